@@ -20,6 +20,14 @@ static void remove_newline(char *str)
     }
 }
 
+// Copy a field into a fixed-size config string, trimming trailing whitespace
+static void copy_field(char *dst, size_t size, const char *src)
+{
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+    remove_newline(dst);
+}
+
 int parse_plugin_config(const char *config_file, plugin_config_t *configs, int max_configs)
 {
     FILE *file = fopen(config_file, "r");
@@ -39,7 +47,9 @@ int parse_plugin_config(const char *config_file, plugin_config_t *configs, int m
             continue;
         }
 
-        // Parse plugin configuration: name,path,enabled,type,plugin_related_config_path
+        // Parse plugin configuration:
+        // name,path,enabled,type,plugin_related_config_path,venv_path,isolation,startup,
+        // hook_budget_us,hooks
         // Parsing name
         char *token = strtok(line, ",");
         if (!token)
@@ -68,17 +78,27 @@ int parse_plugin_config(const char *config_file, plugin_config_t *configs, int m
             continue;
         configs[config_count].type = atoi(token);
 
+        // The optional fields may be empty, so split them by hand: strtok would skip an
+        // empty field and shift the following ones into its place.
+        // plugin_related_config_path,venv_path,isolation,startup,hook_budget_us,hooks
+        char *fields[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
+        char *rest      = strtok(NULL, "\n\r");
+        for (int f = 0; f < 6 && rest; f++)
+        {
+            fields[f] = rest;
+            rest      = strchr(rest, ',');
+            if (rest)
+            {
+                *rest++ = '\0';
+            }
+        }
+
         // parsing plugin_related_config_path (optional field)
-        token = strtok(NULL, ",");
-        if (token && strlen(token) > 0)
+        if (fields[0] && strlen(fields[0]) > 0)
         {
-            printf("[PLUGIN_CONFIG]: Found config_path: '%s'\n", token);
-            strncpy(configs[config_count].plugin_related_config_path, token,
-                    sizeof(configs[config_count].plugin_related_config_path) - 1);
-            configs[config_count]
-                .plugin_related_config_path[sizeof(configs[config_count].plugin_related_config_path) -
-                                            1] = '\0';
-            remove_newline(configs[config_count].plugin_related_config_path);
+            printf("[PLUGIN_CONFIG]: Found config_path: '%s'\n", fields[0]);
+            copy_field(configs[config_count].plugin_related_config_path,
+                       sizeof(configs[config_count].plugin_related_config_path), fields[0]);
         }
         else
         {
@@ -87,19 +107,70 @@ int parse_plugin_config(const char *config_file, plugin_config_t *configs, int m
             configs[config_count].plugin_related_config_path[0] = '\0';
         }
 
-        // parsing venv_path (optional field)
-        token = strtok(NULL, ",\n\r");
-        if (token)
+        // parsing venv_path (optional field, empty string if not specified)
+        copy_field(configs[config_count].venv_path, sizeof(configs[config_count].venv_path),
+                   fields[1] ? fields[1] : "");
+
+        // parsing isolation (optional field, Python plugins only)
+        configs[config_count].isolation = PLUGIN_ISOLATION_SHARED;
+        if (fields[2])
+        {
+            remove_newline(fields[2]);
+            if (strcmp(fields[2], "subinterpreter") == 0)
+            {
+                configs[config_count].isolation = PLUGIN_ISOLATION_SUBINTERPRETER;
+            }
+            else if (fields[2][0] != '\0' && strcmp(fields[2], "shared") != 0)
+            {
+                printf("[PLUGIN_CONFIG]: Unknown isolation '%s', using shared\n", fields[2]);
+            }
+        }
+
+        // parsing startup (optional field)
+        configs[config_count].startup = PLUGIN_STARTUP_SEQUENTIAL;
+        if (fields[3])
         {
-            strncpy(configs[config_count].venv_path, token,
-                    sizeof(configs[config_count].venv_path) - 1);
-            configs[config_count].venv_path[sizeof(configs[config_count].venv_path) - 1] = '\0';
-            remove_newline(configs[config_count].venv_path);
+            remove_newline(fields[3]);
+            if (strcmp(fields[3], "parallel") == 0)
+            {
+                configs[config_count].startup = PLUGIN_STARTUP_PARALLEL;
+            }
+            else if (fields[3][0] != '\0' && strcmp(fields[3], "sequential") != 0)
+            {
+                printf("[PLUGIN_CONFIG]: Unknown startup '%s', using sequential\n", fields[3]);
+            }
         }
-        else
+
+        // parsing hook_budget_us (optional field, 0 or empty for no budget)
+        configs[config_count].hook_budget_us = 0;
+        if (fields[4])
+        {
+            remove_newline(fields[4]);
+            char *end;
+            long budget = strtol(fields[4], &end, 10);
+            if (*end != '\0' || budget < 0 || budget > 10000000)
+            {
+                printf("[PLUGIN_CONFIG]: Invalid hook budget '%s', using none\n", fields[4]);
+            }
+            else
+            {
+                configs[config_count].hook_budget_us = (int)budget;
+            }
+        }
+
+        // parsing hooks (optional field, native plugins only)
+        configs[config_count].hooks = PLUGIN_HOOKS_INLINE;
+        if (fields[5])
         {
-            // No venv_path specified, use empty string
-            configs[config_count].venv_path[0] = '\0';
+            remove_newline(fields[5]);
+            if (strcmp(fields[5], "deferred") == 0)
+            {
+                configs[config_count].hooks = PLUGIN_HOOKS_DEFERRED;
+            }
+            else if (fields[5][0] != '\0' && strcmp(fields[5], "inline") != 0)
+            {
+                printf("[PLUGIN_CONFIG]: Unknown hooks '%s', using inline\n", fields[5]);
+            }
         }
 
         // Incrementing index to target next config
@@ -4,14 +4,39 @@
 #define MAX_PLUGIN_NAME_LEN 64
 #define MAX_PLUGIN_PATH_LEN 256
 
+// Interpreter a Python plugin runs in
+typedef enum
+{
+    PLUGIN_ISOLATION_SHARED,        // Main interpreter, GIL shared with the other Python plugins
+    PLUGIN_ISOLATION_SUBINTERPRETER // Own subinterpreter with its own GIL (Python 3.12+)
+} plugin_isolation_t;
+
+// How a plugin's init and start calls are scheduled at program load
+typedef enum
+{
+    PLUGIN_STARTUP_SEQUENTIAL, // In config order on the loading thread
+    PLUGIN_STARTUP_PARALLEL    // On its own thread, alongside the other plugins
+} plugin_startup_t;
+
+// Where a native plugin's cycle_start and cycle_end run
+typedef enum
+{
+    PLUGIN_HOOKS_INLINE,  // On the scan thread, with buffer_mutex held
+    PLUGIN_HOOKS_DEFERRED // On a helper thread after each scan, without buffer_mutex
+} plugin_hooks_t;
+
 typedef struct
 {
     char name[MAX_PLUGIN_NAME_LEN];
     char path[MAX_PLUGIN_PATH_LEN];
     int enabled;
-    int type; // 0 = python, 1 = native
+    int type; // 0 = python, 1 = native, 2 = process
     char plugin_related_config_path[MAX_PLUGIN_PATH_LEN];
     char venv_path[MAX_PLUGIN_PATH_LEN]; // Path to virtual environment
+    int isolation;                       // plugin_isolation_t, Python plugins only
+    int startup;                         // plugin_startup_t
+    int hook_budget_us;                  // Time allowed per cycle hook call, 0 for no budget
+    int hooks;                           // plugin_hooks_t, native plugins only
 } plugin_config_t;
 
 int parse_plugin_config(const char *config_file, plugin_config_t *configs, int max_configs);
@@ -0,0 +1,230 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include "plugin_cycle_signal.h"
+
+struct plugin_cycle_signal_s
+{
+    // Latest posted scan, guarded by a seqlock (odd while posting)
+    atomic_uint seq;
+    atomic_ullong cycle;
+    atomic_uint generation;
+
+    // Set by the consumer before it sleeps, cleared by whoever wakes it
+    atomic_int waiting;
+
+    // Set while the plugin is being stopped: waits return 0 at once
+    atomic_int interrupted;
+
+    // Wakeup descriptor: read end in fds[0], write end in fds[1] (the same eventfd on Linux)
+    int fds[2];
+
+    // Consumer side
+    unsigned long long last_cycle;
+    atomic_ullong delivered;
+    atomic_ullong missed;
+};
+
+static void signal_wake(plugin_cycle_signal_t *signal)
+{
+#if defined(__linux__)
+    uint64_t one = 1;
+    ssize_t ret  = write(signal->fds[1], &one, sizeof(one));
+#else
+    char one    = 1;
+    ssize_t ret = write(signal->fds[1], &one, sizeof(one));
+#endif
+    (void)ret; // EAGAIN: a wakeup is already pending
+}
+
+static void signal_drain(plugin_cycle_signal_t *signal)
+{
+    uint64_t buf;
+    while (read(signal->fds[0], &buf, sizeof(buf)) > 0)
+    {
+    }
+}
+
+static void signal_load(plugin_cycle_signal_t *signal, unsigned long long *cycle,
+                        unsigned int *generation)
+{
+    for (;;)
+    {
+        unsigned s0 = atomic_load_explicit(&signal->seq, memory_order_acquire);
+        if (s0 & 1u)
+        {
+            continue;
+        }
+        *cycle      = atomic_load_explicit(&signal->cycle, memory_order_relaxed);
+        *generation = atomic_load_explicit(&signal->generation, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&signal->seq, memory_order_relaxed) == s0)
+        {
+            return;
+        }
+    }
+}
+
+// Deliver the latest scan if it is newer than the last one delivered
+static int signal_take(plugin_cycle_signal_t *signal, plugin_cycle_token_t *token)
+{
+    unsigned long long cycle;
+    unsigned int generation;
+    signal_load(signal, &cycle, &generation);
+    if (cycle <= signal->last_cycle)
+    {
+        return 0;
+    }
+
+    unsigned long long missed =
+        signal->last_cycle != 0 ? cycle - signal->last_cycle - 1 : 0;
+    signal->last_cycle = cycle;
+    atomic_fetch_add_explicit(&signal->delivered, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&signal->missed, missed, memory_order_relaxed);
+
+    token->cycle      = cycle;
+    token->generation = generation;
+    token->missed     = missed > UINT32_MAX ? UINT32_MAX : (unsigned int)missed;
+    return 1;
+}
+
+plugin_cycle_signal_t *plugin_cycle_signal_create(void)
+{
+    plugin_cycle_signal_t *signal = calloc(1, sizeof(plugin_cycle_signal_t));
+    if (!signal)
+    {
+        return NULL;
+    }
+
+#if defined(__linux__)
+    signal->fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    signal->fds[1] = signal->fds[0];
+    if (signal->fds[0] < 0)
+    {
+        free(signal);
+        return NULL;
+    }
+#else
+    if (pipe(signal->fds) != 0)
+    {
+        free(signal);
+        return NULL;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        fcntl(signal->fds[i], F_SETFL, fcntl(signal->fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(signal->fds[i], F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    return signal;
+}
+
+void plugin_cycle_signal_destroy(plugin_cycle_signal_t *signal)
+{
+    if (!signal)
+    {
+        return;
+    }
+    close(signal->fds[0]);
+    if (signal->fds[1] != signal->fds[0])
+    {
+        close(signal->fds[1]);
+    }
+    free(signal);
+}
+
+void plugin_cycle_signal_post(plugin_cycle_signal_t *signal, unsigned long long cycle,
+                              unsigned int generation)
+{
+    unsigned s0 = atomic_load_explicit(&signal->seq, memory_order_relaxed);
+    atomic_store_explicit(&signal->seq, s0 + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&signal->cycle, cycle, memory_order_relaxed);
+    atomic_store_explicit(&signal->generation, generation, memory_order_relaxed);
+
+    // Sequentially consistent against the consumer arming waiting and then
+    // rechecking the token, so either it sees this scan or we see it waiting
+    atomic_store(&signal->seq, s0 + 2);
+    if (atomic_exchange(&signal->waiting, 0))
+    {
+        signal_wake(signal);
+    }
+}
+
+int plugin_cycle_signal_wait(plugin_cycle_signal_t *signal, int timeout_ms,
+                             plugin_cycle_token_t *token)
+{
+    if (atomic_load(&signal->interrupted))
+    {
+        return 0;
+    }
+    if (signal_take(signal, token))
+    {
+        return 1;
+    }
+
+    atomic_store(&signal->waiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (signal_take(signal, token))
+    {
+        // A post that already cleared waiting has also written a wakeup
+        if (!atomic_exchange(&signal->waiting, 0))
+        {
+            signal_drain(signal);
+        }
+        return 1;
+    }
+
+    struct pollfd pfd = {.fd = signal->fds[0], .events = POLLIN};
+    int ret           = poll(&pfd, 1, timeout_ms < 0 ? -1 : timeout_ms);
+    if (ret < 0 && errno != EINTR)
+    {
+        atomic_store(&signal->waiting, 0);
+        return -1;
+    }
+
+    atomic_store(&signal->waiting, 0);
+    signal_drain(signal);
+    if (atomic_load(&signal->interrupted))
+    {
+        return 0;
+    }
+    return signal_take(signal, token);
+}
+
+void plugin_cycle_signal_interrupt(plugin_cycle_signal_t *signal)
+{
+    atomic_store(&signal->interrupted, 1);
+    signal_wake(signal);
+}
+
+void plugin_cycle_signal_reset(plugin_cycle_signal_t *signal)
+{
+    signal->last_cycle = 0;
+    atomic_store(&signal->interrupted, 0);
+    atomic_store(&signal->delivered, 0);
+    atomic_store(&signal->missed, 0);
+    signal_drain(signal);
+}
+
+void plugin_cycle_signal_stats(plugin_cycle_signal_t *signal, unsigned long long *delivered,
+                               unsigned long long *missed)
+{
+    if (delivered)
+    {
+        *delivered = atomic_load_explicit(&signal->delivered, memory_order_relaxed);
+    }
+    if (missed)
+    {
+        *missed = atomic_load_explicit(&signal->missed, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef PLUGIN_CYCLE_SIGNAL_H
+#define PLUGIN_CYCLE_SIGNAL_H
+
+#include "plugin_types.h"
+
+/**
+ * @file plugin_cycle_signal.h
+ * @brief Scan notifications for plugins that run in their own threads
+ *
+ * Python plugins cannot run on the scan thread, so instead of cycle hooks
+ * they get a signal per plugin: at the end of every scan the scan thread
+ * posts a token (scan counter and image snapshot generation) and a plugin
+ * thread blocked in plugin_cycle_signal_wait() wakes up to process it.
+ *
+ * The signal holds only the latest token. A consumer slower than the scan
+ * gets the newest scan and the number of scans it skipped, which matches the
+ * image shadow: older snapshots are overwritten anyway.
+ *
+ * Posting never blocks: it is a seqlock store, plus a non-blocking write to
+ * an eventfd (a pipe where eventfd is not available) when the consumer is
+ * asleep. Each signal supports a single waiting thread.
+ */
+
+typedef struct plugin_cycle_signal_s plugin_cycle_signal_t;
+
+/**
+ * @brief Create a signal
+ *
+ * @return New signal, or NULL if the wakeup descriptor cannot be created
+ */
+plugin_cycle_signal_t *plugin_cycle_signal_create(void);
+
+/**
+ * @brief Destroy a signal. No thread may be waiting on it.
+ */
+void plugin_cycle_signal_destroy(plugin_cycle_signal_t *signal);
+
+/**
+ * @brief Publish the scan that just completed and wake the consumer
+ *
+ * Called by the scan thread only. Never blocks.
+ *
+ * @param cycle Scan counter, increasing with every scan
+ * @param generation Image snapshot generation published by the scan (0 if none)
+ */
+void plugin_cycle_signal_post(plugin_cycle_signal_t *signal, unsigned long long cycle,
+                              unsigned int generation);
+
+/**
+ * @brief Wait for a scan newer than the last one delivered
+ *
+ * @param timeout_ms Maximum time to wait, negative to wait indefinitely
+ * @param token Receives the scan, with missed set to the number of scans
+ *              skipped since the previous token
+ * @return 1 if a token was delivered, 0 on timeout or interrupt, -1 on error
+ */
+int plugin_cycle_signal_wait(plugin_cycle_signal_t *signal, int timeout_ms,
+                             plugin_cycle_token_t *token);
+
+/**
+ * @brief Make plugin_cycle_signal_wait() return 0 without blocking until the next reset
+ *
+ * Used before stopping a plugin, so its thread keeps checking its stop flag
+ * instead of sleeping until the next scan.
+ */
+void plugin_cycle_signal_interrupt(plugin_cycle_signal_t *signal);
+
+/**
+ * @brief Forget the last delivered scan, clear the counters and the interrupt
+ *
+ * Called while no thread is waiting, before a plugin is started, so the first
+ * token after a restart does not count the downtime as missed scans.
+ */
+void plugin_cycle_signal_reset(plugin_cycle_signal_t *signal);
+
+/**
+ * @brief Counters since the last reset
+ *
+ * @param delivered Receives the number of tokens delivered (may be NULL)
+ * @param missed Receives the number of scans skipped by the consumer (may be NULL)
+ */
+void plugin_cycle_signal_stats(plugin_cycle_signal_t *signal, unsigned long long *delivered,
+                               unsigned long long *missed);
+
+#endif // PLUGIN_CYCLE_SIGNAL_H
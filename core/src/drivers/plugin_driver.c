@@ -13,38 +13,203 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include "../plc_app/image_shadow.h"
 #include "../plc_app/image_tables.h"
 #include "../plc_app/journal_buffer.h"
+#include "../plc_app/metrics.h"
+#include "../plc_app/plc_instances.h"
+#include "../plc_app/scan_cycle_manager.h"
+#include "../plc_app/scan_profiler.h"
+#include "../plc_app/utils/boot_timeline.h"
 #include "../plc_app/utils/log.h"
+#include "../plc_app/utils/seqlock.h"
 #include "plugin_config.h"
 #include "plugin_driver.h"
+#include "python_buffer_module.h"
 #include <dlfcn.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
-// External buffer declarations from image_tables.c
-extern IEC_BOOL *bool_input[BUFFER_SIZE][8];
-extern IEC_BOOL *bool_output[BUFFER_SIZE][8];
-extern IEC_BYTE *byte_input[BUFFER_SIZE];
-extern IEC_BYTE *byte_output[BUFFER_SIZE];
-extern IEC_UINT *int_input[BUFFER_SIZE];
-extern IEC_UINT *int_output[BUFFER_SIZE];
-extern IEC_UDINT *dint_input[BUFFER_SIZE];
-extern IEC_UDINT *dint_output[BUFFER_SIZE];
-extern IEC_ULINT *lint_input[BUFFER_SIZE];
-extern IEC_ULINT *lint_output[BUFFER_SIZE];
-extern IEC_UINT *int_memory[BUFFER_SIZE];
-extern IEC_UDINT *dint_memory[BUFFER_SIZE];
-extern IEC_ULINT *lint_memory[BUFFER_SIZE];
-extern IEC_BOOL *bool_memory[BUFFER_SIZE][8];
 static PyThreadState *main_tstate = NULL;
 static PyGILState_STATE gstate;
 static int has_python_plugin = 0;
 
+// Thread started by plugin_driver_start_python(), joined before anything else touches
+// the plugins
+static pthread_mutex_t python_loader_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t python_loader;
+static int python_loader_running = 0;
+static int python_loader_selected[MAX_PLUGINS];
+
 // Prototypes
 static void python_plugin_cleanup(plugin_instance_t *plugin);
+static void python_start_interpreter(void);
+static void plugin_driver_join_loader(void);
+static void *plugin_hook_thread(void *arg);
+
+// Argument of the deferred hook thread of each plugin slot
+typedef struct
+{
+    plugin_driver_t *driver;
+    int index;
+} plugin_hook_job_t;
+
+static plugin_hook_job_t hook_jobs[MAX_PLUGINS];
+
+// Per-interpreter GILs need Python 3.12
+#if PY_VERSION_HEX >= 0x030C0000
+#define PYTHON_HAS_SUBINTERPRETERS 1
+#else
+#define PYTHON_HAS_SUBINTERPRETERS 0
+#endif
+
+// Thread state the calling thread is attached to, NULL if it does not hold a GIL
+#if PY_VERSION_HEX >= 0x030D0000
+#define python_current_tstate() PyThreadState_GetUnchecked()
+#else
+#define python_current_tstate() _PyThreadState_UncheckedGet()
+#endif
+
+// Attachment of the calling thread to the interpreter of a Python plugin
+typedef struct
+{
+    int ensured;           // Main interpreter entered through PyGILState_Ensure
+    PyGILState_STATE gil;  // State returned by PyGILState_Ensure
+    PyThreadState *outer;  // Thread state detached to enter a subinterpreter
+    PyThreadState *tstate; // Thread state in the subinterpreter
+    int keep_tstate;       // Detach tstate on leave instead of deleting it
+} python_call_t;
+
+// Attach the calling thread to the plugin's interpreter and take its GIL.
+// Works whether or not the calling thread already holds the main GIL.
+static void python_call_enter(python_binds_t *binds, python_call_t *call)
+{
+    memset(call, 0, sizeof(*call));
+#if PYTHON_HAS_SUBINTERPRETERS
+    if (binds && binds->interp)
+    {
+        call->outer = python_current_tstate();
+        if (call->outer)
+        {
+            PyEval_SaveThread();
+        }
+        call->tstate = PyThreadState_New(binds->interp);
+        PyEval_RestoreThread(call->tstate);
+        return;
+    }
+#else
+    (void)binds;
+#endif
+    call->ensured = 1;
+    call->gil     = PyGILState_Ensure();
+}
+
+// Undo python_call_enter(), restoring whatever the thread was attached to before
+static void python_call_leave(python_call_t *call)
+{
+    if (call->tstate && call->keep_tstate)
+    {
+        PyEval_SaveThread();
+    }
+    else if (call->tstate)
+    {
+        PyThreadState_Clear(call->tstate);
+        PyThreadState_DeleteCurrent();
+    }
+    if (call->outer)
+    {
+        PyEval_RestoreThread(call->outer);
+    }
+    if (call->ensured)
+    {
+        PyGILState_Release(call->gil);
+    }
+}
+
+// Create a subinterpreter with its own GIL for a plugin and attach the calling thread
+// to it, as python_call_enter() would. Returns -1 if it cannot be created.
+static int python_call_enter_new_interpreter(python_binds_t *binds, python_call_t *call)
+{
+    memset(call, 0, sizeof(*call));
+#if PYTHON_HAS_SUBINTERPRETERS
+    const PyInterpreterConfig config = {
+        .use_main_obmalloc             = 0,
+        .allow_fork                    = 0,
+        .allow_exec                    = 0,
+        .allow_threads                 = 1,
+        .allow_daemon_threads          = 1, // Plugins run their loops in daemon threads
+        .check_multi_interp_extensions = 1,
+        .gil                           = PyInterpreterConfig_OWN_GIL,
+    };
+
+    // Creating an interpreter requires the main GIL; the call releases it again
+    call->ensured = 1;
+    call->gil     = PyGILState_Ensure();
+    call->outer   = PyThreadState_Get();
+
+    PyThreadState *tstate = NULL;
+    PyStatus status       = Py_NewInterpreterFromConfig(&tstate, &config);
+    if (PyStatus_Exception(status) || !tstate)
+    {
+        fprintf(stderr, "Failed to create subinterpreter: %s\n",
+                status.err_msg ? status.err_msg : "unknown error");
+        call->outer = NULL;
+        python_call_leave(call);
+        return -1;
+    }
+
+    // The first thread state is kept for the interpreter's lifetime: Python 3.12 aborts when
+    // an interpreter's first thread state is deleted and a new one is created afterwards
+    call->tstate         = tstate;
+    call->keep_tstate    = 1;
+    binds->interp        = PyThreadState_GetInterpreter(tstate);
+    binds->interp_tstate = tstate;
+    return 0;
+#else
+    (void)binds;
+    (void)call;
+    return -1;
+#endif
+}
+
+// End a plugin's subinterpreter. Skipped (and leaked) while threads of the plugin
+// are still running, since ending the interpreter would abort the process.
+static void python_end_interpreter(python_binds_t *binds)
+{
+#if PYTHON_HAS_SUBINTERPRETERS
+    if (!binds->interp)
+    {
+        return;
+    }
+
+    python_call_t call;
+    python_call_enter(binds, &call);
+    PyThreadState_Clear(binds->interp_tstate);
+    PyThreadState_Delete(binds->interp_tstate);
+    binds->interp_tstate = NULL;
+
+    if (PyInterpreterState_ThreadHead(binds->interp) == call.tstate &&
+        PyThreadState_Next(call.tstate) == NULL)
+    {
+        // Ends the interpreter and its current thread state, leaving no thread state current
+        Py_EndInterpreter(call.tstate);
+        call.tstate = NULL;
+    }
+    else
+    {
+        fprintf(stderr, "[PLUGIN]: Subinterpreter still has running threads, not ending it\n");
+    }
+    python_call_leave(&call);
+    binds->interp = NULL;
+#else
+    (void)binds;
+#endif
+}
 
 // Driver management functions
 plugin_driver_t *plugin_driver_create(void)
@@ -112,28 +277,334 @@ int plugin_mutex_give(pthread_mutex_t *mutex)
 
 static int plugin_journal_write_bool(int type, int index, int bit, int value)
 {
-    return journal_write_bool((journal_buffer_type_t)type, (uint16_t)index, (uint8_t)bit,
+    if (index < 0)
+    {
+        return -1;
+    }
+    return journal_write_bool((journal_buffer_type_t)type, (uint32_t)index, (uint8_t)bit,
                               value != 0);
 }
 
 static int plugin_journal_write_byte(int type, int index, int value)
 {
-    return journal_write_byte((journal_buffer_type_t)type, (uint16_t)index, (uint8_t)value);
+    if (index < 0)
+    {
+        return -1;
+    }
+    return journal_write_byte((journal_buffer_type_t)type, (uint32_t)index, (uint8_t)value);
 }
 
 static int plugin_journal_write_int(int type, int index, int value)
 {
-    return journal_write_int((journal_buffer_type_t)type, (uint16_t)index, (uint16_t)value);
+    if (index < 0)
+    {
+        return -1;
+    }
+    return journal_write_int((journal_buffer_type_t)type, (uint32_t)index, (uint16_t)value);
 }
 
 static int plugin_journal_write_dint(int type, int index, unsigned int value)
 {
-    return journal_write_dint((journal_buffer_type_t)type, (uint16_t)index, (uint32_t)value);
+    if (index < 0)
+    {
+        return -1;
+    }
+    return journal_write_dint((journal_buffer_type_t)type, (uint32_t)index, (uint32_t)value);
 }
 
 static int plugin_journal_write_lint(int type, int index, unsigned long long value)
 {
-    return journal_write_lint((journal_buffer_type_t)type, (uint16_t)index, (uint64_t)value);
+    if (index < 0)
+    {
+        return -1;
+    }
+    return journal_write_lint((journal_buffer_type_t)type, (uint32_t)index, (uint64_t)value);
+}
+
+static int plugin_journal_write_range(int type, int start_index, int count, const void *values)
+{
+    if (start_index < 0 || count <= 0)
+    {
+        return -1;
+    }
+    return journal_write_range((journal_buffer_type_t)type, (uint32_t)start_index,
+                               (uint32_t)count, values);
+}
+
+// Plugins share the wrappers above, so every plugin slot gets entry points of its own
+// that count the writes rejected for that plugin, reported by JOURNAL_STATS
+static atomic_ullong journal_rejected[MAX_PLUGINS];
+
+static int count_rejected(int slot, int result)
+{
+    if (result != 0)
+    {
+        atomic_fetch_add_explicit(&journal_rejected[slot], 1, memory_order_relaxed);
+    }
+    return result;
+}
+
+// Journal the writes of a batch in order, up to the first one the journal rejects
+static int plugin_journal_write_batch(int slot, const plugin_journal_write_t *writes, int count)
+{
+    if (!writes || count < 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        const plugin_journal_write_t *write = &writes[i];
+        int result;
+        if (write->bit >= 0)
+        {
+            result = plugin_journal_write_bool(write->type, write->start_index, write->bit,
+                                               write->values ? *(const uint8_t *)write->values & 1
+                                                             : 0);
+        }
+        else
+        {
+            result = plugin_journal_write_range(write->type, write->start_index, write->count,
+                                                write->values);
+        }
+        if (count_rejected(slot, result) != 0)
+        {
+            return i;
+        }
+    }
+    return count;
+}
+
+// Instance 0 is the main program, counted against the slot like its other writes
+static int plugin_instance_write_batch(int slot, int instance,
+                                       const plugin_journal_write_t *writes, int count)
+{
+    if (instance == 0)
+    {
+        return plugin_journal_write_batch(slot, writes, count);
+    }
+    int result = plc_instance_write_batch(instance, writes, count);
+    if (result >= 0 && result < count)
+    {
+        atomic_fetch_add_explicit(&journal_rejected[slot], 1, memory_order_relaxed);
+    }
+    return result;
+}
+
+typedef struct
+{
+    plugin_journal_write_bool_func_t write_bool;
+    plugin_journal_write_byte_func_t write_byte;
+    plugin_journal_write_int_func_t write_int;
+    plugin_journal_write_dint_func_t write_dint;
+    plugin_journal_write_lint_func_t write_lint;
+    plugin_journal_write_range_func_t write_range;
+    plugin_journal_write_batch_func_t write_batch;
+    plugin_instance_write_batch_func_t instance_write_batch;
+} plugin_journal_slot_t;
+
+#define PLUGIN_JOURNAL_SLOT(n)                                                                     \
+    static int journal_write_bool_##n(int type, int index, int bit, int value)                     \
+    {                                                                                              \
+        return count_rejected(n, plugin_journal_write_bool(type, index, bit, value));              \
+    }                                                                                              \
+    static int journal_write_byte_##n(int type, int index, int value)                              \
+    {                                                                                              \
+        return count_rejected(n, plugin_journal_write_byte(type, index, value));                   \
+    }                                                                                              \
+    static int journal_write_int_##n(int type, int index, int value)                               \
+    {                                                                                              \
+        return count_rejected(n, plugin_journal_write_int(type, index, value));                    \
+    }                                                                                              \
+    static int journal_write_dint_##n(int type, int index, unsigned int value)                     \
+    {                                                                                              \
+        return count_rejected(n, plugin_journal_write_dint(type, index, value));                   \
+    }                                                                                              \
+    static int journal_write_lint_##n(int type, int index, unsigned long long value)               \
+    {                                                                                              \
+        return count_rejected(n, plugin_journal_write_lint(type, index, value));                   \
+    }                                                                                              \
+    static int journal_write_range_##n(int type, int start_index, int count, const void *values)   \
+    {                                                                                              \
+        return count_rejected(n, plugin_journal_write_range(type, start_index, count, values));    \
+    }                                                                                              \
+    static int journal_write_batch_##n(const plugin_journal_write_t *writes, int count)            \
+    {                                                                                              \
+        return plugin_journal_write_batch(n, writes, count);                                       \
+    }                                                                                              \
+    static int instance_write_batch_##n(int instance, const plugin_journal_write_t *writes,        \
+                                        int count)                                                 \
+    {                                                                                              \
+        return plugin_instance_write_batch(n, instance, writes, count);                            \
+    }
+
+#define PLUGIN_JOURNAL_FUNCS(n)                                                                    \
+    {journal_write_bool_##n, journal_write_byte_##n, journal_write_int_##n,                        \
+     journal_write_dint_##n, journal_write_lint_##n, journal_write_range_##n,                      \
+     journal_write_batch_##n, instance_write_batch_##n}
+
+_Static_assert(MAX_PLUGINS == 16, "one PLUGIN_JOURNAL_SLOT per plugin slot");
+
+PLUGIN_JOURNAL_SLOT(0)
+PLUGIN_JOURNAL_SLOT(1)
+PLUGIN_JOURNAL_SLOT(2)
+PLUGIN_JOURNAL_SLOT(3)
+PLUGIN_JOURNAL_SLOT(4)
+PLUGIN_JOURNAL_SLOT(5)
+PLUGIN_JOURNAL_SLOT(6)
+PLUGIN_JOURNAL_SLOT(7)
+PLUGIN_JOURNAL_SLOT(8)
+PLUGIN_JOURNAL_SLOT(9)
+PLUGIN_JOURNAL_SLOT(10)
+PLUGIN_JOURNAL_SLOT(11)
+PLUGIN_JOURNAL_SLOT(12)
+PLUGIN_JOURNAL_SLOT(13)
+PLUGIN_JOURNAL_SLOT(14)
+PLUGIN_JOURNAL_SLOT(15)
+
+static const plugin_journal_slot_t journal_slots[MAX_PLUGINS] = {
+    PLUGIN_JOURNAL_FUNCS(0),  PLUGIN_JOURNAL_FUNCS(1),  PLUGIN_JOURNAL_FUNCS(2),
+    PLUGIN_JOURNAL_FUNCS(3),  PLUGIN_JOURNAL_FUNCS(4),  PLUGIN_JOURNAL_FUNCS(5),
+    PLUGIN_JOURNAL_FUNCS(6),  PLUGIN_JOURNAL_FUNCS(7),  PLUGIN_JOURNAL_FUNCS(8),
+    PLUGIN_JOURNAL_FUNCS(9),  PLUGIN_JOURNAL_FUNCS(10), PLUGIN_JOURNAL_FUNCS(11),
+    PLUGIN_JOURNAL_FUNCS(12), PLUGIN_JOURNAL_FUNCS(13), PLUGIN_JOURNAL_FUNCS(14),
+    PLUGIN_JOURNAL_FUNCS(15),
+};
+
+#undef PLUGIN_JOURNAL_SLOT
+#undef PLUGIN_JOURNAL_FUNCS
+
+static const void *plugin_get_image_area(int type, int *length)
+{
+    size_t count     = 0;
+    const void *base = image_shadow_get_area((journal_buffer_type_t)type, &count);
+    if (length)
+    {
+        *length = base ? (int)count : 0;
+    }
+    return base;
+}
+
+static int plugin_read_image_snapshot(int type, int start_index, int count, void *dest)
+{
+    if (start_index < 0 || count < 0)
+    {
+        return -1;
+    }
+    return image_shadow_read((journal_buffer_type_t)type, (size_t)start_index, (size_t)count,
+                             dest, NULL);
+}
+
+static int plugin_read_image_changes(int type, int start_index, int count, void *dest,
+                                     void *changes, unsigned int *generation)
+{
+    if (start_index < 0 || count < 0 || generation == NULL)
+    {
+        return -1;
+    }
+    uint32_t since = *generation;
+    int copied     = image_shadow_read_changes((journal_buffer_type_t)type, (size_t)start_index,
+                                               (size_t)count, dest, changes, &since);
+    *generation    = since;
+    return copied;
+}
+
+static int plugin_read_image_batch(plugin_image_read_t *reads, int count, unsigned int *generation)
+{
+    if (!reads || count < 0 || !generation)
+    {
+        return -1;
+    }
+
+    // Every read is consistent on its own; repeat while a scan ends in between
+    int available = 0;
+    *generation   = 0;
+    for (int attempt = 0; attempt < 3; attempt++)
+    {
+        uint32_t first = 0;
+        int mixed      = 0;
+        available      = 0;
+        for (int i = 0; i < count; i++)
+        {
+            plugin_image_read_t *read = &reads[i];
+            uint32_t read_generation  = 0;
+            read->copied              = -1;
+            if (read->start_index < 0 || read->count < 0)
+            {
+                continue;
+            }
+            read->copied = image_shadow_read((journal_buffer_type_t)read->type,
+                                             (size_t)read->start_index, (size_t)read->count,
+                                             read->dest, &read_generation);
+            if (read->copied < 0)
+            {
+                continue;
+            }
+            if (available != 0 && read_generation != first)
+            {
+                mixed = 1;
+            }
+            first = read_generation;
+            available++;
+        }
+        if (!mixed)
+        {
+            *generation = available ? first : 0;
+            break;
+        }
+    }
+    return available;
+}
+
+static int plugin_instance_read_batch(int instance, plugin_image_read_t *reads, int count,
+                                      unsigned int *generation)
+{
+    if (instance == 0)
+    {
+        return plugin_read_image_batch(reads, count, generation);
+    }
+    return plc_instance_read_batch(instance, reads, count, generation);
+}
+
+static int plugin_wait_cycle(void *signal, int timeout_ms, plugin_cycle_token_t *token)
+{
+    if (!signal || !token)
+    {
+        return -1;
+    }
+    return plugin_cycle_signal_wait((plugin_cycle_signal_t *)signal, timeout_ms, token);
+}
+
+// Everything plugin_capabilities_t has in this runtime
+#define PLUGIN_RUNTIME_CAPABILITIES                                                                \
+    (PLUGIN_CAP_JOURNAL_RANGE | PLUGIN_CAP_IMAGE_AREA | PLUGIN_CAP_IMAGE_SNAPSHOT |                \
+     PLUGIN_CAP_IMAGE_CHANGES | PLUGIN_CAP_METRICS | PLUGIN_CAP_JOURNAL_BATCH |                    \
+     PLUGIN_CAP_IMAGE_BATCH | PLUGIN_CAP_INSTANCES)
+
+// Capability tables of ABI version 2 plugins, one per slot for the slot's journal entry
+// points. Never freed, plugins keep the pointer.
+static plugin_capabilities_t capability_tables[MAX_PLUGINS];
+
+static const plugin_capabilities_t *plugin_capabilities_for(int plugin_index)
+{
+    plugin_capabilities_t *table = &capability_tables[plugin_index];
+    const plugin_journal_slot_t *journal = &journal_slots[plugin_index];
+
+    table->size                   = sizeof(plugin_capabilities_t);
+    table->mask                   = PLUGIN_RUNTIME_CAPABILITIES;
+    table->journal_write_range    = journal->write_range;
+    table->get_image_area         = plugin_get_image_area;
+    table->read_image_snapshot    = plugin_read_image_snapshot;
+    table->read_image_changes     = plugin_read_image_changes;
+    table->metric_register        = metrics_register_source;
+    table->metric_add             = metrics_add;
+    table->metric_set             = metrics_set;
+    table->metric_register_labels = metrics_register_source_labels;
+    table->journal_write_batch    = journal->write_batch;
+    table->read_image_batch       = plugin_read_image_batch;
+    table->instance_count         = plc_instance_count;
+    table->instance_write_batch   = journal->instance_write_batch;
+    table->instance_read_batch    = plugin_instance_read_batch;
+    return table;
 }
 
 // Python capsule destructor for runtime args
@@ -175,6 +646,7 @@ int plugin_driver_update_config(plugin_driver_t *driver, const char *config_file
     {
         return -1;
     }
+    plugin_driver_join_loader();
 
     // Check if config file exists, if not copy from default
     if (access(config_file, F_OK) != 0)
@@ -235,157 +707,542 @@ int plugin_driver_update_config(plugin_driver_t *driver, const char *config_file
     return 0;
 }
 
-int plugin_driver_load_config(plugin_driver_t *driver, const char *config_file)
+// Wait for a background start of the Python plugins to finish
+static void plugin_driver_join_loader(void)
 {
-    if (!driver || !config_file)
+    pthread_mutex_lock(&python_loader_mutex);
+    if (python_loader_running)
     {
-        return -1;
+        pthread_join(python_loader, NULL);
+        python_loader_running = 0;
     }
+    pthread_mutex_unlock(&python_loader_mutex);
+}
 
-    plugin_driver_update_config(driver, config_file);
-
-    // Now retrieve the function symbols and initialize
-    // struct plugin_instance_t para cada plugin.
+// Resolve the entry points of the enabled plugins in selected (all if NULL) of one type
+// that have none yet. A Python plugin starts the interpreter, so it is never started
+// while no Python plugin is enabled. Returns -1 if any of them failed.
+static int plugin_load_symbols(plugin_driver_t *driver, const int *selected, int type)
+{
+    int result = 0;
     for (int i = 0; i < driver->plugin_count; i++)
     {
         plugin_instance_t *plugin = &driver->plugins[i];
+        if ((selected && !selected[i]) || !plugin->config.enabled || plugin->config.type != type)
+        {
+            continue;
+        }
 
-        if (plugin->config.type == PLUGIN_TYPE_PYTHON)
+        if (type == PLUGIN_TYPE_PYTHON && !plugin->python_plugin &&
+            python_plugin_get_symbols(plugin) != 0)
         {
-            if (python_plugin_get_symbols(plugin) != 0)
-            {
-                fprintf(stderr, "Failed to get Python plugin symbols for: %s\n",
-                        plugin->config.path);
-                return -1;
-            }
+            fprintf(stderr, "Failed to get Python plugin symbols for: %s\n", plugin->config.path);
+            result = -1;
         }
-        else if (plugin->config.type == PLUGIN_TYPE_NATIVE)
+        else if (type == PLUGIN_TYPE_NATIVE && !plugin->native_plugin &&
+                 native_plugin_get_symbols(plugin) != 0)
         {
-            if (native_plugin_get_symbols(plugin) != 0)
-            {
-                fprintf(stderr, "Failed to get native plugin symbols for: %s\n",
-                        plugin->config.path);
-                return -1;
-            }
+            fprintf(stderr, "Failed to get native plugin symbols for: %s\n", plugin->config.path);
+            result = -1;
+        }
+        // Nothing to load for a process plugin, but a missing executable should show now
+        else if (type == PLUGIN_TYPE_PROCESS && access(plugin->config.path, X_OK) != 0)
+        {
+            fprintf(stderr, "Process plugin executable not found: %s\n", plugin->config.path);
+            result = -1;
         }
     }
-
-    return 0;
+    return result;
 }
 
-// Send to plugin init function all args
-int plugin_driver_init(plugin_driver_t *driver)
+int plugin_driver_load_config(plugin_driver_t *driver, const char *config_file)
 {
-    if (!driver)
+    if (!driver || !config_file)
     {
         return -1;
     }
 
-    // Only acquire Python GIL if we have Python plugins and Python is initialized
-    // Initialize to PyGILState_LOCKED (0) to satisfy compiler warning
-    PyGILState_STATE local_gstate = PyGILState_LOCKED;
-    int have_gil = has_python_plugin && Py_IsInitialized();
-    if (have_gil)
-    {
-        local_gstate = PyGILState_Ensure();
-    }
+    plugin_driver_update_config(driver, config_file);
 
-    // #chamdo a função init de cada plugin aqui
-    for (int i = 0; i < driver->plugin_count; i++)
-    {
-        plugin_instance_t *plugin = &driver->plugins[i];
+    // Native plugins are loaded now; Python plugins when they are first initialized, so
+    // the interpreter is only started when one is enabled
+    return plugin_load_symbols(driver, NULL, PLUGIN_TYPE_NATIVE);
+}
 
-        // Skip disabled plugins
-        if (!plugin->config.enabled)
-        {
-            printf("[PLUGIN]: Skipping disabled plugin: %s\n", plugin->config.name);
-            continue;
-        }
+// Send to plugin init function all args
+// Call one plugin's init function. Runs on a startup thread for plugins with parallel startup,
+// so it takes the GIL itself and touches nothing but its own plugin instance.
+static int plugin_init_one(plugin_driver_t *driver, int i)
+{
+    plugin_instance_t *plugin = &driver->plugins[i];
 
-        if (plugin->config.type == PLUGIN_TYPE_PYTHON && plugin->python_plugin &&
-            plugin->python_plugin->pFuncInit)
+    if (plugin->config.type == PLUGIN_TYPE_PYTHON && plugin->python_plugin &&
+        plugin->python_plugin->pFuncInit)
+    {
+        // Kept until the driver is destroyed, since the scan thread may still be posting
+        if (!plugin->cycle_signal)
         {
-            // Generate structured args for Python plugin
-            PyObject *args =
-                (PyObject *)generate_structured_args_with_driver(PLUGIN_TYPE_PYTHON, driver, i);
-            if (!args)
+            plugin->cycle_signal = plugin_cycle_signal_create();
+            if (!plugin->cycle_signal)
             {
-                fprintf(stderr, "Failed to generate runtime args for plugin: %s\n",
+                fprintf(stderr, "[PLUGIN]: No cycle signal for plugin %s, wait_cycle disabled\n",
                         plugin->config.name);
-
-                if (have_gil)
-                {
-                    PyGILState_Release(local_gstate);
-                }
-                return -1;
             }
-            // Call the Python init function with proper capsule
-            PyObject *result =
-                PyObject_CallFunctionObjArgs(plugin->python_plugin->pFuncInit, args, NULL);
+        }
 
-            // Store the capsule reference for the lifetime of the plugin
-            plugin->python_plugin->args_capsule = args;
+        // The capsule must be created in the interpreter the plugin lives in
+        python_call_t call;
+        python_call_enter(plugin->python_plugin, &call);
 
-            if (!result)
-            {
-                PyErr_Print();
-                fprintf(stderr, "Python init function failed for plugin: %s\n",
-                        plugin->config.name);
+        // Generate structured args for Python plugin
+        PyObject *args =
+            (PyObject *)generate_structured_args_with_driver(PLUGIN_TYPE_PYTHON, driver, i);
+        if (!args)
+        {
+            fprintf(stderr, "Failed to generate runtime args for plugin: %s\n",
+                    plugin->config.name);
+            python_call_leave(&call);
+            return -1;
+        }
+        // Call the Python init function with proper capsule
+        PyObject *result =
+            PyObject_CallFunctionObjArgs(plugin->python_plugin->pFuncInit, args, NULL);
 
-                if (have_gil)
-                {
-                    PyGILState_Release(local_gstate);
-                }
-                return -1;
-            }
-            Py_DECREF(result);
+        // Store the capsule reference for the lifetime of the plugin
+        plugin->python_plugin->args_capsule = args;
+
+        if (!result)
+        {
+            PyErr_Print();
+            fprintf(stderr, "Python init function failed for plugin: %s\n", plugin->config.name);
+            python_call_leave(&call);
+            return -1;
+        }
+        Py_DECREF(result);
+        python_call_leave(&call);
+    }
+    else if (plugin->config.type == PLUGIN_TYPE_NATIVE && plugin->native_plugin &&
+             (plugin->native_plugin->init || plugin->native_plugin->init_abi))
+    {
+        // Generate structured args for native plugin
+        plugin_runtime_args_t *args =
+            (plugin_runtime_args_t *)generate_structured_args_with_driver(PLUGIN_TYPE_NATIVE,
+                                                                          driver, i);
+        if (!args)
+        {
+            fprintf(stderr, "Failed to generate runtime args for native plugin: %s\n",
+                    plugin->config.name);
+            return -1;
+        }
+
+        // Call the native init function, with the sizes and capabilities for version 2
+        int result;
+        if (plugin->native_plugin->init_abi)
+        {
+            plugin_abi_t abi = {
+                .size         = sizeof(plugin_abi_t),
+                .version      = PLUGIN_ABI_VERSION,
+                .args_size    = sizeof(plugin_runtime_args_t),
+                .args         = args,
+                .capabilities = plugin_capabilities_for(i),
+            };
+            result = plugin->native_plugin->init_abi(&abi);
+        }
+        else
+        {
+            result = plugin->native_plugin->init(args);
         }
-        else if (plugin->config.type == PLUGIN_TYPE_NATIVE && plugin->native_plugin &&
-                 plugin->native_plugin->init)
+        if (result != 0)
+        {
+            fprintf(stderr, "Native init function failed for plugin: %s (returned %d)\n",
+                    plugin->config.name, result);
+            free_structured_args(args);
+            return -1;
+        }
+
+        // Free the args after successful initialization
+        free_structured_args(args);
+    }
+    else if (plugin->config.type == PLUGIN_TYPE_PROCESS)
+    {
+        // The bridge waits on the signal, it is kept like for Python plugins
+        if (!plugin->cycle_signal)
         {
-            // Generate structured args for native plugin
-            plugin_runtime_args_t *args =
-                (plugin_runtime_args_t *)generate_structured_args_with_driver(PLUGIN_TYPE_NATIVE,
-                                                                              driver, i);
-            if (!args)
+            plugin->cycle_signal = plugin_cycle_signal_create();
+            if (!plugin->cycle_signal)
             {
-                fprintf(stderr, "Failed to generate runtime args for native plugin: %s\n",
+                fprintf(stderr, "[PLUGIN]: No cycle signal for process plugin %s\n",
                         plugin->config.name);
-                if (have_gil)
-                {
-                    PyGILState_Release(local_gstate);
-                }
                 return -1;
             }
+        }
 
-            // Call the native init function
-            int result = plugin->native_plugin->init(args);
-            if (result != 0)
-            {
-                fprintf(stderr, "Native init function failed for plugin: %s (returned %d)\n",
-                        plugin->config.name, result);
-                free_structured_args(args);
-                if (have_gil)
-                {
-                    PyGILState_Release(local_gstate);
-                }
-                return -1;
-            }
+        // A new init (after a reload) may come with another executable or config
+        plugin_process_destroy(plugin->process_plugin);
+        plugin->process_plugin = NULL;
 
-            // Free the args after successful initialization
-            free_structured_args(args);
+        // The bridge uses the journal entry points and log functions of the plugin's slot
+        plugin_runtime_args_t *args =
+            (plugin_runtime_args_t *)generate_structured_args_with_driver(PLUGIN_TYPE_NATIVE,
+                                                                          driver, i);
+        if (!args)
+        {
+            fprintf(stderr, "Failed to generate runtime args for process plugin: %s\n",
+                    plugin->config.name);
+            return -1;
+        }
+        plugin->process_plugin =
+            plugin_process_create(plugin->config.name, plugin->config.path, args);
+        free_structured_args(args);
+        if (!plugin->process_plugin)
+        {
+            fprintf(stderr, "Failed to create the shared memory of process plugin: %s\n",
+                    plugin->config.name);
+            return -1;
         }
     }
-
-    if (have_gil)
+    return 0;
+}
+
+// Run the cycle hooks of a native plugin with deferred hooks on a thread of their own.
+// Without the thread (inline hooks, or it cannot be created) they run on the scan thread.
+static void plugin_start_hook_thread(plugin_driver_t *driver, int i)
+{
+    plugin_instance_t *plugin = &driver->plugins[i];
+    if (plugin->has_hook_thread || plugin->config.hooks != PLUGIN_HOOKS_DEFERRED ||
+        (!plugin->native_plugin->cycle_start && !plugin->native_plugin->cycle_end))
     {
-        PyGILState_Release(local_gstate);
+        return;
+    }
+
+    // Kept until the driver is destroyed, since the scan thread may still be posting
+    if (!plugin->cycle_signal)
+    {
+        plugin->cycle_signal = plugin_cycle_signal_create();
+    }
+    if (!plugin->cycle_signal)
+    {
+        fprintf(stderr, "[PLUGIN]: No cycle signal for plugin %s, running its hooks inline\n",
+                plugin->config.name);
+        return;
+    }
+    plugin_cycle_signal_reset(plugin->cycle_signal);
+
+    hook_jobs[i].driver = driver;
+    hook_jobs[i].index  = i;
+    atomic_store(&plugin->hook_thread_stop, false);
+    if (pthread_create(&plugin->hook_thread, NULL, plugin_hook_thread, &hook_jobs[i]) != 0)
+    {
+        fprintf(stderr, "[PLUGIN]: Failed to create the hook thread of plugin %s, running its "
+                        "hooks inline\n",
+                plugin->config.name);
+        return;
+    }
+    plugin->has_hook_thread = 1;
+    printf("[PLUGIN]: Native plugin %s runs its cycle hooks deferred\n", plugin->config.name);
+}
+
+// Stop the deferred hook thread, letting a running hook finish
+static void plugin_stop_hook_thread(plugin_instance_t *plugin)
+{
+    if (!plugin->has_hook_thread)
+    {
+        return;
+    }
+    plugin->has_hook_thread = 0;
+    atomic_store(&plugin->hook_thread_stop, true);
+    plugin_cycle_signal_interrupt(plugin->cycle_signal);
+    pthread_join(plugin->hook_thread, NULL);
+
+    unsigned long long delivered = 0, missed = 0;
+    plugin_cycle_signal_stats(plugin->cycle_signal, &delivered, &missed);
+    printf("[PLUGIN]: Plugin %s ran deferred hooks for %llu cycles, missed %llu\n",
+           plugin->config.name, delivered, missed);
+}
+
+// Call one plugin's start function, see plugin_init_one()
+static int plugin_start_one(plugin_driver_t *driver, int i)
+{
+    plugin_instance_t *plugin = &driver->plugins[i];
+
+    switch (plugin->config.type)
+    {
+    case PLUGIN_TYPE_PYTHON:
+    {
+        // Python plugins run asynchronously in their own threads.
+        // NOTE: The thread is created python-side
+        if (plugin->python_plugin && plugin->python_plugin->pFuncStart)
+        {
+            if (plugin->cycle_signal)
+            {
+                plugin_cycle_signal_reset(plugin->cycle_signal);
+            }
+
+            // Acquire the plugin interpreter's GIL for this specific Python call
+            python_call_t call;
+            python_call_enter(plugin->python_plugin, &call);
+            PyObject *res = PyObject_CallNoArgs(plugin->python_plugin->pFuncStart);
+            if (!res)
+            {
+                PyErr_Print();
+                fprintf(stderr, "Python start call failed for plugin: %s\n", plugin->config.name);
+            }
+            else
+            {
+                printf("[PLUGIN]: Plugin %s started successfully.\n", plugin->config.name);
+            }
+            Py_XDECREF(
+                res); // There's no problem in calling DECREF here because it only
+                      // handles the returned object from start_loop, not the function itself
+            python_call_leave(&call);
+
+            plugin->running = 1;
+        }
+        else
+        {
+            fprintf(stderr, "Python plugin %s does not have a start_loop function.\n",
+                    plugin->config.name);
+        }
+    }
+    break;
+
+    case PLUGIN_TYPE_NATIVE:
+    {
+        // Native plugins run synchronously - call start_loop if available
+        if (plugin->native_plugin && plugin->native_plugin->start)
+        {
+            seq_write_begin(&plugin->hook_stats_seq);
+            memset(plugin->hook_stats, 0, sizeof(plugin->hook_stats));
+            seq_write_end(&plugin->hook_stats_seq);
+
+            plugin->native_plugin->start();
+            printf("[PLUGIN]: Native plugin %s started successfully.\n", plugin->config.name);
+            plugin_start_hook_thread(driver, i);
+            plugin->running = 1;
+        }
+        else
+        {
+            fprintf(stderr, "Native plugin %s does not have a start_loop function.\n",
+                    plugin->config.name);
+        }
     }
+    break;
 
+    case PLUGIN_TYPE_PROCESS:
+    {
+        // The process runs on its own; its bridge thread is woken from cycle_end
+        if (plugin->process_plugin)
+        {
+            plugin_cycle_signal_reset(plugin->cycle_signal);
+            if (plugin_process_start(plugin->process_plugin) == 0)
+            {
+                printf("[PLUGIN]: Process plugin %s started successfully.\n",
+                       plugin->config.name);
+                plugin->running = 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Process plugin %s was not initialized.\n", plugin->config.name);
+        }
+    }
+    break;
+
+    default:
+        break;
+    }
     return 0;
 }
 
-// Call the thread function for each plugin
+typedef int (*plugin_step_func_t)(plugin_driver_t *driver, int index);
+
+// One plugin's init or start call, with how long it took
+typedef struct
+{
+    plugin_driver_t *driver;
+    plugin_step_func_t step;
+    int index;
+    int result;
+    double elapsed_ms;
+    pthread_t thread;
+    int threaded;
+} plugin_step_job_t;
+
+static double plugin_elapsed_ms(const struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - since->tv_sec) * 1000.0 +
+           (double)(now.tv_nsec - since->tv_nsec) / 1000000.0;
+}
+
+static void plugin_step_job_run(plugin_step_job_t *job)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    job->result     = job->step(job->driver, job->index);
+    job->elapsed_ms = plugin_elapsed_ms(&start);
+}
+
+static void *plugin_step_thread(void *arg)
+{
+    plugin_step_job_t *job = (plugin_step_job_t *)arg;
+    plugin_step_job_run(job);
+    return NULL;
+}
+
+// Run step for every enabled plugin, or only those set in selected if it is not NULL.
+// Plugins with parallel startup each run on their own
+// thread while the others run one after the other in config order on the calling thread,
+// so a plugin that blocks in init or start (connecting to a device, say) delays only itself.
+// Returns -1 if the step failed for any plugin, once all of them have finished.
+static int plugin_driver_run_step(plugin_driver_t *driver, plugin_step_func_t step,
+                                  const char *what, const int *selected)
+{
+    plugin_step_job_t jobs[MAX_PLUGINS];
+    int parallel = 0;
+    int failed   = 0;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Python code on the startup threads needs the GIL, which this thread holds after
+    // Py_Initialize(); each step takes it only for its own Python calls
+    PyThreadState *saved = NULL;
+    if (has_python_plugin && Py_IsInitialized() && python_current_tstate())
+    {
+        saved = PyEval_SaveThread();
+    }
+
+    int count = 0;
+    for (int i = 0; i < driver->plugin_count; i++)
+    {
+        jobs[i] = (plugin_step_job_t){.driver = driver, .step = step, .index = i};
+        if (selected && !selected[i])
+        {
+            continue;
+        }
+        count++;
+        if (driver->plugins[i].config.enabled &&
+            driver->plugins[i].config.startup == PLUGIN_STARTUP_PARALLEL)
+        {
+            if (pthread_create(&jobs[i].thread, NULL, plugin_step_thread, &jobs[i]) == 0)
+            {
+                jobs[i].threaded = 1;
+                parallel++;
+            }
+            else
+            {
+                fprintf(stderr, "[PLUGIN]: No %s thread for plugin %s, running it in order\n",
+                        what, driver->plugins[i].config.name);
+            }
+        }
+    }
+
+    for (int i = 0; i < driver->plugin_count; i++)
+    {
+        if (selected && !selected[i])
+        {
+            continue;
+        }
+        if (!driver->plugins[i].config.enabled)
+        {
+            printf("[PLUGIN]: Skipping disabled plugin during %s: %s\n", what,
+                   driver->plugins[i].config.name);
+        }
+        else if (!jobs[i].threaded)
+        {
+            plugin_step_job_run(&jobs[i]);
+        }
+    }
+
+    for (int i = 0; i < driver->plugin_count; i++)
+    {
+        if (jobs[i].threaded)
+        {
+            pthread_join(jobs[i].thread, NULL);
+        }
+        if (driver->plugins[i].config.enabled && (!selected || selected[i]))
+        {
+            printf("[PLUGIN]: Plugin %s %s took %.1f ms%s%s\n", driver->plugins[i].config.name,
+                   what, jobs[i].elapsed_ms, jobs[i].threaded ? " (parallel)" : "",
+                   jobs[i].result != 0 ? ", failed" : "");
+            failed |= jobs[i].result != 0;
+        }
+    }
+
+    if (saved)
+    {
+        PyEval_RestoreThread(saved);
+    }
+
+    printf("[PLUGIN]: Plugin %s took %.1f ms (%d of %d plugins in parallel)\n", what,
+           plugin_elapsed_ms(&start), parallel, count);
+    return failed ? -1 : 0;
+}
+
+// Rebuild the slot lists of plugin_driver_cycle_start/_end, empty if active is 0. Takes
+// buffer_mutex, which the scan thread holds while it runs the hooks, so a plugin is out of
+// the lists before it stops. Callers must not hold the GIL: Python plugin threads can hold
+// buffer_mutex while they wait for it.
+static void plugin_driver_publish_hooks(plugin_driver_t *driver, int active)
+{
+    // Only this function writes the lists, so they can be read without the lock here
+    if (!active && driver->cycle_start_count == 0 && driver->cycle_end_count == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&driver->buffer_mutex);
+    driver->cycle_start_count = 0;
+    driver->cycle_end_count   = 0;
+    for (int i = 0; active && i < driver->plugin_count; i++)
+    {
+        plugin_instance_t *plugin = &driver->plugins[i];
+        if (!plugin->config.enabled || !plugin->running)
+        {
+            continue;
+        }
+
+        // Python plugin threads, deferred hook threads and process bridges are woken from
+        // cycle_end
+        if ((plugin->config.type == PLUGIN_TYPE_PYTHON ||
+             plugin->config.type == PLUGIN_TYPE_PROCESS || plugin->has_hook_thread) &&
+            plugin->cycle_signal)
+        {
+            driver->cycle_end_slots[driver->cycle_end_count++] = (unsigned char)i;
+            continue;
+        }
+
+        if (plugin->config.type == PLUGIN_TYPE_NATIVE && plugin->native_plugin)
+        {
+            if (plugin->native_plugin->cycle_start && !plugin->has_hook_thread)
+            {
+                driver->cycle_start_slots[driver->cycle_start_count++] = (unsigned char)i;
+            }
+            if (plugin->native_plugin->cycle_end)
+            {
+                driver->cycle_end_slots[driver->cycle_end_count++] = (unsigned char)i;
+            }
+        }
+    }
+    pthread_mutex_unlock(&driver->buffer_mutex);
+}
+
+int plugin_driver_init(plugin_driver_t *driver)
+{
+    if (!driver)
+    {
+        return -1;
+    }
+    plugin_driver_join_loader();
+
+    int failed = plugin_load_symbols(driver, NULL, PLUGIN_TYPE_NATIVE);
+    failed |= plugin_load_symbols(driver, NULL, PLUGIN_TYPE_PYTHON);
+    failed |= plugin_load_symbols(driver, NULL, PLUGIN_TYPE_PROCESS);
+    return plugin_driver_run_step(driver, plugin_init_one, "init", NULL) | failed;
+}
+
 int plugin_driver_start(plugin_driver_t *driver)
 {
     if (!driver)
@@ -393,6 +1250,8 @@ int plugin_driver_start(plugin_driver_t *driver)
         return -1;
     }
 
+    plugin_driver_join_loader();
+
     if (driver->plugin_count == 0)
     {
         printf("[PLUGIN]: No plugins to start.\n");
@@ -406,148 +1265,334 @@ int plugin_driver_start(plugin_driver_t *driver)
         main_tstate = PyEval_SaveThread();
     }
 
-    for (int i = 0; i < driver->plugin_count; i++)
+    plugin_driver_run_step(driver, plugin_start_one, "start", NULL);
+    plugin_driver_publish_hooks(driver, 1);
+
+    // Don't call PyGILState_Release here since we used PyEval_SaveThread
+    // The GIL will be restored in plugin_driver_destroy
+    return 0;
+}
+
+// Enabled plugins of one type, as a selection for plugin_driver_run_step()
+static int plugin_select_type(plugin_driver_t *driver, int type, int selected[])
+{
+    int count = 0;
+    for (int i = 0; i < MAX_PLUGINS; i++)
     {
-        plugin_instance_t *plugin = &driver->plugins[i];
+        selected[i] = i < driver->plugin_count && driver->plugins[i].config.enabled &&
+                      driver->plugins[i].config.type == type;
+        count += selected[i];
+    }
+    return count;
+}
+
+int plugin_driver_start_native(plugin_driver_t *driver)
+{
+    if (!driver)
+    {
+        return -1;
+    }
+    plugin_driver_join_loader();
+
+    // Process plugins need no interpreter either, their processes start with the natives
+    int selected[MAX_PLUGINS], process[MAX_PLUGINS];
+    int count = plugin_select_type(driver, PLUGIN_TYPE_NATIVE, selected);
+    count += plugin_select_type(driver, PLUGIN_TYPE_PROCESS, process);
+    if (count == 0)
+    {
+        return 0;
+    }
+    for (int i = 0; i < MAX_PLUGINS; i++)
+    {
+        selected[i] |= process[i];
+    }
+
+    int failed = plugin_load_symbols(driver, selected, PLUGIN_TYPE_NATIVE);
+    failed |= plugin_load_symbols(driver, selected, PLUGIN_TYPE_PROCESS);
+    failed |= plugin_driver_run_step(driver, plugin_init_one, "init", selected);
+    plugin_driver_run_step(driver, plugin_start_one, "start", selected);
+    plugin_driver_publish_hooks(driver, 1);
+    return failed;
+}
+
+// Import, init and start the selected Python plugins, then add them to the scan's hook
+// list so their cycle signals are posted from the next cycle_end on
+static void python_loader_run(plugin_driver_t *driver)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    plugin_load_symbols(driver, python_loader_selected, PLUGIN_TYPE_PYTHON);
+    plugin_driver_run_step(driver, plugin_init_one, "init", python_loader_selected);
+    plugin_driver_run_step(driver, plugin_start_one, "start", python_loader_selected);
+    plugin_driver_publish_hooks(driver, 1);
+
+    printf("[PLUGIN]: Python plugins attached after %.1f ms\n", plugin_elapsed_ms(&start));
+    boot_timeline_mark("python plugins attached");
+    boot_timeline_end();
+}
+
+static void *python_loader_thread(void *arg)
+{
+    python_loader_run((plugin_driver_t *)arg);
+    return NULL;
+}
 
-        // Skip disabled plugins
-        if (!plugin->config.enabled)
+int plugin_driver_start_python(plugin_driver_t *driver)
+{
+    if (!driver)
+    {
+        return -1;
+    }
+    plugin_driver_join_loader();
+
+    if (plugin_select_type(driver, PLUGIN_TYPE_PYTHON, python_loader_selected) == 0)
+    {
+        if (!Py_IsInitialized())
         {
-            printf("[PLUGIN]: Skipping disabled plugin during start: %s\n", plugin->config.name);
-            continue;
+            printf("[PLUGIN]: No Python plugin enabled, the interpreter is not started\n");
         }
+        return 0;
+    }
 
-        switch (plugin->config.type)
+    // The interpreter is started here so it belongs to this thread, which also finalizes
+    // it; the loader only takes the GIL for its calls
+    if (!Py_IsInitialized())
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        python_start_interpreter();
+        gstate      = PyGILState_Ensure();
+        main_tstate = PyEval_SaveThread();
+        printf("[PLUGIN]: Python interpreter started in %.1f ms\n", plugin_elapsed_ms(&start));
+        boot_timeline_mark("python interpreter");
+    }
+
+    pthread_mutex_lock(&python_loader_mutex);
+    python_loader_running =
+        pthread_create(&python_loader, NULL, python_loader_thread, driver) == 0;
+    pthread_mutex_unlock(&python_loader_mutex);
+    if (python_loader_running)
+    {
+        return 1;
+    }
+
+    fprintf(stderr, "[PLUGIN]: No thread to start the Python plugins, starting them now\n");
+    python_loader_run(driver);
+    return 0;
+}
+
+bool plugin_driver_is_started(plugin_driver_t *driver)
+{
+    if (!driver)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&python_loader_mutex);
+    bool started = python_loader_running;
+    pthread_mutex_unlock(&python_loader_mutex);
+    for (int i = 0; !started && i < driver->plugin_count; i++)
+    {
+        started = driver->plugins[i].running;
+    }
+    return started;
+}
+
+// Call one plugin's stop function if it is running
+static void plugin_stop_one(plugin_driver_t *driver, int i)
+{
+    plugin_instance_t *plugin = &driver->plugins[i];
+
+    if (plugin->python_plugin && plugin->python_plugin->pFuncStop && plugin->running)
+    {
+        if (plugin->config.enabled == 0)
         {
-        case PLUGIN_TYPE_PYTHON:
+            printf("[PLUGIN]: Plugin %s is disabled, skipping stop.\n", plugin->config.name);
+            return;
+        }
+
+        // Wake a thread blocked in wait_cycle so it sees its stop flag
+        if (plugin->cycle_signal)
         {
-            // Python plugins run asynchronously in their own threads.
-            // NOTE: The thread is created python-side
-            if (plugin->python_plugin && plugin->python_plugin->pFuncStart)
-            {
-                // Acquire GIL for this specific Python call
-                PyGILState_STATE local_gil = PyGILState_Ensure();
-                PyObject *res              = PyObject_CallNoArgs(plugin->python_plugin->pFuncStart);
-                if (!res)
-                {
-                    PyErr_Print();
-                    fprintf(stderr, "Python start call failed for plugin: %s\n",
-                            plugin->config.name);
-                }
-                else
-                {
-                    printf("[PLUGIN]: Plugin %s started successfully.\n", plugin->config.name);
-                }
-                Py_DECREF(
-                    res); // There's no problem in calling DECREF here because it only
-                          // handles the returned object from start_loop, not the function itself
-                PyGILState_Release(local_gil);
+            plugin_cycle_signal_interrupt(plugin->cycle_signal);
+        }
 
-                plugin->running = 1;
-            }
-            else
-            {
-                fprintf(stderr, "Python plugin %s does not have a start_loop function.\n",
-                        plugin->config.name);
-            }
+        python_call_t call;
+        python_call_enter(plugin->python_plugin, &call);
+        PyObject *res = PyObject_CallNoArgs(plugin->python_plugin->pFuncStop);
+        if (!res)
+        {
+            PyErr_Print();
+            fprintf(stderr, "Python stop call failed for plugin: %s\n", plugin->config.name);
         }
-        break;
+        else
+        {
+            printf("[PLUGIN]: Plugin %s stopped successfully.\n", plugin->config.name);
+        }
+        Py_XDECREF(res);
+        python_call_leave(&call);
+        printf("[PLUGIN]: Plugin %s stopped...\n", plugin->config.name);
+        plugin->running = 0;
 
-        case PLUGIN_TYPE_NATIVE:
+        unsigned long long delivered = 0, missed = 0;
+        if (plugin->cycle_signal)
         {
-            // Native plugins run synchronously - call start_loop if available
-            if (plugin->native_plugin && plugin->native_plugin->start)
-            {
-                plugin->native_plugin->start();
-                printf("[PLUGIN]: Native plugin %s started successfully.\n", plugin->config.name);
-                plugin->running = 1;
-            }
-            else
-            {
-                fprintf(stderr, "Native plugin %s does not have a start_loop function.\n",
-                        plugin->config.name);
-            }
+            plugin_cycle_signal_stats(plugin->cycle_signal, &delivered, &missed);
         }
-        break;
+        if (delivered > 0)
+        {
+            printf("[PLUGIN]: Plugin %s handled %llu cycles, missed %llu\n", plugin->config.name,
+                   delivered, missed);
+        }
+    }
 
-        default:
-            break;
+    else if (plugin->native_plugin && plugin->running)
+    {
+        // Deferred hooks must not run into a stopped or unloaded plugin
+        plugin_stop_hook_thread(plugin);
+        if (plugin->native_plugin->stop)
+        {
+            plugin->native_plugin->stop();
+            printf("[PLUGIN]: Native plugin %s stopped successfully.\n", plugin->config.name);
+            plugin->running = 0;
         }
     }
-    // Don't call PyGILState_Release here since we used PyEval_SaveThread
-    // The GIL will be restored in plugin_driver_destroy
+
+    else if (plugin->process_plugin && plugin->running)
+    {
+        plugin_process_stop(plugin->process_plugin);
+        plugin->running = 0;
+
+        unsigned long long delivered = 0, missed = 0, restarts = 0, rejected = 0;
+        plugin_cycle_signal_stats(plugin->cycle_signal, &delivered, &missed);
+        plugin_process_stats(plugin->process_plugin, &restarts, &rejected);
+        printf("[PLUGIN]: Process plugin %s stopped after %llu cycles, missed %llu, restarted "
+               "%llu times, %llu writes rejected\n",
+               plugin->config.name, delivered, missed, restarts, rejected);
+    }
+    // Plugin manager only handles destruction, not stopping
+}
+
+int plugin_driver_stop(plugin_driver_t *driver)
+{
+    printf("[PLUGIN]: Stopping all plugins...\n");
+    if (!driver)
+    {
+        return -1;
+    }
+    plugin_driver_join_loader();
+
+    if (driver->plugin_count == 0)
+    {
+        printf("[PLUGIN]: No plugins to stop.\n");
+        return 0;
+    }
+
+    plugin_driver_publish_hooks(driver, 0);
+
+    // Only acquire Python GIL if we have Python plugins and Python is initialized
+    PyGILState_STATE local_gstate;
+    int need_gil = has_python_plugin && Py_IsInitialized();
+    if (need_gil)
+    {
+        local_gstate = PyGILState_Ensure();
+    }
+
+    // Signal all plugins to stop
+    for (int i = 0; i < driver->plugin_count; i++)
+    {
+        printf("[PLUGIN]: Stopping plugin %d/%d: %s\n", i + 1, driver->plugin_count,
+               driver->plugins[i].config.name);
+        plugin_stop_one(driver, i);
+    }
+
+    if (need_gil)
+    {
+        PyGILState_Release(local_gstate);
+    }
+
     return 0;
 }
 
-int plugin_driver_stop(plugin_driver_t *driver)
+static int plugin_config_equal(const plugin_config_t *a, const plugin_config_t *b)
+{
+    return strcmp(a->name, b->name) == 0 && strcmp(a->path, b->path) == 0 &&
+           a->enabled == b->enabled && a->type == b->type &&
+           strcmp(a->plugin_related_config_path, b->plugin_related_config_path) == 0 &&
+           strcmp(a->venv_path, b->venv_path) == 0 && a->isolation == b->isolation &&
+           a->startup == b->startup && a->hook_budget_us == b->hook_budget_us &&
+           a->hooks == b->hooks;
+}
+
+int plugin_driver_reload(plugin_driver_t *driver, const char *config_file)
 {
-    printf("[PLUGIN]: Stopping all plugins...\n");
-    if (!driver)
+    if (!driver || !config_file)
     {
         return -1;
     }
 
-    if (driver->plugin_count == 0)
+    plugin_config_t previous[MAX_PLUGINS];
+    int previous_count = driver->plugin_count;
+    for (int i = 0; i < previous_count; i++)
     {
-        printf("[PLUGIN]: No plugins to stop.\n");
-        return 0;
+        previous[i] = driver->plugins[i].config;
     }
 
-    // Only acquire Python GIL if we have Python plugins and Python is initialized
-    PyGILState_STATE local_gstate;
-    int need_gil = has_python_plugin && Py_IsInitialized();
-    if (need_gil)
+    if (plugin_driver_update_config(driver, config_file) != 0)
     {
-        local_gstate = PyGILState_Ensure();
+        driver->plugin_count = previous_count;
+        for (int i = 0; i < previous_count; i++)
+        {
+            driver->plugins[i].config = previous[i];
+        }
+        return -1;
     }
 
-    // Signal all plugins to stop
-    for (int i = 0; i < driver->plugin_count; i++)
+    // A running plugin keeps running if its line in the config did not change; everything
+    // else is stopped with its previous config and started again with the new one
+    int restart[MAX_PLUGINS] = {0};
+    int kept                 = 0;
+    int restarted            = 0;
+    plugin_driver_publish_hooks(driver, 0);
+    for (int i = 0; i < previous_count || i < driver->plugin_count; i++)
     {
-        printf("[PLUGIN]: Stopping plugin %d/%d: %s\n", i + 1, driver->plugin_count,
-               driver->plugins[i].config.name);
-        if (driver->plugins[i].python_plugin && driver->plugins[i].python_plugin->pFuncStop &&
-            driver->plugins[i].running)
+        plugin_instance_t *plugin = &driver->plugins[i];
+        int unchanged = i < previous_count && i < driver->plugin_count &&
+                        plugin_config_equal(&previous[i], &plugin->config);
+        if (unchanged && (plugin->running || !plugin->config.enabled))
         {
-            plugin_instance_t *plugin = &driver->plugins[i];
-            if (plugin->config.enabled == 0)
-            {
-                printf("[PLUGIN]: Plugin %s is disabled, skipping stop.\n", plugin->config.name);
-                continue;
-            }
+            kept += plugin->running;
+            continue;
+        }
 
-            PyObject *res = PyObject_CallNoArgs(driver->plugins[i].python_plugin->pFuncStop);
-            if (!res)
-            {
-                PyErr_Print();
-                fprintf(stderr, "Python stop call failed for plugin: %s\n", plugin->config.name);
-            }
-            else
-            {
-                printf("[PLUGIN]: Plugin %s stopped successfully.\n", plugin->config.name);
-            }
-            Py_DECREF(res);
-            printf("[PLUGIN]: Plugin %s stopped...\n", driver->plugins[i].config.name);
-            plugin->running = 0;
+        if (plugin->running)
+        {
+            plugin_config_t next = plugin->config;
+            plugin->config       = previous[i];
+            plugin_stop_one(driver, i);
+            plugin->config = next;
         }
 
-        else if (driver->plugins[i].native_plugin && driver->plugins[i].native_plugin->stop &&
-                 driver->plugins[i].running)
+        if (i < driver->plugin_count && plugin->config.enabled)
         {
-            plugin_instance_t *plugin = &driver->plugins[i];
-            plugin->native_plugin->stop();
-            printf("[PLUGIN]: Native plugin %s stopped successfully.\n", plugin->config.name);
-            plugin->running = 0;
+            restart[i] = 1;
+            restarted++;
         }
-        // Plugin manager only handles destruction, not stopping
     }
 
-    if (need_gil)
+    printf("[PLUGIN]: Reload keeps %d plugins running, restarts %d\n", kept, restarted);
+    int result = 0;
+    if (restarted > 0)
     {
-        PyGILState_Release(local_gstate);
+        result = plugin_load_symbols(driver, restart, PLUGIN_TYPE_NATIVE);
+        result |= plugin_load_symbols(driver, restart, PLUGIN_TYPE_PYTHON);
+        result |= plugin_load_symbols(driver, restart, PLUGIN_TYPE_PROCESS);
+        result |= plugin_driver_run_step(driver, plugin_init_one, "init", restart);
+        plugin_driver_run_step(driver, plugin_start_one, "start", restart);
     }
-
-    return 0;
+    plugin_driver_publish_hooks(driver, 1);
+    return result;
 }
 
 int plugin_driver_restart(plugin_driver_t *driver)
@@ -608,16 +1653,28 @@ int plugin_driver_restart(plugin_driver_t *driver)
     return 0;
 }
 
+// Signals live in the plugin slots, which may lie beyond plugin_count after a reload
+static void destroy_cycle_signals(plugin_driver_t *driver)
+{
+    for (int i = 0; i < MAX_PLUGINS; i++)
+    {
+        plugin_cycle_signal_destroy(driver->plugins[i].cycle_signal);
+        driver->plugins[i].cycle_signal = NULL;
+    }
+}
+
 void plugin_driver_destroy(plugin_driver_t *driver)
 {
     if (!driver)
     {
         return;
     }
+    plugin_driver_join_loader();
 
     if (driver->plugin_count == 0)
     {
         printf("[PLUGIN]: No plugins to destroy.\n");
+        destroy_cycle_signals(driver);
         pthread_mutex_destroy(&driver->buffer_mutex);
         free(driver);
         return;
@@ -628,6 +1685,8 @@ void plugin_driver_destroy(plugin_driver_t *driver)
     // Initialize to PyGILState_LOCKED (0) to satisfy compiler warning
     PyGILState_STATE local_gstate = PyGILState_LOCKED;
 
+    // plugin_driver_stop() empties the hook lists too, but would do it holding the GIL
+    plugin_driver_publish_hooks(driver, 0);
     if (python_initialized)
     {
         local_gstate = PyGILState_Ensure();
@@ -661,6 +1720,8 @@ void plugin_driver_destroy(plugin_driver_t *driver)
             free(plugin->native_plugin);
             plugin->native_plugin = NULL;
         }
+        plugin_process_destroy(plugin->process_plugin);
+        plugin->process_plugin = NULL;
     }
 
     if (python_initialized)
@@ -673,6 +1734,7 @@ void plugin_driver_destroy(plugin_driver_t *driver)
         Py_FinalizeEx();
     }
 
+    destroy_cycle_signals(driver);
     pthread_mutex_destroy(&driver->buffer_mutex);
 
     free(driver);
@@ -745,7 +1807,7 @@ void *generate_structured_args_with_driver(plugin_type_t type, plugin_driver_t *
            sizeof(driver->plugins[plugin_index].config.plugin_related_config_path));
 
     // Initialize buffer size info
-    args->buffer_size     = BUFFER_SIZE;
+    args->buffer_size     = (int)image_tables_size();
     args->bits_per_buffer = 8;
 
     // Initialize logging functions
@@ -754,12 +1816,37 @@ void *generate_structured_args_with_driver(plugin_type_t type, plugin_driver_t *
     args->log_warn  = log_warn;
     args->log_error = log_error;
 
-    // Initialize journal write functions for race-condition-free buffer writes
-    args->journal_write_bool = plugin_journal_write_bool;
-    args->journal_write_byte = plugin_journal_write_byte;
-    args->journal_write_int  = plugin_journal_write_int;
-    args->journal_write_dint = plugin_journal_write_dint;
-    args->journal_write_lint = plugin_journal_write_lint;
+    // Initialize journal write functions for race-condition-free buffer writes, the
+    // entry points of this plugin's slot so its rejected writes are counted
+    const plugin_journal_slot_t *journal = &journal_slots[plugin_index];
+    atomic_store_explicit(&journal_rejected[plugin_index], 0, memory_order_relaxed);
+    args->journal_write_bool  = journal->write_bool;
+    args->journal_write_byte  = journal->write_byte;
+    args->journal_write_int   = journal->write_int;
+    args->journal_write_dint  = journal->write_dint;
+    args->journal_write_lint  = journal->write_lint;
+    args->journal_write_range = journal->write_range;
+
+    // Packed image areas for bulk reads
+    args->get_image_area      = plugin_get_image_area;
+    args->read_image_snapshot = plugin_read_image_snapshot;
+    args->read_image_changes  = plugin_read_image_changes;
+
+    // Records logged through log_message carry the plugin as their source
+    args->plugin_id   = plugin_index + 1;
+    args->log_message = log_message;
+    args->log_limited = log_message_limited;
+
+    // Scan notifications, created by plugin_init_one() for Python and process plugins
+    args->cycle_signal = driver->plugins[plugin_index].cycle_signal;
+    args->wait_cycle   = plugin_wait_cycle;
+
+    // Metrics registered by the plugin are labelled with its name
+    metrics_set_source_name(args->plugin_id, driver->plugins[plugin_index].config.name);
+    args->metric_register = metrics_register_source;
+    args->metric_add      = metrics_add;
+    args->metric_set      = metrics_set;
+    args->metric_register_labels = metrics_register_source_labels;
 
     // printf("[PLUGIN]: Runtime args initialized:\n");
     // printf("[PLUGIN]:   buffer_size = %d\n", args->buffer_size);
@@ -823,26 +1910,10 @@ void free_structured_args(plugin_runtime_args_t *args)
     }
 }
 
-int python_plugin_get_symbols(plugin_instance_t *plugin)
+// Import a Python plugin module and resolve its entry points.
+// Runs attached to the interpreter the plugin lives in.
+static int python_plugin_load_module(plugin_instance_t *plugin, python_binds_t *py_binds)
 {
-    if (!plugin || plugin->config.path[0] == '\0')
-    {
-        return -1;
-    }
-
-    // Allocate python binds structure
-    python_binds_t *py_binds = calloc(1, sizeof(python_binds_t));
-    if (!py_binds)
-    {
-        return -1;
-    }
-
-    // Initialize Python if not already initialized
-    if (!Py_IsInitialized())
-    {
-        Py_Initialize();
-    }
-
     // Extract module name from plugin path
     // Remove .py extension and directory path if present
     char module_name[256];
@@ -904,7 +1975,6 @@ int python_plugin_get_symbols(plugin_instance_t *plugin)
                     fprintf(stderr, "Failed to insert venv path into sys.path for plugin: %s\n",
                             plugin->config.name);
                     Py_DECREF(venv_path_obj);
-                    free(py_binds);
                     return -1;
                 }
             }
@@ -913,7 +1983,6 @@ int python_plugin_get_symbols(plugin_instance_t *plugin)
         else
         {
             fprintf(stderr, "Failed to get sys.path for plugin: %s\n", plugin->config.name);
-            free(py_binds);
             return -1;
         }
         printf("[PLUGIN] Using venv for %s: %s\n", plugin->config.name, venv_site_packages);
@@ -926,7 +1995,6 @@ int python_plugin_get_symbols(plugin_instance_t *plugin)
         fprintf(stderr, "Failed to load Python module '%s' from path '%s'\n", module_name,
                 plugin->config.path);
         PyErr_Print();
-        free(py_binds);
         return -1;
     }
 
@@ -939,7 +2007,6 @@ int python_plugin_get_symbols(plugin_instance_t *plugin)
                 "is required\n",
                 module_name);
         Py_XDECREF(py_binds->pModule);
-        free(py_binds);
         return -1;
     }
 
@@ -967,9 +2034,6 @@ int python_plugin_get_symbols(plugin_instance_t *plugin)
         py_binds->pFuncCleanup = NULL;
     }
 
-    // Store the python binds in the plugin instance
-    plugin->python_plugin = py_binds;
-
     printf("Python plugin '%s' symbols loaded successfully\n", module_name);
     printf("  - init: %s\n", py_binds->pFuncInit ? "(PASS)" : "(FAIL)");
     printf("  - start_loop: %s\n", py_binds->pFuncStart ? "(PASS)" : "(FAIL)");
@@ -979,6 +2043,102 @@ int python_plugin_get_symbols(plugin_instance_t *plugin)
     return 0;
 }
 
+int python_plugin_get_symbols(plugin_instance_t *plugin)
+{
+    if (!plugin || plugin->config.path[0] == '\0')
+    {
+        return -1;
+    }
+
+    // Allocate python binds structure
+    python_binds_t *py_binds = calloc(1, sizeof(python_binds_t));
+    if (!py_binds)
+    {
+        return -1;
+    }
+
+    // Initialize Python if not already initialized
+    python_start_interpreter();
+
+    // Enter the interpreter the plugin will live in
+    python_call_t call;
+    if (plugin->config.isolation == PLUGIN_ISOLATION_SUBINTERPRETER && PYTHON_HAS_SUBINTERPRETERS)
+    {
+        if (python_call_enter_new_interpreter(py_binds, &call) != 0)
+        {
+            fprintf(stderr, "Failed to create subinterpreter for plugin: %s\n",
+                    plugin->config.name);
+            free(py_binds);
+            return -1;
+        }
+        printf("[PLUGIN]: Plugin %s runs in its own subinterpreter\n", plugin->config.name);
+    }
+    else
+    {
+        if (plugin->config.isolation == PLUGIN_ISOLATION_SUBINTERPRETER)
+        {
+            printf("[PLUGIN]: Subinterpreters need Python 3.12, plugin %s shares the main "
+                   "interpreter\n",
+                   plugin->config.name);
+        }
+        python_call_enter(py_binds, &call);
+    }
+
+    int result = python_plugin_load_module(plugin, py_binds);
+    python_call_leave(&call);
+    if (result != 0)
+    {
+        python_end_interpreter(py_binds);
+        free(py_binds);
+        return -1;
+    }
+
+    // Store the python binds in the plugin instance
+    plugin->python_plugin = py_binds;
+    return 0;
+}
+
+// Start the interpreter if it is not running yet; the calling thread then holds the GIL
+static void python_start_interpreter(void)
+{
+    if (Py_IsInitialized())
+    {
+        return;
+    }
+
+    // Built-in modules must be registered before the interpreter starts
+    if (python_buffer_module_register() != 0)
+    {
+        fprintf(stderr, "Failed to register the openplc_buffers module\n");
+    }
+    Py_Initialize();
+}
+
+// Look up an optional entry point of a native plugin. With a declaration only the hooks it
+// lists are looked up, and a listed one that is missing sets *missing.
+static void *native_plugin_hook(void *handle, const char *path,
+                                const plugin_declaration_t *declaration, unsigned int hook,
+                                const char *symbol, int *missing)
+{
+    if (declaration && !(declaration->hooks & hook))
+    {
+        return NULL;
+    }
+    void *func = dlsym(handle, symbol);
+    if (!func && declaration)
+    {
+        fprintf(stderr, "Error: '%s' is declared but not found in native plugin '%s'\n", symbol,
+                path);
+        *missing = 1;
+    }
+    else if (!func && hook != PLUGIN_HOOK_COMMAND)
+    {
+        fprintf(stderr, "Warning: '%s' function not found in native plugin '%s' (optional)\n",
+                symbol, path);
+    }
+    return func;
+}
+
 int native_plugin_get_symbols(plugin_instance_t *plugin)
 {
     if (!plugin || plugin->config.path[0] == '\0')
@@ -1008,10 +2168,39 @@ int native_plugin_get_symbols(plugin_instance_t *plugin)
     // Clear any existing error
     dlerror();
 
+    // A version 2 plugin declares its hooks and the capabilities it needs
+    const plugin_declaration_t *declaration =
+        (const plugin_declaration_t *)dlsym(handle, "plugin_declaration");
+    native_bundle->abi_version = 1;
+    if (declaration)
+    {
+        if (declaration->size < sizeof(plugin_declaration_t) || declaration->abi_version < 2)
+        {
+            fprintf(stderr, "Error: invalid plugin_declaration in native plugin '%s'\n",
+                    plugin->config.path);
+            dlclose(handle);
+            free(native_bundle);
+            return -1;
+        }
+        unsigned int missing = declaration->required & ~PLUGIN_RUNTIME_CAPABILITIES;
+        if (missing)
+        {
+            fprintf(stderr,
+                    "Error: native plugin '%s' (ABI version %u) requires capabilities 0x%x "
+                    "this runtime (ABI version %d) does not provide\n",
+                    plugin->config.path, declaration->abi_version, missing, PLUGIN_ABI_VERSION);
+            dlclose(handle);
+            free(native_bundle);
+            return -1;
+        }
+        native_bundle->abi_version = declaration->abi_version;
+        native_bundle->init_abi    = (plugin_init_abi_func_t)dlsym(handle, "plugin_init");
+    }
+
     // Get function pointers for required functions
-    // init function is required
+    // init function is required, unless a declared plugin has plugin_init
     native_bundle->init = (plugin_init_func_t)dlsym(handle, "init");
-    if (!native_bundle->init)
+    if (!native_bundle->init && !native_bundle->init_abi)
     {
         fprintf(stderr, "Error: 'init' function not found in native plugin '%s': %s\n",
                 plugin->config.path, dlerror());
@@ -1021,123 +2210,295 @@ int native_plugin_get_symbols(plugin_instance_t *plugin)
     }
 
     // Optional functions - set to NULL if not found
-    native_bundle->start = (plugin_start_loop_func_t)dlsym(handle, "start_loop");
-    if (!native_bundle->start)
-    {
-        fprintf(stderr,
-                "Warning: 'start_loop' function not found in native plugin '%s' (optional)\n",
-                plugin->config.path);
-    }
-
-    native_bundle->stop = (plugin_stop_loop_func_t)dlsym(handle, "stop_loop");
-    if (!native_bundle->stop)
-    {
-        fprintf(stderr,
-                "Warning: 'stop_loop' function not found in native plugin '%s' (optional)\n",
-                plugin->config.path);
-    }
-
-    native_bundle->cycle_start = (plugin_cycle_start_func_t)dlsym(handle, "cycle_start");
-    if (!native_bundle->cycle_start)
-    {
-        fprintf(stderr,
-                "Warning: 'cycle_start' function not found in native plugin '%s' (optional)\n",
-                plugin->config.path);
-    }
-
-    native_bundle->cycle_end = (plugin_cycle_end_func_t)dlsym(handle, "cycle_end");
-    if (!native_bundle->cycle_end)
-    {
-        fprintf(stderr,
-                "Warning: 'cycle_end' function not found in native plugin '%s' (optional)\n",
-                plugin->config.path);
-    }
-
-    native_bundle->cleanup = (plugin_cleanup_func_t)dlsym(handle, "cleanup");
-    if (!native_bundle->cleanup)
+    int missing_hook = 0;
+    native_bundle->start = (plugin_start_loop_func_t)native_plugin_hook(
+        handle, plugin->config.path, declaration, PLUGIN_HOOK_START_LOOP, "start_loop",
+        &missing_hook);
+    native_bundle->stop = (plugin_stop_loop_func_t)native_plugin_hook(
+        handle, plugin->config.path, declaration, PLUGIN_HOOK_STOP_LOOP, "stop_loop",
+        &missing_hook);
+    native_bundle->cycle_start = (plugin_cycle_start_func_t)native_plugin_hook(
+        handle, plugin->config.path, declaration, PLUGIN_HOOK_CYCLE_START, "cycle_start",
+        &missing_hook);
+    native_bundle->cycle_end = (plugin_cycle_end_func_t)native_plugin_hook(
+        handle, plugin->config.path, declaration, PLUGIN_HOOK_CYCLE_END, "cycle_end",
+        &missing_hook);
+    native_bundle->cleanup = (plugin_cleanup_func_t)native_plugin_hook(
+        handle, plugin->config.path, declaration, PLUGIN_HOOK_CLEANUP, "cleanup", &missing_hook);
+    native_bundle->command = (plugin_command_func_t)native_plugin_hook(
+        handle, plugin->config.path, declaration, PLUGIN_HOOK_COMMAND, "handle_command",
+        &missing_hook);
+    if (missing_hook)
     {
-        fprintf(stderr, "Warning: 'cleanup' function not found in native plugin '%s' (optional)\n",
-                plugin->config.path);
+        dlclose(handle);
+        free(native_bundle);
+        return -1;
     }
 
     // Store the native bundle and handle in the plugin instance
     plugin->native_plugin = native_bundle;
 
     printf("Native plugin '%s' symbols loaded successfully\n", plugin->config.path);
-    printf("  - init: (PASS)\n");
+    printf("  - ABI version: %u\n", native_bundle->abi_version);
+    printf("  - init: (PASS)%s\n", native_bundle->init_abi ? " plugin_init" : "");
     printf("  - start_loop: %s\n", native_bundle->start ? "(PASS)" : "(FAIL)");
     printf("  - stop_loop: %s\n", native_bundle->stop ? "(PASS)" : "(FAIL)");
     printf("  - cycle_start: %s\n", native_bundle->cycle_start ? "(PASS)" : "(FAIL)");
     printf("  - cycle_end: %s\n", native_bundle->cycle_end ? "(PASS)" : "(FAIL)");
     printf("  - cleanup: %s\n", native_bundle->cleanup ? "(PASS)" : "(FAIL)");
+    if (native_bundle->command)
+    {
+        printf("  - handle_command: (PASS)\n");
+    }
 
     return 0;
 }
 
-// Python plugin cycle function
-void python_plugin_cycle(plugin_instance_t *plugin)
+// Run one cycle hook of a native plugin and account for its time. Called by the thread
+// that owns the plugin's hooks: the scan thread, or its hook thread for deferred hooks.
+static void plugin_run_hook(plugin_instance_t *plugin, int index, scan_hook_t hook,
+                            void (*func)(void), int on_scan_thread)
 {
-    (void)plugin; // Suppress unused parameter warning
-    // In a real implementation, you'd retrieve the python_plugin_t structure
-    // and call the cycle function
+    uint64_t start = scan_profiler_now_ns();
+    func();
+    uint64_t elapsed = scan_profiler_now_ns() - start;
+
+    if (on_scan_thread && scan_profiler_cycle_active)
+    {
+        scan_profiler_record_hook(index, plugin->config.name, hook, elapsed);
+    }
+
+    uint64_t budget_ns = (uint64_t)plugin->config.hook_budget_us * 1000;
+    int overrun        = budget_ns > 0 && elapsed > budget_ns;
+    plugin_hook_stats_t *stats = &plugin->hook_stats[hook];
+
+    seq_write_begin(&plugin->hook_stats_seq);
+    stats->calls++;
+    stats->total_ns += elapsed;
+    if (elapsed > stats->max_ns)
+    {
+        stats->max_ns = elapsed;
+    }
+    stats->overruns += overrun ? 1 : 0;
+    seq_write_end(&plugin->hook_stats_seq);
+
+    if (overrun)
+    {
+        char message[160];
+        snprintf(message, sizeof(message), "Plugin %s %s took %" PRIu64 " us, budget %d us",
+                 plugin->config.name, hook == SCAN_HOOK_CYCLE_START ? "cycle_start" : "cycle_end",
+                 elapsed / 1000, plugin->config.hook_budget_us);
+        log_message_limited(LOG_SOURCE_RUNTIME, LOG_LEVEL_WARN,
+                            0x484f4f00u | (unsigned int)(index * SCAN_HOOK_COUNT + hook), message);
+    }
+}
+
+// Deferred hooks: cycle_start and cycle_end once per scan, after it, against the image
+// snapshot the scan published. Scans that end while the hooks still run are skipped.
+static void *plugin_hook_thread(void *arg)
+{
+    plugin_hook_job_t *job    = (plugin_hook_job_t *)arg;
+    plugin_instance_t *plugin = &job->driver->plugins[job->index];
+    plugin_cycle_token_t token;
+
+    while (!atomic_load(&plugin->hook_thread_stop))
+    {
+        if (plugin_cycle_signal_wait(plugin->cycle_signal, -1, &token) != 1)
+        {
+            continue;
+        }
+        if (plugin->native_plugin->cycle_start)
+        {
+            plugin_run_hook(plugin, job->index, SCAN_HOOK_CYCLE_START,
+                            plugin->native_plugin->cycle_start, 0);
+        }
+        if (plugin->native_plugin->cycle_end)
+        {
+            plugin_run_hook(plugin, job->index, SCAN_HOOK_CYCLE_END,
+                            plugin->native_plugin->cycle_end, 0);
+        }
+    }
+    return NULL;
 }
 
 // Call cycle_start for all active native plugins that have registered the hook
 // This should be called at the beginning of each PLC scan cycle, before PLC logic execution
 // Plugins opt-in by implementing cycle_start(); opt-out by not implementing it (NULL pointer)
+// Called with buffer_mutex held, which keeps the slot list stable
 void plugin_driver_cycle_start(plugin_driver_t *driver)
 {
-    if (!driver || driver->plugin_count == 0)
+    if (!driver)
     {
         return;
     }
 
-    for (int i = 0; i < driver->plugin_count; i++)
+    // Only running native plugins with an inline cycle_start are listed; deferred hooks
+    // run on the plugin's hook thread after cycle_end
+    for (int k = 0; k < driver->cycle_start_count; k++)
     {
+        int i                     = driver->cycle_start_slots[k];
         plugin_instance_t *plugin = &driver->plugins[i];
-
-        // Skip disabled or non-running plugins
-        if (!plugin->config.enabled || !plugin->running)
-        {
-            continue;
-        }
-
-        // Only native plugins support cycle hooks (they can run in real-time)
-        if (plugin->config.type == PLUGIN_TYPE_NATIVE && plugin->native_plugin &&
-            plugin->native_plugin->cycle_start)
-        {
-            plugin->native_plugin->cycle_start();
-        }
+        atomic_store_explicit(&driver->scan_hook_slot, i + 1, memory_order_relaxed);
+        plugin_run_hook(plugin, i, SCAN_HOOK_CYCLE_START, plugin->native_plugin->cycle_start, 1);
     }
+    atomic_store_explicit(&driver->scan_hook_slot, 0, memory_order_relaxed);
 }
 
 // Call cycle_end for all active native plugins that have registered the hook
 // This should be called at the end of each PLC scan cycle, after PLC logic execution
 // Plugins opt-in by implementing cycle_end(); opt-out by not implementing it (NULL pointer)
+// Called with buffer_mutex held, which keeps the slot list stable
 void plugin_driver_cycle_end(plugin_driver_t *driver)
 {
-    if (!driver || driver->plugin_count == 0)
+    if (!driver)
     {
         return;
     }
 
-    for (int i = 0; i < driver->plugin_count; i++)
+    unsigned long long cycle = ++driver->cycle_count;
+    if (driver->cycle_end_count == 0)
+    {
+        return;
+    }
+    unsigned int generation = image_shadow_generation();
+
+    for (int k = 0; k < driver->cycle_end_count; k++)
     {
+        int i                     = driver->cycle_end_slots[k];
         plugin_instance_t *plugin = &driver->plugins[i];
 
-        // Skip disabled or non-running plugins
-        if (!plugin->config.enabled || !plugin->running)
+        // Python plugin threads, deferred hook threads and process bridges are woken
+        // instead of called on the scan thread
+        if (plugin->config.type != PLUGIN_TYPE_NATIVE || plugin->has_hook_thread)
+        {
+            plugin_cycle_signal_post(plugin->cycle_signal, cycle, generation);
+        }
+        else
+        {
+            atomic_store_explicit(&driver->scan_hook_slot, i + 1, memory_order_relaxed);
+            plugin_run_hook(plugin, i, SCAN_HOOK_CYCLE_END, plugin->native_plugin->cycle_end, 1);
+        }
+    }
+    atomic_store_explicit(&driver->scan_hook_slot, 0, memory_order_relaxed);
+}
+
+int plugin_driver_push_outputs(plugin_driver_t *driver)
+{
+    if (!driver)
+    {
+        return 0;
+    }
+
+    // Called directly, the hook stats have the scan thread as their only writer
+    int stuck  = atomic_load_explicit(&driver->scan_hook_slot, memory_order_relaxed) - 1;
+    int called = 0;
+    for (int k = 0; k < driver->cycle_end_count; k++)
+    {
+        int i                     = driver->cycle_end_slots[k];
+        plugin_instance_t *plugin = &driver->plugins[i];
+        if (i == stuck || plugin->config.type != PLUGIN_TYPE_NATIVE || plugin->has_hook_thread)
         {
             continue;
         }
+        plugin->native_plugin->cycle_end();
+        called++;
+    }
+    return called;
+}
+
+static bool format_hook_stats(char *buffer, size_t buffer_size, size_t *written,
+                              const char *hook, const plugin_hook_stats_t *stats)
+{
+    return timing_format_append(buffer, buffer_size, written,
+                                ",\"%s_calls\":%llu,\"%s_overruns\":%llu,\"%s_max\":%llu,"
+                                "\"%s_avg\":%llu",
+                                hook, stats->calls, hook, stats->overruns, hook,
+                                stats->max_ns / 1000, hook,
+                                stats->calls > 0 ? stats->total_ns / stats->calls / 1000 : 0);
+}
+
+bool plugin_driver_get_hook_stats(plugin_driver_t *driver, int index,
+                                  plugin_hook_stats_t stats[2])
+{
+    if (!driver || index < 0 || index >= driver->plugin_count)
+    {
+        return false;
+    }
+    plugin_instance_t *plugin = &driver->plugins[index];
+    if (plugin->config.type != PLUGIN_TYPE_NATIVE || !plugin->native_plugin ||
+        (!plugin->native_plugin->cycle_start && !plugin->native_plugin->cycle_end))
+    {
+        return false;
+    }
+
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&plugin->hook_stats_seq);
+        memcpy(stats, plugin->hook_stats, sizeof(plugin->hook_stats));
+    } while (seq_read_retry(&plugin->hook_stats_seq, seq));
+    return true;
+}
 
-        // Only native plugins support cycle hooks (they can run in real-time)
+int plugin_driver_command(plugin_driver_t *driver, const char *name, const char *command,
+                          char *response, size_t response_size)
+{
+    // Native libraries stay loaded until the driver is destroyed, the plugin itself
+    // answers while it is stopped
+    for (int i = 0; driver && i < driver->plugin_count; i++)
+    {
+        plugin_instance_t *plugin = &driver->plugins[i];
         if (plugin->config.type == PLUGIN_TYPE_NATIVE && plugin->native_plugin &&
-            plugin->native_plugin->cycle_end)
+            plugin->native_plugin->command && strcmp(plugin->config.name, name) == 0)
         {
-            plugin->native_plugin->cycle_end();
+            plugin->native_plugin->command(command, response, response_size);
+            return 0;
         }
     }
+    return -1;
+}
+
+bool plugin_driver_format_journal_rejects(plugin_driver_t *driver, char *buffer,
+                                          size_t buffer_size, size_t *written)
+{
+    bool ok = timing_format_append(buffer, buffer_size, written, "\"plugins\":[");
+    for (int i = 0; ok && driver && i < driver->plugin_count; i++)
+    {
+        ok = timing_format_append(
+            buffer, buffer_size, written, "%s{\"name\":\"%s\",\"rejected\":%llu}",
+            i == 0 ? "" : ",", driver->plugins[i].config.name,
+            (unsigned long long)atomic_load_explicit(&journal_rejected[i], memory_order_relaxed));
+    }
+    return ok && timing_format_append(buffer, buffer_size, written, "]");
+}
+
+bool plugin_driver_format_hook_stats(plugin_driver_t *driver, char *buffer, size_t buffer_size,
+                                     size_t *written)
+{
+    bool ok    = timing_format_append(buffer, buffer_size, written, "\"plugin_hooks\":[");
+    bool first = true;
+    for (int i = 0; ok && driver && i < driver->plugin_count; i++)
+    {
+        plugin_hook_stats_t stats[SCAN_HOOK_COUNT];
+        if (!plugin_driver_get_hook_stats(driver, i, stats))
+        {
+            continue;
+        }
+
+        plugin_instance_t *plugin = &driver->plugins[i];
+        ok = timing_format_append(buffer, buffer_size, written,
+                                  "%s{\"plugin\":\"%s\",\"deferred\":%s,\"budget_us\":%d",
+                                  first ? "" : ",", plugin->config.name,
+                                  plugin->has_hook_thread ? "true" : "false",
+                                  plugin->config.hook_budget_us) &&
+             format_hook_stats(buffer, buffer_size, written, "cycle_start",
+                               &stats[SCAN_HOOK_CYCLE_START]) &&
+             format_hook_stats(buffer, buffer_size, written, "cycle_end",
+                               &stats[SCAN_HOOK_CYCLE_END]) &&
+             timing_format_append(buffer, buffer_size, written, "}");
+        first = false;
+    }
+    return ok && timing_format_append(buffer, buffer_size, written, "]");
 }
 
 // Cleanup Python plugin
@@ -1147,6 +2508,9 @@ static void python_plugin_cleanup(plugin_instance_t *plugin)
     // Cleanup Python resources
     if (plugin && plugin->python_plugin)
     {
+        python_call_t call;
+        python_call_enter(plugin->python_plugin, &call);
+
         // Call cleanup function if available
         if (plugin->python_plugin->pFuncCleanup)
         {
@@ -1170,7 +2534,9 @@ static void python_plugin_cleanup(plugin_instance_t *plugin)
         Py_XDECREF(plugin->python_plugin->pFuncCleanup);
         Py_XDECREF(plugin->python_plugin->pModule);
         Py_XDECREF(plugin->python_plugin->args_capsule);
+        python_call_leave(&call);
 
+        python_end_interpreter(plugin->python_plugin);
         free(plugin->python_plugin);
         plugin->python_plugin = NULL;
     }
@@ -1,8 +1,14 @@
 #ifndef PLUGIN_DRIVER_H
 #define PLUGIN_DRIVER_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "../plc_app/plcapp_manager.h"
 #include "plugin_config.h"
+#include "plugin_cycle_signal.h"
+#include "plugin_process.h"
 #include "plugin_types.h"
 #include "python_plugin_bridge.h"
 
@@ -12,36 +18,60 @@
 typedef enum
 {
     PLUGIN_TYPE_PYTHON,
-    PLUGIN_TYPE_NATIVE
+    PLUGIN_TYPE_NATIVE,
+    PLUGIN_TYPE_PROCESS // Executable in a process of its own, see plugin_process.h
 } plugin_type_t;
 
 typedef int (*plugin_init_func_t)(void *);
+typedef int (*plugin_init_abi_func_t)(const plugin_abi_t *); // plugin_init, ABI version 2
 typedef void (*plugin_start_loop_func_t)(void);
 typedef void (*plugin_stop_loop_func_t)(void);
 typedef void (*plugin_cycle_start_func_t)(void);
 typedef void (*plugin_cycle_end_func_t)(void);
 typedef void (*plugin_cleanup_func_t)(void);
+// Handle a PLUGIN:<name>:<command> socket command, writing at most response_size bytes
+typedef void (*plugin_command_func_t)(const char *command, char *response, size_t response_size);
 
 typedef struct
 {
     void *handle; // Handle to the loaded shared library
+    unsigned int abi_version; // Declared by the plugin, 1 without a plugin_declaration
     plugin_init_func_t init;
+    plugin_init_abi_func_t init_abi; // Called instead of init when set
     plugin_start_loop_func_t start;
     plugin_stop_loop_func_t stop;
     plugin_cycle_start_func_t cycle_start;
     plugin_cycle_end_func_t cycle_end;
     plugin_cleanup_func_t cleanup;
+    plugin_command_func_t command;
 } plugin_funct_bundle_t;
 
+// Cycle hook timing of one plugin, written by the thread that runs its hooks
+typedef struct
+{
+    unsigned long long calls;
+    unsigned long long overruns; // Calls that took longer than hook_budget_us
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+} plugin_hook_stats_t;
+
 // Plugin instance structure
 typedef struct plugin_instance_s
 {
     PluginManager *manager;
     python_binds_t *python_plugin;
     plugin_funct_bundle_t *native_plugin;
+    plugin_process_t *process_plugin;
+    plugin_cycle_signal_t *cycle_signal; // Scan notifications for Python plugin threads,
+                                         // deferred native hooks and process bridges
     // pthread_t thread;
     int running;
     plugin_config_t config;
+    pthread_t hook_thread; // Runs deferred cycle hooks
+    int has_hook_thread;
+    atomic_bool hook_thread_stop;
+    atomic_uint hook_stats_seq;
+    plugin_hook_stats_t hook_stats[2]; // cycle_start, cycle_end
 } plugin_instance_t;
 
 // Driver structure
@@ -50,6 +80,13 @@ typedef struct
     plugin_instance_t plugins[MAX_PLUGINS];
     int plugin_count;
     pthread_mutex_t buffer_mutex;
+    unsigned long long cycle_count; // Scans completed, counted by plugin_driver_cycle_end
+    // Slots the scan hooks visit, rebuilt under buffer_mutex when plugins start or stop
+    unsigned char cycle_start_slots[MAX_PLUGINS];
+    int cycle_start_count;
+    unsigned char cycle_end_slots[MAX_PLUGINS];
+    int cycle_end_count;
+    atomic_int scan_hook_slot; // Slot + 1 of the hook running on the scan thread, 0 = none
 } plugin_driver_t;
 
 // Driver management functions
@@ -60,16 +97,61 @@ int plugin_driver_init(plugin_driver_t *driver);
 int plugin_driver_start(plugin_driver_t *driver);
 int plugin_driver_stop(plugin_driver_t *driver);
 int plugin_driver_restart(plugin_driver_t *driver);
+// Re-read config_file for a new PLC program, keeping plugins whose config line did not
+// change running and restarting the others. Plugins not running are started.
+int plugin_driver_reload(plugin_driver_t *driver, const char *config_file);
+// Init and start only the enabled native and process plugins, for the program start before
+// the scan thread exists
+int plugin_driver_start_native(plugin_driver_t *driver);
+// Start the enabled Python plugins once the scan runs: the interpreter is started on the
+// calling thread if needed (never when no Python plugin is enabled), then a background
+// thread imports, inits and starts the plugins and attaches them to the scan. Returns 1
+// if the background thread runs, 0 if there was nothing to do or it ran inline, -1 on
+// error. The other driver functions wait for it first.
+int plugin_driver_start_python(plugin_driver_t *driver);
+// Whether any plugin is running or the Python plugins are being started
+bool plugin_driver_is_started(plugin_driver_t *driver);
 void plugin_driver_destroy(plugin_driver_t *driver);
 int plugin_mutex_take(pthread_mutex_t *mutex);
 int plugin_mutex_give(pthread_mutex_t *mutex);
 
 // Cycle hook functions for native plugins (called during PLC scan cycle)
-// These iterate through all active native plugins and call their cycle hooks
+// These call the cycle hooks of the running native plugins that have them, from a list
+// rebuilt when plugins start or stop
 // Plugins opt-in by implementing cycle_start/cycle_end; opt-out by not implementing them
+// cycle_end also posts the scan to the cycle signal of every running Python plugin
 void plugin_driver_cycle_start(plugin_driver_t *driver);
 void plugin_driver_cycle_end(plugin_driver_t *driver);
 
+// Call the inline cycle_end hooks outside a scan, so native plugins write the current
+// output image to their devices now (the safe state). Meant for a scan thread that may be
+// stuck: the plugin whose hook it is in is skipped, and deferred hooks and Python plugins
+// are not called, their threads read the image on their own. The caller holds
+// buffer_mutex, or could not get it within a bounded wait. Returns the hooks called.
+int plugin_driver_push_outputs(plugin_driver_t *driver);
+
+// Append "plugin_hooks":[...] with the hook timing of every native plugin that has
+// cycle hooks, for the STATS command. Returns false if the buffer is too small.
+bool plugin_driver_format_hook_stats(plugin_driver_t *driver, char *buffer, size_t buffer_size,
+                                     size_t *written);
+
+// Append "plugins":[{"name":..,"rejected":N},...] with the journal writes rejected for
+// every plugin since it was initialized, for the JOURNAL_STATS command. Returns false if
+// the buffer is too small.
+bool plugin_driver_format_journal_rejects(plugin_driver_t *driver, char *buffer,
+                                          size_t buffer_size, size_t *written);
+
+// Pass a PLUGIN:<name>:<command> socket command to handle_command() of the native plugin
+// `name`, on the calling thread. Returns 0 if it was handled, -1 if no loaded native plugin
+// of that name has handle_command().
+int plugin_driver_command(plugin_driver_t *driver, const char *name, const char *command,
+                          char *response, size_t response_size);
+
+// Copy the cycle_start and cycle_end timing of plugin `index`, without blocking the
+// thread that runs its hooks. Returns false if it is not a native plugin with hooks.
+bool plugin_driver_get_hook_stats(plugin_driver_t *driver, int index,
+                                  plugin_hook_stats_t stats[2]);
+
 // Python plugin functions
 int python_plugin_get_symbols(plugin_instance_t *plugin);
 
@@ -0,0 +1,672 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../plc_app/image_shadow.h"
+#include "../plc_app/journal_buffer.h"
+#include "../plc_app/utils/log.h"
+#include "plugin_config.h"
+#include "plugin_cycle_signal.h"
+#include "plugin_process.h"
+#include "plugin_process_shm.h"
+
+extern char **environ;
+
+// Longest the bridge waits for a scan, and so how often it checks on the process
+#define PROCESS_POLL_MS 100
+// Time a process gets to exit after the stop state is set, then after SIGTERM
+#define PROCESS_STOP_GRACE_MS 2000
+#define PROCESS_TERM_GRACE_MS 1000
+// Delay before starting a process that exited again, doubling while it keeps failing
+#define PROCESS_BACKOFF_MIN_MS 1000
+#define PROCESS_BACKOFF_MAX_MS 30000
+// A process that ran this long before exiting is started again after the minimum delay
+#define PROCESS_STABLE_MS 10000
+
+struct plugin_process_s
+{
+    char name[MAX_PLUGIN_NAME_LEN];
+    char path[MAX_PLUGIN_PATH_LEN];
+    char shm_name[64];
+    plugin_runtime_args_t args;
+
+    plugin_shm_header_t *header;
+    size_t region_size;
+    uint64_t ring_tail;
+
+    pthread_t bridge;
+    int has_bridge;
+    atomic_bool stopping;
+
+    // The running process, pid 0 while there is none
+    pid_t pid;
+    struct timespec started;
+    struct timespec checked;
+    struct timespec respawn_at;
+    int backoff_ms;
+
+    // stdout and stderr of the process, logged by the output thread
+    int output;
+    pthread_t output_thread;
+    int has_output_thread;
+    atomic_bool output_stop;
+
+    atomic_ullong restarts;
+    atomic_ullong rejected;
+};
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static long long elapsed_ms(const struct timespec *since, const struct timespec *now)
+{
+    return (long long)(now->tv_sec - since->tv_sec) * 1000 +
+           (now->tv_nsec - since->tv_nsec) / 1000000;
+}
+
+static void add_ms(struct timespec *ts, int ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+plugin_process_t *plugin_process_create(const char *name, const char *path,
+                                        const plugin_runtime_args_t *args)
+{
+    if (!name || !path || !args || args->buffer_size <= 0)
+    {
+        return NULL;
+    }
+
+    // Header, the two snapshot sets, then the journal ring, each area on its own cache lines
+    plugin_shm_area_t areas[PLUGIN_SHM_AREAS];
+    size_t offset = sizeof(plugin_shm_header_t);
+    for (int set = 0; set < 2; set++)
+    {
+        for (int type = 0; type < PLUGIN_SHM_AREAS; type++)
+        {
+            areas[type].count       = (uint32_t)args->buffer_size;
+            areas[type].width       = (uint32_t)journal_type_width((journal_buffer_type_t)type);
+            areas[type].offset[set] = (uint32_t)offset;
+            offset = align_up(offset + (size_t)args->buffer_size * areas[type].width, 64);
+        }
+    }
+    size_t ring_offset = offset;
+    size_t size        = ring_offset + PLUGIN_SHM_RING_BYTES;
+    if (size > UINT32_MAX)
+    {
+        return NULL;
+    }
+
+    plugin_process_t *process = calloc(1, sizeof(*process));
+    if (!process)
+    {
+        return NULL;
+    }
+    snprintf(process->name, sizeof(process->name), "%s", name);
+    snprintf(process->path, sizeof(process->path), "%s", path);
+    snprintf(process->shm_name, sizeof(process->shm_name), "/openplc-%d-plugin-%d", (int)getpid(),
+             args->plugin_id);
+    process->args   = *args;
+    process->output = -1;
+
+    // A region left by an earlier runtime with the same pid is stale
+    int fd = shm_open(process->shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST)
+    {
+        shm_unlink(process->shm_name);
+        fd = shm_open(process->shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0)
+    {
+        log_error("[PLUGIN]: Process plugin %s: shm_open(%s) failed: %s", name, process->shm_name,
+                  strerror(errno));
+        free(process);
+        return NULL;
+    }
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0)
+    {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int saved_errno = errno;
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        log_error("[PLUGIN]: Process plugin %s: cannot map %zu bytes of shared memory: %s", name,
+                  size, strerror(saved_errno));
+        shm_unlink(process->shm_name);
+        free(process);
+        return NULL;
+    }
+
+    // A new region is zero-filled, so only the layout needs writing
+    plugin_shm_header_t *header = (plugin_shm_header_t *)base;
+    header->magic               = PLUGIN_SHM_MAGIC;
+    header->version             = PLUGIN_SHM_VERSION;
+    header->header_size         = sizeof(plugin_shm_header_t);
+    header->region_size         = (uint32_t)size;
+    header->buffer_size         = (uint32_t)args->buffer_size;
+    header->ring_offset         = (uint32_t)ring_offset;
+    header->ring_size           = PLUGIN_SHM_RING_BYTES;
+    header->runtime_pid         = (uint32_t)getpid();
+    memcpy(header->areas, areas, sizeof(areas));
+
+    process->header      = header;
+    process->region_size = size;
+    return process;
+}
+
+// Log the output of the process line by line with the plugin as the source. Polls so the
+// thread can be stopped even if a child of the process still holds the pipe open.
+static void *process_output_thread(void *arg)
+{
+    plugin_process_t *process = (plugin_process_t *)arg;
+    char buffer[512];
+    size_t used = 0;
+
+    while (!atomic_load(&process->output_stop))
+    {
+        struct pollfd pfd = {.fd = process->output, .events = POLLIN};
+        if (poll(&pfd, 1, 200) <= 0)
+        {
+            continue;
+        }
+        ssize_t n = read(process->output, buffer + used, sizeof(buffer) - 1 - used);
+        if (n <= 0)
+        {
+            break;
+        }
+        used += (size_t)n;
+
+        // A line longer than the buffer is logged in pieces
+        char *line = buffer;
+        char *nl;
+        while ((nl = memchr(line, '\n', used - (size_t)(line - buffer))) != NULL)
+        {
+            *nl = '\0';
+            process->args.log_message(process->args.plugin_id, PLUGIN_LOG_LEVEL_INFO, line);
+            line = nl + 1;
+        }
+        used -= (size_t)(line - buffer);
+        memmove(buffer, line, used);
+        if (used == sizeof(buffer) - 1)
+        {
+            buffer[used] = '\0';
+            process->args.log_message(process->args.plugin_id, PLUGIN_LOG_LEVEL_INFO, buffer);
+            used = 0;
+        }
+    }
+    if (used > 0)
+    {
+        buffer[used] = '\0';
+        process->args.log_message(process->args.plugin_id, PLUGIN_LOG_LEVEL_INFO, buffer);
+    }
+    return NULL;
+}
+
+static void process_schedule_respawn(plugin_process_t *process, const struct timespec *now)
+{
+    process->respawn_at = *now;
+    add_ms(&process->respawn_at, process->backoff_ms);
+    log_warn("[PLUGIN]: Process plugin %s is started again in %d ms", process->name,
+             process->backoff_ms);
+    process->backoff_ms = process->backoff_ms * 2 < PROCESS_BACKOFF_MAX_MS
+                              ? process->backoff_ms * 2
+                              : PROCESS_BACKOFF_MAX_MS;
+}
+
+// Start the process on a region reset for it. Called by the bridge while no process runs.
+static void process_spawn(plugin_process_t *process)
+{
+    plugin_shm_header_t *header = process->header;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // Nothing maps the ring now, so both ends start over
+    PLUGIN_SHM_STORE(&header->state, (uint32_t)PLUGIN_SHM_STATE_RUN);
+    PLUGIN_SHM_STORE(&header->subscribed, 0u);
+    PLUGIN_SHM_STORE(&header->waiting, 0u);
+    PLUGIN_SHM_STORE(&header->process_pid, 0u);
+    PLUGIN_SHM_STORE(&header->ring_head, (uint64_t)0);
+    PLUGIN_SHM_STORE(&header->ring_tail, (uint64_t)0);
+    process->ring_tail = 0;
+
+    int output[2];
+    if (pipe(output) != 0)
+    {
+        log_error("[PLUGIN]: Process plugin %s: pipe failed: %s", process->name, strerror(errno));
+        process_schedule_respawn(process, &now);
+        return;
+    }
+    // The runtime's end must not leak into the process (or any other child)
+    fcntl(output[0], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose(&actions, output[1]);
+
+    // Default signal handling and its own process group, so signals meant for the
+    // runtime do not reach the process, whose stop the runtime handles itself
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGHUP);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF |
+                                        POSIX_SPAWN_SETPGROUP);
+
+    // The runtime's environment with the region and the plugin's identity
+    char env_shm[128], env_name[128], env_config[MAX_PLUGIN_PATH_LEN + 32];
+    snprintf(env_shm, sizeof(env_shm), "%s=%s", PLUGIN_SHM_ENV, process->shm_name);
+    snprintf(env_name, sizeof(env_name), "%s=%s", PLUGIN_SHM_ENV_NAME, process->name);
+    snprintf(env_config, sizeof(env_config), "%s=%s", PLUGIN_SHM_ENV_CONFIG,
+             process->args.plugin_specific_config_file_path);
+    size_t env_count = 0;
+    while (environ[env_count])
+    {
+        env_count++;
+    }
+    char **envp = calloc(env_count + 4, sizeof(char *));
+    int ret     = ENOMEM;
+    if (envp)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < env_count; i++)
+        {
+            if (strncmp(environ[i], "OPENPLC_PLUGIN_", 15) != 0)
+            {
+                envp[n++] = environ[i];
+            }
+        }
+        envp[n++] = env_shm;
+        envp[n++] = env_name;
+        envp[n++] = env_config;
+
+        const char *config = process->args.plugin_specific_config_file_path;
+        char *argv[]       = {process->path, config[0] ? (char *)config : NULL, NULL};
+        ret                = posix_spawn(&process->pid, process->path, &actions, &attr, argv, envp);
+        free(envp);
+    }
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    close(output[1]);
+
+    if (ret != 0)
+    {
+        log_error("[PLUGIN]: Process plugin %s: cannot start %s: %s", process->name,
+                  process->path, strerror(ret));
+        close(output[0]);
+        process->pid = 0;
+        process_schedule_respawn(process, &now);
+        return;
+    }
+
+    process->output = output[0];
+    atomic_store(&process->output_stop, false);
+    process->has_output_thread =
+        pthread_create(&process->output_thread, NULL, process_output_thread, process) == 0;
+    if (!process->has_output_thread)
+    {
+        log_warn("[PLUGIN]: Process plugin %s: no thread for its output", process->name);
+    }
+    process->started = now;
+    process->checked = now;
+    log_info("[PLUGIN]: Process plugin %s started (pid %d, shared memory %s, %zu bytes)",
+             process->name, (int)process->pid, process->shm_name, process->region_size);
+}
+
+// Forget a process that has been waited for
+static void process_reap(plugin_process_t *process)
+{
+    if (process->has_output_thread)
+    {
+        atomic_store(&process->output_stop, true);
+        pthread_join(process->output_thread, NULL);
+        process->has_output_thread = 0;
+    }
+    if (process->output >= 0)
+    {
+        close(process->output);
+        process->output = -1;
+    }
+    process->pid = 0;
+}
+
+// Wait up to timeout_ms for the process to exit. Returns true once it has been waited for.
+static bool process_wait_exit(plugin_process_t *process, int timeout_ms)
+{
+    for (int waited = 0;; waited += 20)
+    {
+        pid_t ret = waitpid(process->pid, NULL, WNOHANG);
+        if (ret == process->pid || (ret < 0 && errno == ECHILD))
+        {
+            return true;
+        }
+        if (waited >= timeout_ms)
+        {
+            return false;
+        }
+        usleep(20000);
+    }
+}
+
+// Notice a process that exited and start it again once its backoff has passed
+static void process_supervise(plugin_process_t *process)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (process->pid == 0)
+    {
+        if (elapsed_ms(&process->respawn_at, &now) >= 0)
+        {
+            atomic_fetch_add(&process->restarts, 1);
+            process_spawn(process);
+        }
+        return;
+    }
+
+    // waitpid() once per poll period, not once per scan
+    if (elapsed_ms(&process->checked, &now) < PROCESS_POLL_MS)
+    {
+        return;
+    }
+    process->checked = now;
+
+    int status = 0;
+    pid_t ret  = waitpid(process->pid, &status, WNOHANG);
+    if (ret == 0 || (ret < 0 && errno != ECHILD))
+    {
+        return;
+    }
+
+    int pid = (int)process->pid;
+    process_reap(process);
+    if (ret > 0 && WIFSIGNALED(status))
+    {
+        log_error("[PLUGIN]: Process plugin %s (pid %d) was killed by signal %d", process->name,
+                  pid, WTERMSIG(status));
+    }
+    else
+    {
+        log_error("[PLUGIN]: Process plugin %s (pid %d) exited with status %d", process->name,
+                  pid, ret > 0 ? WEXITSTATUS(status) : -1);
+    }
+    if (elapsed_ms(&process->started, &now) >= PROCESS_STABLE_MS)
+    {
+        process->backoff_ms = PROCESS_BACKOFF_MIN_MS;
+    }
+    process_schedule_respawn(process, &now);
+}
+
+// Journal the entries the process appended since the last drain
+static void process_drain(plugin_process_t *process)
+{
+    plugin_shm_header_t *header = process->header;
+    const uint8_t *ring         = (const uint8_t *)header + header->ring_offset;
+    uint32_t ring_size          = header->ring_size;
+    uint64_t head               = PLUGIN_SHM_LOAD(&header->ring_head);
+    uint64_t tail               = process->ring_tail;
+    unsigned long long rejected = 0;
+
+    if (head - tail > ring_size)
+    {
+        log_message_limited(process->args.plugin_id, LOG_LEVEL_ERROR, 0x50524e47u,
+                            "Process plugin ring head is out of range, entries dropped");
+        tail = head;
+    }
+
+    while (tail != head)
+    {
+        uint32_t pos = (uint32_t)(tail % ring_size);
+        plugin_shm_entry_t entry;
+        memcpy(&entry, ring + pos, sizeof(entry));
+        if (entry.size < sizeof(entry) || entry.size % 16 != 0 || entry.size > ring_size - pos ||
+            entry.size > head - tail)
+        {
+            log_message_limited(process->args.plugin_id, LOG_LEVEL_ERROR, 0x50524e47u,
+                                "Process plugin ring entry is malformed, entries dropped");
+            tail = head;
+            break;
+        }
+
+        if (entry.kind == PLUGIN_SHM_ENTRY_RANGE)
+        {
+            size_t width = journal_type_width((journal_buffer_type_t)entry.type);
+            if (width == 0 || entry.count == 0 || entry.count > header->buffer_size ||
+                sizeof(entry) + entry.count * width > entry.size ||
+                process->args.journal_write_range(entry.type, (int)entry.start, (int)entry.count,
+                                                  ring + pos + sizeof(entry)) != 0)
+            {
+                rejected++;
+            }
+        }
+        else if (entry.kind == PLUGIN_SHM_ENTRY_BOOL)
+        {
+            if (process->args.journal_write_bool(entry.type, (int)entry.start, entry.bit,
+                                                 entry.value) != 0)
+            {
+                rejected++;
+            }
+        }
+        else if (entry.kind != PLUGIN_SHM_ENTRY_PAD)
+        {
+            rejected++;
+        }
+        tail += entry.size;
+    }
+
+    process->ring_tail = tail;
+    PLUGIN_SHM_STORE(&header->ring_tail, tail);
+    if (rejected > 0)
+    {
+        atomic_fetch_add(&process->rejected, rejected);
+        PLUGIN_SHM_STORE(&header->rejected, header->rejected + rejected);
+    }
+}
+
+// Copy the subscribed areas of the latest image snapshot into the set the process is not
+// pointed at, publish it and wake the process
+static void process_publish(plugin_process_t *process, unsigned long long cycle)
+{
+    plugin_shm_header_t *header = process->header;
+    uint8_t *base               = (uint8_t *)header;
+    uint32_t subscribed         = PLUGIN_SHM_LOAD(&header->subscribed);
+    uint32_t set                = 1u - (header->published & 1u);
+
+    __atomic_store_n(&header->set_seq[set], header->set_seq[set] + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // Each area is read on its own; retry while a scan ends in between, so all areas of
+    // the set come from the same scan as long as the scan does not outpace the copy
+    uint32_t valid = 0;
+    for (int attempt = 0; attempt < 3; attempt++)
+    {
+        uint32_t first = 0;
+        int mixed      = 0;
+        valid          = 0;
+        for (int type = 0; type < PLUGIN_SHM_AREAS; type++)
+        {
+            if (!(subscribed & (1u << type)))
+            {
+                continue;
+            }
+            uint32_t generation = 0;
+            if (image_shadow_read((journal_buffer_type_t)type, 0, header->areas[type].count,
+                                  base + header->areas[type].offset[set], &generation) < 0)
+            {
+                continue;
+            }
+            if (valid != 0 && generation != first)
+            {
+                mixed = 1;
+            }
+            first = generation;
+            valid |= 1u << type;
+        }
+        if (!mixed)
+        {
+            break;
+        }
+    }
+
+    __atomic_store_n(&header->set_cycle[set], (uint64_t)cycle, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->set_valid[set], valid, __ATOMIC_RELAXED);
+    PLUGIN_SHM_STORE(&header->set_seq[set], header->set_seq[set] + 1);
+    PLUGIN_SHM_STORE(&header->published, set);
+
+    // Pairs with the waiting flag the process sets before its last check
+    __atomic_fetch_add(&header->cycle_futex, 1u, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->waiting, __ATOMIC_SEQ_CST))
+    {
+        plugin_shm_futex_wake(&header->cycle_futex);
+    }
+}
+
+// Set the stop state, then escalate to SIGTERM and SIGKILL
+static void process_terminate(plugin_process_t *process)
+{
+    if (process->pid == 0)
+    {
+        return;
+    }
+    plugin_shm_header_t *header = process->header;
+    PLUGIN_SHM_STORE(&header->state, (uint32_t)PLUGIN_SHM_STATE_STOP);
+    __atomic_fetch_add(&header->cycle_futex, 1u, __ATOMIC_SEQ_CST);
+    plugin_shm_futex_wake(&header->cycle_futex);
+
+    int pid = (int)process->pid;
+    if (!process_wait_exit(process, PROCESS_STOP_GRACE_MS))
+    {
+        log_warn("[PLUGIN]: Process plugin %s (pid %d) did not exit, sending SIGTERM",
+                 process->name, pid);
+        kill(process->pid, SIGTERM);
+        if (!process_wait_exit(process, PROCESS_TERM_GRACE_MS))
+        {
+            log_warn("[PLUGIN]: Process plugin %s (pid %d) did not exit, sending SIGKILL",
+                     process->name, pid);
+            kill(process->pid, SIGKILL);
+            waitpid(process->pid, NULL, 0);
+        }
+    }
+    process_reap(process);
+    log_info("[PLUGIN]: Process plugin %s (pid %d) stopped", process->name, pid);
+}
+
+// Runs while the plugin is started: one drain and one publication per scan, and the
+// supervision of the process in between
+static void *process_bridge_thread(void *arg)
+{
+    plugin_process_t *process = (plugin_process_t *)arg;
+    process_spawn(process);
+
+    while (!atomic_load(&process->stopping))
+    {
+        plugin_cycle_token_t token;
+        int scanned =
+            process->args.wait_cycle(process->args.cycle_signal, PROCESS_POLL_MS, &token);
+        if (scanned < 0)
+        {
+            usleep(PROCESS_POLL_MS * 1000);
+        }
+        if (process->pid > 0)
+        {
+            process_drain(process);
+            if (scanned == 1)
+            {
+                process_publish(process, token.cycle);
+            }
+        }
+        process_supervise(process);
+    }
+
+    process_terminate(process);
+    return NULL;
+}
+
+int plugin_process_start(plugin_process_t *process)
+{
+    if (!process || process->has_bridge)
+    {
+        return -1;
+    }
+    atomic_store(&process->stopping, false);
+    atomic_store(&process->restarts, 0);
+    atomic_store(&process->rejected, 0);
+    process->backoff_ms = PROCESS_BACKOFF_MIN_MS;
+
+    if (pthread_create(&process->bridge, NULL, process_bridge_thread, process) != 0)
+    {
+        log_error("[PLUGIN]: Process plugin %s: cannot create its bridge thread", process->name);
+        return -1;
+    }
+    process->has_bridge = 1;
+    return 0;
+}
+
+void plugin_process_stop(plugin_process_t *process)
+{
+    if (!process || !process->has_bridge)
+    {
+        return;
+    }
+    atomic_store(&process->stopping, true);
+    plugin_cycle_signal_interrupt((plugin_cycle_signal_t *)process->args.cycle_signal);
+    pthread_join(process->bridge, NULL);
+    process->has_bridge = 0;
+}
+
+void plugin_process_destroy(plugin_process_t *process)
+{
+    if (!process)
+    {
+        return;
+    }
+    plugin_process_stop(process);
+    munmap(process->header, process->region_size);
+    shm_unlink(process->shm_name);
+    free(process);
+}
+
+void plugin_process_stats(plugin_process_t *process, unsigned long long *restarts,
+                          unsigned long long *rejected)
+{
+    if (restarts)
+    {
+        *restarts = process ? atomic_load(&process->restarts) : 0;
+    }
+    if (rejected)
+    {
+        *rejected = process ? atomic_load(&process->rejected) : 0;
+    }
+}
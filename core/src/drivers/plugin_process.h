@@ -0,0 +1,68 @@
+#ifndef PLUGIN_PROCESS_H
+#define PLUGIN_PROCESS_H
+
+#include "plugin_types.h"
+
+/**
+ * @file plugin_process.h
+ * @brief Runtime side of out-of-process plugins (PLUGIN_TYPE_PROCESS)
+ *
+ * Each process plugin gets a shared memory region (see plugin_process_shm.h)
+ * and a bridge thread in the runtime. The scan thread only posts the plugin's
+ * cycle signal, like for Python plugins. The bridge thread then drains the
+ * journal ring the process filled into the journal, copies the areas the
+ * process subscribed to from the image shadow into the snapshot set the
+ * process is not reading, publishes it and wakes the process.
+ *
+ * The bridge also supervises the process: one that exits or crashes while
+ * the plugin runs is logged and started again, after 1 s doubling up to 30 s
+ * while it keeps failing. Its stdout and stderr are logged line by line with
+ * the plugin as the source.
+ */
+
+typedef struct plugin_process_s plugin_process_t;
+
+/**
+ * @brief Create the shared memory region of a plugin
+ *
+ * @param name Plugin name, for messages and OPENPLC_PLUGIN_NAME
+ * @param path Executable to start
+ * @param args Runtime args of the plugin's slot (copied): journal entry points,
+ *             log functions, cycle signal, buffer size and config path
+ * @return New plugin process, or NULL if the region cannot be created
+ */
+plugin_process_t *plugin_process_create(const char *name, const char *path,
+                                        const plugin_runtime_args_t *args);
+
+/**
+ * @brief Start the process and its bridge thread
+ *
+ * @return 0 on success, -1 if the bridge thread cannot be created. A process
+ *         that fails to start is retried by the bridge.
+ */
+int plugin_process_start(plugin_process_t *process);
+
+/**
+ * @brief Ask the process to exit and stop the bridge thread
+ *
+ * Sets the stop state in the region, then waits up to 2 s for the process to
+ * exit before sending SIGTERM, and SIGKILL a second later. Interrupts the
+ * plugin's cycle signal, so the bridge does not wait for another scan.
+ */
+void plugin_process_stop(plugin_process_t *process);
+
+/**
+ * @brief Unmap and remove the region. The plugin must be stopped.
+ */
+void plugin_process_destroy(plugin_process_t *process);
+
+/**
+ * @brief Counters since the plugin was started
+ *
+ * @param restarts Receives how often the process was started again (may be NULL)
+ * @param rejected Receives the ring entries the journal refused (may be NULL)
+ */
+void plugin_process_stats(plugin_process_t *process, unsigned long long *restarts,
+                          unsigned long long *rejected);
+
+#endif // PLUGIN_PROCESS_H
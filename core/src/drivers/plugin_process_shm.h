@@ -0,0 +1,523 @@
+#ifndef PLUGIN_PROCESS_SHM_H
+#define PLUGIN_PROCESS_SHM_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @file plugin_process_shm.h
+ * @brief Shared memory of out-of-process plugins (plugin type 2)
+ *
+ * A process plugin is an executable the runtime starts and supervises. It
+ * exchanges data with the runtime through one shared memory region, so a
+ * crash of the plugin cannot take the runtime down and the plugin may be
+ * written in any language that can map a file and use atomic loads and
+ * stores. The region holds:
+ *
+ * - A header, written once by the runtime before the process starts.
+ * - Two snapshot sets of the packed image areas, in the layout of the image
+ *   shadow (see image_shadow.h): one byte per index for BOOL areas with bit n
+ *   holding %XXi.n, one element of the IEC type per index otherwise. After
+ *   every scan the runtime rewrites the set the process is not pointed at and
+ *   then publishes it, so a reader never waits and has a full scan to read a
+ *   set in place. Each set has a sequence counter, odd while it is rewritten.
+ * - A single-producer, single-consumer ring of journal writes. The process
+ *   appends entries, the runtime drains them after every scan into the
+ *   journal, so they reach the image tables at the start of the next scan.
+ *
+ * After publishing a set the runtime increments cycle_futex and, if the
+ * process announced in `waiting` that it sleeps on that word, wakes it with
+ * FUTEX_WAKE (a shared futex, not FUTEX_PRIVATE). Where futexes do not exist
+ * the process polls cycle_futex instead.
+ *
+ * The runtime passes the region to the process by name in the
+ * OPENPLC_PLUGIN_SHM environment variable (for shm_open()), along with
+ * OPENPLC_PLUGIN_NAME and OPENPLC_PLUGIN_CONFIG (the config path of the
+ * plugins.conf line, also passed as the first argument if it is set). The
+ * process exits when `state` becomes PLUGIN_SHM_STATE_STOP; the runtime
+ * sends SIGTERM, and later SIGKILL, to a process that does not.
+ *
+ * All fields are in host byte order. Fields written by one side and read by
+ * the other are accessed with atomic loads and stores (acquire/release).
+ * The static inline functions below implement the process side for C and
+ * C++ plugins and document the protocol for other languages.
+ */
+
+#define PLUGIN_SHM_MAGIC 0x4d53504fu // "OPSM"
+#define PLUGIN_SHM_VERSION 1
+#define PLUGIN_SHM_AREAS 14          // One per journal_buffer_type_t
+#define PLUGIN_SHM_RING_BYTES (256u * 1024u)
+
+#define PLUGIN_SHM_ENV "OPENPLC_PLUGIN_SHM"
+#define PLUGIN_SHM_ENV_NAME "OPENPLC_PLUGIN_NAME"
+#define PLUGIN_SHM_ENV_CONFIG "OPENPLC_PLUGIN_CONFIG"
+
+#define PLUGIN_SHM_STATE_RUN 0
+#define PLUGIN_SHM_STATE_STOP 1
+
+// Ring entry kinds
+#define PLUGIN_SHM_ENTRY_RANGE 1 // count elements from start, packed after the entry
+#define PLUGIN_SHM_ENTRY_BOOL 2  // One bit: start is the index, bit and value in the entry
+#define PLUGIN_SHM_ENTRY_PAD 3   // Filler up to the end of the ring, skipped
+
+/**
+ * @brief Where one image area lies in the two snapshot sets
+ */
+typedef struct
+{
+    uint32_t offset[2]; // Byte offset from the start of the region, per set
+    uint32_t count;     // Elements (the runtime's buffer size)
+    uint32_t width;     // Bytes per element: 1 for BOOL and BYTE, then 2, 4, 8
+} plugin_shm_area_t;
+
+/**
+ * @brief Header at offset 0 of the region, 512 bytes
+ *
+ * Grouped by writer, each group on cache lines of its own.
+ */
+typedef struct
+{
+    // Written by the runtime before the process starts
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size; // sizeof(plugin_shm_header_t)
+    uint32_t region_size; // Bytes of the whole region
+    uint32_t buffer_size; // Elements per image area
+    uint32_t ring_offset; // Byte offset of the journal ring, 16-byte aligned
+    uint32_t ring_size;   // Bytes of the journal ring, a multiple of 16
+    uint32_t runtime_pid;
+    plugin_shm_area_t areas[PLUGIN_SHM_AREAS];
+
+    // Written by the runtime after every scan (offset 256)
+    uint32_t published;    // Set to read, 0 or 1
+    uint32_t cycle_futex;  // Incremented after every publication, the futex word
+    uint32_t set_seq[2];   // Per set, odd while the runtime rewrites it
+    uint64_t set_cycle[2]; // Scan counter of each set
+    uint32_t set_valid[2]; // Areas present in each set, bit n for area n
+    uint32_t state;        // PLUGIN_SHM_STATE_*
+    uint32_t reserved0;
+    uint64_t ring_tail;    // Ring bytes consumed by the runtime
+    uint64_t rejected;     // Ring entries the journal refused
+    uint8_t pad0[64];
+
+    // Written by the process (offset 384)
+    uint32_t subscribed;  // Areas the runtime copies into the sets, bit n for area n
+    uint32_t waiting;     // Non-zero while the process sleeps on cycle_futex
+    uint64_t ring_head;   // Ring bytes written by the process
+    uint32_t process_pid; // Set when the process attaches
+    uint8_t pad1[108];
+} plugin_shm_header_t;
+
+/**
+ * @brief Ring entry header, 16 bytes, followed by the values of a RANGE entry
+ *
+ * Entries start on 16-byte boundaries and never wrap: an entry that does not
+ * fit before the end of the ring is preceded by a PAD entry covering the rest.
+ * size includes the header and the padding after the values.
+ */
+typedef struct
+{
+    uint32_t size;
+    uint8_t kind;  // PLUGIN_SHM_ENTRY_*
+    uint8_t type;  // Area, journal_buffer_type_t
+    uint8_t bit;   // BOOL entries
+    uint8_t value; // BOOL entries
+    uint32_t start;
+    uint32_t count; // RANGE entries
+} plugin_shm_entry_t;
+
+#ifdef __cplusplus
+static_assert(sizeof(plugin_shm_header_t) == 512, "plugin_shm_header_t is 512 bytes");
+static_assert(sizeof(plugin_shm_entry_t) == 16, "plugin_shm_entry_t is 16 bytes");
+#else
+_Static_assert(sizeof(plugin_shm_header_t) == 512, "plugin_shm_header_t is 512 bytes");
+_Static_assert(sizeof(plugin_shm_entry_t) == 16, "plugin_shm_entry_t is 16 bytes");
+#endif
+
+#define PLUGIN_SHM_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define PLUGIN_SHM_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+static inline void plugin_shm_futex_wait(uint32_t *word, uint32_t expected, int timeout_ms)
+{
+#if defined(__linux__)
+    struct timespec timeout = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L};
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, timeout_ms < 0 ? NULL : &timeout, NULL, 0);
+#else
+    (void)word;
+    (void)expected;
+    (void)timeout_ms;
+    struct timespec pause = {0, 1000000L};
+    nanosleep(&pause, NULL);
+#endif
+}
+
+static inline void plugin_shm_futex_wake(uint32_t *word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+/**
+ * @brief Process side of a region
+ */
+typedef struct
+{
+    plugin_shm_header_t *header;
+    size_t size;
+    uint32_t last_futex; // cycle_futex when the last publication was handed out
+} plugin_shm_client_t;
+
+/**
+ * @brief Read handle of a set, see plugin_shm_peek()
+ */
+typedef struct
+{
+    uint32_t set;
+    uint32_t seq;
+    uint64_t cycle;
+} plugin_shm_ticket_t;
+
+/**
+ * @brief Map the region named in OPENPLC_PLUGIN_SHM
+ *
+ * @return 0 on success, -1 if the variable is missing or the region cannot be
+ *         mapped or has another layout version
+ */
+static inline int plugin_shm_attach(plugin_shm_client_t *client)
+{
+    memset(client, 0, sizeof(*client));
+    const char *name = getenv(PLUGIN_SHM_ENV);
+    if (!name)
+    {
+        return -1;
+    }
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(plugin_shm_header_t))
+    {
+        close(fd);
+        return -1;
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    plugin_shm_header_t *header = (plugin_shm_header_t *)base;
+    if (header->magic != PLUGIN_SHM_MAGIC || header->version != PLUGIN_SHM_VERSION ||
+        header->header_size != sizeof(plugin_shm_header_t) ||
+        header->region_size > (size_t)st.st_size)
+    {
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+    client->header     = header;
+    client->size       = (size_t)st.st_size;
+    client->last_futex = PLUGIN_SHM_LOAD(&header->cycle_futex);
+    PLUGIN_SHM_STORE(&header->process_pid, (uint32_t)getpid());
+    return 0;
+}
+
+static inline void plugin_shm_detach(plugin_shm_client_t *client)
+{
+    if (client->header)
+    {
+        munmap(client->header, client->size);
+        client->header = NULL;
+    }
+}
+
+/**
+ * @brief Ask the runtime to copy an area into the snapshot sets
+ *
+ * Only subscribed areas are copied. An area shows up in set_valid from the
+ * second scan after subscribing on.
+ */
+static inline void plugin_shm_subscribe(plugin_shm_client_t *client, int type)
+{
+    if (type >= 0 && type < PLUGIN_SHM_AREAS)
+    {
+        __atomic_fetch_or(&client->header->subscribed, 1u << type, __ATOMIC_RELEASE);
+    }
+}
+
+static inline int plugin_shm_stopping(const plugin_shm_client_t *client)
+{
+    return PLUGIN_SHM_LOAD(&client->header->state) != PLUGIN_SHM_STATE_RUN;
+}
+
+/**
+ * @brief Wait for a set published after the last one this function returned
+ *
+ * @param timeout_ms Maximum time to wait, negative to wait indefinitely
+ * @return 1 if a new set was published, 0 on timeout, -1 if the runtime asks
+ *         the process to exit
+ */
+static inline int plugin_shm_wait(plugin_shm_client_t *client, int timeout_ms)
+{
+    plugin_shm_header_t *header = client->header;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;)
+    {
+        if (plugin_shm_stopping(client))
+        {
+            return -1;
+        }
+        uint32_t word = PLUGIN_SHM_LOAD(&header->cycle_futex);
+        if (word != client->last_futex)
+        {
+            client->last_futex = word;
+            return 1;
+        }
+
+        int left = timeout_ms;
+        if (timeout_ms >= 0)
+        {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            int elapsed = (int)((now.tv_sec - start.tv_sec) * 1000 +
+                                (now.tv_nsec - start.tv_nsec) / 1000000);
+            if (elapsed >= timeout_ms)
+            {
+                return 0;
+            }
+            left = timeout_ms - elapsed;
+        }
+
+        // Announce the sleep before the last check, so the runtime either sees the flag
+        // or the kernel sees the new word
+        __atomic_store_n(&header->waiting, 1u, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&header->cycle_futex, __ATOMIC_SEQ_CST) == client->last_futex)
+        {
+            plugin_shm_futex_wait(&header->cycle_futex, client->last_futex, left);
+        }
+        __atomic_store_n(&header->waiting, 0u, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Point at an area of the published set without copying it
+ *
+ * The data may be read in place; call plugin_shm_ticket_valid() afterwards,
+ * and only if it returns true do the values form one consistent snapshot.
+ *
+ * @param count Receives the number of elements (may be NULL)
+ * @return Base of the area, or NULL if the set carries no copy of it
+ */
+static inline const void *plugin_shm_peek(plugin_shm_client_t *client, int type, uint32_t *count,
+                                          plugin_shm_ticket_t *ticket)
+{
+    plugin_shm_header_t *header = client->header;
+    if (type < 0 || type >= PLUGIN_SHM_AREAS)
+    {
+        return NULL;
+    }
+    for (;;)
+    {
+        uint32_t set = PLUGIN_SHM_LOAD(&header->published) & 1u;
+        uint32_t seq = PLUGIN_SHM_LOAD(&header->set_seq[set]);
+        if (seq & 1u)
+        {
+            continue; // Republished while the runtime rewrites the other set
+        }
+        ticket->set   = set;
+        ticket->seq   = seq;
+        ticket->cycle = PLUGIN_SHM_LOAD(&header->set_cycle[set]);
+        if (!(PLUGIN_SHM_LOAD(&header->set_valid[set]) & (1u << type)))
+        {
+            return NULL;
+        }
+        if (count)
+        {
+            *count = header->areas[type].count;
+        }
+        return (const uint8_t *)header + header->areas[type].offset[set];
+    }
+}
+
+static inline int plugin_shm_ticket_valid(plugin_shm_client_t *client,
+                                          const plugin_shm_ticket_t *ticket)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&client->header->set_seq[ticket->set], __ATOMIC_RELAXED) ==
+           ticket->seq;
+}
+
+/**
+ * @brief Copy elements of an area from the published set
+ *
+ * @param dest Destination, count * width bytes
+ * @param cycle Receives the scan counter of the set (may be NULL)
+ * @return Number of elements copied (clipped to the area), or -1 if the set
+ *         carries no copy of the area
+ */
+static inline int plugin_shm_read(plugin_shm_client_t *client, int type, uint32_t start,
+                                  uint32_t count, void *dest, uint64_t *cycle)
+{
+    for (;;)
+    {
+        plugin_shm_ticket_t ticket;
+        uint32_t length;
+        const uint8_t *base = (const uint8_t *)plugin_shm_peek(client, type, &length, &ticket);
+        if (!base)
+        {
+            return -1;
+        }
+        if (start >= length)
+        {
+            return 0;
+        }
+        if (count > length - start)
+        {
+            count = length - start;
+        }
+        uint32_t width = client->header->areas[type].width;
+        memcpy(dest, base + (size_t)start * width, (size_t)count * width);
+        if (plugin_shm_ticket_valid(client, &ticket))
+        {
+            if (cycle)
+            {
+                *cycle = ticket.cycle;
+            }
+            return (int)count;
+        }
+    }
+}
+
+// Reserve space for one entry of size bytes, writing a PAD entry first if it does not
+// fit before the end of the ring. Returns the entry, or NULL while the ring is full.
+static inline plugin_shm_entry_t *plugin_shm_ring_reserve(plugin_shm_client_t *client,
+                                                          uint32_t size)
+{
+    plugin_shm_header_t *header = client->header;
+    uint8_t *ring               = (uint8_t *)header + header->ring_offset;
+    uint64_t head               = header->ring_head; // Only this side writes it
+    uint64_t tail               = PLUGIN_SHM_LOAD(&header->ring_tail);
+    uint32_t pos                = (uint32_t)(head % header->ring_size);
+    uint32_t room               = header->ring_size - pos;
+    uint64_t need               = size + (room < size ? room : 0);
+
+    if (header->ring_size - (head - tail) < need)
+    {
+        return NULL;
+    }
+    if (room < size)
+    {
+        plugin_shm_entry_t *pad = (plugin_shm_entry_t *)(ring + pos);
+        memset(pad, 0, sizeof(*pad));
+        pad->size = room;
+        pad->kind = PLUGIN_SHM_ENTRY_PAD;
+        head += room;
+        PLUGIN_SHM_STORE(&header->ring_head, head);
+        pos = 0;
+    }
+    return (plugin_shm_entry_t *)(ring + pos);
+}
+
+static inline void plugin_shm_ring_commit(plugin_shm_client_t *client, uint32_t size)
+{
+    PLUGIN_SHM_STORE(&client->header->ring_head, client->header->ring_head + size);
+}
+
+/**
+ * @brief Journal count elements of an area starting at start
+ *
+ * values holds the elements packed like the snapshot sets. Ranges longer than
+ * a quarter of the ring are split. Single producer: call from one thread, or
+ * serialize the calls.
+ *
+ * @return 0 on success, -1 if the ring is full (retry after the next scan)
+ *         or the arguments are invalid
+ */
+static inline int plugin_shm_write_range(plugin_shm_client_t *client, int type, uint32_t start,
+                                         uint32_t count, const void *values)
+{
+    plugin_shm_header_t *header = client->header;
+    if (type < 0 || type >= PLUGIN_SHM_AREAS || count == 0)
+    {
+        return -1;
+    }
+    uint32_t width     = header->areas[type].width;
+    uint32_t max_count = (header->ring_size / 4 - sizeof(plugin_shm_entry_t)) / width;
+    const uint8_t *src = (const uint8_t *)values;
+
+    while (count > 0)
+    {
+        uint32_t n    = count < max_count ? count : max_count;
+        uint32_t size = (uint32_t)(sizeof(plugin_shm_entry_t) + n * width + 15u) & ~15u;
+        plugin_shm_entry_t *entry = plugin_shm_ring_reserve(client, size);
+        if (!entry)
+        {
+            return -1;
+        }
+        entry->size  = size;
+        entry->kind  = PLUGIN_SHM_ENTRY_RANGE;
+        entry->type  = (uint8_t)type;
+        entry->bit   = 0;
+        entry->value = 0;
+        entry->start = start;
+        entry->count = n;
+        memcpy(entry + 1, src, (size_t)n * width);
+        plugin_shm_ring_commit(client, size);
+
+        start += n;
+        count -= n;
+        src += (size_t)n * width;
+    }
+    return 0;
+}
+
+/**
+ * @brief Journal one bit of a BOOL area, e.g. %QX2.5 as (1, 2, 5, value)
+ *
+ * @return 0 on success, -1 if the ring is full or the arguments are invalid
+ */
+static inline int plugin_shm_write_bool(plugin_shm_client_t *client, int type, uint32_t index,
+                                        int bit, int value)
+{
+    if (type < 0 || type > 2 || bit < 0 || bit > 7)
+    {
+        return -1;
+    }
+    uint32_t size             = sizeof(plugin_shm_entry_t);
+    plugin_shm_entry_t *entry = plugin_shm_ring_reserve(client, size);
+    if (!entry)
+    {
+        return -1;
+    }
+    entry->size  = size;
+    entry->kind  = PLUGIN_SHM_ENTRY_BOOL;
+    entry->type  = (uint8_t)type;
+    entry->bit   = (uint8_t)bit;
+    entry->value = value != 0;
+    entry->start = index;
+    entry->count = 1;
+    plugin_shm_ring_commit(client, size);
+    return 0;
+}
+
+#endif // PLUGIN_PROCESS_SHM_H
@@ -6,6 +6,7 @@
  * the plugin driver system and native plugins. It provides:
  * - Logging function pointer types
  * - The plugin_runtime_args_t structure for runtime buffer access
+ * - ABI version 2: plugin_abi_t, the capability table and plugin_declaration_t
  *
  * Both Python and native plugins receive a pointer to plugin_runtime_args_t
  * during initialization, giving them access to PLC I/O buffers, mutex
@@ -30,6 +31,31 @@ typedef void (*plugin_log_debug_func_t)(const char *fmt, ...);
 typedef void (*plugin_log_warn_func_t)(const char *fmt, ...);
 typedef void (*plugin_log_error_func_t)(const char *fmt, ...);
 
+/**
+ * @brief Preformatted logging with the plugin as source
+ *
+ * Logs `message` as is (it is not a format string) at `level`, one of the
+ * PLUGIN_LOG_LEVEL_* values, tagged with `source` (the plugin_id the plugin
+ * received) so the log server can tell the plugins apart.
+ */
+typedef void (*plugin_log_message_func_t)(int source, int level, const char *message);
+
+/**
+ * @brief Rate-limited preformatted logging for hot error paths
+ *
+ * Like plugin_log_message_func_t, but messages with the same source, level and
+ * key beyond a short burst are dropped and later summarized as "(repeated N
+ * more times)". `key` identifies the call site; 0 uses a hash of the message,
+ * so identical messages are limited together.
+ */
+typedef void (*plugin_log_limited_func_t)(int source, int level, unsigned int key,
+                                          const char *message);
+
+#define PLUGIN_LOG_LEVEL_DEBUG 0
+#define PLUGIN_LOG_LEVEL_INFO 1
+#define PLUGIN_LOG_LEVEL_WARN 2
+#define PLUGIN_LOG_LEVEL_ERROR 3
+
 /**
  * @brief Journal write function pointer types
  *
@@ -50,6 +76,109 @@ typedef int (*plugin_journal_write_int_func_t)(int type, int index, int value);
 typedef int (*plugin_journal_write_dint_func_t)(int type, int index, unsigned int value);
 typedef int (*plugin_journal_write_lint_func_t)(int type, int index, unsigned long long value);
 
+/**
+ * @brief Journal range write function pointer type
+ *
+ * Journals count consecutive elements starting at start_index as a single
+ * entry. values holds the elements packed at the natural width of the type
+ * (1, 2, 4 or 8 bytes) in host byte order; for BOOL types each element is
+ * one byte carrying all 8 bits of that index.
+ */
+typedef int (*plugin_journal_write_range_func_t)(int type, int start_index, int count,
+                                                 const void *values);
+
+/**
+ * @brief Packed image area accessor function pointer type
+ *
+ * Returns the base of a contiguous, packed copy of one image table area
+ * (type uses the journal buffer type values above) and stores its element
+ * count in length. BOOL areas hold one byte per index with bit n = bit n
+ * of that index. The copy is refreshed at the end of every scan while
+ * buffer_mutex is held, so take the mutex while reading it.
+ *
+ * Returns NULL until the area has been refreshed at least once after the
+ * first request; callers should fall back to the pointer tables then.
+ */
+typedef const void *(*plugin_get_image_area_func_t)(int type, int *length);
+
+/**
+ * @brief Lock-free snapshot read function pointer type
+ *
+ * Copies count packed elements starting at start_index from the snapshot
+ * published at the end of the last scan into dest, without taking
+ * buffer_mutex. All elements come from the same scan. Returns the number of
+ * elements copied, or -1 if the area is not available yet (the first call
+ * enables it; fall back to a locked read until it succeeds).
+ */
+typedef int (*plugin_read_image_snapshot_func_t)(int type, int start_index, int count,
+                                                 void *dest);
+
+/**
+ * @brief Change-of-value read function pointer type
+ *
+ * Like read_image_snapshot (dest may be NULL), and fills changes with one bit
+ * per variable of the range that changed since the snapshot the plugin read
+ * before: bit n of byte k for index start_index + k in BOOL areas (count
+ * bytes), bit k % 8 of byte k / 8 for element start_index + k otherwise
+ * ((count + 7) / 8 bytes). *generation holds the generation of that previous
+ * read, 0 the first time, and receives the one read now. If scans were missed
+ * in between, or on the first read, every bit is set, so a plugin that
+ * transmits the set bits never loses a change. Returns the number of elements,
+ * or -1 if the area is not available yet.
+ */
+typedef int (*plugin_read_image_changes_func_t)(int type, int start_index, int count, void *dest,
+                                                void *changes, unsigned int *generation);
+
+/**
+ * @brief One completed scan, as handed to a plugin thread by wait_cycle
+ */
+typedef struct
+{
+    unsigned long long cycle; // Scan counter, increasing with every scan
+    unsigned int generation;  // Image snapshot generation published by the scan (0 if none)
+    unsigned int missed;      // Scans skipped since the previous token
+} plugin_cycle_token_t;
+
+/**
+ * @brief Scan wait function pointer type
+ *
+ * Blocks the calling thread until a scan newer than the last one it received
+ * has completed, or until timeout_ms passes (negative waits indefinitely).
+ * signal is the cycle_signal member of the same structure. Only one thread
+ * per plugin may wait. Returns 1 with token filled in, 0 on timeout, or at once
+ * while the plugin is being stopped, -1 on error or if the plugin has no signal.
+ */
+typedef int (*plugin_wait_cycle_func_t)(void *signal, int timeout_ms,
+                                        plugin_cycle_token_t *token);
+
+/**
+ * @brief Metric function pointer types
+ *
+ * metric_register creates a counter or gauge (type is one of the
+ * PLUGIN_METRIC_* values) exported on the runtime's metrics endpoint with a
+ * plugin="<plugin name>" label; source is the plugin_id the plugin received.
+ * name must match [a-zA-Z_:][a-zA-Z0-9_:]*, counters are exported with the
+ * _total suffix. Registering the same name again returns the same handle.
+ * Returns the handle, or -1 if the metric cannot be registered; register at
+ * init, metric_add and metric_set are cheap enough for any thread and ignore
+ * a handle of -1.
+ *
+ * metric_register_labels adds the label set `labels` (without braces, e.g.
+ * `client="10.0.0.5"`) after the plugin label, for one series per peer or
+ * channel. Registration takes a mutex, so register a series once, when its
+ * peer or channel first shows up, not per request.
+ */
+typedef int (*plugin_metric_register_func_t)(int source, const char *name, const char *help,
+                                             int type);
+typedef int (*plugin_metric_register_labels_func_t)(int source, const char *name,
+                                                    const char *help, int type,
+                                                    const char *labels);
+typedef void (*plugin_metric_add_func_t)(int handle, long long delta);
+typedef void (*plugin_metric_set_func_t)(int handle, long long value);
+
+#define PLUGIN_METRIC_COUNTER 0
+#define PLUGIN_METRIC_GAUGE 1
+
 /**
  * @brief Runtime buffer access structure for plugins
  *
@@ -106,6 +235,211 @@ typedef struct
     plugin_journal_write_int_func_t journal_write_int;
     plugin_journal_write_dint_func_t journal_write_dint;
     plugin_journal_write_lint_func_t journal_write_lint;
+    plugin_journal_write_range_func_t journal_write_range;
+
+    /* Packed image areas for bulk reads */
+    plugin_get_image_area_func_t get_image_area;
+    plugin_read_image_snapshot_func_t read_image_snapshot;
+
+    /* Log source identity: 1-based position in plugins.conf */
+    int plugin_id;
+    plugin_log_message_func_t log_message;
+    plugin_log_limited_func_t log_limited;
+
+    /* Scan notifications for plugin threads (Python plugins only, NULL otherwise) */
+    void *cycle_signal;
+    plugin_wait_cycle_func_t wait_cycle;
+
+    /* Plugin metrics for the runtime's metrics endpoint */
+    plugin_metric_register_func_t metric_register;
+    plugin_metric_add_func_t metric_add;
+    plugin_metric_set_func_t metric_set;
+
+    /* Change-of-value reads of the packed image areas */
+    plugin_read_image_changes_func_t read_image_changes;
+
+    /* Plugin metrics with labels of their own */
+    plugin_metric_register_labels_func_t metric_register_labels;
 } plugin_runtime_args_t;
 
+/**
+ * @brief Plugin ABI version
+ *
+ * Version 1 is init(plugin_runtime_args_t *): the structure above only ever
+ * grows at its end, but a plugin cannot tell how much of it the runtime
+ * filled in. Version 2 plugins additionally export
+ *
+ *   const plugin_declaration_t plugin_declaration;
+ *   int plugin_init(const plugin_abi_t *abi);
+ *
+ * The runtime then calls plugin_init() instead of init(), with the size of
+ * what it passes and a table of the optional entry points it provides, and
+ * only resolves the hooks the plugin declares. A runtime that only knows
+ * version 1 ignores both symbols and calls init(), so a plugin that exports
+ * init() as well runs on either.
+ */
+#define PLUGIN_ABI_VERSION 2
+
+/**
+ * @brief Capability bits, one per entry point group of plugin_capabilities_t
+ *
+ * Bits and table members are only ever appended, so a runtime that sets a
+ * bit also has the members that go with it.
+ */
+#define PLUGIN_CAP_JOURNAL_RANGE (1u << 0)  // journal_write_range
+#define PLUGIN_CAP_IMAGE_AREA (1u << 1)     // get_image_area
+#define PLUGIN_CAP_IMAGE_SNAPSHOT (1u << 2) // read_image_snapshot
+#define PLUGIN_CAP_IMAGE_CHANGES (1u << 3)  // read_image_changes
+#define PLUGIN_CAP_METRICS (1u << 4)        // metric_register, _add, _set, _register_labels
+#define PLUGIN_CAP_JOURNAL_BATCH (1u << 5)  // journal_write_batch
+#define PLUGIN_CAP_IMAGE_BATCH (1u << 6)    // read_image_batch
+#define PLUGIN_CAP_INSTANCES (1u << 7)      // instance_count, _write_batch, _read_batch
+
+/**
+ * @brief One write of a journal_write_batch call
+ *
+ * With bit >= 0 (BOOL types only) bit `bit` of start_index is set to bit 0
+ * of the first byte of values and count is ignored; otherwise count elements
+ * are written like journal_write_range.
+ */
+typedef struct
+{
+    int type;
+    int start_index;
+    int count;
+    int bit;
+    const void *values;
+} plugin_journal_write_t;
+
+/**
+ * @brief Batch journal write function pointer type
+ *
+ * Journals the writes in order, in a single call. Stops at the first write
+ * the journal rejects and returns the number journaled before it, so count
+ * means all of them were; the caller retries the rest.
+ */
+typedef int (*plugin_journal_write_batch_func_t)(const plugin_journal_write_t *writes, int count);
+
+/**
+ * @brief One range of a read_image_batch call
+ */
+typedef struct
+{
+    int type;
+    int start_index;
+    int count;
+    void *dest;  // count packed elements, as for read_image_snapshot
+    int copied;  // Receives the elements copied, -1 if the area is not available yet
+} plugin_image_read_t;
+
+/**
+ * @brief Batch snapshot read function pointer type
+ *
+ * Like read_image_snapshot for every range, but all ranges come from the same
+ * scan, also across areas: the reads are repeated (up to three times) while
+ * scans end in between. *generation receives the generation of that scan, or
+ * 0 if no consistent set could be read. Returns the number of ranges with
+ * copied >= 0, or -1 on invalid arguments.
+ */
+typedef int (*plugin_read_image_batch_func_t)(plugin_image_read_t *reads, int count,
+                                              unsigned int *generation);
+
+/**
+ * @brief Program instance count function pointer type
+ *
+ * Returns the number of programs the runtime runs, the main one (instance 0)
+ * included. Instances 1 and up are the ones added with --instance; their
+ * tables are sized like the main program's.
+ */
+typedef int (*plugin_instance_count_func_t)(void);
+
+/**
+ * @brief Instance batch journal write function pointer type
+ *
+ * journal_write_batch for one program instance. Instance 0 is the main
+ * program's journal, the others are applied at the start of a scan of their
+ * own program. Returns -1 if the instance is not running.
+ */
+typedef int (*plugin_instance_write_batch_func_t)(int instance,
+                                                  const plugin_journal_write_t *writes, int count);
+
+/**
+ * @brief Instance batch read function pointer type
+ *
+ * read_image_batch for one program instance. Instances other than 0 have no
+ * image shadow: the read waits for a scan of the instance in progress to end.
+ * Returns -1 if the instance is not running.
+ */
+typedef int (*plugin_instance_read_batch_func_t)(int instance, plugin_image_read_t *reads,
+                                                 int count, unsigned int *generation);
+
+/**
+ * @brief Optional entry points of ABI version 2
+ *
+ * Owned by the runtime and valid until the plugin's cleanup, so a plugin may
+ * keep the pointer. Check mask before calling a member.
+ */
+typedef struct
+{
+    unsigned int size; // Bytes of this table the runtime filled in
+    unsigned int mask; // PLUGIN_CAP_* bits of the members set below
+
+    plugin_journal_write_range_func_t journal_write_range;
+    plugin_get_image_area_func_t get_image_area;
+    plugin_read_image_snapshot_func_t read_image_snapshot;
+    plugin_read_image_changes_func_t read_image_changes;
+    plugin_metric_register_func_t metric_register;
+    plugin_metric_add_func_t metric_add;
+    plugin_metric_set_func_t metric_set;
+    plugin_metric_register_labels_func_t metric_register_labels;
+    plugin_journal_write_batch_func_t journal_write_batch;
+    plugin_read_image_batch_func_t read_image_batch;
+    plugin_instance_count_func_t instance_count;
+    plugin_instance_write_batch_func_t instance_write_batch;
+    plugin_instance_read_batch_func_t instance_read_batch;
+} plugin_capabilities_t;
+
+/**
+ * @brief What the runtime passes to plugin_init()
+ *
+ * The structure and args are freed when plugin_init() returns; copy
+ * args_size bytes of args (at most sizeof(plugin_runtime_args_t) of the
+ * plugin's own header, zeroing the rest) and keep the capabilities pointer.
+ */
+typedef struct
+{
+    unsigned int size;                         // sizeof(plugin_abi_t) of the runtime
+    unsigned int version;                      // PLUGIN_ABI_VERSION of the runtime
+    unsigned int args_size;                    // sizeof(plugin_runtime_args_t) of the runtime
+    const plugin_runtime_args_t *args;         // The version 1 members
+    const plugin_capabilities_t *capabilities; // Optional entry points
+} plugin_abi_t;
+
+/**
+ * @brief Hook bits of plugin_declaration_t, one per optional plugin symbol
+ */
+#define PLUGIN_HOOK_START_LOOP (1u << 0)
+#define PLUGIN_HOOK_STOP_LOOP (1u << 1)
+#define PLUGIN_HOOK_CYCLE_START (1u << 2)
+#define PLUGIN_HOOK_CYCLE_END (1u << 3)
+#define PLUGIN_HOOK_CLEANUP (1u << 4)
+#define PLUGIN_HOOK_COMMAND (1u << 5) // handle_command
+
+/**
+ * @brief Exported by version 2 plugins as `plugin_declaration`
+ *
+ * The runtime only looks up the hooks listed in hooks, so a plugin that keeps
+ * an empty cycle_start for older runtimes is not called every scan, and a
+ * listed hook that is missing fails the load. A plugin that needs capabilities
+ * the runtime does not have is refused with a message naming them, instead of
+ * calling a member that is not there.
+ */
+typedef struct
+{
+    unsigned int size;        // sizeof(plugin_declaration_t) the plugin was built with
+    unsigned int abi_version; // PLUGIN_ABI_VERSION the plugin was built against
+    unsigned int hooks;       // PLUGIN_HOOK_* bits of the hooks the plugin implements
+    unsigned int required;    // PLUGIN_CAP_* bits the plugin cannot run without
+} plugin_declaration_t;
+
 #endif /* PLUGIN_TYPES_H */
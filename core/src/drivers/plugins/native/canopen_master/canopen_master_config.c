@@ -0,0 +1,289 @@
+/**
+ * @file canopen_master_config.c
+ * @brief CANopen Master Plugin Configuration Parser Implementation
+ *
+ * Parses JSON configuration files using cJSON library.
+ */
+
+#include "canopen_master_config.h"
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Error codes */
+#define CANOPEN_MASTER_CONFIG_OK              0
+#define CANOPEN_MASTER_CONFIG_ERR_FILE       -1
+#define CANOPEN_MASTER_CONFIG_ERR_PARSE      -2
+#define CANOPEN_MASTER_CONFIG_ERR_INVALID    -4
+
+/**
+ * @brief Read entire file into a string
+ */
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size > 1024 * 1024) { /* Max 1MB config file */
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    fclose(fp);
+
+    if ((long)read_size != size) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[size] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Safely copy string with length limit
+ */
+static void safe_strcpy(char *dest, const char *src, size_t max_len)
+{
+    if (src == NULL) {
+        dest[0] = '\0';
+        return;
+    }
+    strncpy(dest, src, max_len - 1);
+    dest[max_len - 1] = '\0';
+}
+
+/**
+ * @brief Get string value from JSON object
+ */
+static const char *get_string(const cJSON *obj, const char *key, const char *default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring != NULL) {
+        return item->valuestring;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get integer value from JSON object
+ */
+static int get_int(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) {
+        return item->valueint;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Parse a bit location of the expected area ("%IX2.0", "%QX0.7")
+ */
+static int parse_bit_location(const char *str, char area, int *index, int *bit)
+{
+    if (str == NULL) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    while (isspace((unsigned char)*str)) {
+        str++;
+    }
+    if (str[0] != '%' || toupper((unsigned char)str[1]) != area ||
+        toupper((unsigned char)str[2]) != 'X' || !isdigit((unsigned char)str[3])) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    char *end = NULL;
+    long byte = strtol(str + 3, &end, 10);
+    if (*end != '.' || !isdigit((unsigned char)end[1])) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+    long bit_number = strtol(end + 1, &end, 10);
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0' || byte > 0xFFFF || bit_number > 7) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    *index = (int)byte;
+    *bit = (int)bit_number;
+    return CANOPEN_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief Parse one entry of io_groups
+ */
+static int parse_io_group(const cJSON *json, canopen_master_io_group_t *group)
+{
+    const char *type = get_string(json, "type", "");
+
+    if (strcmp(type, "DI") == 0) {
+        group->type = CANOPEN_GROUP_DI;
+    } else if (strcmp(type, "DO") == 0) {
+        group->type = CANOPEN_GROUP_DO;
+    } else {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    group->length = get_int(json, "len", 0);
+    return parse_bit_location(get_string(json, "iec_location", NULL),
+                              group->type == CANOPEN_GROUP_DI ? 'I' : 'Q', &group->index, &group->bit);
+}
+
+/**
+ * @brief Parse one device entry
+ */
+static int parse_device(const cJSON *json, canopen_master_device_t *device)
+{
+    device->node_id = get_int(json, "node_id", 0);
+
+    const cJSON *groups = cJSON_GetObjectItemCaseSensitive(json, "io_groups");
+    if (cJSON_IsArray(groups) && cJSON_GetArraySize(groups) > CANOPEN_MASTER_MAX_IO_GROUPS) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    int output_bits = 0;
+    const cJSON *group = NULL;
+    cJSON_ArrayForEach(group, groups) {
+        canopen_master_io_group_t *io_group = &device->io_groups[device->num_io_groups];
+        int result = parse_io_group(group, io_group);
+        if (result != CANOPEN_MASTER_CONFIG_OK) {
+            return result;
+        }
+        if (io_group->type == CANOPEN_GROUP_DO && io_group->length > output_bits) {
+            output_bits = io_group->length;
+        }
+        device->num_io_groups++;
+    }
+
+    /* The Python plugin always sends 2 bytes; longer output groups need more */
+    int needed = (output_bits + 7) / 8;
+    device->tpdo_length = get_int(json, "tpdo_length",
+                                  needed > CANOPEN_MASTER_DEFAULT_TPDO_LENGTH ? needed
+                                                                              : CANOPEN_MASTER_DEFAULT_TPDO_LENGTH);
+    return CANOPEN_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief canbus_enabled is the string "true" in generated files; accept JSON true too
+ */
+static bool get_enabled(const cJSON *root)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(root, "canbus_enabled");
+    if (cJSON_IsBool(item)) {
+        return cJSON_IsTrue(item);
+    }
+    return cJSON_IsString(item) && item->valuestring != NULL && strcmp(item->valuestring, "true") == 0;
+}
+
+int canopen_master_config_parse(const char *config_path, canopen_master_config_t *config)
+{
+    if (config_path == NULL || config == NULL) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    memset(config, 0, sizeof(canopen_master_config_t));
+
+    /* Read file contents */
+    char *json_str = read_file(config_path);
+    if (json_str == NULL) {
+        return CANOPEN_MASTER_CONFIG_ERR_FILE;
+    }
+
+    /* Parse JSON */
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+
+    if (root == NULL) {
+        return CANOPEN_MASTER_CONFIG_ERR_PARSE;
+    }
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    config->enabled = get_enabled(root);
+    safe_strcpy(config->interface, get_string(root, "interface", CANOPEN_MASTER_DEFAULT_INTERFACE),
+                CANOPEN_MASTER_MAX_STRING_LEN);
+    config->tpdo_refresh_ms = get_int(root, "tpdo_refresh_ms", CANOPEN_MASTER_DEFAULT_TPDO_REFRESH_MS);
+
+    const cJSON *devices = cJSON_GetObjectItemCaseSensitive(root, "devices");
+    if (cJSON_IsArray(devices) && cJSON_GetArraySize(devices) > CANOPEN_MASTER_MAX_DEVICES) {
+        cJSON_Delete(root);
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    /* Parse each device */
+    const cJSON *device = NULL;
+    cJSON_ArrayForEach(device, devices) {
+        int result = parse_device(device, &config->devices[config->num_devices]);
+        config->num_devices++;
+        if (result != CANOPEN_MASTER_CONFIG_OK) {
+            cJSON_Delete(root);
+            return result;
+        }
+    }
+
+    cJSON_Delete(root);
+
+    /* Validate the parsed configuration */
+    return canopen_master_config_validate(config);
+}
+
+int canopen_master_config_validate(const canopen_master_config_t *config)
+{
+    if (config == NULL) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+    if (config->interface[0] == '\0' || config->tpdo_refresh_ms < 0) {
+        return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    for (int i = 0; i < config->num_devices; i++) {
+        const canopen_master_device_t *device = &config->devices[i];
+
+        if (device->node_id < 1 || device->node_id > CANOPEN_MASTER_MAX_NODE_ID) {
+            return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+        }
+        if (device->tpdo_length < 1 || device->tpdo_length > CANOPEN_MASTER_MAX_PDO_LENGTH) {
+            return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+        }
+
+        /* Groups must fit the PDO: 8 bytes in, tpdo_length bytes out */
+        for (int g = 0; g < device->num_io_groups; g++) {
+            const canopen_master_io_group_t *group = &device->io_groups[g];
+            int max_bits = group->type == CANOPEN_GROUP_DI ? CANOPEN_MASTER_MAX_PDO_LENGTH * 8
+                                                           : device->tpdo_length * 8;
+            if (group->length <= 0 || group->length > max_bits) {
+                return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+            }
+        }
+
+        /* Node ids must be unique */
+        for (int j = 0; j < i; j++) {
+            if (device->node_id == config->devices[j].node_id) {
+                return CANOPEN_MASTER_CONFIG_ERR_INVALID;
+            }
+        }
+    }
+
+    return CANOPEN_MASTER_CONFIG_OK;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file canopen_master_config.h
+ * @brief CANopen Master Plugin Configuration Structures and Parser
+ *
+ * Reads the canbus_conf.json file of the Python canbus_master plugin: the
+ * CAN nodes and, per node, the digital input and output groups exchanged
+ * through PDO1.
+ */
+
+#ifndef CANOPEN_MASTER_CONFIG_H
+#define CANOPEN_MASTER_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configuration limits */
+#define CANOPEN_MASTER_MAX_NODE_ID      127
+#define CANOPEN_MASTER_MAX_DEVICES      CANOPEN_MASTER_MAX_NODE_ID
+#define CANOPEN_MASTER_MAX_IO_GROUPS    16      /* Per device */
+#define CANOPEN_MASTER_MAX_PDO_LENGTH   8       /* Bytes of a classic CAN frame */
+#define CANOPEN_MASTER_MAX_STRING_LEN   16      /* IFNAMSIZ */
+
+/* Default values (match the Python plugin) */
+#define CANOPEN_MASTER_DEFAULT_INTERFACE        "can0"
+#define CANOPEN_MASTER_DEFAULT_TPDO_LENGTH      2
+#define CANOPEN_MASTER_DEFAULT_TPDO_REFRESH_MS  20
+
+typedef enum {
+    CANOPEN_GROUP_DI = 0,           /* Node TPDO1 bits to %IX */
+    CANOPEN_GROUP_DO                /* %QX to node RPDO1 bits */
+} canopen_master_group_type_t;
+
+/**
+ * @brief One run of bits exchanged with a node
+ *
+ * Bit n of the group is bit n of the PDO payload (byte n / 8, bit n % 8)
+ * and the n-th bit counted from iec_location.
+ */
+typedef struct {
+    canopen_master_group_type_t type;
+    int index;                      /* Image table index of iec_location */
+    int bit;                        /* Bit of iec_location */
+    int length;                     /* Number of bits */
+} canopen_master_io_group_t;
+
+/**
+ * @brief One CANopen node
+ */
+typedef struct {
+    int node_id;                    /* 1..127 */
+    int tpdo_length;                /* Bytes sent in the output PDO */
+    canopen_master_io_group_t io_groups[CANOPEN_MASTER_MAX_IO_GROUPS];
+    int num_io_groups;
+} canopen_master_device_t;
+
+/**
+ * @brief Complete CANopen master configuration
+ */
+typedef struct {
+    bool enabled;                   /* canbus_enabled */
+    char interface[CANOPEN_MASTER_MAX_STRING_LEN];
+    int tpdo_refresh_ms;            /* Unchanged outputs are resent this often */
+    canopen_master_device_t devices[CANOPEN_MASTER_MAX_DEVICES];
+    int num_devices;
+} canopen_master_config_t;
+
+/**
+ * @brief Parse configuration from JSON file
+ *
+ * @param config_path Path to the JSON configuration file
+ * @param config Pointer to configuration structure to populate
+ * @return 0 on success, negative error code on failure
+ */
+int canopen_master_config_parse(const char *config_path, canopen_master_config_t *config);
+
+/**
+ * @brief Validate configuration values
+ *
+ * @param config Pointer to configuration structure to validate
+ * @return 0 if valid, negative error code indicating the issue
+ */
+int canopen_master_config_validate(const canopen_master_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CANOPEN_MASTER_CONFIG_H */
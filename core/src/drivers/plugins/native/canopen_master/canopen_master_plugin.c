@@ -0,0 +1,745 @@
+/**
+ * @file canopen_master_plugin.c
+ * @brief Native CANopen Master Plugin Implementation
+ *
+ * PDO1 of every configured node is exchanged like the Python canbus_master
+ * plugin does: the node's TPDO1 (COB-ID 0x180 + node id) feeds %IX groups
+ * and %QX groups are sent in the node's RPDO1 (COB-ID 0x200 + node id).
+ *
+ * The io_groups are compiled at init into bit-copy runs, so no address is
+ * parsed at runtime:
+ * - Inputs: one I/O thread drains the raw CAN socket with recvmmsg() and
+ *   journals each changed PDO, whole image bytes in one range write.
+ * - Outputs: cycle_end (OpenPLC mutex held, after the runtime refreshed its
+ *   packed areas) builds the PDOs of the scan and sends them with one
+ *   non-blocking sendmmsg(), so outputs leave one scan after the program
+ *   wrote them. The runtime's change bits of the %QX window used by the nodes
+ *   tell which nodes have changed outputs, the others are skipped without
+ *   rebuilding their PDO.
+ */
+
+#define _GNU_SOURCE
+
+#include "canopen_master_plugin.h"
+#include "canopen_master_config.h"
+#include "plugin_logger.h"
+#include "plugin_types.h"
+
+#include <errno.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Journal buffer types (matching journal_buffer_type_t) */
+#define CO_TYPE_BOOL_INPUT      0
+#define CO_TYPE_BOOL_OUTPUT     1
+
+/* Predefined connection set, PDO1 */
+#define CO_COB_TPDO1            0x180   /* Node to master */
+#define CO_COB_RPDO1            0x200   /* Master to node */
+#define CO_COB_FUNCTION_MASK    0x780
+
+/* Frames drained per recvmmsg() call */
+#define CO_RX_BATCH             32
+
+/* Interface retry backoff (same as the native Modbus master) */
+#define CO_RETRY_DELAY_BASE_MS  2000
+#define CO_RETRY_DELAY_MAX_MS   30000
+
+/**
+ * @brief One io_group compiled for copying
+ *
+ * Bit n of the run is bit n of the PDO payload. The bits before the first
+ * whole image byte and after the last one are copied one by one, the whole
+ * bytes in between in one go.
+ */
+typedef struct {
+    int index;                      /* Image table index of the first bit */
+    int bit;                        /* Bit of the first bit */
+    int length;                     /* Number of bits */
+    int head_bits;                  /* Bits before the first whole image byte */
+    int full_bytes;                 /* Whole image bytes */
+} co_bit_run_t;
+
+typedef struct {
+    const canopen_master_device_t *config;
+    co_bit_run_t inputs[CANOPEN_MASTER_MAX_IO_GROUPS];
+    int num_inputs;
+    co_bit_run_t outputs[CANOPEN_MASTER_MAX_IO_GROUPS];
+    int num_outputs;
+
+    /* I/O thread only */
+    bool input_seen;
+    uint64_t last_input;
+
+    /* Scan thread only */
+    bool output_sent;
+    bool output_pending;            /* Built but not sent, retried next scan */
+    uint64_t last_output;
+    uint64_t last_output_ms;
+} co_device_t;
+
+/* Plugin state */
+static plugin_logger_t g_logger;
+static plugin_runtime_args_t g_runtime_args;
+static canopen_master_config_t g_config;
+static co_device_t g_devices[CANOPEN_MASTER_MAX_DEVICES];
+static int g_num_devices = 0;
+static co_device_t *g_nodes[CANOPEN_MASTER_MAX_NODE_ID + 1];   /* Node id to device */
+static bool g_initialized = false;
+static volatile bool g_running = false;
+
+/* Raw CAN socket, owned by the I/O thread; published under buffer_mutex
+ * because cycle_end sends on it */
+static int g_socket = -1;
+static int g_stop_fd = -1;
+static pthread_t g_thread;
+static bool g_thread_started = false;
+
+/* Receive batch (I/O thread only) */
+static struct can_frame g_rx_frames[CO_RX_BATCH];
+static struct iovec g_rx_iov[CO_RX_BATCH];
+static struct mmsghdr g_rx_msgs[CO_RX_BATCH];
+
+/* Send batch (scan thread only), one slot per device */
+static struct can_frame g_tx_frames[CANOPEN_MASTER_MAX_DEVICES];
+static struct iovec g_tx_iov[CANOPEN_MASTER_MAX_DEVICES];
+static struct mmsghdr g_tx_msgs[CANOPEN_MASTER_MAX_DEVICES];
+static co_device_t *g_tx_devices[CANOPEN_MASTER_MAX_DEVICES];
+static uint64_t g_tx_payloads[CANOPEN_MASTER_MAX_DEVICES];
+
+/* Change bits of the %QX indexes [g_changes_first, g_changes_first +
+ * g_changes_count) used by output groups (scan thread only) */
+static uint8_t *g_changes = NULL;
+static int g_changes_first = 0;
+static int g_changes_count = 0;
+static unsigned int g_changes_generation = 0;
+
+/*
+ * =============================================================================
+ * Bit Copying
+ * =============================================================================
+ */
+
+static void compile_run(const canopen_master_io_group_t *group, co_bit_run_t *run)
+{
+    run->index = group->index;
+    run->bit = group->bit;
+    run->length = group->length;
+    run->head_bits = group->bit == 0 ? 0 : 8 - group->bit;
+    if (run->head_bits > run->length) {
+        run->head_bits = run->length;
+    }
+    run->full_bytes = (run->length - run->head_bits) / 8;
+}
+
+/**
+ * @brief Payload of a frame as a little-endian integer (bit n = byte n / 8, bit n % 8)
+ */
+static uint64_t frame_payload(const struct can_frame *frame)
+{
+    uint64_t payload = 0;
+    int length = frame->can_dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : frame->can_dlc;
+
+    for (int i = 0; i < length; i++) {
+        payload |= (uint64_t)frame->data[i] << (8 * i);
+    }
+    return payload;
+}
+
+/**
+ * @brief Journal the bits of an input PDO to the %IX runs of its node
+ */
+static void store_inputs(const co_device_t *device, uint64_t payload)
+{
+    for (int r = 0; r < device->num_inputs; r++) {
+        const co_bit_run_t *run = &device->inputs[r];
+        int k = 0;
+
+        for (; k < run->head_bits; k++) {
+            g_runtime_args.journal_write_bool(CO_TYPE_BOOL_INPUT, run->index, run->bit + k,
+                                              (int)((payload >> k) & 1));
+        }
+
+        int index = run->index + (run->bit + k) / 8;
+        if (run->full_bytes > 0) {
+            uint8_t bytes[CANOPEN_MASTER_MAX_PDO_LENGTH];
+            for (int b = 0; b < run->full_bytes; b++) {
+                bytes[b] = (uint8_t)(payload >> (k + 8 * b));
+            }
+            g_runtime_args.journal_write_range(CO_TYPE_BOOL_INPUT, index, run->full_bytes, bytes);
+            k += run->full_bytes * 8;
+            index += run->full_bytes;
+        }
+
+        for (int bit = 0; k < run->length; k++, bit++) {
+            g_runtime_args.journal_write_bool(CO_TYPE_BOOL_INPUT, index, bit, (int)((payload >> k) & 1));
+        }
+    }
+}
+
+/**
+ * @brief Bits of a run in a packed BOOL area (or change bits) starting at index `first`
+ */
+static uint64_t load_packed_run(const co_bit_run_t *run, const uint8_t *packed, int first)
+{
+    uint64_t bits = 0;
+    int pos = (run->index - first) * 8 + run->bit;
+
+    for (int k = 0; k < run->length;) {
+        int shift = (pos + k) % 8;
+        int take = 8 - shift < run->length - k ? 8 - shift : run->length - k;
+        uint64_t chunk = (uint64_t)((packed[(pos + k) / 8] >> shift) & ((1u << take) - 1));
+        bits |= chunk << k;
+        k += take;
+    }
+    return bits;
+}
+
+/**
+ * @brief Read the bits of an output run
+ *
+ * Caller must hold buffer_mutex. Uses the packed output area when it covers
+ * the run, else the pointer tables (unlocated bits read as 0).
+ */
+static uint64_t load_output_run(const co_bit_run_t *run, const uint8_t *area, int area_length)
+{
+    uint64_t bits = 0;
+    int pos = run->index * 8 + run->bit;
+
+    if (area != NULL && (pos + run->length - 1) / 8 < area_length) {
+        return load_packed_run(run, area, 0);
+    }
+
+    for (int k = 0; k < run->length; k++) {
+        IEC_BOOL *value = g_runtime_args.bool_output[(pos + k) / 8][(pos + k) % 8];
+        if (value != NULL && *value) {
+            bits |= (uint64_t)1 << k;
+        }
+    }
+    return bits;
+}
+
+/*
+ * =============================================================================
+ * CAN Socket
+ * =============================================================================
+ */
+
+/**
+ * @brief Open a raw CAN socket on `interface` receiving only PDO1 of the nodes
+ *
+ * @return The socket, or -1 (errno set)
+ */
+static int open_socket(const char *interface)
+{
+    unsigned int ifindex = if_nametoindex(interface);
+    if (ifindex == 0) {
+        return -1;
+    }
+
+    int fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* Standard data frames 0x180..0x1FF only */
+    struct can_filter filter;
+    filter.can_id = CO_COB_TPDO1;
+    filter.can_mask = CO_COB_FUNCTION_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = (int)ifindex;
+
+    if (setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter)) != 0 ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Make `fd` the socket cycle_end sends on
+ */
+static void publish_socket(int fd)
+{
+    g_runtime_args.mutex_take(g_runtime_args.buffer_mutex);
+    g_socket = fd;
+    g_runtime_args.mutex_give(g_runtime_args.buffer_mutex);
+}
+
+/*
+ * =============================================================================
+ * I/O Thread
+ * =============================================================================
+ */
+
+/**
+ * @brief Sleep `ms` milliseconds or until the plugin is stopped
+ *
+ * @return false if the plugin is stopping
+ */
+static bool wait_ms(int ms)
+{
+    struct pollfd pfd;
+    pfd.fd = g_stop_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    while (poll(&pfd, 1, ms) < 0 && errno == EINTR) {
+    }
+    return g_running;
+}
+
+static void process_frame(const struct can_frame *frame)
+{
+    if (frame->can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) {
+        return;
+    }
+
+    int node_id = (int)(frame->can_id & CAN_SFF_MASK) - CO_COB_TPDO1;
+    if (node_id < 1 || node_id > CANOPEN_MASTER_MAX_NODE_ID) {
+        return;
+    }
+
+    co_device_t *device = g_nodes[node_id];
+    if (device == NULL || device->num_inputs == 0) {
+        return;
+    }
+
+    /* Nodes resend unchanged PDOs on SYNC or their event timer */
+    uint64_t payload = frame_payload(frame);
+    if (device->input_seen && payload == device->last_input) {
+        return;
+    }
+    store_inputs(device, payload);
+    device->input_seen = true;
+    device->last_input = payload;
+}
+
+static void *io_thread(void *arg)
+{
+    (void)arg;
+    int retry_delay_ms = CO_RETRY_DELAY_BASE_MS;
+    int fd = -1;
+
+    plugin_logger_info(&g_logger, "I/O thread started");
+
+    while (g_running) {
+        if (fd < 0) {
+            fd = open_socket(g_config.interface);
+            if (fd < 0) {
+                plugin_logger_warn_limited(&g_logger, "Cannot open CAN interface %s: %s",
+                                           g_config.interface, strerror(errno));
+                if (!wait_ms(retry_delay_ms)) {
+                    break;
+                }
+                retry_delay_ms = retry_delay_ms * 3 / 2;
+                if (retry_delay_ms > CO_RETRY_DELAY_MAX_MS) {
+                    retry_delay_ms = CO_RETRY_DELAY_MAX_MS;
+                }
+                continue;
+            }
+            retry_delay_ms = CO_RETRY_DELAY_BASE_MS;
+            publish_socket(fd);
+            plugin_logger_info(&g_logger, "Listening on %s", g_config.interface);
+        }
+
+        struct pollfd pfds[2];
+        pfds[0].fd = fd;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        pfds[1].fd = g_stop_fd;
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            plugin_logger_error(&g_logger, "poll failed: %s", strerror(errno));
+            break;
+        }
+        if (pfds[1].revents != 0) {
+            break;
+        }
+
+        int received = recvmmsg(fd, g_rx_msgs, CO_RX_BATCH, MSG_DONTWAIT, NULL);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
+            if (errno == ENETDOWN) {
+                /* Reported once when the interface goes down, the socket stays usable */
+                plugin_logger_warn_limited(&g_logger, "CAN interface %s is down", g_config.interface);
+                continue;
+            }
+            plugin_logger_error_limited(&g_logger, "Receive failed on %s: %s, reopening",
+                                        g_config.interface, strerror(errno));
+            publish_socket(-1);
+            close(fd);
+            fd = -1;
+            continue;
+        }
+
+        for (int i = 0; i < received; i++) {
+            if (g_rx_msgs[i].msg_len == sizeof(struct can_frame)) {
+                process_frame(&g_rx_frames[i]);
+            }
+        }
+    }
+
+    if (fd >= 0) {
+        publish_socket(-1);
+        close(fd);
+    }
+    plugin_logger_info(&g_logger, "I/O thread finished and interface closed");
+    return NULL;
+}
+
+/*
+ * =============================================================================
+ * Device Setup
+ * =============================================================================
+ */
+
+/**
+ * @brief Compile the io_groups of one device
+ *
+ * Groups beyond the image tables are logged and ignored.
+ */
+static void setup_device(const canopen_master_device_t *config, co_device_t *device)
+{
+    memset(device, 0, sizeof(co_device_t));
+    device->config = config;
+
+    for (int g = 0; g < config->num_io_groups; g++) {
+        const canopen_master_io_group_t *group = &config->io_groups[g];
+        char area = group->type == CANOPEN_GROUP_DI ? 'I' : 'Q';
+
+        if (group->index + (group->bit + group->length - 1) / 8 >= g_runtime_args.buffer_size) {
+            plugin_logger_error(&g_logger, "[node %d] %%%cX%d.%d + %d exceeds the image table, group ignored",
+                                config->node_id, area, group->index, group->bit, group->length);
+            continue;
+        }
+
+        if (group->type == CANOPEN_GROUP_DI) {
+            compile_run(group, &device->inputs[device->num_inputs++]);
+        } else {
+            compile_run(group, &device->outputs[device->num_outputs++]);
+        }
+    }
+}
+
+static void setup_batches(void)
+{
+    for (int i = 0; i < CO_RX_BATCH; i++) {
+        g_rx_iov[i].iov_base = &g_rx_frames[i];
+        g_rx_iov[i].iov_len = sizeof(struct can_frame);
+        memset(&g_rx_msgs[i], 0, sizeof(struct mmsghdr));
+        g_rx_msgs[i].msg_hdr.msg_iov = &g_rx_iov[i];
+        g_rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    for (int i = 0; i < CANOPEN_MASTER_MAX_DEVICES; i++) {
+        g_tx_iov[i].iov_base = &g_tx_frames[i];
+        g_tx_iov[i].iov_len = sizeof(struct can_frame);
+        memset(&g_tx_msgs[i], 0, sizeof(struct mmsghdr));
+        g_tx_msgs[i].msg_hdr.msg_iov = &g_tx_iov[i];
+        g_tx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+/**
+ * @brief Allocate the change bits of the %QX window the output groups use
+ *
+ * No change bits (and every PDO rebuilt each scan) if it cannot be allocated.
+ */
+static void setup_changes(void)
+{
+    int first = -1;
+    int end = 0;
+
+    for (int i = 0; i < g_num_devices; i++) {
+        for (int r = 0; r < g_devices[i].num_outputs; r++) {
+            const co_bit_run_t *run = &g_devices[i].outputs[r];
+            int last = run->index + (run->bit + run->length - 1) / 8;
+            if (first < 0 || run->index < first) {
+                first = run->index;
+            }
+            if (last + 1 > end) {
+                end = last + 1;
+            }
+        }
+    }
+
+    free(g_changes);
+    g_changes = NULL;
+    g_changes_count = 0;
+    if (first < 0 || g_runtime_args.read_image_changes == NULL) {
+        return;
+    }
+    g_changes = malloc((size_t)(end - first));
+    if (g_changes != NULL) {
+        g_changes_first = first;
+        g_changes_count = end - first;
+    }
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/*
+ * =============================================================================
+ * Plugin Lifecycle Functions
+ * =============================================================================
+ */
+
+/**
+ * @brief Initialize the CANopen master plugin
+ */
+int init(void *args)
+{
+    /* Initialize logger first (before we have runtime_args) */
+    plugin_logger_init(&g_logger, "CANOPEN_MASTER", NULL);
+    plugin_logger_info(&g_logger, "Initializing CANopen master plugin...");
+
+    if (!args) {
+        plugin_logger_error(&g_logger, "init args is NULL");
+        return -1;
+    }
+
+    /* Copy runtime args (critical - pointer is freed after init returns) */
+    memcpy(&g_runtime_args, args, sizeof(plugin_runtime_args_t));
+
+    /* Re-initialize logger with runtime_args for central logging */
+    plugin_logger_init(&g_logger, "CANOPEN_MASTER", args);
+
+    const char *config_path = g_runtime_args.plugin_specific_config_file_path;
+    plugin_logger_info(&g_logger, "Loading config: %s", config_path);
+    int result = canopen_master_config_parse(config_path, &g_config);
+    if (result != 0) {
+        plugin_logger_error(&g_logger, "Failed to load config file (error %d)", result);
+        return -1;
+    }
+
+    memset(g_nodes, 0, sizeof(g_nodes));
+    g_num_devices = 0;
+    for (int i = 0; i < g_config.num_devices; i++) {
+        co_device_t *device = &g_devices[g_num_devices++];
+        setup_device(&g_config.devices[i], device);
+        g_nodes[device->config->node_id] = device;
+        plugin_logger_info(&g_logger, "[node %d] %d input group(s), %d output group(s), %d output byte(s)",
+                           device->config->node_id, device->num_inputs, device->num_outputs,
+                           device->config->tpdo_length);
+    }
+    setup_batches();
+    setup_changes();
+
+    g_initialized = true;
+    plugin_logger_info(&g_logger, "Configuration loaded successfully: %d node(s) on %s%s", g_num_devices,
+                       g_config.interface, g_config.enabled ? "" : " (CAN bus disabled)");
+    return 0;
+}
+
+/**
+ * @brief Start the CAN I/O thread
+ */
+void start_loop(void)
+{
+    if (!g_initialized) {
+        plugin_logger_error(&g_logger, "Cannot start - plugin not initialized");
+        return;
+    }
+
+    if (g_running) {
+        plugin_logger_warn(&g_logger, "Already running");
+        return;
+    }
+
+    if (!g_config.enabled || g_num_devices == 0) {
+        plugin_logger_info(&g_logger, "CAN bus disabled or no nodes configured, not started");
+        return;
+    }
+
+    g_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (g_stop_fd < 0) {
+        plugin_logger_error(&g_logger, "Failed to create stop event: %s", strerror(errno));
+        return;
+    }
+
+    for (int i = 0; i < g_num_devices; i++) {
+        g_devices[i].input_seen = false;
+        g_devices[i].output_sent = false;
+        g_devices[i].output_pending = false;
+    }
+
+    g_running = true;
+    if (pthread_create(&g_thread, NULL, io_thread, NULL) != 0) {
+        plugin_logger_error(&g_logger, "Failed to create I/O thread");
+        g_running = false;
+        close(g_stop_fd);
+        g_stop_fd = -1;
+        return;
+    }
+    g_thread_started = true;
+    plugin_logger_info(&g_logger, "Started on %s", g_config.interface);
+}
+
+/**
+ * @brief Stop the CAN I/O thread
+ */
+void stop_loop(void)
+{
+    if (!g_running) {
+        plugin_logger_debug(&g_logger, "Already stopped");
+        return;
+    }
+
+    g_running = false;
+    uint64_t one = 1;
+    if (write(g_stop_fd, &one, sizeof(one)) < 0) {
+        plugin_logger_warn(&g_logger, "Failed to signal stop event: %s", strerror(errno));
+    }
+
+    if (g_thread_started) {
+        pthread_join(g_thread, NULL);
+        g_thread_started = false;
+    }
+    close(g_stop_fd);
+    g_stop_fd = -1;
+    plugin_logger_info(&g_logger, "Main loop stopped");
+}
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void)
+{
+    if (g_running) {
+        stop_loop();
+    }
+
+    memset(g_nodes, 0, sizeof(g_nodes));
+    g_num_devices = 0;
+    free(g_changes);
+    g_changes = NULL;
+    g_changes_count = 0;
+    g_initialized = false;
+    plugin_logger_info(&g_logger, "CANopen master plugin cleanup complete");
+}
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ */
+void cycle_start(void)
+{
+    /* Received inputs are applied by the journal */
+}
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Runs with the OpenPLC mutex held, after the runtime refreshed its packed
+ * output area.
+ */
+void cycle_end(void)
+{
+    if (!g_running || g_socket < 0) {
+        return;
+    }
+
+    int area_length = 0;
+    const uint8_t *area = NULL;
+    if (g_runtime_args.get_image_area != NULL) {
+        area = (const uint8_t *)g_runtime_args.get_image_area(CO_TYPE_BOOL_OUTPUT, &area_length);
+    }
+
+    /* Every bit is set after missed scans, and no change bits means rebuild all */
+    bool have_changes = g_changes_count > 0 &&
+                        g_runtime_args.read_image_changes(CO_TYPE_BOOL_OUTPUT, g_changes_first, g_changes_count,
+                                                          NULL, g_changes, &g_changes_generation) == g_changes_count;
+
+    uint64_t now = now_ms();
+    int count = 0;
+    for (int i = 0; i < g_num_devices; i++) {
+        co_device_t *device = &g_devices[i];
+        if (device->num_outputs == 0) {
+            continue;
+        }
+
+        bool refresh_due = g_config.tpdo_refresh_ms != 0 &&
+                           now - device->last_output_ms >= (uint64_t)g_config.tpdo_refresh_ms;
+        if (have_changes && device->output_sent && !device->output_pending && !refresh_due) {
+            uint64_t changed = 0;
+            for (int r = 0; r < device->num_outputs; r++) {
+                changed |= load_packed_run(&device->outputs[r], g_changes, g_changes_first);
+            }
+            if (changed == 0) {
+                continue;
+            }
+        }
+
+        uint64_t payload = 0;
+        for (int r = 0; r < device->num_outputs; r++) {
+            payload |= load_output_run(&device->outputs[r], area, area_length);
+        }
+
+        /* Unchanged outputs are resent every tpdo_refresh_ms, never if 0 */
+        if (device->output_sent && payload == device->last_output && !refresh_due) {
+            device->output_pending = false;
+            continue;
+        }
+
+        struct can_frame *frame = &g_tx_frames[count];
+        memset(frame, 0, sizeof(struct can_frame));
+        frame->can_id = (canid_t)(CO_COB_RPDO1 + device->config->node_id);
+        frame->can_dlc = (uint8_t)device->config->tpdo_length;
+        for (int b = 0; b < device->config->tpdo_length; b++) {
+            frame->data[b] = (uint8_t)(payload >> (8 * b));
+        }
+        g_tx_devices[count] = device;
+        g_tx_payloads[count] = payload;
+        device->output_pending = true;
+        count++;
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    /* Never block the scan: PDOs the queue cannot take are retried next scan */
+    int sent = sendmmsg(g_socket, g_tx_msgs, (unsigned int)count, MSG_DONTWAIT);
+    if (sent < 0) {
+        plugin_logger_warn_limited(&g_logger, "Cannot send output PDOs on %s: %s", g_config.interface,
+                                   strerror(errno));
+        return;
+    }
+    for (int i = 0; i < sent; i++) {
+        g_tx_devices[i]->output_sent = true;
+        g_tx_devices[i]->output_pending = false;
+        g_tx_devices[i]->last_output = g_tx_payloads[i];
+        g_tx_devices[i]->last_output_ms = now;
+    }
+    if (sent < count) {
+        plugin_logger_warn_limited(&g_logger, "%d of %d output PDOs not sent, CAN transmit queue full",
+                                   count - sent, count);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file canopen_master_plugin.h
+ * @brief Native CANopen Master Plugin for OpenPLC Runtime v4
+ *
+ * This plugin exchanges the digital I/O of CANopen nodes over SocketCAN,
+ * configured with the same canbus_conf.json file as the Python
+ * canbus_master plugin. Input PDOs are journaled as they arrive and output
+ * PDOs are sent at the end of every PLC scan.
+ */
+
+#ifndef CANOPEN_MASTER_PLUGIN_H
+#define CANOPEN_MASTER_PLUGIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the CANopen master plugin
+ *
+ * Called when the plugin is loaded. Parses the node list and compiles the
+ * io_groups of every node into bit-copy tables.
+ *
+ * @param args Pointer to plugin_runtime_args_t containing runtime buffers,
+ *             mutex functions, and logging function pointers
+ * @return 0 on success, -1 on failure
+ */
+int init(void *args);
+
+/**
+ * @brief Start the CAN I/O thread
+ *
+ * The thread opens the CAN interface (retrying with backoff until it
+ * exists) and journals the input PDOs it receives.
+ */
+void start_loop(void);
+
+/**
+ * @brief Stop the CAN I/O thread and close the interface
+ */
+void stop_loop(void);
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void);
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ *
+ * Nothing to do: received inputs reach the image tables through the journal.
+ */
+void cycle_start(void);
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Sends the output PDO of every node whose outputs changed this scan or
+ * were last sent tpdo_refresh_ms ago.
+ */
+void cycle_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CANOPEN_MASTER_PLUGIN_H */
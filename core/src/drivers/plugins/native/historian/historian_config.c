@@ -0,0 +1,307 @@
+/**
+ * @file historian_config.c
+ * @brief Historian Plugin Configuration Parser Implementation
+ *
+ * Parses JSON configuration files using cJSON library.
+ */
+
+#include "historian_config.h"
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Error codes */
+#define HISTORIAN_CONFIG_OK              0
+#define HISTORIAN_CONFIG_ERR_FILE       -1
+#define HISTORIAN_CONFIG_ERR_PARSE      -2
+#define HISTORIAN_CONFIG_ERR_INVALID    -4
+
+/* Journal buffer types (matching journal_buffer_type_t), -1 where the area
+ * has no such width */
+static const int g_buffer_types[5][3] = {
+    /*  I   Q   M */
+    {   0,  1,  2 },                /* X */
+    {   3,  4, -1 },                /* B */
+    {   5,  6,  7 },                /* W */
+    {   8,  9, 10 },                /* D */
+    {  11, 12, 13 },                /* L */
+};
+
+/**
+ * @brief Read entire file into a string
+ */
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size > 1024 * 1024) { /* Max 1MB config file */
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    fclose(fp);
+
+    if ((long)read_size != size) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[size] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Safely copy string with length limit
+ *
+ * @return false if `src` was truncated
+ */
+static bool safe_strcpy(char *dest, const char *src, size_t max_len)
+{
+    if (src == NULL) {
+        dest[0] = '\0';
+        return true;
+    }
+    strncpy(dest, src, max_len - 1);
+    dest[max_len - 1] = '\0';
+    return strlen(src) < max_len;
+}
+
+/**
+ * @brief Get string value from JSON object
+ */
+static const char *get_string(const cJSON *obj, const char *key, const char *default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring != NULL) {
+        return item->valuestring;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get integer value from JSON object
+ */
+static int get_int(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) {
+        return item->valueint;
+    }
+    return default_val;
+}
+
+int historian_parse_address(const char *address, historian_tag_t *tag)
+{
+    static const char areas[] = "IQM";
+    static const char sizes[] = "XBWDL";
+
+    if (address == NULL) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    while (isspace((unsigned char)*address)) {
+        address++;
+    }
+    if (address[0] != '%' || address[1] == '\0' || address[2] == '\0') {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    const char *area = strchr(areas, toupper((unsigned char)address[1]));
+    const char *size = strchr(sizes, toupper((unsigned char)address[2]));
+    if (area == NULL || size == NULL || !isdigit((unsigned char)address[3])) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    char *end = NULL;
+    long index = strtol(address + 3, &end, 10);
+    long bit = 0;
+    if (*size == 'X') {
+        if (*end != '.' || !isdigit((unsigned char)end[1])) {
+            return HISTORIAN_CONFIG_ERR_INVALID;
+        }
+        bit = strtol(end + 1, &end, 10);
+    }
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0' || index > 0xFFFF || bit > 7) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    int buffer_type = g_buffer_types[size - sizes][area - areas];
+    if (buffer_type < 0) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    tag->type = (historian_tag_type_t)(size - sizes);
+    tag->buffer_type = buffer_type;
+    tag->index = (int)index;
+    tag->bit = (int)bit;
+    return HISTORIAN_CONFIG_OK;
+}
+
+/**
+ * @brief Tag names are words of the query command and strings of its JSON reply
+ */
+static bool valid_name(const char *name)
+{
+    if (name[0] == '\0') {
+        return false;
+    }
+    for (; *name != '\0'; name++) {
+        if (!isgraph((unsigned char)*name) || *name == '"' || *name == '\\') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Parse one entry of tags
+ */
+static int parse_tag(const cJSON *json, historian_tag_t *tag)
+{
+    const char *address = get_string(json, "address", NULL);
+
+    if (!safe_strcpy(tag->name, get_string(json, "name", NULL), HISTORIAN_MAX_NAME_LEN) ||
+        !safe_strcpy(tag->address, address, sizeof(tag->address))) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    /* Unnamed tags are queried by their address */
+    if (tag->name[0] == '\0') {
+        safe_strcpy(tag->name, tag->address, HISTORIAN_MAX_NAME_LEN);
+    }
+
+    const char *format = get_string(json, "format", "unsigned");
+    if (strcmp(format, "unsigned") == 0) {
+        tag->format = HISTORIAN_FORMAT_UNSIGNED;
+    } else if (strcmp(format, "signed") == 0) {
+        tag->format = HISTORIAN_FORMAT_SIGNED;
+    } else if (strcmp(format, "real") == 0) {
+        tag->format = HISTORIAN_FORMAT_REAL;
+    } else {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    return historian_parse_address(address, tag);
+}
+
+int historian_config_parse(const char *config_path, historian_config_t *config)
+{
+    if (config_path == NULL || config == NULL) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    memset(config, 0, sizeof(historian_config_t));
+
+    /* Read file contents */
+    char *json_str = read_file(config_path);
+    if (json_str == NULL) {
+        return HISTORIAN_CONFIG_ERR_FILE;
+    }
+
+    /* Parse JSON */
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+
+    if (root == NULL) {
+        return HISTORIAN_CONFIG_ERR_PARSE;
+    }
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    if (!safe_strcpy(config->data_dir, get_string(root, "data_dir", HISTORIAN_DEFAULT_DATA_DIR),
+                     HISTORIAN_MAX_PATH_LEN)) {
+        cJSON_Delete(root);
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    config->segment_size_kb = get_int(root, "segment_size_kb", HISTORIAN_DEFAULT_SEGMENT_KB);
+    config->max_segments = get_int(root, "max_segments", HISTORIAN_DEFAULT_MAX_SEGMENTS);
+    config->ring_size = get_int(root, "ring_size", HISTORIAN_DEFAULT_RING_SIZE);
+    config->flush_interval_ms = get_int(root, "flush_interval_ms", HISTORIAN_DEFAULT_FLUSH_INTERVAL_MS);
+
+    const cJSON *tags = cJSON_GetObjectItemCaseSensitive(root, "tags");
+    if (cJSON_IsArray(tags) && cJSON_GetArraySize(tags) > HISTORIAN_MAX_TAGS) {
+        cJSON_Delete(root);
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    /* Parse each tag */
+    const cJSON *tag = NULL;
+    cJSON_ArrayForEach(tag, tags) {
+        int result = parse_tag(tag, &config->tags[config->num_tags]);
+        config->num_tags++;
+        if (result != HISTORIAN_CONFIG_OK) {
+            cJSON_Delete(root);
+            return result;
+        }
+    }
+
+    cJSON_Delete(root);
+
+    /* Validate the parsed configuration */
+    return historian_config_validate(config);
+}
+
+int historian_config_validate(const historian_config_t *config)
+{
+    if (config == NULL) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    if (config->data_dir[0] == '\0') {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    if (config->segment_size_kb < HISTORIAN_MIN_SEGMENT_KB ||
+        config->segment_size_kb > HISTORIAN_MAX_SEGMENT_KB) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    if (config->max_segments < 2 || config->max_segments > HISTORIAN_MAX_SEGMENTS) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    /* The queue is indexed with a mask */
+    if (config->ring_size < HISTORIAN_MIN_RING_SIZE || config->ring_size > HISTORIAN_MAX_RING_SIZE ||
+        (config->ring_size & (config->ring_size - 1)) != 0) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+    if (config->flush_interval_ms < 1 || config->flush_interval_ms > 10000) {
+        return HISTORIAN_CONFIG_ERR_INVALID;
+    }
+
+    for (int i = 0; i < config->num_tags; i++) {
+        const historian_tag_t *tag = &config->tags[i];
+        if (!valid_name(tag->name)) {
+            return HISTORIAN_CONFIG_ERR_INVALID;
+        }
+        if (tag->format == HISTORIAN_FORMAT_REAL && tag->type != HISTORIAN_TAG_DWORD &&
+            tag->type != HISTORIAN_TAG_LWORD) {
+            return HISTORIAN_CONFIG_ERR_INVALID;
+        }
+
+        /* Tag names must be unique, they are what queries ask for */
+        for (int j = 0; j < i; j++) {
+            if (strcmp(config->tags[i].name, config->tags[j].name) == 0) {
+                return HISTORIAN_CONFIG_ERR_INVALID;
+            }
+        }
+    }
+
+    return HISTORIAN_CONFIG_OK;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file historian_config.h
+ * @brief Historian Plugin Configuration Structures and Parser
+ *
+ * Lists the tags to record (a name and an IEC located address each), where
+ * the segment files go and how much of them is kept.
+ */
+
+#ifndef HISTORIAN_CONFIG_H
+#define HISTORIAN_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configuration limits */
+#define HISTORIAN_MAX_TAGS              256
+#define HISTORIAN_MAX_NAME_LEN          40      /* Tag name, including the NUL */
+#define HISTORIAN_MAX_PATH_LEN          256
+#define HISTORIAN_MIN_SEGMENT_KB        64
+#define HISTORIAN_MAX_SEGMENT_KB        (1024 * 1024)
+#define HISTORIAN_MAX_SEGMENTS          4096
+#define HISTORIAN_MIN_RING_SIZE         256
+#define HISTORIAN_MAX_RING_SIZE         (1 << 24)
+
+/* Default values */
+#define HISTORIAN_DEFAULT_DATA_DIR          "./historian"
+#define HISTORIAN_DEFAULT_SEGMENT_KB        4096
+#define HISTORIAN_DEFAULT_MAX_SEGMENTS      16
+#define HISTORIAN_DEFAULT_RING_SIZE         65536
+#define HISTORIAN_DEFAULT_FLUSH_INTERVAL_MS 50
+
+/**
+ * @brief Width of a tag's value, from the size letter of its address
+ */
+typedef enum {
+    HISTORIAN_TAG_BOOL = 0,         /* X */
+    HISTORIAN_TAG_BYTE,             /* B */
+    HISTORIAN_TAG_WORD,             /* W */
+    HISTORIAN_TAG_DWORD,            /* D */
+    HISTORIAN_TAG_LWORD             /* L */
+} historian_tag_type_t;
+
+/**
+ * @brief How queries print a tag's values (the stored bits are the same)
+ */
+typedef enum {
+    HISTORIAN_FORMAT_UNSIGNED = 0,
+    HISTORIAN_FORMAT_SIGNED,        /* INT, DINT, LINT */
+    HISTORIAN_FORMAT_REAL           /* REAL (D) or LREAL (L) */
+} historian_value_format_t;
+
+/**
+ * @brief One recorded variable
+ */
+typedef struct {
+    char name[HISTORIAN_MAX_NAME_LEN];
+    char address[16];               /* As configured, "%QW10" */
+    historian_tag_type_t type;
+    historian_value_format_t format;
+    int buffer_type;                /* Journal buffer type of the area */
+    int index;                      /* Image table index */
+    int bit;                        /* Bit of index, BOOL only */
+} historian_tag_t;
+
+/**
+ * @brief Complete historian configuration
+ */
+typedef struct {
+    char data_dir[HISTORIAN_MAX_PATH_LEN];
+    int segment_size_kb;            /* Size of one segment file */
+    int max_segments;               /* Oldest segments beyond this are deleted */
+    int ring_size;                  /* Samples queued between the scan and the writer */
+    int flush_interval_ms;          /* How often the writer drains the queue */
+    historian_tag_t tags[HISTORIAN_MAX_TAGS];
+    int num_tags;
+} historian_config_t;
+
+/**
+ * @brief Parse configuration from JSON file
+ *
+ * @param config_path Path to the JSON configuration file
+ * @param config Pointer to configuration structure to populate
+ * @return 0 on success, negative error code on failure
+ */
+int historian_config_parse(const char *config_path, historian_config_t *config);
+
+/**
+ * @brief Validate configuration values
+ *
+ * @param config Pointer to configuration structure to validate
+ * @return 0 if valid, negative error code indicating the issue
+ */
+int historian_config_validate(const historian_config_t *config);
+
+/**
+ * @brief Parse an IEC located address into a tag ("%IX0.3", "%QW10", "%MD4")
+ *
+ * Sets type, buffer_type, index and bit of `tag`.
+ *
+ * @return 0 on success, negative error code if the address is not recordable
+ */
+int historian_parse_address(const char *address, historian_tag_t *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORIAN_CONFIG_H */
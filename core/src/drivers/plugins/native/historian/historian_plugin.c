@@ -0,0 +1,818 @@
+/**
+ * @file historian_plugin.c
+ * @brief Native Tag Historian Plugin Implementation
+ *
+ * The work is split so the scan never waits on storage:
+ * - cycle_end reads the change bits of every image area that has tags with
+ *   read_image_changes (a lock-free read of the snapshot of the scan) and
+ *   queues a timestamped sample for each tag whose value changed, into a
+ *   single-producer ring allocated at init.
+ * - The writer thread drains the ring every flush_interval_ms into the
+ *   memory-mapped segment of historian_store.c, which encodes, rotates and
+ *   answers queries.
+ * - handle_command answers the PLUGIN:<name>:... socket commands on the
+ *   runtime's socket thread.
+ */
+
+#define _GNU_SOURCE
+
+#include "historian_plugin.h"
+#include "historian_config.h"
+#include "historian_store.h"
+#include "plugin_logger.h"
+#include "plugin_types.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Journal buffer types (matching journal_buffer_type_t) */
+#define HIST_NUM_BUFFER_TYPES   14
+
+/* Room kept at the end of a query response for its closing fields */
+#define HIST_RESPONSE_TAIL      64
+
+/**
+ * @brief The window of one image area covering its tags
+ *
+ * Tags of the area are g_area_tags[first_tag .. first_tag + num_tags).
+ */
+typedef struct {
+    int type;                       /* Journal buffer type */
+    int width;                      /* Bytes per element, BOOL areas packed 1 */
+    bool is_bool;
+    int first;                      /* First image table index read */
+    int count;
+    uint8_t *values;
+    uint8_t *changes;
+    unsigned int generation;
+    int first_tag;
+    int num_tags;
+} hist_area_t;
+
+/* Scan side state of one tag */
+typedef struct {
+    uint64_t last_value;            /* Last queued value */
+    bool recorded;                  /* last_value is valid */
+    bool pending;                   /* A change was dropped, check until queued */
+    bool enabled;                   /* Within the image tables */
+} hist_tag_state_t;
+
+/* Plugin state */
+static plugin_logger_t g_logger;
+static plugin_runtime_args_t g_runtime_args;
+static historian_config_t g_config;
+static bool g_initialized = false;
+static volatile bool g_running = false;
+
+/* Commands run on the socket thread, init may replace the config meanwhile */
+static pthread_mutex_t g_command_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static hist_area_t g_areas[HIST_NUM_BUFFER_TYPES];
+static int g_num_areas = 0;
+static int g_area_tags[HISTORIAN_MAX_TAGS];
+static hist_tag_state_t g_tags[HISTORIAN_MAX_TAGS];
+
+/* Sample queue: cycle_end produces at g_head, the writer consumes at g_tail */
+static historian_sample_t *g_ring = NULL;
+static size_t g_ring_size = 0;
+static atomic_size_t g_head;
+static atomic_size_t g_tail;
+static atomic_bool g_recording;
+static atomic_int g_producing;      /* cycle_end is queueing samples */
+static atomic_ullong g_dropped;     /* Changes the full queue could not take */
+static atomic_ullong g_lost;        /* Samples the store could not write */
+
+/* Writer thread */
+static int g_stop_fd = -1;
+static pthread_t g_thread;
+static bool g_thread_started = false;
+
+/* Metric handles, -1 if not registered */
+static int g_metric_samples = -1;
+static int g_metric_dropped = -1;
+
+static const char *const g_type_names[] = { "BOOL", "BYTE", "WORD", "DWORD", "LWORD" };
+static const char *const g_format_names[] = { "unsigned", "signed", "real" };
+
+/*
+ * =============================================================================
+ * Runtime Metrics
+ * =============================================================================
+ */
+
+static void register_metrics(void)
+{
+    if (g_runtime_args.metric_register == NULL || g_runtime_args.metric_add == NULL) {
+        return;
+    }
+    g_metric_samples = g_runtime_args.metric_register(g_runtime_args.plugin_id, "historian_samples",
+                                                      "Samples written to the historian",
+                                                      PLUGIN_METRIC_COUNTER);
+    g_metric_dropped = g_runtime_args.metric_register(g_runtime_args.plugin_id, "historian_dropped",
+                                                      "Tag changes the historian could not record",
+                                                      PLUGIN_METRIC_COUNTER);
+}
+
+static void metric_add(int handle, long long delta)
+{
+    if (handle >= 0 && delta != 0) {
+        g_runtime_args.metric_add(handle, delta);
+    }
+}
+
+/*
+ * =============================================================================
+ * Scan Side
+ * =============================================================================
+ */
+
+static uint64_t load_value(const hist_area_t *area, int k, int bit)
+{
+    const uint8_t *value = area->values + (size_t)k * (size_t)area->width;
+
+    if (area->is_bool) {
+        return (uint64_t)((*value >> bit) & 1);
+    }
+    switch (area->width) {
+    case 1:
+        return *value;
+    case 2: {
+        uint16_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    case 4: {
+        uint32_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    default: {
+        uint64_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    }
+}
+
+static bool tag_changed(const hist_area_t *area, int k, int bit)
+{
+    if (area->is_bool) {
+        return (area->changes[k] >> bit) & 1;
+    }
+    return (area->changes[k / 8] >> (k % 8)) & 1;
+}
+
+/*
+ * =============================================================================
+ * Writer Thread
+ * =============================================================================
+ */
+
+/**
+ * @brief Sleep `ms` milliseconds or until the plugin is stopped
+ *
+ * @return false if the plugin is stopping
+ */
+static bool wait_ms(int ms)
+{
+    struct pollfd pfd;
+    pfd.fd = g_stop_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    while (poll(&pfd, 1, ms) < 0 && errno == EINTR) {
+    }
+    return g_running;
+}
+
+/**
+ * @brief Store the queued samples, in at most two contiguous runs of the ring
+ */
+static void drain(void)
+{
+    size_t tail = atomic_load_explicit(&g_tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&g_head, memory_order_acquire);
+
+    while (tail != head) {
+        size_t offset = tail & (g_ring_size - 1);
+        size_t count = head - tail;
+        if (count > g_ring_size - offset) {
+            count = g_ring_size - offset;
+        }
+
+        size_t stored = historian_store_append(&g_ring[offset], count);
+        if (stored < count) {
+            atomic_fetch_add_explicit(&g_lost, count - stored, memory_order_relaxed);
+            metric_add(g_metric_dropped, (long long)(count - stored));
+            plugin_logger_error_limited(&g_logger, "Cannot write segment in %s: %s, %zu sample(s) lost",
+                                        g_config.data_dir, strerror(errno), count - stored);
+        }
+        metric_add(g_metric_samples, (long long)stored);
+
+        tail += count;
+        atomic_store_explicit(&g_tail, tail, memory_order_release);
+    }
+}
+
+static void *writer_thread(void *arg)
+{
+    (void)arg;
+    bool running = true;
+
+    plugin_logger_info(&g_logger, "Writer thread started");
+    while (running) {
+        running = wait_ms(g_config.flush_interval_ms);
+        drain();
+    }
+    plugin_logger_info(&g_logger, "Writer thread finished");
+    return NULL;
+}
+
+/*
+ * =============================================================================
+ * Setup
+ * =============================================================================
+ */
+
+static void free_buffers(void)
+{
+    for (int i = 0; i < g_num_areas; i++) {
+        free(g_areas[i].values);
+        free(g_areas[i].changes);
+    }
+    memset(g_areas, 0, sizeof(g_areas));
+    g_num_areas = 0;
+    free(g_ring);
+    g_ring = NULL;
+    g_ring_size = 0;
+}
+
+static int area_width(int type)
+{
+    if (type <= 4) {
+        return 1;                   /* BOOL (packed) and BYTE */
+    }
+    if (type <= 7) {
+        return 2;
+    }
+    return type <= 10 ? 4 : 8;
+}
+
+/**
+ * @brief Group the tags by image area and allocate the window of every area
+ *
+ * Tags beyond the image tables are logged and not recorded.
+ */
+static int setup_areas(void)
+{
+    int next_tag = 0;
+
+    for (int type = 0; type < HIST_NUM_BUFFER_TYPES; type++) {
+        hist_area_t *area = &g_areas[g_num_areas];
+        int first = -1;
+        int end = 0;
+
+        area->first_tag = next_tag;
+        for (int i = 0; i < g_config.num_tags; i++) {
+            const historian_tag_t *tag = &g_config.tags[i];
+            if (tag->buffer_type != type) {
+                continue;
+            }
+            if (tag->index >= g_runtime_args.buffer_size) {
+                plugin_logger_error(&g_logger, "[%s] %s exceeds the image table, tag ignored", tag->name,
+                                    tag->address);
+                continue;
+            }
+            g_tags[i].enabled = true;
+            g_area_tags[next_tag++] = i;
+            if (first < 0 || tag->index < first) {
+                first = tag->index;
+            }
+            if (tag->index + 1 > end) {
+                end = tag->index + 1;
+            }
+        }
+        if (first < 0) {
+            continue;
+        }
+
+        area->type = type;
+        area->is_bool = type <= 2;
+        area->width = area_width(type);
+        area->first = first;
+        area->count = end - first;
+        area->num_tags = next_tag - area->first_tag;
+        area->values = malloc((size_t)area->count * (size_t)area->width);
+        area->changes = malloc(area->is_bool ? (size_t)area->count : ((size_t)area->count + 7) / 8);
+        g_num_areas++;
+        if (area->values == NULL || area->changes == NULL) {
+            return -1;
+        }
+    }
+
+    g_ring_size = (size_t)g_config.ring_size;
+    g_ring = calloc(g_ring_size, sizeof(historian_sample_t));
+    return g_ring != NULL ? 0 : -1;
+}
+
+/*
+ * =============================================================================
+ * Socket Commands
+ * =============================================================================
+ */
+
+typedef struct {
+    char *buffer;
+    size_t size;
+    size_t length;
+} hist_output_t;
+
+static bool output_append(hist_output_t *out, const char *fmt, ...)
+{
+    if (out->length >= out->size) {
+        return false;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out->buffer + out->length, out->size - out->length, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= out->size - out->length) {
+        out->buffer[out->length] = '\0';
+        return false;
+    }
+    out->length += (size_t)n;
+    return true;
+}
+
+typedef struct {
+    hist_output_t out;
+    historian_tag_type_t type;
+    historian_value_format_t format;
+    long limit;                     /* 0 = as many as fit */
+    long count;
+    bool more;
+    uint64_t next;
+} hist_query_ctx_t;
+
+/**
+ * @brief Print a raw value as the tag's format says
+ */
+static void format_value(char *text, size_t size, uint64_t value, historian_tag_type_t type,
+                         historian_value_format_t format)
+{
+    static const int widths[] = { 1, 8, 16, 32, 64 };
+    int width = widths[type];
+
+    if (format == HISTORIAN_FORMAT_SIGNED && width < 64) {
+        uint64_t sign = 1ull << (width - 1);
+        snprintf(text, size, "%" PRId64, (int64_t)((value ^ sign) - sign));
+    } else if (format == HISTORIAN_FORMAT_SIGNED) {
+        snprintf(text, size, "%" PRId64, (int64_t)value);
+    } else if (format == HISTORIAN_FORMAT_REAL) {
+        double number;
+        if (width == 32) {
+            uint32_t bits = (uint32_t)value;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            number = f;
+        } else {
+            memcpy(&number, &value, sizeof(number));
+        }
+        if (isfinite(number)) {
+            snprintf(text, size, width == 32 ? "%.9g" : "%.17g", number);
+        } else {
+            snprintf(text, size, "null");  /* JSON has no NaN or infinity */
+        }
+    } else {
+        snprintf(text, size, "%" PRIu64, value);
+    }
+}
+
+static bool query_sample(void *arg, uint64_t timestamp, uint64_t value)
+{
+    hist_query_ctx_t *query = (hist_query_ctx_t *)arg;
+    char text[32];
+
+    if (query->limit > 0 && query->count >= query->limit) {
+        query->more = true;
+        query->next = timestamp;
+        return false;
+    }
+
+    format_value(text, sizeof(text), value, query->type, query->format);
+    size_t saved = query->out.length;
+    if (!output_append(&query->out, "%s[%" PRIu64 ",%s]", query->count > 0 ? "," : "", timestamp, text)) {
+        query->out.length = saved;
+        query->out.buffer[saved] = '\0';
+        query->more = true;
+        query->next = timestamp;
+        return false;
+    }
+    query->count++;
+    return true;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief A query time: nanoseconds since the epoch, or before now if negative
+ */
+static bool parse_time(const char *text, uint64_t *time)
+{
+    char *end = NULL;
+    errno = 0;
+    if (text[0] == '-') {
+        unsigned long long ago = strtoull(text + 1, &end, 10);
+        uint64_t now = now_ns();
+        *time = ago < now ? now - ago : 0;
+    } else {
+        *time = strtoull(text, &end, 10);
+    }
+    return end != text && *end == '\0' && errno == 0;
+}
+
+static const historian_tag_t *find_tag(const char *name)
+{
+    for (int i = 0; i < g_config.num_tags; i++) {
+        if (strcmp(g_config.tags[i].name, name) == 0) {
+            return &g_config.tags[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief QUERY <tag> [<from_ns> [<to_ns> [<limit>]]]
+ *
+ * Tags no longer configured are still found in the segments recorded while
+ * they were, printed as unsigned.
+ */
+static void command_query(char *args, char *response, size_t response_size)
+{
+    char *save = NULL;
+    char *name = strtok_r(args, " ", &save);
+    char *from_text = strtok_r(NULL, " ", &save);
+    char *to_text = strtok_r(NULL, " ", &save);
+    char *limit_text = strtok_r(NULL, " ", &save);
+    uint64_t from = 0;
+    uint64_t to = UINT64_MAX;
+
+    if (name == NULL || (from_text != NULL && !parse_time(from_text, &from)) ||
+        (to_text != NULL && !parse_time(to_text, &to)) || response_size <= HIST_RESPONSE_TAIL) {
+        snprintf(response, response_size, "PLUGIN:ERROR_PARSING\n");
+        return;
+    }
+
+    hist_query_ctx_t query;
+    memset(&query, 0, sizeof(query));
+    query.limit = limit_text != NULL ? strtol(limit_text, NULL, 10) : 0;
+    const historian_tag_t *tag = find_tag(name);
+    if (tag != NULL) {
+        query.type = tag->type;
+        query.format = tag->format;
+    } else {
+        query.type = HISTORIAN_TAG_LWORD;
+    }
+
+    query.out.buffer = response;
+    query.out.size = response_size - HIST_RESPONSE_TAIL;
+    if (!output_append(&query.out, "{\"tag\":\"%s\",\"samples\":[", name)) {
+        snprintf(response, response_size, "PLUGIN:ERROR_PARSING\n");
+        return;
+    }
+
+    if (historian_store_query(name, from, to, query_sample, &query) < 0) {
+        snprintf(response, response_size, "PLUGIN:ERROR_NOT_OPEN\n");
+        return;
+    }
+
+    query.out.size = response_size;
+    if (query.more) {
+        output_append(&query.out, "],\"count\":%ld,\"more\":true,\"next\":%" PRIu64 "}\n", query.count,
+                      query.next);
+    } else {
+        output_append(&query.out, "],\"count\":%ld,\"more\":false}\n", query.count);
+    }
+}
+
+static void command_tags(char *response, size_t response_size)
+{
+    hist_output_t out = { response, response_size, 0 };
+    bool ok = output_append(&out, "{\"tags\":[");
+
+    for (int i = 0; ok && i < g_config.num_tags; i++) {
+        const historian_tag_t *tag = &g_config.tags[i];
+        ok = output_append(&out, "%s{\"name\":\"%s\",\"address\":\"%s\",\"type\":\"%s\",\"format\":\"%s\"%s}",
+                           i == 0 ? "" : ",", tag->name, tag->address, g_type_names[tag->type],
+                           g_format_names[tag->format], g_tags[i].enabled ? "" : ",\"ignored\":true");
+    }
+    if (!ok || !output_append(&out, "]}\n")) {
+        snprintf(response, response_size, "PLUGIN:ERROR_TOO_LARGE\n");
+    }
+}
+
+static void command_stats(char *response, size_t response_size)
+{
+    historian_store_stats_t stats;
+    historian_store_get_stats(&stats);
+
+    size_t head = atomic_load_explicit(&g_head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&g_tail, memory_order_acquire);
+    snprintf(response, response_size,
+             "{\"recording\":%s,\"tags\":%d,\"samples\":%" PRIu64 ",\"bytes\":%" PRIu64
+             ",\"queued\":%zu,\"dropped\":%llu,\"lost\":%llu,\"segments\":%d,\"sequence\":%" PRIu64
+             ",\"blocks_used\":%d,\"num_blocks\":%d}\n",
+             atomic_load(&g_recording) ? "true" : "false", g_config.num_tags, stats.samples, stats.bytes,
+             head - tail, (unsigned long long)atomic_load(&g_dropped),
+             (unsigned long long)atomic_load(&g_lost), stats.segments, stats.sequence, stats.blocks_used,
+             stats.num_blocks);
+}
+
+/*
+ * =============================================================================
+ * Plugin Lifecycle Functions
+ * =============================================================================
+ */
+
+/**
+ * @brief Initialize the historian plugin
+ */
+int init(void *args)
+{
+    /* Initialize logger first (before we have runtime_args) */
+    plugin_logger_init(&g_logger, "HISTORIAN", NULL);
+    plugin_logger_info(&g_logger, "Initializing historian plugin...");
+
+    if (!args) {
+        plugin_logger_error(&g_logger, "init args is NULL");
+        return -1;
+    }
+
+    /* Copy runtime args (critical - pointer is freed after init returns) */
+    memcpy(&g_runtime_args, args, sizeof(plugin_runtime_args_t));
+
+    /* Re-initialize logger with runtime_args for central logging */
+    plugin_logger_init(&g_logger, "HISTORIAN", args);
+
+    if (g_runtime_args.read_image_changes == NULL) {
+        plugin_logger_error(&g_logger, "The runtime does not provide change-of-value reads");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_command_lock);
+    g_initialized = false;
+    historian_store_close();
+    free_buffers();
+    memset(g_tags, 0, sizeof(g_tags));
+
+    const char *config_path = g_runtime_args.plugin_specific_config_file_path;
+    plugin_logger_info(&g_logger, "Loading config: %s", config_path);
+    int result = historian_config_parse(config_path, &g_config);
+    if (result != 0) {
+        pthread_mutex_unlock(&g_command_lock);
+        plugin_logger_error(&g_logger, "Failed to load config file (error %d)", result);
+        return -1;
+    }
+
+    if (setup_areas() != 0) {
+        free_buffers();
+        pthread_mutex_unlock(&g_command_lock);
+        plugin_logger_error(&g_logger, "Failed to allocate the sample buffers");
+        return -1;
+    }
+    if (historian_store_open(&g_config) != 0) {
+        int saved = errno;
+        free_buffers();
+        pthread_mutex_unlock(&g_command_lock);
+        plugin_logger_error(&g_logger, "Cannot open the data directory %s: %s", g_config.data_dir,
+                            strerror(saved));
+        return -1;
+    }
+    g_initialized = true;
+    pthread_mutex_unlock(&g_command_lock);
+
+    register_metrics();
+    plugin_logger_info(&g_logger, "Configuration loaded successfully: %d tag(s) in %d area(s), %s, "
+                       "%d KiB segments, %d kept",
+                       g_config.num_tags, g_num_areas, g_config.data_dir, g_config.segment_size_kb,
+                       g_config.max_segments);
+    return 0;
+}
+
+/**
+ * @brief Start recording and the writer thread
+ */
+void start_loop(void)
+{
+    if (!g_initialized) {
+        plugin_logger_error(&g_logger, "Cannot start - plugin not initialized");
+        return;
+    }
+
+    if (g_running) {
+        plugin_logger_warn(&g_logger, "Already running");
+        return;
+    }
+
+    g_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (g_stop_fd < 0) {
+        plugin_logger_error(&g_logger, "Failed to create stop event: %s", strerror(errno));
+        return;
+    }
+
+    /* Every tag is recorded with its current value first */
+    for (int i = 0; i < g_config.num_tags; i++) {
+        g_tags[i].recorded = false;
+        g_tags[i].pending = false;
+    }
+    for (int i = 0; i < g_num_areas; i++) {
+        g_areas[i].generation = 0;
+    }
+    atomic_store(&g_head, 0);
+    atomic_store(&g_tail, 0);
+
+    g_running = true;
+    if (pthread_create(&g_thread, NULL, writer_thread, NULL) != 0) {
+        plugin_logger_error(&g_logger, "Failed to create writer thread");
+        g_running = false;
+        close(g_stop_fd);
+        g_stop_fd = -1;
+        return;
+    }
+    g_thread_started = true;
+    atomic_store_explicit(&g_recording, true, memory_order_release);
+    plugin_logger_info(&g_logger, "Recording %d tag(s)", g_config.num_tags);
+}
+
+/**
+ * @brief Stop recording and the writer thread
+ */
+void stop_loop(void)
+{
+    if (!g_running) {
+        plugin_logger_debug(&g_logger, "Already stopped");
+        return;
+    }
+
+    /* No sample is queued after this, the writer stores the rest */
+    atomic_store_explicit(&g_recording, false, memory_order_release);
+    while (atomic_load_explicit(&g_producing, memory_order_acquire)) {
+        sched_yield();
+    }
+
+    g_running = false;
+    uint64_t one = 1;
+    if (write(g_stop_fd, &one, sizeof(one)) < 0) {
+        plugin_logger_warn(&g_logger, "Failed to signal stop event: %s", strerror(errno));
+    }
+
+    if (g_thread_started) {
+        pthread_join(g_thread, NULL);
+        g_thread_started = false;
+    }
+    close(g_stop_fd);
+    g_stop_fd = -1;
+    plugin_logger_info(&g_logger, "Main loop stopped");
+}
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void)
+{
+    if (g_running) {
+        stop_loop();
+    }
+
+    pthread_mutex_lock(&g_command_lock);
+    historian_store_close();
+    free_buffers();
+    g_initialized = false;
+    pthread_mutex_unlock(&g_command_lock);
+    plugin_logger_info(&g_logger, "Historian plugin cleanup complete");
+}
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ */
+void cycle_start(void)
+{
+    /* Tags are recorded at the end of the scan */
+}
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Also called outside a scan by the safe state, possibly from the watchdog
+ * thread; g_producing keeps a single producer on the ring.
+ */
+void cycle_end(void)
+{
+    if (!atomic_load_explicit(&g_recording, memory_order_acquire) ||
+        atomic_exchange_explicit(&g_producing, 1, memory_order_acquire) != 0) {
+        return;
+    }
+    if (!atomic_load_explicit(&g_recording, memory_order_acquire)) {
+        atomic_store_explicit(&g_producing, 0, memory_order_release);
+        return;
+    }
+
+    uint64_t timestamp = now_ns();
+    size_t head = atomic_load_explicit(&g_head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&g_tail, memory_order_acquire);
+    unsigned long long dropped = 0;
+
+    for (int a = 0; a < g_num_areas; a++) {
+        hist_area_t *area = &g_areas[a];
+
+        /* Every bit is set on the first read and after missed scans */
+        if (g_runtime_args.read_image_changes(area->type, area->first, area->count, area->values,
+                                              area->changes, &area->generation) != area->count) {
+            continue;
+        }
+
+        for (int t = 0; t < area->num_tags; t++) {
+            int i = g_area_tags[area->first_tag + t];
+            const historian_tag_t *tag = &g_config.tags[i];
+            hist_tag_state_t *state = &g_tags[i];
+            int k = tag->index - area->first;
+
+            if (!state->pending && !tag_changed(area, k, tag->bit)) {
+                continue;
+            }
+            uint64_t value = load_value(area, k, tag->bit);
+            if (state->recorded && value == state->last_value) {
+                state->pending = false;
+                continue;
+            }
+
+            /* Full: the value is queued once the writer made room */
+            if (head - tail >= g_ring_size) {
+                if (!state->pending) {
+                    dropped++;
+                }
+                state->pending = true;
+                continue;
+            }
+
+            historian_sample_t *sample = &g_ring[head & (g_ring_size - 1)];
+            sample->timestamp = timestamp;
+            sample->value = value;
+            sample->tag = (uint32_t)i;
+            head++;
+
+            state->last_value = value;
+            state->recorded = true;
+            state->pending = false;
+        }
+    }
+
+    atomic_store_explicit(&g_head, head, memory_order_release);
+    if (dropped > 0) {
+        atomic_fetch_add_explicit(&g_dropped, dropped, memory_order_relaxed);
+        metric_add(g_metric_dropped, (long long)dropped);
+    }
+    atomic_store_explicit(&g_producing, 0, memory_order_release);
+}
+
+/**
+ * @brief Answer a PLUGIN:<name>:<command> socket command
+ */
+void handle_command(const char *command, char *response, size_t response_size)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", command);
+
+    pthread_mutex_lock(&g_command_lock);
+    if (!g_initialized) {
+        snprintf(response, response_size, "PLUGIN:ERROR_NOT_INITIALIZED\n");
+    } else if (strncmp(buffer, "QUERY ", 6) == 0) {
+        command_query(buffer + 6, response, response_size);
+    } else if (strcmp(buffer, "TAGS") == 0) {
+        command_tags(response, response_size);
+    } else if (strcmp(buffer, "STATS") == 0) {
+        command_stats(response, response_size);
+    } else {
+        snprintf(response, response_size, "PLUGIN:ERROR_COMMAND\n");
+    }
+    pthread_mutex_unlock(&g_command_lock);
+}
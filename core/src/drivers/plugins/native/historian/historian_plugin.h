@@ -0,0 +1,77 @@
+/**
+ * @file historian_plugin.h
+ * @brief Native Tag Historian Plugin for OpenPLC Runtime v4
+ *
+ * This plugin records every change of the configured tags, timestamped,
+ * into append-only segment files under data_dir, at the scan rate. The
+ * history is read back with range queries through the runtime's unix socket
+ * (PLUGIN:<name>:QUERY ...).
+ */
+
+#ifndef HISTORIAN_PLUGIN_H
+#define HISTORIAN_PLUGIN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the historian plugin
+ *
+ * Called when the plugin is loaded, and again when it is restarted with a
+ * new configuration. Parses the tag list, allocates the buffers the scan
+ * hook uses and opens a new segment in data_dir.
+ *
+ * @param args Pointer to plugin_runtime_args_t containing runtime buffers,
+ *             mutex functions, and logging function pointers
+ * @return 0 on success, -1 on failure
+ */
+int init(void *args);
+
+/**
+ * @brief Start recording and the writer thread
+ */
+void start_loop(void);
+
+/**
+ * @brief Stop recording; the writer thread stores the queued samples and exits
+ */
+void stop_loop(void);
+
+/**
+ * @brief Cleanup plugin resources and close the current segment
+ */
+void cleanup(void);
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ *
+ * Nothing to do: tags are recorded at the end of the scan.
+ */
+void cycle_start(void);
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Reads the change bits of the tag areas and queues the tags whose value
+ * changed. Never allocates memory or blocks; samples the queue cannot take
+ * are counted as dropped and the tag is recorded again once there is room.
+ */
+void cycle_end(void);
+
+/**
+ * @brief Answer a PLUGIN:<name>:<command> socket command
+ *
+ * - QUERY <tag> [<from_ns> [<to_ns> [<limit>]]]: samples of one tag
+ * - TAGS: the configured tags
+ * - STATS: recording and storage counters
+ */
+void handle_command(const char *command, char *response, size_t response_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORIAN_PLUGIN_H */
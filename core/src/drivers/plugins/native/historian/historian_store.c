@@ -0,0 +1,800 @@
+/**
+ * @file historian_store.c
+ * @brief Historian segment files: layout, encoding, rotation and queries
+ */
+
+#define _GNU_SOURCE
+
+#include "historian_store.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SEGMENT_MAGIC       "OPLCHIST"
+#define BLOCK_MAGIC         0x4b4c4248u     /* "HBLK" */
+#define MAX_VARINT_LEN      10
+
+/**
+ * @brief Start of a segment file, followed by num_tags segment_tag_t
+ *
+ * The header and the tag table take the first header_blocks blocks.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t num_blocks;            /* Blocks in the file, header included */
+    uint32_t blocks_used;           /* Header included */
+    uint32_t header_blocks;
+    uint32_t num_tags;
+    uint64_t sequence;
+    uint64_t first_ts;              /* Earliest sample, 0 while empty */
+    uint64_t last_ts;
+} segment_header_t;
+
+typedef struct {
+    char name[HISTORIAN_MAX_NAME_LEN];
+    uint8_t type;                   /* historian_tag_type_t */
+    uint8_t reserved[7];
+} segment_tag_t;
+
+/**
+ * @brief Start of every data block
+ *
+ * The timestamp column starts right after it, the value column ends at the
+ * end of the block.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t tag;                   /* Index in the segment's tag table */
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t count;                 /* Samples */
+    uint32_t ts_bytes;              /* Length of the timestamp column */
+    uint32_t value_bytes;           /* Length of the value column */
+    uint32_t reserved2;
+    uint64_t first_ts;
+    uint64_t last_ts;
+} block_header_t;
+
+#define BLOCK_DATA_SIZE (HISTORIAN_BLOCK_SIZE - sizeof(block_header_t))
+
+/* A closed segment */
+typedef struct {
+    uint64_t sequence;
+    uint64_t first_ts;
+    uint64_t last_ts;
+} segment_info_t;
+
+/* Writer state of one configured tag */
+typedef struct {
+    uint32_t block;                 /* Open block in the current segment, 0 if none */
+    uint64_t last_value;            /* Previous value in that block */
+    uint64_t last_ts;               /* Previous sample, kept across segments */
+    bool has_ts;
+} tag_state_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static historian_config_t g_config_copy;
+static const historian_config_t *g_config = NULL;   /* &g_config_copy while open */
+static tag_state_t g_tags[HISTORIAN_MAX_TAGS];
+
+/* Closed segments, oldest first */
+static segment_info_t *g_segments = NULL;
+static int g_num_segments = 0;
+
+/* Current segment */
+static int g_fd = -1;
+static uint8_t *g_map = NULL;
+static size_t g_map_size = 0;
+static segment_header_t *g_header = NULL;
+static uint64_t g_sequence = 0;
+
+static uint64_t g_samples = 0;
+static uint64_t g_bytes = 0;
+
+/*
+ * =============================================================================
+ * Encoding
+ * =============================================================================
+ */
+
+static int tag_width(int type)
+{
+    static const int widths[] = { 1, 8, 16, 32, 64 };
+    return type >= 0 && type <= HISTORIAN_TAG_LWORD ? widths[type] : 64;
+}
+
+static uint64_t width_mask(int width)
+{
+    return width >= 64 ? ~0ull : (1ull << width) - 1;
+}
+
+static int put_varint(uint8_t *dest, uint64_t value)
+{
+    int length = 0;
+    while (value >= 0x80) {
+        dest[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    dest[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+ * @brief Zigzag code of the signed difference of two values of `width` bits
+ */
+static uint64_t encode_delta(uint64_t value, uint64_t previous, int width)
+{
+    uint64_t mask = width_mask(width);
+    uint64_t delta = (value - previous) & mask;
+    if (width < 64 && (delta >> (width - 1)) & 1) {
+        delta |= ~mask;                 /* Sign-extend */
+    }
+    int64_t signed_delta = (int64_t)delta;
+    return ((uint64_t)signed_delta << 1) ^ (uint64_t)(signed_delta >> 63);
+}
+
+static uint64_t decode_delta(uint64_t code, uint64_t previous, int width)
+{
+    uint64_t delta = (code >> 1) ^ (0 - (code & 1));
+    return (previous + delta) & width_mask(width);
+}
+
+static block_header_t *block_at(uint8_t *base, uint32_t block)
+{
+    return (block_header_t *)(base + (size_t)block * HISTORIAN_BLOCK_SIZE);
+}
+
+/*
+ * =============================================================================
+ * Segment Files
+ * =============================================================================
+ */
+
+static void segment_path(char *path, size_t size, const char *dir, uint64_t sequence)
+{
+    snprintf(path, size, "%s/seg-%012llu.hist", dir, (unsigned long long)sequence);
+}
+
+/**
+ * @brief Sequence number of a segment file name, false if it is not one
+ */
+static bool parse_segment_name(const char *name, uint64_t *sequence)
+{
+    unsigned long long value = 0;
+    int end = 0;
+    if (sscanf(name, "seg-%12llu.hist%n", &value, &end) != 1 || end == 0 || name[end] != '\0') {
+        return false;
+    }
+    *sequence = value;
+    return true;
+}
+
+static int mkdir_p(const char *dir)
+{
+    char path[HISTORIAN_MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s", dir);
+
+    for (char *p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+static bool valid_header(const segment_header_t *header, size_t size)
+{
+    return memcmp(header->magic, SEGMENT_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == HISTORIAN_FORMAT_VERSION && header->block_size == HISTORIAN_BLOCK_SIZE &&
+           header->header_blocks > 0 && header->blocks_used >= header->header_blocks &&
+           header->blocks_used <= header->num_blocks &&
+           (size_t)header->blocks_used * HISTORIAN_BLOCK_SIZE <= size &&
+           sizeof(segment_header_t) + (size_t)header->num_tags * sizeof(segment_tag_t) <=
+               (size_t)header->header_blocks * HISTORIAN_BLOCK_SIZE;
+}
+
+static int compare_segments(const void *a, const void *b)
+{
+    uint64_t sa = ((const segment_info_t *)a)->sequence;
+    uint64_t sb = ((const segment_info_t *)b)->sequence;
+    return sa < sb ? -1 : sa > sb;
+}
+
+/**
+ * @brief Delete the oldest closed segments so `keep` of them are left
+ */
+static void apply_retention(int keep)
+{
+    int excess = g_num_segments - keep;
+    if (excess <= 0) {
+        return;
+    }
+
+    char path[HISTORIAN_MAX_PATH_LEN + 32];
+    for (int i = 0; i < excess; i++) {
+        segment_path(path, sizeof(path), g_config->data_dir, g_segments[i].sequence);
+        unlink(path);
+    }
+    memmove(g_segments, g_segments + excess, (size_t)(g_num_segments - excess) * sizeof(segment_info_t));
+    g_num_segments -= excess;
+}
+
+/**
+ * @brief Index the segments already in data_dir, oldest first
+ *
+ * Files that are not valid segments are left alone.
+ */
+static int index_segments(void)
+{
+    DIR *dir = opendir(g_config->data_dir);
+    if (dir == NULL) {
+        return -1;
+    }
+
+    int capacity = g_config->max_segments;
+    g_segments = malloc((size_t)capacity * sizeof(segment_info_t));
+    if (g_segments == NULL) {
+        closedir(dir);
+        return -1;
+    }
+    g_num_segments = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        uint64_t sequence;
+        if (!parse_segment_name(entry->d_name, &sequence)) {
+            continue;
+        }
+
+        char path[HISTORIAN_MAX_PATH_LEN + 32];
+        segment_path(path, sizeof(path), g_config->data_dir, sequence);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        segment_header_t header;
+        struct stat st;
+        bool valid = fstat(fd, &st) == 0 && pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                     valid_header(&header, (size_t)st.st_size) && header.sequence == sequence;
+        close(fd);
+        if (!valid) {
+            continue;
+        }
+
+        if (g_num_segments == capacity) {
+            segment_info_t *grown = realloc(g_segments, (size_t)capacity * 2 * sizeof(segment_info_t));
+            if (grown == NULL) {
+                break;
+            }
+            g_segments = grown;
+            capacity *= 2;
+        }
+        g_segments[g_num_segments].sequence = sequence;
+        g_segments[g_num_segments].first_ts = header.first_ts;
+        g_segments[g_num_segments].last_ts = header.last_ts;
+        g_num_segments++;
+    }
+    closedir(dir);
+
+    qsort(g_segments, (size_t)g_num_segments, sizeof(segment_info_t), compare_segments);
+    if (g_num_segments > 0) {
+        g_sequence = g_segments[g_num_segments - 1].sequence;
+    }
+
+    /* Room for the current segment; the array never grows again */
+    apply_retention(g_config->max_segments - 1);
+    return 0;
+}
+
+static int create_segment(uint64_t sequence)
+{
+    char path[HISTORIAN_MAX_PATH_LEN + 32];
+    segment_path(path, sizeof(path), g_config->data_dir, sequence);
+
+    size_t size = (size_t)g_config->segment_size_kb * 1024;
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        int saved = errno;
+        close(fd);
+        unlink(path);
+        errno = saved;
+        return -1;
+    }
+    uint8_t *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        int saved = errno;
+        close(fd);
+        unlink(path);
+        errno = saved;
+        return -1;
+    }
+
+    segment_header_t *header = (segment_header_t *)map;
+    size_t header_size = sizeof(segment_header_t) + (size_t)g_config->num_tags * sizeof(segment_tag_t);
+    memcpy(header->magic, SEGMENT_MAGIC, sizeof(header->magic));
+    header->version = HISTORIAN_FORMAT_VERSION;
+    header->block_size = HISTORIAN_BLOCK_SIZE;
+    header->num_blocks = (uint32_t)(size / HISTORIAN_BLOCK_SIZE);
+    header->header_blocks = (uint32_t)((header_size + HISTORIAN_BLOCK_SIZE - 1) / HISTORIAN_BLOCK_SIZE);
+    header->blocks_used = header->header_blocks;
+    header->num_tags = (uint32_t)g_config->num_tags;
+    header->sequence = sequence;
+
+    segment_tag_t *tags = (segment_tag_t *)(header + 1);
+    for (int i = 0; i < g_config->num_tags; i++) {
+        memcpy(tags[i].name, g_config->tags[i].name, HISTORIAN_MAX_NAME_LEN);
+        tags[i].type = (uint8_t)g_config->tags[i].type;
+    }
+
+    g_fd = fd;
+    g_map = map;
+    g_map_size = size;
+    g_header = header;
+    g_sequence = sequence;
+    for (int i = 0; i < g_config->num_tags; i++) {
+        g_tags[i].block = 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Close the current segment: truncated to its used blocks, or deleted if empty
+ */
+static void close_segment(void)
+{
+    if (g_map == NULL) {
+        return;
+    }
+
+    uint32_t used = g_header->blocks_used;
+    bool empty = used == g_header->header_blocks;
+    segment_info_t info = { g_header->sequence, g_header->first_ts, g_header->last_ts };
+
+    g_header->num_blocks = used;
+    msync(g_map, g_map_size, MS_ASYNC);
+    munmap(g_map, g_map_size);
+    g_map = NULL;
+    g_header = NULL;
+
+    if (empty) {
+        char path[HISTORIAN_MAX_PATH_LEN + 32];
+        segment_path(path, sizeof(path), g_config->data_dir, info.sequence);
+        unlink(path);
+    } else {
+        if (ftruncate(g_fd, (off_t)used * HISTORIAN_BLOCK_SIZE) != 0) {
+            /* The header tells readers where the data ends */
+        }
+        /* Room for this one and the next current segment */
+        apply_retention(g_config->max_segments - 2);
+        g_segments[g_num_segments++] = info;
+    }
+    close(g_fd);
+    g_fd = -1;
+}
+
+/**
+ * @brief Open a data block for `tag`, rotating to a new segment if the current one is full
+ */
+static bool open_block(int tag)
+{
+    if (g_header->blocks_used >= g_header->num_blocks) {
+        uint64_t next = g_sequence + 1;
+        close_segment();
+        if (create_segment(next) != 0) {
+            return false;
+        }
+    }
+
+    uint32_t index = g_header->blocks_used++;
+    block_header_t *block = block_at(g_map, index);
+    memset(block, 0, HISTORIAN_BLOCK_SIZE);
+    block->magic = BLOCK_MAGIC;
+    block->tag = (uint16_t)tag;
+    block->type = (uint8_t)g_config->tags[tag].type;
+
+    g_tags[tag].block = index;
+    g_tags[tag].last_value = 0;
+    return true;
+}
+
+static bool append_sample(const historian_sample_t *sample)
+{
+    int tag = (int)sample->tag;
+    tag_state_t *state = &g_tags[tag];
+    int type = g_config->tags[tag].type;
+    int width = tag_width(type);
+    uint64_t value = sample->value & width_mask(width);
+
+    uint64_t timestamp = sample->timestamp;
+    if (state->has_ts && timestamp <= state->last_ts) {
+        timestamp = state->last_ts + 1;
+    }
+
+    for (;;) {
+        if (state->block == 0 && !open_block(tag)) {
+            return false;
+        }
+
+        block_header_t *block = block_at(g_map, state->block);
+        uint64_t ts_delta = block->count == 0 ? 0 : timestamp - block->last_ts;
+        uint8_t ts_bytes[MAX_VARINT_LEN];
+        uint8_t value_bytes[MAX_VARINT_LEN];
+        int ts_length = put_varint(ts_bytes, ts_delta);
+        int value_length;
+
+        if (type == HISTORIAN_TAG_BOOL) {
+            value_length = block->count % 8 == 0 ? 1 : 0;
+        } else {
+            value_length = put_varint(value_bytes, encode_delta(value, state->last_value, width));
+        }
+
+        size_t used = (size_t)block->ts_bytes + block->value_bytes;
+        if (used + (size_t)ts_length + (size_t)value_length > BLOCK_DATA_SIZE) {
+            state->block = 0;       /* Full, continue in a new block */
+            continue;
+        }
+
+        uint8_t *data = (uint8_t *)(block + 1);
+        uint8_t *end = (uint8_t *)block + HISTORIAN_BLOCK_SIZE;
+        memcpy(data + block->ts_bytes, ts_bytes, (size_t)ts_length);
+        if (type == HISTORIAN_TAG_BOOL) {
+            uint8_t *byte = end - 1 - block->count / 8;
+            if (value_length == 1) {
+                *byte = 0;
+            }
+            *byte |= (uint8_t)((value & 1) << (block->count % 8));
+        } else {
+            for (int k = 0; k < value_length; k++) {
+                end[-1 - (long)block->value_bytes - k] = value_bytes[k];
+            }
+        }
+
+        if (block->count == 0) {
+            block->first_ts = timestamp;
+        }
+        block->last_ts = timestamp;
+        block->ts_bytes += (uint32_t)ts_length;
+        block->value_bytes += (uint32_t)value_length;
+        block->count++;
+        g_bytes += (uint64_t)ts_length + (uint64_t)value_length;
+        break;
+    }
+
+    if (g_header->first_ts == 0) {
+        g_header->first_ts = timestamp;
+    }
+    g_header->last_ts = timestamp;
+    state->last_value = value;
+    state->last_ts = timestamp;
+    state->has_ts = true;
+    return true;
+}
+
+/*
+ * =============================================================================
+ * Queries
+ * =============================================================================
+ */
+
+static bool get_varint(const uint8_t *data, size_t length, size_t *pos, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *pos < length; shift += 7) {
+        uint8_t byte = data[(*pos)++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Value column bytes are stored back to front */
+static bool get_varint_reversed(const uint8_t *end, size_t length, size_t *pos, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *pos < length; shift += 7) {
+        uint8_t byte = end[-1 - (long)(*pos)++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct {
+    const char *name;
+    char dir[HISTORIAN_MAX_PATH_LEN];
+    uint64_t from;
+    uint64_t to;
+    historian_query_cb_t cb;
+    void *ctx;
+    long found;
+    bool stopped;
+} query_t;
+
+/**
+ * @brief Decode the samples of one block within the query range
+ *
+ * @return false once the query is over (the callback stopped it, or the
+ *         block has samples after `to`)
+ */
+static bool query_block(const block_header_t *block, query_t *query)
+{
+    if (block->ts_bytes + (size_t)block->value_bytes > BLOCK_DATA_SIZE) {
+        return true;                /* Damaged, skip it */
+    }
+
+    const uint8_t *data = (const uint8_t *)(block + 1);
+    const uint8_t *end = (const uint8_t *)block + HISTORIAN_BLOCK_SIZE;
+    int width = tag_width(block->type);
+    uint64_t timestamp = block->first_ts;
+    uint64_t value = 0;
+    size_t ts_pos = 0;
+    size_t value_pos = 0;
+
+    for (uint32_t i = 0; i < block->count; i++) {
+        uint64_t delta;
+        if (!get_varint(data, block->ts_bytes, &ts_pos, &delta)) {
+            return true;
+        }
+        timestamp += delta;
+
+        if (block->type == HISTORIAN_TAG_BOOL) {
+            if (i / 8 >= block->value_bytes) {
+                return true;
+            }
+            value = (end[-1 - (long)(i / 8)] >> (i % 8)) & 1;
+        } else {
+            uint64_t code;
+            if (!get_varint_reversed(end, block->value_bytes, &value_pos, &code)) {
+                return true;
+            }
+            value = decode_delta(code, value, width);
+        }
+
+        if (timestamp < query->from) {
+            continue;
+        }
+        if (timestamp > query->to) {
+            return false;
+        }
+        if (!query->cb(query->ctx, timestamp, value)) {
+            query->stopped = true;
+            return false;
+        }
+        query->found++;
+    }
+    return true;
+}
+
+/**
+ * @brief Query one mapped segment of `size` bytes
+ *
+ * @return false once the query is over
+ */
+static bool query_segment(const uint8_t *base, size_t size, query_t *query)
+{
+    const segment_header_t *header = (const segment_header_t *)base;
+    if (size < sizeof(segment_header_t) || !valid_header(header, size)) {
+        return true;
+    }
+
+    const segment_tag_t *tags = (const segment_tag_t *)(header + 1);
+    int tag = -1;
+    for (uint32_t i = 0; i < header->num_tags; i++) {
+        if (strncmp(tags[i].name, query->name, HISTORIAN_MAX_NAME_LEN) == 0) {
+            tag = (int)i;
+            break;
+        }
+    }
+    if (tag < 0) {
+        return true;
+    }
+
+    /* A tag's blocks are in time order */
+    for (uint32_t b = header->header_blocks; b < header->blocks_used; b++) {
+        const block_header_t *block = (const block_header_t *)(base + (size_t)b * HISTORIAN_BLOCK_SIZE);
+        if (block->magic != BLOCK_MAGIC || block->tag != tag || block->count == 0 ||
+            block->last_ts < query->from) {
+            continue;
+        }
+        if (block->first_ts > query->to || !query_block(block, query)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Query a closed segment file; a file deleted since it was listed is skipped
+ */
+static bool query_file(uint64_t sequence, query_t *query)
+{
+    char path[HISTORIAN_MAX_PATH_LEN + 32];
+    segment_path(path, sizeof(path), query->dir, sequence);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return true;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)HISTORIAN_BLOCK_SIZE) {
+        close(fd);
+        return true;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return true;
+    }
+    bool more = query_segment(map, (size_t)st.st_size, query);
+    munmap(map, (size_t)st.st_size);
+    return more;
+}
+
+static bool overlaps(const segment_info_t *segment, const query_t *query)
+{
+    return segment->last_ts >= query->from && segment->first_ts <= query->to;
+}
+
+/*
+ * =============================================================================
+ * Public Functions
+ * =============================================================================
+ */
+
+int historian_store_open(const historian_config_t *config)
+{
+    pthread_mutex_lock(&g_lock);
+    memcpy(&g_config_copy, config, sizeof(historian_config_t));
+    g_config = &g_config_copy;
+    memset(g_tags, 0, sizeof(g_tags));
+    g_samples = 0;
+    g_bytes = 0;
+    g_sequence = 0;
+
+    int result = -1;
+    if (mkdir_p(config->data_dir) == 0 && index_segments() == 0) {
+        result = create_segment(g_sequence + 1);
+    }
+    if (result != 0) {
+        int saved = errno;
+        free(g_segments);
+        g_segments = NULL;
+        g_num_segments = 0;
+        g_config = NULL;
+        errno = saved;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return result;
+}
+
+void historian_store_close(void)
+{
+    pthread_mutex_lock(&g_lock);
+    if (g_config != NULL) {
+        close_segment();
+        free(g_segments);
+        g_segments = NULL;
+        g_num_segments = 0;
+        g_config = NULL;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+size_t historian_store_append(const historian_sample_t *samples, size_t count)
+{
+    size_t appended = 0;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_config != NULL) {
+        /* A segment that could not be created is retried with the next batch */
+        if (g_map == NULL && create_segment(g_sequence + 1) != 0) {
+            pthread_mutex_unlock(&g_lock);
+            return 0;
+        }
+        for (; appended < count && g_map != NULL; appended++) {
+            if ((int)samples[appended].tag >= g_config->num_tags) {
+                continue;
+            }
+            if (!append_sample(&samples[appended])) {
+                break;
+            }
+        }
+        g_samples += appended;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return appended;
+}
+
+long historian_store_query(const char *name, uint64_t from, uint64_t to, historian_query_cb_t cb,
+                           void *ctx)
+{
+    query_t query;
+    memset(&query, 0, sizeof(query));
+    query.name = name;
+    query.from = from;
+    query.to = to;
+    query.cb = cb;
+    query.ctx = ctx;
+
+    /* Closed segments are read without the lock, so the writer does not wait */
+    pthread_mutex_lock(&g_lock);
+    if (g_config == NULL) {
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    memcpy(query.dir, g_config->data_dir, sizeof(query.dir));
+    int count = g_num_segments;
+    uint64_t current = g_sequence;
+    segment_info_t *segments = count > 0 ? malloc((size_t)count * sizeof(segment_info_t)) : NULL;
+    if (segments != NULL) {
+        memcpy(segments, g_segments, (size_t)count * sizeof(segment_info_t));
+    } else {
+        count = 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    bool more = true;
+    for (int i = 0; more && i < count; i++) {
+        if (overlaps(&segments[i], &query)) {
+            more = query_file(segments[i].sequence, &query);
+        }
+    }
+    free(segments);
+
+    pthread_mutex_lock(&g_lock);
+    if (g_config != NULL) {
+        /* Segments closed since the list was copied, then the current one */
+        for (int i = 0; more && i < g_num_segments; i++) {
+            if (g_segments[i].sequence >= current && overlaps(&g_segments[i], &query)) {
+                more = query_file(g_segments[i].sequence, &query);
+            }
+        }
+        if (more && g_map != NULL) {
+            query_segment(g_map, g_map_size, &query);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return query.found;
+}
+
+void historian_store_get_stats(historian_store_stats_t *stats)
+{
+    memset(stats, 0, sizeof(historian_store_stats_t));
+
+    pthread_mutex_lock(&g_lock);
+    stats->samples = g_samples;
+    stats->sequence = g_sequence;
+    stats->segments = g_num_segments + (g_map != NULL ? 1 : 0);
+    if (g_header != NULL) {
+        stats->blocks_used = (int)g_header->blocks_used;
+        stats->num_blocks = (int)g_header->num_blocks;
+    }
+    stats->bytes = g_bytes;
+    pthread_mutex_unlock(&g_lock);
+}
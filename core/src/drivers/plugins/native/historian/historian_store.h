@@ -0,0 +1,107 @@
+/**
+ * @file historian_store.h
+ * @brief Append-only, memory-mapped segment files of the historian
+ *
+ * Samples are appended to the current segment, a file of segment_size_kb
+ * mapped with mmap() and cut into 4 KiB blocks. Each block holds samples of
+ * one tag as two columns:
+ * - timestamps, growing up from the block header: nanosecond deltas to the
+ *   previous sample (the first one to first_ts) as LEB128 varints
+ * - values, growing down from the end of the block: BOOL tags one bit per
+ *   sample, other tags the zigzag varint of the difference to the previous
+ *   value in the tag's width
+ * so a block decodes on its own, and a tag that changes by small steps every
+ * few milliseconds takes 2 to 4 bytes per sample.
+ *
+ * A full segment is truncated to the blocks it used and closed, and the next
+ * one is created; the oldest segments beyond max_segments are deleted. The
+ * files are named seg-<sequence>.hist in data_dir and describe themselves
+ * (tag names and types in the header), so old segments stay readable after
+ * the tag list changes.
+ *
+ * All functions but historian_store_open/close may be called from any
+ * thread: a mutex serializes appends and queries.
+ */
+
+#ifndef HISTORIAN_STORE_H
+#define HISTORIAN_STORE_H
+
+#include "historian_config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* On-disk format */
+#define HISTORIAN_BLOCK_SIZE        4096
+#define HISTORIAN_FORMAT_VERSION    1
+
+/**
+ * @brief One recorded change, as queued by the scan thread
+ */
+typedef struct {
+    uint64_t timestamp;             /* CLOCK_REALTIME, nanoseconds */
+    uint64_t value;                 /* Raw value, zero-extended */
+    uint32_t tag;                   /* Index in the configuration */
+    uint32_t reserved;
+} historian_sample_t;
+
+/**
+ * @brief Called for each sample a query finds, in time order
+ *
+ * @return false to end the query before this sample
+ */
+typedef bool (*historian_query_cb_t)(void *ctx, uint64_t timestamp, uint64_t value);
+
+typedef struct {
+    uint64_t samples;               /* Appended since open */
+    uint64_t bytes;                 /* Column bytes appended since open */
+    uint64_t sequence;              /* Of the current segment */
+    int segments;                   /* On disk, the current one included */
+    int blocks_used;                /* Of the current segment */
+    int num_blocks;
+} historian_store_stats_t;
+
+/**
+ * @brief Create data_dir if needed, index its segments and start a new one
+ *
+ * @return 0 on success, -1 on failure (errno set)
+ */
+int historian_store_open(const historian_config_t *config);
+
+/**
+ * @brief Close the current segment, truncated to the blocks it used
+ */
+void historian_store_close(void);
+
+/**
+ * @brief Append samples, in time order
+ *
+ * Timestamps are stored strictly increasing per tag: one not after the tag's
+ * previous sample (the clock stepped back) is stored 1 ns after it.
+ *
+ * @return Samples appended, fewer if a new segment could not be created
+ */
+size_t historian_store_append(const historian_sample_t *samples, size_t count);
+
+/**
+ * @brief Find the samples of tag `name` with from <= timestamp <= to
+ *
+ * Closed segments are mapped read-only for the time of the query.
+ *
+ * @return Samples passed to `cb`, -1 if the store is not open
+ */
+long historian_store_query(const char *name, uint64_t from, uint64_t to, historian_query_cb_t cb,
+                           void *ctx);
+
+void historian_store_get_stats(historian_store_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORIAN_STORE_H */
@@ -0,0 +1,186 @@
+/**
+ * @file image_read.h
+ * @brief Packed reads of the image tables for native plugins
+ *
+ * Reads count elements of one image table area into a packed buffer: one
+ * byte per index for BOOL areas (bit n = %IXi.n / %QXi.n / %MXi.n), one
+ * element of the area's width otherwise, unlocated addresses reading as 0.
+ * Areas are numbered like the journal buffer types (journal_buffer_type_t),
+ * which is also what read_image_snapshot and journal_write_range take.
+ * image_journal_bits() writes a packed bit string back through the journal.
+ */
+
+#ifndef IMAGE_READ_H
+#define IMAGE_READ_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bit_pack.h"
+#include "plugin_types.h"
+
+/* Image table areas (matching journal_buffer_type_t) */
+#define IMAGE_READ_BOOL_INPUT   0
+#define IMAGE_READ_BOOL_OUTPUT  1
+#define IMAGE_READ_BOOL_MEMORY  2
+#define IMAGE_READ_BYTE_INPUT   3
+#define IMAGE_READ_BYTE_OUTPUT  4
+#define IMAGE_READ_INT_INPUT    5
+#define IMAGE_READ_INT_OUTPUT   6
+#define IMAGE_READ_INT_MEMORY   7
+#define IMAGE_READ_DINT_INPUT   8
+#define IMAGE_READ_DINT_OUTPUT  9
+#define IMAGE_READ_DINT_MEMORY  10
+#define IMAGE_READ_LINT_INPUT   11
+#define IMAGE_READ_LINT_OUTPUT  12
+#define IMAGE_READ_LINT_MEMORY  13
+
+/**
+ * @brief Bytes per packed element of an area
+ */
+static inline int image_read_width(int type)
+{
+    switch (type) {
+        case IMAGE_READ_INT_INPUT:
+        case IMAGE_READ_INT_OUTPUT:
+        case IMAGE_READ_INT_MEMORY:
+            return 2;
+        case IMAGE_READ_DINT_INPUT:
+        case IMAGE_READ_DINT_OUTPUT:
+        case IMAGE_READ_DINT_MEMORY:
+            return 4;
+        case IMAGE_READ_LINT_INPUT:
+        case IMAGE_READ_LINT_OUTPUT:
+        case IMAGE_READ_LINT_MEMORY:
+            return 8;
+        default:
+            return 1; /* BOOL (one byte per index) and BYTE */
+    }
+}
+
+/**
+ * @brief Read packed elements from the pointer tables
+ *
+ * Caller must hold buffer_mutex.
+ */
+static inline void image_read_pointer_tables(const plugin_runtime_args_t *args, int type,
+                                             int start, int count, void *dest)
+{
+    for (int i = 0; i < count; i++) {
+        int index = start + i;
+
+        switch (type) {
+            case IMAGE_READ_BOOL_INPUT:
+            case IMAGE_READ_BOOL_OUTPUT:
+            case IMAGE_READ_BOOL_MEMORY: {
+                IEC_BOOL *(*table)[8] = type == IMAGE_READ_BOOL_INPUT  ? args->bool_input
+                                      : type == IMAGE_READ_BOOL_OUTPUT ? args->bool_output
+                                                                      : args->bool_memory;
+                uint8_t byte = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    if (table[index][bit] != NULL && *table[index][bit]) {
+                        byte |= (uint8_t)(1u << bit);
+                    }
+                }
+                ((uint8_t *)dest)[i] = byte;
+                break;
+            }
+            case IMAGE_READ_BYTE_INPUT:
+            case IMAGE_READ_BYTE_OUTPUT: {
+                IEC_BYTE **table = type == IMAGE_READ_BYTE_INPUT ? args->byte_input
+                                                                 : args->byte_output;
+                ((uint8_t *)dest)[i] = table[index] != NULL ? *table[index] : 0;
+                break;
+            }
+            case IMAGE_READ_INT_INPUT:
+            case IMAGE_READ_INT_OUTPUT:
+            case IMAGE_READ_INT_MEMORY: {
+                IEC_UINT **table = type == IMAGE_READ_INT_INPUT  ? args->int_input
+                                 : type == IMAGE_READ_INT_OUTPUT ? args->int_output
+                                                                 : args->int_memory;
+                ((uint16_t *)dest)[i] = table[index] != NULL ? *table[index] : 0;
+                break;
+            }
+            case IMAGE_READ_DINT_INPUT:
+            case IMAGE_READ_DINT_OUTPUT:
+            case IMAGE_READ_DINT_MEMORY: {
+                IEC_UDINT **table = type == IMAGE_READ_DINT_INPUT  ? args->dint_input
+                                  : type == IMAGE_READ_DINT_OUTPUT ? args->dint_output
+                                                                   : args->dint_memory;
+                ((uint32_t *)dest)[i] = table[index] != NULL ? *table[index] : 0;
+                break;
+            }
+            default: {
+                IEC_ULINT **table = type == IMAGE_READ_LINT_INPUT  ? args->lint_input
+                                  : type == IMAGE_READ_LINT_OUTPUT ? args->lint_output
+                                                                   : args->lint_memory;
+                ((uint64_t *)dest)[i] = table[index] != NULL ? *table[index] : 0;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Read packed elements of one image table area
+ *
+ * Uses the lock-free snapshot when the runtime provides it, so readers do
+ * not contend with the scan cycle for buffer_mutex, and falls back to a
+ * locked read of the pointer tables until the snapshot is available.
+ * Elements past the end of the snapshot read as 0.
+ */
+static inline void image_read_elements(const plugin_runtime_args_t *args, int type, int start,
+                                       int count, void *dest)
+{
+    if (args->read_image_snapshot != NULL) {
+        int copied = args->read_image_snapshot(type, start, count, dest);
+        if (copied >= 0) {
+            if (copied < count) {
+                int width = image_read_width(type);
+                memset((uint8_t *)dest + copied * width, 0, (size_t)((count - copied) * width));
+            }
+            return;
+        }
+    }
+
+    args->mutex_take(args->buffer_mutex);
+    image_read_pointer_tables(args, type, start, count, dest);
+    args->mutex_give(args->buffer_mutex);
+}
+
+/**
+ * @brief Journal `count` bits of `src` (from bit `src_pos`) to a BOOL area
+ *
+ * The bits go to bit `bit` of index `index` on: `bit` may exceed 7. Whole
+ * image table bytes go in one range write; the bits of partially covered
+ * bytes are written one by one so their other bits are kept.
+ *
+ * @param scratch At least count / 8 bytes
+ */
+static inline void image_journal_bits(const plugin_runtime_args_t *args, int type, int index,
+                                      int bit, int count, const uint8_t *src, int src_pos,
+                                      uint8_t *scratch)
+{
+    int k = 0;
+
+    for (; k < count && (bit + k) % 8 != 0; k++) {
+        int pos = src_pos + k;
+        args->journal_write_bool(type, index + (bit + k) / 8, (bit + k) % 8,
+                                 (src[pos / 8] >> (pos % 8)) & 1);
+    }
+
+    int num_bytes = (count - k) / 8;
+    if (num_bytes > 0) {
+        bit_pack_copy(scratch, 0, src, (size_t)(src_pos + k), (size_t)num_bytes * 8);
+        args->journal_write_range(type, index + (bit + k) / 8, num_bytes, scratch);
+        k += num_bytes * 8;
+    }
+
+    for (; k < count; k++) {
+        int pos = src_pos + k;
+        args->journal_write_bool(type, index + (bit + k) / 8, (bit + k) % 8,
+                                 (src[pos / 8] >> (pos % 8)) & 1);
+    }
+}
+
+#endif /* IMAGE_READ_H */
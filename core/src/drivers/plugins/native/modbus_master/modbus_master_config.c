@@ -0,0 +1,344 @@
+/**
+ * @file modbus_master_config.c
+ * @brief Modbus Master Plugin Configuration Parser Implementation
+ *
+ * Parses JSON configuration files using cJSON library.
+ */
+
+#include "modbus_master_config.h"
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Error codes */
+#define MODBUS_MASTER_CONFIG_OK              0
+#define MODBUS_MASTER_CONFIG_ERR_FILE       -1
+#define MODBUS_MASTER_CONFIG_ERR_PARSE      -2
+#define MODBUS_MASTER_CONFIG_ERR_MEMORY     -3
+#define MODBUS_MASTER_CONFIG_ERR_INVALID    -4
+
+/**
+ * @brief Read entire file into a string
+ */
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size > 1024 * 1024) { /* Max 1MB config file */
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    fclose(fp);
+
+    if ((long)read_size != size) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[size] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Safely copy string with length limit
+ */
+static void safe_strcpy(char *dest, const char *src, size_t max_len)
+{
+    if (src == NULL) {
+        dest[0] = '\0';
+        return;
+    }
+    strncpy(dest, src, max_len - 1);
+    dest[max_len - 1] = '\0';
+}
+
+/**
+ * @brief Get string value from JSON object
+ */
+static const char *get_string(const cJSON *obj, const char *key, const char *default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring != NULL) {
+        return item->valuestring;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get integer value from JSON object
+ */
+static int get_int(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) {
+        return item->valueint;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Parse a Modbus offset, decimal ("123") or hexadecimal ("0x7B")
+ *
+ * @return The offset, or -1 if invalid
+ */
+static int parse_offset(const cJSON *item)
+{
+    if (cJSON_IsNumber(item)) {
+        return item->valueint >= 0 ? item->valueint : -1;
+    }
+    if (!cJSON_IsString(item) || item->valuestring == NULL) {
+        return -1;
+    }
+
+    const char *str = item->valuestring;
+    while (isspace((unsigned char)*str)) {
+        str++;
+    }
+    if (*str == '\0' || *str == '-') {
+        return -1;
+    }
+
+    char *end = NULL;
+    int base = (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) ? 16 : 10;
+    long value = strtol(str, &end, base);
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0' || value > 0xFFFF) {
+        return -1;
+    }
+    return (int)value;
+}
+
+int modbus_master_parse_iec_location(const char *str, modbus_master_iec_location_t *location)
+{
+    if (str == NULL || location == NULL) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    while (isspace((unsigned char)*str)) {
+        str++;
+    }
+    if (str[0] != '%') {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    char area = (char)toupper((unsigned char)str[1]);
+    char size = (char)toupper((unsigned char)str[2]);
+    if (strchr("IQM", area) == NULL || area == '\0' || strchr("XBWDL", size) == NULL || size == '\0') {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    const char *p = str + 3;
+    if (!isdigit((unsigned char)*p)) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+    char *end = NULL;
+    long index = strtol(p, &end, 10);
+
+    long bit = 0;
+    if (size == 'X') {
+        if (*end != '.' || !isdigit((unsigned char)end[1])) {
+            return MODBUS_MASTER_CONFIG_ERR_INVALID;
+        }
+        bit = strtol(end + 1, &end, 10);
+        if (bit > 7) {
+            return MODBUS_MASTER_CONFIG_ERR_INVALID;
+        }
+    }
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0' || index > 0xFFFF) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    location->area = area;
+    location->size = size;
+    location->index = (int)index;
+    location->bit = (int)bit;
+    return MODBUS_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief Parse one entry of io_points
+ */
+static int parse_io_point(const cJSON *json, modbus_master_io_point_t *point)
+{
+    const cJSON *iec = cJSON_GetObjectItemCaseSensitive(json, "iec_location");
+
+    /* fc, offset, iec_location and len are required */
+    point->fc = get_int(json, "fc", 0);
+    point->offset = parse_offset(cJSON_GetObjectItemCaseSensitive(json, "offset"));
+    point->length = get_int(json, "len", 0);
+    point->cycle_time_ms = get_int(json, "cycle_time_ms", MODBUS_MASTER_DEFAULT_CYCLE_TIME_MS);
+
+    if (!cJSON_IsString(iec) ||
+        modbus_master_parse_iec_location(iec->valuestring, &point->iec_location) != 0) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+    if (point->offset < 0) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+    return MODBUS_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief Parse one device entry
+ */
+static int parse_device(const cJSON *json, modbus_master_device_t *device)
+{
+    const cJSON *config = cJSON_GetObjectItemCaseSensitive(json, "config");
+
+    safe_strcpy(device->name, get_string(json, "name", "UNDEFINED"), MODBUS_MASTER_MAX_STRING_LEN);
+    if (strcmp(get_string(json, "protocol", "MODBUS"), "MODBUS") != 0) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    safe_strcpy(device->host, get_string(config, "host", "127.0.0.1"), MODBUS_MASTER_MAX_STRING_LEN);
+    int port = get_int(config, "port", MODBUS_MASTER_DEFAULT_PORT);
+    device->port = (port > 0 && port <= 0xFFFF) ? (uint16_t)port : 0;
+    device->timeout_ms = get_int(config, "timeout_ms", MODBUS_MASTER_DEFAULT_TIMEOUT_MS);
+    device->unit_id = get_int(config, "unit_id", MODBUS_MASTER_DEFAULT_UNIT_ID);
+    device->pipeline_depth = get_int(config, "pipeline_depth", MODBUS_MASTER_DEFAULT_PIPELINE);
+
+    const cJSON *points = cJSON_GetObjectItemCaseSensitive(config, "io_points");
+    int count = cJSON_IsArray(points) ? cJSON_GetArraySize(points) : 0;
+    if (count > MODBUS_MASTER_MAX_IO_POINTS) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+    if (count == 0) {
+        return MODBUS_MASTER_CONFIG_OK;
+    }
+
+    device->io_points = (modbus_master_io_point_t *)calloc((size_t)count, sizeof(modbus_master_io_point_t));
+    if (device->io_points == NULL) {
+        return MODBUS_MASTER_CONFIG_ERR_MEMORY;
+    }
+
+    const cJSON *point = NULL;
+    cJSON_ArrayForEach(point, points) {
+        int result = parse_io_point(point, &device->io_points[device->num_io_points]);
+        if (result != MODBUS_MASTER_CONFIG_OK) {
+            return result;
+        }
+        device->num_io_points++;
+    }
+    return MODBUS_MASTER_CONFIG_OK;
+}
+
+int modbus_master_config_parse(const char *config_path, modbus_master_config_t *config)
+{
+    if (config_path == NULL || config == NULL) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    memset(config, 0, sizeof(modbus_master_config_t));
+
+    /* Read file contents */
+    char *json_str = read_file(config_path);
+    if (json_str == NULL) {
+        return MODBUS_MASTER_CONFIG_ERR_FILE;
+    }
+
+    /* Parse JSON */
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+
+    if (root == NULL) {
+        return MODBUS_MASTER_CONFIG_ERR_PARSE;
+    }
+    if (!cJSON_IsArray(root) || cJSON_GetArraySize(root) > MODBUS_MASTER_MAX_DEVICES) {
+        cJSON_Delete(root);
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    /* Parse each device */
+    const cJSON *device = NULL;
+    cJSON_ArrayForEach(device, root) {
+        int result = parse_device(device, &config->devices[config->num_devices]);
+        config->num_devices++;
+        if (result != MODBUS_MASTER_CONFIG_OK) {
+            cJSON_Delete(root);
+            return result;
+        }
+    }
+
+    cJSON_Delete(root);
+
+    /* Validate the parsed configuration */
+    return modbus_master_config_validate(config);
+}
+
+int modbus_master_config_validate(const modbus_master_config_t *config)
+{
+    if (config == NULL || config->num_devices == 0) {
+        return MODBUS_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    for (int i = 0; i < config->num_devices; i++) {
+        const modbus_master_device_t *device = &config->devices[i];
+
+        if (strcmp(device->name, "UNDEFINED") == 0 || device->port == 0 || device->timeout_ms <= 0) {
+            return MODBUS_MASTER_CONFIG_ERR_INVALID;
+        }
+        if (device->unit_id < 0 || device->unit_id > 255) {
+            return MODBUS_MASTER_CONFIG_ERR_INVALID;
+        }
+        if (device->pipeline_depth < 1 || device->pipeline_depth > MODBUS_MASTER_MAX_PIPELINE) {
+            return MODBUS_MASTER_CONFIG_ERR_INVALID;
+        }
+
+        for (int p = 0; p < device->num_io_points; p++) {
+            const modbus_master_io_point_t *point = &device->io_points[p];
+            if (point->fc <= 0 || point->length <= 0 || point->cycle_time_ms <= 0) {
+                return MODBUS_MASTER_CONFIG_ERR_INVALID;
+            }
+        }
+
+        /* Names and host:port combinations must be unique */
+        for (int j = 0; j < i; j++) {
+            const modbus_master_device_t *other = &config->devices[j];
+            if (strcmp(device->name, other->name) == 0) {
+                return MODBUS_MASTER_CONFIG_ERR_INVALID;
+            }
+            if (strcmp(device->host, other->host) == 0 && device->port == other->port) {
+                return MODBUS_MASTER_CONFIG_ERR_INVALID;
+            }
+        }
+    }
+
+    return MODBUS_MASTER_CONFIG_OK;
+}
+
+void modbus_master_config_free(modbus_master_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < config->num_devices; i++) {
+        free(config->devices[i].io_points);
+        config->devices[i].io_points = NULL;
+        config->devices[i].num_io_points = 0;
+    }
+    config->num_devices = 0;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file modbus_master_config.h
+ * @brief Modbus Master Plugin Configuration Structures and Parser
+ *
+ * Reads the modbus_master.json file of the Python modbus_master plugin: a
+ * list of devices, each with its own I/O points.
+ */
+
+#ifndef MODBUS_MASTER_CONFIG_H
+#define MODBUS_MASTER_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configuration limits */
+#define MODBUS_MASTER_MAX_DEVICES       32
+#define MODBUS_MASTER_MAX_IO_POINTS     1024    /* Per device */
+#define MODBUS_MASTER_MAX_STRING_LEN    64
+#define MODBUS_MASTER_MAX_PIPELINE      64
+
+/* Default values (match the Python plugin) */
+#define MODBUS_MASTER_DEFAULT_PORT          502
+#define MODBUS_MASTER_DEFAULT_TIMEOUT_MS    1000
+#define MODBUS_MASTER_DEFAULT_CYCLE_TIME_MS 1000
+#define MODBUS_MASTER_DEFAULT_UNIT_ID       1
+#define MODBUS_MASTER_DEFAULT_PIPELINE      8
+
+/**
+ * @brief Parsed IEC location such as %IX0.3 or %MD10
+ */
+typedef struct {
+    char area;                      /* 'I', 'Q' or 'M' */
+    char size;                      /* 'X', 'B', 'W', 'D' or 'L' */
+    int index;                      /* Image table index (number after the size letter) */
+    int bit;                        /* Bit of the index for 'X', else 0 */
+} modbus_master_iec_location_t;
+
+/**
+ * @brief One polled or written range of a device
+ */
+typedef struct {
+    int fc;                                     /* Modbus function code */
+    int offset;                                 /* First coil or register */
+    modbus_master_iec_location_t iec_location;  /* First IEC element */
+    int length;                                 /* Number of IEC elements */
+    int cycle_time_ms;                          /* Polling period */
+} modbus_master_io_point_t;
+
+/**
+ * @brief One Modbus TCP slave device
+ */
+typedef struct {
+    char name[MODBUS_MASTER_MAX_STRING_LEN];
+    char host[MODBUS_MASTER_MAX_STRING_LEN];
+    uint16_t port;
+    int timeout_ms;                             /* Connect and response timeout */
+    int unit_id;                                /* Unit id sent in requests */
+    int pipeline_depth;                         /* Requests in flight, 1 = no pipelining */
+    modbus_master_io_point_t *io_points;        /* Allocated by the parser */
+    int num_io_points;
+} modbus_master_device_t;
+
+/**
+ * @brief Complete Modbus master configuration
+ */
+typedef struct {
+    modbus_master_device_t devices[MODBUS_MASTER_MAX_DEVICES];
+    int num_devices;
+} modbus_master_config_t;
+
+/**
+ * @brief Parse configuration from JSON file
+ *
+ * @param config_path Path to the JSON configuration file
+ * @param config Pointer to configuration structure to populate; release it
+ *               with modbus_master_config_free() even on failure
+ * @return 0 on success, negative error code on failure
+ */
+int modbus_master_config_parse(const char *config_path, modbus_master_config_t *config);
+
+/**
+ * @brief Validate configuration values
+ *
+ * @param config Pointer to configuration structure to validate
+ * @return 0 if valid, negative error code indicating the issue
+ */
+int modbus_master_config_validate(const modbus_master_config_t *config);
+
+/**
+ * @brief Release the I/O point arrays of a parsed configuration
+ */
+void modbus_master_config_free(modbus_master_config_t *config);
+
+/**
+ * @brief Parse an IEC location string ("%QX0.1", "%IW3", ...)
+ *
+ * @return 0 on success, negative error code if the string is invalid
+ */
+int modbus_master_parse_iec_location(const char *str, modbus_master_iec_location_t *location);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_MASTER_CONFIG_H */
@@ -0,0 +1,839 @@
+/**
+ * @file modbus_master_plugin.c
+ * @brief Native Modbus TCP Master Plugin Implementation
+ *
+ * Each device is polled by its own thread on a tick of the GCD of its
+ * cycle times, like the Python modbus_master plugin. Per tick, the I/O
+ * points that are due are coalesced: points of the same function code whose
+ * address ranges touch or overlap become one request of up to 2000 coils or
+ * 125 registers (1968 / 123 for writes). The requests of a tick are then
+ * pipelined over the connection and read results are stored with one
+ * journal range write per point.
+ */
+
+#include "modbus_master_plugin.h"
+#include "bit_pack.h"
+#include "image_read.h"
+#include "modbus_master_config.h"
+#include "modbus_tcp_client.h"
+#include "plugin_logger.h"
+#include "plugin_types.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Journal buffer types (matching journal_buffer_type_t) */
+#define MM_TYPE_BOOL_INPUT      0
+#define MM_TYPE_BOOL_OUTPUT     1
+#define MM_TYPE_BOOL_MEMORY     2
+#define MM_TYPE_BYTE_INPUT      3
+#define MM_TYPE_BYTE_OUTPUT     4
+#define MM_TYPE_INT_INPUT       5
+#define MM_TYPE_INT_OUTPUT      6
+#define MM_TYPE_INT_MEMORY      7
+#define MM_TYPE_DINT_INPUT      8
+#define MM_TYPE_DINT_OUTPUT     9
+#define MM_TYPE_DINT_MEMORY     10
+#define MM_TYPE_LINT_INPUT      11
+#define MM_TYPE_LINT_OUTPUT     12
+#define MM_TYPE_LINT_MEMORY     13
+
+/* Function codes */
+#define MM_FC_READ_COILS                0x01
+#define MM_FC_READ_DISCRETE_INPUTS      0x02
+#define MM_FC_READ_HOLDING_REGISTERS    0x03
+#define MM_FC_READ_INPUT_REGISTERS      0x04
+#define MM_FC_WRITE_SINGLE_COIL         0x05
+#define MM_FC_WRITE_SINGLE_REGISTER     0x06
+#define MM_FC_WRITE_MULTIPLE_COILS      0x0F
+#define MM_FC_WRITE_MULTIPLE_REGISTERS  0x10
+
+/* Quantity limits of the Modbus specification */
+#define MM_MAX_READ_BITS        2000
+#define MM_MAX_WRITE_BITS       1968
+#define MM_MAX_READ_REGISTERS   125
+#define MM_MAX_WRITE_REGISTERS  123
+
+/* Reconnect backoff (same as the Python plugin) */
+#define MM_RETRY_DELAY_BASE_MS  2000
+#define MM_RETRY_DELAY_MAX_MS   30000
+
+/**
+ * @brief An I/O point prepared for polling
+ */
+typedef struct {
+    const modbus_master_io_point_t *config;
+    int journal_type;
+    int quantity;                   /* Coils or registers covered */
+    int period;                     /* Polled every `period` ticks */
+} mm_point_t;
+
+/**
+ * @brief One request of a tick, covering one or more points
+ */
+typedef struct {
+    int fc;
+    int address;
+    int quantity;
+    int first_member;               /* Index into the device's members */
+    int num_members;
+} mm_request_t;
+
+typedef struct {
+    const modbus_master_device_t *config;
+    mm_point_t *points;             /* Sorted by function code, then offset */
+    int num_points;
+    int tick_ms;
+
+    modbus_tcp_client_t client;
+    int retry_delay_ms;
+
+    /* Per-tick scratch, one slot per point */
+    mm_request_t *requests;
+    modbus_tcp_transaction_t *transactions;
+    int *members;
+
+    pthread_t thread;
+    bool thread_started;
+} mm_device_t;
+
+/* Plugin state */
+static plugin_logger_t g_logger;
+static plugin_runtime_args_t g_runtime_args;
+static modbus_master_config_t g_config;
+static mm_device_t g_devices[MODBUS_MASTER_MAX_DEVICES];
+static int g_num_devices = 0;
+static bool g_initialized = false;
+static volatile bool g_running = false;
+
+/* Wakes the device threads when stopping */
+static pthread_mutex_t g_stop_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stop_cond;
+
+/*
+ * =============================================================================
+ * IEC Locations
+ * =============================================================================
+ */
+
+static bool is_bit_fc(int fc)
+{
+    return fc == MM_FC_READ_COILS || fc == MM_FC_READ_DISCRETE_INPUTS ||
+           fc == MM_FC_WRITE_SINGLE_COIL || fc == MM_FC_WRITE_MULTIPLE_COILS;
+}
+
+static bool is_read_fc(int fc)
+{
+    return fc >= MM_FC_READ_COILS && fc <= MM_FC_READ_INPUT_REGISTERS;
+}
+
+/**
+ * @brief Largest quantity of one request, 0 for unsupported function codes
+ */
+static int max_quantity(int fc)
+{
+    switch (fc) {
+        case MM_FC_READ_COILS:
+        case MM_FC_READ_DISCRETE_INPUTS:
+            return MM_MAX_READ_BITS;
+        case MM_FC_READ_HOLDING_REGISTERS:
+        case MM_FC_READ_INPUT_REGISTERS:
+            return MM_MAX_READ_REGISTERS;
+        case MM_FC_WRITE_MULTIPLE_COILS:
+            return MM_MAX_WRITE_BITS;
+        case MM_FC_WRITE_MULTIPLE_REGISTERS:
+            return MM_MAX_WRITE_REGISTERS;
+        case MM_FC_WRITE_SINGLE_COIL:
+        case MM_FC_WRITE_SINGLE_REGISTER:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Journal buffer type of an IEC location, -1 if it has none (%MB)
+ */
+static int journal_type_of(const modbus_master_iec_location_t *location)
+{
+    static const int types[3][5] = {
+        /*        X                    B                    W                   D                    L */
+        { MM_TYPE_BOOL_INPUT,  MM_TYPE_BYTE_INPUT,  MM_TYPE_INT_INPUT,  MM_TYPE_DINT_INPUT,  MM_TYPE_LINT_INPUT  },
+        { MM_TYPE_BOOL_OUTPUT, MM_TYPE_BYTE_OUTPUT, MM_TYPE_INT_OUTPUT, MM_TYPE_DINT_OUTPUT, MM_TYPE_LINT_OUTPUT },
+        { MM_TYPE_BOOL_MEMORY, -1,                  MM_TYPE_INT_MEMORY, MM_TYPE_DINT_MEMORY, MM_TYPE_LINT_MEMORY },
+    };
+    int area = location->area == 'I' ? 0 : location->area == 'Q' ? 1 : 2;
+    int size = (int)(strchr("XBWDL", location->size) - "XBWDL");
+    return types[area][size];
+}
+
+/**
+ * @brief Registers per element of an IEC size (B and W use one register)
+ */
+static int registers_per_element(char size)
+{
+    return size == 'D' ? 2 : size == 'L' ? 4 : 1;
+}
+
+/*
+ * =============================================================================
+ * Register Conversion
+ * =============================================================================
+ */
+
+/**
+ * @brief Convert big-endian registers to packed elements
+ *
+ * %xD and %xL values are built low word first, as the Python plugin does.
+ */
+static void registers_to_elements(const uint8_t *registers, char size, int count, void *dest)
+{
+    int words = registers_per_element(size);
+
+    for (int i = 0; i < count; i++) {
+        uint64_t value = 0;
+        for (int w = 0; w < words; w++) {
+            const uint8_t *reg = registers + 2 * (i * words + w);
+            value |= (uint64_t)((reg[0] << 8) | reg[1]) << (16 * w);
+        }
+
+        switch (size) {
+            case 'B':
+                ((uint8_t *)dest)[i] = (uint8_t)value;
+                break;
+            case 'W':
+                ((uint16_t *)dest)[i] = (uint16_t)value;
+                break;
+            case 'D':
+                ((uint32_t *)dest)[i] = (uint32_t)value;
+                break;
+            default:
+                ((uint64_t *)dest)[i] = value;
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Convert packed elements to big-endian registers
+ */
+static void elements_to_registers(const void *elements, char size, int count, uint8_t *registers)
+{
+    int words = registers_per_element(size);
+
+    for (int i = 0; i < count; i++) {
+        uint64_t value;
+        switch (size) {
+            case 'B':
+                value = ((const uint8_t *)elements)[i];
+                break;
+            case 'W':
+                value = ((const uint16_t *)elements)[i];
+                break;
+            case 'D':
+                value = ((const uint32_t *)elements)[i];
+                break;
+            default:
+                value = ((const uint64_t *)elements)[i];
+                break;
+        }
+
+        for (int w = 0; w < words; w++) {
+            uint16_t word = (uint16_t)(value >> (16 * w));
+            uint8_t *reg = registers + 2 * (i * words + w);
+            reg[0] = (uint8_t)(word >> 8);
+            reg[1] = (uint8_t)(word & 0xFF);
+        }
+    }
+}
+
+/*
+ * =============================================================================
+ * Request Building
+ * =============================================================================
+ */
+
+static void put_u16(uint8_t *data, int value)
+{
+    data[0] = (uint8_t)((value >> 8) & 0xFF);
+    data[1] = (uint8_t)(value & 0xFF);
+}
+
+/**
+ * @brief Copy the IEC values of a write point into request data
+ *
+ * @param data Coil bits (LSB first) or big-endian registers of the request
+ * @param pos First coil or register of the point within the request
+ */
+static void fill_write_data(const mm_point_t *point, uint8_t *data, int pos)
+{
+    const modbus_master_iec_location_t *location = &point->config->iec_location;
+    uint64_t elements[MM_MAX_WRITE_REGISTERS];
+
+    if (location->size == 'X') {
+        uint8_t bytes[MM_MAX_WRITE_BITS / 8 + 2];
+        int count = point->config->fc == MM_FC_WRITE_SINGLE_COIL ? 1 : point->quantity;
+        image_read_elements(&g_runtime_args, point->journal_type,
+                            location->index, (location->bit + count - 1) / 8 + 1, bytes);
+        bit_pack_copy(data, (size_t)pos, bytes, (size_t)location->bit, (size_t)count);
+        return;
+    }
+
+    if (point->config->fc == MM_FC_WRITE_SINGLE_REGISTER) {
+        /* First register of the first element, as the Python plugin writes */
+        uint8_t registers[8];
+        image_read_elements(&g_runtime_args, point->journal_type, location->index, 1, elements);
+        elements_to_registers(elements, location->size, 1, registers);
+        memcpy(data + 2 * pos, registers, 2);
+        return;
+    }
+    image_read_elements(&g_runtime_args, point->journal_type,
+                        location->index, point->config->length, elements);
+    elements_to_registers(elements, location->size, point->config->length, data + 2 * pos);
+}
+
+/**
+ * @brief Build the request PDU of a coalesced request
+ */
+static void build_request(const mm_device_t *device, const mm_request_t *request,
+                          modbus_tcp_transaction_t *transaction)
+{
+    uint8_t *pdu = transaction->request;
+
+    pdu[0] = (uint8_t)request->fc;
+    put_u16(pdu + 1, request->address);
+
+    switch (request->fc) {
+        case MM_FC_WRITE_SINGLE_COIL: {
+            uint8_t bit = 0;
+            fill_write_data(&device->points[device->members[request->first_member]], &bit, 0);
+            put_u16(pdu + 3, bit ? 0xFF00 : 0x0000);
+            transaction->request_len = 5;
+            break;
+        }
+        case MM_FC_WRITE_SINGLE_REGISTER:
+            fill_write_data(&device->points[device->members[request->first_member]], pdu + 3, 0);
+            transaction->request_len = 5;
+            break;
+        case MM_FC_WRITE_MULTIPLE_COILS:
+        case MM_FC_WRITE_MULTIPLE_REGISTERS: {
+            bool coils = request->fc == MM_FC_WRITE_MULTIPLE_COILS;
+            int byte_count = coils ? (request->quantity + 7) / 8 : request->quantity * 2;
+            put_u16(pdu + 3, request->quantity);
+            pdu[5] = (uint8_t)byte_count;
+            memset(pdu + 6, 0, (size_t)byte_count);
+            for (int m = 0; m < request->num_members; m++) {
+                const mm_point_t *point = &device->points[device->members[request->first_member + m]];
+                fill_write_data(point, pdu + 6, point->config->offset - request->address);
+            }
+            transaction->request_len = 6 + byte_count;
+            break;
+        }
+        default: /* Reads */
+            put_u16(pdu + 3, request->quantity);
+            transaction->request_len = 5;
+            break;
+    }
+}
+
+/**
+ * @brief Coalesce the points due at `tick` into requests
+ *
+ * @return Number of requests
+ */
+static int plan_requests(mm_device_t *device, unsigned long tick)
+{
+    int num_requests = 0;
+    int num_members = 0;
+
+    for (int i = 0; i < device->num_points; i++) {
+        const mm_point_t *point = &device->points[i];
+        if (tick % (unsigned long)point->period != 0) {
+            continue;
+        }
+
+        int fc = point->config->fc;
+        int start = point->config->offset;
+        int end = start + point->quantity;
+        mm_request_t *last = num_requests > 0 ? &device->requests[num_requests - 1] : NULL;
+
+        /* Points are sorted by (fc, offset): only the last request can absorb this one */
+        if (last != NULL && last->fc == fc && max_quantity(fc) > 1 &&
+            start <= last->address + last->quantity) {
+            int merged_end = end > last->address + last->quantity ? end : last->address + last->quantity;
+            if (merged_end - last->address <= max_quantity(fc)) {
+                last->quantity = merged_end - last->address;
+                last->num_members++;
+                device->members[num_members++] = i;
+                continue;
+            }
+        }
+
+        mm_request_t *request = &device->requests[num_requests++];
+        request->fc = fc;
+        request->address = start;
+        request->quantity = max_quantity(fc) > 1 ? point->quantity : 1;
+        request->first_member = num_members;
+        request->num_members = 1;
+        device->members[num_members++] = i;
+    }
+    return num_requests;
+}
+
+/**
+ * @brief Store the data of an answered read request
+ */
+static void store_read_response(const mm_device_t *device, const mm_request_t *request,
+                                const modbus_tcp_transaction_t *transaction)
+{
+    const uint8_t *response = transaction->response;
+    bool bits = is_bit_fc(request->fc);
+    int expected = bits ? (request->quantity + 7) / 8 : request->quantity * 2;
+
+    if (transaction->response_len < 2 + expected || response[1] != expected) {
+        plugin_logger_error_limited(&g_logger, "[%s] Malformed response (FC %d, addr %d)",
+                                    device->config->name, request->fc, request->address);
+        return;
+    }
+
+    for (int m = 0; m < request->num_members; m++) {
+        const mm_point_t *point = &device->points[device->members[request->first_member + m]];
+        const modbus_master_iec_location_t *location = &point->config->iec_location;
+        int pos = point->config->offset - request->address;
+
+        if (bits) {
+            uint8_t scratch[MM_MAX_READ_BITS / 8 + 1];
+            image_journal_bits(&g_runtime_args, point->journal_type, location->index, location->bit,
+                               point->quantity, response + 2, pos, scratch);
+        } else {
+            uint64_t elements[MM_MAX_READ_REGISTERS];
+            registers_to_elements(response + 2 + 2 * pos, location->size, point->config->length, elements);
+            g_runtime_args.journal_write_range(point->journal_type, location->index, point->config->length,
+                                               elements);
+        }
+    }
+}
+
+/*
+ * =============================================================================
+ * Device Threads
+ * =============================================================================
+ */
+
+/**
+ * @brief Sleep until `deadline` or until the plugin is stopped
+ *
+ * @return false if the plugin is stopping
+ */
+static bool wait_until(const struct timespec *deadline)
+{
+    pthread_mutex_lock(&g_stop_mutex);
+    while (g_running) {
+        if (pthread_cond_timedwait(&g_stop_cond, &g_stop_mutex, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    bool running = g_running;
+    pthread_mutex_unlock(&g_stop_mutex);
+    return running;
+}
+
+static void add_ms(struct timespec *ts, int ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static bool ensure_connection(mm_device_t *device)
+{
+    if (device->client.fd >= 0) {
+        return true;
+    }
+
+    const modbus_master_device_t *config = device->config;
+    if (modbus_tcp_client_connect(&device->client, config->host, config->port) == 0) {
+        plugin_logger_info(&g_logger, "[%s] Connected to %s:%d", config->name, config->host, config->port);
+        device->retry_delay_ms = MM_RETRY_DELAY_BASE_MS;
+        return true;
+    }
+
+    plugin_logger_warn_limited(&g_logger, "[%s] Cannot connect to %s:%d: %s", config->name,
+                               config->host, config->port, strerror(errno));
+    return false;
+}
+
+/**
+ * @brief Run the requests of one tick
+ */
+static void poll_tick(mm_device_t *device, unsigned long tick)
+{
+    int num_requests = plan_requests(device, tick);
+    if (num_requests == 0) {
+        return;
+    }
+
+    for (int r = 0; r < num_requests; r++) {
+        build_request(device, &device->requests[r], &device->transactions[r]);
+    }
+
+    int result = modbus_tcp_client_execute(&device->client, device->transactions, num_requests);
+    if (result != 0) {
+        plugin_logger_error_limited(&g_logger, "[%s] Communication error: %s, reconnecting",
+                                    device->config->name, strerror(errno));
+        modbus_tcp_client_close(&device->client);
+    }
+
+    /* Answered requests are stored even if the batch failed part way */
+    for (int r = 0; r < num_requests; r++) {
+        const mm_request_t *request = &device->requests[r];
+        const modbus_tcp_transaction_t *transaction = &device->transactions[r];
+
+        if (transaction->response_len == 0) {
+            continue;
+        }
+        if (transaction->response[0] == (request->fc | 0x80) && transaction->response_len >= 2) {
+            plugin_logger_error_limited(&g_logger, "[%s] Modbus exception %d (FC %d, addr %d, qty %d)",
+                                        device->config->name, transaction->response[1], request->fc,
+                                        request->address, request->quantity);
+            continue;
+        }
+        if (transaction->response[0] != request->fc) {
+            plugin_logger_error_limited(&g_logger, "[%s] Unexpected response (FC %d, addr %d)",
+                                        device->config->name, request->fc, request->address);
+            continue;
+        }
+        if (is_read_fc(request->fc)) {
+            store_read_response(device, request, transaction);
+        }
+    }
+}
+
+static void *device_thread(void *arg)
+{
+    mm_device_t *device = (mm_device_t *)arg;
+    unsigned long tick = 0;
+    struct timespec next;
+
+    plugin_logger_info(&g_logger, "[%s] Thread started (tick %d ms)", device->config->name, device->tick_ms);
+
+    while (g_running) {
+        if (!ensure_connection(device)) {
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            add_ms(&next, device->retry_delay_ms);
+            device->retry_delay_ms = device->retry_delay_ms * 3 / 2;
+            if (device->retry_delay_ms > MM_RETRY_DELAY_MAX_MS) {
+                device->retry_delay_ms = MM_RETRY_DELAY_MAX_MS;
+            }
+            if (!wait_until(&next)) {
+                break;
+            }
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        add_ms(&next, device->tick_ms);
+
+        poll_tick(device, tick);
+        tick++;
+
+        if (!wait_until(&next)) {
+            break;
+        }
+    }
+
+    modbus_tcp_client_close(&device->client);
+    plugin_logger_info(&g_logger, "[%s] Thread finished and connection closed", device->config->name);
+    return NULL;
+}
+
+/*
+ * =============================================================================
+ * Device Setup
+ * =============================================================================
+ */
+
+static int gcd(int a, int b)
+{
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int compare_points(const void *a, const void *b)
+{
+    const mm_point_t *pa = (const mm_point_t *)a;
+    const mm_point_t *pb = (const mm_point_t *)b;
+
+    if (pa->config->fc != pb->config->fc) {
+        return pa->config->fc - pb->config->fc;
+    }
+    return pa->config->offset - pb->config->offset;
+}
+
+/**
+ * @brief Check an I/O point and compute its quantity and journal type
+ *
+ * @return false (logged) if the point cannot be polled
+ */
+static bool prepare_point(const modbus_master_device_t *config, const modbus_master_io_point_t *io,
+                          mm_point_t *point)
+{
+    const modbus_master_iec_location_t *location = &io->iec_location;
+    int limit = max_quantity(io->fc);
+
+    if (limit == 0) {
+        plugin_logger_error(&g_logger, "[%s] Unsupported FC %d, point ignored", config->name, io->fc);
+        return false;
+    }
+    if (is_bit_fc(io->fc) != (location->size == 'X')) {
+        plugin_logger_error(&g_logger, "[%s] FC %d cannot use %%%c%c%d, point ignored", config->name,
+                            io->fc, location->area, location->size, location->index);
+        return false;
+    }
+
+    point->config = io;
+    point->journal_type = journal_type_of(location);
+    if (point->journal_type < 0) {
+        plugin_logger_error(&g_logger, "[%s] %%M%c locations are not supported, point ignored",
+                            config->name, location->size);
+        return false;
+    }
+
+    point->quantity = location->size == 'X' ? io->length : io->length * registers_per_element(location->size);
+    if (limit > 1 && point->quantity > limit) {
+        plugin_logger_error(&g_logger, "[%s] FC %d at %d: %d exceeds the %d per request, point ignored",
+                            config->name, io->fc, io->offset, point->quantity, limit);
+        return false;
+    }
+    if (io->offset + (limit > 1 ? point->quantity : 1) > 0x10000) {
+        plugin_logger_error(&g_logger, "[%s] FC %d at %d exceeds the address space, point ignored",
+                            config->name, io->fc, io->offset);
+        return false;
+    }
+
+    int last_index = location->size == 'X' ? location->index + (location->bit + io->length - 1) / 8
+                                           : location->index + io->length - 1;
+    if (last_index >= g_runtime_args.buffer_size) {
+        plugin_logger_error(&g_logger, "[%s] %%%c%c%d + %d exceeds the image table, point ignored",
+                            config->name, location->area, location->size, location->index, io->length);
+        return false;
+    }
+    return true;
+}
+
+static void free_device(mm_device_t *device)
+{
+    free(device->points);
+    free(device->requests);
+    free(device->transactions);
+    free(device->members);
+    memset(device, 0, sizeof(mm_device_t));
+    device->client.fd = -1;
+}
+
+/**
+ * @brief Prepare the runtime state of one device
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int setup_device(const modbus_master_device_t *config, mm_device_t *device)
+{
+    memset(device, 0, sizeof(mm_device_t));
+    device->config = config;
+    modbus_tcp_client_init(&device->client, (uint8_t)config->unit_id, config->timeout_ms,
+                           config->pipeline_depth);
+    device->retry_delay_ms = MM_RETRY_DELAY_BASE_MS;
+
+    int n = config->num_io_points;
+    if (n == 0) {
+        return 0;
+    }
+
+    device->points = (mm_point_t *)calloc((size_t)n, sizeof(mm_point_t));
+    device->requests = (mm_request_t *)calloc((size_t)n, sizeof(mm_request_t));
+    device->transactions = (modbus_tcp_transaction_t *)calloc((size_t)n, sizeof(modbus_tcp_transaction_t));
+    device->members = (int *)calloc((size_t)n, sizeof(int));
+    if (!device->points || !device->requests || !device->transactions || !device->members) {
+        free_device(device);
+        return -1;
+    }
+
+    device->tick_ms = 0;
+    for (int i = 0; i < n; i++) {
+        if (prepare_point(config, &config->io_points[i], &device->points[device->num_points])) {
+            device->tick_ms = gcd(device->tick_ms, config->io_points[i].cycle_time_ms);
+            device->num_points++;
+        }
+    }
+    for (int i = 0; i < device->num_points; i++) {
+        device->points[i].period = device->points[i].config->cycle_time_ms / device->tick_ms;
+    }
+    qsort(device->points, (size_t)device->num_points, sizeof(mm_point_t), compare_points);
+    return 0;
+}
+
+/*
+ * =============================================================================
+ * Plugin Lifecycle Functions
+ * =============================================================================
+ */
+
+/**
+ * @brief Initialize the Modbus master plugin
+ */
+int init(void *args)
+{
+    /* Initialize logger first (before we have runtime_args) */
+    plugin_logger_init(&g_logger, "MODBUS_MASTER", NULL);
+    plugin_logger_info(&g_logger, "Initializing Modbus master plugin...");
+
+    if (!args) {
+        plugin_logger_error(&g_logger, "init args is NULL");
+        return -1;
+    }
+
+    /* Copy runtime args (critical - pointer is freed after init returns) */
+    memcpy(&g_runtime_args, args, sizeof(plugin_runtime_args_t));
+
+    /* Re-initialize logger with runtime_args for central logging */
+    plugin_logger_init(&g_logger, "MODBUS_MASTER", args);
+
+    const char *config_path = g_runtime_args.plugin_specific_config_file_path;
+    plugin_logger_info(&g_logger, "Loading config: %s", config_path);
+    int result = modbus_master_config_parse(config_path, &g_config);
+    if (result != 0) {
+        plugin_logger_error(&g_logger, "Failed to load config file (error %d)", result);
+        modbus_master_config_free(&g_config);
+        return -1;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_stop_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    g_num_devices = 0;
+    for (int i = 0; i < g_config.num_devices; i++) {
+        mm_device_t *device = &g_devices[g_num_devices];
+        if (setup_device(&g_config.devices[i], device) != 0) {
+            plugin_logger_error(&g_logger, "[%s] Failed to allocate device state", g_config.devices[i].name);
+            continue;
+        }
+        g_num_devices++;
+        plugin_logger_info(&g_logger, "[%s] %s:%d, %d I/O point(s), tick %d ms, pipeline depth %d",
+                           device->config->name, device->config->host, device->config->port,
+                           device->num_points, device->tick_ms, device->config->pipeline_depth);
+    }
+
+    g_initialized = true;
+    plugin_logger_info(&g_logger, "Configuration loaded successfully: %d device(s)", g_num_devices);
+    return 0;
+}
+
+/**
+ * @brief Start one polling thread per device
+ */
+void start_loop(void)
+{
+    if (!g_initialized) {
+        plugin_logger_error(&g_logger, "Cannot start - plugin not initialized");
+        return;
+    }
+
+    if (g_running) {
+        plugin_logger_warn(&g_logger, "Already running");
+        return;
+    }
+
+    g_running = true;
+    int started = 0;
+    for (int i = 0; i < g_num_devices; i++) {
+        mm_device_t *device = &g_devices[i];
+        if (device->num_points == 0) {
+            plugin_logger_warn(&g_logger, "[%s] No I/O points defined, not polled", device->config->name);
+            continue;
+        }
+        if (pthread_create(&device->thread, NULL, device_thread, device) != 0) {
+            plugin_logger_error(&g_logger, "[%s] Failed to create thread", device->config->name);
+            continue;
+        }
+        device->thread_started = true;
+        started++;
+    }
+
+    plugin_logger_info(&g_logger, "Started %d device thread(s)", started);
+}
+
+/**
+ * @brief Stop the polling threads
+ */
+void stop_loop(void)
+{
+    if (!g_running) {
+        plugin_logger_debug(&g_logger, "Already stopped");
+        return;
+    }
+
+    pthread_mutex_lock(&g_stop_mutex);
+    g_running = false;
+    pthread_cond_broadcast(&g_stop_cond);
+    pthread_mutex_unlock(&g_stop_mutex);
+
+    for (int i = 0; i < g_num_devices; i++) {
+        if (g_devices[i].thread_started) {
+            pthread_join(g_devices[i].thread, NULL);
+            g_devices[i].thread_started = false;
+        }
+    }
+    plugin_logger_info(&g_logger, "Main loop stopped");
+}
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void)
+{
+    if (g_running) {
+        stop_loop();
+    }
+
+    for (int i = 0; i < g_num_devices; i++) {
+        free_device(&g_devices[i]);
+    }
+    g_num_devices = 0;
+
+    if (g_initialized) {
+        pthread_cond_destroy(&g_stop_cond);
+    }
+    modbus_master_config_free(&g_config);
+    g_initialized = false;
+    plugin_logger_info(&g_logger, "Modbus master plugin cleanup complete");
+}
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ */
+void cycle_start(void)
+{
+    /* Read results are applied by the journal */
+}
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ */
+void cycle_end(void)
+{
+    /* Write values come from the runtime's snapshot */
+}
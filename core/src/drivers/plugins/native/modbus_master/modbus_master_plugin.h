@@ -0,0 +1,67 @@
+/**
+ * @file modbus_master_plugin.h
+ * @brief Native Modbus TCP Master Plugin for OpenPLC Runtime v4
+ *
+ * This plugin polls Modbus TCP slave devices configured with the same
+ * modbus_master.json file as the Python modbus_master plugin, coalescing
+ * adjacent I/O points into block requests and pipelining them.
+ */
+
+#ifndef MODBUS_MASTER_PLUGIN_H
+#define MODBUS_MASTER_PLUGIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the Modbus master plugin
+ *
+ * Called when the plugin is loaded. Parses the device list and prepares
+ * the I/O points of every device.
+ *
+ * @param args Pointer to plugin_runtime_args_t containing runtime buffers,
+ *             mutex functions, and logging function pointers
+ * @return 0 on success, -1 on failure
+ */
+int init(void *args);
+
+/**
+ * @brief Start polling
+ *
+ * Starts one thread per device; each connects (retrying with backoff) and
+ * polls its I/O points.
+ */
+void start_loop(void);
+
+/**
+ * @brief Stop polling
+ *
+ * Stops the device threads and closes their connections.
+ */
+void stop_loop(void);
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void);
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ *
+ * Nothing to do: read results reach the image tables through the journal.
+ */
+void cycle_start(void);
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Nothing to do: written values come from the runtime's per-scan snapshot.
+ */
+void cycle_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_MASTER_PLUGIN_H */
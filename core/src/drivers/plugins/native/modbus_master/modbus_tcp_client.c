@@ -0,0 +1,243 @@
+/**
+ * @file modbus_tcp_client.c
+ * @brief Pipelined Modbus TCP client implementation
+ *
+ * The socket is non-blocking; every wait goes through poll() with the
+ * device timeout, so a silent slave costs at most one timeout per batch.
+ */
+
+#define _GNU_SOURCE
+
+#include "modbus_tcp_client.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* MBAP header: transaction id, protocol id, length, unit id */
+#define MBAP_HEADER_SIZE    7
+#define MODBUS_TCP_MAX_ADU  (MBAP_HEADER_SIZE + MODBUS_TCP_MAX_PDU)
+
+#define CLIENT_RX_SIZE      (4 * MODBUS_TCP_MAX_ADU)
+#define CLIENT_TX_MAX_DEPTH 64
+
+void modbus_tcp_client_init(modbus_tcp_client_t *client, uint8_t unit_id, int timeout_ms,
+                            int pipeline_depth)
+{
+    client->fd = -1;
+    client->unit_id = unit_id;
+    client->timeout_ms = timeout_ms;
+    client->pipeline_depth = pipeline_depth < 1 ? 1
+                           : pipeline_depth > CLIENT_TX_MAX_DEPTH ? CLIENT_TX_MAX_DEPTH
+                           : pipeline_depth;
+    client->next_transaction_id = 1;
+}
+
+/**
+ * @brief Wait until the socket is ready for `events`
+ *
+ * @return 0 when ready, -1 on timeout (errno ETIMEDOUT) or error
+ */
+static int wait_socket(int fd, short events, int timeout_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    for (;;) {
+        int result = poll(&pfd, 1, timeout_ms);
+        if (result > 0) {
+            return 0;
+        }
+        if (result == 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static int connect_address(const struct addrinfo *ai, int timeout_ms)
+{
+    int fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        if (errno != EINPROGRESS || wait_socket(fd, POLLOUT, timeout_ms) != 0) {
+            close(fd);
+            return -1;
+        }
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+            close(fd);
+            errno = error;
+            return -1;
+        }
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int modbus_tcp_client_connect(modbus_tcp_client_t *client, const char *host, uint16_t port)
+{
+    modbus_tcp_client_close(client);
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(host, service, &hints, &result) != 0) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+
+    for (const struct addrinfo *ai = result; ai != NULL && client->fd < 0; ai = ai->ai_next) {
+        client->fd = connect_address(ai, client->timeout_ms);
+    }
+    freeaddrinfo(result);
+
+    return client->fd >= 0 ? 0 : -1;
+}
+
+void modbus_tcp_client_close(modbus_tcp_client_t *client)
+{
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+}
+
+static int send_all(modbus_tcp_client_t *client, const uint8_t *data, int len)
+{
+    int off = 0;
+
+    while (off < len) {
+        ssize_t sent = send(client->fd, data + off, (size_t)(len - off), MSG_NOSIGNAL);
+        if (sent > 0) {
+            off += (int)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (wait_socket(client->fd, POLLOUT, client->timeout_ms) != 0) {
+                return -1;
+            }
+            continue;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int modbus_tcp_client_execute(modbus_tcp_client_t *client, modbus_tcp_transaction_t *transactions,
+                              int count)
+{
+    uint8_t tx[CLIENT_TX_MAX_DEPTH * MODBUS_TCP_MAX_ADU];
+    uint8_t rx[CLIENT_RX_SIZE];
+    int rx_len = 0;
+    int sent = 0;
+    int answered = 0;
+
+    if (client->fd < 0) {
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    /* Transaction ids base + 0 .. base + count - 1 identify the requests */
+    uint16_t base = client->next_transaction_id;
+    client->next_transaction_id = (uint16_t)(base + count);
+    for (int i = 0; i < count; i++) {
+        transactions[i].response_len = 0;
+    }
+
+    while (answered < count) {
+        /* Top up the requests in flight */
+        int tx_len = 0;
+        while (sent < count && sent - answered < client->pipeline_depth) {
+            const modbus_tcp_transaction_t *t = &transactions[sent];
+            uint16_t tid = (uint16_t)(base + sent);
+            uint8_t *adu = tx + tx_len;
+
+            adu[0] = (uint8_t)(tid >> 8);
+            adu[1] = (uint8_t)(tid & 0xFF);
+            adu[2] = 0;
+            adu[3] = 0;
+            adu[4] = (uint8_t)((t->request_len + 1) >> 8);
+            adu[5] = (uint8_t)((t->request_len + 1) & 0xFF);
+            adu[6] = client->unit_id;
+            memcpy(adu + MBAP_HEADER_SIZE, t->request, (size_t)t->request_len);
+            tx_len += MBAP_HEADER_SIZE + t->request_len;
+            sent++;
+        }
+        if (tx_len > 0 && send_all(client, tx, tx_len) != 0) {
+            return -1;
+        }
+
+        if (wait_socket(client->fd, POLLIN, client->timeout_ms) != 0) {
+            return -1;
+        }
+        ssize_t got = recv(client->fd, rx + rx_len, (size_t)(CLIENT_RX_SIZE - rx_len), 0);
+        if (got == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (got < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        rx_len += (int)got;
+
+        /* Match every complete response to its request */
+        int pos = 0;
+        while (rx_len - pos >= MBAP_HEADER_SIZE) {
+            const uint8_t *frame = rx + pos;
+            int protocol = (frame[2] << 8) | frame[3];
+            int length = (frame[4] << 8) | frame[5];
+
+            if (protocol != 0 || length < 2 || length > MODBUS_TCP_MAX_PDU + 1) {
+                errno = EPROTO;
+                return -1;
+            }
+            if (rx_len - pos < 6 + length) {
+                break;
+            }
+
+            uint16_t index = (uint16_t)(((frame[0] << 8) | frame[1]) - base);
+            if (index < sent && transactions[index].response_len == 0) {
+                memcpy(transactions[index].response, frame + MBAP_HEADER_SIZE, (size_t)(length - 1));
+                transactions[index].response_len = length - 1;
+                answered++;
+            }
+            pos += 6 + length;
+        }
+        if (pos > 0) {
+            memmove(rx, rx + pos, (size_t)(rx_len - pos));
+            rx_len -= pos;
+        }
+    }
+    return 0;
+}
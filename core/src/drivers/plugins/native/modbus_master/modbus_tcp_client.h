@@ -0,0 +1,75 @@
+/**
+ * @file modbus_tcp_client.h
+ * @brief Pipelined Modbus TCP client for the Modbus master plugin
+ *
+ * A batch of requests is exchanged with up to `pipeline_depth` of them in
+ * flight at once; responses are matched to their requests by transaction
+ * id, so a batch costs about one round trip per `pipeline_depth` requests
+ * instead of one per request.
+ */
+
+#ifndef MODBUS_TCP_CLIENT_H
+#define MODBUS_TCP_CLIENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest PDU (function code + data) of a Modbus TCP frame */
+#define MODBUS_TCP_MAX_PDU  253
+
+typedef struct {
+    uint8_t request[MODBUS_TCP_MAX_PDU];    /* Request PDU, starting with the function code */
+    int request_len;
+    uint8_t response[MODBUS_TCP_MAX_PDU];   /* Response PDU */
+    int response_len;                       /* 0 until answered */
+} modbus_tcp_transaction_t;
+
+typedef struct {
+    int fd;                                 /* -1 when disconnected */
+    uint8_t unit_id;
+    int timeout_ms;
+    int pipeline_depth;
+    uint16_t next_transaction_id;
+} modbus_tcp_client_t;
+
+/**
+ * @brief Initialize a disconnected client
+ */
+void modbus_tcp_client_init(modbus_tcp_client_t *client, uint8_t unit_id, int timeout_ms,
+                            int pipeline_depth);
+
+/**
+ * @brief Connect to host:port within the client timeout
+ *
+ * @return 0 on success, -1 on failure (errno is set)
+ */
+int modbus_tcp_client_connect(modbus_tcp_client_t *client, const char *host, uint16_t port);
+
+/**
+ * @brief Close the connection
+ */
+void modbus_tcp_client_close(modbus_tcp_client_t *client);
+
+/**
+ * @brief Exchange a batch of requests
+ *
+ * Responses (including exception responses) are stored in the
+ * transactions. If a response does not arrive within the client timeout or
+ * the connection fails, the remaining transactions keep response_len 0 and
+ * -1 is returned; the caller must close and reconnect, since the stream
+ * position is lost.
+ *
+ * @return 0 if every request was answered, -1 on timeout or connection error
+ */
+int modbus_tcp_client_execute(modbus_tcp_client_t *client, modbus_tcp_transaction_t *transactions,
+                              int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_TCP_CLIENT_H */
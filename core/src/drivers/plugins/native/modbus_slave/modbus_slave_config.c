@@ -0,0 +1,325 @@
+/**
+ * @file modbus_slave_config.c
+ * @brief Modbus Slave Plugin Configuration Parser Implementation
+ *
+ * Parses JSON configuration files using cJSON library.
+ */
+
+#include "modbus_slave_config.h"
+#include "cJSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Error codes */
+#define MODBUS_SLAVE_CONFIG_OK              0
+#define MODBUS_SLAVE_CONFIG_ERR_FILE       -1
+#define MODBUS_SLAVE_CONFIG_ERR_PARSE      -2
+#define MODBUS_SLAVE_CONFIG_ERR_INVALID    -4
+
+/* Modbus addresses are 16-bit */
+#define MODBUS_SLAVE_ADDRESS_SPACE  65536
+
+/**
+ * @brief Read entire file into a string
+ */
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size > 1024 * 1024) { /* Max 1MB config file */
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    fclose(fp);
+
+    if ((long)read_size != size) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[size] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Safely copy string with length limit
+ */
+static void safe_strcpy(char *dest, const char *src, size_t max_len)
+{
+    if (src == NULL) {
+        dest[0] = '\0';
+        return;
+    }
+    strncpy(dest, src, max_len - 1);
+    dest[max_len - 1] = '\0';
+}
+
+/**
+ * @brief Get string value from JSON object
+ */
+static const char *get_string(const cJSON *obj, const char *key, const char *default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring != NULL) {
+        return item->valuestring;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get integer value from JSON object
+ */
+static int get_int(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) {
+        return item->valueint;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get boolean value from JSON object
+ */
+static bool get_bool(const cJSON *obj, const char *key, bool default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsBool(item)) {
+        return cJSON_IsTrue(item);
+    }
+    return default_val;
+}
+
+/**
+ * @brief Parse network_configuration section from JSON
+ */
+static void parse_network_section(const cJSON *network, modbus_slave_config_t *config)
+{
+    if (network == NULL) {
+        return;
+    }
+
+    config->enabled = get_bool(network, "enabled", true);
+    safe_strcpy(config->host, get_string(network, "host", "0.0.0.0"), MODBUS_SLAVE_MAX_STRING_LEN);
+    config->port = (uint16_t)get_int(network, "port", MODBUS_SLAVE_DEFAULT_PORT);
+    config->max_clients = get_int(network, "max_clients", MODBUS_SLAVE_DEFAULT_MAX_CLIENTS);
+    config->unit_id = get_int(network, "unit_id", MODBUS_SLAVE_DEFAULT_UNIT_ID);
+    config->idle_timeout_s = get_int(network, "idle_timeout_s", MODBUS_SLAVE_DEFAULT_IDLE_TIMEOUT);
+}
+
+/**
+ * @brief Parse buffer_mapping section from JSON
+ *
+ * The segmented format has one object per Modbus table. The legacy format
+ * (max_coils, max_holding_registers, ...) maps them to %QX, %IX, %IW and
+ * %QW only, as the Python plugin does.
+ */
+static void parse_buffer_mapping_section(const cJSON *mapping, modbus_slave_config_t *config)
+{
+    if (mapping == NULL) {
+        return;
+    }
+
+    const cJSON *hr = cJSON_GetObjectItemCaseSensitive(mapping, "holding_registers");
+    if (cJSON_IsObject(hr)) {
+        const cJSON *coils = cJSON_GetObjectItemCaseSensitive(mapping, "coils");
+        const cJSON *di = cJSON_GetObjectItemCaseSensitive(mapping, "discrete_inputs");
+        const cJSON *ir = cJSON_GetObjectItemCaseSensitive(mapping, "input_registers");
+
+        config->qw_count = get_int(hr, "qw_count", MODBUS_SLAVE_DEFAULT_QW_COUNT);
+        config->mw_count = get_int(hr, "mw_count", MODBUS_SLAVE_DEFAULT_MW_COUNT);
+        config->md_count = get_int(hr, "md_count", MODBUS_SLAVE_DEFAULT_MD_COUNT);
+        config->ml_count = get_int(hr, "ml_count", MODBUS_SLAVE_DEFAULT_ML_COUNT);
+        config->qx_bits = get_int(coils, "qx_bits", MODBUS_SLAVE_DEFAULT_QX_BITS);
+        config->mx_bits = get_int(coils, "mx_bits", MODBUS_SLAVE_DEFAULT_MX_BITS);
+        config->ix_bits = get_int(di, "ix_bits", MODBUS_SLAVE_DEFAULT_IX_BITS);
+        config->iw_count = get_int(ir, "iw_count", MODBUS_SLAVE_DEFAULT_IW_COUNT);
+        return;
+    }
+
+    /* Legacy format, no memory locations */
+    config->qx_bits = get_int(mapping, "max_coils", MODBUS_SLAVE_DEFAULT_QX_BITS);
+    config->mx_bits = 0;
+    config->ix_bits = get_int(mapping, "max_discrete_inputs", MODBUS_SLAVE_DEFAULT_IX_BITS);
+    config->iw_count = get_int(mapping, "max_input_registers", MODBUS_SLAVE_DEFAULT_IW_COUNT);
+    config->qw_count = get_int(mapping, "max_holding_registers", MODBUS_SLAVE_DEFAULT_QW_COUNT);
+    config->mw_count = 0;
+    config->md_count = 0;
+    config->ml_count = 0;
+}
+
+/**
+ * @brief Parse logging section from JSON
+ */
+static void parse_logging_section(const cJSON *logging, modbus_slave_config_t *config)
+{
+    if (logging == NULL) {
+        return;
+    }
+
+    config->log_connections = get_bool(logging, "log_connections", true);
+}
+
+void modbus_slave_config_init_defaults(modbus_slave_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    memset(config, 0, sizeof(modbus_slave_config_t));
+
+    /* Server defaults */
+    config->enabled = true;
+    safe_strcpy(config->host, "0.0.0.0", MODBUS_SLAVE_MAX_STRING_LEN);
+    config->port = MODBUS_SLAVE_DEFAULT_PORT;
+    config->max_clients = MODBUS_SLAVE_DEFAULT_MAX_CLIENTS;
+    config->unit_id = MODBUS_SLAVE_DEFAULT_UNIT_ID;
+    config->idle_timeout_s = MODBUS_SLAVE_DEFAULT_IDLE_TIMEOUT;
+
+    /* Mapping defaults */
+    config->qx_bits = MODBUS_SLAVE_DEFAULT_QX_BITS;
+    config->mx_bits = MODBUS_SLAVE_DEFAULT_MX_BITS;
+    config->ix_bits = MODBUS_SLAVE_DEFAULT_IX_BITS;
+    config->iw_count = MODBUS_SLAVE_DEFAULT_IW_COUNT;
+    config->qw_count = MODBUS_SLAVE_DEFAULT_QW_COUNT;
+    config->mw_count = MODBUS_SLAVE_DEFAULT_MW_COUNT;
+    config->md_count = MODBUS_SLAVE_DEFAULT_MD_COUNT;
+    config->ml_count = MODBUS_SLAVE_DEFAULT_ML_COUNT;
+    config->word_order = WORD_ORDER_HIGH_FIRST;
+
+    /* Logging defaults */
+    config->log_connections = true;
+}
+
+int modbus_slave_config_parse(const char *config_path, modbus_slave_config_t *config)
+{
+    if (config_path == NULL || config == NULL) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    /* Initialize with defaults */
+    modbus_slave_config_init_defaults(config);
+
+    /* Read file contents */
+    char *json_str = read_file(config_path);
+    if (json_str == NULL) {
+        return MODBUS_SLAVE_CONFIG_ERR_FILE;
+    }
+
+    /* Parse JSON */
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+
+    if (root == NULL) {
+        return MODBUS_SLAVE_CONFIG_ERR_PARSE;
+    }
+
+    /* Parse each section */
+    parse_network_section(cJSON_GetObjectItemCaseSensitive(root, "network_configuration"), config);
+    parse_buffer_mapping_section(cJSON_GetObjectItemCaseSensitive(root, "buffer_mapping"), config);
+    parse_logging_section(cJSON_GetObjectItemCaseSensitive(root, "logging"), config);
+
+    const char *word_order = get_string(root, "word_order", "high_word_first");
+    config->word_order = strcmp(word_order, "low_word_first") == 0 ? WORD_ORDER_LOW_FIRST
+                                                                   : WORD_ORDER_HIGH_FIRST;
+
+    cJSON_Delete(root);
+
+    /* Validate the parsed configuration */
+    return modbus_slave_config_validate(config);
+}
+
+int modbus_slave_config_validate(const modbus_slave_config_t *config)
+{
+    if (config == NULL) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    /* Validate port */
+    if (config->port == 0) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    /* Validate max_clients */
+    if (config->max_clients < 1 || config->max_clients > MODBUS_SLAVE_MAX_CLIENTS_LIMIT) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    /* Validate unit_id (0 answers any unit, 255 is the TCP "no unit" value) */
+    if (config->unit_id < 0 || config->unit_id > 255) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    if (config->idle_timeout_s < 0) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    /* Validate segment sizes */
+    if (config->qx_bits < 0 || config->mx_bits < 0 || config->ix_bits < 0 ||
+        config->iw_count < 0 || config->qw_count < 0 || config->mw_count < 0 ||
+        config->md_count < 0 || config->ml_count < 0) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    /* Every table must fit the 16-bit address space */
+    if ((long)config->qx_bits + config->mx_bits > MODBUS_SLAVE_ADDRESS_SPACE ||
+        config->ix_bits > MODBUS_SLAVE_ADDRESS_SPACE ||
+        config->iw_count > MODBUS_SLAVE_ADDRESS_SPACE ||
+        (long)config->qw_count + config->mw_count + 2L * config->md_count + 4L * config->ml_count >
+            MODBUS_SLAVE_ADDRESS_SPACE) {
+        return MODBUS_SLAVE_CONFIG_ERR_INVALID;
+    }
+
+    return MODBUS_SLAVE_CONFIG_OK;
+}
+
+void modbus_slave_config_clamp(modbus_slave_config_t *config, int buffer_size, int bits_per_buffer)
+{
+    if (config == NULL || buffer_size <= 0) {
+        return;
+    }
+
+    int max_bits = buffer_size * (bits_per_buffer > 0 ? bits_per_buffer : 8);
+
+    if (config->qx_bits > max_bits) {
+        config->qx_bits = max_bits;
+    }
+    if (config->mx_bits > max_bits) {
+        config->mx_bits = max_bits;
+    }
+    if (config->ix_bits > max_bits) {
+        config->ix_bits = max_bits;
+    }
+    if (config->iw_count > buffer_size) {
+        config->iw_count = buffer_size;
+    }
+    if (config->qw_count > buffer_size) {
+        config->qw_count = buffer_size;
+    }
+    if (config->mw_count > buffer_size) {
+        config->mw_count = buffer_size;
+    }
+    if (config->md_count > buffer_size) {
+        config->md_count = buffer_size;
+    }
+    if (config->ml_count > buffer_size) {
+        config->ml_count = buffer_size;
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file modbus_slave_config.h
+ * @brief Modbus Slave Plugin Configuration Structures and Parser
+ *
+ * Reads the same JSON file as the Python simple_modbus plugin (segmented
+ * or legacy buffer_mapping), plus a few settings of the native server.
+ */
+
+#ifndef MODBUS_SLAVE_CONFIG_H
+#define MODBUS_SLAVE_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configuration limits */
+#define MODBUS_SLAVE_MAX_STRING_LEN     64
+#define MODBUS_SLAVE_MAX_CLIENTS_LIMIT  1024
+
+/* Default values */
+#define MODBUS_SLAVE_DEFAULT_PORT           5020    /* Same as the Python plugin */
+#define MODBUS_SLAVE_DEFAULT_MAX_CLIENTS    32
+#define MODBUS_SLAVE_DEFAULT_UNIT_ID        1
+#define MODBUS_SLAVE_DEFAULT_IDLE_TIMEOUT   0       /* Seconds, 0 = never */
+
+/* Default segmentation (matches the Python plugin and v3) */
+#define MODBUS_SLAVE_DEFAULT_QX_BITS        8192
+#define MODBUS_SLAVE_DEFAULT_MX_BITS        0
+#define MODBUS_SLAVE_DEFAULT_IX_BITS        8192
+#define MODBUS_SLAVE_DEFAULT_IW_COUNT       1024
+#define MODBUS_SLAVE_DEFAULT_QW_COUNT       1024
+#define MODBUS_SLAVE_DEFAULT_MW_COUNT       1024
+#define MODBUS_SLAVE_DEFAULT_MD_COUNT       1024
+#define MODBUS_SLAVE_DEFAULT_ML_COUNT       1024
+
+/**
+ * @brief Order of the 16-bit words of %MD and %ML values
+ */
+typedef enum {
+    WORD_ORDER_HIGH_FIRST = 0,      /* High word at the lower address (v3 compatible) */
+    WORD_ORDER_LOW_FIRST
+} modbus_slave_word_order_t;
+
+/**
+ * @brief Complete Modbus slave configuration
+ *
+ * Coils are %QX bits followed by %MX bits; holding registers are %QW, %MW,
+ * %MD (2 registers per value) and %ML (4 registers per value) in that order.
+ */
+typedef struct {
+    /* Server settings */
+    bool enabled;                                   /* Enable/disable the server */
+    char host[MODBUS_SLAVE_MAX_STRING_LEN];         /* Network interface to bind */
+    uint16_t port;                                  /* Modbus TCP port */
+    int max_clients;                                /* Maximum simultaneous connections */
+    int unit_id;                                    /* Unit answered, 0 = any */
+    int idle_timeout_s;                             /* Close silent connections, 0 = never */
+
+    /* Coils */
+    int qx_bits;                                    /* %QX (bool_output) */
+    int mx_bits;                                    /* %MX (bool_memory) */
+
+    /* Discrete inputs */
+    int ix_bits;                                    /* %IX (bool_input) */
+
+    /* Input registers */
+    int iw_count;                                   /* %IW (int_input) */
+
+    /* Holding registers */
+    int qw_count;                                   /* %QW (int_output) */
+    int mw_count;                                   /* %MW (int_memory) */
+    int md_count;                                   /* %MD (dint_memory) values */
+    int ml_count;                                   /* %ML (lint_memory) values */
+    modbus_slave_word_order_t word_order;
+
+    /* Logging */
+    bool log_connections;
+} modbus_slave_config_t;
+
+/**
+ * @brief Parse configuration from JSON file
+ *
+ * @param config_path Path to the JSON configuration file
+ * @param config Pointer to configuration structure to populate
+ * @return 0 on success, negative error code on failure
+ */
+int modbus_slave_config_parse(const char *config_path, modbus_slave_config_t *config);
+
+/**
+ * @brief Validate configuration values
+ *
+ * @param config Pointer to configuration structure to validate
+ * @return 0 if valid, negative error code indicating the issue
+ */
+int modbus_slave_config_validate(const modbus_slave_config_t *config);
+
+/**
+ * @brief Initialize configuration with default values
+ *
+ * @param config Pointer to configuration structure to initialize
+ */
+void modbus_slave_config_init_defaults(modbus_slave_config_t *config);
+
+/**
+ * @brief Clamp the segment sizes to the runtime's image tables
+ *
+ * @param config Configuration to adjust
+ * @param buffer_size Elements per image table (plugin_runtime_args_t.buffer_size)
+ * @param bits_per_buffer Bits per BOOL element
+ */
+void modbus_slave_config_clamp(modbus_slave_config_t *config, int buffer_size, int bits_per_buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_SLAVE_CONFIG_H */
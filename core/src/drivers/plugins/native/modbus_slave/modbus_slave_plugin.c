@@ -0,0 +1,556 @@
+/**
+ * @file modbus_slave_plugin.c
+ * @brief Native Modbus TCP Slave Plugin Implementation
+ *
+ * Address map (same as the Python simple_modbus plugin):
+ * - Coils: %QX bits, then %MX bits
+ * - Discrete inputs: %IX bits
+ * - Input registers: %IW
+ * - Holding registers: %QW, %MW, %MD (2 registers each), %ML (4 registers each)
+ *
+ * Reads come from the runtime's lock-free per-scan snapshot, so a request
+ * never waits for the scan cycle; they fall back to a locked read of the
+ * pointer tables until the snapshot is available. Writes go through the
+ * journal and are applied at the start of the next scan.
+ */
+
+#include "modbus_slave_plugin.h"
+#include "bit_pack.h"
+#include "image_read.h"
+#include "modbus_slave_config.h"
+#include "modbus_tcp_server.h"
+#include "plugin_logger.h"
+#include "plugin_types.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Journal buffer types (matching journal_buffer_type_t) */
+#define MB_TYPE_BOOL_INPUT      0
+#define MB_TYPE_BOOL_OUTPUT     1
+#define MB_TYPE_BOOL_MEMORY     2
+#define MB_TYPE_INT_INPUT       5
+#define MB_TYPE_INT_OUTPUT      6
+#define MB_TYPE_INT_MEMORY      7
+#define MB_TYPE_DINT_MEMORY     10
+#define MB_TYPE_LINT_MEMORY     13
+
+/* Function codes */
+#define MB_FC_READ_COILS                0x01
+#define MB_FC_READ_DISCRETE_INPUTS      0x02
+#define MB_FC_READ_HOLDING_REGISTERS    0x03
+#define MB_FC_READ_INPUT_REGISTERS      0x04
+#define MB_FC_WRITE_SINGLE_COIL         0x05
+#define MB_FC_WRITE_SINGLE_REGISTER     0x06
+#define MB_FC_WRITE_MULTIPLE_COILS      0x0F
+#define MB_FC_WRITE_MULTIPLE_REGISTERS  0x10
+
+/* Exception codes */
+#define MB_EX_ILLEGAL_FUNCTION      0x01
+#define MB_EX_ILLEGAL_ADDRESS       0x02
+#define MB_EX_ILLEGAL_VALUE         0x03
+
+/* Quantity limits of the Modbus specification */
+#define MB_MAX_READ_BITS        2000
+#define MB_MAX_WRITE_BITS       1968
+#define MB_MAX_READ_REGISTERS   125
+#define MB_MAX_WRITE_REGISTERS  123
+
+#define MB_MAX_SEGMENTS         4
+
+/**
+ * @brief One image table area mapped into a Modbus table
+ *
+ * `words` is the number of registers per element for register tables
+ * (1, 2 or 4) and 0 for bit tables, whose `size` is counted in bits.
+ */
+typedef struct {
+    int type;                       /* Journal buffer type */
+    int words;
+    int size;                       /* Registers or bits in the Modbus table */
+} mb_segment_t;
+
+typedef struct {
+    mb_segment_t segments[MB_MAX_SEGMENTS];
+    int num_segments;
+    int size;                       /* Sum of the segment sizes */
+} mb_table_t;
+
+/* Plugin state */
+static plugin_logger_t g_logger;
+static plugin_runtime_args_t g_runtime_args;
+static modbus_slave_config_t g_config;
+static bool g_initialized = false;
+static bool g_running = false;
+
+static mb_table_t g_coils;
+static mb_table_t g_discrete_inputs;
+static mb_table_t g_input_registers;
+static mb_table_t g_holding_registers;
+
+/*
+ * =============================================================================
+ * Address Map
+ * =============================================================================
+ */
+
+static void add_segment(mb_table_t *table, int type, int words, int size)
+{
+    if (size <= 0) {
+        return;
+    }
+    mb_segment_t *segment = &table->segments[table->num_segments++];
+    segment->type = type;
+    segment->words = words;
+    segment->size = size;
+    table->size += size;
+}
+
+static void build_tables(void)
+{
+    memset(&g_coils, 0, sizeof(g_coils));
+    memset(&g_discrete_inputs, 0, sizeof(g_discrete_inputs));
+    memset(&g_input_registers, 0, sizeof(g_input_registers));
+    memset(&g_holding_registers, 0, sizeof(g_holding_registers));
+
+    add_segment(&g_coils, MB_TYPE_BOOL_OUTPUT, 0, g_config.qx_bits);
+    add_segment(&g_coils, MB_TYPE_BOOL_MEMORY, 0, g_config.mx_bits);
+    add_segment(&g_discrete_inputs, MB_TYPE_BOOL_INPUT, 0, g_config.ix_bits);
+    add_segment(&g_input_registers, MB_TYPE_INT_INPUT, 1, g_config.iw_count);
+    add_segment(&g_holding_registers, MB_TYPE_INT_OUTPUT, 1, g_config.qw_count);
+    add_segment(&g_holding_registers, MB_TYPE_INT_MEMORY, 1, g_config.mw_count);
+    add_segment(&g_holding_registers, MB_TYPE_DINT_MEMORY, 2, g_config.md_count * 2);
+    add_segment(&g_holding_registers, MB_TYPE_LINT_MEMORY, 4, g_config.ml_count * 4);
+}
+
+/*
+ * =============================================================================
+ * Table Access
+ * =============================================================================
+ */
+
+/**
+ * @brief Pack `quantity` bits starting at `address` into `out` (LSB first)
+ */
+static void read_bits(const mb_table_t *table, int address, int quantity, uint8_t *out)
+{
+    uint8_t bytes[MB_MAX_READ_BITS / 8 + 2];
+    int base = 0;
+
+    memset(out, 0, (size_t)((quantity + 7) / 8));
+    for (int s = 0; s < table->num_segments; s++) {
+        const mb_segment_t *segment = &table->segments[s];
+        int first = address > base ? address - base : 0;
+        int last = address + quantity - base < segment->size ? address + quantity - base : segment->size;
+
+        if (first < last) {
+            image_read_elements(&g_runtime_args, segment->type,
+                                first / 8, (last - 1) / 8 - first / 8 + 1, bytes);
+            bit_pack_copy(out, (size_t)(base + first - address), bytes, (size_t)(first % 8),
+                          (size_t)(last - first));
+        }
+        base += segment->size;
+    }
+}
+
+/**
+ * @brief Journal `quantity` bits starting at `address` (LSB first in `values`)
+ *
+ * Whole image table bytes go in one range write; the bits of partially
+ * covered bytes are written one by one so their other bits are kept.
+ */
+static void write_bits(const mb_table_t *table, int address, int quantity, const uint8_t *values)
+{
+    uint8_t bytes[MB_MAX_WRITE_BITS / 8 + 1];
+    int base = 0;
+
+    for (int s = 0; s < table->num_segments; s++) {
+        const mb_segment_t *segment = &table->segments[s];
+        int first = address > base ? address - base : 0;
+        int last = address + quantity - base < segment->size ? address + quantity - base : segment->size;
+
+        if (first < last) {
+            image_journal_bits(&g_runtime_args, segment->type, 0, first, last - first, values,
+                               base + first - address, bytes);
+        }
+        base += segment->size;
+    }
+}
+
+/**
+ * @brief Register `word` (0 = lowest address) of an element `words` registers wide
+ */
+static int register_shift(int words, int word)
+{
+    if (g_config.word_order == WORD_ORDER_HIGH_FIRST) {
+        return 16 * (words - 1 - word);
+    }
+    return 16 * word;
+}
+
+static uint64_t element_value(const void *elements, int words, int index)
+{
+    switch (words) {
+        case 1:
+            return ((const uint16_t *)elements)[index];
+        case 2:
+            return ((const uint32_t *)elements)[index];
+        default:
+            return ((const uint64_t *)elements)[index];
+    }
+}
+
+static void set_element_value(void *elements, int words, int index, uint64_t value)
+{
+    switch (words) {
+        case 1:
+            ((uint16_t *)elements)[index] = (uint16_t)value;
+            break;
+        case 2:
+            ((uint32_t *)elements)[index] = (uint32_t)value;
+            break;
+        default:
+            ((uint64_t *)elements)[index] = value;
+            break;
+    }
+}
+
+/**
+ * @brief Store `quantity` registers starting at `address` big-endian in `out`
+ */
+static void read_registers(const mb_table_t *table, int address, int quantity, uint8_t *out)
+{
+    uint64_t elements[MB_MAX_READ_REGISTERS + 1];
+    int base = 0;
+
+    for (int s = 0; s < table->num_segments; s++) {
+        const mb_segment_t *segment = &table->segments[s];
+        int first = address > base ? address - base : 0;
+        int last = address + quantity - base < segment->size ? address + quantity - base : segment->size;
+
+        if (first < last) {
+            int first_element = first / segment->words;
+            int count = (last - 1) / segment->words - first_element + 1;
+            image_read_elements(&g_runtime_args, segment->type, first_element, count, elements);
+
+            for (int reg = first; reg < last; reg++) {
+                uint64_t value = element_value(elements, segment->words, reg / segment->words - first_element);
+                uint16_t word = (uint16_t)(value >> register_shift(segment->words, reg % segment->words));
+                int pos = base + reg - address;
+                out[2 * pos] = (uint8_t)(word >> 8);
+                out[2 * pos + 1] = (uint8_t)(word & 0xFF);
+            }
+        }
+        base += segment->size;
+    }
+}
+
+/**
+ * @brief Journal `quantity` big-endian registers starting at `address`
+ *
+ * Registers covering part of a %MD or %ML value are merged with its current
+ * value, so a client may write one word of it.
+ */
+static void write_registers(const mb_table_t *table, int address, int quantity, const uint8_t *values)
+{
+    uint64_t elements[MB_MAX_WRITE_REGISTERS + 1];
+    int base = 0;
+
+    for (int s = 0; s < table->num_segments; s++) {
+        const mb_segment_t *segment = &table->segments[s];
+        int words = segment->words;
+        int first = address > base ? address - base : 0;
+        int last = address + quantity - base < segment->size ? address + quantity - base : segment->size;
+
+        if (first < last) {
+            int first_element = first / words;
+            int count = (last - 1) / words - first_element + 1;
+            if (first % words != 0 || last % words != 0) {
+                image_read_elements(&g_runtime_args, segment->type, first_element, count, elements);
+            } else {
+                memset(elements, 0, (size_t)count * (size_t)image_read_width(segment->type));
+            }
+
+            for (int reg = first; reg < last; reg++) {
+                int pos = base + reg - address;
+                uint64_t word = ((uint64_t)values[2 * pos] << 8) | values[2 * pos + 1];
+                int index = reg / words - first_element;
+                int shift = register_shift(words, reg % words);
+                uint64_t value = element_value(elements, words, index);
+                value = (value & ~(0xFFFFull << shift)) | (word << shift);
+                set_element_value(elements, words, index, value);
+            }
+            g_runtime_args.journal_write_range(segment->type, first_element, count, elements);
+        }
+        base += segment->size;
+    }
+}
+
+/*
+ * =============================================================================
+ * Request Handling
+ * =============================================================================
+ */
+
+static int exception_response(uint8_t function, uint8_t code, uint8_t *response)
+{
+    response[0] = (uint8_t)(function | 0x80);
+    response[1] = code;
+    return 2;
+}
+
+static int get_u16(const uint8_t *data)
+{
+    return (data[0] << 8) | data[1];
+}
+
+/**
+ * @brief Check quantity and address range of a request
+ *
+ * @return 0 if the request may be served, else the exception code
+ */
+static uint8_t check_range(const mb_table_t *table, int address, int quantity, int max_quantity)
+{
+    if (quantity < 1 || quantity > max_quantity) {
+        return MB_EX_ILLEGAL_VALUE;
+    }
+    if (address + quantity > table->size) {
+        return MB_EX_ILLEGAL_ADDRESS;
+    }
+    return 0;
+}
+
+/**
+ * @brief Serve one request PDU (modbus_tcp_handler_t)
+ */
+static int handle_request(uint8_t unit_id, const uint8_t *request, int length, uint8_t *response)
+{
+    if (g_config.unit_id != 0 && unit_id != g_config.unit_id) {
+        return 0; /* Not addressed to us */
+    }
+
+    uint8_t function = request[0];
+    if (length < 5) {
+        return exception_response(function, MB_EX_ILLEGAL_VALUE, response);
+    }
+    int address = get_u16(request + 1);
+    int value = get_u16(request + 3);
+    uint8_t ex;
+
+    switch (function) {
+        case MB_FC_READ_COILS:
+        case MB_FC_READ_DISCRETE_INPUTS: {
+            const mb_table_t *table = function == MB_FC_READ_COILS ? &g_coils : &g_discrete_inputs;
+            if ((ex = check_range(table, address, value, MB_MAX_READ_BITS)) != 0) {
+                return exception_response(function, ex, response);
+            }
+            response[0] = function;
+            response[1] = (uint8_t)((value + 7) / 8);
+            read_bits(table, address, value, response + 2);
+            return 2 + response[1];
+        }
+
+        case MB_FC_READ_HOLDING_REGISTERS:
+        case MB_FC_READ_INPUT_REGISTERS: {
+            const mb_table_t *table = function == MB_FC_READ_HOLDING_REGISTERS ? &g_holding_registers
+                                                                               : &g_input_registers;
+            if ((ex = check_range(table, address, value, MB_MAX_READ_REGISTERS)) != 0) {
+                return exception_response(function, ex, response);
+            }
+            response[0] = function;
+            response[1] = (uint8_t)(value * 2);
+            read_registers(table, address, value, response + 2);
+            return 2 + response[1];
+        }
+
+        case MB_FC_WRITE_SINGLE_COIL: {
+            if (value != 0xFF00 && value != 0x0000) {
+                return exception_response(function, MB_EX_ILLEGAL_VALUE, response);
+            }
+            if ((ex = check_range(&g_coils, address, 1, 1)) != 0) {
+                return exception_response(function, ex, response);
+            }
+            uint8_t bit = value == 0xFF00 ? 1 : 0;
+            write_bits(&g_coils, address, 1, &bit);
+            memcpy(response, request, 5); /* Echo */
+            return 5;
+        }
+
+        case MB_FC_WRITE_SINGLE_REGISTER: {
+            if ((ex = check_range(&g_holding_registers, address, 1, 1)) != 0) {
+                return exception_response(function, ex, response);
+            }
+            write_registers(&g_holding_registers, address, 1, request + 3);
+            memcpy(response, request, 5); /* Echo */
+            return 5;
+        }
+
+        case MB_FC_WRITE_MULTIPLE_COILS:
+        case MB_FC_WRITE_MULTIPLE_REGISTERS: {
+            bool coils = function == MB_FC_WRITE_MULTIPLE_COILS;
+            const mb_table_t *table = coils ? &g_coils : &g_holding_registers;
+            int byte_count = coils ? (value + 7) / 8 : value * 2;
+
+            if ((ex = check_range(table, address, value, coils ? MB_MAX_WRITE_BITS : MB_MAX_WRITE_REGISTERS)) != 0) {
+                return exception_response(function, ex, response);
+            }
+            if (length < 6 || request[5] != byte_count || length < 6 + byte_count) {
+                return exception_response(function, MB_EX_ILLEGAL_VALUE, response);
+            }
+            if (coils) {
+                write_bits(table, address, value, request + 6);
+            } else {
+                write_registers(table, address, value, request + 6);
+            }
+            memcpy(response, request, 5); /* Function, address, quantity */
+            return 5;
+        }
+
+        default:
+            return exception_response(function, MB_EX_ILLEGAL_FUNCTION, response);
+    }
+}
+
+/*
+ * =============================================================================
+ * Plugin Lifecycle Functions
+ * =============================================================================
+ */
+
+/**
+ * @brief Initialize the Modbus slave plugin
+ */
+int init(void *args)
+{
+    /* Initialize logger first (before we have runtime_args) */
+    plugin_logger_init(&g_logger, "MODBUS_SLAVE", NULL);
+    plugin_logger_info(&g_logger, "Initializing Modbus slave plugin...");
+
+    if (!args) {
+        plugin_logger_error(&g_logger, "init args is NULL");
+        return -1;
+    }
+
+    /* Copy runtime args (critical - pointer is freed after init returns) */
+    memcpy(&g_runtime_args, args, sizeof(plugin_runtime_args_t));
+
+    /* Re-initialize logger with runtime_args for central logging */
+    plugin_logger_init(&g_logger, "MODBUS_SLAVE", args);
+
+    /* Parse configuration file */
+    const char *config_path = g_runtime_args.plugin_specific_config_file_path;
+    if (config_path[0] == '\0') {
+        plugin_logger_warn(&g_logger, "No config file specified, using defaults");
+        modbus_slave_config_init_defaults(&g_config);
+    } else {
+        plugin_logger_info(&g_logger, "Loading config: %s", config_path);
+        int result = modbus_slave_config_parse(config_path, &g_config);
+        if (result != 0) {
+            plugin_logger_error(&g_logger, "Failed to parse config file (error %d)", result);
+            plugin_logger_warn(&g_logger, "Using default configuration");
+            modbus_slave_config_init_defaults(&g_config);
+        }
+    }
+
+    if (!g_config.enabled) {
+        plugin_logger_info(&g_logger, "Modbus slave is disabled in configuration");
+        g_initialized = true;
+        return 0;
+    }
+
+    modbus_slave_config_clamp(&g_config, g_runtime_args.buffer_size, g_runtime_args.bits_per_buffer);
+    build_tables();
+
+    plugin_logger_info(&g_logger, "Server config: %s:%d, max_clients=%d, unit_id=%d",
+                       g_config.host, g_config.port, g_config.max_clients, g_config.unit_id);
+    plugin_logger_info(&g_logger, "Coils: %d (QX %d, MX %d), discrete inputs: %d",
+                       g_coils.size, g_config.qx_bits, g_config.mx_bits, g_discrete_inputs.size);
+    plugin_logger_info(&g_logger, "Holding registers: %d (QW %d, MW %d, MD %d, ML %d), input registers: %d",
+                       g_holding_registers.size, g_config.qw_count, g_config.mw_count, g_config.md_count,
+                       g_config.ml_count, g_input_registers.size);
+
+    g_initialized = true;
+    return 0;
+}
+
+/**
+ * @brief Start the Modbus TCP server
+ */
+void start_loop(void)
+{
+    if (!g_initialized) {
+        plugin_logger_error(&g_logger, "Cannot start - plugin not initialized");
+        return;
+    }
+
+    if (!g_config.enabled) {
+        return;
+    }
+
+    if (g_running) {
+        plugin_logger_warn(&g_logger, "Server already running");
+        return;
+    }
+
+    modbus_tcp_server_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.host = g_config.host;
+    params.port = g_config.port;
+    params.max_clients = g_config.max_clients;
+    params.idle_timeout_s = g_config.idle_timeout_s;
+    params.log_connections = g_config.log_connections;
+    params.handler = handle_request;
+    params.logger = &g_logger;
+
+    if (modbus_tcp_server_start(&params) != 0) {
+        plugin_logger_error(&g_logger, "Failed to start Modbus server");
+        return;
+    }
+
+    g_running = true;
+    plugin_logger_info(&g_logger, "Modbus server listening on %s:%d", g_config.host, g_config.port);
+}
+
+/**
+ * @brief Stop the Modbus TCP server
+ */
+void stop_loop(void)
+{
+    if (!g_running) {
+        plugin_logger_debug(&g_logger, "Server already stopped");
+        return;
+    }
+
+    modbus_tcp_server_stop();
+    g_running = false;
+    plugin_logger_info(&g_logger, "Modbus server stopped");
+}
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void)
+{
+    if (g_running) {
+        stop_loop();
+    }
+    g_initialized = false;
+    plugin_logger_info(&g_logger, "Modbus slave plugin cleanup complete");
+}
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ */
+void cycle_start(void)
+{
+    /* Writes are applied by the journal */
+}
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ */
+void cycle_end(void)
+{
+    /* Reads use the runtime's snapshot */
+}
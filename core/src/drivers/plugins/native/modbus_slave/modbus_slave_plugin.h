@@ -0,0 +1,66 @@
+/**
+ * @file modbus_slave_plugin.h
+ * @brief Native Modbus TCP Slave Plugin for OpenPLC Runtime v4
+ *
+ * This plugin serves the OpenPLC image tables to Modbus TCP clients with the
+ * same address map as the Python simple_modbus plugin, without the Python
+ * interpreter and its per-request locking overhead.
+ */
+
+#ifndef MODBUS_SLAVE_PLUGIN_H
+#define MODBUS_SLAVE_PLUGIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the Modbus slave plugin
+ *
+ * Called when the plugin is loaded. Parses the configuration and sizes the
+ * address map to the runtime's image tables.
+ *
+ * @param args Pointer to plugin_runtime_args_t containing runtime buffers,
+ *             mutex functions, and logging function pointers
+ * @return 0 on success, -1 on failure
+ */
+int init(void *args);
+
+/**
+ * @brief Start the Modbus TCP server
+ *
+ * Binds the configured port (default: 5020) and starts the I/O thread.
+ */
+void start_loop(void);
+
+/**
+ * @brief Stop the Modbus TCP server
+ *
+ * Stops the I/O thread and closes every client connection.
+ */
+void stop_loop(void);
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void);
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ *
+ * Nothing to do: writes reach the image tables through the journal.
+ */
+void cycle_start(void);
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Nothing to do: reads use the runtime's per-scan snapshot.
+ */
+void cycle_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_SLAVE_PLUGIN_H */
@@ -0,0 +1,459 @@
+/**
+ * @file modbus_tcp_server.c
+ * @brief Event-driven Modbus TCP transport implementation
+ *
+ * Sockets are non-blocking and level-triggered in a single epoll set. Each
+ * connection has a receive buffer, split into MBAP frames as bytes arrive,
+ * and a transmit buffer for the answers the socket could not take at once;
+ * while that buffer is too full for another answer the requests wait in the
+ * receive buffer, so a client that does not read cannot grow memory.
+ */
+
+#define _GNU_SOURCE
+
+#include "modbus_tcp_server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* MBAP header: transaction id, protocol id, length, unit id */
+#define MBAP_HEADER_SIZE    7
+#define MODBUS_TCP_MAX_ADU  (MBAP_HEADER_SIZE + MODBUS_TCP_MAX_PDU)
+
+/* Room for a few pipelined requests and their answers per connection */
+#define CONN_RX_SIZE        (4 * MODBUS_TCP_MAX_ADU)
+#define CONN_TX_SIZE        (4 * MODBUS_TCP_MAX_ADU)
+
+#define EPOLL_MAX_EVENTS    64
+#define LISTEN_BACKLOG      64
+
+/* epoll data of the two sockets that are not connections */
+#define TAG_LISTENER        0xFFFFFFFFu
+#define TAG_WAKEUP          0xFFFFFFFEu
+
+typedef struct {
+    int fd;                         /* -1 when the slot is free */
+    uint8_t rx[CONN_RX_SIZE];
+    int rx_len;
+    uint8_t tx[CONN_TX_SIZE];
+    int tx_len;
+    int tx_off;
+    bool want_write;                /* EPOLLOUT armed */
+    time_t last_activity;
+    char peer[INET_ADDRSTRLEN];
+} modbus_conn_t;
+
+static modbus_tcp_server_params_t g_params;
+static modbus_conn_t *g_conns = NULL;
+static int g_listen_fd = -1;
+static int g_epoll_fd = -1;
+static int g_wakeup_fd = -1;
+static pthread_t g_thread;
+static volatile bool g_stop = false;
+
+static time_t monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static void close_conn(int slot, const char *reason)
+{
+    modbus_conn_t *conn = &g_conns[slot];
+
+    if (conn->fd < 0) {
+        return;
+    }
+    if (g_params.log_connections) {
+        plugin_logger_info_limited(g_params.logger, "Client %s disconnected (%s)", conn->peer, reason);
+    }
+    close(conn->fd); /* Also removes it from the epoll set */
+    conn->fd = -1;
+}
+
+/**
+ * @brief Arm or disarm EPOLLOUT to match the pending transmit bytes
+ */
+static void update_events(int slot)
+{
+    modbus_conn_t *conn = &g_conns[slot];
+    bool want_write = conn->tx_len > conn->tx_off;
+
+    if (want_write == conn->want_write) {
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0);
+    ev.data.u32 = (uint32_t)slot;
+    if (epoll_ctl(g_epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev) == 0) {
+        conn->want_write = want_write;
+    }
+}
+
+/**
+ * @brief Send what the socket takes of the transmit buffer
+ *
+ * @return false if the connection failed
+ */
+static bool flush_conn(int slot)
+{
+    modbus_conn_t *conn = &g_conns[slot];
+
+    while (conn->tx_off < conn->tx_len) {
+        ssize_t sent = send(conn->fd, conn->tx + conn->tx_off, (size_t)(conn->tx_len - conn->tx_off),
+                            MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn->tx_off += (int)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false;
+    }
+
+    if (conn->tx_off == conn->tx_len) {
+        conn->tx_off = 0;
+        conn->tx_len = 0;
+    } else if (conn->tx_off > 0 && CONN_TX_SIZE - conn->tx_len < MODBUS_TCP_MAX_ADU) {
+        memmove(conn->tx, conn->tx + conn->tx_off, (size_t)(conn->tx_len - conn->tx_off));
+        conn->tx_len -= conn->tx_off;
+        conn->tx_off = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Serve the complete frames of the receive buffer
+ *
+ * @return false if the client broke the framing
+ */
+static bool process_frames(int slot)
+{
+    modbus_conn_t *conn = &g_conns[slot];
+    int pos = 0;
+
+    while (conn->rx_len - pos >= MBAP_HEADER_SIZE) {
+        const uint8_t *frame = conn->rx + pos;
+        int protocol = (frame[2] << 8) | frame[3];
+        int length = (frame[4] << 8) | frame[5]; /* Unit id + PDU */
+
+        if (protocol != 0 || length < 2 || length > MODBUS_TCP_MAX_PDU + 1) {
+            return false;
+        }
+        if (conn->rx_len - pos < 6 + length) {
+            break; /* Incomplete */
+        }
+        if (CONN_TX_SIZE - conn->tx_len < MODBUS_TCP_MAX_ADU) {
+            break; /* Answer when the client has read the previous ones */
+        }
+
+        uint8_t *out = conn->tx + conn->tx_len;
+        int pdu_len = g_params.handler(frame[6], frame + MBAP_HEADER_SIZE, length - 1,
+                                       out + MBAP_HEADER_SIZE);
+        if (pdu_len > 0) {
+            memcpy(out, frame, 4);                  /* Transaction and protocol id */
+            out[4] = (uint8_t)((pdu_len + 1) >> 8);
+            out[5] = (uint8_t)((pdu_len + 1) & 0xFF);
+            out[6] = frame[6];
+            conn->tx_len += MBAP_HEADER_SIZE + pdu_len;
+        }
+        pos += 6 + length;
+    }
+
+    if (pos > 0) {
+        memmove(conn->rx, conn->rx + pos, (size_t)(conn->rx_len - pos));
+        conn->rx_len -= pos;
+    }
+    return true;
+}
+
+static void handle_readable(int slot)
+{
+    modbus_conn_t *conn = &g_conns[slot];
+
+    if (conn->rx_len < CONN_RX_SIZE) {
+        ssize_t got = recv(conn->fd, conn->rx + conn->rx_len, (size_t)(CONN_RX_SIZE - conn->rx_len), 0);
+        if (got == 0) {
+            close_conn(slot, "closed by peer");
+            return;
+        }
+        if (got < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                close_conn(slot, strerror(errno));
+            }
+            return;
+        }
+        conn->rx_len += (int)got;
+        conn->last_activity = monotonic_seconds();
+    }
+
+    if (!process_frames(slot)) {
+        close_conn(slot, "invalid MBAP header");
+        return;
+    }
+    if (!flush_conn(slot)) {
+        close_conn(slot, "send failed");
+        return;
+    }
+    update_events(slot);
+}
+
+static void handle_writable(int slot)
+{
+    if (!flush_conn(slot)) {
+        close_conn(slot, "send failed");
+        return;
+    }
+    /* Requests held back while the transmit buffer was full */
+    if (!process_frames(slot) || !flush_conn(slot)) {
+        close_conn(slot, "send failed");
+        return;
+    }
+    update_events(slot);
+}
+
+static void accept_clients(void)
+{
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept4(g_listen_fd, (struct sockaddr *)&addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; /* EAGAIN: backlog drained */
+        }
+
+        int slot = -1;
+        for (int i = 0; i < g_params.max_clients; i++) {
+            if (g_conns[i].fd < 0) {
+                slot = i;
+                break;
+            }
+        }
+
+        char peer[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &addr.sin_addr, peer, sizeof(peer));
+        if (slot < 0) {
+            plugin_logger_warn_limited(g_params.logger, "Refused %s: %d clients connected", peer,
+                                       g_params.max_clients);
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        modbus_conn_t *conn = &g_conns[slot];
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u32 = (uint32_t)slot;
+        if (epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+
+        conn->fd = fd;
+        conn->rx_len = 0;
+        conn->tx_len = 0;
+        conn->tx_off = 0;
+        conn->want_write = false;
+        conn->last_activity = monotonic_seconds();
+        memcpy(conn->peer, peer, sizeof(peer));
+        if (g_params.log_connections) {
+            plugin_logger_info_limited(g_params.logger, "Client %s connected", peer);
+        }
+    }
+}
+
+static void close_idle_clients(void)
+{
+    time_t now = monotonic_seconds();
+
+    for (int i = 0; i < g_params.max_clients; i++) {
+        if (g_conns[i].fd >= 0 && now - g_conns[i].last_activity >= g_params.idle_timeout_s) {
+            close_conn(i, "idle timeout");
+        }
+    }
+}
+
+static void *io_thread(void *arg)
+{
+    (void)arg;
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int timeout_ms = g_params.idle_timeout_s > 0 ? 1000 : -1;
+
+    while (!g_stop) {
+        int n = epoll_wait(g_epoll_fd, events, EPOLL_MAX_EVENTS, timeout_ms);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            plugin_logger_error(g_params.logger, "epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n && !g_stop; i++) {
+            uint32_t tag = events[i].data.u32;
+            uint32_t ev = events[i].events;
+
+            if (tag == TAG_WAKEUP) {
+                continue; /* g_stop is set */
+            }
+            if (tag == TAG_LISTENER) {
+                accept_clients();
+                continue;
+            }
+
+            int slot = (int)tag;
+            if (g_conns[slot].fd < 0) {
+                continue; /* Closed earlier in this batch */
+            }
+            if (ev & EPOLLOUT) {
+                handle_writable(slot);
+            }
+            if (g_conns[slot].fd >= 0 && (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                handle_readable(slot);
+            }
+        }
+
+        if (g_params.idle_timeout_s > 0) {
+            close_idle_clients();
+        }
+    }
+    return NULL;
+}
+
+static int open_listener(void)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_params.port);
+    if (inet_pton(AF_INET, g_params.host, &addr.sin_addr) != 1) {
+        plugin_logger_error(g_params.logger, "Invalid bind address: %s", g_params.host);
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        plugin_logger_error(g_params.logger, "socket() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, LISTEN_BACKLOG) != 0) {
+        plugin_logger_error(g_params.logger, "Cannot listen on %s:%d: %s", g_params.host, g_params.port,
+                            strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void release_resources(void)
+{
+    if (g_conns != NULL) {
+        for (int i = 0; i < g_params.max_clients; i++) {
+            if (g_conns[i].fd >= 0) {
+                close(g_conns[i].fd);
+            }
+        }
+        free(g_conns);
+        g_conns = NULL;
+    }
+    if (g_listen_fd >= 0) {
+        close(g_listen_fd);
+        g_listen_fd = -1;
+    }
+    if (g_wakeup_fd >= 0) {
+        close(g_wakeup_fd);
+        g_wakeup_fd = -1;
+    }
+    if (g_epoll_fd >= 0) {
+        close(g_epoll_fd);
+        g_epoll_fd = -1;
+    }
+}
+
+int modbus_tcp_server_start(const modbus_tcp_server_params_t *params)
+{
+    if (params == NULL || params->handler == NULL || params->max_clients <= 0) {
+        return -1;
+    }
+    g_params = *params;
+    g_stop = false;
+
+    g_conns = (modbus_conn_t *)calloc((size_t)g_params.max_clients, sizeof(modbus_conn_t));
+    if (g_conns == NULL) {
+        plugin_logger_error(g_params.logger, "Failed to allocate %d connection slots", g_params.max_clients);
+        return -1;
+    }
+    for (int i = 0; i < g_params.max_clients; i++) {
+        g_conns[i].fd = -1;
+    }
+
+    g_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    g_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (g_epoll_fd < 0 || g_wakeup_fd < 0) {
+        plugin_logger_error(g_params.logger, "Failed to create epoll set: %s", strerror(errno));
+        release_resources();
+        return -1;
+    }
+
+    g_listen_fd = open_listener();
+    if (g_listen_fd < 0) {
+        release_resources();
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = TAG_LISTENER;
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, g_listen_fd, &ev);
+    ev.data.u32 = TAG_WAKEUP;
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, g_wakeup_fd, &ev);
+
+    if (pthread_create(&g_thread, NULL, io_thread, NULL) != 0) {
+        plugin_logger_error(g_params.logger, "Failed to create I/O thread");
+        release_resources();
+        return -1;
+    }
+    return 0;
+}
+
+void modbus_tcp_server_stop(void)
+{
+    if (g_epoll_fd < 0) {
+        return;
+    }
+
+    g_stop = true;
+    uint64_t one = 1;
+    ssize_t ret = write(g_wakeup_fd, &one, sizeof(one)); /* Wakes epoll_wait */
+    (void)ret;
+    pthread_join(g_thread, NULL);
+    release_resources();
+}
@@ -0,0 +1,65 @@
+/**
+ * @file modbus_tcp_server.h
+ * @brief Event-driven Modbus TCP transport for the Modbus slave plugin
+ *
+ * One I/O thread waits on the listening socket and every connection with
+ * epoll, splits the byte stream into MBAP frames and hands each request PDU
+ * to the handler, so connections cost a slot in a table, not a thread.
+ * Requests a client pipelines are answered in order.
+ */
+
+#ifndef MODBUS_TCP_SERVER_H
+#define MODBUS_TCP_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "plugin_logger.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest PDU (function code + data) of a Modbus TCP frame */
+#define MODBUS_TCP_MAX_PDU  253
+
+/**
+ * @brief Serve one request
+ *
+ * Called on the I/O thread. `request` holds `length` bytes starting with the
+ * function code; the response PDU (at most MODBUS_TCP_MAX_PDU bytes) goes to
+ * `response`.
+ *
+ * @return The response length, or 0 to send no response
+ */
+typedef int (*modbus_tcp_handler_t)(uint8_t unit_id, const uint8_t *request, int length,
+                                    uint8_t *response);
+
+typedef struct {
+    const char *host;               /* Interface to bind, "0.0.0.0" for all */
+    uint16_t port;
+    int max_clients;                /* Connections beyond this are refused */
+    int idle_timeout_s;             /* Close connections silent this long, 0 = never */
+    bool log_connections;
+    modbus_tcp_handler_t handler;
+    plugin_logger_t *logger;
+} modbus_tcp_server_params_t;
+
+/**
+ * @brief Bind the listening socket and start the I/O thread
+ *
+ * @return 0 on success, -1 if the socket cannot be bound or the thread
+ * cannot be created (logged)
+ */
+int modbus_tcp_server_start(const modbus_tcp_server_params_t *params);
+
+/**
+ * @brief Stop the I/O thread and close every connection
+ */
+void modbus_tcp_server_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODBUS_TCP_SERVER_H */
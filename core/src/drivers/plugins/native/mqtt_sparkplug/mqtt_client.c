@@ -0,0 +1,494 @@
+/**
+ * @file mqtt_client.c
+ * @brief Minimal MQTT 3.1.1 client implementation
+ *
+ * The socket is non-blocking; every wait goes through poll() with the client
+ * timeout, so a broker that stops reading costs at most one timeout before
+ * the caller reconnects. PUBLISH sends the header and the payload with one
+ * sendmsg() call, without copying the payload.
+ */
+
+#define _GNU_SOURCE
+
+#include "mqtt_client.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Control packet types */
+#define MQTT_CONNECT        1
+#define MQTT_CONNACK        2
+#define MQTT_PUBLISH        3
+#define MQTT_SUBSCRIBE      8
+#define MQTT_PINGREQ        12
+#define MQTT_DISCONNECT     14
+
+/* CONNECT flags */
+#define MQTT_FLAG_CLEAN     0x02
+#define MQTT_FLAG_WILL      0x04
+#define MQTT_FLAG_PASSWORD  0x40
+#define MQTT_FLAG_USERNAME  0x80
+
+/* Fixed header, topic length and a topic of up to 256 bytes */
+#define MQTT_MAX_TOPIC_LEN  256
+#define MQTT_HEADER_SIZE    (5 + 2 + MQTT_MAX_TOPIC_LEN)
+
+uint64_t mqtt_client_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+}
+
+void mqtt_client_init(mqtt_client_t *client, int timeout_ms, mqtt_message_func_t on_message,
+                      void *ctx)
+{
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+    client->timeout_ms = timeout_ms;
+    client->connack_code = -1;
+    client->next_packet_id = 1;
+    client->on_message = on_message;
+    client->ctx = ctx;
+}
+
+/**
+ * @brief Wait until the socket is ready for `events`
+ *
+ * @return 0 when ready, -1 on timeout (errno ETIMEDOUT) or error
+ */
+static int wait_socket(int fd, short events, int timeout_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    for (;;) {
+        int result = poll(&pfd, 1, timeout_ms);
+        if (result > 0) {
+            return 0;
+        }
+        if (result == 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static int connect_address(const struct addrinfo *ai, int timeout_ms)
+{
+    int fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        if (errno != EINPROGRESS || wait_socket(fd, POLLOUT, timeout_ms) != 0) {
+            close(fd);
+            return -1;
+        }
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+            close(fd);
+            errno = error;
+            return -1;
+        }
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief Send every byte of the vectors, waiting for room up to the timeout
+ */
+static int send_iov(mqtt_client_t *client, struct iovec *iov, int count)
+{
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (size_t)count;
+
+    while (msg.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(client->fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+                wait_socket(client->fd, POLLOUT, client->timeout_ms) == 0) {
+                continue;
+            }
+            return -1;
+        }
+
+        /* Skip what was sent */
+        while (msg.msg_iovlen > 0 && (size_t)sent >= msg.msg_iov->iov_len) {
+            sent -= (ssize_t)msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + sent;
+            msg.msg_iov->iov_len -= (size_t)sent;
+        }
+    }
+
+    return 0;
+}
+
+static int send_packet(mqtt_client_t *client, const uint8_t *data, size_t len)
+{
+    if (client->fd < 0) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    struct iovec iov = { (void *)data, len };
+    return send_iov(client, &iov, 1);
+}
+
+/**
+ * @brief Write the fixed header; the remaining length takes 1 to 4 bytes
+ */
+static size_t put_fixed_header(uint8_t *buf, uint8_t first, size_t remaining)
+{
+    size_t len = 0;
+
+    buf[len++] = first;
+    do {
+        uint8_t byte = (uint8_t)(remaining & 0x7F);
+        remaining >>= 7;
+        buf[len++] = remaining > 0 ? (uint8_t)(byte | 0x80) : byte;
+    } while (remaining > 0 && len < 5);
+    return len;
+}
+
+static size_t put_u16(uint8_t *buf, size_t value)
+{
+    buf[0] = (uint8_t)(value >> 8);
+    buf[1] = (uint8_t)(value & 0xFF);
+    return 2;
+}
+
+static size_t put_string(uint8_t *buf, const void *data, size_t len)
+{
+    put_u16(buf, len);
+    memcpy(buf + 2, data, len);
+    return 2 + len;
+}
+
+/*
+ * =============================================================================
+ * Receiving
+ * =============================================================================
+ */
+
+static void dispatch(mqtt_client_t *client, const uint8_t *packet, size_t header_len, size_t len)
+{
+    const uint8_t *body = packet + header_len;
+    size_t body_len = len - header_len;
+
+    switch (packet[0] >> 4) {
+    case MQTT_CONNACK:
+        if (body_len >= 2) {
+            client->connack_code = body[1];
+        }
+        break;
+    case MQTT_PUBLISH: {
+        /* Subscriptions are QoS 0, but a packet id is skipped if there is one */
+        size_t id_len = ((packet[0] >> 1) & 3) != 0 ? 2 : 0;
+        if (body_len < 2) {
+            break;
+        }
+        size_t topic_len = ((size_t)body[0] << 8) | body[1];
+        if (2 + topic_len + id_len > body_len || client->on_message == NULL) {
+            break;
+        }
+        client->on_message(client->ctx, (const char *)body + 2, topic_len,
+                           body + 2 + topic_len + id_len, body_len - 2 - topic_len - id_len);
+        break;
+    }
+    default:
+        /* SUBACK and PINGRESP only prove the broker is alive */
+        break;
+    }
+}
+
+/**
+ * @brief Dispatch the complete packets at the start of rx
+ */
+static void parse_packets(mqtt_client_t *client)
+{
+    size_t off = 0;
+
+    while (client->rx_len - off >= 2) {
+        const uint8_t *packet = client->rx + off;
+        size_t avail = client->rx_len - off;
+        size_t remaining = 0;
+        size_t header_len = 1;
+        bool complete = false;
+
+        for (int shift = 0; header_len < avail && header_len <= 4; shift += 7) {
+            uint8_t byte = packet[header_len++];
+            remaining |= (size_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            break;
+        }
+
+        size_t total = header_len + remaining;
+        if (total > MQTT_CLIENT_RX_SIZE) {
+            /* Everything buffered from here belongs to it, the rest is dispatched */
+            client->rx_skip = total - avail;
+            client->rx_len = 0;
+            return;
+        }
+        if (total > avail) {
+            break;
+        }
+        dispatch(client, packet, header_len, total);
+        off += total;
+    }
+
+    if (off > 0) {
+        memmove(client->rx, client->rx + off, client->rx_len - off);
+        client->rx_len -= off;
+    }
+}
+
+int mqtt_client_read(mqtt_client_t *client)
+{
+    if (client->fd < 0) {
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    for (;;) {
+        uint8_t *dest = client->rx + client->rx_len;
+        ssize_t n = recv(client->fd, dest, MQTT_CLIENT_RX_SIZE - client->rx_len, 0);
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        client->last_rx_ms = mqtt_client_now_ms();
+
+        size_t len = (size_t)n;
+        if (client->rx_skip > 0) {
+            size_t skip = len < client->rx_skip ? len : client->rx_skip;
+            memmove(dest, dest + skip, len - skip);
+            client->rx_skip -= skip;
+            len -= skip;
+        }
+        client->rx_len += len;
+        parse_packets(client);
+    }
+}
+
+/*
+ * =============================================================================
+ * Session
+ * =============================================================================
+ */
+
+static int send_connect(mqtt_client_t *client, const mqtt_connect_options_t *options)
+{
+    uint8_t packet[1024];
+    size_t client_id_len = strlen(options->client_id);
+    size_t username_len = options->username != NULL ? strlen(options->username) : 0;
+    size_t password_len = options->password != NULL ? strlen(options->password) : 0;
+    size_t will_topic_len = options->will_topic != NULL ? strlen(options->will_topic) : 0;
+    uint8_t flags = MQTT_FLAG_CLEAN;
+
+    size_t remaining = 10 + 2 + client_id_len;
+    if (will_topic_len > 0) {
+        flags |= (uint8_t)(MQTT_FLAG_WILL | (options->will_qos << 3));
+        remaining += 2 + will_topic_len + 2 + options->will_len;
+    }
+    if (username_len > 0) {
+        flags |= MQTT_FLAG_USERNAME;
+        remaining += 2 + username_len;
+        if (password_len > 0) {
+            flags |= MQTT_FLAG_PASSWORD;
+            remaining += 2 + password_len;
+        }
+    }
+    if (remaining + 5 > sizeof(packet)) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    size_t len = put_fixed_header(packet, MQTT_CONNECT << 4, remaining);
+    len += put_string(packet + len, "MQTT", 4);
+    packet[len++] = 4;                  /* Protocol level 3.1.1 */
+    packet[len++] = flags;
+    len += put_u16(packet + len, (size_t)options->keepalive_s);
+    len += put_string(packet + len, options->client_id, client_id_len);
+    if (will_topic_len > 0) {
+        len += put_string(packet + len, options->will_topic, will_topic_len);
+        len += put_string(packet + len, options->will_payload, options->will_len);
+    }
+    if (username_len > 0) {
+        len += put_string(packet + len, options->username, username_len);
+        if (password_len > 0) {
+            len += put_string(packet + len, options->password, password_len);
+        }
+    }
+    return send_packet(client, packet, len);
+}
+
+int mqtt_client_connect(mqtt_client_t *client, const char *host, uint16_t port,
+                        const mqtt_connect_options_t *options)
+{
+    mqtt_client_close(client);
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(host, service, &hints, &result) != 0) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+
+    for (const struct addrinfo *ai = result; ai != NULL && client->fd < 0; ai = ai->ai_next) {
+        client->fd = connect_address(ai, client->timeout_ms);
+    }
+    freeaddrinfo(result);
+    if (client->fd < 0) {
+        return -1;
+    }
+
+    client->rx_len = 0;
+    client->rx_skip = 0;
+    client->connack_code = -1;
+    if (send_connect(client, options) != 0) {
+        mqtt_client_close(client);
+        return -1;
+    }
+
+    /* The CONNACK is the first packet of the session */
+    uint64_t deadline = mqtt_client_now_ms() + (uint64_t)client->timeout_ms;
+    while (client->connack_code < 0) {
+        uint64_t now = mqtt_client_now_ms();
+        if (now >= deadline) {
+            errno = ETIMEDOUT;
+        }
+        if (now >= deadline || wait_socket(client->fd, POLLIN, (int)(deadline - now)) != 0 ||
+            mqtt_client_read(client) != 0) {
+            int saved = errno;
+            mqtt_client_close(client);
+            errno = saved;
+            return -1;
+        }
+    }
+    if (client->connack_code != 0) {
+        mqtt_client_close(client);
+        errno = ECONNREFUSED;
+        return -1;
+    }
+    return 0;
+}
+
+void mqtt_client_close(mqtt_client_t *client)
+{
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    client->rx_len = 0;
+    client->rx_skip = 0;
+}
+
+void mqtt_client_disconnect(mqtt_client_t *client)
+{
+    static const uint8_t packet[2] = { MQTT_DISCONNECT << 4, 0 };
+
+    if (client->fd >= 0) {
+        send_packet(client, packet, sizeof(packet));
+    }
+    mqtt_client_close(client);
+}
+
+int mqtt_client_publish(mqtt_client_t *client, const char *topic, const uint8_t *payload,
+                        size_t len, bool retain)
+{
+    uint8_t header[MQTT_HEADER_SIZE];
+    size_t topic_len = strlen(topic);
+
+    if (client->fd < 0) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    if (topic_len > MQTT_MAX_TOPIC_LEN || len > 0x0FFFFFFF - 2 - topic_len) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    size_t header_len = put_fixed_header(header, (uint8_t)((MQTT_PUBLISH << 4) | (retain ? 1 : 0)),
+                                         2 + topic_len + len);
+    header_len += put_string(header + header_len, topic, topic_len);
+
+    struct iovec iov[2] = {
+        { header, header_len },
+        { (void *)payload, len },
+    };
+    return send_iov(client, iov, len > 0 ? 2 : 1);
+}
+
+int mqtt_client_subscribe(mqtt_client_t *client, const char *topic)
+{
+    uint8_t packet[MQTT_HEADER_SIZE + 3];
+    size_t topic_len = strlen(topic);
+
+    if (topic_len > MQTT_MAX_TOPIC_LEN) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    uint16_t packet_id = client->next_packet_id++;
+    if (client->next_packet_id == 0) {
+        client->next_packet_id = 1;     /* 0 is not a valid packet id */
+    }
+
+    size_t len = put_fixed_header(packet, (MQTT_SUBSCRIBE << 4) | 0x02, 2 + 2 + topic_len + 1);
+    len += put_u16(packet + len, packet_id);
+    len += put_string(packet + len, topic, topic_len);
+    packet[len++] = 0;                  /* Requested QoS */
+    return send_packet(client, packet, len);
+}
+
+int mqtt_client_ping(mqtt_client_t *client)
+{
+    static const uint8_t packet[2] = { MQTT_PINGREQ << 4, 0 };
+    return send_packet(client, packet, sizeof(packet));
+}
@@ -0,0 +1,115 @@
+/**
+ * @file mqtt_client.h
+ * @brief Minimal MQTT 3.1.1 client for the Sparkplug plugin
+ *
+ * What an edge node needs and nothing more: CONNECT with credentials and a
+ * will, QoS 0 PUBLISH and SUBSCRIBE, PINGREQ and DISCONNECT. Incoming
+ * PUBLISH packets are handed to a callback.
+ */
+
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest incoming packet kept; bigger ones are skipped */
+#define MQTT_CLIENT_RX_SIZE     8192
+
+typedef void (*mqtt_message_func_t)(void *ctx, const char *topic, size_t topic_len,
+                                    const uint8_t *payload, size_t payload_len);
+
+typedef struct {
+    const char *client_id;
+    const char *username;           /* NULL or "" for none */
+    const char *password;
+    int keepalive_s;
+    const char *will_topic;         /* NULL for no will */
+    const uint8_t *will_payload;
+    size_t will_len;
+    int will_qos;
+} mqtt_connect_options_t;
+
+typedef struct {
+    int fd;                         /* -1 when disconnected */
+    int timeout_ms;
+    int connack_code;               /* Return code of the last CONNACK, -1 if none */
+    uint16_t next_packet_id;
+    uint64_t last_rx_ms;            /* Monotonic time of the last packet received */
+
+    mqtt_message_func_t on_message;
+    void *ctx;
+
+    uint8_t rx[MQTT_CLIENT_RX_SIZE];
+    size_t rx_len;
+    size_t rx_skip;                 /* Bytes left of an oversized packet */
+} mqtt_client_t;
+
+/**
+ * @brief Initialize a disconnected client
+ */
+void mqtt_client_init(mqtt_client_t *client, int timeout_ms, mqtt_message_func_t on_message,
+                      void *ctx);
+
+/**
+ * @brief Connect to host:port and open an MQTT session (clean session)
+ *
+ * Waits for the CONNACK within the client timeout. A refused session sets
+ * connack_code and errno ECONNREFUSED.
+ *
+ * @return 0 on success, -1 on failure (errno is set)
+ */
+int mqtt_client_connect(mqtt_client_t *client, const char *host, uint16_t port,
+                        const mqtt_connect_options_t *options);
+
+/**
+ * @brief Send DISCONNECT if connected, then close the connection
+ */
+void mqtt_client_disconnect(mqtt_client_t *client);
+
+/**
+ * @brief Close the connection without DISCONNECT: the broker publishes the will
+ */
+void mqtt_client_close(mqtt_client_t *client);
+
+/**
+ * @brief Publish at QoS 0
+ *
+ * @return 0 on success, -1 if the broker did not take the packet within the
+ *         client timeout or the connection failed
+ */
+int mqtt_client_publish(mqtt_client_t *client, const char *topic, const uint8_t *payload,
+                        size_t len, bool retain);
+
+/**
+ * @brief Subscribe to a topic filter at QoS 0; the SUBACK is read by mqtt_client_read
+ */
+int mqtt_client_subscribe(mqtt_client_t *client, const char *topic);
+
+/**
+ * @brief Send PINGREQ
+ */
+int mqtt_client_ping(mqtt_client_t *client);
+
+/**
+ * @brief Read what the socket has without blocking, dispatching PUBLISH packets
+ *
+ * @return 0 on success, -1 when the connection is closed or broken
+ */
+int mqtt_client_read(mqtt_client_t *client);
+
+/**
+ * @brief Monotonic clock in milliseconds
+ */
+uint64_t mqtt_client_now_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_CLIENT_H */
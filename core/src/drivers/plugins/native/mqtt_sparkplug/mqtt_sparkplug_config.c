@@ -0,0 +1,381 @@
+/**
+ * @file mqtt_sparkplug_config.c
+ * @brief MQTT Sparkplug B Plugin Configuration Parser Implementation
+ *
+ * Parses JSON configuration files using cJSON library.
+ */
+
+#include "mqtt_sparkplug_config.h"
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Error codes */
+#define MQTT_SPARKPLUG_CONFIG_OK              0
+#define MQTT_SPARKPLUG_CONFIG_ERR_FILE       -1
+#define MQTT_SPARKPLUG_CONFIG_ERR_PARSE      -2
+#define MQTT_SPARKPLUG_CONFIG_ERR_INVALID    -4
+
+/* Journal buffer types (matching journal_buffer_type_t), -1 where the area
+ * has no such width */
+static const int g_buffer_types[5][3] = {
+    /*  I   Q   M */
+    {   0,  1,  2 },                /* X */
+    {   3,  4, -1 },                /* B */
+    {   5,  6,  7 },                /* W */
+    {   8,  9, 10 },                /* D */
+    {  11, 12, 13 },                /* L */
+};
+
+/* Datatype names as Sparkplug spells them, and the width they need; the
+ * first of each width is the default */
+static const struct {
+    const char *name;
+    sparkplug_datatype_t datatype;
+    int width;
+} g_datatypes[] = {
+    { "Boolean", SPARKPLUG_BOOLEAN, 1 },
+    { "UInt8",   SPARKPLUG_UINT8,   8 },
+    { "Int8",    SPARKPLUG_INT8,    8 },
+    { "UInt16",  SPARKPLUG_UINT16, 16 },
+    { "Int16",   SPARKPLUG_INT16,  16 },
+    { "UInt32",  SPARKPLUG_UINT32, 32 },
+    { "Int32",   SPARKPLUG_INT32,  32 },
+    { "Float",   SPARKPLUG_FLOAT,  32 },
+    { "UInt64",  SPARKPLUG_UINT64, 64 },
+    { "Int64",   SPARKPLUG_INT64,  64 },
+    { "Double",  SPARKPLUG_DOUBLE, 64 },
+};
+
+/**
+ * @brief Read entire file into a string
+ */
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size > 1024 * 1024) { /* Max 1MB config file */
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    fclose(fp);
+
+    if ((long)read_size != size) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[size] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Safely copy string with length limit
+ *
+ * @return false if `src` was truncated
+ */
+static bool safe_strcpy(char *dest, const char *src, size_t max_len)
+{
+    if (src == NULL) {
+        dest[0] = '\0';
+        return true;
+    }
+    strncpy(dest, src, max_len - 1);
+    dest[max_len - 1] = '\0';
+    return strlen(src) < max_len;
+}
+
+/**
+ * @brief Get string value from JSON object
+ */
+static const char *get_string(const cJSON *obj, const char *key, const char *default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring != NULL) {
+        return item->valuestring;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get integer value from JSON object
+ */
+static int get_int(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) {
+        return item->valueint;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Parse a located address ("%QW10", "%IX0.3") into a metric
+ */
+static int parse_address(const char *address, mqtt_sparkplug_metric_t *metric)
+{
+    static const char areas[] = "IQM";
+    static const char sizes[] = "XBWDL";
+    static const int widths[] = { 1, 8, 16, 32, 64 };
+
+    if (address == NULL) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    while (isspace((unsigned char)*address)) {
+        address++;
+    }
+    if (address[0] != '%' || address[1] == '\0' || address[2] == '\0') {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    const char *area = strchr(areas, toupper((unsigned char)address[1]));
+    const char *size = strchr(sizes, toupper((unsigned char)address[2]));
+    if (area == NULL || size == NULL || !isdigit((unsigned char)address[3])) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    char *end = NULL;
+    long index = strtol(address + 3, &end, 10);
+    long bit = 0;
+    if (*size == 'X') {
+        if (*end != '.' || !isdigit((unsigned char)end[1])) {
+            return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+        }
+        bit = strtol(end + 1, &end, 10);
+    }
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0' || index > 0xFFFF || bit > 7) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    int buffer_type = g_buffer_types[size - sizes][area - areas];
+    if (buffer_type < 0) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    metric->buffer_type = buffer_type;
+    metric->index = (int)index;
+    metric->bit = (int)bit;
+    metric->width = widths[size - sizes];
+    return MQTT_SPARKPLUG_CONFIG_OK;
+}
+
+/**
+ * @brief Parse a datatype name, the unsigned type of the width if absent
+ */
+static int parse_datatype(const char *name, mqtt_sparkplug_metric_t *metric)
+{
+    for (size_t i = 0; i < sizeof(g_datatypes) / sizeof(g_datatypes[0]); i++) {
+        if (g_datatypes[i].width != metric->width) {
+            continue;
+        }
+        if (name == NULL || strcmp(name, g_datatypes[i].name) == 0) {
+            metric->datatype = g_datatypes[i].datatype;
+            return MQTT_SPARKPLUG_CONFIG_OK;
+        }
+    }
+    return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+}
+
+/**
+ * @brief Sparkplug ids are topic levels: no separators or wildcards
+ */
+static bool valid_id(const char *id)
+{
+    if (id[0] == '\0') {
+        return false;
+    }
+    return strpbrk(id, "/+#") == NULL;
+}
+
+/**
+ * @brief Parse one entry of metrics
+ */
+static int parse_metric(const cJSON *json, mqtt_sparkplug_metric_t *metric)
+{
+    const char *address = get_string(json, "address", NULL);
+
+    if (!safe_strcpy(metric->name, get_string(json, "name", NULL), MQTT_SPARKPLUG_MAX_NAME_LEN) ||
+        !safe_strcpy(metric->address, address, sizeof(metric->address))) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    /* Unnamed metrics are published under their address */
+    if (metric->name[0] == '\0') {
+        safe_strcpy(metric->name, metric->address, MQTT_SPARKPLUG_MAX_NAME_LEN);
+    }
+
+    int result = parse_address(address, metric);
+    if (result != MQTT_SPARKPLUG_CONFIG_OK) {
+        return result;
+    }
+    return parse_datatype(get_string(json, "datatype", NULL), metric);
+}
+
+int mqtt_sparkplug_config_parse(const char *config_path, mqtt_sparkplug_config_t *config)
+{
+    if (config_path == NULL || config == NULL) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    memset(config, 0, sizeof(mqtt_sparkplug_config_t));
+
+    /* Read file contents */
+    char *json_str = read_file(config_path);
+    if (json_str == NULL) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_FILE;
+    }
+
+    /* Parse JSON */
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+
+    if (root == NULL) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_PARSE;
+    }
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    bool ok = true;
+
+    /* Broker */
+    const cJSON *broker = cJSON_GetObjectItemCaseSensitive(root, "broker");
+    ok = ok && safe_strcpy(config->host, get_string(broker, "host", "127.0.0.1"),
+                           MQTT_SPARKPLUG_MAX_STRING_LEN);
+    int port = get_int(broker, "port", MQTT_SPARKPLUG_DEFAULT_PORT);
+    ok = ok && safe_strcpy(config->client_id, get_string(broker, "client_id", NULL),
+                           MQTT_SPARKPLUG_MAX_ID_LEN);
+    ok = ok && safe_strcpy(config->username, get_string(broker, "username", NULL),
+                           MQTT_SPARKPLUG_MAX_STRING_LEN);
+    ok = ok && safe_strcpy(config->password, get_string(broker, "password", NULL),
+                           MQTT_SPARKPLUG_MAX_STRING_LEN);
+    config->keepalive_s = get_int(broker, "keepalive_s", MQTT_SPARKPLUG_DEFAULT_KEEPALIVE_S);
+    config->timeout_ms = get_int(broker, "timeout_ms", MQTT_SPARKPLUG_DEFAULT_TIMEOUT_MS);
+
+    /* Sparkplug identity */
+    const cJSON *sparkplug = cJSON_GetObjectItemCaseSensitive(root, "sparkplug");
+    ok = ok && safe_strcpy(config->group_id,
+                           get_string(sparkplug, "group_id", MQTT_SPARKPLUG_DEFAULT_GROUP_ID),
+                           MQTT_SPARKPLUG_MAX_ID_LEN);
+    ok = ok && safe_strcpy(config->edge_node_id, get_string(sparkplug, "edge_node_id", NULL),
+                           MQTT_SPARKPLUG_MAX_ID_LEN);
+    ok = ok && safe_strcpy(config->device_id,
+                           get_string(sparkplug, "device_id", MQTT_SPARKPLUG_DEFAULT_DEVICE_ID),
+                           MQTT_SPARKPLUG_MAX_ID_LEN);
+
+    /* Publishing */
+    const cJSON *publish = cJSON_GetObjectItemCaseSensitive(root, "publish");
+    config->interval_ms = get_int(publish, "interval_ms", 0);
+    config->queue_depth = get_int(publish, "queue_depth", MQTT_SPARKPLUG_DEFAULT_QUEUE_DEPTH);
+    const char *overflow = get_string(publish, "overflow", "merge");
+    if (strcmp(overflow, "merge") == 0) {
+        config->overflow = MQTT_SPARKPLUG_OVERFLOW_MERGE;
+    } else if (strcmp(overflow, "drop") == 0) {
+        config->overflow = MQTT_SPARKPLUG_OVERFLOW_DROP;
+    } else {
+        ok = false;
+    }
+
+    if (!ok || port < 1 || port > 65535) {
+        cJSON_Delete(root);
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    config->port = (uint16_t)port;
+
+    /* The client id must be unique on the broker: default to the edge node's */
+    if (config->client_id[0] == '\0') {
+        snprintf(config->client_id, sizeof(config->client_id), "openplc-%.48s",
+                 config->edge_node_id);
+    }
+
+    const cJSON *metrics = cJSON_GetObjectItemCaseSensitive(root, "metrics");
+    if (cJSON_IsArray(metrics) && cJSON_GetArraySize(metrics) > MQTT_SPARKPLUG_MAX_METRICS) {
+        cJSON_Delete(root);
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    /* Parse each metric */
+    const cJSON *metric = NULL;
+    cJSON_ArrayForEach(metric, metrics) {
+        int result = parse_metric(metric, &config->metrics[config->num_metrics]);
+        config->num_metrics++;
+        if (result != MQTT_SPARKPLUG_CONFIG_OK) {
+            cJSON_Delete(root);
+            return result;
+        }
+    }
+
+    cJSON_Delete(root);
+
+    /* Validate the parsed configuration */
+    return mqtt_sparkplug_config_validate(config);
+}
+
+int mqtt_sparkplug_config_validate(const mqtt_sparkplug_config_t *config)
+{
+    if (config == NULL) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    if (config->host[0] == '\0' || config->port == 0 || config->client_id[0] == '\0') {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    /* The keep alive is a 16-bit field of CONNECT; 0 would let a dead broker go unnoticed */
+    if (config->keepalive_s < 1 || config->keepalive_s > 65535) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    if (config->timeout_ms < 100 || config->timeout_ms > 60000) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    if (!valid_id(config->group_id) || !valid_id(config->edge_node_id) ||
+        !valid_id(config->device_id)) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    if (config->interval_ms < 0 || config->interval_ms > 60000) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    if (config->queue_depth < 2 || config->queue_depth > MQTT_SPARKPLUG_MAX_QUEUE_DEPTH) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+    if (config->num_metrics < 1) {
+        return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+    }
+
+    for (int i = 0; i < config->num_metrics; i++) {
+        if (config->metrics[i].name[0] == '\0') {
+            return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+        }
+
+        /* Metric names must be unique within the device */
+        for (int j = 0; j < i; j++) {
+            if (strcmp(config->metrics[i].name, config->metrics[j].name) == 0) {
+                return MQTT_SPARKPLUG_CONFIG_ERR_INVALID;
+            }
+        }
+    }
+
+    return MQTT_SPARKPLUG_CONFIG_OK;
+}
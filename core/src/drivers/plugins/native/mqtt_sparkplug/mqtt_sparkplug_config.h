@@ -0,0 +1,121 @@
+/**
+ * @file mqtt_sparkplug_config.h
+ * @brief MQTT Sparkplug B Plugin Configuration Structures and Parser
+ *
+ * The broker to publish to, the Sparkplug identity of the runtime (group,
+ * edge node and device) and the metrics: a name and an IEC located address
+ * each.
+ */
+
+#ifndef MQTT_SPARKPLUG_CONFIG_H
+#define MQTT_SPARKPLUG_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configuration limits */
+#define MQTT_SPARKPLUG_MAX_METRICS      512
+#define MQTT_SPARKPLUG_MAX_NAME_LEN     64      /* Metric name, including the NUL */
+#define MQTT_SPARKPLUG_MAX_ID_LEN       64      /* Group, edge node, device and client ids */
+#define MQTT_SPARKPLUG_MAX_STRING_LEN   128     /* Host, username, password */
+#define MQTT_SPARKPLUG_MAX_QUEUE_DEPTH  4096
+
+/* Default values */
+#define MQTT_SPARKPLUG_DEFAULT_PORT             1883
+#define MQTT_SPARKPLUG_DEFAULT_KEEPALIVE_S      30
+#define MQTT_SPARKPLUG_DEFAULT_TIMEOUT_MS       5000
+#define MQTT_SPARKPLUG_DEFAULT_GROUP_ID         "OpenPLC"
+#define MQTT_SPARKPLUG_DEFAULT_DEVICE_ID        "runtime"
+#define MQTT_SPARKPLUG_DEFAULT_QUEUE_DEPTH      64
+
+/**
+ * @brief Sparkplug B metric datatypes (the values of the DataType enum)
+ */
+typedef enum {
+    SPARKPLUG_INT8 = 1,
+    SPARKPLUG_INT16 = 2,
+    SPARKPLUG_INT32 = 3,
+    SPARKPLUG_INT64 = 4,
+    SPARKPLUG_UINT8 = 5,
+    SPARKPLUG_UINT16 = 6,
+    SPARKPLUG_UINT32 = 7,
+    SPARKPLUG_UINT64 = 8,
+    SPARKPLUG_FLOAT = 9,
+    SPARKPLUG_DOUBLE = 10,
+    SPARKPLUG_BOOLEAN = 11
+} sparkplug_datatype_t;
+
+/**
+ * @brief What happens to changes while the publish queue is full
+ */
+typedef enum {
+    MQTT_SPARKPLUG_OVERFLOW_MERGE = 0,  /* Sent with their latest value once there is room */
+    MQTT_SPARKPLUG_OVERFLOW_DROP        /* Dropped until the metric changes again */
+} mqtt_sparkplug_overflow_t;
+
+/**
+ * @brief One published variable
+ */
+typedef struct {
+    char name[MQTT_SPARKPLUG_MAX_NAME_LEN];
+    char address[16];               /* As configured, "%QW10" */
+    sparkplug_datatype_t datatype;
+    int buffer_type;                /* Journal buffer type of the area */
+    int index;                      /* Image table index */
+    int bit;                        /* Bit of index, BOOL only */
+    int width;                      /* Bits: 1, 8, 16, 32 or 64 */
+} mqtt_sparkplug_metric_t;
+
+/**
+ * @brief Complete MQTT Sparkplug configuration
+ */
+typedef struct {
+    /* Broker */
+    char host[MQTT_SPARKPLUG_MAX_STRING_LEN];
+    uint16_t port;
+    char client_id[MQTT_SPARKPLUG_MAX_ID_LEN];
+    char username[MQTT_SPARKPLUG_MAX_STRING_LEN];
+    char password[MQTT_SPARKPLUG_MAX_STRING_LEN];
+    int keepalive_s;
+    int timeout_ms;                 /* Connect, and a send the broker does not take */
+
+    /* Sparkplug identity */
+    char group_id[MQTT_SPARKPLUG_MAX_ID_LEN];
+    char edge_node_id[MQTT_SPARKPLUG_MAX_ID_LEN];
+    char device_id[MQTT_SPARKPLUG_MAX_ID_LEN];
+
+    /* Publishing */
+    int interval_ms;                /* Shortest time between two DDATA, 0 = every scan */
+    int queue_depth;                /* DDATA payloads queued for the I/O thread */
+    mqtt_sparkplug_overflow_t overflow;
+
+    mqtt_sparkplug_metric_t metrics[MQTT_SPARKPLUG_MAX_METRICS];
+    int num_metrics;
+} mqtt_sparkplug_config_t;
+
+/**
+ * @brief Parse configuration from JSON file
+ *
+ * @param config_path Path to the JSON configuration file
+ * @param config Pointer to configuration structure to populate
+ * @return 0 on success, negative error code on failure
+ */
+int mqtt_sparkplug_config_parse(const char *config_path, mqtt_sparkplug_config_t *config);
+
+/**
+ * @brief Validate configuration values
+ *
+ * @param config Pointer to configuration structure to validate
+ * @return 0 if valid, negative error code indicating the issue
+ */
+int mqtt_sparkplug_config_validate(const mqtt_sparkplug_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_SPARKPLUG_CONFIG_H */
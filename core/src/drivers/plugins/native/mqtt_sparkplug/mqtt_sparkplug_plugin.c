@@ -0,0 +1,946 @@
+/**
+ * @file mqtt_sparkplug_plugin.c
+ * @brief Native MQTT Sparkplug B Publisher Plugin Implementation
+ *
+ * The work is split so the scan never waits on the broker:
+ * - cycle_end reads the change bits of every image area that has metrics
+ *   with read_image_changes (a lock-free read of the snapshot of the scan)
+ *   and queues the changed metrics as one batch into a ring of batches
+ *   allocated at init.
+ * - The I/O thread owns the MQTT session: it connects with NDEATH as the
+ *   will, publishes NBIRTH and DBIRTH from read_image_snapshot, then one
+ *   DDATA per queued batch, and answers rebirth requests (NCMD).
+ *
+ * Neither side takes buffer_mutex. When the broker is slower than the scan
+ * the ring fills up; with overflow "merge" the scan then stops reading
+ * until there is room, and the next read reports every metric that changed
+ * meanwhile with its latest value, in one batch. With "drop" those changes
+ * are discarded.
+ */
+
+#define _GNU_SOURCE
+
+#include "mqtt_sparkplug_plugin.h"
+#include "mqtt_client.h"
+#include "mqtt_sparkplug_config.h"
+#include "plugin_logger.h"
+#include "plugin_types.h"
+#include "sparkplug_payload.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Journal buffer types (matching journal_buffer_type_t) */
+#define SP_NUM_BUFFER_TYPES     14
+
+/* Reconnect backoff (same as the native Modbus master) */
+#define SP_RETRY_DELAY_BASE_MS  2000
+#define SP_RETRY_DELAY_MAX_MS   30000
+
+#define SP_TOPIC_LEN            256
+
+/* Retry step while the image snapshot of an area is not published yet */
+#define SP_SNAPSHOT_POLL_MS     10
+
+/**
+ * @brief The window of one image area covering its metrics
+ *
+ * Metrics of the area are g_area_metrics[first_metric .. first_metric + num_metrics).
+ */
+typedef struct {
+    int type;                       /* Journal buffer type */
+    int width;                      /* Bytes per element, BOOL areas packed 1 */
+    bool is_bool;
+    int first;                      /* First image table index read */
+    int count;
+    uint8_t *values;                /* Scan side */
+    uint8_t *changes;
+    unsigned int generation;
+    uint8_t *snapshot;              /* I/O thread, for births */
+    int first_metric;
+    int num_metrics;
+} sp_area_t;
+
+/* Scan side state of one metric */
+typedef struct {
+    uint64_t last_value;            /* Last queued value */
+    bool queued;                    /* last_value is valid */
+} sp_metric_state_t;
+
+typedef struct {
+    uint32_t metric;
+    uint64_t value;
+} sp_entry_t;
+
+/* One DDATA: the metrics that changed in one scan */
+typedef struct {
+    uint64_t timestamp_ms;
+    int count;
+    sp_entry_t *entries;            /* num_metrics entries */
+} sp_batch_t;
+
+/* Plugin state */
+static plugin_logger_t g_logger;
+static plugin_runtime_args_t g_runtime_args;
+static mqtt_sparkplug_config_t g_config;
+static bool g_initialized = false;
+static volatile bool g_running = false;
+
+/* Commands run on the socket thread, init may replace the config meanwhile */
+static pthread_mutex_t g_command_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static sp_area_t g_areas[SP_NUM_BUFFER_TYPES];
+static int g_num_areas = 0;
+static int g_area_metrics[MQTT_SPARKPLUG_MAX_METRICS];
+static sp_metric_state_t g_metrics[MQTT_SPARKPLUG_MAX_METRICS];
+
+/* Batch queue: cycle_end produces at g_head, the I/O thread consumes at g_tail */
+static sp_batch_t *g_batches = NULL;
+static sp_entry_t *g_entries = NULL;
+static size_t g_queue_depth = 0;
+static atomic_size_t g_head;
+static atomic_size_t g_tail;
+static atomic_bool g_publishing;    /* Births sent, cycle_end queues batches */
+static atomic_int g_producing;      /* cycle_end is queueing a batch */
+static atomic_bool g_io_waiting;    /* The I/O thread sleeps, wake it with g_event_fd */
+static uint64_t g_last_batch_ms = 0;
+
+/* Counters */
+static atomic_ullong g_messages;    /* DDATA published */
+static atomic_ullong g_bytes;       /* Payload bytes published */
+static atomic_ullong g_overflows;   /* Scans that found the queue full */
+static atomic_ullong g_dropped;     /* Changes discarded, overflow "drop" */
+static atomic_ullong g_connects;
+
+/* I/O thread */
+static int g_event_fd = -1;
+static pthread_t g_thread;
+static bool g_thread_started = false;
+static mqtt_client_t g_client;
+static uint8_t *g_payload = NULL;
+static size_t g_payload_size = 0;
+static uint8_t g_will[SPARKPLUG_MAX_HEADER + SPARKPLUG_MAX_BIRTH_METRIC];
+static size_t g_will_len = 0;
+static uint64_t g_bdseq = 0;        /* Birth/death sequence, one per session */
+static uint64_t g_seq = 0;          /* Message sequence, 0 at NBIRTH */
+static bool g_rebirth = false;
+static atomic_bool g_connected;
+
+static char g_topic_nbirth[SP_TOPIC_LEN];
+static char g_topic_ndeath[SP_TOPIC_LEN];
+static char g_topic_ncmd[SP_TOPIC_LEN];
+static char g_topic_dbirth[SP_TOPIC_LEN];
+static char g_topic_ddata[SP_TOPIC_LEN];
+
+/* Metric handles, -1 if not registered */
+static int g_metric_messages = -1;
+static int g_metric_overflows = -1;
+
+/*
+ * =============================================================================
+ * Runtime Metrics
+ * =============================================================================
+ */
+
+static void register_metrics(void)
+{
+    if (g_runtime_args.metric_register == NULL || g_runtime_args.metric_add == NULL) {
+        return;
+    }
+    g_metric_messages = g_runtime_args.metric_register(g_runtime_args.plugin_id, "sparkplug_messages",
+                                                       "Sparkplug DDATA messages published",
+                                                       PLUGIN_METRIC_COUNTER);
+    g_metric_overflows = g_runtime_args.metric_register(g_runtime_args.plugin_id,
+                                                        "sparkplug_overflows",
+                                                        "Scans whose changes found the publish queue full",
+                                                        PLUGIN_METRIC_COUNTER);
+}
+
+static void metric_add(int handle, long long delta)
+{
+    if (handle >= 0 && delta != 0) {
+        g_runtime_args.metric_add(handle, delta);
+    }
+}
+
+/*
+ * =============================================================================
+ * Image Values
+ * =============================================================================
+ */
+
+static uint64_t load_value(const sp_area_t *area, const uint8_t *values, int k, int bit)
+{
+    const uint8_t *value = values + (size_t)k * (size_t)area->width;
+
+    if (area->is_bool) {
+        return (uint64_t)((*value >> bit) & 1);
+    }
+    switch (area->width) {
+    case 1:
+        return *value;
+    case 2: {
+        uint16_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    case 4: {
+        uint32_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    default: {
+        uint64_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    }
+}
+
+static bool metric_changed(const sp_area_t *area, int k, int bit)
+{
+    if (area->is_bool) {
+        return (area->changes[k] >> bit) & 1;
+    }
+    return (area->changes[k / 8] >> (k % 8)) & 1;
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+}
+
+/*
+ * =============================================================================
+ * I/O Thread
+ * =============================================================================
+ */
+
+/**
+ * @brief Sleep `ms` milliseconds or until the plugin is stopped
+ *
+ * @return false if the plugin is stopping
+ */
+static bool wait_ms(int ms)
+{
+    uint64_t deadline = mqtt_client_now_ms() + (uint64_t)ms;
+    struct pollfd pfd;
+    pfd.fd = g_event_fd;
+    pfd.events = POLLIN;
+
+    /* The event is also written by cycle_end; only the stop ends the wait */
+    while (g_running) {
+        uint64_t now = mqtt_client_now_ms();
+        if (now >= deadline) {
+            break;
+        }
+        pfd.revents = 0;
+        if (poll(&pfd, 1, (int)(deadline - now)) > 0) {
+            uint64_t count;
+            if (read(g_event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                break;
+            }
+        }
+    }
+    return g_running;
+}
+
+static void on_message(void *ctx, const char *topic, size_t topic_len, const uint8_t *payload,
+                       size_t payload_len)
+{
+    (void)ctx;
+    if (topic_len == strlen(g_topic_ncmd) && memcmp(topic, g_topic_ncmd, topic_len) == 0 &&
+        sparkplug_is_rebirth_request(payload, payload_len)) {
+        plugin_logger_info(&g_logger, "Rebirth requested");
+        g_rebirth = true;
+    }
+}
+
+static int publish(const char *topic, const sparkplug_writer_t *writer)
+{
+    if (writer->overflow) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    return mqtt_client_publish(&g_client, topic, writer->buf, writer->len, false);
+}
+
+static uint64_t next_seq(void)
+{
+    uint64_t seq = g_seq;
+    g_seq = (g_seq + 1) & 0xFF;
+    return seq;
+}
+
+/**
+ * @brief Publish NBIRTH and DBIRTH with the current value of every metric
+ *
+ * The batches queued so far hold older values than the snapshot and are
+ * discarded; the ones queued from now on are newer.
+ */
+static int send_births(void)
+{
+    size_t head = atomic_load_explicit(&g_head, memory_order_acquire);
+    atomic_store_explicit(&g_tail, head, memory_order_release);
+
+    /* Areas are published from the end of the scan after their first read */
+    for (int a = 0; a < g_num_areas; a++) {
+        sp_area_t *area = &g_areas[a];
+        int waited_ms = 0;
+        while (g_runtime_args.read_image_snapshot(area->type, area->first, area->count,
+                                                  area->snapshot) != area->count) {
+            if (waited_ms >= g_config.timeout_ms || !wait_ms(SP_SNAPSHOT_POLL_MS)) {
+                errno = EAGAIN;
+                return -1;
+            }
+            waited_ms += SP_SNAPSHOT_POLL_MS;
+        }
+    }
+
+    sparkplug_writer_t writer;
+    uint64_t timestamp = now_ms();
+
+    g_seq = 0;
+    sparkplug_begin(&writer, g_payload, g_payload_size, timestamp, true, next_seq());
+    sparkplug_add_metric(&writer, "bdSeq", 0, SPARKPLUG_UINT64, g_bdseq);
+    sparkplug_add_metric(&writer, SPARKPLUG_REBIRTH_METRIC, 0, SPARKPLUG_BOOLEAN, 0);
+    if (publish(g_topic_nbirth, &writer) != 0) {
+        return -1;
+    }
+
+    sparkplug_begin(&writer, g_payload, g_payload_size, timestamp, true, next_seq());
+    for (int a = 0; a < g_num_areas; a++) {
+        const sp_area_t *area = &g_areas[a];
+        for (int m = 0; m < area->num_metrics; m++) {
+            int i = g_area_metrics[area->first_metric + m];
+            const mqtt_sparkplug_metric_t *metric = &g_config.metrics[i];
+            uint64_t value = load_value(area, area->snapshot, metric->index - area->first, metric->bit);
+            sparkplug_add_metric(&writer, metric->name, (uint64_t)i + 1, metric->datatype, value);
+        }
+    }
+    return publish(g_topic_dbirth, &writer);
+}
+
+/**
+ * @brief Publish one DDATA per queued batch
+ */
+static int publish_batches(void)
+{
+    size_t tail = atomic_load_explicit(&g_tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&g_head, memory_order_acquire);
+    unsigned long long messages = 0;
+    unsigned long long bytes = 0;
+    int result = 0;
+
+    while (tail != head) {
+        const sp_batch_t *batch = &g_batches[tail % g_queue_depth];
+        sparkplug_writer_t writer;
+
+        sparkplug_begin(&writer, g_payload, g_payload_size, batch->timestamp_ms, true, next_seq());
+        for (int e = 0; e < batch->count; e++) {
+            const sp_entry_t *entry = &batch->entries[e];
+            sparkplug_add_metric(&writer, NULL, (uint64_t)entry->metric + 1,
+                                 g_config.metrics[entry->metric].datatype, entry->value);
+        }
+
+        /* Encoded: the slot can take the next batch while this one is sent */
+        tail++;
+        atomic_store_explicit(&g_tail, tail, memory_order_release);
+
+        if (publish(g_topic_ddata, &writer) != 0) {
+            result = -1;
+            break;
+        }
+        messages++;
+        bytes += writer.len;
+    }
+
+    atomic_fetch_add_explicit(&g_messages, messages, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_bytes, bytes, memory_order_relaxed);
+    metric_add(g_metric_messages, (long long)messages);
+    return result;
+}
+
+/**
+ * @brief Open the MQTT session, with NDEATH of the new bdSeq as the will
+ */
+static int connect_session(void)
+{
+    sparkplug_writer_t will;
+
+    g_bdseq = (g_bdseq + 1) & 0xFF;
+    sparkplug_begin(&will, g_will, sizeof(g_will), now_ms(), false, 0);
+    sparkplug_add_metric(&will, "bdSeq", 0, SPARKPLUG_UINT64, g_bdseq);
+    g_will_len = will.len;
+
+    mqtt_connect_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.client_id = g_config.client_id;
+    options.username = g_config.username;
+    options.password = g_config.password;
+    options.keepalive_s = g_config.keepalive_s;
+    options.will_topic = g_topic_ndeath;
+    options.will_payload = will.buf;
+    options.will_len = g_will_len;
+    options.will_qos = 1;           /* As the specification asks for NDEATH */
+
+    if (mqtt_client_connect(&g_client, g_config.host, g_config.port, &options) != 0) {
+        return -1;
+    }
+    if (mqtt_client_subscribe(&g_client, g_topic_ncmd) != 0) {
+        mqtt_client_close(&g_client);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Publish until the session fails or the plugin stops
+ */
+static void run_session(void)
+{
+    const uint64_t ping_interval = (uint64_t)g_config.keepalive_s * 500ull;
+    const uint64_t rx_timeout = (uint64_t)g_config.keepalive_s * 1500ull;
+
+    /* Pinged even while publishing: the PINGRESP proves the broker still reads */
+    uint64_t ping_at = mqtt_client_now_ms() + ping_interval;
+
+    g_rebirth = true;
+    while (g_running) {
+        if (g_rebirth) {
+            g_rebirth = false;
+            if (send_births() != 0) {
+                plugin_logger_error_limited(&g_logger, "Cannot publish births: %s",
+                                            errno == EAGAIN ? "image snapshot not available"
+                                                            : strerror(errno));
+                return;
+            }
+            atomic_store_explicit(&g_publishing, true, memory_order_release);
+        }
+
+        if (publish_batches() != 0) {
+            plugin_logger_error_limited(&g_logger, "Cannot publish to %s:%u: %s", g_config.host,
+                                        (unsigned)g_config.port, strerror(errno));
+            return;
+        }
+
+        uint64_t now = mqtt_client_now_ms();
+        if (now - g_client.last_rx_ms > rx_timeout) {
+            plugin_logger_error_limited(&g_logger, "Broker %s:%u stopped answering", g_config.host,
+                                        (unsigned)g_config.port);
+            return;
+        }
+        if (now >= ping_at) {
+            if (mqtt_client_ping(&g_client) != 0) {
+                plugin_logger_error_limited(&g_logger, "Cannot ping %s:%u: %s", g_config.host,
+                                            (unsigned)g_config.port, strerror(errno));
+                return;
+            }
+            ping_at = now + ping_interval;
+        }
+
+        /* Sleep until the next batch, something from the broker or the next ping */
+        atomic_store_explicit(&g_io_waiting, true, memory_order_seq_cst);
+        if (atomic_load_explicit(&g_head, memory_order_seq_cst) !=
+            atomic_load_explicit(&g_tail, memory_order_relaxed)) {
+            atomic_store_explicit(&g_io_waiting, false, memory_order_relaxed);
+            continue;
+        }
+
+        struct pollfd pfds[2];
+        pfds[0].fd = g_event_fd;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        pfds[1].fd = g_client.fd;
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+        now = mqtt_client_now_ms();
+        int timeout = ping_at > now ? (int)(ping_at - now) : 0;
+        int ready = poll(pfds, 2, timeout);
+        atomic_store_explicit(&g_io_waiting, false, memory_order_relaxed);
+        if (ready < 0 && errno != EINTR) {
+            plugin_logger_error(&g_logger, "poll failed: %s", strerror(errno));
+            return;
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            uint64_t count;
+            if (read(g_event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                plugin_logger_warn(&g_logger, "Failed to read wake event: %s", strerror(errno));
+            }
+        }
+        if ((pfds[1].revents & (POLLIN | POLLERR | POLLHUP)) && mqtt_client_read(&g_client) != 0) {
+            plugin_logger_error_limited(&g_logger, "Connection to %s:%u lost: %s", g_config.host,
+                                        (unsigned)g_config.port, strerror(errno));
+            return;
+        }
+    }
+}
+
+static void *io_thread(void *arg)
+{
+    (void)arg;
+    int delay_ms = SP_RETRY_DELAY_BASE_MS;
+
+    plugin_logger_info(&g_logger, "I/O thread started");
+
+    while (g_running) {
+        if (connect_session() != 0) {
+            plugin_logger_error_limited(&g_logger, "Cannot connect to %s:%u: %s, retrying in %d ms",
+                                        g_config.host, (unsigned)g_config.port, strerror(errno),
+                                        delay_ms);
+            wait_ms(delay_ms);
+            delay_ms = delay_ms * 2 > SP_RETRY_DELAY_MAX_MS ? SP_RETRY_DELAY_MAX_MS : delay_ms * 2;
+            continue;
+        }
+        delay_ms = SP_RETRY_DELAY_BASE_MS;
+        atomic_fetch_add_explicit(&g_connects, 1, memory_order_relaxed);
+        atomic_store(&g_connected, true);
+        plugin_logger_info(&g_logger, "Connected to %s:%u as %s, bdSeq %llu", g_config.host,
+                           (unsigned)g_config.port, g_config.client_id, (unsigned long long)g_bdseq);
+
+        run_session();
+
+        /* cycle_end stops queueing; its next read after the births reports every change */
+        atomic_store_explicit(&g_publishing, false, memory_order_release);
+        atomic_store(&g_connected, false);
+        if (g_running) {
+            mqtt_client_close(&g_client);   /* The broker publishes the will */
+            wait_ms(delay_ms);
+            continue;
+        }
+
+        /* Stopping: publish NDEATH ourselves, a clean DISCONNECT discards the will */
+        if (mqtt_client_publish(&g_client, g_topic_ndeath, g_will, g_will_len, false) != 0) {
+            plugin_logger_warn(&g_logger, "Cannot publish NDEATH: %s", strerror(errno));
+        }
+        mqtt_client_disconnect(&g_client);
+    }
+
+    plugin_logger_info(&g_logger, "I/O thread finished");
+    return NULL;
+}
+
+/*
+ * =============================================================================
+ * Setup
+ * =============================================================================
+ */
+
+static void free_buffers(void)
+{
+    for (int i = 0; i < g_num_areas; i++) {
+        free(g_areas[i].values);
+        free(g_areas[i].changes);
+        free(g_areas[i].snapshot);
+    }
+    memset(g_areas, 0, sizeof(g_areas));
+    g_num_areas = 0;
+    free(g_batches);
+    g_batches = NULL;
+    free(g_entries);
+    g_entries = NULL;
+    g_queue_depth = 0;
+    free(g_payload);
+    g_payload = NULL;
+    g_payload_size = 0;
+}
+
+static int area_width(int type)
+{
+    if (type <= 4) {
+        return 1;                   /* BOOL (packed) and BYTE */
+    }
+    if (type <= 7) {
+        return 2;
+    }
+    return type <= 10 ? 4 : 8;
+}
+
+/**
+ * @brief Group the metrics by image area and allocate the buffers
+ *
+ * Metrics beyond the image tables are logged and not published.
+ */
+static int setup_buffers(void)
+{
+    int next_metric = 0;
+
+    for (int type = 0; type < SP_NUM_BUFFER_TYPES; type++) {
+        sp_area_t *area = &g_areas[g_num_areas];
+        int first = -1;
+        int end = 0;
+
+        area->first_metric = next_metric;
+        for (int i = 0; i < g_config.num_metrics; i++) {
+            const mqtt_sparkplug_metric_t *metric = &g_config.metrics[i];
+            if (metric->buffer_type != type) {
+                continue;
+            }
+            if (metric->index >= g_runtime_args.buffer_size) {
+                plugin_logger_error(&g_logger, "[%s] %s exceeds the image table, metric ignored",
+                                    metric->name, metric->address);
+                continue;
+            }
+            g_area_metrics[next_metric++] = i;
+            if (first < 0 || metric->index < first) {
+                first = metric->index;
+            }
+            if (metric->index + 1 > end) {
+                end = metric->index + 1;
+            }
+        }
+        if (first < 0) {
+            continue;
+        }
+
+        area->type = type;
+        area->is_bool = type <= 2;
+        area->width = area_width(type);
+        area->first = first;
+        area->count = end - first;
+        area->num_metrics = next_metric - area->first_metric;
+        area->values = malloc((size_t)area->count * (size_t)area->width);
+        area->snapshot = malloc((size_t)area->count * (size_t)area->width);
+        area->changes = malloc(area->is_bool ? (size_t)area->count : ((size_t)area->count + 7) / 8);
+        g_num_areas++;
+        if (area->values == NULL || area->snapshot == NULL || area->changes == NULL) {
+            return -1;
+        }
+    }
+
+    size_t num_metrics = (size_t)g_config.num_metrics;
+    g_queue_depth = (size_t)g_config.queue_depth;
+    g_batches = calloc(g_queue_depth, sizeof(sp_batch_t));
+    g_entries = calloc(g_queue_depth * num_metrics, sizeof(sp_entry_t));
+    g_payload_size = SPARKPLUG_MAX_HEADER + num_metrics * SPARKPLUG_MAX_BIRTH_METRIC;
+    g_payload = malloc(g_payload_size);
+    if (g_batches == NULL || g_entries == NULL || g_payload == NULL) {
+        return -1;
+    }
+    for (size_t b = 0; b < g_queue_depth; b++) {
+        g_batches[b].entries = &g_entries[b * num_metrics];
+    }
+    return 0;
+}
+
+static void build_topics(void)
+{
+    const char *group = g_config.group_id;
+    const char *node = g_config.edge_node_id;
+    const char *device = g_config.device_id;
+
+    snprintf(g_topic_nbirth, SP_TOPIC_LEN, "spBv1.0/%s/NBIRTH/%s", group, node);
+    snprintf(g_topic_ndeath, SP_TOPIC_LEN, "spBv1.0/%s/NDEATH/%s", group, node);
+    snprintf(g_topic_ncmd, SP_TOPIC_LEN, "spBv1.0/%s/NCMD/%s", group, node);
+    snprintf(g_topic_dbirth, SP_TOPIC_LEN, "spBv1.0/%s/DBIRTH/%s/%s", group, node, device);
+    snprintf(g_topic_ddata, SP_TOPIC_LEN, "spBv1.0/%s/DDATA/%s/%s", group, node, device);
+}
+
+/*
+ * =============================================================================
+ * Socket Commands
+ * =============================================================================
+ */
+
+static void command_stats(char *response, size_t response_size)
+{
+    size_t head = atomic_load_explicit(&g_head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&g_tail, memory_order_acquire);
+
+    snprintf(response, response_size,
+             "{\"connected\":%s,\"broker\":\"%s:%u\",\"metrics\":%d,\"messages\":%llu,\"bytes\":%llu"
+             ",\"queued\":%zu,\"overflows\":%llu,\"dropped\":%llu,\"connects\":%llu,\"bdseq\":%llu}\n",
+             atomic_load(&g_connected) ? "true" : "false", g_config.host, (unsigned)g_config.port,
+             g_config.num_metrics, (unsigned long long)atomic_load(&g_messages),
+             (unsigned long long)atomic_load(&g_bytes), head - tail,
+             (unsigned long long)atomic_load(&g_overflows), (unsigned long long)atomic_load(&g_dropped),
+             (unsigned long long)atomic_load(&g_connects), (unsigned long long)g_bdseq);
+}
+
+/*
+ * =============================================================================
+ * Plugin Lifecycle Functions
+ * =============================================================================
+ */
+
+/**
+ * @brief Initialize the MQTT Sparkplug plugin
+ */
+int init(void *args)
+{
+    /* Initialize logger first (before we have runtime_args) */
+    plugin_logger_init(&g_logger, "MQTT_SPARKPLUG", NULL);
+    plugin_logger_info(&g_logger, "Initializing MQTT Sparkplug plugin...");
+
+    if (!args) {
+        plugin_logger_error(&g_logger, "init args is NULL");
+        return -1;
+    }
+
+    /* Copy runtime args (critical - pointer is freed after init returns) */
+    memcpy(&g_runtime_args, args, sizeof(plugin_runtime_args_t));
+
+    /* Re-initialize logger with runtime_args for central logging */
+    plugin_logger_init(&g_logger, "MQTT_SPARKPLUG", args);
+
+    if (g_runtime_args.read_image_changes == NULL || g_runtime_args.read_image_snapshot == NULL) {
+        plugin_logger_error(&g_logger, "The runtime does not provide snapshot reads");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_command_lock);
+    g_initialized = false;
+    free_buffers();
+    memset(g_metrics, 0, sizeof(g_metrics));
+
+    const char *config_path = g_runtime_args.plugin_specific_config_file_path;
+    plugin_logger_info(&g_logger, "Loading config: %s", config_path);
+    int result = mqtt_sparkplug_config_parse(config_path, &g_config);
+    if (result != 0) {
+        pthread_mutex_unlock(&g_command_lock);
+        plugin_logger_error(&g_logger, "Failed to load config file (error %d)", result);
+        return -1;
+    }
+
+    if (setup_buffers() != 0) {
+        free_buffers();
+        pthread_mutex_unlock(&g_command_lock);
+        plugin_logger_error(&g_logger, "Failed to allocate the publish buffers");
+        return -1;
+    }
+    build_topics();
+    mqtt_client_init(&g_client, g_config.timeout_ms, on_message, NULL);
+    g_initialized = true;
+    pthread_mutex_unlock(&g_command_lock);
+
+    register_metrics();
+    plugin_logger_info(&g_logger, "Configuration loaded successfully: %d metric(s) in %d area(s), "
+                       "broker %s:%u, device %s/%s/%s",
+                       g_config.num_metrics, g_num_areas, g_config.host, (unsigned)g_config.port,
+                       g_config.group_id, g_config.edge_node_id, g_config.device_id);
+    return 0;
+}
+
+/**
+ * @brief Start the I/O thread
+ */
+void start_loop(void)
+{
+    if (!g_initialized) {
+        plugin_logger_error(&g_logger, "Cannot start - plugin not initialized");
+        return;
+    }
+
+    if (g_running) {
+        plugin_logger_warn(&g_logger, "Already running");
+        return;
+    }
+
+    g_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (g_event_fd < 0) {
+        plugin_logger_error(&g_logger, "Failed to create wake event: %s", strerror(errno));
+        return;
+    }
+
+    for (int i = 0; i < g_config.num_metrics; i++) {
+        g_metrics[i].queued = false;
+    }
+    for (int i = 0; i < g_num_areas; i++) {
+        g_areas[i].generation = 0;
+    }
+    atomic_store(&g_head, 0);
+    atomic_store(&g_tail, 0);
+    g_last_batch_ms = 0;
+
+    g_running = true;
+    if (pthread_create(&g_thread, NULL, io_thread, NULL) != 0) {
+        plugin_logger_error(&g_logger, "Failed to create I/O thread");
+        g_running = false;
+        close(g_event_fd);
+        g_event_fd = -1;
+        return;
+    }
+    g_thread_started = true;
+    plugin_logger_info(&g_logger, "Publishing %d metric(s) to %s:%u", g_config.num_metrics,
+                       g_config.host, (unsigned)g_config.port);
+}
+
+/**
+ * @brief Stop the I/O thread
+ */
+void stop_loop(void)
+{
+    if (!g_running) {
+        plugin_logger_debug(&g_logger, "Already stopped");
+        return;
+    }
+
+    /* No batch is queued after this */
+    atomic_store_explicit(&g_publishing, false, memory_order_release);
+    while (atomic_load_explicit(&g_producing, memory_order_acquire)) {
+        sched_yield();
+    }
+
+    g_running = false;
+    uint64_t one = 1;
+    if (write(g_event_fd, &one, sizeof(one)) < 0) {
+        plugin_logger_warn(&g_logger, "Failed to signal stop event: %s", strerror(errno));
+    }
+
+    if (g_thread_started) {
+        pthread_join(g_thread, NULL);
+        g_thread_started = false;
+    }
+    close(g_event_fd);
+    g_event_fd = -1;
+    plugin_logger_info(&g_logger, "Main loop stopped");
+}
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void)
+{
+    if (g_running) {
+        stop_loop();
+    }
+
+    pthread_mutex_lock(&g_command_lock);
+    free_buffers();
+    g_initialized = false;
+    pthread_mutex_unlock(&g_command_lock);
+    plugin_logger_info(&g_logger, "MQTT Sparkplug plugin cleanup complete");
+}
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ */
+void cycle_start(void)
+{
+    /* Changes are collected at the end of the scan */
+}
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Also called outside a scan by the safe state, possibly from the watchdog
+ * thread; g_producing keeps a single producer on the queue.
+ */
+void cycle_end(void)
+{
+    if (!atomic_load_explicit(&g_publishing, memory_order_acquire) ||
+        atomic_exchange_explicit(&g_producing, 1, memory_order_acquire) != 0) {
+        return;
+    }
+    if (!atomic_load_explicit(&g_publishing, memory_order_acquire)) {
+        atomic_store_explicit(&g_producing, 0, memory_order_release);
+        return;
+    }
+
+    /* Unread scans are not lost: the next read reports all their changes */
+    uint64_t now = mqtt_client_now_ms();
+    if (g_config.interval_ms > 0 && now - g_last_batch_ms < (uint64_t)g_config.interval_ms) {
+        atomic_store_explicit(&g_producing, 0, memory_order_release);
+        return;
+    }
+
+    size_t head = atomic_load_explicit(&g_head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&g_tail, memory_order_acquire);
+    sp_batch_t *batch = NULL;
+    if (head - tail < g_queue_depth) {
+        batch = &g_batches[head % g_queue_depth];
+    } else {
+        atomic_fetch_add_explicit(&g_overflows, 1, memory_order_relaxed);
+        metric_add(g_metric_overflows, 1);
+        if (g_config.overflow == MQTT_SPARKPLUG_OVERFLOW_MERGE) {
+            atomic_store_explicit(&g_producing, 0, memory_order_release);
+            return;
+        }
+    }
+
+    int count = 0;
+    unsigned long long dropped = 0;
+    for (int a = 0; a < g_num_areas; a++) {
+        sp_area_t *area = &g_areas[a];
+
+        /* Every bit is set on the first read and after missed scans */
+        if (g_runtime_args.read_image_changes(area->type, area->first, area->count, area->values,
+                                              area->changes, &area->generation) != area->count) {
+            continue;
+        }
+
+        for (int m = 0; m < area->num_metrics; m++) {
+            int i = g_area_metrics[area->first_metric + m];
+            const mqtt_sparkplug_metric_t *metric = &g_config.metrics[i];
+            sp_metric_state_t *state = &g_metrics[i];
+            int k = metric->index - area->first;
+
+            if (!metric_changed(area, k, metric->bit)) {
+                continue;
+            }
+            uint64_t value = load_value(area, area->values, k, metric->bit);
+            if (state->queued && value == state->last_value) {
+                continue;
+            }
+            state->last_value = value;
+            state->queued = true;
+
+            if (batch == NULL) {
+                dropped++;
+                continue;
+            }
+            batch->entries[count].metric = (uint32_t)i;
+            batch->entries[count].value = value;
+            count++;
+        }
+    }
+
+    if (batch != NULL && count > 0) {
+        batch->timestamp_ms = now_ms();
+        batch->count = count;
+        atomic_store_explicit(&g_head, head + 1, memory_order_seq_cst);
+        g_last_batch_ms = now;
+
+        if (atomic_load_explicit(&g_io_waiting, memory_order_seq_cst) &&
+            atomic_exchange_explicit(&g_io_waiting, false, memory_order_relaxed)) {
+            uint64_t one = 1;
+            if (write(g_event_fd, &one, sizeof(one)) < 0) {
+                /* The I/O thread wakes up for the next ping at the latest */
+            }
+        }
+    }
+    if (dropped > 0) {
+        atomic_fetch_add_explicit(&g_dropped, dropped, memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_producing, 0, memory_order_release);
+}
+
+/**
+ * @brief Answer a PLUGIN:<name>:<command> socket command
+ */
+void handle_command(const char *command, char *response, size_t response_size)
+{
+    pthread_mutex_lock(&g_command_lock);
+    if (!g_initialized) {
+        snprintf(response, response_size, "PLUGIN:ERROR_NOT_INITIALIZED\n");
+    } else if (strcmp(command, "STATS") == 0) {
+        command_stats(response, response_size);
+    } else {
+        snprintf(response, response_size, "PLUGIN:ERROR_COMMAND\n");
+    }
+    pthread_mutex_unlock(&g_command_lock);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file mqtt_sparkplug_plugin.h
+ * @brief Native MQTT Sparkplug B Publisher Plugin for OpenPLC Runtime v4
+ *
+ * This plugin publishes the configured PLC variables as the metrics of a
+ * Sparkplug B device: a birth certificate with every value when the session
+ * to the broker starts, then one DDATA message per scan (or per
+ * publish.interval_ms) with the metrics that changed.
+ */
+
+#ifndef MQTT_SPARKPLUG_PLUGIN_H
+#define MQTT_SPARKPLUG_PLUGIN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the MQTT Sparkplug plugin
+ *
+ * Called when the plugin is loaded, and again when it is restarted with a
+ * new configuration. Parses the metric list and allocates the buffers the
+ * scan hook and the I/O thread use.
+ *
+ * @param args Pointer to plugin_runtime_args_t containing runtime buffers,
+ *             mutex functions, and logging function pointers
+ * @return 0 on success, -1 on failure
+ */
+int init(void *args);
+
+/**
+ * @brief Start the I/O thread, which connects to the broker and publishes
+ */
+void start_loop(void);
+
+/**
+ * @brief Stop publishing; the I/O thread sends NDEATH, disconnects and exits
+ */
+void stop_loop(void);
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void);
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ *
+ * Nothing to do: changes are collected at the end of the scan.
+ */
+void cycle_start(void);
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Reads the change bits of the metric areas from the image snapshot and
+ * queues the changed metrics as one DDATA batch for the I/O thread. Never
+ * takes buffer_mutex, allocates memory or waits on the network.
+ */
+void cycle_end(void);
+
+/**
+ * @brief Answer a PLUGIN:<name>:<command> socket command
+ *
+ * - STATS: session and publishing counters
+ */
+void handle_command(const char *command, char *response, size_t response_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_SPARKPLUG_PLUGIN_H */
@@ -0,0 +1,265 @@
+/**
+ * @file sparkplug_payload.c
+ * @brief Sparkplug B payload encoding implementation
+ *
+ * Field numbers are those of sparkplug_b.proto:
+ *   Payload: timestamp = 1, metrics = 2, seq = 3
+ *   Metric:  name = 1, alias = 2, datatype = 4, int_value = 10,
+ *            long_value = 11, float_value = 12, double_value = 13,
+ *            boolean_value = 14
+ */
+
+#include "sparkplug_payload.h"
+
+#include <string.h>
+
+/* Protobuf wire types */
+#define WIRE_VARINT     0
+#define WIRE_FIXED64    1
+#define WIRE_LEN        2
+#define WIRE_FIXED32    5
+
+/* Largest varint, 64 bits in 7-bit groups */
+#define VARINT_MAX      10
+
+static size_t put_varint(uint8_t *buf, uint64_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80) {
+        buf[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[len++] = (uint8_t)value;
+    return len;
+}
+
+static size_t put_key(uint8_t *buf, unsigned field, unsigned wire)
+{
+    return put_varint(buf, ((uint64_t)field << 3) | wire);
+}
+
+/* Fixed-width fields are little endian on the wire */
+static size_t put_fixed(uint8_t *buf, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        buf[i] = (uint8_t)(value >> (8 * i));
+    }
+    return (size_t)bytes;
+}
+
+static bool reserve(sparkplug_writer_t *writer, size_t len)
+{
+    if (writer->overflow || writer->size - writer->len < len) {
+        writer->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+void sparkplug_begin(sparkplug_writer_t *writer, uint8_t *buf, size_t size, uint64_t timestamp_ms,
+                     bool has_seq, uint64_t seq)
+{
+    writer->buf = buf;
+    writer->size = size;
+    writer->len = 0;
+    writer->overflow = false;
+
+    if (!reserve(writer, 2 * (1 + VARINT_MAX))) {
+        return;
+    }
+    writer->len += put_key(buf + writer->len, 1, WIRE_VARINT);
+    writer->len += put_varint(buf + writer->len, timestamp_ms);
+    if (has_seq) {
+        writer->len += put_key(buf + writer->len, 3, WIRE_VARINT);
+        writer->len += put_varint(buf + writer->len, seq);
+    }
+}
+
+/**
+ * @brief The value field of the datatype, from the raw bits
+ */
+static size_t put_value(uint8_t *buf, sparkplug_datatype_t datatype, uint64_t raw)
+{
+    size_t len = 0;
+
+    switch (datatype) {
+    case SPARKPLUG_BOOLEAN:
+        len += put_key(buf, 14, WIRE_VARINT);
+        len += put_varint(buf + len, raw != 0);
+        break;
+    case SPARKPLUG_INT8:
+    case SPARKPLUG_INT16: {
+        /* Signed types travel in int_value as 32-bit two's complement */
+        int shift = datatype == SPARKPLUG_INT8 ? 56 : 48;
+        int64_t value = (int64_t)(raw << shift) >> shift;
+        len += put_key(buf, 10, WIRE_VARINT);
+        len += put_varint(buf + len, (uint32_t)value);
+        break;
+    }
+    case SPARKPLUG_INT32:
+    case SPARKPLUG_UINT8:
+    case SPARKPLUG_UINT16:
+    case SPARKPLUG_UINT32:
+        len += put_key(buf, 10, WIRE_VARINT);
+        len += put_varint(buf + len, (uint32_t)raw);
+        break;
+    case SPARKPLUG_FLOAT:
+        len += put_key(buf, 12, WIRE_FIXED32);
+        len += put_fixed(buf + len, raw, 4);
+        break;
+    case SPARKPLUG_DOUBLE:
+        len += put_key(buf, 13, WIRE_FIXED64);
+        len += put_fixed(buf + len, raw, 8);
+        break;
+    default:
+        /* INT64 and UINT64 */
+        len += put_key(buf, 11, WIRE_VARINT);
+        len += put_varint(buf + len, raw);
+        break;
+    }
+    return len;
+}
+
+void sparkplug_add_metric(sparkplug_writer_t *writer, const char *name, uint64_t alias,
+                          sparkplug_datatype_t datatype, uint64_t raw)
+{
+    uint8_t metric[SPARKPLUG_MAX_BIRTH_METRIC];
+    size_t len = 0;
+
+    if (name != NULL) {
+        size_t name_len = strnlen(name, MQTT_SPARKPLUG_MAX_NAME_LEN - 1);
+        len += put_key(metric, 1, WIRE_LEN);
+        len += put_varint(metric + len, name_len);
+        memcpy(metric + len, name, name_len);
+        len += name_len;
+    }
+    if (alias != 0) {
+        len += put_key(metric + len, 2, WIRE_VARINT);
+        len += put_varint(metric + len, alias);
+    }
+    if (name != NULL) {
+        len += put_key(metric + len, 4, WIRE_VARINT);
+        len += put_varint(metric + len, (uint64_t)datatype);
+    }
+    len += put_value(metric + len, datatype, raw);
+
+    /* Embedded message: key, length, body */
+    if (!reserve(writer, 1 + VARINT_MAX + len)) {
+        return;
+    }
+    writer->len += put_key(writer->buf + writer->len, 2, WIRE_LEN);
+    writer->len += put_varint(writer->buf + writer->len, len);
+    memcpy(writer->buf + writer->len, metric, len);
+    writer->len += len;
+}
+
+/*
+ * =============================================================================
+ * Decoding
+ * =============================================================================
+ */
+
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+} pb_reader_t;
+
+static bool get_varint(pb_reader_t *reader, uint64_t *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 64 && reader->pos < reader->end; shift += 7) {
+        uint8_t byte = *reader->pos++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Read one field: varint fields in *value, others as the bytes at *data
+ */
+static bool get_field(pb_reader_t *reader, unsigned *field, unsigned *wire, uint64_t *value,
+                      const uint8_t **data)
+{
+    uint64_t key = 0;
+    size_t len = 0;
+
+    if (!get_varint(reader, &key)) {
+        return false;
+    }
+    *field = (unsigned)(key >> 3);
+    *wire = (unsigned)(key & 7);
+    *data = reader->pos;
+
+    switch (*wire) {
+    case WIRE_VARINT:
+        return get_varint(reader, value);
+    case WIRE_FIXED64:
+        len = 8;
+        break;
+    case WIRE_FIXED32:
+        len = 4;
+        break;
+    case WIRE_LEN:
+        if (!get_varint(reader, value)) {
+            return false;
+        }
+        *data = reader->pos;
+        len = (size_t)*value;
+        break;
+    default:
+        return false;               /* Groups are not used by Sparkplug */
+    }
+
+    if ((size_t)(reader->end - reader->pos) < len) {
+        return false;
+    }
+    reader->pos += len;
+    return true;
+}
+
+static bool is_rebirth_metric(const uint8_t *data, size_t len)
+{
+    static const char rebirth[] = SPARKPLUG_REBIRTH_METRIC;
+    pb_reader_t reader = { data, data + len };
+    bool named = false;
+    bool value = false;
+    unsigned field;
+    unsigned wire;
+    uint64_t number;
+    const uint8_t *bytes;
+
+    while (reader.pos < reader.end) {
+        if (!get_field(&reader, &field, &wire, &number, &bytes)) {
+            return false;
+        }
+        if (field == 1 && wire == WIRE_LEN) {
+            named = number == sizeof(rebirth) - 1 && memcmp(bytes, rebirth, sizeof(rebirth) - 1) == 0;
+        } else if (field == 14 && wire == WIRE_VARINT) {
+            value = number != 0;
+        }
+    }
+    return named && value;
+}
+
+bool sparkplug_is_rebirth_request(const uint8_t *payload, size_t len)
+{
+    pb_reader_t reader = { payload, payload + len };
+    unsigned field;
+    unsigned wire;
+    uint64_t number;
+    const uint8_t *bytes;
+
+    while (reader.pos < reader.end) {
+        if (!get_field(&reader, &field, &wire, &number, &bytes)) {
+            return false;
+        }
+        if (field == 2 && wire == WIRE_LEN && is_rebirth_metric(bytes, (size_t)number)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file sparkplug_payload.h
+ * @brief Sparkplug B payload encoding
+ *
+ * Writes the protobuf encoding of the Sparkplug B Payload message (timestamp,
+ * metrics, seq) straight into a caller buffer, without a protobuf library or
+ * an intermediate message tree. Metric values are the raw bits of the image
+ * table, converted to the value field of their datatype.
+ */
+
+#ifndef SPARKPLUG_PAYLOAD_H
+#define SPARKPLUG_PAYLOAD_H
+
+#include "mqtt_sparkplug_config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Name of the node metric a host sets to ask for a rebirth */
+#define SPARKPLUG_REBIRTH_METRIC    "Node Control/Rebirth"
+
+/* Upper bounds of one encoded metric, for sizing payload buffers */
+#define SPARKPLUG_MAX_DATA_METRIC   32
+#define SPARKPLUG_MAX_BIRTH_METRIC  (SPARKPLUG_MAX_DATA_METRIC + MQTT_SPARKPLUG_MAX_NAME_LEN + 8)
+#define SPARKPLUG_MAX_HEADER        32
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;                  /* The buffer was too small, len is not valid */
+} sparkplug_writer_t;
+
+/**
+ * @brief Start a payload: timestamp (ms since the epoch) and, if has_seq, seq
+ */
+void sparkplug_begin(sparkplug_writer_t *writer, uint8_t *buf, size_t size, uint64_t timestamp_ms,
+                     bool has_seq, uint64_t seq);
+
+/**
+ * @brief Append a metric
+ *
+ * @param name      Metric name, NULL to identify the metric by alias only
+ * @param alias     Alias, 0 for none
+ * @param datatype  Type of the value field; sent in the metric if name is
+ *                  set (births), omitted otherwise as the specification asks
+ * @param raw       Value as raw bits: the IEC variable, zero extended
+ */
+void sparkplug_add_metric(sparkplug_writer_t *writer, const char *name, uint64_t alias,
+                          sparkplug_datatype_t datatype, uint64_t raw);
+
+/**
+ * @brief Whether a payload (NCMD) sets Node Control/Rebirth to true
+ */
+bool sparkplug_is_rebirth_request(const uint8_t *payload, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARKPLUG_PAYLOAD_H */
@@ -5,6 +5,7 @@
 
 #include "plugin_logger.h"
 #include "../../plugin_types.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
@@ -25,6 +26,9 @@ bool plugin_logger_init(plugin_logger_t *logger, const char *plugin_name, void *
     logger->log_debug = NULL;
     logger->log_warn = NULL;
     logger->log_error = NULL;
+    logger->log_message = NULL;
+    logger->log_limited = NULL;
+    logger->plugin_id = 0;
     logger->plugin_name[0] = '\0';
 
     if (!plugin_name)
@@ -51,6 +55,9 @@ bool plugin_logger_init(plugin_logger_t *logger, const char *plugin_name, void *
     logger->log_debug = args->log_debug;
     logger->log_warn = args->log_warn;
     logger->log_error = args->log_error;
+    logger->log_message = args->log_message;
+    logger->log_limited = args->log_limited;
+    logger->plugin_id = args->plugin_id;
 
     /* Validate that we have at least the basic logging functions */
     if (logger->log_info && logger->log_error)
@@ -70,7 +77,8 @@ bool plugin_logger_init(plugin_logger_t *logger, const char *plugin_name, void *
  * @brief Internal helper to format and send log message
  */
 static void plugin_logger_log(plugin_logger_t *logger, plugin_log_func_t log_func,
-                              const char *level, const char *fmt, va_list args)
+                              int level_id, const char *level, bool limited, const char *fmt,
+                              va_list args)
 {
     char message[MAX_LOG_MESSAGE_SIZE];
     char prefixed_message[MAX_LOG_MESSAGE_SIZE];
@@ -82,7 +90,18 @@ static void plugin_logger_log(plugin_logger_t *logger, plugin_log_func_t log_fun
     snprintf(prefixed_message, sizeof(prefixed_message), "[%s] %s", logger->plugin_name, message);
 
     /* Use central logging if available, otherwise fall back to printf */
-    if (log_func)
+    if (limited && logger->log_limited)
+    {
+        /* The format string address identifies the call site */
+        uintptr_t site = (uintptr_t)fmt;
+        logger->log_limited(logger->plugin_id, level_id, (unsigned int)(site ^ (site >> 32)),
+                            prefixed_message);
+    }
+    else if (logger->log_message)
+    {
+        logger->log_message(logger->plugin_id, level_id, prefixed_message);
+    }
+    else if (log_func)
     {
         log_func("%s", prefixed_message);
     }
@@ -101,7 +120,7 @@ void plugin_logger_info(plugin_logger_t *logger, const char *fmt, ...)
 
     va_list args;
     va_start(args, fmt);
-    plugin_logger_log(logger, logger->log_info, "INFO", fmt, args);
+    plugin_logger_log(logger, logger->log_info, PLUGIN_LOG_LEVEL_INFO, "INFO", false, fmt, args);
     va_end(args);
 }
 
@@ -114,7 +133,7 @@ void plugin_logger_debug(plugin_logger_t *logger, const char *fmt, ...)
 
     va_list args;
     va_start(args, fmt);
-    plugin_logger_log(logger, logger->log_debug, "DEBUG", fmt, args);
+    plugin_logger_log(logger, logger->log_debug, PLUGIN_LOG_LEVEL_DEBUG, "DEBUG", false, fmt, args);
     va_end(args);
 }
 
@@ -127,7 +146,7 @@ void plugin_logger_warn(plugin_logger_t *logger, const char *fmt, ...)
 
     va_list args;
     va_start(args, fmt);
-    plugin_logger_log(logger, logger->log_warn, "WARN", fmt, args);
+    plugin_logger_log(logger, logger->log_warn, PLUGIN_LOG_LEVEL_WARN, "WARN", false, fmt, args);
     va_end(args);
 }
 
@@ -140,6 +159,58 @@ void plugin_logger_error(plugin_logger_t *logger, const char *fmt, ...)
 
     va_list args;
     va_start(args, fmt);
-    plugin_logger_log(logger, logger->log_error, "ERROR", fmt, args);
+    plugin_logger_log(logger, logger->log_error, PLUGIN_LOG_LEVEL_ERROR, "ERROR", false, fmt, args);
+    va_end(args);
+}
+
+void plugin_logger_info_limited(plugin_logger_t *logger, const char *fmt, ...)
+{
+    if (!logger || !fmt)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    plugin_logger_log(logger, logger->log_info, PLUGIN_LOG_LEVEL_INFO, "INFO", true, fmt, args);
+    va_end(args);
+}
+
+void plugin_logger_debug_limited(plugin_logger_t *logger, const char *fmt, ...)
+{
+    if (!logger || !fmt)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    plugin_logger_log(logger, logger->log_debug, PLUGIN_LOG_LEVEL_DEBUG, "DEBUG", true, fmt, args);
+    va_end(args);
+}
+
+void plugin_logger_warn_limited(plugin_logger_t *logger, const char *fmt, ...)
+{
+    if (!logger || !fmt)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    plugin_logger_log(logger, logger->log_warn, PLUGIN_LOG_LEVEL_WARN, "WARN", true, fmt, args);
+    va_end(args);
+}
+
+void plugin_logger_error_limited(plugin_logger_t *logger, const char *fmt, ...)
+{
+    if (!logger || !fmt)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    plugin_logger_log(logger, logger->log_error, PLUGIN_LOG_LEVEL_ERROR, "ERROR", true, fmt, args);
     va_end(args);
 }
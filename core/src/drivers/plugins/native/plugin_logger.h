@@ -37,6 +37,8 @@
  * @brief Logging function pointer types (matching plugin_driver.h)
  */
 typedef void (*plugin_log_func_t)(const char *fmt, ...);
+typedef void (*plugin_log_message_t)(int source, int level, const char *message);
+typedef void (*plugin_log_limited_t)(int source, int level, unsigned int key, const char *message);
 
 /**
  * @brief Plugin logger structure
@@ -46,12 +48,15 @@ typedef void (*plugin_log_func_t)(const char *fmt, ...);
  */
 typedef struct
 {
-    char plugin_name[64];           /**< Plugin name used as prefix in log messages */
-    plugin_log_func_t log_info;     /**< Info level logging function */
-    plugin_log_func_t log_debug;    /**< Debug level logging function */
-    plugin_log_func_t log_warn;     /**< Warning level logging function */
-    plugin_log_func_t log_error;    /**< Error level logging function */
-    bool is_valid;                  /**< True if logger is properly initialized */
+    char plugin_name[64];             /**< Plugin name used as prefix in log messages */
+    plugin_log_func_t log_info;       /**< Info level logging function */
+    plugin_log_func_t log_debug;      /**< Debug level logging function */
+    plugin_log_func_t log_warn;       /**< Warning level logging function */
+    plugin_log_func_t log_error;      /**< Error level logging function */
+    plugin_log_message_t log_message; /**< Preformatted logging tagged with plugin_id, if provided */
+    plugin_log_limited_t log_limited; /**< Rate-limited variant of log_message, if provided */
+    int plugin_id;                    /**< Source id of this plugin's log records */
+    bool is_valid;                    /**< True if logger is properly initialized */
 } plugin_logger_t;
 
 /**
@@ -107,4 +112,21 @@ void plugin_logger_warn(plugin_logger_t *logger, const char *fmt, ...);
  */
 void plugin_logger_error(plugin_logger_t *logger, const char *fmt, ...);
 
+/**
+ * @brief Rate-limited variants for call sites that can fire at high rates
+ *
+ * Each call site (identified by its format string) may log a short burst,
+ * then a few messages per second; the runtime reports the suppressed repeats
+ * as "(repeated N more times)". Without runtime support they behave like the
+ * plain functions.
+ *
+ * @param logger Pointer to initialized plugin logger
+ * @param fmt Printf-style format string, also the call site key
+ * @param ... Format arguments
+ */
+void plugin_logger_info_limited(plugin_logger_t *logger, const char *fmt, ...);
+void plugin_logger_debug_limited(plugin_logger_t *logger, const char *fmt, ...);
+void plugin_logger_warn_limited(plugin_logger_t *logger, const char *fmt, ...);
+void plugin_logger_error_limited(plugin_logger_t *logger, const char *fmt, ...);
+
 #endif /* PLUGIN_LOGGER_H */
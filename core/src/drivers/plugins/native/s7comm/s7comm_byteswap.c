@@ -0,0 +1,186 @@
+/**
+ * @file s7comm_byteswap.c
+ * @brief Bulk endian conversion kernels
+ *
+ * The vector kernels reverse the bytes of every element of a 16 or 32 byte
+ * block with one shuffle; the scalar loop converts what is left below one
+ * block. On x86 the AVX2 and SSSE3 kernels are compiled with target
+ * attributes, so the plugin still loads on CPUs without them.
+ */
+
+#include "s7comm_byteswap.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define S7COMM_SWAP_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define S7COMM_SWAP_NEON
+#include <arm_neon.h>
+#endif
+
+typedef void (*swap_kernel_t)(uint8_t *dest, const uint8_t *src, size_t bytes, int width);
+
+/*
+ * =============================================================================
+ * Scalar
+ * =============================================================================
+ */
+
+static void swap_scalar(uint8_t *dest, const uint8_t *src, size_t bytes, int width)
+{
+    size_t i;
+
+    switch (width) {
+        case 2:
+            for (i = 0; i + 2 <= bytes; i += 2) {
+                uint16_t v;
+                memcpy(&v, src + i, 2);
+                v = __builtin_bswap16(v);
+                memcpy(dest + i, &v, 2);
+            }
+            break;
+        case 4:
+            for (i = 0; i + 4 <= bytes; i += 4) {
+                uint32_t v;
+                memcpy(&v, src + i, 4);
+                v = __builtin_bswap32(v);
+                memcpy(dest + i, &v, 4);
+            }
+            break;
+        case 8:
+            for (i = 0; i + 8 <= bytes; i += 8) {
+                uint64_t v;
+                memcpy(&v, src + i, 8);
+                v = __builtin_bswap64(v);
+                memcpy(dest + i, &v, 8);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * =============================================================================
+ * x86: SSSE3 and AVX2 pshufb
+ * =============================================================================
+ */
+
+#ifdef S7COMM_SWAP_X86
+
+__attribute__((target("ssse3")))
+static __m128i ssse3_mask(int width)
+{
+    switch (width) {
+        case 2:  return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        case 4:  return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        default: return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+}
+
+__attribute__((target("ssse3")))
+static void swap_ssse3(uint8_t *dest, const uint8_t *src, size_t bytes, int width)
+{
+    const __m128i mask = ssse3_mask(width);
+    size_t i = 0;
+
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_shuffle_epi8(v, mask));
+    }
+    swap_scalar(dest + i, src + i, bytes - i, width);
+}
+
+__attribute__((target("avx2")))
+static void swap_avx2(uint8_t *dest, const uint8_t *src, size_t bytes, int width)
+{
+    /* vpshufb shuffles within each 128-bit lane, the same mask serves both */
+    const __m256i mask = _mm256_broadcastsi128_si256(ssse3_mask(width));
+    size_t i = 0;
+
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_shuffle_epi8(v, mask));
+    }
+    swap_scalar(dest + i, src + i, bytes - i, width);
+}
+
+#endif /* S7COMM_SWAP_X86 */
+
+/*
+ * =============================================================================
+ * ARM: NEON vrev
+ * =============================================================================
+ */
+
+#ifdef S7COMM_SWAP_NEON
+
+static void swap_neon(uint8_t *dest, const uint8_t *src, size_t bytes, int width)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= bytes; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        switch (width) {
+            case 2:  v = vrev16q_u8(v); break;
+            case 4:  v = vrev32q_u8(v); break;
+            default: v = vrev64q_u8(v); break;
+        }
+        vst1q_u8(dest + i, v);
+    }
+    swap_scalar(dest + i, src + i, bytes - i, width);
+}
+
+#endif /* S7COMM_SWAP_NEON */
+
+/*
+ * =============================================================================
+ * Runtime Selection
+ * =============================================================================
+ */
+
+static swap_kernel_t g_kernel = swap_scalar;
+static const char *g_kernel_name = "scalar";
+
+/* Runs when the plugin is loaded, before any S7 client can connect */
+__attribute__((constructor))
+static void select_kernel(void)
+{
+#if defined(S7COMM_SWAP_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        g_kernel = swap_avx2;
+        g_kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("ssse3")) {
+        g_kernel = swap_ssse3;
+        g_kernel_name = "ssse3";
+    }
+#elif defined(S7COMM_SWAP_NEON)
+    /* Part of the baseline wherever the compiler enables it */
+    g_kernel = swap_neon;
+    g_kernel_name = "neon";
+#endif
+}
+
+void s7comm_swap16_copy(void *dest, const void *src, size_t count)
+{
+    g_kernel((uint8_t *)dest, (const uint8_t *)src, count * 2, 2);
+}
+
+void s7comm_swap32_copy(void *dest, const void *src, size_t count)
+{
+    g_kernel((uint8_t *)dest, (const uint8_t *)src, count * 4, 4);
+}
+
+void s7comm_swap64_copy(void *dest, const void *src, size_t count)
+{
+    g_kernel((uint8_t *)dest, (const uint8_t *)src, count * 8, 8);
+}
+
+const char *s7comm_byteswap_kernel(void)
+{
+    return g_kernel_name;
+}
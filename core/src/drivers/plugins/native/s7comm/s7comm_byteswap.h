@@ -0,0 +1,35 @@
+/**
+ * @file s7comm_byteswap.h
+ * @brief Bulk endian conversion between OpenPLC (host order) and S7 (big-endian)
+ *
+ * Each function copies count elements from src to dest reversing the bytes of
+ * every element. dest and src may be the same buffer (in-place conversion) but
+ * must not otherwise overlap; neither needs to be aligned.
+ *
+ * The kernel is chosen once at run time from what the CPU supports: AVX2 or
+ * SSSE3 on x86-64, NEON on ARM, a scalar loop everywhere else.
+ */
+
+#ifndef S7COMM_BYTESWAP_H
+#define S7COMM_BYTESWAP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void s7comm_swap16_copy(void *dest, const void *src, size_t count);
+void s7comm_swap32_copy(void *dest, const void *src, size_t count);
+void s7comm_swap64_copy(void *dest, const void *src, size_t count);
+
+/**
+ * @brief Name of the kernel in use ("avx2", "ssse3", "neon" or "scalar")
+ */
+const char *s7comm_byteswap_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* S7COMM_BYTESWAP_H */
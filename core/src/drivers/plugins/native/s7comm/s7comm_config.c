@@ -42,6 +42,30 @@ static const struct {
     {NULL, BUFFER_TYPE_NONE}
 };
 
+/* Event names of the logging section */
+static const struct {
+    const char *name;
+    uint32_t event;
+} event_map[] = {
+    {"server_started",      S7COMM_EVENT_SERVER_STARTED},
+    {"server_stopped",      S7COMM_EVENT_SERVER_STOPPED},
+    {"listener_failed",     S7COMM_EVENT_LISTENER_FAILED},
+    {"client_added",        S7COMM_EVENT_CLIENT_ADDED},
+    {"client_rejected",     S7COMM_EVENT_CLIENT_REJECTED},
+    {"client_no_room",      S7COMM_EVENT_CLIENT_NO_ROOM},
+    {"client_exception",    S7COMM_EVENT_CLIENT_EXCEPTION},
+    {"client_disconnected", S7COMM_EVENT_CLIENT_DISCONNECTED},
+    {"client_terminated",   S7COMM_EVENT_CLIENT_TERMINATED},
+    {"pdu_incoming",        S7COMM_EVENT_PDU_INCOMING},
+    {"data_read",           S7COMM_EVENT_DATA_READ},
+    {"data_write",          S7COMM_EVENT_DATA_WRITE},
+    {"negotiate_pdu",       S7COMM_EVENT_NEGOTIATE_PDU},
+    {"read_szl",            S7COMM_EVENT_READ_SZL},
+    {"clock",               S7COMM_EVENT_CLOCK},
+    {"control",             S7COMM_EVENT_CONTROL},
+    {NULL, 0}
+};
+
 /**
  * @brief Read entire file into a string
  */
@@ -176,6 +200,8 @@ static void parse_server_section(const cJSON *server, s7comm_config_t *config)
     config->port = (uint16_t)get_int(server, "port", S7COMM_DEFAULT_PORT);
     config->max_clients = get_int(server, "max_clients", S7COMM_DEFAULT_MAX_CLIENTS);
     config->work_interval_ms = get_int(server, "work_interval_ms", S7COMM_DEFAULT_WORK_INTERVAL);
+    config->io_threads = get_int(server, "io_threads", S7COMM_DEFAULT_IO_THREADS);
+    config->worker_pool = get_int(server, "worker_pool", S7COMM_DEFAULT_WORKER_POOL);
     config->send_timeout_ms = get_int(server, "send_timeout_ms", S7COMM_DEFAULT_SEND_TIMEOUT);
     config->recv_timeout_ms = get_int(server, "recv_timeout_ms", S7COMM_DEFAULT_RECV_TIMEOUT);
     config->ping_timeout_ms = get_int(server, "ping_timeout_ms", S7COMM_DEFAULT_PING_TIMEOUT);
@@ -299,18 +325,203 @@ static void parse_system_areas_section(const cJSON *system_areas, s7comm_config_
                       &config->mk_area);
 }
 
+/**
+ * @brief Get a TSAP from JSON: a number, or a string such as "0x1002"
+ *
+ * @return The TSAP, or -1 if it is not a valid 16-bit value
+ */
+static int get_tsap(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    long tsap = default_val;
+
+    if (cJSON_IsNumber(item)) {
+        tsap = item->valueint;
+    } else if (cJSON_IsString(item) && item->valuestring != NULL) {
+        char *end = NULL;
+        tsap = strtol(item->valuestring, &end, 0);
+        if (end == item->valuestring || *end != '\0') {
+            return -1;
+        }
+    } else if (item != NULL) {
+        return -1;
+    }
+    return (tsap >= 0 && tsap <= 0xFFFF) ? (int)tsap : -1;
+}
+
+/**
+ * @brief Parse a single partner block from JSON
+ */
+static int parse_partner_block(const cJSON *block_json, s7comm_partner_block_t *block)
+{
+    int r_id = get_int(block_json, "r_id", -1);
+    if (r_id < 0) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+    block->r_id = (uint32_t)r_id;
+
+    const char *direction = get_string(block_json, "direction", NULL);
+    if (direction != NULL && strcmp(direction, "send") == 0) {
+        block->send = true;
+    } else if (direction != NULL && strcmp(direction, "receive") == 0) {
+        block->send = false;
+    } else {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+
+    block->size_bytes = get_int(block_json, "size_bytes", 0);
+    block->refresh_ms = get_int(block_json, "refresh_ms", S7COMM_DEFAULT_REFRESH_MS);
+
+    const cJSON *mapping = cJSON_GetObjectItemCaseSensitive(block_json, "mapping");
+    if (mapping != NULL) {
+        parse_buffer_mapping(mapping, &block->mapping);
+    }
+
+    return S7COMM_CONFIG_OK;
+}
+
+/**
+ * @brief Parse a single partner connection from JSON
+ */
+static int parse_partner(const cJSON *partner_json, s7comm_partner_t *partner)
+{
+    if (partner_json == NULL || partner == NULL) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+
+    memset(partner, 0, sizeof(s7comm_partner_t));
+
+    const char *name = get_string(partner_json, "name", NULL);
+    const char *remote_address = get_string(partner_json, "remote_address", NULL);
+    if (name == NULL || remote_address == NULL) {
+        return S7COMM_CONFIG_ERR_MISSING;
+    }
+    safe_strcpy(partner->name, name, S7COMM_MAX_STRING_LEN);
+    safe_strcpy(partner->remote_address, remote_address, S7COMM_MAX_STRING_LEN);
+    safe_strcpy(partner->local_address, get_string(partner_json, "local_address", "0.0.0.0"),
+                S7COMM_MAX_STRING_LEN);
+
+    partner->enabled = get_bool(partner_json, "enabled", true);
+    partner->active = get_bool(partner_json, "active", true);
+    partner->send_timeout_ms = get_int(partner_json, "send_timeout_ms", S7COMM_DEFAULT_BLOCK_TIMEOUT);
+    partner->recv_timeout_ms = get_int(partner_json, "recv_timeout_ms", S7COMM_DEFAULT_BLOCK_TIMEOUT);
+    partner->recovery_time_ms = get_int(partner_json, "recovery_time_ms", S7COMM_DEFAULT_RECOVERY_TIME);
+
+    int local_tsap = get_tsap(partner_json, "local_tsap", S7COMM_DEFAULT_PARTNER_TSAP);
+    int remote_tsap = get_tsap(partner_json, "remote_tsap", S7COMM_DEFAULT_PARTNER_TSAP);
+    if (local_tsap < 0 || remote_tsap < 0) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+    partner->local_tsap = (uint16_t)local_tsap;
+    partner->remote_tsap = (uint16_t)remote_tsap;
+
+    const cJSON *blocks = cJSON_GetObjectItemCaseSensitive(partner_json, "blocks");
+    if (blocks != NULL && !cJSON_IsArray(blocks)) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+    const cJSON *block_json;
+    cJSON_ArrayForEach(block_json, blocks) {
+        if (partner->num_blocks >= S7COMM_MAX_PARTNER_BLOCKS) {
+            return S7COMM_CONFIG_ERR_INVALID;
+        }
+        int result = parse_partner_block(block_json, &partner->blocks[partner->num_blocks]);
+        if (result != S7COMM_CONFIG_OK) {
+            return result;
+        }
+        partner->num_blocks++;
+    }
+
+    return S7COMM_CONFIG_OK;
+}
+
+/**
+ * @brief Parse partners array from JSON
+ *
+ * Unlike a data block, a partner is not skipped when invalid: its peer would
+ * otherwise silently stop receiving the blocks it expects.
+ */
+static int parse_partners_section(const cJSON *partners, s7comm_config_t *config)
+{
+    config->num_partners = 0;
+    if (partners == NULL) {
+        return S7COMM_CONFIG_OK;
+    }
+    if (!cJSON_IsArray(partners) || cJSON_GetArraySize(partners) > S7COMM_MAX_PARTNERS) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+
+    const cJSON *partner_json;
+    cJSON_ArrayForEach(partner_json, partners) {
+        int result = parse_partner(partner_json, &config->partners[config->num_partners]);
+        if (result != S7COMM_CONFIG_OK) {
+            return result;
+        }
+        config->num_partners++;
+    }
+
+    return S7COMM_CONFIG_OK;
+}
+
+/**
+ * @brief Events the log_* flags stand for
+ */
+static uint32_t flag_events(const s7comm_logging_t *log_config)
+{
+    uint32_t events = 0;
+
+    if (log_config->log_connections) {
+        events |= S7COMM_EVENT_SERVER_STARTED | S7COMM_EVENT_SERVER_STOPPED |
+                  S7COMM_EVENT_CLIENT_ADDED | S7COMM_EVENT_CLIENT_DISCONNECTED |
+                  S7COMM_EVENT_CLIENT_REJECTED;
+    }
+    if (log_config->log_errors) {
+        events |= S7COMM_EVENT_LISTENER_FAILED | S7COMM_EVENT_CLIENT_EXCEPTION;
+    }
+    if (log_config->log_data_access) {
+        events |= S7COMM_EVENT_DATA_READ | S7COMM_EVENT_DATA_WRITE;
+    }
+    return events;
+}
+
 /**
  * @brief Parse logging section from JSON
+ *
+ * @return 0 on success, S7COMM_CONFIG_ERR_INVALID for an unknown event name
  */
-static void parse_logging_section(const cJSON *logging, s7comm_logging_t *log_config)
+static int parse_logging_section(const cJSON *logging, s7comm_logging_t *log_config)
 {
     if (logging == NULL) {
-        return;
+        return S7COMM_CONFIG_OK;
     }
 
     log_config->log_connections = get_bool(logging, "log_connections", true);
     log_config->log_data_access = get_bool(logging, "log_data_access", false);
     log_config->log_errors = get_bool(logging, "log_errors", true);
+    log_config->client_metrics = get_bool(logging, "client_metrics", true);
+    log_config->events = flag_events(log_config);
+
+    /* An explicit event list replaces the flags */
+    const cJSON *events = cJSON_GetObjectItemCaseSensitive(logging, "events");
+    if (events == NULL) {
+        return S7COMM_CONFIG_OK;
+    }
+    if (!cJSON_IsArray(events)) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+    log_config->events = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, events) {
+        int i = 0;
+        while (event_map[i].name != NULL &&
+               !(cJSON_IsString(item) && strcmp(item->valuestring, event_map[i].name) == 0)) {
+            i++;
+        }
+        if (event_map[i].name == NULL) {
+            return S7COMM_CONFIG_ERR_INVALID;
+        }
+        log_config->events |= event_map[i].event;
+    }
+    return S7COMM_CONFIG_OK;
 }
 
 void s7comm_config_init_defaults(s7comm_config_t *config)
@@ -327,6 +538,8 @@ void s7comm_config_init_defaults(s7comm_config_t *config)
     config->port = S7COMM_DEFAULT_PORT;
     config->max_clients = S7COMM_DEFAULT_MAX_CLIENTS;
     config->work_interval_ms = S7COMM_DEFAULT_WORK_INTERVAL;
+    config->io_threads = S7COMM_DEFAULT_IO_THREADS;
+    config->worker_pool = S7COMM_DEFAULT_WORKER_POOL;
     config->send_timeout_ms = S7COMM_DEFAULT_SEND_TIMEOUT;
     config->recv_timeout_ms = S7COMM_DEFAULT_RECV_TIMEOUT;
     config->ping_timeout_ms = S7COMM_DEFAULT_PING_TIMEOUT;
@@ -343,6 +556,8 @@ void s7comm_config_init_defaults(s7comm_config_t *config)
     config->logging.log_connections = true;
     config->logging.log_data_access = false;
     config->logging.log_errors = true;
+    config->logging.client_metrics = true;
+    config->logging.events = flag_events(&config->logging);
 }
 
 int s7comm_config_parse(const char *config_path, s7comm_config_t *config)
@@ -373,9 +588,16 @@ int s7comm_config_parse(const char *config_path, s7comm_config_t *config)
     parse_identity_section(cJSON_GetObjectItemCaseSensitive(root, "plc_identity"), &config->identity);
     parse_data_blocks_section(cJSON_GetObjectItemCaseSensitive(root, "data_blocks"), config);
     parse_system_areas_section(cJSON_GetObjectItemCaseSensitive(root, "system_areas"), config);
-    parse_logging_section(cJSON_GetObjectItemCaseSensitive(root, "logging"), &config->logging);
+    int result = parse_partners_section(cJSON_GetObjectItemCaseSensitive(root, "partners"), config);
+    if (result == S7COMM_CONFIG_OK) {
+        result = parse_logging_section(cJSON_GetObjectItemCaseSensitive(root, "logging"),
+                                       &config->logging);
+    }
 
     cJSON_Delete(root);
+    if (result != S7COMM_CONFIG_OK) {
+        return result;
+    }
 
     /* Validate the parsed configuration */
     return s7comm_config_validate(config);
@@ -407,6 +629,16 @@ int s7comm_config_validate(const s7comm_config_t *config)
         return S7COMM_CONFIG_ERR_INVALID;
     }
 
+    /* Validate io_threads (0 selects one thread per client) */
+    if (config->io_threads < 0 || config->io_threads > S7COMM_MAX_IO_THREADS) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+
+    /* Validate worker_pool (0 frees every worker with its connection) */
+    if (config->worker_pool < 0 || config->worker_pool > S7COMM_MAX_WORKER_POOL) {
+        return S7COMM_CONFIG_ERR_INVALID;
+    }
+
     /* Check for duplicate DB numbers */
     for (int i = 0; i < config->num_data_blocks; i++) {
         for (int j = i + 1; j < config->num_data_blocks; j++) {
@@ -433,6 +665,34 @@ int s7comm_config_validate(const s7comm_config_t *config)
         }
     }
 
+    /* Validate partners and their blocks */
+    for (int i = 0; i < config->num_partners; i++) {
+        const s7comm_partner_t *partner = &config->partners[i];
+
+        if (partner->send_timeout_ms < 100 || partner->recv_timeout_ms < 100 ||
+            partner->recovery_time_ms < 0) {
+            return S7COMM_CONFIG_ERR_INVALID;
+        }
+
+        for (int j = 0; j < partner->num_blocks; j++) {
+            const s7comm_partner_block_t *block = &partner->blocks[j];
+
+            if (block->size_bytes <= 0 || block->size_bytes > S7COMM_MAX_BLOCK_SIZE ||
+                block->mapping.type == BUFFER_TYPE_NONE || block->mapping.start_buffer < 0 ||
+                block->refresh_ms < 0) {
+                return S7COMM_CONFIG_ERR_INVALID;
+            }
+
+            /* A received block is told apart by its R_ID only */
+            for (int k = j + 1; k < partner->num_blocks; k++) {
+                if (partner->blocks[k].r_id == block->r_id &&
+                    partner->blocks[k].send == block->send) {
+                    return S7COMM_CONFIG_ERR_INVALID;
+                }
+            }
+        }
+    }
+
     return S7COMM_CONFIG_OK;
 }
 
@@ -17,18 +17,29 @@ extern "C" {
 #endif
 
 /* Configuration limits */
-#define S7COMM_MAX_DATA_BLOCKS     64
+#define S7COMM_MAX_DATA_BLOCKS     512
 #define S7COMM_MAX_STRING_LEN      64
 #define S7COMM_MAX_DESCRIPTION_LEN 128
+#define S7COMM_MAX_PARTNERS        16
+#define S7COMM_MAX_PARTNER_BLOCKS  16      /* Sent and received, per partner */
+#define S7COMM_MAX_BLOCK_SIZE      65535   /* Largest BSend / BRecv block */
 
 /* Default values */
 #define S7COMM_DEFAULT_PORT           102
 #define S7COMM_DEFAULT_MAX_CLIENTS    32
 #define S7COMM_DEFAULT_WORK_INTERVAL  100
+#define S7COMM_DEFAULT_IO_THREADS     2
+#define S7COMM_MAX_IO_THREADS         16
+#define S7COMM_DEFAULT_WORKER_POOL    8
+#define S7COMM_MAX_WORKER_POOL        64
 #define S7COMM_DEFAULT_SEND_TIMEOUT   3000
 #define S7COMM_DEFAULT_RECV_TIMEOUT   3000
 #define S7COMM_DEFAULT_PING_TIMEOUT   10000
-#define S7COMM_DEFAULT_PDU_SIZE       480
+#define S7COMM_DEFAULT_PDU_SIZE       960
+#define S7COMM_DEFAULT_PARTNER_TSAP   0x1002
+#define S7COMM_DEFAULT_BLOCK_TIMEOUT  3000
+#define S7COMM_DEFAULT_RECOVERY_TIME  500
+#define S7COMM_DEFAULT_REFRESH_MS     1000
 
 /**
  * @brief Buffer type enumeration for mapping S7 areas to OpenPLC buffers
@@ -90,6 +101,56 @@ typedef struct {
     char module_name[S7COMM_MAX_STRING_LEN];    /* Module name */
 } s7comm_plc_identity_t;
 
+/**
+ * @brief Block exchanged with a partner (BSend / BRecv)
+ */
+typedef struct {
+    uint32_t r_id;                      /* Block ID, matches the R_ID of the peer's BRCV / BSEND */
+    bool send;                          /* Pushed to the partner, else received from it */
+    int size_bytes;                     /* Block size in bytes */
+    s7comm_buffer_mapping_t mapping;    /* Buffer mapping */
+    int refresh_ms;                     /* Send blocks: resent unchanged after this, 0 = on change only */
+} s7comm_partner_block_t;
+
+/**
+ * @brief Partner connection configuration (S7 peer-to-peer, BSEND/BRCV)
+ */
+typedef struct {
+    char name[S7COMM_MAX_STRING_LEN];           /* Partner name, used in log messages */
+    bool enabled;                               /* Enable this partner */
+    bool active;                                /* Connect to the peer, else wait for it */
+    char local_address[S7COMM_MAX_STRING_LEN];  /* Local interface (passive: listens on port 102) */
+    char remote_address[S7COMM_MAX_STRING_LEN]; /* Peer address */
+    uint16_t local_tsap;                        /* Local TSAP */
+    uint16_t remote_tsap;                       /* Peer TSAP */
+    int send_timeout_ms;                        /* Completion timeout of a block send */
+    int recv_timeout_ms;                        /* Timeout between the frames of a received block */
+    int recovery_time_ms;                       /* Delay between connection attempts */
+    int num_blocks;
+    s7comm_partner_block_t blocks[S7COMM_MAX_PARTNER_BLOCKS];
+} s7comm_partner_t;
+
+/*
+ * Server events that can be logged ("events" in the logging section). The
+ * values are Snap7's evc* event codes, so a set of them is a Snap7 event mask.
+ */
+#define S7COMM_EVENT_SERVER_STARTED      0x00000001u
+#define S7COMM_EVENT_SERVER_STOPPED      0x00000002u
+#define S7COMM_EVENT_LISTENER_FAILED     0x00000004u
+#define S7COMM_EVENT_CLIENT_ADDED        0x00000008u
+#define S7COMM_EVENT_CLIENT_REJECTED     0x00000010u
+#define S7COMM_EVENT_CLIENT_NO_ROOM      0x00000020u
+#define S7COMM_EVENT_CLIENT_EXCEPTION    0x00000040u
+#define S7COMM_EVENT_CLIENT_DISCONNECTED 0x00000080u
+#define S7COMM_EVENT_CLIENT_TERMINATED   0x00000100u
+#define S7COMM_EVENT_PDU_INCOMING        0x00010000u
+#define S7COMM_EVENT_DATA_READ           0x00020000u
+#define S7COMM_EVENT_DATA_WRITE          0x00040000u
+#define S7COMM_EVENT_NEGOTIATE_PDU       0x00080000u
+#define S7COMM_EVENT_READ_SZL            0x00100000u
+#define S7COMM_EVENT_CLOCK               0x00200000u
+#define S7COMM_EVENT_CONTROL             0x04000000u
+
 /**
  * @brief Logging configuration
  */
@@ -97,6 +158,8 @@ typedef struct {
     bool log_connections;   /* Log client connect/disconnect */
     bool log_data_access;   /* Log read/write operations */
     bool log_errors;        /* Log errors and warnings */
+    uint32_t events;        /* S7COMM_EVENT_* logged, from the flags above unless listed */
+    bool client_metrics;    /* Per-client request counters on the metrics endpoint */
 } s7comm_logging_t;
 
 /**
@@ -109,6 +172,8 @@ typedef struct {
     uint16_t port;                                  /* S7Comm TCP port */
     int max_clients;                                /* Maximum simultaneous connections */
     int work_interval_ms;                           /* Worker thread polling interval */
+    int io_threads;                                 /* I/O thread pool size, 0 = thread per client */
+    int worker_pool;                                /* Idle workers kept for new connections */
     int send_timeout_ms;                            /* Socket send timeout */
     int recv_timeout_ms;                            /* Socket receive timeout */
     int ping_timeout_ms;                            /* Keep-alive timeout */
@@ -126,6 +191,10 @@ typedef struct {
     s7comm_system_area_t pa_area;   /* Process outputs (Q area) */
     s7comm_system_area_t mk_area;   /* Markers (M area) */
 
+    /* Partner connections */
+    int num_partners;
+    s7comm_partner_t partners[S7COMM_MAX_PARTNERS];
+
     /* Logging */
     s7comm_logging_t logging;
 } s7comm_config_t;
@@ -9,18 +9,33 @@
  * - S7 buffers: What Snap7 clients read/write (managed by Snap7 server)
  * - Journal writes: Race-condition-free writes to OpenPLC buffers
  *
- * Data flow (on-demand via Snap7 RWArea callback):
- * - S7 client READ: Callback acquires OpenPLC mutex, copies fresh data to S7 buffer
+ * Data flow (via Snap7 RWArea callback):
+ * - S7 client READ: Callback copies the area's per-scan read cache, which
+ *   cycle_end rebuilds in S7 layout for every area read recently (falls back
+ *   to the runtime's lock-free snapshot, then to the OpenPLC mutex)
  * - S7 client WRITE: Callback uses journal writes (thread-safe, no mutex needed)
+ * - Multi-item ReadVar/WriteVar: one RWAreas callback for all the items, so a
+ *   read returns every item from the same scan
  *
- * This approach allows the S7 server thread to run independently without
- * requiring cycle_start/cycle_end hooks for data synchronization.
+ * The S7 server threads never wait for the scan: the only work done in the
+ * scan thread is one conversion per scan of each area clients are polling.
+ *
+ * Partner connections (S7 peer-to-peer, BSEND/BRCV):
+ * - Send blocks: cycle_end converts each block and queues it with an
+ *   asynchronous BSend when it changed (or its refresh interval expired);
+ *   the partner's worker thread transmits it
+ * - Received blocks: the partner's BRecv callback journals them, so they
+ *   reach the image tables at the start of the next scan
  */
 
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <atomic>
+#include <arpa/inet.h>
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 /* Snap7 includes */
 #include "snap7_libmain.h"
@@ -33,6 +48,7 @@ extern "C" {
 #include "plugin_types.h"
 #include "s7comm_plugin.h"
 #include "s7comm_config.h"
+#include "s7comm_byteswap.h"
 }
 
 /*
@@ -42,6 +58,70 @@ extern "C" {
  */
 #define S7COMM_MAX_DB_SIZE  65536   /* Maximum size for a single DB buffer */
 
+/* An area no client read for this many scans is no longer refreshed */
+#define S7COMM_CACHE_IDLE_SCANS     1000
+/* Attempts to copy a cache the scan thread keeps rewriting before falling back */
+#define S7COMM_CACHE_READ_RETRIES   4
+
+/* DB number -> g_db_runtime slot, open addressing, at most half full */
+#define S7COMM_DB_HASH_BITS         10
+#define S7COMM_DB_HASH_SIZE         (1 << S7COMM_DB_HASH_BITS)
+#if S7COMM_DB_HASH_SIZE < 2 * S7COMM_MAX_DATA_BLOCKS
+#error "S7COMM_DB_HASH_BITS too small for S7COMM_MAX_DATA_BLOCKS"
+#endif
+
+/* Client addresses with counters of their own, later ones share the "other" slot */
+#define S7COMM_CLIENT_SLOTS         8
+
+/* Events the plugin always needs, for the connection and error counters */
+#define S7COMM_COUNTED_EVENTS       (evcClientAdded | evcClientDisconnected | evcClientTerminated | \
+                                     evcClientException | evcClientRejected)
+
+static_assert(S7COMM_EVENT_CLIENT_ADDED == evcClientAdded &&
+              S7COMM_EVENT_CLIENT_DISCONNECTED == evcClientDisconnected &&
+              S7COMM_EVENT_DATA_READ == evcDataRead && S7COMM_EVENT_CONTROL == evcControl,
+              "S7COMM_EVENT_* must be the Snap7 event codes");
+
+/*
+ * =============================================================================
+ * Per-scan Read Cache
+ * The area's s7_buffer holds its S7-layout (big-endian) image, rebuilt in
+ * cycle_end with the OpenPLC mutex held. Readers copy it without locking and
+ * check seq, which is odd while the scan thread rewrites the buffer.
+ * =============================================================================
+ */
+typedef struct {
+    std::atomic<unsigned> seq;
+    std::atomic<unsigned> built;        /* Scan that last rebuilt the buffer */
+    std::atomic<unsigned> last_read;    /* Scan during which a client last read it */
+} s7comm_read_cache_t;
+
+/*
+ * =============================================================================
+ * Per-client Counters
+ * One slot per client address (Snap7 reports clients by IPv4 address, so all
+ * connections of a host share it). Slots are claimed in order by the event
+ * callback, which Snap7 serializes, and published by storing the address last;
+ * the request callbacks only do relaxed atomic adds, never lock or log.
+ * =============================================================================
+ */
+typedef struct {
+    std::atomic<uint32_t> address;          /* Client address, 0 while the slot is free */
+    std::atomic<int> connections;
+    std::atomic<uint64_t> requests;
+    std::atomic<uint64_t> bytes;            /* Read and written */
+    std::atomic<uint64_t> errors;           /* Unmapped items, rejected requests, exceptions */
+    std::atomic<uint64_t> service_ns;       /* Total time in the read/write callbacks */
+    std::atomic<uint64_t> service_max_ns;
+    char name[INET_ADDRSTRLEN];
+    int metric_connections;
+    int metric_requests;
+    int metric_bytes;
+    int metric_errors;
+    int metric_service;
+    int metric_service_max;
+} s7comm_client_stats_t;
+
 /*
  * =============================================================================
  * Data Block Runtime Structure
@@ -53,7 +133,9 @@ typedef struct {
     int start_buffer;               /* Starting buffer index */
     int size_bytes;                 /* Size in bytes */
     bool bit_addressing;            /* Bit-level access enabled */
-    uint8_t *s7_buffer;             /* S7 buffer (registered with Snap7) */
+    int type_shift;                 /* log2 of the element size of type */
+    uint8_t *s7_buffer;             /* S7 buffer (registered with Snap7), per-scan read cache */
+    s7comm_read_cache_t *cache;     /* Read cache state of s7_buffer */
 } s7comm_db_runtime_t;
 
 /*
@@ -66,9 +148,35 @@ typedef struct {
     int size_bytes;
     s7comm_buffer_type_t type;
     int start_buffer;
-    uint8_t *s7_buffer;             /* S7 buffer (registered with Snap7) */
+    int type_shift;                 /* log2 of the element size of type */
+    uint8_t *s7_buffer;             /* S7 buffer (registered with Snap7), per-scan read cache */
+    s7comm_read_cache_t *cache;     /* Read cache state of s7_buffer */
 } s7comm_area_runtime_t;
 
+/*
+ * =============================================================================
+ * Partner Runtime Structures
+ * Blocks and the pending send are only touched by the scan thread (cycle_end)
+ * and the lifecycle functions; the BRecv callback only reads the config.
+ * =============================================================================
+ */
+typedef struct {
+    const s7comm_partner_block_t *config;
+    uint8_t *s7_buffer;             /* Send blocks: S7-layout image last queued */
+    bool sent;                      /* Send blocks: s7_buffer reached the peer or is on its way */
+    uint64_t sent_ns;               /* Send blocks: when s7_buffer was queued */
+} s7comm_partner_block_runtime_t;
+
+typedef struct {
+    const s7comm_partner_t *config;
+    S7Object partner;               /* Snap7 partner handle, 0 if not created */
+    s7comm_partner_block_runtime_t blocks[S7COMM_MAX_PARTNER_BLOCKS];
+    uint8_t *scratch;               /* Conversion buffer, size of the largest send block */
+    int sending;                    /* Block of the pending AsBSend, -1 if none */
+    int next_send;                  /* First block checked next scan, so all get their turn */
+    bool linked;                    /* Link state last logged */
+} s7comm_partner_runtime_t;
+
 /*
  * =============================================================================
  * Plugin State
@@ -84,17 +192,48 @@ static bool g_config_loaded = false;
 /* Snap7 server handle (S7Object is uintptr_t, use 0 for null) */
 static S7Object g_server = 0;
 
-/* No S7 buffer mutex needed - reads use OpenPLC mutex, writes use journal */
+/* No S7 buffer mutex needed - reads use the read cache, writes use journal */
 
 /* Runtime data blocks (dynamically allocated based on config) */
 static s7comm_db_runtime_t g_db_runtime[S7COMM_MAX_DATA_BLOCKS];
 static int g_num_db_runtime = 0;
 
+/* 1 + slot of each registered DB in g_db_runtime, 0 for an empty bucket */
+static uint16_t g_db_hash[S7COMM_DB_HASH_SIZE];
+
 /* System area runtime */
 static s7comm_area_runtime_t g_pe_runtime;
 static s7comm_area_runtime_t g_pa_runtime;
 static s7comm_area_runtime_t g_mk_runtime;
 
+/* Read cache state, one per runtime entry above */
+static s7comm_read_cache_t g_db_cache[S7COMM_MAX_DATA_BLOCKS];
+static s7comm_read_cache_t g_pe_cache;
+static s7comm_read_cache_t g_pa_cache;
+static s7comm_read_cache_t g_mk_cache;
+
+/* Scans completed since the plugin was loaded, published at the end of cycle_end */
+static std::atomic<unsigned> g_scan_count(0);
+
+/* Handles of the metrics registered with the runtime, -1 if not registered */
+static int g_metric_connections = -1;
+static int g_metric_rejected = -1;
+static int g_metric_read_requests = -1;
+static int g_metric_write_requests = -1;
+static int g_metric_read_bytes = -1;
+static int g_metric_write_bytes = -1;
+
+/* Client counters, the last slot for every address past S7COMM_CLIENT_SLOTS */
+static s7comm_client_stats_t g_clients[S7COMM_CLIENT_SLOTS + 1];
+static int g_num_clients = 0;           /* Claimed slots, event callback only */
+
+/* Events logged, S7COMM_EVENT_* (Snap7 evc* codes) */
+static longword g_log_events = 0;
+
+/* Partner connections, one per enabled partner of the config */
+static s7comm_partner_runtime_t g_partner_runtime[S7COMM_MAX_PARTNERS];
+static int g_num_partner_runtime = 0;
+
 /*
  * =============================================================================
  * Forward Declarations
@@ -110,6 +249,33 @@ static void write_buffer_to_openplc_journal(uint8_t *src, int size, s7comm_buffe
 static s7comm_db_runtime_t* find_db_runtime(int db_number);
 static s7comm_area_runtime_t* find_area_runtime(int area);
 static int get_type_size(s7comm_buffer_type_t type);
+static int get_type_shift(s7comm_buffer_type_t type);
+static void build_db_hash(void);
+static void clear_db_hash(void);
+static void reset_read_cache(s7comm_read_cache_t *cache);
+static void refresh_read_cache(s7comm_read_cache_t *cache, uint8_t *buffer, int size,
+                               s7comm_buffer_type_t type, int start_buffer, unsigned scan);
+static bool read_cache_to_buffer(s7comm_read_cache_t *cache, const uint8_t *buffer, int area_size,
+                                 int offset, int size, uint8_t *dest, unsigned *built_scan);
+static int s7comm_rw_areas_callback(void *usrPtr, int Sender, int Operation, int ItemsCount,
+                                    PS7Tag PTags, void **pUsrData);
+static void register_metrics(void);
+static void metric_add(int handle, long long delta);
+static void count_request(int operation, int bytes);
+static void reset_client_stats(void);
+static s7comm_client_stats_t *claim_client_stats(uint32_t address);
+static s7comm_client_stats_t *find_client_stats(uint32_t address);
+static void client_connected(int sender);
+static void client_closed(int sender, bool error, const char *how);
+static uint64_t service_clock_ns(void);
+static void count_client_request(int sender, int bytes, int errors, uint64_t start_ns);
+static int create_partners(void);
+static void destroy_partners(void);
+static void start_partners(void);
+static void stop_partners(void);
+static void send_partner_blocks(void);
+static void S7API s7comm_partner_recv_callback(void *usrPtr, int opResult, longword R_ID,
+                                               void *pdata, int Size);
 
 /*
  * =============================================================================
@@ -151,7 +317,8 @@ static inline uint64_t swap64(uint64_t val)
 /**
  * @brief Allocate a system area buffer
  */
-static int allocate_area(s7comm_area_runtime_t *area, const s7comm_system_area_t *config)
+static int allocate_area(s7comm_area_runtime_t *area, const s7comm_system_area_t *config,
+                         s7comm_read_cache_t *cache)
 {
     memset(area, 0, sizeof(s7comm_area_runtime_t));
 
@@ -164,12 +331,15 @@ static int allocate_area(s7comm_area_runtime_t *area, const s7comm_system_area_t
     area->size_bytes = config->size_bytes;
     area->type = config->mapping.type;
     area->start_buffer = config->mapping.start_buffer;
+    area->type_shift = get_type_shift(area->type);
 
     /* Allocate S7 buffer (what Snap7 clients see) */
     area->s7_buffer = (uint8_t *)calloc(1, config->size_bytes);
     if (area->s7_buffer == NULL) {
         return -1;
     }
+    area->cache = cache;
+    reset_read_cache(cache);
 
     return 0;
 }
@@ -194,17 +364,17 @@ static int allocate_buffers(void)
     g_num_db_runtime = 0;
 
     /* Allocate system areas */
-    if (allocate_area(&g_pe_runtime, &g_config.pe_area) != 0) {
+    if (allocate_area(&g_pe_runtime, &g_config.pe_area, &g_pe_cache) != 0) {
         plugin_logger_error(&g_logger, "Failed to allocate PE area buffer");
         return -1;
     }
 
-    if (allocate_area(&g_pa_runtime, &g_config.pa_area) != 0) {
+    if (allocate_area(&g_pa_runtime, &g_config.pa_area, &g_pa_cache) != 0) {
         plugin_logger_error(&g_logger, "Failed to allocate PA area buffer");
         return -1;
     }
 
-    if (allocate_area(&g_mk_runtime, &g_config.mk_area) != 0) {
+    if (allocate_area(&g_mk_runtime, &g_config.mk_area, &g_mk_cache) != 0) {
         plugin_logger_error(&g_logger, "Failed to allocate MK area buffer");
         return -1;
     }
@@ -225,6 +395,7 @@ static int allocate_buffers(void)
         db_rt->start_buffer = db_cfg->mapping.start_buffer;
         db_rt->size_bytes = db_cfg->size_bytes;
         db_rt->bit_addressing = db_cfg->mapping.bit_addressing;
+        db_rt->type_shift = get_type_shift(db_rt->type);
 
         /* Allocate S7 buffer */
         db_rt->s7_buffer = (uint8_t *)calloc(1, db_cfg->size_bytes);
@@ -232,6 +403,8 @@ static int allocate_buffers(void)
             plugin_logger_error(&g_logger, "Failed to allocate DB%d S7 buffer", db_cfg->db_number);
             return -1;
         }
+        db_rt->cache = &g_db_cache[g_num_db_runtime];
+        reset_read_cache(db_rt->cache);
 
         g_num_db_runtime++;
         plugin_logger_debug(&g_logger, "Allocated DB%d: %d bytes, type=%s",
@@ -260,6 +433,7 @@ static void free_buffers(void)
         }
     }
     g_num_db_runtime = 0;
+    clear_db_hash();
 }
 
 /**
@@ -298,6 +472,7 @@ static int register_all_areas(void)
     }
 
     /* Register data blocks (using S7 buffers) */
+    build_db_hash();
     for (int i = 0; i < g_num_db_runtime; i++) {
         s7comm_db_runtime_t *db = &g_db_runtime[i];
         result = Srv_RegisterArea(g_server, srvAreaDB, db->db_number, db->s7_buffer, db->size_bytes);
@@ -317,6 +492,30 @@ static int register_all_areas(void)
  * =============================================================================
  */
 
+extern "C" const plugin_declaration_t plugin_declaration = {
+    sizeof(plugin_declaration_t),
+    PLUGIN_ABI_VERSION,
+    PLUGIN_HOOK_START_LOOP | PLUGIN_HOOK_STOP_LOOP | PLUGIN_HOOK_CYCLE_END | PLUGIN_HOOK_CLEANUP,
+    PLUGIN_CAP_JOURNAL_RANGE, /* The image reads fall back to the pointer tables */
+};
+
+/**
+ * @brief Initialize the S7Comm plugin (ABI version 2)
+ */
+extern "C" int plugin_init(const plugin_abi_t *abi)
+{
+    if (!abi || !abi->args) {
+        return -1;
+    }
+
+    /* Members the runtime does not have stay NULL */
+    plugin_runtime_args_t args;
+    memset(&args, 0, sizeof(args));
+    size_t size = abi->args_size < sizeof(args) ? abi->args_size : sizeof(args);
+    memcpy(&args, abi->args, size);
+    return init(&args);
+}
+
 /**
  * @brief Initialize the S7Comm plugin
  */
@@ -365,10 +564,14 @@ extern "C" int init(void *args)
     }
 
     /* Log configuration summary */
-    plugin_logger_info(&g_logger, "Server config: port=%d, max_clients=%d, pdu_size=%d",
-                       g_config.port, g_config.max_clients, g_config.pdu_size);
+    plugin_logger_info(&g_logger,
+                       "Server config: port=%d, max_clients=%d, pdu_size=%d, io_threads=%d, "
+                       "worker_pool=%d",
+                       g_config.port, g_config.max_clients, g_config.pdu_size, g_config.io_threads,
+                       g_config.worker_pool);
     plugin_logger_info(&g_logger, "PLC identity: %s (%s)", g_config.identity.name, g_config.identity.module_type);
     plugin_logger_info(&g_logger, "Data blocks configured: %d", g_config.num_data_blocks);
+    plugin_logger_debug(&g_logger, "Endian conversion kernel: %s", s7comm_byteswap_kernel());
 
     /* Allocate S7 buffers */
     if (allocate_buffers() != 0) {
@@ -389,6 +592,8 @@ extern "C" int init(void *args)
     uint16_t port = g_config.port;
     int max_clients = g_config.max_clients;
     int work_interval = g_config.work_interval_ms;
+    int io_threads = g_config.io_threads;
+    int worker_pool = g_config.worker_pool;
     int send_timeout = g_config.send_timeout_ms;
     int recv_timeout = g_config.recv_timeout_ms;
     int ping_timeout = g_config.ping_timeout_ms;
@@ -397,34 +602,46 @@ extern "C" int init(void *args)
     Srv_SetParam(g_server, p_u16_LocalPort, &port);
     Srv_SetParam(g_server, p_i32_MaxClients, &max_clients);
     Srv_SetParam(g_server, p_i32_WorkInterval, &work_interval);
+    Srv_SetParam(g_server, p_i32_IoThreads, &io_threads);
+    Srv_SetParam(g_server, p_i32_WorkerPool, &worker_pool);
     Srv_SetParam(g_server, p_i32_SendTimeout, &send_timeout);
     Srv_SetParam(g_server, p_i32_RecvTimeout, &recv_timeout);
     Srv_SetParam(g_server, p_i32_PingTimeout, &ping_timeout);
     Srv_SetParam(g_server, p_i32_PDURequest, &pdu_size);
 
-    /* Set event mask based on logging configuration */
-    longword event_mask = 0;
-    if (g_config.logging.log_connections) {
-        event_mask |= evcServerStarted | evcServerStopped |
-                      evcClientAdded | evcClientDisconnected | evcClientRejected;
-    }
-    if (g_config.logging.log_errors) {
-        event_mask |= evcListenerCannotStart | evcClientException;
-    }
-    if (g_config.logging.log_data_access) {
-        event_mask |= evcDataRead | evcDataWrite;
-    }
-    Srv_SetMask(g_server, mkEvent, event_mask);
+    register_metrics();
+    reset_client_stats();
+
+    /*
+     * Only the events logged reach the callback, plus the client events the
+     * counters need. Snap7 calls it under a server-wide lock, so per-request
+     * events (data_read, data_write, pdu_incoming) are best left out on busy
+     * servers; the counters cover them.
+     */
+    g_log_events = g_config.logging.events;
+    Srv_SetMask(g_server, mkEvent, g_log_events | S7COMM_COUNTED_EVENTS);
+    plugin_logger_debug(&g_logger, "Logged events: 0x%08X", (unsigned)g_log_events);
 
     /* Set event callback for logging */
     Srv_SetEventsCallback(g_server, s7comm_event_callback, NULL);
 
     /* Set RWArea callback for on-demand data synchronization */
     Srv_SetRWAreaCallback(g_server, s7comm_rw_area_callback, NULL);
+    Srv_SetRWAreasCallback(g_server, s7comm_rw_areas_callback, NULL);
 
     /* Register all S7 areas with the server */
     register_all_areas();
 
+    /* Create the partner connections (started with the server) */
+    if (create_partners() != 0) {
+        plugin_logger_error(&g_logger, "Failed to create partner connections");
+        destroy_partners();
+        Srv_Destroy(g_server);
+        g_server = 0;
+        free_buffers();
+        return -1;
+    }
+
     g_initialized = true;
     plugin_logger_info(&g_logger, "S7Comm plugin initialized successfully (journal-buffered mode)");
 
@@ -454,6 +671,13 @@ extern "C" int init(void *args)
                           s7comm_buffer_type_name(g_db_runtime[i].type),
                           g_db_runtime[i].start_buffer);
     }
+    for (int i = 0; i < g_num_partner_runtime; i++) {
+        const s7comm_partner_t *partner = g_partner_runtime[i].config;
+        plugin_logger_info(&g_logger, "Partner %s: %s %s, TSAP %04X -> %04X, %d blocks",
+                          partner->name, partner->active ? "active to" : "passive for",
+                          partner->remote_address, partner->local_tsap, partner->remote_tsap,
+                          partner->num_blocks);
+    }
 
     return 0;
 }
@@ -499,6 +723,8 @@ extern "C" void start_loop(void)
 
     g_running = true;
     plugin_logger_info(&g_logger, "S7 server started successfully");
+
+    start_partners();
 }
 
 /**
@@ -513,6 +739,7 @@ extern "C" void stop_loop(void)
 
     plugin_logger_info(&g_logger, "Stopping S7 server...");
 
+    stop_partners();
     Srv_Stop(g_server);
     g_running = false;
 
@@ -530,6 +757,8 @@ extern "C" void cleanup(void)
         stop_loop();
     }
 
+    destroy_partners();
+
     if (g_server != 0) {
         Srv_Destroy(g_server);
         g_server = 0;
@@ -556,12 +785,35 @@ extern "C" void cycle_start(void)
 /**
  * @brief Called at the end of each PLC scan cycle
  *
- * With the journal-based approach, data synchronization happens on-demand
- * via the RWArea callback. No action needed here.
+ * Runs with the OpenPLC mutex held, after the runtime refreshed its shadow
+ * areas: rebuilds the read cache of every area a client read recently, so
+ * any number of clients polling it cost one conversion per scan, and queues
+ * the partner blocks that changed.
  */
 extern "C" void cycle_end(void)
 {
-    /* Data sync is handled on-demand via RWArea callback */
+    if (!g_running) {
+        return;
+    }
+
+    unsigned scan = g_scan_count.load(std::memory_order_relaxed) + 1;
+
+    s7comm_area_runtime_t *areas[] = {&g_pe_runtime, &g_pa_runtime, &g_mk_runtime};
+    for (s7comm_area_runtime_t *area : areas) {
+        if (area->enabled) {
+            refresh_read_cache(area->cache, area->s7_buffer, area->size_bytes, area->type,
+                               area->start_buffer, scan);
+        }
+    }
+    for (int i = 0; i < g_num_db_runtime; i++) {
+        s7comm_db_runtime_t *db = &g_db_runtime[i];
+        refresh_read_cache(db->cache, db->s7_buffer, db->size_bytes, db->type,
+                           db->start_buffer, scan);
+    }
+
+    send_partner_blocks();
+
+    g_scan_count.store(scan, std::memory_order_release);
 }
 
 /*
@@ -571,54 +823,345 @@ extern "C" void cycle_end(void)
  */
 
 /**
- * @brief Snap7 event callback for logging connections and errors
+ * @brief Snap7 event callback for the client counters and the logged events
+ *
+ * Per-client events use the rate-limited logger: a client reconnecting in a
+ * loop or a fast-polling HMI would otherwise flood the log.
  */
 static void s7comm_event_callback(void *usrPtr, PSrvEvent PEvent, int Size)
 {
     (void)usrPtr;
     (void)Size;
 
-    switch (PEvent->EvtCode) {
+    longword code = PEvent->EvtCode;
+    bool logged = (g_log_events & code) != 0;
+    char address[INET_ADDRSTRLEN];
+    struct in_addr in = {(in_addr_t)PEvent->EvtSender};
+    inet_ntop(AF_INET, &in, address, sizeof(address));
+
+    switch (code) {
         case evcServerStarted:
-            plugin_logger_info(&g_logger, "S7 server started");
+            if (logged) {
+                plugin_logger_info(&g_logger, "S7 server started");
+            }
             break;
         case evcServerStopped:
-            plugin_logger_info(&g_logger, "S7 server stopped");
+            if (logged) {
+                plugin_logger_info(&g_logger, "S7 server stopped");
+            }
             break;
         case evcClientAdded:
-            if (g_config.logging.log_connections) {
-                plugin_logger_info(&g_logger, "Client connected (ID: %d)", PEvent->EvtSender);
+            metric_add(g_metric_connections, 1);
+            client_connected(PEvent->EvtSender);
+            if (logged) {
+                plugin_logger_info_limited(&g_logger, "Client %s connected", address);
             }
             break;
         case evcClientDisconnected:
-            if (g_config.logging.log_connections) {
-                plugin_logger_info(&g_logger, "Client disconnected (ID: %d)", PEvent->EvtSender);
-            }
+            metric_add(g_metric_connections, -1);
+            client_closed(PEvent->EvtSender, false, logged ? "disconnected" : NULL);
+            break;
+        case evcClientTerminated:
+            metric_add(g_metric_connections, -1);
+            client_closed(PEvent->EvtSender, false, logged ? "terminated" : NULL);
+            break;
+        case evcClientException:
+            metric_add(g_metric_connections, -1);
+            client_closed(PEvent->EvtSender, true, logged ? "closed after an exception" : NULL);
             break;
         case evcClientRejected:
-            plugin_logger_warn(&g_logger, "Client rejected (ID: %d)", PEvent->EvtSender);
+            metric_add(g_metric_rejected, 1);
+            if (logged) {
+                plugin_logger_warn_limited(&g_logger, "Client %s rejected", address);
+            }
             break;
         case evcListenerCannotStart:
-            plugin_logger_error(&g_logger, "Listener cannot start - port may be in use or requires root");
-            break;
-        case evcClientException:
-            if (g_config.logging.log_errors) {
-                plugin_logger_warn(&g_logger, "Client exception (ID: %d)", PEvent->EvtSender);
+            if (logged) {
+                plugin_logger_error(&g_logger,
+                                    "Listener cannot start - port may be in use or requires root");
             }
             break;
         case evcDataRead:
-            if (g_config.logging.log_data_access) {
-                plugin_logger_debug(&g_logger, "Data read by client %d", PEvent->EvtSender);
+            if (logged) {
+                plugin_logger_debug_limited(&g_logger, "Data read by client %s", address);
             }
             break;
         case evcDataWrite:
-            if (g_config.logging.log_data_access) {
-                plugin_logger_debug(&g_logger, "Data write by client %d", PEvent->EvtSender);
+            if (logged) {
+                plugin_logger_debug_limited(&g_logger, "Data write by client %s", address);
             }
             break;
         default:
-            /* Ignore other events */
+            if (logged) {
+                char text[256];
+                Srv_EventText(*PEvent, text, sizeof(text));
+                plugin_logger_debug_limited(&g_logger, "%s", text);
+            }
+            break;
+    }
+}
+
+/*
+ * =============================================================================
+ * Runtime Metrics
+ * =============================================================================
+ */
+
+static int register_metric(const char *name, const char *help, int type)
+{
+    return g_runtime_args.metric_register(g_runtime_args.plugin_id, name, help, type);
+}
+
+/**
+ * @brief Register the S7 server metrics with the runtime's metrics endpoint
+ *
+ * Handles stay -1 when the runtime does not provide metric_register. A plugin
+ * restart registers the same names again and gets the same handles back.
+ */
+static void register_metrics(void)
+{
+    if (g_runtime_args.metric_register == NULL || g_runtime_args.metric_add == NULL ||
+        g_runtime_args.metric_set == NULL) {
+        return;
+    }
+
+    g_metric_connections = register_metric("s7comm_connections", "Connected S7 clients",
+                                           PLUGIN_METRIC_GAUGE);
+    g_metric_rejected = register_metric("s7comm_clients_rejected", "S7 connections rejected",
+                                        PLUGIN_METRIC_COUNTER);
+    g_metric_read_requests = register_metric("s7comm_read_requests", "S7 read requests served",
+                                             PLUGIN_METRIC_COUNTER);
+    g_metric_write_requests = register_metric("s7comm_write_requests", "S7 write requests served",
+                                              PLUGIN_METRIC_COUNTER);
+    g_metric_read_bytes = register_metric("s7comm_read_bytes", "Bytes read by S7 clients",
+                                          PLUGIN_METRIC_COUNTER);
+    g_metric_write_bytes = register_metric("s7comm_write_bytes", "Bytes written by S7 clients",
+                                           PLUGIN_METRIC_COUNTER);
+
+    /* No client is connected to a server that has not started yet */
+    if (g_metric_connections >= 0) {
+        g_runtime_args.metric_set(g_metric_connections, 0);
+    }
+}
+
+static void metric_add(int handle, long long delta)
+{
+    if (handle >= 0) {
+        g_runtime_args.metric_add(handle, delta);
+    }
+}
+
+/* Count one read or write request (all items of a multi-item request) */
+static void count_request(int operation, int bytes)
+{
+    if (operation == OperationRead) {
+        metric_add(g_metric_read_requests, 1);
+        metric_add(g_metric_read_bytes, bytes);
+    } else if (operation == OperationWrite) {
+        metric_add(g_metric_write_requests, 1);
+        metric_add(g_metric_write_bytes, bytes);
+    }
+}
+
+/*
+ * =============================================================================
+ * Per-client Counters
+ * =============================================================================
+ */
+
+static int register_client_metric(const char *name, const char *help, int type, const char *client)
+{
+    if (g_runtime_args.metric_register_labels == NULL) {
+        return -1;
+    }
+    char labels[48];
+    snprintf(labels, sizeof(labels), "client=\"%s\"", client);
+    return g_runtime_args.metric_register_labels(g_runtime_args.plugin_id, name, help, type, labels);
+}
+
+/**
+ * @brief Set up a slot and its metric series for `client` (an address or "other")
+ */
+static void init_client_stats(s7comm_client_stats_t *stats, const char *client)
+{
+    stats->connections.store(0, std::memory_order_relaxed);
+    stats->requests.store(0, std::memory_order_relaxed);
+    stats->bytes.store(0, std::memory_order_relaxed);
+    stats->errors.store(0, std::memory_order_relaxed);
+    stats->service_ns.store(0, std::memory_order_relaxed);
+    stats->service_max_ns.store(0, std::memory_order_relaxed);
+    snprintf(stats->name, sizeof(stats->name), "%s", client);
+
+    stats->metric_connections = -1;
+    stats->metric_requests = -1;
+    stats->metric_bytes = -1;
+    stats->metric_errors = -1;
+    stats->metric_service = -1;
+    stats->metric_service_max = -1;
+    if (!g_config.logging.client_metrics || g_runtime_args.metric_add == NULL ||
+        g_runtime_args.metric_set == NULL) {
+        return;
+    }
+
+    stats->metric_connections = register_client_metric(
+        "s7comm_client_connections", "Open connections of an S7 client", PLUGIN_METRIC_GAUGE, client);
+    stats->metric_requests = register_client_metric(
+        "s7comm_client_requests", "Read and write requests of an S7 client", PLUGIN_METRIC_COUNTER,
+        client);
+    stats->metric_bytes = register_client_metric(
+        "s7comm_client_bytes", "Bytes read and written by an S7 client", PLUGIN_METRIC_COUNTER, client);
+    stats->metric_errors = register_client_metric(
+        "s7comm_client_errors", "Unmapped items, rejected requests and exceptions of an S7 client",
+        PLUGIN_METRIC_COUNTER, client);
+    stats->metric_service = register_client_metric(
+        "s7comm_client_service_ns", "Time spent serving the requests of an S7 client",
+        PLUGIN_METRIC_COUNTER, client);
+    stats->metric_service_max = register_client_metric(
+        "s7comm_client_service_max_ns", "Longest request of an S7 client since the plugin started",
+        PLUGIN_METRIC_GAUGE, client);
+
+    /* A restarted plugin gets the same series back, with nobody connected */
+    if (stats->metric_connections >= 0) {
+        g_runtime_args.metric_set(stats->metric_connections, 0);
+    }
+    if (stats->metric_service_max >= 0) {
+        g_runtime_args.metric_set(stats->metric_service_max, 0);
+    }
+}
+
+/**
+ * @brief Free every client slot (before the server starts)
+ */
+static void reset_client_stats(void)
+{
+    for (int i = 0; i < S7COMM_CLIENT_SLOTS; i++) {
+        g_clients[i].address.store(0, std::memory_order_relaxed);
+    }
+    g_num_clients = 0;
+    init_client_stats(&g_clients[S7COMM_CLIENT_SLOTS], "other");
+}
+
+/**
+ * @brief Slot of a client address, NULL if it has none
+ *
+ * Slots are claimed in order and never freed, so the search stops at the
+ * first free one.
+ */
+static s7comm_client_stats_t *find_client_stats(uint32_t address)
+{
+    for (int i = 0; i < S7COMM_CLIENT_SLOTS; i++) {
+        uint32_t slot_address = g_clients[i].address.load(std::memory_order_acquire);
+        if (slot_address == address) {
+            return &g_clients[i];
+        }
+        if (slot_address == 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Slot of a client address, claiming a free one (event callback only)
+ */
+static s7comm_client_stats_t *claim_client_stats(uint32_t address)
+{
+    s7comm_client_stats_t *stats = address != 0 ? find_client_stats(address) : NULL;
+    if (stats != NULL) {
+        return stats;
+    }
+    if (address == 0 || g_num_clients == S7COMM_CLIENT_SLOTS) {
+        return &g_clients[S7COMM_CLIENT_SLOTS];
+    }
+
+    char name[INET_ADDRSTRLEN];
+    struct in_addr in = {(in_addr_t)address};
+    inet_ntop(AF_INET, &in, name, sizeof(name));
+
+    stats = &g_clients[g_num_clients++];
+    init_client_stats(stats, name);
+    stats->address.store(address, std::memory_order_release);
+    return stats;
+}
+
+static void client_connected(int sender)
+{
+    s7comm_client_stats_t *stats = claim_client_stats((uint32_t)sender);
+    stats->connections.fetch_add(1, std::memory_order_relaxed);
+    metric_add(stats->metric_connections, 1);
+}
+
+/**
+ * @brief Count a closed connection, logging the client's totals unless `how` is NULL
+ */
+static void client_closed(int sender, bool error, const char *how)
+{
+    s7comm_client_stats_t *stats = claim_client_stats((uint32_t)sender);
+    stats->connections.fetch_sub(1, std::memory_order_relaxed);
+    metric_add(stats->metric_connections, -1);
+    if (error) {
+        stats->errors.fetch_add(1, std::memory_order_relaxed);
+        metric_add(stats->metric_errors, 1);
+    }
+    if (how == NULL) {
+        return;
+    }
+
+    uint64_t requests = stats->requests.load(std::memory_order_relaxed);
+    uint64_t service_ns = stats->service_ns.load(std::memory_order_relaxed);
+    char address[INET_ADDRSTRLEN];
+    struct in_addr in = {(in_addr_t)sender};
+    inet_ntop(AF_INET, &in, address, sizeof(address));
+    bool shared = stats == &g_clients[S7COMM_CLIENT_SLOTS];
+    plugin_logger_info_limited(&g_logger,
+                               "Client %s %s, totals%s: %llu requests, %llu bytes, %llu errors, "
+                               "avg %llu ns, max %llu ns",
+                               address, how, shared ? " of the other clients" : "",
+                               (unsigned long long)requests,
+                               (unsigned long long)stats->bytes.load(std::memory_order_relaxed),
+                               (unsigned long long)stats->errors.load(std::memory_order_relaxed),
+                               (unsigned long long)(requests ? service_ns / requests : 0),
+                               (unsigned long long)stats->service_max_ns.load(
+                                   std::memory_order_relaxed));
+}
+
+static uint64_t service_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Count a request served for `sender` since `start_ns`
+ */
+static void count_client_request(int sender, int bytes, int errors, uint64_t start_ns)
+{
+    uint64_t elapsed = service_clock_ns() - start_ns;
+    s7comm_client_stats_t *stats = find_client_stats((uint32_t)sender);
+    if (stats == NULL) {
+        stats = &g_clients[S7COMM_CLIENT_SLOTS];
+    }
+
+    stats->requests.fetch_add(1, std::memory_order_relaxed);
+    stats->bytes.fetch_add((uint64_t)bytes, std::memory_order_relaxed);
+    stats->service_ns.fetch_add(elapsed, std::memory_order_relaxed);
+    metric_add(stats->metric_requests, 1);
+    metric_add(stats->metric_bytes, bytes);
+    metric_add(stats->metric_service, (long long)elapsed);
+    if (errors > 0) {
+        stats->errors.fetch_add((uint64_t)errors, std::memory_order_relaxed);
+        metric_add(stats->metric_errors, errors);
+    }
+
+    uint64_t max = stats->service_max_ns.load(std::memory_order_relaxed);
+    while (elapsed > max) {
+        if (stats->service_max_ns.compare_exchange_weak(max, elapsed, std::memory_order_relaxed)) {
+            if (stats->metric_service_max >= 0) {
+                g_runtime_args.metric_set(stats->metric_service_max, (long long)elapsed);
+            }
             break;
+        }
     }
 }
 
@@ -660,15 +1203,44 @@ static int map_to_journal_type(s7comm_buffer_type_t type)
     }
 }
 
+static inline unsigned db_hash_bucket(int db_number)
+{
+    return ((unsigned)db_number * 2654435761u) >> (32 - S7COMM_DB_HASH_BITS);
+}
+
+/**
+ * @brief Index the allocated DBs by number (before the server starts)
+ */
+static void build_db_hash(void)
+{
+    clear_db_hash();
+    for (int i = 0; i < g_num_db_runtime; i++) {
+        unsigned bucket = db_hash_bucket(g_db_runtime[i].db_number);
+        while (g_db_hash[bucket] != 0) {
+            bucket = (bucket + 1) & (S7COMM_DB_HASH_SIZE - 1);
+        }
+        g_db_hash[bucket] = (uint16_t)(i + 1);
+    }
+}
+
+static void clear_db_hash(void)
+{
+    memset(g_db_hash, 0, sizeof(g_db_hash));
+}
+
 /**
  * @brief Find DB runtime structure by DB number
  */
 static s7comm_db_runtime_t* find_db_runtime(int db_number)
 {
-    for (int i = 0; i < g_num_db_runtime; i++) {
-        if (g_db_runtime[i].db_number == db_number) {
-            return &g_db_runtime[i];
+    unsigned bucket = db_hash_bucket(db_number);
+    int slot;
+
+    while ((slot = g_db_hash[bucket]) != 0) {
+        if (g_db_runtime[slot - 1].db_number == db_number) {
+            return &g_db_runtime[slot - 1];
         }
+        bucket = (bucket + 1) & (S7COMM_DB_HASH_SIZE - 1);
     }
     return NULL;
 }
@@ -724,6 +1296,23 @@ static int get_type_size(s7comm_buffer_type_t type)
     }
 }
 
+/**
+ * @brief log2 of get_type_size(), so tag offsets are shifts
+ */
+static int get_type_shift(s7comm_buffer_type_t type)
+{
+    switch (get_type_size(type)) {
+        case 8:
+            return 3;
+        case 4:
+            return 2;
+        case 2:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 /*
  * =============================================================================
  * Read Functions: OpenPLC -> S7 Buffer (for S7 client READs)
@@ -732,6 +1321,29 @@ static int get_type_size(s7comm_buffer_type_t type)
  * =============================================================================
  */
 
+/**
+ * @brief Get the runtime's packed shadow copy of an OpenPLC area
+ *
+ * The first request enables the shadow for that area; until the runtime has
+ * refreshed it NULL is returned and readers fall back to the pointer tables.
+ */
+static const void *get_shadow_area(s7comm_buffer_type_t type)
+{
+    if (g_runtime_args.get_image_area == NULL) {
+        return NULL;
+    }
+    int journal_type = map_to_journal_type(type);
+    if (journal_type < 0) {
+        return NULL;
+    }
+    int length = 0;
+    const void *area = g_runtime_args.get_image_area(journal_type, &length);
+    if (length < g_runtime_args.buffer_size) {
+        return NULL;
+    }
+    return area;
+}
+
 /**
  * @brief Read OpenPLC bool buffer to destination (mutex must be held)
  */
@@ -759,6 +1371,14 @@ static void read_openplc_bool_to_buffer(uint8_t *dest, int size, s7comm_buffer_t
 
     int max_bytes = g_runtime_args.buffer_size - start_buffer;
     if (max_bytes > size) max_bytes = size;
+    if (max_bytes <= 0) return;
+
+    /* Shadow is already bit-packed in S7 layout */
+    const uint8_t *shadow = (const uint8_t *)get_shadow_area(type);
+    if (shadow != NULL) {
+        memcpy(dest, shadow + start_buffer, (size_t)max_bytes);
+        return;
+    }
 
     for (int byte_idx = 0; byte_idx < max_bytes; byte_idx++) {
         uint8_t byte_val = 0;
@@ -799,6 +1419,14 @@ static void read_openplc_int_to_buffer(uint8_t *dest, int size, s7comm_buffer_ty
     int max_words = g_runtime_args.buffer_size - start_buffer;
     if (max_words > num_words) max_words = num_words;
 
+    const IEC_UINT *shadow = (const IEC_UINT *)get_shadow_area(type);
+    if (shadow != NULL) {
+        if (max_words > 0) {
+            s7comm_swap16_copy(s7_words, shadow + start_buffer, (size_t)max_words);
+        }
+        return;
+    }
+
     for (int i = 0; i < max_words; i++) {
         IEC_UINT *ptr = buffer[start_buffer + i];
         if (ptr != NULL) {
@@ -833,6 +1461,14 @@ static void read_openplc_dint_to_buffer(uint8_t *dest, int size, s7comm_buffer_t
     int max_dwords = g_runtime_args.buffer_size - start_buffer;
     if (max_dwords > num_dwords) max_dwords = num_dwords;
 
+    const IEC_UDINT *shadow = (const IEC_UDINT *)get_shadow_area(type);
+    if (shadow != NULL) {
+        if (max_dwords > 0) {
+            s7comm_swap32_copy(s7_dwords, shadow + start_buffer, (size_t)max_dwords);
+        }
+        return;
+    }
+
     for (int i = 0; i < max_dwords; i++) {
         IEC_UDINT *ptr = buffer[start_buffer + i];
         if (ptr != NULL) {
@@ -867,6 +1503,14 @@ static void read_openplc_lint_to_buffer(uint8_t *dest, int size, s7comm_buffer_t
     int max_lwords = g_runtime_args.buffer_size - start_buffer;
     if (max_lwords > num_lwords) max_lwords = num_lwords;
 
+    const IEC_ULINT *shadow = (const IEC_ULINT *)get_shadow_area(type);
+    if (shadow != NULL) {
+        if (max_lwords > 0) {
+            s7comm_swap64_copy(s7_lwords, shadow + start_buffer, (size_t)max_lwords);
+        }
+        return;
+    }
+
     for (int i = 0; i < max_lwords; i++) {
         IEC_ULINT *ptr = buffer[start_buffer + i];
         if (ptr != NULL) {
@@ -875,6 +1519,47 @@ static void read_openplc_lint_to_buffer(uint8_t *dest, int size, s7comm_buffer_t
     }
 }
 
+/**
+ * @brief Read from the runtime's per-scan snapshot without taking the mutex
+ *
+ * The snapshot is published by the scan thread at the end of every cycle, so
+ * a slow client read neither waits for nor delays the scan.
+ *
+ * @return true if the read was served, false to fall back to a locked read
+ */
+static bool read_snapshot_to_buffer(uint8_t *dest, int size, s7comm_buffer_type_t type, int start_buffer)
+{
+    if (g_runtime_args.read_image_snapshot == NULL) {
+        return false;
+    }
+    int journal_type = map_to_journal_type(type);
+    if (journal_type < 0 || start_buffer < 0) {
+        return false;
+    }
+
+    int count = size / get_type_size(type);
+    int copied = g_runtime_args.read_image_snapshot(journal_type, start_buffer, count, dest);
+    if (copied < 0) {
+        return false;
+    }
+
+    /* Snapshot is in host order; S7 is big-endian */
+    switch (get_type_size(type)) {
+        case 2:
+            s7comm_swap16_copy(dest, dest, (size_t)copied);
+            break;
+        case 4:
+            s7comm_swap32_copy(dest, dest, (size_t)copied);
+            break;
+        case 8:
+            s7comm_swap64_copy(dest, dest, (size_t)copied);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
 /**
  * @brief Dispatch read from OpenPLC to buffer based on buffer type
  */
@@ -910,6 +1595,81 @@ static void read_openplc_to_buffer(uint8_t *dest, int size, s7comm_buffer_type_t
     }
 }
 
+/**
+ * @brief Mark a freshly allocated area's cache as idle and never built
+ */
+static void reset_read_cache(s7comm_read_cache_t *cache)
+{
+    unsigned scan = g_scan_count.load(std::memory_order_relaxed);
+    cache->built.store(scan - 1, std::memory_order_relaxed);
+    cache->last_read.store(scan - S7COMM_CACHE_IDLE_SCANS - 1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Rebuild an area's read cache if a client read it recently (scan thread, mutex held)
+ */
+static void refresh_read_cache(s7comm_read_cache_t *cache, uint8_t *buffer, int size,
+                               s7comm_buffer_type_t type, int start_buffer, unsigned scan)
+{
+    if (cache == NULL || buffer == NULL) {
+        return;
+    }
+    if (scan - cache->last_read.load(std::memory_order_relaxed) > S7COMM_CACHE_IDLE_SCANS) {
+        return;
+    }
+
+    unsigned seq = cache->seq.load(std::memory_order_relaxed);
+    cache->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    read_openplc_to_buffer(buffer, size, type, start_buffer);
+    cache->built.store(scan, std::memory_order_relaxed);
+
+    cache->seq.store(seq + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Copy a span of an area from its read cache
+ *
+ * Also marks the area as read, so the scan keeps (or starts) refreshing it.
+ *
+ * @param built_scan If not NULL, receives the scan that built the copied bytes
+ * @return true if the span was served from the latest scan, false if the cache
+ * is not built yet (first read of an idle area), the span is out of the area,
+ * or the scan thread kept rewriting it
+ */
+static bool read_cache_to_buffer(s7comm_read_cache_t *cache, const uint8_t *buffer, int area_size,
+                                 int offset, int size, uint8_t *dest, unsigned *built_scan)
+{
+    if (cache == NULL || buffer == NULL || offset < 0 || size < 0 || offset + size > area_size) {
+        return false;
+    }
+
+    unsigned scan = g_scan_count.load(std::memory_order_acquire);
+    if (cache->last_read.load(std::memory_order_relaxed) != scan) {
+        cache->last_read.store(scan, std::memory_order_relaxed);
+    }
+
+    for (int attempt = 0; attempt < S7COMM_CACHE_READ_RETRIES; attempt++) {
+        unsigned seq = cache->seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(dest, buffer + offset, (size_t)size);
+        unsigned built = cache->built.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (cache->seq.load(std::memory_order_relaxed) == seq) {
+            if (built_scan != NULL) {
+                *built_scan = built;
+            }
+            /* Built by the last completed scan, or by the one finishing now */
+            return (int)(built - scan) >= 0;
+        }
+    }
+    return false;
+}
+
 /*
  * =============================================================================
  * Write Functions: S7 Buffer -> OpenPLC via Journal (for S7 client WRITEs)
@@ -918,8 +1678,14 @@ static void read_openplc_to_buffer(uint8_t *dest, int size, s7comm_buffer_type_t
  * =============================================================================
  */
 
+/* Elements byte-swapped on the stack per journal range entry */
+#define S7COMM_JOURNAL_CHUNK 256
+
 /**
  * @brief Write bool buffer to OpenPLC via journal
+ *
+ * S7 bit areas use the same byte/bit layout as OpenPLC, so the bytes are
+ * journaled as a single range entry without unpacking.
  */
 static void write_bool_to_openplc_journal(uint8_t *src, int size, s7comm_buffer_type_t type, int start_buffer)
 {
@@ -928,15 +1694,9 @@ static void write_bool_to_openplc_journal(uint8_t *src, int size, s7comm_buffer_
 
     int max_bytes = g_runtime_args.buffer_size - start_buffer;
     if (max_bytes > size) max_bytes = size;
+    if (max_bytes <= 0) return;
 
-    for (int byte_idx = 0; byte_idx < max_bytes; byte_idx++) {
-        uint8_t byte_val = src[byte_idx];
-        int plc_idx = start_buffer + byte_idx;
-        for (int bit_idx = 0; bit_idx < 8; bit_idx++) {
-            int bit_val = (byte_val >> bit_idx) & 0x01;
-            g_runtime_args.journal_write_bool(journal_type, plc_idx, bit_idx, bit_val);
-        }
-    }
+    g_runtime_args.journal_write_range(journal_type, start_buffer, max_bytes, src);
 }
 
 /**
@@ -952,9 +1712,12 @@ static void write_int_to_openplc_journal(uint8_t *src, int size, s7comm_buffer_t
     int max_words = g_runtime_args.buffer_size - start_buffer;
     if (max_words > num_words) max_words = num_words;
 
-    for (int i = 0; i < max_words; i++) {
-        uint16_t value = swap16(s7_words[i]);
-        g_runtime_args.journal_write_int(journal_type, start_buffer + i, value);
+    uint16_t values[S7COMM_JOURNAL_CHUNK];
+    for (int base = 0; base < max_words; base += S7COMM_JOURNAL_CHUNK) {
+        int count = max_words - base;
+        if (count > S7COMM_JOURNAL_CHUNK) count = S7COMM_JOURNAL_CHUNK;
+        s7comm_swap16_copy(values, s7_words + base, (size_t)count);
+        g_runtime_args.journal_write_range(journal_type, start_buffer + base, count, values);
     }
 }
 
@@ -971,9 +1734,12 @@ static void write_dint_to_openplc_journal(uint8_t *src, int size, s7comm_buffer_
     int max_dwords = g_runtime_args.buffer_size - start_buffer;
     if (max_dwords > num_dwords) max_dwords = num_dwords;
 
-    for (int i = 0; i < max_dwords; i++) {
-        uint32_t value = swap32(s7_dwords[i]);
-        g_runtime_args.journal_write_dint(journal_type, start_buffer + i, value);
+    uint32_t values[S7COMM_JOURNAL_CHUNK];
+    for (int base = 0; base < max_dwords; base += S7COMM_JOURNAL_CHUNK) {
+        int count = max_dwords - base;
+        if (count > S7COMM_JOURNAL_CHUNK) count = S7COMM_JOURNAL_CHUNK;
+        s7comm_swap32_copy(values, s7_dwords + base, (size_t)count);
+        g_runtime_args.journal_write_range(journal_type, start_buffer + base, count, values);
     }
 }
 
@@ -990,9 +1756,12 @@ static void write_lint_to_openplc_journal(uint8_t *src, int size, s7comm_buffer_
     int max_lwords = g_runtime_args.buffer_size - start_buffer;
     if (max_lwords > num_lwords) max_lwords = num_lwords;
 
-    for (int i = 0; i < max_lwords; i++) {
-        uint64_t value = swap64(s7_lwords[i]);
-        g_runtime_args.journal_write_lint(journal_type, start_buffer + i, value);
+    uint64_t values[S7COMM_JOURNAL_CHUNK];
+    for (int base = 0; base < max_lwords; base += S7COMM_JOURNAL_CHUNK) {
+        int count = max_lwords - base;
+        if (count > S7COMM_JOURNAL_CHUNK) count = S7COMM_JOURNAL_CHUNK;
+        s7comm_swap64_copy(values, s7_lwords + base, (size_t)count);
+        g_runtime_args.journal_write_range(journal_type, start_buffer + base, count, values);
     }
 }
 
@@ -1037,11 +1806,69 @@ static void write_buffer_to_openplc_journal(uint8_t *src, int size, s7comm_buffe
  * =============================================================================
  */
 
+/* Where an S7 tag lives in OpenPLC and in its area's read cache */
+typedef struct {
+    s7comm_buffer_type_t type;
+    int start_buffer;               /* First OpenPLC buffer index of the tag */
+    int offset;                     /* Byte offset of that element in the area */
+    int size;                       /* Bytes requested */
+    s7comm_read_cache_t *cache;
+    const uint8_t *cache_buffer;
+    int area_size;
+} s7comm_tag_span_t;
+
+/**
+ * @brief Resolve an S7 tag against the configured DBs and system areas
+ *
+ * The conversions address whole elements, so the span starts at the element
+ * containing PTag->Start.
+ *
+ * @return false if the DB or area is not configured (the tag reads as zeros
+ * and writes to it are ignored)
+ */
+static bool resolve_tag_span(PS7Tag PTag, s7comm_tag_span_t *span)
+{
+    int shift;
+
+    if (PTag->Area == S7AreaDB) {
+        /* Data block - look up configuration */
+        s7comm_db_runtime_t *db = find_db_runtime(PTag->DBNumber);
+        if (db == NULL) {
+            return false;
+        }
+        span->type = db->type;
+        span->start_buffer = db->start_buffer;
+        shift = db->type_shift;
+        span->cache = db->cache;
+        span->cache_buffer = db->s7_buffer;
+        span->area_size = db->size_bytes;
+    } else {
+        /* System area (PE, PA, MK) */
+        s7comm_area_runtime_t *area = find_area_runtime(PTag->Area);
+        if (area == NULL) {
+            return false;
+        }
+        span->type = area->type;
+        span->start_buffer = area->start_buffer;
+        shift = area->type_shift;
+        span->cache = area->cache;
+        span->cache_buffer = area->s7_buffer;
+        span->area_size = area->size_bytes;
+    }
+
+    span->start_buffer += PTag->Start >> shift;
+    span->offset = (PTag->Start >> shift) << shift;
+    span->size = PTag->Size;
+    return true;
+}
+
 /**
  * @brief Snap7 RWArea callback for on-demand data synchronization
  *
  * Called by Snap7 when an S7 client reads or writes data.
- * - On READ: Acquire OpenPLC mutex, copy fresh data to S7 buffer, release mutex
+ * - On READ: Copy from the area's per-scan read cache; until it is built, copy
+ *   from the lock-free runtime snapshot, or acquire OpenPLC mutex, copy fresh
+ *   data to S7 buffer, release mutex
  * - On WRITE: Use journal writes (thread-safe, no mutex needed)
  *
  * @param usrPtr User pointer (unused)
@@ -1054,52 +1881,406 @@ static void write_buffer_to_openplc_journal(uint8_t *src, int size, s7comm_buffe
 static int s7comm_rw_area_callback(void *usrPtr, int Sender, int Operation, PS7Tag PTag, void *pUsrData)
 {
     (void)usrPtr;
-    (void)Sender;
+
+    uint64_t start_ns = g_config.logging.client_metrics ? service_clock_ns() : 0;
 
     if (pUsrData == NULL || PTag == NULL) {
+        if (start_ns != 0) {
+            count_client_request(Sender, 0, 1, start_ns);
+        }
         return -1;
     }
 
-    s7comm_buffer_type_t type;
-    int start_buffer;
-    int size = PTag->Size;
-
-    /* Determine mapping based on S7 protocol area code */
-    if (PTag->Area == S7AreaDB) {
-        /* Data block - look up configuration */
-        s7comm_db_runtime_t *db = find_db_runtime(PTag->DBNumber);
-        if (db == NULL) {
-            /* DB not configured - return zeros for read, ignore write */
-            return 0;
-        }
-        type = db->type;
-        start_buffer = db->start_buffer + (PTag->Start / get_type_size(type));
-    } else {
-        /* System area (PE, PA, MK) */
-        s7comm_area_runtime_t *area = find_area_runtime(PTag->Area);
-        if (area == NULL) {
-            /* Area not configured - return zeros for read, ignore write */
-            return 0;
+    s7comm_tag_span_t span;
+    if (!resolve_tag_span(PTag, &span)) {
+        /* Not configured - return zeros for read, ignore write */
+        if (start_ns != 0) {
+            count_client_request(Sender, 0, 1, start_ns);
         }
-        type = area->type;
-        start_buffer = area->start_buffer + (PTag->Start / get_type_size(type));
+        return 0;
     }
+    count_request(Operation, span.size);
 
     if (Operation == OperationRead) {
         /*
-         * S7 client is READing - provide fresh data from OpenPLC
-         * Acquire mutex, copy data, release mutex
+         * S7 client is READing - provide data from the last completed scan.
+         * A memcpy from the read cache once cycle_end builds it, lock-free
+         * when the runtime snapshot is available, otherwise acquire mutex,
+         * copy data, release mutex.
          */
-        g_runtime_args.mutex_take(g_runtime_args.buffer_mutex);
-        read_openplc_to_buffer((uint8_t *)pUsrData, size, type, start_buffer);
-        g_runtime_args.mutex_give(g_runtime_args.buffer_mutex);
+        if (!read_cache_to_buffer(span.cache, span.cache_buffer, span.area_size, span.offset,
+                                  span.size, (uint8_t *)pUsrData, NULL) &&
+            !read_snapshot_to_buffer((uint8_t *)pUsrData, span.size, span.type,
+                                     span.start_buffer)) {
+            g_runtime_args.mutex_take(g_runtime_args.buffer_mutex);
+            read_openplc_to_buffer((uint8_t *)pUsrData, span.size, span.type, span.start_buffer);
+            g_runtime_args.mutex_give(g_runtime_args.buffer_mutex);
+        }
     } else if (Operation == OperationWrite) {
         /*
          * S7 client is WRITing - journal the changes
          * Journal writes are thread-safe, no mutex needed
          */
-        write_buffer_to_openplc_journal((uint8_t *)pUsrData, size, type, start_buffer);
+        write_buffer_to_openplc_journal((uint8_t *)pUsrData, span.size, span.type, span.start_buffer);
     }
 
+    if (start_ns != 0) {
+        count_client_request(Sender, span.size, 0, start_ns);
+    }
     return 0;  /* Accept operation */
 }
+
+/**
+ * @brief Copy every mapped item of a multi-item read from the read caches
+ *
+ * @return true if all of them were built by the same scan, and that scan is
+ * still the latest one
+ */
+static bool read_caches_consistent(int ItemsCount, const s7comm_tag_span_t *spans,
+                                   const bool *mapped, void **pUsrData)
+{
+    unsigned scan = g_scan_count.load(std::memory_order_acquire);
+    unsigned first = 0;
+    bool have_first = false;
+
+    for (int i = 0; i < ItemsCount; i++) {
+        unsigned built;
+        if (!mapped[i]) {
+            continue;
+        }
+        if (!read_cache_to_buffer(spans[i].cache, spans[i].cache_buffer, spans[i].area_size,
+                                  spans[i].offset, spans[i].size, (uint8_t *)pUsrData[i], &built)) {
+            return false;
+        }
+        if (have_first && built != first) {
+            return false;
+        }
+        first = built;
+        have_first = true;
+    }
+    return g_scan_count.load(std::memory_order_acquire) == scan;
+}
+
+/**
+ * @brief Snap7 callback for all the items of one multi-item ReadVar/WriteVar
+ *
+ * - On READ: every item comes from the same scan. The read caches when they
+ *   agree on it, otherwise all the items are converted under one acquisition
+ *   of the OpenPLC mutex.
+ * - On WRITE: every item is journaled, in request order
+ *
+ * @return 0 to accept the whole request
+ */
+static int s7comm_rw_areas_callback(void *usrPtr, int Sender, int Operation, int ItemsCount,
+                                    PS7Tag PTags, void **pUsrData)
+{
+    (void)usrPtr;
+
+    uint64_t start_ns = g_config.logging.client_metrics ? service_clock_ns() : 0;
+
+    if (PTags == NULL || pUsrData == NULL || ItemsCount <= 0 || ItemsCount > MaxVars) {
+        if (start_ns != 0) {
+            count_client_request(Sender, 0, 1, start_ns);
+        }
+        return -1;
+    }
+
+    s7comm_tag_span_t spans[MaxVars];
+    bool mapped[MaxVars];
+    bool any_mapped = false;
+
+    int bytes = 0;
+    int unmapped = 0;
+
+    for (int i = 0; i < ItemsCount; i++) {
+        mapped[i] = pUsrData[i] != NULL && resolve_tag_span(&PTags[i], &spans[i]);
+        any_mapped = any_mapped || mapped[i];
+        bytes += mapped[i] ? spans[i].size : 0;
+        unmapped += mapped[i] ? 0 : 1;
+    }
+    if (!any_mapped) {
+        if (start_ns != 0) {
+            count_client_request(Sender, 0, unmapped, start_ns);
+        }
+        return 0;
+    }
+    count_request(Operation, bytes);
+
+    if (Operation == OperationRead) {
+        bool consistent = false;
+        for (int attempt = 0; attempt < S7COMM_CACHE_READ_RETRIES && !consistent; attempt++) {
+            consistent = read_caches_consistent(ItemsCount, spans, mapped, pUsrData);
+        }
+        if (!consistent) {
+            g_runtime_args.mutex_take(g_runtime_args.buffer_mutex);
+            for (int i = 0; i < ItemsCount; i++) {
+                if (mapped[i]) {
+                    read_openplc_to_buffer((uint8_t *)pUsrData[i], spans[i].size, spans[i].type,
+                                           spans[i].start_buffer);
+                }
+            }
+            g_runtime_args.mutex_give(g_runtime_args.buffer_mutex);
+        }
+    } else if (Operation == OperationWrite) {
+        for (int i = 0; i < ItemsCount; i++) {
+            if (mapped[i]) {
+                write_buffer_to_openplc_journal((uint8_t *)pUsrData[i], spans[i].size, spans[i].type,
+                                                spans[i].start_buffer);
+            }
+        }
+    }
+
+    if (start_ns != 0) {
+        count_client_request(Sender, bytes, unmapped, start_ns);
+    }
+    return 0;
+}
+
+/*
+ * =============================================================================
+ * Partner Connections (S7 peer-to-peer, BSEND/BRCV)
+ * =============================================================================
+ */
+
+static void log_partner_error(const s7comm_partner_runtime_t *p, const char *what, int error)
+{
+    char text[128];
+    Par_ErrorText(error, text, sizeof(text));
+    plugin_logger_warn_limited(&g_logger, "Partner %s: %s: %s", p->config->name, what, text);
+}
+
+/**
+ * @brief Create a Snap7 partner for every enabled partner (init)
+ */
+static int create_partners(void)
+{
+    g_num_partner_runtime = 0;
+
+    for (int i = 0; i < g_config.num_partners; i++) {
+        const s7comm_partner_t *cfg = &g_config.partners[i];
+        if (!cfg->enabled) {
+            plugin_logger_info(&g_logger, "Partner %s is disabled", cfg->name);
+            continue;
+        }
+
+        s7comm_partner_runtime_t *p = &g_partner_runtime[g_num_partner_runtime++];
+        memset(p, 0, sizeof(s7comm_partner_runtime_t));
+        p->config = cfg;
+        p->sending = -1;
+
+        int scratch_size = 0;
+        for (int j = 0; j < cfg->num_blocks; j++) {
+            p->blocks[j].config = &cfg->blocks[j];
+            if (!cfg->blocks[j].send) {
+                continue;
+            }
+            p->blocks[j].s7_buffer = (uint8_t *)calloc(1, cfg->blocks[j].size_bytes);
+            if (p->blocks[j].s7_buffer == NULL) {
+                return -1;
+            }
+            if (cfg->blocks[j].size_bytes > scratch_size) {
+                scratch_size = cfg->blocks[j].size_bytes;
+            }
+        }
+        if (scratch_size > 0) {
+            p->scratch = (uint8_t *)malloc(scratch_size);
+            if (p->scratch == NULL) {
+                return -1;
+            }
+        }
+
+        p->partner = Par_Create(cfg->active ? 1 : 0);
+        if (p->partner == 0) {
+            return -1;
+        }
+
+        int send_timeout = cfg->send_timeout_ms;
+        int recv_timeout = cfg->recv_timeout_ms;
+        uint32_t recovery_time = (uint32_t)cfg->recovery_time_ms;
+        Par_SetParam(p->partner, p_i32_BSendTimeout, &send_timeout);
+        Par_SetParam(p->partner, p_i32_BRecvTimeout, &recv_timeout);
+        Par_SetParam(p->partner, p_u32_RecoveryTime, &recovery_time);
+        Par_SetRecvCallback(p->partner, s7comm_partner_recv_callback, p);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Destroy the partners and free their blocks (cleanup)
+ */
+static void destroy_partners(void)
+{
+    for (int i = 0; i < g_num_partner_runtime; i++) {
+        s7comm_partner_runtime_t *p = &g_partner_runtime[i];
+        if (p->partner != 0) {
+            Par_Destroy(p->partner);
+        }
+        for (int j = 0; j < S7COMM_MAX_PARTNER_BLOCKS; j++) {
+            free(p->blocks[j].s7_buffer);
+            p->blocks[j].s7_buffer = NULL;
+        }
+        free(p->scratch);
+        p->scratch = NULL;
+    }
+    g_num_partner_runtime = 0;
+}
+
+/**
+ * @brief Start the partners (start_loop)
+ *
+ * Active partners connect in the background and keep retrying; a passive
+ * partner fails here if it cannot listen on port 102 of its local address.
+ */
+static void start_partners(void)
+{
+    for (int i = 0; i < g_num_partner_runtime; i++) {
+        s7comm_partner_runtime_t *p = &g_partner_runtime[i];
+        const s7comm_partner_t *cfg = p->config;
+
+        p->sending = -1;
+        p->linked = false;
+        int result = Par_StartTo(p->partner, cfg->local_address, cfg->remote_address,
+                                 cfg->local_tsap, cfg->remote_tsap);
+        if (result != 0) {
+            char text[128];
+            Par_ErrorText(result, text, sizeof(text));
+            plugin_logger_error(&g_logger, "Failed to start partner %s: %s", cfg->name, text);
+            if (!cfg->active) {
+                plugin_logger_error(&g_logger,
+                                    "Note: a passive partner listens on %s:102, which must not "
+                                    "also be the S7 server's", cfg->local_address);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stop the partners, dropping a pending send (stop_loop)
+ */
+static void stop_partners(void)
+{
+    for (int i = 0; i < g_num_partner_runtime; i++) {
+        Par_Stop(g_partner_runtime[i].partner);
+        g_partner_runtime[i].sending = -1;
+    }
+}
+
+/**
+ * @brief Queue at most one send block per partner (scan thread, mutex held)
+ *
+ * A partner sends one block at a time, so the scan only checks whether the
+ * previous one completed; it never waits for the peer. A block is sent when
+ * its image differs from the last one sent, when its refresh interval
+ * expired, and again after a failed send or a new link.
+ */
+static void send_partner_blocks(void)
+{
+    uint64_t now_ns = 0;
+
+    for (int i = 0; i < g_num_partner_runtime; i++) {
+        s7comm_partner_runtime_t *p = &g_partner_runtime[i];
+        const s7comm_partner_t *cfg = p->config;
+
+        if (p->sending >= 0) {
+            int op_result = 0;
+            if (Par_CheckAsBSendCompletion(p->partner, op_result) == JobPending) {
+                continue;
+            }
+            if (op_result != 0) {
+                p->blocks[p->sending].sent = false;
+                log_partner_error(p, "block send failed", op_result);
+            }
+            p->sending = -1;
+        }
+
+        int status = par_stopped;
+        Par_GetStatus(p->partner, status);
+        bool linked = status == par_linked || status == par_sending || status == par_receiving;
+        if (linked != p->linked) {
+            p->linked = linked;
+            plugin_logger_info_limited(&g_logger, "Partner %s %s", cfg->name,
+                                       linked ? "linked" : "unlinked");
+        }
+        if (!linked) {
+            for (int j = 0; j < cfg->num_blocks; j++) {
+                p->blocks[j].sent = false;
+            }
+            continue;
+        }
+
+        if (now_ns == 0) {
+            now_ns = service_clock_ns();
+        }
+        for (int k = 0; k < cfg->num_blocks; k++) {
+            int j = (p->next_send + k) % cfg->num_blocks;
+            s7comm_partner_block_runtime_t *block = &p->blocks[j];
+            const s7comm_partner_block_t *block_cfg = block->config;
+            if (!block_cfg->send) {
+                continue;
+            }
+
+            int size = block_cfg->size_bytes;
+            read_openplc_to_buffer(p->scratch, size, block_cfg->mapping.type,
+                                   block_cfg->mapping.start_buffer);
+            bool due = !block->sent || memcmp(p->scratch, block->s7_buffer, size) != 0 ||
+                       (block_cfg->refresh_ms > 0 &&
+                        now_ns - block->sent_ns >= (uint64_t)block_cfg->refresh_ms * 1000000ull);
+            if (!due) {
+                continue;
+            }
+
+            int result = Par_AsBSend(p->partner, block_cfg->r_id, p->scratch, size);
+            if (result != 0) {
+                log_partner_error(p, "cannot queue block send", result);
+                break;
+            }
+            memcpy(block->s7_buffer, p->scratch, size);
+            block->sent = true;
+            block->sent_ns = now_ns;
+            p->sending = j;
+            p->next_send = j + 1;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Snap7 BRecv callback: journal a block received from a partner
+ *
+ * Called by the partner's worker thread once the whole block arrived. The
+ * journal applies it at the start of the next scan.
+ */
+static void S7API s7comm_partner_recv_callback(void *usrPtr, int opResult, longword R_ID,
+                                               void *pdata, int Size)
+{
+    s7comm_partner_runtime_t *p = (s7comm_partner_runtime_t *)usrPtr;
+    const s7comm_partner_t *cfg = p->config;
+
+    if (opResult != 0) {
+        log_partner_error(p, "block receive failed", opResult);
+        return;
+    }
+
+    for (int j = 0; j < cfg->num_blocks; j++) {
+        const s7comm_partner_block_t *block = &cfg->blocks[j];
+        if (block->send || block->r_id != R_ID) {
+            continue;
+        }
+
+        int size = Size;
+        if (size != block->size_bytes) {
+            plugin_logger_warn_limited(&g_logger, "Partner %s: block R_ID %u is %d bytes, expected %d",
+                                       cfg->name, (unsigned)R_ID, Size, block->size_bytes);
+            if (size > block->size_bytes) {
+                size = block->size_bytes;
+            }
+        }
+        write_buffer_to_openplc_journal((uint8_t *)pdata, size, block->mapping.type,
+                                        block->mapping.start_buffer);
+        return;
+    }
+
+    plugin_logger_warn_limited(&g_logger, "Partner %s: no receive block for R_ID %u",
+                               cfg->name, (unsigned)R_ID);
+}
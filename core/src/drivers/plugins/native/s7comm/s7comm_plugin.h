@@ -12,10 +12,31 @@
 #ifndef S7COMM_PLUGIN_H
 #define S7COMM_PLUGIN_H
 
+#include "plugin_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Hooks and capabilities of the plugin, for runtimes with ABI version 2
+ *
+ * Lists start_loop, stop_loop, cycle_end and cleanup, so such a runtime does
+ * not call the empty cycle_start every scan.
+ */
+extern const plugin_declaration_t plugin_declaration;
+
+/**
+ * @brief Initialize the S7Comm plugin (ABI version 2)
+ *
+ * Copies the part of the runtime args the runtime filled in and continues
+ * like init().
+ *
+ * @param abi Sizes and version of what the runtime passes
+ * @return 0 on success, -1 on failure
+ */
+int plugin_init(const plugin_abi_t *abi);
+
 /**
  * @brief Initialize the S7Comm plugin
  *
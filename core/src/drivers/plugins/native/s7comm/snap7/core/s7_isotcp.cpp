@@ -43,6 +43,17 @@ TIsoTcpSocket::~TIsoTcpSocket()
 {
 }
 //---------------------------------------------------------------------------
+void TIsoTcpSocket::Recycle()
+{
+	TMsgSocket::Recycle();
+	// The connection request of the next client sets them again
+	DstRef = 0x0000;
+	SrcRef = 0x0100;
+	IsoPDUSize =1024;
+    IsoMaxFragments=MaxIsoFragments;
+    LastIsoError=0;
+}
+//---------------------------------------------------------------------------
 int TIsoTcpSocket::CheckPDU(void *pPDU, u_char PduTypeExpected)
 {
 	PIsoHeaderInfo Info;
@@ -244,6 +244,7 @@ public:
 	//--------------------------------------------------------------------------
 	TIsoTcpSocket();
 	~TIsoTcpSocket();
+	void Recycle();
 	// HIGH Level functions (work on payload hiding the underlying protocol)
 	// Connects with a peer, the connection PDU is automatically built starting from address scheme (see below)
 	int isoConnect();
@@ -104,6 +104,21 @@ TS7Worker::TS7Worker()
     // We skip RFC/ISO header, our PDU is the payload
     PDUH_in   =PS7ReqHeader(&PDU.Payload);
     FPDULength=2048;
+    BatchCount=0;
+    BatchRead =false;
+    BatchWrite=false;
+    DBCnt     =0;
+    LastBlk   =Block_DB;
+}
+
+void TS7Worker::Recycle()
+{
+    TIsoTcpWorker::Recycle();
+    // Back to the state of a new worker, the PDU length is negotiated again
+    FPDULength=2048;
+    BatchCount=0;
+    BatchRead =false;
+    BatchWrite=false;
     DBCnt     =0;
     LastBlk   =Block_DB;
 }
@@ -321,8 +336,63 @@ PS7Area TS7Worker::GetArea(byte S7Code, word index)
     };
 }
 //------------------------------------------------------------------------------
+void TS7Worker::BatchReadItems(PReqFunReadParams ReqParams, int ItemsCount)
+{
+    PReqFunReadItem Item;
+    longword Start, Size;
+    longword *PAdd;
+    int c, Multiplier;
+    longword Used = 0;
+
+    // Same Tag as ReadArea gives to DoReadArea, items ReadArea will reject
+    // are just read for nothing
+    BatchCount=0;
+    for (c = 0; c < ItemsCount; c++)
+    {
+        Item=&ReqParams->Items[c];
+        Multiplier=DataSizeByte(Item->TransportSize);
+        Size=Multiplier*SwapWord(Item->Length);
+        if ((Multiplier==0) || (Used+Size>sizeof(BatchBuffer)))
+            continue; // ReadArea rejects it or reads it alone
+
+        PAdd=(longword*)(&Item->Area);
+        Start=SwapDWord(*PAdd & 0xFFFFFF00);
+        if ((Item->TransportSize != S7WLBit) && (Item->TransportSize != S7WLCounter) && (Item->TransportSize != S7WLTimer))
+            Start = Start >> 3;
+
+        BatchTag[BatchCount].Area=Item->Area;
+        BatchTag[BatchCount].DBNumber=(Item->Area==S7AreaDB) ? SwapWord(Item->DBNumber) : 0;
+        BatchTag[BatchCount].Start=Start;
+        BatchTag[BatchCount].Size=SwapWord(Item->Length);
+        BatchTag[BatchCount].WordLen=Item->TransportSize;
+        BatchData[BatchCount]=&BatchBuffer[Used];
+        BatchItem[BatchCount]=c;
+        BatchCount++;
+        Used+=Size;
+    }
+    memset(BatchBuffer, 0, Used);
+    BatchRead=(BatchCount>0) && FServer->DoRWAreas(ClientHandle, OperationRead, BatchCount, &BatchTag[0], &BatchData[0]);
+}
+//------------------------------------------------------------------------------
+bool TS7Worker::ReadAreaData(int Item, PS7Tag Tag, void *pUsrData, longword Size)
+{
+    int c;
+    if (BatchRead)
+    {
+        for (c = 0; c < BatchCount; c++)
+        {
+            if (BatchItem[c]==Item)
+            {
+                memcpy(pUsrData, BatchData[c], Size);
+                return true;
+            }
+        }
+    }
+    return FServer->DoReadArea(ClientHandle, Tag->Area, Tag->DBNumber, Tag->Start, Tag->Size, Tag->WordLen, pUsrData);
+}
+//------------------------------------------------------------------------------
 word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar,
-     int &PDURemainder, TEv &EV)
+     int &PDURemainder, TEv &EV, int Item)
 {
     PS7Area P;
 	word DBNum = 0;
@@ -333,6 +403,7 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
 	int Multiplier;
     void *Source = NULL;
     PSnapCriticalSection pcs;
+    TS7Tag Tag;
 
     P=NULL;
     EV.EvStart   =0;
@@ -429,7 +500,12 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
 	if (FServer->ResourceLess)
 	{
 		memset(&ResItemData->Data, 0, Size);
-		if (!FServer->DoReadArea(ClientHandle, EV.EvArea, EV.EvIndex, AStart, Elements, ReqItemPar->TransportSize, &ResItemData->Data))
+		Tag.Area=EV.EvArea;
+		Tag.DBNumber=EV.EvIndex;
+		Tag.Start=AStart;
+		Tag.Size=Elements;
+		Tag.WordLen=ReqItemPar->TransportSize;
+		if (!ReadAreaData(Item, &Tag, &ResItemData->Data, Size))
 			return RA_NotFound(ResItemData, EV);
 	}
 	else
@@ -518,13 +594,18 @@ bool TS7Worker::PerformFunctionRead()
 
     ItemsCount=ReqParams->ItemsCount;
 
+    // All the items in one callback, values from the same scan
+    BatchRead=false;
+    if (FServer->ResourceLess && (FServer->OnRWAreas!=NULL) && (ItemsCount>1))
+        BatchReadItems(ReqParams, ItemsCount);
+
     // Stage 2 : gather data
     Offset=sizeof(TResFunReadParams);      // = 2
 
     for (c = 0; c < ItemsCount; c++)
 	{
 		ResData[c]=PResFunReadItem(pbyte(ResParams)+Offset);
-		ItemSize=ReadArea(ResData[c],&ReqParams->Items[c],PDURemainder, EV);
+		ItemSize=ReadArea(ResData[c],&ReqParams->Items[c],PDURemainder, EV, c);
 
         // S7 doesn't xfer odd byte amount
         if ((c<ItemsCount-1) && (ItemSize % 2 != 0))
@@ -584,8 +665,24 @@ byte TS7Worker::WA_DataSizeMismatch(TEv &EV)
     return Code7WriteDataSizeMismatch;
 }
 //------------------------------------------------------------------------------
+void TS7Worker::BatchWriteItems(PResFunWrite ResData)
+{
+    int c;
+    if (BatchCount==0)
+        return;
+    if (FServer->DoRWAreas(ClientHandle, OperationWrite, BatchCount, &BatchTag[0], &BatchData[0]))
+        return;
+    // Refused as a whole, write the items one by one
+    for (c = 0; c < BatchCount; c++)
+    {
+        if (!FServer->DoWriteArea(ClientHandle, BatchTag[c].Area, BatchTag[c].DBNumber, BatchTag[c].Start,
+              BatchTag[c].Size, BatchTag[c].WordLen, BatchData[c]))
+            ResData->Data[BatchItem[c]]=Code7ResItemNotAvailable;
+    }
+}
+//------------------------------------------------------------------------------
 byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem ReqItemPar,
-     TEv &EV)
+     TEv &EV, int Item)
 {
 	int Multiplier;
     PS7Area P = NULL;
@@ -685,6 +782,19 @@ byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem Req
 	if (DataLen!=Size)
         return WA_DataSizeMismatch(EV);
 
+	if (FServer->ResourceLess && BatchWrite)
+	{
+		// Written with the other items of the PDU by BatchWriteItems()
+		BatchTag[BatchCount].Area=EV.EvArea;
+		BatchTag[BatchCount].DBNumber=EV.EvIndex;
+		BatchTag[BatchCount].Start=AStart;
+		BatchTag[BatchCount].Size=Elements;
+		BatchTag[BatchCount].WordLen=ReqItemPar->TransportSize;
+		BatchData[BatchCount]=&ReqItemData->Data[0];
+		BatchItem[BatchCount]=Item;
+		BatchCount++;
+	}
+	else
 	if (FServer->ResourceLess)
 	{
 		if (!FServer->DoWriteArea(ClientHandle, EV.EvArea, EV.EvIndex, AStart, Elements, ReqItemPar->TransportSize, &ReqItemData->Data[0]))
@@ -750,14 +860,21 @@ bool TS7Worker::PerformFunctionWrite()
 	ResData->FunWrite =pduFuncWrite;
 	ResData->ItemCount=ReqParams->ItemsCount;
 
-	// Stage 2 : Write data
+	// Stage 2 : Write data, all the valid items in one callback
+	BatchCount=0;
+	BatchWrite=FServer->ResourceLess && (FServer->OnRWAreas!=NULL) && (ItemsCount>1);
 	for (c = 0; c < ItemsCount; c++)
 	{
-	  ResData->Data[c]=WriteArea(ReqData[c],&ReqParams->Items[c], EV);
+	  ResData->Data[c]=WriteArea(ReqData[c],&ReqParams->Items[c], EV, c);
       // For multiple items we have to create multiple events
       if (ItemsCount>1)
            DoEvent(evcDataWrite,EV.EvRetCode,EV.EvArea,EV.EvIndex,EV.EvStart,EV.EvSize);
     }
+	if (BatchWrite)
+	{
+		BatchWriteItems(ResData);
+		BatchWrite=false;
+	}
 
     // Stage 3 : finalize the answer
     Answer.Header.P=0x32;
@@ -782,7 +899,7 @@ bool TS7Worker::PerformFunctionNegotiate()
 {
 	PReqFunNegotiateParams ReqParams;
 	PResFunNegotiateParams ResParams;
-	word ReqLen;
+	word ReqLen, Jobs;
 	TS7Answer23 Answer;
 	int Size;
 
@@ -800,23 +917,24 @@ bool TS7Worker::PerformFunctionNegotiate()
 	// Params point at the end of the header
 	ResParams->FunNegotiate=pduNegotiate;
 	ResParams->Unknown=0x0;
-	// We offer the same
-	ResParams->ParallelJobs_1=ReqParams->ParallelJobs_1;
-	ResParams->ParallelJobs_2=ReqParams->ParallelJobs_2;
-
-	if (FServer->ForcePDU == 0)
-	{
-		ReqLen = SwapWord(ReqParams->PDULength);
-		if (ReqLen<MinPduSize)
-			ResParams->PDULength = SwapWord(MinPduSize);
-		else
-			if (ReqLen>IsoPayload_Size)
-				ResParams->PDULength = SwapWord(IsoPayload_Size);
-			else
-				ResParams->PDULength = ReqParams->PDULength;
-	}
+	// We offer the same, up to MaxParallelJobs : requests sent without
+	// waiting for the answers are queued by the socket and served in order
+	Jobs=SwapWord(ReqParams->ParallelJobs_1);
+	ResParams->ParallelJobs_1=SwapWord(Jobs<1 ? 1 : (Jobs>MaxParallelJobs ? MaxParallelJobs : Jobs));
+	Jobs=SwapWord(ReqParams->ParallelJobs_2);
+	ResParams->ParallelJobs_2=SwapWord(Jobs<1 ? 1 : (Jobs>MaxParallelJobs ? MaxParallelJobs : Jobs));
+
+	// ForcePDU, if set, is the largest PDU we accept : a client must never
+	// get more than it proposed
+	ReqLen = SwapWord(ReqParams->PDULength);
+	if (ReqLen<MinPduSize)
+		ReqLen = MinPduSize;
 	else
-		ResParams->PDULength = SwapWord(FServer->ForcePDU);
+		if (ReqLen>IsoPayload_Size)
+			ReqLen = IsoPayload_Size;
+	if ((FServer->ForcePDU != 0) && (ReqLen > FServer->ForcePDU))
+		ReqLen = FServer->ForcePDU;
+	ResParams->PDULength = SwapWord(ReqLen);
 
 	FPDULength=SwapWord(ResParams->PDULength); // Stores the value
 	// Sends the answer
@@ -1733,6 +1851,8 @@ TSnap7Server::TSnap7Server()
 {
 	CSRWHook = new TSnapCriticalSection();
 	OnReadEvent=NULL;
+	OnRWArea=NULL;
+	OnRWAreas=NULL;
 	memset(&DB,0,sizeof(DB));
     memset(&HA,0,sizeof(HA));
     DBCount=0;
@@ -1933,6 +2053,12 @@ int TSnap7Server::GetParam(int ParamNumber, void *pValue)
 	case p_i32_MaxClients:
 	    *Pint32_t(pValue)=MaxClients;
 	    break;
+	case p_i32_IoThreads:
+	    *Pint32_t(pValue)=IoThreads;
+	    break;
+	case p_i32_WorkerPool:
+	    *Pint32_t(pValue)=WorkerPool;
+	    break;
 	case p_i32_PDURequest:
 		*Pint32_t(pValue) = ForcePDU;
 		break;
@@ -1962,7 +2088,7 @@ int TSnap7Server::SetParam(int ParamNumber, void *pValue)
 					if ((PDU < MinPduSize) || (PDU>IsoPayload_Size))
 						return errSrvInvalidParams; // Wrong value
 					else
-						ForcePDU = PDU; // The server imposes ForcePDU as PDU size
+						ForcePDU = PDU; // The server caps the client's proposal to ForcePDU
 				}
 	    }
 		else
@@ -1977,6 +2103,28 @@ int TSnap7Server::SetParam(int ParamNumber, void *pValue)
          else
 	         return errSrvCannotChangeParam;
          break;
+	case p_i32_IoThreads:
+	     if (Status==SrvStopped)
+	     {
+	         int Count=*Pint32_t(pValue);
+	         if ((Count<0) || (Count>MaxIoThreads))
+	             return errSrvInvalidParams;
+	         IoThreads=Count;
+	     }
+         else
+	         return errSrvCannotChangeParam;
+         break;
+	case p_i32_WorkerPool:
+	     if (Status==SrvStopped)
+	     {
+	         int Count=*Pint32_t(pValue);
+	         if ((Count<0) || (Count>MaxWorkerPool))
+	             return errSrvInvalidParams;
+	         WorkerPool=Count;
+	     }
+         else
+	         return errSrvCannotChangeParam;
+         break;
 	default: return errSrvInvalidParamNumber;
     }
     return 0;
@@ -2076,6 +2224,13 @@ int TSnap7Server::SetRWAreaCallBack(pfn_RWAreaCallBack PCallBack, void *UsrPtr)
 	return 0;
 }
 //---------------------------------------------------------------------------
+int TSnap7Server::SetRWAreasCallBack(pfn_RWAreasCallBack PCallBack, void *UsrPtr)
+{
+	OnRWAreas = PCallBack;
+	FRWAreasUsrPtr = UsrPtr;
+	return 0;
+}
+//---------------------------------------------------------------------------
 void TSnap7Server::DoReadEvent(int Sender, longword Code, word RetCode, word Param1,
   word Param2, word Param3, word Param4)
 {
@@ -2154,5 +2309,24 @@ bool TSnap7Server::DoWriteArea(int Sender, int Area, int DBNumber, int Start, in
 	}
 	return Result;
 }
+//---------------------------------------------------------------------------
+bool TSnap7Server::DoRWAreas(int Sender, int Operation, int ItemsCount, PS7Tag PTags, void **pUsrData)
+{
+	bool Result = false;
+	if (!Destroying && (OnRWAreas != NULL))
+	{
+		CSRWHook->Enter();
+		try
+		{ // callback is outside here, we have to shield it
+			Result = OnRWAreas(FRWAreasUsrPtr, Sender, Operation, ItemsCount, PTags, pUsrData) == 0;
+		}
+		catch (...)
+		{
+			Result = false;
+		};
+		CSRWHook->Leave();
+	}
+	return Result;
+}
 
 
@@ -37,6 +37,7 @@
 #define MaxDB 2048    // Like a S7 318
 #define MinPduSize 240
 #define CPU315PduSize 240
+#define MaxParallelJobs 8 // Outstanding jobs offered to a client (S7-1500 style)
 //---------------------------------------------------------------------------
 // Server Interface errors
 const longword errSrvDBNullPointer      = 0x00200000; // Pssed null as PData
@@ -120,6 +121,15 @@ private:
 	int DBCnt;
     byte LastBlk;
     TSZL SZL;
+    // Items of the current multi-item Read/Write PDU handed to the batch
+    // callback in one call. BatchItem[i] is the PDU item of BatchTag[i].
+    TS7Tag BatchTag[MaxVars];
+    void  *BatchData[MaxVars];
+    int    BatchItem[MaxVars];
+    int    BatchCount;
+    bool   BatchRead;   // BatchData holds the values read for the PDU
+    bool   BatchWrite;  // WriteArea queues the items instead of writing them
+    byte   BatchBuffer[IsoPayload_Size];
     byte BCD(word Value);
     // Checks the consistence of the incoming PDU
     bool CheckPDU_in(int PayloadSize);
@@ -143,16 +153,19 @@ protected:
     // Group Read Area
     bool PerformFunctionRead();
     // Subfunctions Read Data
+    void BatchReadItems(PReqFunReadParams ReqParams, int ItemsCount);
+    bool ReadAreaData(int Item, PS7Tag Tag, void *pUsrData, longword Size);
     word ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar,
-    int &PDURemainder,TEv &EV);
+    int &PDURemainder,TEv &EV, int Item);
     word RA_NotFound(PResFunReadItem ResItem, TEv &EV);
     word RA_OutOfRange(PResFunReadItem ResItem, TEv &EV);
     word RA_SizeOverPDU(PResFunReadItem ResItem, TEv &EV);
     // Group Write Area
     bool PerformFunctionWrite();
     // Subfunctions Write Data
+    void BatchWriteItems(PResFunWrite ResData);
     byte WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem ReqItemPar,
-         TEv &EV);
+         TEv &EV, int Item);
     byte WA_NotFound(TEv &EV);
     byte WA_InvalidTransportSize(TEv &EV);
     byte WA_OutOfRange(TEv &EV);
@@ -194,6 +207,7 @@ public:
     int FPDULength;
     TS7Worker();
     ~TS7Worker(){};
+    void Recycle();
 };
 
 typedef TS7Worker *PS7Worker;
@@ -203,6 +217,12 @@ typedef TS7Worker *PS7Worker;
 extern "C"
 {
 	typedef int (S7API *pfn_RWAreaCallBack)(void *usrPtr, int Sender, int Operation, PS7Tag PTag, void *pUsrData);
+	// Serves all the items of a multi-item Read or Write PDU in one call, so
+	// they can come from (or go to) the same PLC scan. Returns 0 if every
+	// item was served, otherwise the server repeats them one by one through
+	// the RWArea callback, which must be set too.
+	typedef int (S7API *pfn_RWAreasCallBack)(void *usrPtr, int Sender, int Operation, int ItemsCount,
+	  PS7Tag PTags, void **pUsrData);
 }
 const int OperationRead  = 0;
 const int OperationWrite = 1;
@@ -213,10 +233,12 @@ private:
     // Read Callback related
     pfn_SrvCallBack OnReadEvent;
 	pfn_RWAreaCallBack OnRWArea;
+	pfn_RWAreasCallBack OnRWAreas;
 	// Critical section to lock Read/Write Hook Area
 	PSnapCriticalSection CSRWHook;
 	void *FReadUsrPtr;
 	void *FRWAreaUsrPtr;
+	void *FRWAreasUsrPtr;
 	void DisposeAll();
     int FindFirstFreeDB();
     int IndexOfDB(word DBNumber);
@@ -238,6 +260,7 @@ protected:
       word Param2, word Param3, word Param4);
 	bool DoReadArea(int Sender, int Area, int DBNumber, int Start, int Size, int WordLen, void *pUsrData);
 	bool DoWriteArea(int Sender, int Area, int DBNumber, int Start, int Size, int WordLen, void *pUsrData);
+	bool DoRWAreas(int Sender, int Operation, int ItemsCount, PS7Tag PTags, void **pUsrData);
 public:
     int WorkInterval;
     byte CpuStatus;
@@ -253,6 +276,7 @@ public:
     // Sets Event callback
     int SetReadEventsCallBack(pfn_SrvCallBack PCallBack, void *UsrPtr);
 	int SetRWAreaCallBack(pfn_RWAreaCallBack PCallBack, void *UsrPtr);
+	int SetRWAreasCallBack(pfn_RWAreasCallBack PCallBack, void *UsrPtr);
     friend class TS7Worker;
 };
 typedef TSnap7Server *PSnap7Server;
@@ -170,6 +170,8 @@ const int p_i32_BSendTimeout    = 12;
 const int p_i32_BRecvTimeout    = 13;
 const int p_u32_RecoveryTime    = 14;
 const int p_u32_KeepAliveTime   = 15;
+const int p_i32_IoThreads       = 16; // Server : I/O thread pool size, 0 = thread per client
+const int p_i32_WorkerPool      = 17; // Server : idle workers kept for new connections
 
 // Bool param is passed as int32_t : 0->false, 1->true
 // String param (only set) is passed as pointer
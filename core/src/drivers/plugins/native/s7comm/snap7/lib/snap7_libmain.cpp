@@ -999,6 +999,14 @@ int S7API Srv_SetRWAreaCallback(S7Object Server, pfn_RWAreaCallBack pCallback, v
 	else
 		return errLibInvalidObject;
 }
+//---------------------------------------------------------------------------
+int S7API Srv_SetRWAreasCallback(S7Object Server, pfn_RWAreasCallBack pCallback, void *usrPtr)
+{
+	if (Server)
+		return PSnap7Server(Server)->SetRWAreasCallBack(pCallback, usrPtr);
+	else
+		return errLibInvalidObject;
+}
 //***************************************************************************
 // PARTNER
 //***************************************************************************
@@ -203,6 +203,13 @@ void TMsgSocket::SetSocket(socket_t s)
     Connected=FSocket!=INVALID_SOCKET;
 }
 //---------------------------------------------------------------------------
+void TMsgSocket::Recycle()
+{
+    DestroySocket();
+    Connected=false;
+    ClientHandle=0;
+}
+//---------------------------------------------------------------------------
 void TMsgSocket::DestroySocket()
 {
     if(FSocket != INVALID_SOCKET)
@@ -302,6 +302,9 @@ public:
         int SckListen();
         // Set an external socket reference (tipically from a listener)
         void SetSocket(socket_t s);
+        // Closes the connection and restores the state of a new worker, so
+        // that a server can hand the same object to the next client
+        virtual void Recycle();
         // Accepts an incoming connection returning a socket descriptor (server-side)
         socket_t SckAccept();
         // Pings the peer before connecting
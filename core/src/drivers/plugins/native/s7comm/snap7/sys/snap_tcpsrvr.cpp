@@ -25,6 +25,9 @@
 |=============================================================================*/
 
 #include "snap_tcpsrvr.h"
+#ifdef SNAP_EPOLL_SERVER
+#include <sys/epoll.h>
+#endif
 //---------------------------------------------------------------------------
 // EVENTS QUEUE
 //---------------------------------------------------------------------------
@@ -102,9 +105,31 @@ TMsgWorkerThread::TMsgWorkerThread(TMsgSocket *Socket, TCustomMsgServer *Server)
     FreeOnTerminate = true;
     WorkerSocket = Socket;
     FServer = Server;
+    FAssigned = new TSnapEvent(false);
 }
 //---------------------------------------------------------------------------
-void TMsgWorkerThread::Execute() 
+TMsgWorkerThread::~TMsgWorkerThread()
+{
+    delete FAssigned;
+}
+//---------------------------------------------------------------------------
+void TMsgWorkerThread::Execute()
+{
+    // An idle thread waits for its first connection
+    if (WorkerSocket == NULL)
+        FAssigned->WaitForever();
+    // Woken up without a connection means that the pool is stopping, the
+    // thread must not touch the server any more
+    while (WorkerSocket != NULL)
+    {
+        Serve();
+        if (!FServer->ParkThread(this))
+            break;
+        FAssigned->WaitForever();
+    }
+}
+//---------------------------------------------------------------------------
+void TMsgWorkerThread::Serve()
 {
     bool Exception = false;
     bool SelfClose = false;
@@ -136,9 +161,6 @@ void TMsgWorkerThread::Execute()
         else
             FServer->DoEvent(WorkerSocket->ClientHandle, evcClientTerminated, 0, 0, 0, 0, 0);
     }
-    delete WorkerSocket;
-    // Delete reference from list
-    FServer->Delete(Index);
 }
 //---------------------------------------------------------------------------
 // LISTENER THREAD
@@ -176,6 +198,28 @@ void TMsgListenerThread::Execute()
     }
 }
 //---------------------------------------------------------------------------
+// I/O THREAD
+//---------------------------------------------------------------------------
+TMsgIoThread::TMsgIoThread(TCustomMsgServer *Server)
+{
+    FServer = Server;
+    FreeOnTerminate = false;
+}
+//---------------------------------------------------------------------------
+void TMsgIoThread::Execute()
+{
+#ifdef SNAP_EPOLL_SERVER
+    epoll_event Event;
+    // One event per wait : a request that takes long to serve doesn't hold
+    // back other ready connections, the idle threads of the pool pick them up
+    while (!Terminated)
+    {
+        if (epoll_wait(FServer->FEpoll, &Event, 1, IoTimeout) == 1 && !Terminated)
+            FServer->ServeConnection(int(Event.data.u32));
+    }
+#endif
+}
+//---------------------------------------------------------------------------
 // TCP SERVER
 //---------------------------------------------------------------------------
 TCustomMsgServer::TCustomMsgServer() 
@@ -195,6 +239,13 @@ TCustomMsgServer::TCustomMsgServer()
     ClientsCount = 0;
     LocalBind = 0;
     MaxClients = MaxWorkers;
+    IoThreads = 0;
+    WorkerPool = 0;
+    FPooling = false;
+    FIdleCount = 0;
+    FFreeCount = 0;
+    FEpoll = -1;
+    FIoCount = 0;
     OnEvent = NULL;
 }
 //---------------------------------------------------------------------------
@@ -309,6 +360,183 @@ void TCustomMsgServer::KillAll()
     DoEvent(0, evcClientsDropped, 0, cnt, 0, 0, 0);
 }
 //---------------------------------------------------------------------------
+void TCustomMsgServer::StartIoThreads()
+{
+#ifdef SNAP_EPOLL_SERVER
+    int Count = IoThreads > MaxIoThreads ? MaxIoThreads : IoThreads;
+    if (Count <= 0)
+        return;
+    FEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (FEpoll < 0)
+        return; // Falls back to one thread per client
+    for (FIoCount = 0; FIoCount < Count; FIoCount++)
+    {
+        IoPool[FIoCount] = new TMsgIoThread(this);
+        IoPool[FIoCount]->Start();
+    }
+#endif
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::StopIoThreads()
+{
+#ifdef SNAP_EPOLL_SERVER
+    int c;
+    if (FEpoll < 0)
+        return;
+    for (c = 0; c < FIoCount; c++)
+        IoPool[c]->Terminate();
+    for (c = 0; c < FIoCount; c++)
+    {
+        if (IoPool[c]->WaitFor(ThTimeout) != WAIT_OBJECT_0)
+            IoPool[c]->Kill();
+        delete IoPool[c];
+        IoPool[c] = NULL;
+    }
+    FIoCount = 0;
+    // No thread is serving them now
+    for (c = 0; c < MaxWorkers; c++)
+    {
+        if (Workers[c] != 0)
+            CloseConnection(c, evcClientTerminated);
+    }
+    close(FEpoll);
+    FEpoll = -1;
+    ClientsCount = 0;
+#endif
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::ServeConnection(int Index)
+{
+#ifdef SNAP_EPOLL_SERVER
+    PWorkerSocket WorkerSocket = PWorkerSocket(Workers[Index]);
+    epoll_event Event;
+    bool Exception = false;
+    bool SelfClose = false;
+
+    try
+    {
+        // A client with parallel jobs sends the next requests without waiting
+        // for the answers, serve what is already queued before re-arming
+        for (int Served = 0; ; )
+        {
+            if (!WorkerSocket->Execute()) // False -> End of Activities
+            {
+                SelfClose = true;
+                break;
+            }
+            if ((++Served >= MaxIoBurst) || !WorkerSocket->CanRead(0))
+                break;
+        }
+    } catch (...)
+    {
+        Exception = true;
+    }
+
+    if (!Exception && !SelfClose)
+    {
+        // Wait for the next request
+        Event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        Event.data.u64 = 0;
+        Event.data.u32 = longword(Index);
+        if (epoll_ctl(FEpoll, EPOLL_CTL_MOD, IoSockets[Index], &Event) == 0)
+            return;
+        Exception = true;
+    }
+    if (Exception)
+        WorkerSocket->ForceClose();
+    CloseConnection(Index, Exception ? evcClientException : evcClientDisconnected);
+#endif
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::CloseConnection(int Index, longword Code)
+{
+    PWorkerSocket WorkerSocket = PWorkerSocket(Workers[Index]);
+    // DoEvent skips it if we are destroying
+    DoEvent(WorkerSocket->ClientHandle, Code, 0, 0, 0, 0, 0);
+    // Closing the socket removes it from the epoll set
+    ReleaseWorkerSocket(WorkerSocket);
+    Delete(Index);
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::StartWorkerPool()
+{
+    int Count = WorkerPool > MaxWorkerPool ? MaxWorkerPool : WorkerPool;
+    if (Count <= 0)
+        return;
+    // Allocated now, so the first connections find them ready
+    LockList();
+    FPooling = true;
+    while (FFreeCount < Count)
+        FreeSockets[FFreeCount++] = CreateWorkerSocket(INVALID_SOCKET);
+    // The I/O threads serve every connection, no worker thread is needed
+    if (FIoCount == 0)
+    {
+        while (FIdleCount < Count)
+        {
+            IdleThreads[FIdleCount] = new TMsgWorkerThread(NULL, this);
+            IdleThreads[FIdleCount++]->Start();
+        }
+    }
+    UnlockList();
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::StopWorkerPool()
+{
+    int c;
+    LockList();
+    // Workers that end their connection from now on are freed
+    FPooling = false;
+    for (c = 0; c < FIdleCount; c++)
+        IdleThreads[c]->FAssigned->Set(); // No connection, the thread ends
+    FIdleCount = 0;
+    for (c = 0; c < FFreeCount; c++)
+        delete FreeSockets[c];
+    FFreeCount = 0;
+    UnlockList();
+}
+//---------------------------------------------------------------------------
+PWorkerSocket TCustomMsgServer::AcquireWorkerSocket(socket_t Sock)
+{
+    PWorkerSocket WorkerSocket;
+    if (FFreeCount == 0)
+        return CreateWorkerSocket(Sock);
+    WorkerSocket = FreeSockets[--FFreeCount];
+    WorkerSocket->SetSocket(Sock);
+    return WorkerSocket;
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::ReleaseWorkerSocket(PWorkerSocket WorkerSocket)
+{
+    bool Pooled;
+    // Closing can wait for the peer, it's done outside the lock
+    WorkerSocket->Recycle();
+    LockList();
+    Pooled = FPooling && (FFreeCount < WorkerPool) && (FFreeCount < MaxWorkerPool);
+    if (Pooled)
+        FreeSockets[FFreeCount++] = WorkerSocket;
+    UnlockList();
+    if (!Pooled)
+        delete WorkerSocket;
+}
+//---------------------------------------------------------------------------
+bool TCustomMsgServer::ParkThread(PMsgWorkerThread Thread)
+{
+    bool Parked;
+    ReleaseWorkerSocket(Thread->WorkerSocket);
+    Thread->WorkerSocket = NULL;
+    LockList();
+    // Delete reference from list
+    Workers[Thread->Index] = 0;
+    ClientsCount--;
+    // A terminated thread ends, TerminateAll() waits for it
+    Parked = FPooling && !Thread->Terminated && (FIdleCount < WorkerPool) &&
+        (FIdleCount < MaxWorkerPool);
+    if (Parked)
+        IdleThreads[FIdleCount++] = Thread;
+    UnlockList();
+    return Parked;
+}
+//---------------------------------------------------------------------------
 bool TCustomMsgServer::CanAccept(socket_t Socket) 
 {
     return ((MaxClients == 0) || (ClientsCount < MaxClients));
@@ -369,6 +597,7 @@ void TCustomMsgServer::Incoming(socket_t Sock)
 {
     int idx;
     PWorkerSocket WorkerSocket;
+    PMsgWorkerThread Thread;
     longword ClientHandle = Msg_GetSockAddr(Sock);
 
     if (CanAccept(Sock))
@@ -378,16 +607,35 @@ void TCustomMsgServer::Incoming(socket_t Sock)
         idx = FirstFree();
         if (idx >= 0)
         {
-            // Creates the Worker and assigns it the connected socket
-            WorkerSocket = CreateWorkerSocket(Sock);
-            // Creates the Worker thread
-            Workers[idx] = new TMsgWorkerThread(WorkerSocket, this);
-            PMsgWorkerThread(Workers[idx])->Index = idx;
-            // Update the number
-            ClientsCount++;
-            // And Starts the worker
-            PMsgWorkerThread(Workers[idx])->Start();
-            DoEvent(WorkerSocket->ClientHandle, evcClientAdded, 0, 0, 0, 0, 0);
+            if (FIoCount > 0)
+                IncomingIo(idx, Sock);
+            else
+            {
+                // Takes a Worker and assigns it the connected socket
+                WorkerSocket = AcquireWorkerSocket(Sock);
+                if (FIdleCount > 0)
+                {
+                    // An idle thread of the pool serves it
+                    Thread = IdleThreads[--FIdleCount];
+                    Thread->WorkerSocket = WorkerSocket;
+                    Thread->Index = idx;
+                    Workers[idx] = Thread;
+                    ClientsCount++;
+                    DoEvent(WorkerSocket->ClientHandle, evcClientAdded, 0, 0, 0, 0, 0);
+                    Thread->FAssigned->Set();
+                }
+                else
+                {
+                    // Creates the Worker thread
+                    Workers[idx] = new TMsgWorkerThread(WorkerSocket, this);
+                    PMsgWorkerThread(Workers[idx])->Index = idx;
+                    // Update the number
+                    ClientsCount++;
+                    // And Starts the worker
+                    PMsgWorkerThread(Workers[idx])->Start();
+                    DoEvent(WorkerSocket->ClientHandle, evcClientAdded, 0, 0, 0, 0, 0);
+                }
+            }
         }
         else
         {
@@ -403,14 +651,44 @@ void TCustomMsgServer::Incoming(socket_t Sock)
     };
 }
 //---------------------------------------------------------------------------
+void TCustomMsgServer::IncomingIo(int Index, socket_t Sock)
+{
+#ifdef SNAP_EPOLL_SERVER
+    epoll_event Event;
+    // Takes a Worker and hands it to the I/O threads
+    PWorkerSocket WorkerSocket = AcquireWorkerSocket(Sock);
+    Workers[Index] = WorkerSocket;
+    IoSockets[Index] = Sock;
+    ClientsCount++;
+    DoEvent(WorkerSocket->ClientHandle, evcClientAdded, 0, 0, 0, 0, 0);
+
+    Event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    Event.data.u64 = 0;
+    Event.data.u32 = longword(Index);
+    if (epoll_ctl(FEpoll, EPOLL_CTL_ADD, Sock, &Event) != 0)
+    {
+        // The list is locked, Delete() would deadlock
+        DoEvent(WorkerSocket->ClientHandle, evcClientException, 0, 0, 0, 0, 0);
+        delete WorkerSocket;
+        Workers[Index] = 0;
+        ClientsCount--;
+    }
+#endif
+}
+//---------------------------------------------------------------------------
 int TCustomMsgServer::Start() 
 {
     int Result = 0;
     if (Status != SrvRunning)
     {
+        // The pools must be ready before the listener accepts the first client
+        StartIoThreads();
+        StartWorkerPool();
         Result = StartListener();
         if (Result != 0)
         {
+            StopWorkerPool();
+            StopIoThreads();
             DoEvent(0, evcListenerCannotStart, Result, 0, 0, 0, 0);
             Status = SrvError;
         }
@@ -443,8 +721,13 @@ void TCustomMsgServer::Stop()
         // Kills the listener
         delete SockListener;
 
-        // Terminate all client threads
-        TerminateAll();
+        // Ends the idle workers, and the busy ones at the end of their connection
+        StopWorkerPool();
+        // Terminate all clients
+        if (FIoCount > 0)
+            StopIoThreads();
+        else
+            TerminateAll();
 
         Status = SrvStopped;
         LocalBind = 0;
@@ -29,9 +29,17 @@
 #include "snap_msgsock.h"
 #include "snap_threads.h"
 //---------------------------------------------------------------------------
+// On Linux the server can serve all the connections from a small pool of
+// I/O threads waiting on an epoll set instead of one thread per client
+#if defined(__linux__)
+  #define SNAP_EPOLL_SERVER
+#endif
 
-#define MaxWorkers 1024
-#define MaxEvents  1500
+#define MaxWorkers   1024
+#define MaxEvents    1500
+#define MaxIoThreads 16
+#define MaxIoBurst   8    // Pipelined requests served per wake-up of an I/O thread
+#define MaxWorkerPool 64  // Idle workers kept ready for the next connections
 
 const int SrvStopped = 0;
 const int SrvRunning = 1;
@@ -61,6 +69,7 @@ const longword errSrvCannotStart      = 0x00100000;
 
 const longword ThTimeout   = 2000; // Thread timeout
 const longword WkTimeout   = 3000; // Workers termination timeout
+const int      IoTimeout   = 100;  // I/O threads epoll wait, to check Terminated
 
 #pragma pack(1)
 
@@ -110,16 +119,23 @@ typedef TMsgEventQueue *PMsgEventQueue;
 class TCustomMsgServer; // forward declaration
 
 // It's created when connection is accepted, it will interface with the client.
+// With a worker pool it doesn't end with the connection : it waits, idle in
+// the pool, until the server assigns it the next one.
 class TMsgWorkerThread : public TSnapThread
 {
 private:
         TCustomMsgServer *FServer;
+        // Set when a connection (or the end of the pool) is assigned
+        PSnapEvent FAssigned;
+        void Serve();
 protected:
         TMsgSocket *WorkerSocket;
 public:
         int Index;
         friend class TCustomMsgServer;
+        // Socket is NULL for a thread started idle in the pool
         TMsgWorkerThread(TMsgSocket *Socket, TCustomMsgServer *Server);
+        ~TMsgWorkerThread();
         void Execute();
 };
 typedef TMsgWorkerThread *PMsgWorkerThread;
@@ -138,6 +154,22 @@ public:
         void Execute();
 };
 typedef TMsgListenerThread *PMsgListenerThread;
+//---------------------------------------------------------------------------
+// I/O THREAD
+//---------------------------------------------------------------------------
+// Event-driven mode : each thread of the pool waits on the server's epoll set
+// and runs one Execute() of the worker socket that became readable.
+// Connections are armed one-shot, so a socket is never served by two threads
+// at the same time, and re-armed after every Execute().
+class TMsgIoThread : public TSnapThread
+{
+private:
+        TCustomMsgServer *FServer;
+public:
+        TMsgIoThread(TCustomMsgServer *Server);
+        void Execute();
+};
+typedef TMsgIoThread *PMsgIoThread;
 
 //---------------------------------------------------------------------------
 // TCP SERVER
@@ -165,11 +197,36 @@ private:
         void LockList();
         void UnlockList();
         int FirstFree();
+        // Event-driven mode
+        int FEpoll;
+        int FIoCount;
+        PMsgIoThread IoPool[MaxIoThreads];
+        socket_t IoSockets[MaxWorkers];
+        void StartIoThreads();
+        void StopIoThreads();
+        void ServeConnection(int Index);
+        void CloseConnection(int Index, longword Code);
+        void IncomingIo(int Index, socket_t Sock);
+        // Worker pool : idle worker threads and closed worker sockets, both
+        // handled under the list lock
+        bool FPooling;
+        int FIdleCount;
+        int FFreeCount;
+        PMsgWorkerThread IdleThreads[MaxWorkerPool];
+        PWorkerSocket FreeSockets[MaxWorkerPool];
+        void StartWorkerPool();
+        void StopWorkerPool();
+        // Called with the list locked
+        PWorkerSocket AcquireWorkerSocket(socket_t Sock);
+        void ReleaseWorkerSocket(PWorkerSocket WorkerSocket);
+        // Invoked by a Worker Thread at the end of a connection, false if
+        // the thread must end instead of waiting for the next one
+        bool ParkThread(PMsgWorkerThread Thread);
 protected:
         bool Destroying;
         // Critical section to lock Event activities
         PSnapCriticalSection CSEvent;
-	    // Workers list
+	    // Workers list (worker threads, or worker sockets in event-driven mode)
         void *Workers[MaxWorkers];
         // Terminates all worker threads
         virtual void TerminateAll();
@@ -190,6 +247,7 @@ protected:
 public:
         friend class TMsgWorkerThread;
         friend class TMsgListenerThread;
+        friend class TMsgIoThread;
         word LocalPort;
         longword LocalBind;
         longword LogMask;
@@ -197,6 +255,13 @@ public:
         int Status;
         int ClientsCount;
         int MaxClients;
+        // Size of the I/O thread pool, 0 (or a platform without epoll) means
+        // one worker thread per client. Read by Start().
+        int IoThreads;
+        // Workers kept ready for the next connections (worker sockets, and
+        // worker threads without the I/O thread pool), 0 frees every worker
+        // at the end of its connection. Read by Start().
+        int WorkerPool;
         TCustomMsgServer();
         virtual ~TCustomMsgServer();
         // Starts the server
@@ -0,0 +1,372 @@
+/**
+ * @file s7comm_master_config.c
+ * @brief S7Comm Master Plugin Configuration Parser Implementation
+ *
+ * Parses JSON configuration files using cJSON library.
+ */
+
+#include "s7comm_master_config.h"
+#include "cJSON.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Error codes */
+#define S7COMM_MASTER_CONFIG_OK              0
+#define S7COMM_MASTER_CONFIG_ERR_FILE       -1
+#define S7COMM_MASTER_CONFIG_ERR_PARSE      -2
+#define S7COMM_MASTER_CONFIG_ERR_MEMORY     -3
+#define S7COMM_MASTER_CONFIG_ERR_INVALID    -4
+
+/* Snap7 connection types (CONNTYPE_* of s7_micro_client.h) */
+#define S7COMM_MASTER_CONNTYPE_PG       1
+#define S7COMM_MASTER_CONNTYPE_OP       2
+#define S7COMM_MASTER_CONNTYPE_BASIC    3
+
+/**
+ * @brief Read entire file into a string
+ */
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0 || size > 1024 * 1024) { /* Max 1MB config file */
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(size + 1);
+    if (buffer == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    fclose(fp);
+
+    if ((long)read_size != size) {
+        free(buffer);
+        return NULL;
+    }
+
+    buffer[size] = '\0';
+    return buffer;
+}
+
+/**
+ * @brief Safely copy string with length limit
+ */
+static void safe_strcpy(char *dest, const char *src, size_t max_len)
+{
+    if (src == NULL) {
+        dest[0] = '\0';
+        return;
+    }
+    strncpy(dest, src, max_len - 1);
+    dest[max_len - 1] = '\0';
+}
+
+/**
+ * @brief Get string value from JSON object
+ */
+static const char *get_string(const cJSON *obj, const char *key, const char *default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsString(item) && item->valuestring != NULL) {
+        return item->valuestring;
+    }
+    return default_val;
+}
+
+/**
+ * @brief Get integer value from JSON object
+ */
+static int get_int(const cJSON *obj, const char *key, int default_val)
+{
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    if (cJSON_IsNumber(item)) {
+        return item->valueint;
+    }
+    return default_val;
+}
+
+int s7comm_master_parse_iec_location(const char *str, s7comm_master_iec_location_t *location)
+{
+    if (str == NULL || location == NULL) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    while (isspace((unsigned char)*str)) {
+        str++;
+    }
+    if (str[0] != '%') {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    char area = (char)toupper((unsigned char)str[1]);
+    char size = (char)toupper((unsigned char)str[2]);
+    if (strchr("IQM", area) == NULL || area == '\0' || strchr("XBWDL", size) == NULL || size == '\0') {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    const char *p = str + 3;
+    if (!isdigit((unsigned char)*p)) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    char *end = NULL;
+    long index = strtol(p, &end, 10);
+
+    long bit = 0;
+    if (size == 'X') {
+        if (*end != '.' || !isdigit((unsigned char)end[1])) {
+            return S7COMM_MASTER_CONFIG_ERR_INVALID;
+        }
+        bit = strtol(end + 1, &end, 10);
+        if (bit > 7) {
+            return S7COMM_MASTER_CONFIG_ERR_INVALID;
+        }
+    }
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0' || index > 0xFFFF) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    location->area = area;
+    location->size = size;
+    location->index = (int)index;
+    location->bit = (int)bit;
+    return S7COMM_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief Parse an S7 area name ("DB", "I", "Q" or "M")
+ *
+ * @return 0 on success, negative error code if the name is unknown
+ */
+static int parse_area(const char *str, s7comm_master_area_t *area)
+{
+    if (str == NULL) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    if (strcmp(str, "DB") == 0) {
+        *area = S7COMM_MASTER_AREA_DB;
+    } else if (strcmp(str, "I") == 0) {
+        *area = S7COMM_MASTER_AREA_I;
+    } else if (strcmp(str, "Q") == 0) {
+        *area = S7COMM_MASTER_AREA_Q;
+    } else if (strcmp(str, "M") == 0) {
+        *area = S7COMM_MASTER_AREA_M;
+    } else {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    return S7COMM_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief Parse a connection type name, -1 if unknown
+ */
+static int parse_connection_type(const char *str)
+{
+    if (strcmp(str, "PG") == 0) {
+        return S7COMM_MASTER_CONNTYPE_PG;
+    }
+    if (strcmp(str, "OP") == 0) {
+        return S7COMM_MASTER_CONNTYPE_OP;
+    }
+    if (strcmp(str, "BASIC") == 0) {
+        return S7COMM_MASTER_CONNTYPE_BASIC;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parse one entry of tags
+ */
+static int parse_tag(const cJSON *json, int default_cycle_time_ms, s7comm_master_tag_t *tag)
+{
+    const cJSON *iec = cJSON_GetObjectItemCaseSensitive(json, "iec_location");
+    const char *direction = get_string(json, "direction", "read");
+
+    /* area, start, iec_location and len are required, db too for DB tags */
+    safe_strcpy(tag->name, get_string(json, "name", ""), S7COMM_MASTER_MAX_STRING_LEN);
+    if (parse_area(get_string(json, "area", NULL), &tag->area) != 0) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    tag->db_number = get_int(json, "db", tag->area == S7COMM_MASTER_AREA_DB ? -1 : 0);
+    tag->start = get_int(json, "start", -1);
+    tag->bit = get_int(json, "bit", 0);
+    tag->length = get_int(json, "len", 0);
+    tag->cycle_time_ms = get_int(json, "cycle_time_ms", default_cycle_time_ms);
+
+    if (strcmp(direction, "read") == 0) {
+        tag->write = false;
+    } else if (strcmp(direction, "write") == 0) {
+        tag->write = true;
+    } else {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    if (!cJSON_IsString(iec) ||
+        s7comm_master_parse_iec_location(iec->valuestring, &tag->iec_location) != 0) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    if (tag->iec_location.size != 'X' && tag->bit != 0) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    return S7COMM_MASTER_CONFIG_OK;
+}
+
+/**
+ * @brief Parse one device entry
+ */
+static int parse_device(const cJSON *json, s7comm_master_device_t *device)
+{
+    safe_strcpy(device->name, get_string(json, "name", "UNDEFINED"), S7COMM_MASTER_MAX_STRING_LEN);
+    safe_strcpy(device->host, get_string(json, "host", "127.0.0.1"), S7COMM_MASTER_MAX_STRING_LEN);
+    int port = get_int(json, "port", S7COMM_MASTER_DEFAULT_PORT);
+    device->port = (port > 0 && port <= 0xFFFF) ? (uint16_t)port : 0;
+    device->rack = get_int(json, "rack", S7COMM_MASTER_DEFAULT_RACK);
+    device->slot = get_int(json, "slot", S7COMM_MASTER_DEFAULT_SLOT);
+    device->connection_type = parse_connection_type(get_string(json, "connection_type", "PG"));
+    device->timeout_ms = get_int(json, "timeout_ms", S7COMM_MASTER_DEFAULT_TIMEOUT_MS);
+    device->pdu_size = get_int(json, "pdu_size", S7COMM_MASTER_DEFAULT_PDU_SIZE);
+    device->max_read_gap = get_int(json, "max_read_gap", S7COMM_MASTER_DEFAULT_MAX_READ_GAP);
+    int cycle_time_ms = get_int(json, "cycle_time_ms", S7COMM_MASTER_DEFAULT_CYCLE_TIME_MS);
+
+    const cJSON *tags = cJSON_GetObjectItemCaseSensitive(json, "tags");
+    int count = cJSON_IsArray(tags) ? cJSON_GetArraySize(tags) : 0;
+    if (count > S7COMM_MASTER_MAX_TAGS) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+    if (count == 0) {
+        return S7COMM_MASTER_CONFIG_OK;
+    }
+
+    device->tags = (s7comm_master_tag_t *)calloc((size_t)count, sizeof(s7comm_master_tag_t));
+    if (device->tags == NULL) {
+        return S7COMM_MASTER_CONFIG_ERR_MEMORY;
+    }
+
+    const cJSON *tag = NULL;
+    cJSON_ArrayForEach(tag, tags) {
+        int result = parse_tag(tag, cycle_time_ms, &device->tags[device->num_tags]);
+        if (result != S7COMM_MASTER_CONFIG_OK) {
+            return result;
+        }
+        device->num_tags++;
+    }
+    return S7COMM_MASTER_CONFIG_OK;
+}
+
+int s7comm_master_config_parse(const char *config_path, s7comm_master_config_t *config)
+{
+    if (config_path == NULL || config == NULL) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    memset(config, 0, sizeof(s7comm_master_config_t));
+
+    /* Read file contents */
+    char *json_str = read_file(config_path);
+    if (json_str == NULL) {
+        return S7COMM_MASTER_CONFIG_ERR_FILE;
+    }
+
+    /* Parse JSON */
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+
+    if (root == NULL) {
+        return S7COMM_MASTER_CONFIG_ERR_PARSE;
+    }
+
+    const cJSON *devices = cJSON_GetObjectItemCaseSensitive(root, "devices");
+    if (!cJSON_IsArray(devices) || cJSON_GetArraySize(devices) > S7COMM_MASTER_MAX_DEVICES) {
+        cJSON_Delete(root);
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    /* Parse each device */
+    const cJSON *device = NULL;
+    cJSON_ArrayForEach(device, devices) {
+        int result = parse_device(device, &config->devices[config->num_devices]);
+        config->num_devices++;
+        if (result != S7COMM_MASTER_CONFIG_OK) {
+            cJSON_Delete(root);
+            return result;
+        }
+    }
+
+    cJSON_Delete(root);
+
+    /* Validate the parsed configuration */
+    return s7comm_master_config_validate(config);
+}
+
+int s7comm_master_config_validate(const s7comm_master_config_t *config)
+{
+    if (config == NULL || config->num_devices == 0) {
+        return S7COMM_MASTER_CONFIG_ERR_INVALID;
+    }
+
+    for (int i = 0; i < config->num_devices; i++) {
+        const s7comm_master_device_t *device = &config->devices[i];
+
+        if (strcmp(device->name, "UNDEFINED") == 0 || device->port == 0 || device->timeout_ms <= 0) {
+            return S7COMM_MASTER_CONFIG_ERR_INVALID;
+        }
+        if (device->rack < 0 || device->rack > 7 || device->slot < 0 || device->slot > 31 ||
+            device->connection_type < 0) {
+            return S7COMM_MASTER_CONFIG_ERR_INVALID;
+        }
+        if (device->pdu_size < S7COMM_MASTER_MIN_PDU_SIZE || device->pdu_size > S7COMM_MASTER_MAX_PDU_SIZE ||
+            device->max_read_gap < 0) {
+            return S7COMM_MASTER_CONFIG_ERR_INVALID;
+        }
+
+        for (int t = 0; t < device->num_tags; t++) {
+            const s7comm_master_tag_t *tag = &device->tags[t];
+            if (tag->length <= 0 || tag->cycle_time_ms <= 0 || tag->start < 0 || tag->start > 0xFFFF ||
+                tag->bit < 0 || tag->bit > 7) {
+                return S7COMM_MASTER_CONFIG_ERR_INVALID;
+            }
+            if (tag->area == S7COMM_MASTER_AREA_DB && (tag->db_number <= 0 || tag->db_number > 0xFFFF)) {
+                return S7COMM_MASTER_CONFIG_ERR_INVALID;
+            }
+        }
+
+        /* Names must be unique */
+        for (int j = 0; j < i; j++) {
+            if (strcmp(device->name, config->devices[j].name) == 0) {
+                return S7COMM_MASTER_CONFIG_ERR_INVALID;
+            }
+        }
+    }
+
+    return S7COMM_MASTER_CONFIG_OK;
+}
+
+void s7comm_master_config_free(s7comm_master_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < config->num_devices; i++) {
+        free(config->devices[i].tags);
+        config->devices[i].tags = NULL;
+        config->devices[i].num_tags = 0;
+    }
+    config->num_devices = 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file s7comm_master_config.h
+ * @brief S7Comm Master Plugin Configuration Structures and Parser
+ *
+ * Reads s7comm_master_config.json: a list of remote S7 PLCs, each with the
+ * tags to read from or write to it.
+ */
+
+#ifndef S7COMM_MASTER_CONFIG_H
+#define S7COMM_MASTER_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Configuration limits */
+#define S7COMM_MASTER_MAX_DEVICES       32
+#define S7COMM_MASTER_MAX_TAGS          1024    /* Per device */
+#define S7COMM_MASTER_MAX_STRING_LEN    64
+#define S7COMM_MASTER_MIN_PDU_SIZE      240
+#define S7COMM_MASTER_MAX_PDU_SIZE      960
+
+/* Default values */
+#define S7COMM_MASTER_DEFAULT_PORT          102
+#define S7COMM_MASTER_DEFAULT_RACK          0
+#define S7COMM_MASTER_DEFAULT_SLOT          1
+#define S7COMM_MASTER_DEFAULT_TIMEOUT_MS    1000
+#define S7COMM_MASTER_DEFAULT_CYCLE_TIME_MS 1000
+#define S7COMM_MASTER_DEFAULT_PDU_SIZE      480
+#define S7COMM_MASTER_DEFAULT_MAX_READ_GAP  16
+
+/**
+ * @brief S7 memory area of a tag
+ */
+typedef enum {
+    S7COMM_MASTER_AREA_DB = 0,      /* Data block */
+    S7COMM_MASTER_AREA_I,           /* Process inputs (PE) */
+    S7COMM_MASTER_AREA_Q,           /* Process outputs (PA) */
+    S7COMM_MASTER_AREA_M            /* Merkers (MK) */
+} s7comm_master_area_t;
+
+/**
+ * @brief Parsed IEC location such as %IX0.3 or %MD10
+ */
+typedef struct {
+    char area;                      /* 'I', 'Q' or 'M' */
+    char size;                      /* 'X', 'B', 'W', 'D' or 'L' */
+    int index;                      /* Image table index (number after the size letter) */
+    int bit;                        /* Bit of the index for 'X', else 0 */
+} s7comm_master_iec_location_t;
+
+/**
+ * @brief One read or written range of a remote PLC
+ *
+ * The remote range starts at byte `start` (bit `bit` for BOOL tags) of the
+ * area and holds `length` IEC elements: bits for %xX locations, else 1, 2,
+ * 4 or 8 bytes per element in S7 (big-endian) byte order.
+ */
+typedef struct {
+    char name[S7COMM_MASTER_MAX_STRING_LEN];
+    s7comm_master_area_t area;
+    int db_number;                              /* DB areas only */
+    int start;                                  /* First byte */
+    int bit;                                    /* First bit of a BOOL tag, else 0 */
+    s7comm_master_iec_location_t iec_location;  /* First IEC element */
+    int length;                                 /* Number of IEC elements */
+    bool write;                                 /* Written to the PLC, else read */
+    int cycle_time_ms;                          /* Polling period */
+} s7comm_master_tag_t;
+
+/**
+ * @brief One remote S7 PLC
+ */
+typedef struct {
+    char name[S7COMM_MASTER_MAX_STRING_LEN];
+    char host[S7COMM_MASTER_MAX_STRING_LEN];
+    uint16_t port;
+    int rack;
+    int slot;
+    int connection_type;                        /* CONNTYPE_PG, CONNTYPE_OP or CONNTYPE_BASIC */
+    int timeout_ms;                             /* Connect and response timeout */
+    int pdu_size;                               /* PDU length requested when connecting */
+    int max_read_gap;                           /* Unconfigured bytes a merged read may span */
+    s7comm_master_tag_t *tags;                  /* Allocated by the parser */
+    int num_tags;
+} s7comm_master_device_t;
+
+/**
+ * @brief Complete S7 master configuration
+ */
+typedef struct {
+    s7comm_master_device_t devices[S7COMM_MASTER_MAX_DEVICES];
+    int num_devices;
+} s7comm_master_config_t;
+
+/**
+ * @brief Parse configuration from JSON file
+ *
+ * @param config_path Path to the JSON configuration file
+ * @param config Pointer to configuration structure to populate; release it
+ *               with s7comm_master_config_free() even on failure
+ * @return 0 on success, negative error code on failure
+ */
+int s7comm_master_config_parse(const char *config_path, s7comm_master_config_t *config);
+
+/**
+ * @brief Validate configuration values
+ *
+ * @param config Pointer to configuration structure to validate
+ * @return 0 if valid, negative error code indicating the issue
+ */
+int s7comm_master_config_validate(const s7comm_master_config_t *config);
+
+/**
+ * @brief Release the tag arrays of a parsed configuration
+ */
+void s7comm_master_config_free(s7comm_master_config_t *config);
+
+/**
+ * @brief Parse an IEC location string ("%QX0.1", "%IW3", ...)
+ *
+ * @return 0 on success, negative error code if the string is invalid
+ */
+int s7comm_master_parse_iec_location(const char *str, s7comm_master_iec_location_t *location);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* S7COMM_MASTER_CONFIG_H */
@@ -0,0 +1,1177 @@
+/**
+ * @file s7comm_master_plugin.cpp
+ * @brief Native S7 Client (Master) Plugin Implementation
+ *
+ * Each device is polled by its own thread with its own Snap7 micro client,
+ * on a tick of the GCD of its cycle times. Per tick, the tags that are due
+ * are planned into as few requests as the negotiated PDU allows:
+ *
+ * - Read tags of the same area (and DB) are merged into one range when they
+ *   overlap or are at most max_read_gap bytes apart, since an item costs
+ *   more telegram bytes than a short gap.
+ * - Ranges are cut into items that fit a PDU, then packed first-fit
+ *   decreasing into ReadMultiVars / WriteMultiVars requests of at most 20
+ *   items whose request and response both fit the PDU.
+ *
+ * Read results are stored with one journal range write per tag and written
+ * values come from the runtime's lock-free snapshot, so the device threads
+ * never wait for the scan.
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <time.h>
+
+/* Snap7 includes */
+#include "s7_micro_client.h"
+#include "s7_text.h"
+
+/* Plugin includes */
+extern "C" {
+#include "bit_pack.h"
+#include "image_read.h"
+#include "plugin_logger.h"
+#include "plugin_types.h"
+#include "s7comm_master_plugin.h"
+#include "s7comm_master_config.h"
+}
+
+/*
+ * =============================================================================
+ * Constants
+ * =============================================================================
+ */
+
+/* Journal buffer types (matching journal_buffer_type_t) */
+#define S7M_TYPE_BOOL_INPUT     0
+#define S7M_TYPE_BOOL_OUTPUT    1
+#define S7M_TYPE_BOOL_MEMORY    2
+#define S7M_TYPE_BYTE_INPUT     3
+#define S7M_TYPE_BYTE_OUTPUT    4
+#define S7M_TYPE_INT_INPUT      5
+#define S7M_TYPE_INT_OUTPUT     6
+#define S7M_TYPE_INT_MEMORY     7
+#define S7M_TYPE_DINT_INPUT     8
+#define S7M_TYPE_DINT_OUTPUT    9
+#define S7M_TYPE_DINT_MEMORY    10
+#define S7M_TYPE_LINT_INPUT     11
+#define S7M_TYPE_LINT_OUTPUT    12
+#define S7M_TYPE_LINT_MEMORY    13
+
+/* Telegram sizes of ReadVar / WriteVar (see opReadMultiVars, opWriteMultiVars) */
+#define S7M_REQUEST_HEADER      12  /* S7 header and function, item count */
+#define S7M_RESPONSE_HEADER     14  /* S7 header with error code and function, item count */
+#define S7M_ITEM_ADDRESS        12  /* Address of one item in a request */
+#define S7M_ITEM_DATA_HEADER    4   /* Return code, transport size and length of item data */
+
+/* Items per request of the micro client (MaxVars) */
+#define S7M_MAX_ITEMS           20
+
+/* Reconnect backoff (same as the Modbus master) */
+#define S7M_RETRY_DELAY_BASE_MS 2000
+#define S7M_RETRY_DELAY_MAX_MS  30000
+
+/*
+ * =============================================================================
+ * Types
+ * =============================================================================
+ */
+
+/**
+ * @brief A tag prepared for polling
+ */
+typedef struct {
+    const s7comm_master_tag_t *config;
+    int journal_type;
+    int s7_area;                    /* S7AreaDB, S7AreaPE, S7AreaPA or S7AreaMK */
+    int num_bytes;                  /* Remote bytes covered, from config->start */
+    bool bit_items;                 /* Written one S7WLBit item per bit */
+    int period;                     /* Polled every `period` ticks */
+} s7m_tag_t;
+
+/**
+ * @brief Remote bytes read or written for one or more tags of a tick
+ */
+typedef struct {
+    int s7_area;
+    int db_number;
+    int start;                      /* First byte, bit address for a bit item */
+    int size;                       /* Bytes */
+    bool bit;                       /* A single S7WLBit item */
+    int offset;                     /* Of its bytes in the device's data buffer */
+    int first_member;               /* Index into the device's members */
+    int num_members;
+    bool failed;
+} s7m_range_t;
+
+/**
+ * @brief Part of a range that fits in one request item
+ */
+typedef struct {
+    int range;
+    int offset;                     /* Within the range */
+    int size;
+    int request;                    /* Request it is packed into */
+} s7m_chunk_t;
+
+/**
+ * @brief Telegram bytes and items of one request being packed
+ */
+typedef struct {
+    int num_items;
+    int request_bytes;
+    int response_bytes;
+    int first_item;
+} s7m_request_t;
+
+typedef struct {
+    const s7comm_master_device_t *config;
+    s7m_tag_t *tags;                /* Sorted by direction, area, DB, start */
+    int num_tags;
+    int tick_ms;
+
+    TSnap7MicroClient *client;
+    bool connected;
+    int pdu_length;                 /* Negotiated on connect */
+    int retry_delay_ms;
+
+    /* Per-tick scratch, sized in setup_device for the smallest PDU */
+    s7m_range_t *ranges;
+    int *members;
+    s7m_chunk_t *chunks;
+    s7m_request_t *requests;
+    TS7DataItem *items;
+    int *item_chunks;
+    uint8_t *data;
+    uint64_t *elements;             /* One tag converted to or from S7 byte order */
+
+    pthread_t thread;
+    bool thread_started;
+} s7m_device_t;
+
+/* Plugin state */
+static plugin_logger_t g_logger;
+static plugin_runtime_args_t g_runtime_args;
+static s7comm_master_config_t g_config;
+static s7m_device_t g_devices[S7COMM_MASTER_MAX_DEVICES];
+static int g_num_devices = 0;
+static bool g_initialized = false;
+static volatile bool g_running = false;
+
+/* Wakes the device threads when stopping */
+static pthread_mutex_t g_stop_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stop_cond;
+
+/*
+ * =============================================================================
+ * IEC Locations
+ * =============================================================================
+ */
+
+/**
+ * @brief Journal buffer type of an IEC location, -1 if it has none (%MB)
+ */
+static int journal_type_of(const s7comm_master_iec_location_t *location)
+{
+    static const int types[3][5] = {
+        /*        X                     B                     W                    D                     L */
+        { S7M_TYPE_BOOL_INPUT,  S7M_TYPE_BYTE_INPUT,  S7M_TYPE_INT_INPUT,  S7M_TYPE_DINT_INPUT,  S7M_TYPE_LINT_INPUT  },
+        { S7M_TYPE_BOOL_OUTPUT, S7M_TYPE_BYTE_OUTPUT, S7M_TYPE_INT_OUTPUT, S7M_TYPE_DINT_OUTPUT, S7M_TYPE_LINT_OUTPUT },
+        { S7M_TYPE_BOOL_MEMORY, -1,                   S7M_TYPE_INT_MEMORY, S7M_TYPE_DINT_MEMORY, S7M_TYPE_LINT_MEMORY },
+    };
+    int area = location->area == 'I' ? 0 : location->area == 'Q' ? 1 : 2;
+    int size = (int)(strchr("XBWDL", location->size) - "XBWDL");
+    return types[area][size];
+}
+
+/**
+ * @brief Bytes per element of an IEC size, 1 for BOOL (one byte per index)
+ */
+static int element_size(char size)
+{
+    return size == 'W' ? 2 : size == 'D' ? 4 : size == 'L' ? 8 : 1;
+}
+
+static int s7_area_of(s7comm_master_area_t area)
+{
+    switch (area) {
+        case S7COMM_MASTER_AREA_I:
+            return S7AreaPE;
+        case S7COMM_MASTER_AREA_Q:
+            return S7AreaPA;
+        case S7COMM_MASTER_AREA_M:
+            return S7AreaMK;
+        default:
+            return S7AreaDB;
+    }
+}
+
+/**
+ * @brief Name an S7 area for log messages ("DB5", "I", "Q" or "M")
+ */
+static const char *format_area(int s7_area, int db_number, char *buffer, size_t size)
+{
+    switch (s7_area) {
+        case S7AreaPE:
+            return "I";
+        case S7AreaPA:
+            return "Q";
+        case S7AreaMK:
+            return "M";
+        default:
+            snprintf(buffer, size, "DB%d", db_number);
+            return buffer;
+    }
+}
+
+/*
+ * =============================================================================
+ * Image Table Access
+ * =============================================================================
+ */
+
+static int get_bit(const uint8_t *bits, int pos)
+{
+    return (bits[pos / 8] >> (pos % 8)) & 1;
+}
+
+/*
+ * =============================================================================
+ * S7 Byte Order
+ * =============================================================================
+ */
+
+/**
+ * @brief Convert big-endian S7 values to packed elements
+ */
+static void s7_to_elements(const uint8_t *src, char size, int count, void *dest)
+{
+    int width = element_size(size);
+
+    for (int i = 0; i < count; i++) {
+        uint64_t value = 0;
+        for (int b = 0; b < width; b++) {
+            value = (value << 8) | src[i * width + b];
+        }
+
+        switch (size) {
+            case 'B':
+                ((uint8_t *)dest)[i] = (uint8_t)value;
+                break;
+            case 'W':
+                ((uint16_t *)dest)[i] = (uint16_t)value;
+                break;
+            case 'D':
+                ((uint32_t *)dest)[i] = (uint32_t)value;
+                break;
+            default:
+                ((uint64_t *)dest)[i] = value;
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Convert packed elements to big-endian S7 values
+ */
+static void elements_to_s7(const void *elements, char size, int count, uint8_t *dest)
+{
+    int width = element_size(size);
+
+    for (int i = 0; i < count; i++) {
+        uint64_t value;
+        switch (size) {
+            case 'B':
+                value = ((const uint8_t *)elements)[i];
+                break;
+            case 'W':
+                value = ((const uint16_t *)elements)[i];
+                break;
+            case 'D':
+                value = ((const uint32_t *)elements)[i];
+                break;
+            default:
+                value = ((const uint64_t *)elements)[i];
+                break;
+        }
+
+        for (int b = width - 1; b >= 0; b--) {
+            dest[i * width + b] = (uint8_t)(value & 0xFF);
+            value >>= 8;
+        }
+    }
+}
+
+/*
+ * =============================================================================
+ * Request Planning
+ * =============================================================================
+ */
+
+/**
+ * @brief Largest item of a request, in data bytes, for the negotiated PDU
+ */
+static int max_item_size(const s7m_device_t *device, bool write)
+{
+    int overhead = write ? S7M_REQUEST_HEADER + S7M_ITEM_ADDRESS + S7M_ITEM_DATA_HEADER
+                         : S7M_RESPONSE_HEADER + S7M_ITEM_DATA_HEADER;
+    return (device->pdu_length - overhead) & ~1;
+}
+
+/**
+ * @brief Start a range at the end of the device's data buffer
+ */
+static s7m_range_t *add_range(s7m_device_t *device, int num_ranges, int data_used, const s7m_tag_t *tag,
+                              int start, int size, bool bit)
+{
+    s7m_range_t *range = &device->ranges[num_ranges];
+    range->s7_area = tag->s7_area;
+    range->db_number = tag->config->db_number;
+    range->start = start;
+    range->size = size;
+    range->bit = bit;
+    range->offset = data_used;
+    range->first_member = 0;
+    range->num_members = 0;
+    range->failed = false;
+    return range;
+}
+
+/**
+ * @brief Merge the read tags due at `tick` into ranges
+ *
+ * @return Number of ranges
+ */
+static int plan_reads(s7m_device_t *device, unsigned long tick)
+{
+    int num_ranges = 0;
+    int num_members = 0;
+    int data_used = 0;
+
+    for (int i = 0; i < device->num_tags; i++) {
+        const s7m_tag_t *tag = &device->tags[i];
+        if (tag->config->write) {
+            break; /* Write tags are sorted last */
+        }
+        if (tick % (unsigned long)tag->period != 0) {
+            continue;
+        }
+
+        int start = tag->config->start;
+        int end = start + tag->num_bytes;
+        s7m_range_t *last = num_ranges > 0 ? &device->ranges[num_ranges - 1] : NULL;
+
+        /* Tags are sorted by (area, DB, start): only the last range can absorb this one */
+        if (last != NULL && last->s7_area == tag->s7_area && last->db_number == tag->config->db_number &&
+            start <= last->start + last->size + device->config->max_read_gap) {
+            int last_end = last->start + last->size;
+            if (end > last_end) {
+                last->size = end - last->start;
+                data_used += end - last_end;
+            }
+            last->num_members++;
+            device->members[num_members++] = i;
+            continue;
+        }
+
+        s7m_range_t *range = add_range(device, num_ranges++, data_used, tag, start, tag->num_bytes, false);
+        range->first_member = num_members;
+        range->num_members = 1;
+        device->members[num_members++] = i;
+        data_used += tag->num_bytes;
+    }
+    return num_ranges;
+}
+
+/**
+ * @brief Copy the IEC values of a write tag into S7 data
+ *
+ * @param dest Remote bytes of the tag, from config->start
+ */
+static void fill_write_data(s7m_device_t *device, const s7m_tag_t *tag, uint8_t *dest)
+{
+    const s7comm_master_iec_location_t *location = &tag->config->iec_location;
+    int count = tag->config->length;
+
+    if (location->size == 'X') {
+        uint8_t *bits = (uint8_t *)device->elements;
+        image_read_elements(&g_runtime_args, tag->journal_type,
+                            location->index, (location->bit + count - 1) / 8 + 1, bits);
+        bit_pack_copy(dest, (size_t)tag->config->bit, bits, (size_t)location->bit, (size_t)count);
+        return;
+    }
+    image_read_elements(&g_runtime_args, tag->journal_type, location->index, count, device->elements);
+    elements_to_s7(device->elements, location->size, count, dest);
+}
+
+/**
+ * @brief Build the ranges of the write tags due at `tick`, with their data
+ *
+ * Byte ranges of tags that touch or overlap are merged (without gaps, which
+ * would overwrite bytes no tag owns). Bits not on byte boundaries are
+ * written as one S7WLBit item each so the other bits of their bytes are
+ * kept.
+ *
+ * @return Number of ranges
+ */
+static int plan_writes(s7m_device_t *device, unsigned long tick)
+{
+    int num_ranges = 0;
+    int num_members = 0;
+    int data_used = 0;
+
+    for (int i = 0; i < device->num_tags; i++) {
+        const s7m_tag_t *tag = &device->tags[i];
+        if (!tag->config->write || tick % (unsigned long)tag->period != 0) {
+            continue;
+        }
+
+        if (tag->bit_items) {
+            const s7comm_master_iec_location_t *location = &tag->config->iec_location;
+            uint8_t *bits = (uint8_t *)device->elements;
+            int count = tag->config->length;
+            image_read_elements(&g_runtime_args, tag->journal_type,
+                                location->index, (location->bit + count - 1) / 8 + 1, bits);
+
+            for (int k = 0; k < count; k++) {
+                int address = tag->config->start * 8 + tag->config->bit + k;
+                s7m_range_t *range = add_range(device, num_ranges++, data_used, tag, address, 1, true);
+                range->first_member = num_members;
+                range->num_members = 1;
+                device->data[data_used++] = (uint8_t)get_bit(bits, location->bit + k);
+            }
+            device->members[num_members++] = i;
+            continue;
+        }
+
+        int start = tag->config->start;
+        int end = start + tag->num_bytes;
+        s7m_range_t *last = num_ranges > 0 ? &device->ranges[num_ranges - 1] : NULL;
+
+        if (last != NULL && !last->bit && last->s7_area == tag->s7_area &&
+            last->db_number == tag->config->db_number && start <= last->start + last->size) {
+            int last_end = last->start + last->size;
+            if (end > last_end) {
+                last->size = end - last->start;
+                data_used += end - last_end;
+            }
+            last->num_members++;
+        } else {
+            last = add_range(device, num_ranges++, data_used, tag, start, tag->num_bytes, false);
+            last->first_member = num_members;
+            last->num_members = 1;
+            data_used += tag->num_bytes;
+        }
+        device->members[num_members++] = i;
+        fill_write_data(device, tag, device->data + last->offset + (start - last->start));
+    }
+    return num_ranges;
+}
+
+static int compare_chunks(const void *a, const void *b)
+{
+    const s7m_chunk_t *ca = (const s7m_chunk_t *)a;
+    const s7m_chunk_t *cb = (const s7m_chunk_t *)b;
+
+    if (ca->size != cb->size) {
+        return cb->size - ca->size;
+    }
+    return ca->range != cb->range ? ca->range - cb->range : ca->offset - cb->offset;
+}
+
+/**
+ * @brief Cut ranges into items and pack them into requests
+ *
+ * An item costs its address in the request and, with its data header and
+ * data (padded to even length), in the response of a read or the request of
+ * a write. Items are placed, largest first, into the first request with room
+ * for them, which leaves few partly used requests.
+ *
+ * @return Number of requests; their items are in device->items from
+ *         requests[r].first_item on
+ */
+static int pack_requests(s7m_device_t *device, int num_ranges, bool write)
+{
+    int item_limit = max_item_size(device, write);
+    int request_limit = device->pdu_length - S7M_REQUEST_HEADER;
+    int response_limit = device->pdu_length - S7M_RESPONSE_HEADER;
+    int num_chunks = 0;
+
+    for (int r = 0; r < num_ranges; r++) {
+        const s7m_range_t *range = &device->ranges[r];
+        for (int offset = 0; offset < range->size; offset += item_limit) {
+            s7m_chunk_t *chunk = &device->chunks[num_chunks++];
+            chunk->range = r;
+            chunk->offset = offset;
+            chunk->size = range->size - offset < item_limit ? range->size - offset : item_limit;
+        }
+    }
+    qsort(device->chunks, (size_t)num_chunks, sizeof(s7m_chunk_t), compare_chunks);
+
+    int num_requests = 0;
+    for (int c = 0; c < num_chunks; c++) {
+        s7m_chunk_t *chunk = &device->chunks[c];
+        int data = S7M_ITEM_DATA_HEADER + chunk->size + (chunk->size & 1);
+        int request_cost = S7M_ITEM_ADDRESS + (write ? data : 0);
+        int response_cost = write ? 1 : data;
+
+        int r = 0;
+        for (; r < num_requests; r++) {
+            const s7m_request_t *request = &device->requests[r];
+            if (request->num_items < S7M_MAX_ITEMS &&
+                request->request_bytes + request_cost <= request_limit &&
+                request->response_bytes + response_cost <= response_limit) {
+                break;
+            }
+        }
+        if (r == num_requests) {
+            memset(&device->requests[num_requests++], 0, sizeof(s7m_request_t));
+        }
+
+        s7m_request_t *request = &device->requests[r];
+        request->num_items++;
+        request->request_bytes += request_cost;
+        request->response_bytes += response_cost;
+        chunk->request = r;
+    }
+
+    /* Lay the items out request by request */
+    int first = 0;
+    for (int r = 0; r < num_requests; r++) {
+        device->requests[r].first_item = first;
+        first += device->requests[r].num_items;
+        device->requests[r].num_items = 0;
+    }
+    for (int c = 0; c < num_chunks; c++) {
+        const s7m_chunk_t *chunk = &device->chunks[c];
+        const s7m_range_t *range = &device->ranges[chunk->range];
+        s7m_request_t *request = &device->requests[chunk->request];
+        int slot = request->first_item + request->num_items++;
+        TS7DataItem *item = &device->items[slot];
+
+        item->Area = range->s7_area;
+        item->WordLen = range->bit ? S7WLBit : S7WLByte;
+        item->Result = 0;
+        item->DBNumber = range->db_number;
+        item->Start = range->start + chunk->offset;
+        item->Amount = chunk->size;
+        item->pdata = device->data + range->offset + chunk->offset;
+        device->item_chunks[slot] = c;
+    }
+    return num_requests;
+}
+
+/*
+ * =============================================================================
+ * Request Execution
+ * =============================================================================
+ */
+
+/**
+ * @brief Whether a client error means the connection is lost
+ *
+ * TCP and ISO errors are in the low bits; the high bits are errors of the
+ * client or of the PLC's answer, after which the connection is still usable.
+ */
+static bool is_connection_error(int error)
+{
+    return (error & errCliBase) != 0 || error == (int)errCliJobTimeout ||
+           error == (int)errCliInvalidPlcAnswer;
+}
+
+static const char *error_text(int error, char *buffer, int size)
+{
+    return ErrCliText(error, buffer, size);
+}
+
+/**
+ * @brief Disconnect the client after a connection error
+ */
+static void drop_connection(s7m_device_t *device, int error)
+{
+    char text[128];
+    plugin_logger_error_limited(&g_logger, "[%s] Communication error: %s, reconnecting",
+                                device->config->name, error_text(error, text, sizeof(text)));
+    device->client->Disconnect();
+    device->connected = false;
+}
+
+/**
+ * @brief Run the packed requests of one direction
+ *
+ * Failed items mark their range failed.
+ *
+ * @return false if the connection was lost
+ */
+static bool run_requests(s7m_device_t *device, int num_requests, bool write)
+{
+    char text[128];
+
+    for (int r = 0; r < num_requests; r++) {
+        const s7m_request_t *request = &device->requests[r];
+        TS7DataItem *items = &device->items[request->first_item];
+        int result = write ? device->client->WriteMultiVars(items, request->num_items)
+                           : device->client->ReadMultiVars(items, request->num_items);
+
+        if (result != 0 && is_connection_error(result)) {
+            drop_connection(device, result);
+            return false;
+        }
+
+        for (int i = 0; i < request->num_items; i++) {
+            int error = result != 0 ? result : items[i].Result;
+            if (error == 0) {
+                continue;
+            }
+
+            const s7m_chunk_t *chunk = &device->chunks[device->item_chunks[request->first_item + i]];
+            s7m_range_t *range = &device->ranges[chunk->range];
+            if (!range->failed) {
+                char area[16];
+                plugin_logger_error_limited(&g_logger, "[%s] %s of %s byte %d (%d bytes) failed: %s",
+                                            device->config->name, write ? "Write" : "Read",
+                                            format_area(range->s7_area, range->db_number, area, sizeof(area)),
+                                            range->bit ? range->start / 8 : range->start, range->size,
+                                            error_text(error, text, sizeof(text)));
+            }
+            range->failed = true;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Store the tags of the ranges read without error
+ */
+static void store_reads(s7m_device_t *device, int num_ranges)
+{
+    for (int r = 0; r < num_ranges; r++) {
+        const s7m_range_t *range = &device->ranges[r];
+        if (range->failed) {
+            continue;
+        }
+
+        for (int m = 0; m < range->num_members; m++) {
+            const s7m_tag_t *tag = &device->tags[device->members[range->first_member + m]];
+            const s7comm_master_iec_location_t *location = &tag->config->iec_location;
+            const uint8_t *src = device->data + range->offset + (tag->config->start - range->start);
+
+            if (location->size == 'X') {
+                image_journal_bits(&g_runtime_args, tag->journal_type, location->index, location->bit,
+                                   tag->config->length, src, tag->config->bit,
+                                   (uint8_t *)device->elements);
+            } else {
+                s7_to_elements(src, location->size, tag->config->length, device->elements);
+                g_runtime_args.journal_write_range(tag->journal_type, location->index, tag->config->length,
+                                                   device->elements);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run the reads and then the writes of one tick
+ */
+static void poll_tick(s7m_device_t *device, unsigned long tick)
+{
+    int num_ranges = plan_reads(device, tick);
+    if (num_ranges > 0) {
+        int num_requests = pack_requests(device, num_ranges, false);
+        bool connected = run_requests(device, num_requests, false);
+        /* Ranges read before a connection loss are stored all the same */
+        store_reads(device, num_ranges);
+        if (!connected) {
+            return;
+        }
+    }
+
+    num_ranges = plan_writes(device, tick);
+    if (num_ranges > 0) {
+        run_requests(device, pack_requests(device, num_ranges, true), true);
+    }
+}
+
+/*
+ * =============================================================================
+ * Device Threads
+ * =============================================================================
+ */
+
+/**
+ * @brief Sleep until `deadline` or until the plugin is stopped
+ *
+ * @return false if the plugin is stopping
+ */
+static bool wait_until(const struct timespec *deadline)
+{
+    pthread_mutex_lock(&g_stop_mutex);
+    while (g_running) {
+        if (pthread_cond_timedwait(&g_stop_cond, &g_stop_mutex, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    bool running = g_running;
+    pthread_mutex_unlock(&g_stop_mutex);
+    return running;
+}
+
+static void add_ms(struct timespec *ts, int ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Resolve the host of a device to a dotted IPv4 address
+ *
+ * Snap7 only connects to addresses, not host names.
+ */
+static bool resolve_host(const char *host, char *address, size_t size)
+{
+    struct addrinfo hints;
+    struct addrinfo *result = NULL;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || result == NULL) {
+        return false;
+    }
+
+    const struct sockaddr_in *sin = (const struct sockaddr_in *)result->ai_addr;
+    bool ok = inet_ntop(AF_INET, &sin->sin_addr, address, (socklen_t)size) != NULL;
+    freeaddrinfo(result);
+    return ok;
+}
+
+static bool ensure_connection(s7m_device_t *device)
+{
+    if (device->connected) {
+        return true;
+    }
+
+    const s7comm_master_device_t *config = device->config;
+    char address[INET_ADDRSTRLEN];
+    if (!resolve_host(config->host, address, sizeof(address))) {
+        plugin_logger_warn_limited(&g_logger, "[%s] Cannot resolve %s", config->name, config->host);
+        return false;
+    }
+
+    int result = device->client->ConnectTo(address, config->rack, config->slot);
+    if (result != 0) {
+        char text[128];
+        plugin_logger_warn_limited(&g_logger, "[%s] Cannot connect to %s:%d (rack %d, slot %d): %s",
+                                   config->name, config->host, config->port, config->rack, config->slot,
+                                   error_text(result, text, sizeof(text)));
+        device->client->Disconnect();
+        return false;
+    }
+
+    /* The scratch buffers are sized for the smallest PDU the plugin accepts */
+    if (device->client->PDULength < S7COMM_MASTER_MIN_PDU_SIZE) {
+        plugin_logger_error_limited(&g_logger, "[%s] PLC negotiated a PDU of %d bytes, at least %d needed",
+                                    config->name, device->client->PDULength, S7COMM_MASTER_MIN_PDU_SIZE);
+        device->client->Disconnect();
+        return false;
+    }
+
+    device->pdu_length = device->client->PDULength;
+    device->connected = true;
+    device->retry_delay_ms = S7M_RETRY_DELAY_BASE_MS;
+    plugin_logger_info(&g_logger, "[%s] Connected to %s:%d (rack %d, slot %d), PDU %d bytes", config->name,
+                       config->host, config->port, config->rack, config->slot, device->pdu_length);
+    return true;
+}
+
+static void *device_thread(void *arg)
+{
+    s7m_device_t *device = (s7m_device_t *)arg;
+    unsigned long tick = 0;
+    struct timespec next;
+
+    plugin_logger_info(&g_logger, "[%s] Thread started (tick %d ms)", device->config->name, device->tick_ms);
+
+    while (g_running) {
+        if (!ensure_connection(device)) {
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            add_ms(&next, device->retry_delay_ms);
+            device->retry_delay_ms = device->retry_delay_ms * 3 / 2;
+            if (device->retry_delay_ms > S7M_RETRY_DELAY_MAX_MS) {
+                device->retry_delay_ms = S7M_RETRY_DELAY_MAX_MS;
+            }
+            if (!wait_until(&next)) {
+                break;
+            }
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        add_ms(&next, device->tick_ms);
+
+        poll_tick(device, tick);
+        tick++;
+
+        if (!wait_until(&next)) {
+            break;
+        }
+    }
+
+    device->client->Disconnect();
+    device->connected = false;
+    plugin_logger_info(&g_logger, "[%s] Thread finished and connection closed", device->config->name);
+    return NULL;
+}
+
+/*
+ * =============================================================================
+ * Device Setup
+ * =============================================================================
+ */
+
+static int gcd(int a, int b)
+{
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int compare_tags(const void *a, const void *b)
+{
+    const s7m_tag_t *ta = (const s7m_tag_t *)a;
+    const s7m_tag_t *tb = (const s7m_tag_t *)b;
+
+    if (ta->config->write != tb->config->write) {
+        return ta->config->write ? 1 : -1;
+    }
+    if (ta->s7_area != tb->s7_area) {
+        return ta->s7_area - tb->s7_area;
+    }
+    if (ta->config->db_number != tb->config->db_number) {
+        return ta->config->db_number - tb->config->db_number;
+    }
+    return ta->config->start - tb->config->start;
+}
+
+/**
+ * @brief Check a tag and compute its remote size and journal type
+ *
+ * @return false (logged) if the tag cannot be polled
+ */
+static bool prepare_tag(const s7comm_master_device_t *config, const s7comm_master_tag_t *tag, s7m_tag_t *prepared)
+{
+    const s7comm_master_iec_location_t *location = &tag->iec_location;
+
+    prepared->config = tag;
+    prepared->journal_type = journal_type_of(location);
+    if (prepared->journal_type < 0) {
+        plugin_logger_error(&g_logger, "[%s] %%M%c locations are not supported, tag %s ignored", config->name,
+                            location->size, tag->name);
+        return false;
+    }
+
+    prepared->s7_area = s7_area_of(tag->area);
+    prepared->num_bytes = location->size == 'X' ? (tag->bit + tag->length - 1) / 8 + 1
+                                                : tag->length * element_size(location->size);
+    prepared->bit_items = tag->write && location->size == 'X' && (tag->bit != 0 || tag->length % 8 != 0);
+
+    if (tag->start + prepared->num_bytes > 0x10000) {
+        char area[16];
+        plugin_logger_error(&g_logger, "[%s] %s byte %d + %d exceeds the address space, tag %s ignored",
+                            config->name, format_area(prepared->s7_area, tag->db_number, area, sizeof(area)),
+                            tag->start, prepared->num_bytes, tag->name);
+        return false;
+    }
+
+    int last_index = location->size == 'X' ? location->index + (location->bit + tag->length - 1) / 8
+                                           : location->index + tag->length - 1;
+    if (last_index >= g_runtime_args.buffer_size) {
+        plugin_logger_error(&g_logger, "[%s] %%%c%c%d + %d exceeds the image table, tag %s ignored",
+                            config->name, location->area, location->size, location->index, tag->length,
+                            tag->name);
+        return false;
+    }
+    return true;
+}
+
+static void free_device(s7m_device_t *device)
+{
+    delete device->client;
+    free(device->tags);
+    free(device->ranges);
+    free(device->members);
+    free(device->chunks);
+    free(device->requests);
+    free(device->items);
+    free(device->item_chunks);
+    free(device->data);
+    free(device->elements);
+    memset(device, 0, sizeof(s7m_device_t));
+}
+
+/**
+ * @brief Size the per-tick scratch of a device for the smallest PDU
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int allocate_scratch(s7m_device_t *device)
+{
+    int max_ranges = 0;
+    int max_members = 0;
+    int data_bytes = 0;
+    int max_tag_bytes = 8;
+
+    for (int i = 0; i < device->num_tags; i++) {
+        const s7m_tag_t *tag = &device->tags[i];
+        /* A write tag of separate bits has one range and one data byte per bit */
+        int ranges = tag->bit_items ? tag->config->length : 1;
+        max_ranges += ranges;
+        max_members++;
+        data_bytes += tag->bit_items ? ranges : tag->num_bytes;
+        if (!tag->config->write) {
+            data_bytes += device->config->max_read_gap;
+        }
+        if (tag->num_bytes > max_tag_bytes) {
+            max_tag_bytes = tag->num_bytes;
+        }
+    }
+
+    /* Every range may end in a partial item */
+    int smallest_item = ((S7COMM_MASTER_MIN_PDU_SIZE - S7M_REQUEST_HEADER - S7M_ITEM_ADDRESS -
+                          S7M_ITEM_DATA_HEADER) & ~1);
+    int max_chunks = max_ranges + data_bytes / smallest_item + 1;
+
+    device->ranges = (s7m_range_t *)calloc((size_t)max_ranges, sizeof(s7m_range_t));
+    device->members = (int *)calloc((size_t)max_members, sizeof(int));
+    device->chunks = (s7m_chunk_t *)calloc((size_t)max_chunks, sizeof(s7m_chunk_t));
+    device->requests = (s7m_request_t *)calloc((size_t)max_chunks, sizeof(s7m_request_t));
+    device->items = (TS7DataItem *)calloc((size_t)max_chunks, sizeof(TS7DataItem));
+    device->item_chunks = (int *)calloc((size_t)max_chunks, sizeof(int));
+    device->data = (uint8_t *)calloc((size_t)data_bytes, 1);
+    /* BOOL tags read one more image byte when their IEC bit is not 0 */
+    device->elements = (uint64_t *)calloc((size_t)max_tag_bytes / 8 + 2, sizeof(uint64_t));
+    if (!device->ranges || !device->members || !device->chunks || !device->requests || !device->items ||
+        !device->item_chunks || !device->data || !device->elements) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Prepare the runtime state of one device
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int setup_device(const s7comm_master_device_t *config, s7m_device_t *device)
+{
+    memset(device, 0, sizeof(s7m_device_t));
+    device->config = config;
+    device->retry_delay_ms = S7M_RETRY_DELAY_BASE_MS;
+
+    device->client = new TSnap7MicroClient();
+    uint16_t port = config->port;
+    int timeout = config->timeout_ms;
+    int pdu_size = config->pdu_size;
+    device->client->SetConnectionType((word)config->connection_type);
+    device->client->SetParam(p_u16_RemotePort, &port);
+    device->client->SetParam(p_i32_PingTimeout, &timeout); /* Connect timeout */
+    device->client->SetParam(p_i32_SendTimeout, &timeout);
+    device->client->SetParam(p_i32_RecvTimeout, &timeout);
+    device->client->SetParam(p_i32_PDURequest, &pdu_size);
+
+    int n = config->num_tags;
+    if (n == 0) {
+        return 0;
+    }
+
+    device->tags = (s7m_tag_t *)calloc((size_t)n, sizeof(s7m_tag_t));
+    if (device->tags == NULL) {
+        free_device(device);
+        return -1;
+    }
+
+    device->tick_ms = 0;
+    for (int i = 0; i < n; i++) {
+        if (prepare_tag(config, &config->tags[i], &device->tags[device->num_tags])) {
+            device->tick_ms = gcd(device->tick_ms, config->tags[i].cycle_time_ms);
+            device->num_tags++;
+        }
+    }
+    for (int i = 0; i < device->num_tags; i++) {
+        device->tags[i].period = device->tags[i].config->cycle_time_ms / device->tick_ms;
+    }
+    qsort(device->tags, (size_t)device->num_tags, sizeof(s7m_tag_t), compare_tags);
+
+    if (device->num_tags > 0 && allocate_scratch(device) != 0) {
+        free_device(device);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * =============================================================================
+ * Plugin Lifecycle Functions
+ * =============================================================================
+ */
+
+/**
+ * @brief Initialize the S7 master plugin
+ */
+extern "C" int init(void *args)
+{
+    /* Initialize logger first (before we have runtime_args) */
+    plugin_logger_init(&g_logger, "S7COMM_MASTER", NULL);
+    plugin_logger_info(&g_logger, "Initializing S7 master plugin...");
+
+    if (!args) {
+        plugin_logger_error(&g_logger, "init args is NULL");
+        return -1;
+    }
+
+    /* Copy runtime args (critical - pointer is freed after init returns) */
+    memcpy(&g_runtime_args, args, sizeof(plugin_runtime_args_t));
+
+    /* Re-initialize logger with runtime_args for central logging */
+    plugin_logger_init(&g_logger, "S7COMM_MASTER", args);
+
+    const char *config_path = g_runtime_args.plugin_specific_config_file_path;
+    plugin_logger_info(&g_logger, "Loading config: %s", config_path);
+    int result = s7comm_master_config_parse(config_path, &g_config);
+    if (result != 0) {
+        plugin_logger_error(&g_logger, "Failed to load config file (error %d)", result);
+        s7comm_master_config_free(&g_config);
+        return -1;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_stop_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    g_num_devices = 0;
+    for (int i = 0; i < g_config.num_devices; i++) {
+        s7m_device_t *device = &g_devices[g_num_devices];
+        if (setup_device(&g_config.devices[i], device) != 0) {
+            plugin_logger_error(&g_logger, "[%s] Failed to allocate device state", g_config.devices[i].name);
+            continue;
+        }
+        g_num_devices++;
+        plugin_logger_info(&g_logger, "[%s] %s:%d rack %d slot %d, %d tag(s), tick %d ms",
+                           device->config->name, device->config->host, device->config->port,
+                           device->config->rack, device->config->slot, device->num_tags, device->tick_ms);
+    }
+
+    g_initialized = true;
+    plugin_logger_info(&g_logger, "Configuration loaded successfully: %d device(s)", g_num_devices);
+    return 0;
+}
+
+/**
+ * @brief Start one polling thread per device
+ */
+extern "C" void start_loop(void)
+{
+    if (!g_initialized) {
+        plugin_logger_error(&g_logger, "Cannot start - plugin not initialized");
+        return;
+    }
+
+    if (g_running) {
+        plugin_logger_warn(&g_logger, "Already running");
+        return;
+    }
+
+    g_running = true;
+    int started = 0;
+    for (int i = 0; i < g_num_devices; i++) {
+        s7m_device_t *device = &g_devices[i];
+        if (device->num_tags == 0) {
+            plugin_logger_warn(&g_logger, "[%s] No tags defined, not polled", device->config->name);
+            continue;
+        }
+        if (pthread_create(&device->thread, NULL, device_thread, device) != 0) {
+            plugin_logger_error(&g_logger, "[%s] Failed to create thread", device->config->name);
+            continue;
+        }
+        device->thread_started = true;
+        started++;
+    }
+
+    plugin_logger_info(&g_logger, "Started %d device thread(s)", started);
+}
+
+/**
+ * @brief Stop the polling threads
+ */
+extern "C" void stop_loop(void)
+{
+    if (!g_running) {
+        plugin_logger_debug(&g_logger, "Already stopped");
+        return;
+    }
+
+    pthread_mutex_lock(&g_stop_mutex);
+    g_running = false;
+    pthread_cond_broadcast(&g_stop_cond);
+    pthread_mutex_unlock(&g_stop_mutex);
+
+    for (int i = 0; i < g_num_devices; i++) {
+        if (g_devices[i].thread_started) {
+            pthread_join(g_devices[i].thread, NULL);
+            g_devices[i].thread_started = false;
+        }
+    }
+    plugin_logger_info(&g_logger, "Main loop stopped");
+}
+
+/**
+ * @brief Cleanup plugin resources
+ */
+extern "C" void cleanup(void)
+{
+    if (g_running) {
+        stop_loop();
+    }
+
+    for (int i = 0; i < g_num_devices; i++) {
+        free_device(&g_devices[i]);
+    }
+    g_num_devices = 0;
+
+    if (g_initialized) {
+        pthread_cond_destroy(&g_stop_cond);
+    }
+    s7comm_master_config_free(&g_config);
+    g_initialized = false;
+    plugin_logger_info(&g_logger, "S7 master plugin cleanup complete");
+}
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ */
+extern "C" void cycle_start(void)
+{
+    /* Read results are applied by the journal */
+}
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ */
+extern "C" void cycle_end(void)
+{
+    /* Write values come from the runtime's snapshot */
+}
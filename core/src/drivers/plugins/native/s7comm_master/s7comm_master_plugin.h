@@ -0,0 +1,70 @@
+/**
+ * @file s7comm_master_plugin.h
+ * @brief Native S7 Client (Master) Plugin for OpenPLC Runtime v4
+ *
+ * This plugin polls remote Siemens S7 PLCs with the Snap7 micro client,
+ * packing the configured tags into ReadMultiVars / WriteMultiVars requests
+ * sized to the PDU negotiated with each PLC.
+ *
+ * The plugin is self-contained with the Snap7 client sources of the S7Comm
+ * plugin compiled directly into the shared library.
+ */
+
+#ifndef S7COMM_MASTER_PLUGIN_H
+#define S7COMM_MASTER_PLUGIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the S7 master plugin
+ *
+ * Called when the plugin is loaded. Parses the device list and prepares
+ * the tags of every device.
+ *
+ * @param args Pointer to plugin_runtime_args_t containing runtime buffers,
+ *             mutex functions, and logging function pointers
+ * @return 0 on success, -1 on failure
+ */
+int init(void *args);
+
+/**
+ * @brief Start polling
+ *
+ * Starts one thread per device; each connects (retrying with backoff) and
+ * polls its tags.
+ */
+void start_loop(void);
+
+/**
+ * @brief Stop polling
+ *
+ * Stops the device threads and closes their connections.
+ */
+void stop_loop(void);
+
+/**
+ * @brief Cleanup plugin resources
+ */
+void cleanup(void);
+
+/**
+ * @brief Called at the start of each PLC scan cycle
+ *
+ * Nothing to do: read results reach the image tables through the journal.
+ */
+void cycle_start(void);
+
+/**
+ * @brief Called at the end of each PLC scan cycle
+ *
+ * Nothing to do: written values come from the runtime's per-scan snapshot.
+ */
+void cycle_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* S7COMM_MASTER_PLUGIN_H */
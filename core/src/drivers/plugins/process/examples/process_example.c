@@ -0,0 +1,80 @@
+/**
+ * @file process_example.c
+ * @brief Example process plugin (plugin type 2)
+ *
+ * Runs as a process of its own, started by the runtime. After every scan it
+ * reads %QW0..%QW3 from the shared snapshot and writes them back, incremented,
+ * to %IW0..%IW3 through the shared journal ring, and mirrors %QX0.0 to %IX0.0.
+ * Its output goes to the runtime's log.
+ *
+ * plugins.conf line:
+ *   process_example,./core/src/drivers/plugins/process/examples/process_example,1,2,
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Shared memory layout and the process side of the protocol */
+#include "../../../plugin_process_shm.h"
+
+/* Area numbers, as in journal_buffer_type_t */
+#define AREA_BOOL_INPUT 0
+#define AREA_BOOL_OUTPUT 1
+#define AREA_INT_INPUT 5
+#define AREA_INT_OUTPUT 6
+
+#define WORDS 4
+
+int main(int argc, char *argv[])
+{
+    plugin_shm_client_t client;
+    if (plugin_shm_attach(&client) != 0)
+    {
+        fprintf(stderr, "process_example: no shared memory, must be started by the runtime\n");
+        return 1;
+    }
+    printf("process_example: attached, config '%s', %u elements per area\n",
+           argc > 1 ? argv[1] : "", client.header->buffer_size);
+    fflush(stdout);
+
+    plugin_shm_subscribe(&client, AREA_INT_OUTPUT);
+    plugin_shm_subscribe(&client, AREA_BOOL_OUTPUT);
+
+    unsigned long long handled = 0;
+    int ret;
+    while ((ret = plugin_shm_wait(&client, 1000)) >= 0)
+    {
+        if (ret == 0)
+        {
+            continue; /* No scan for a second, the program may be stopped */
+        }
+
+        uint16_t words[WORDS];
+        uint8_t coils;
+        uint64_t cycle = 0;
+        if (plugin_shm_read(&client, AREA_INT_OUTPUT, 0, WORDS, words, &cycle) != WORDS ||
+            plugin_shm_read(&client, AREA_BOOL_OUTPUT, 0, 1, &coils, NULL) != 1)
+        {
+            continue; /* Areas show up from the second scan after subscribing */
+        }
+
+        for (int i = 0; i < WORDS; i++)
+        {
+            words[i]++;
+        }
+        /* The ring only fills up if the runtime stops draining it; retry next scan */
+        plugin_shm_write_range(&client, AREA_INT_INPUT, 0, WORDS, words);
+        plugin_shm_write_bool(&client, AREA_BOOL_INPUT, 0, 0, coils & 1);
+
+        if (++handled % 1000 == 0)
+        {
+            printf("process_example: scan %llu, %%QW0 = %u\n", (unsigned long long)cycle,
+                   (unsigned)(uint16_t)(words[0] - 1));
+            fflush(stdout);
+        }
+    }
+
+    printf("process_example: stopping after %llu scans\n", handled);
+    plugin_shm_detach(&client);
+    return 0;
+}
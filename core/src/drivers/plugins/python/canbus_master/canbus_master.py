@@ -9,6 +9,8 @@ class CanbusMaster:
     def __init__(self):
         self.config_path = "/root/openplc-runtime/core/generated/conf/canbus_conf.json"
         self.devices = []
+        self.inputs = {}   # node_id -> [(can_byte, can_bit, iec_addr), ...]
+        self.outputs = []  # [(cob_id, [(can_byte, can_bit, iec_addr), ...]), ...]
         self.running = False
         self.bus = None
 
@@ -21,6 +23,7 @@ class CanbusMaster:
                 if data.get("canbus_enabled") != "true":
                     return False
                 self.devices = data.get("devices", [])
+            self.compile_io_groups()
             return True
         except Exception as e:
             print(f"CANbus Master: Config Error: {e}")
@@ -37,6 +40,38 @@ class CanbusMaster:
         except:
             return None, 0, 0
 
+    def compile_bits(self, group):
+        """
+        Resolve all bits of an io_group once: bit i of the CAN payload maps to
+        the i-th IEC bit counted from iec_location (Byte.(Bit + i)).
+        """
+        addr_type, start_byte, start_bit = self.parse_iec_address(group["iec_location"])
+        bits = []
+        for i in range(group["len"]):
+            total_bits = (start_byte * 8) + start_bit + i
+            bits.append((i // 8, i % 8, f"{addr_type}{total_bits // 8}.{total_bits % 8}"))
+        return bits
+
+    def compile_io_groups(self):
+        """
+        Build the bit tables used by the I/O loops, so no address string is
+        parsed or formatted per message or per scan.
+        """
+        self.inputs = {}
+        self.outputs = []
+        for device in self.devices:
+            inputs = []
+            outputs = []
+            for group in device.get("io_groups", []):
+                if group["type"] == "DI":
+                    inputs.extend(self.compile_bits(group))
+                elif group["type"] == "DO":
+                    outputs.extend(self.compile_bits(group))
+            if inputs:
+                self.inputs[device["node_id"]] = inputs
+            if outputs:
+                self.outputs.append((0x200 + device["node_id"], outputs))
+
     def process_pdo_in(self, msg):
         """
         Hardware -> PLC (%IX)
@@ -45,26 +80,11 @@ class CanbusMaster:
         node_id = msg.arbitration_id - 0x180
         if node_id < 1 or node_id > 127: return
 
-        for device in self.devices:
-            if device["node_id"] == node_id:
-                for group in device.get("io_groups", []):
-                    if group["type"] == "DI":
-                        addr_type, start_byte, start_bit = self.parse_iec_address(group["iec_location"])
-                        
-                        for i in range(group["len"]):
-                            # Hitung posisi bit di payload CAN (max 8 byte / 64 bit)
-                            can_byte_idx = i // 8
-                            can_bit_idx = i % 8
-                            bit_val = (msg.data[can_byte_idx] >> can_bit_idx) & 1
-                            
-                            # Hitung alamat IEC tujuan (OpenPLC %IX Byte.Bit)
-                            # Logika: Bit ke-i dari offset akan mengisi Byte.(Bit + i)
-                            total_bits = (start_byte * 8) + start_bit + i
-                            target_byte = total_bits // 8
-                            target_bit = total_bits % 8
-                            iec_addr = f"%IX{target_byte}.{target_bit}"
-                            
-                            openplc.set_iec_variable(iec_addr, bit_val)
+        for can_byte_idx, can_bit_idx, iec_addr in self.inputs.get(node_id, []):
+            # Posisi bit di payload CAN (max 8 byte / 64 bit)
+            if can_byte_idx >= len(msg.data): break
+            bit_val = (msg.data[can_byte_idx] >> can_bit_idx) & 1
+            openplc.set_iec_variable(iec_addr, bit_val)
 
     def write_outputs_loop(self):
         """
@@ -72,29 +92,14 @@ class CanbusMaster:
         Standard CANopen: Node 1 PDO1 Out = 0x201, Node 2 = 0x202, dst.
         """
         while self.running:
-            for device in self.devices:
-                cob_id = 0x200 + device["node_id"]
+            for cob_id, outputs in self.outputs:
                 payload = [0] * 8 # Inisialisasi 8 byte data CAN
-                has_outputs = False
 
-                for group in device.get("io_groups", []):
-                    if group["type"] == "DO":
-                        has_outputs = True
-                        addr_type, start_byte, start_bit = self.parse_iec_address(group["iec_location"])
-                        
-                        for i in range(group["len"]):
-                            total_bits = (start_byte * 8) + start_bit + i
-                            current_byte = total_bits // 8
-                            current_bit = total_bits % 8
-                            iec_addr = f"%QX{current_byte}.{current_bit}"
-                            
-                            val = openplc.get_iec_variable(iec_addr)
-                            if val:
-                                can_byte_idx = i // 8
-                                can_bit_idx = i % 8
-                                payload[can_byte_idx] |= (1 << can_bit_idx)
-                
-                if has_outputs and self.bus:
+                for can_byte_idx, can_bit_idx, iec_addr in outputs:
+                    if openplc.get_iec_variable(iec_addr):
+                        payload[can_byte_idx] |= (1 << can_bit_idx)
+
+                if self.bus:
                     msg = can.Message(arbitration_id=cob_id, data=payload[:2], is_extended_id=False)
                     try:
                         self.bus.send(msg)
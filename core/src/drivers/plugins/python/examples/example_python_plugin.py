@@ -20,7 +20,8 @@ from shared import (
     safe_extract_runtime_args_from_capsule,
     SafeBufferAccess,
     SafeLoggingAccess,
-    PluginStructureValidator
+    PluginStructureValidator,
+    CycleWaiter
 )
 
 # Global variable to track initialization
@@ -113,13 +114,22 @@ def start_loop():
     Called when the plugin loop should start
     Optional function - not all plugins need this
     """
+    def on_cycle(token):
+        # Runs once per PLC scan, after the scan's outputs were published
+        if token.missed:
+            print(f"Plugin skipped {token.missed} scans before scan {token.cycle}")
+
     def loop():
         global _runtime_args, _stop
         print("Plugin start_loop called")
+        waiter = CycleWaiter(_runtime_args)
+        if waiter.is_valid:
+            waiter.run(on_cycle, _stop)
+            return
+        # Runtimes without cycle signals: free-run
         while not _stop.is_set():
             time.sleep(1)
-            continue
-            
+
 
     global _mainthread
     _mainthread = threading.Thread(target=loop, daemon=True)
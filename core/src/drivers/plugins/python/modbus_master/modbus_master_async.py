@@ -0,0 +1,290 @@
+"""Modbus Master plugin asyncio scheduler: one event loop thread polls many devices."""
+
+import asyncio
+import threading
+import time
+import traceback
+from typing import Any, List, Optional
+
+from pymodbus.client import AsyncModbusTcpClient
+from pymodbus.exceptions import ConnectionException
+
+try:
+    # Try relative imports first (when used as package)
+    from .modbus_master_device import ModbusDeviceCycle
+except ImportError:
+    # Fallback to absolute imports (when run standalone)
+    from modbus_master_device import ModbusDeviceCycle
+
+
+async def wait_or_stop(stop_event: asyncio.Event, timeout: float) -> bool:
+    """
+    Sleeps for timeout seconds or until stop_event is set.
+
+    Returns:
+        True if stop_event was set
+    """
+    try:
+        await asyncio.wait_for(stop_event.wait(), timeout=timeout)
+        return True
+    except asyncio.TimeoutError:
+        return False
+
+
+class AsyncModbusConnectionManager:  # pylint: disable=too-many-instance-attributes
+    """Manages async Modbus TCP connections with the retry logic of ModbusConnectionManager."""
+
+    def __init__(self, host: str, port: int, timeout_ms: int):
+        self.host = host
+        self.port = port
+        self.timeout = timeout_ms / 1000.0  # Convert to seconds
+
+        # Retry configuration
+        self.retry_delay_base = 2.0  # initial delay between attempts (seconds)
+        self.retry_delay_max = 30.0  # maximum delay between attempts (seconds)
+        self.retry_delay_current = self.retry_delay_base
+
+        # Connection state - is_connected is the authoritative flag for connection health
+        # It is set to False when any error occurs, forcing reconnection on next cycle
+        self.client: Optional[AsyncModbusTcpClient] = None
+        self.is_connected = False
+
+    def _close_client(self):
+        if self.client:
+            try:
+                self.client.close()
+            except Exception:
+                pass  # Ignore errors during cleanup
+            self.client = None
+
+    async def connect_with_retry(self, stop_event: asyncio.Event) -> bool:
+        """
+        Attempts to connect to Modbus device with infinite retry.
+
+        Args:
+            stop_event: asyncio.Event to allow early termination
+
+        Returns:
+            True if connected successfully, False if interrupted
+        """
+        retry_count = 0
+
+        while not stop_event.is_set():
+            try:
+                # Reconnection is driven from here, so disable the client's own
+                self._close_client()
+                self.client = AsyncModbusTcpClient(
+                    host=self.host, port=self.port, timeout=self.timeout, reconnect_delay=0
+                )
+
+                # Attempt to connect
+                if await self.client.connect():
+                    print(
+                        f"(PASS) Connected to {self.host}:{self.port} (attempt {retry_count + 1})"
+                    )
+                    self.is_connected = True
+                    self.retry_delay_current = self.retry_delay_base  # Reset delay
+                    return True
+
+            except Exception as e:
+                print(f"(FAIL) Connection attempt {retry_count + 1} failed: {e}")
+
+            # Increment counter and calculate delay
+            retry_count += 1
+
+            # Attempt logging
+            if retry_count == 1:
+                print(f"Failed to connect to {self.host}:{self.port}, starting retry attempts...")
+            elif retry_count % 10 == 0:  # Log every 10 attempts
+                print(f"Connection attempt {retry_count} failed, continuing retries...")
+
+            # Wait with increasing delay (limited exponential backoff)
+            delay = min(self.retry_delay_current, self.retry_delay_max)
+            if await wait_or_stop(stop_event, delay):
+                return False
+
+            # Increase delay for next attempt (maximum of retry_delay_max)
+            self.retry_delay_current = min(self.retry_delay_current * 1.5, self.retry_delay_max)
+
+        return False
+
+    async def ensure_connection(self, stop_event: asyncio.Event) -> bool:
+        """
+        Ensures there is a valid connection, reconnecting if necessary.
+
+        Returns:
+            True if connection is available, False if interrupted
+        """
+        if self.is_connected and self.client and self.client.connected:
+            return True
+
+        # Connection is broken or marked as unhealthy - force full reconnection
+        self._close_client()
+        self.is_connected = False
+        return await self.connect_with_retry(stop_event)
+
+    def mark_disconnected(self):
+        """Mark the connection as broken, forcing reconnection on next ensure_connection() call."""
+        self.is_connected = False
+        print(
+            f"Connection to {self.host}:{self.port} marked as disconnected, "
+            "will reconnect on next cycle"
+        )
+
+    def disconnect(self):
+        """Close the connection and clean up resources."""
+        self._close_client()
+        self.is_connected = False
+        print(f"Disconnected from {self.host}:{self.port}")
+
+
+class AsyncModbusSlaveDevice(ModbusDeviceCycle):
+    """Polls one Modbus slave device as a task of the shared event loop."""
+
+    def __init__(self, device_config: Any, sba: Any, plugin_logger: Any):
+        super().__init__(device_config, sba, plugin_logger)
+        self.name = self.device_name
+        self.connection_manager = AsyncModbusConnectionManager(
+            device_config.host, device_config.port, device_config.timeout_ms
+        )
+
+    async def run(self, stop_event: asyncio.Event):  # pylint: disable=too-many-branches
+        self.logger.info(f"[{self.name}] Task started.")
+
+        gcd_cycle_time_seconds = self.gcd_cycle_time_ms / 1000.0
+
+        if not self.device_config.io_points:
+            self.logger.warn(f"[{self.name}] No I/O points defined. Stopping task.")
+            return
+
+        # Connect with infinite retry
+        if not await self.connection_manager.connect_with_retry(stop_event):
+            self.logger.info(f"[{self.name}] Task stopped before connection could be established.")
+            return
+
+        # Initialize cycle counter
+        cycle_counter = 0
+
+        try:
+            while not stop_event.is_set():
+                cycle_start_time = time.monotonic()
+
+                # Ensure connection exists before cycle
+                if not await self.connection_manager.ensure_connection(stop_event):
+                    break  # Task was interrupted
+
+                # 1. READ OPERATIONS - One request per merged block that is due this cycle
+                read_results_to_update = []  # Store tuples: (point, modbus_data)
+                for block in self.due_read_blocks(cycle_counter):
+                    if stop_event.is_set():
+                        break
+
+                    try:
+                        response = await self.request_read(self.connection_manager.client, block)
+                        if not self.collect_read_response(block, response, read_results_to_update):
+                            # Mark as disconnected to force reconnection on next cycle
+                            self.connection_manager.mark_disconnected()
+                    except ConnectionException as ce:
+                        self.logger.error(
+                            f"[{self.name}] Connection error reading "
+                            f"FC {block.fc}, addr {block.address}: {ce}"
+                        )
+                        self.connection_manager.mark_disconnected()
+                    except Exception as e:
+                        self.logger.error(
+                            f"[{self.name}] Error reading "
+                            f"FC {block.fc}, addr {block.address}: {e}"
+                        )
+                        self.connection_manager.mark_disconnected()
+
+                self.store_read_results(read_results_to_update)
+
+                # 2. WRITE OPERATIONS
+                for point, address, values_to_write in self.collect_due_writes(cycle_counter):
+                    if stop_event.is_set():
+                        break
+
+                    try:
+                        response = await self.request_write(
+                            self.connection_manager.client, point, address, values_to_write
+                        )
+                        if self.response_failed(response, "write", point.fc, address):
+                            self.connection_manager.mark_disconnected()
+                    except ConnectionException as ce:
+                        self.logger.error(
+                            f"[{self.name}] Connection error writing "
+                            f"FC {point.fc}, offset {point.offset}: {ce}"
+                        )
+                        self.connection_manager.mark_disconnected()
+                    except Exception as e:
+                        self.logger.error(
+                            f"[{self.name}] Error writing "
+                            f"FC {point.fc}, offset {point.offset}: {e}"
+                        )
+                        self.connection_manager.mark_disconnected()
+
+                # 3. CYCLE TIMING - Yield to the other devices until the next GCD cycle
+                cycle_elapsed = time.monotonic() - cycle_start_time
+                sleep_duration = max(0, gcd_cycle_time_seconds - cycle_elapsed)
+                if await wait_or_stop(stop_event, sleep_duration):
+                    break
+
+                # Increment cycle counter
+                cycle_counter += 1
+
+        except Exception as e:
+            self.logger.error(f"[{self.name}] Unexpected error in task: {e}")
+            traceback.print_exc()
+        finally:
+            self.connection_manager.disconnect()
+            self.logger.info(f"[{self.name}] Task finished and connection closed.")
+
+
+class ModbusMasterEventLoop(threading.Thread):
+    """
+    Runs one asyncio event loop that polls every async device, so the plugin
+    costs one thread regardless of the device count.
+    """
+
+    def __init__(self, devices: List[AsyncModbusSlaveDevice], plugin_logger: Any):
+        super().__init__(daemon=True)
+        self.devices = devices
+        self.logger = plugin_logger
+        self.name = f"ModbusMasterEventLoop-{len(devices)}-devices"
+        self._stop_requested = threading.Event()
+        self._stop_event: Optional[asyncio.Event] = None
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+
+    def run(self):
+        self.logger.info(f"[{self.name}] Event loop started.")
+        try:
+            asyncio.run(self._main())
+        except Exception as e:
+            self.logger.error(f"[{self.name}] Unexpected error in event loop: {e}")
+            traceback.print_exc()
+        self.logger.info(f"[{self.name}] Event loop finished.")
+
+    async def _main(self):
+        self._stop_event = asyncio.Event()
+        self._loop = asyncio.get_running_loop()
+        # stop() may have run before the loop was published
+        if self._stop_requested.is_set():
+            self._stop_event.set()
+
+        results = await asyncio.gather(
+            *(device.run(self._stop_event) for device in self.devices),
+            return_exceptions=True,
+        )
+        for device, result in zip(self.devices, results):
+            if isinstance(result, BaseException):
+                self.logger.error(f"[{device.name}] Task failed: {result}")
+
+    def stop(self):
+        self.logger.info(f"[{self.name}] Stop signal received.")
+        self._stop_requested.set()
+        loop = self._loop
+        if loop is not None and self._stop_event is not None:
+            try:
+                loop.call_soon_threadsafe(self._stop_event.set)
+            except RuntimeError:
+                pass  # Loop already closed
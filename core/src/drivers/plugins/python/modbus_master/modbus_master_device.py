@@ -0,0 +1,302 @@
+"""Modbus Master plugin per-device polling cycle, shared by the thread and async schedulers."""
+
+from typing import Any, List
+
+from pymodbus.exceptions import ModbusIOException
+from pymodbus.pdu import ExceptionResponse
+
+try:
+    # Try relative imports first (when used as package)
+    from .modbus_master_memory import (
+        convert_modbus_data_to_values,
+        convert_raw_iec_to_modbus,
+        get_sba_access_details,
+    )
+    from .modbus_master_utils import (
+        calculate_gcd_of_cycle_times,
+        get_modbus_read_count,
+        parse_modbus_offset,
+        plan_read_blocks,
+    )
+except ImportError:
+    # Fallback to absolute imports (when run standalone)
+    from modbus_master_memory import (
+        convert_modbus_data_to_values,
+        convert_raw_iec_to_modbus,
+        get_sba_access_details,
+    )
+    from modbus_master_utils import (
+        calculate_gcd_of_cycle_times,
+        get_modbus_read_count,
+        parse_modbus_offset,
+        plan_read_blocks,
+    )
+
+
+class ModbusDeviceCycle:
+    """
+    Plans and processes the polling cycles of one Modbus slave device.
+
+    Everything except the Modbus I/O itself lives here: the read plan, the
+    due-point selection, the IEC buffer access and the response checks. IEC
+    locations are resolved once into access plans, so a cycle does no address
+    parsing and reads the output image with one snapshot copy per area. The
+    request helpers return whatever the client method returns, so the thread
+    scheduler uses the response directly and the async scheduler awaits it.
+    """
+
+    def __init__(self, device_config: Any, sba: Any, plugin_logger: Any):
+        self.device_config = device_config
+        self.sba = sba
+        self.logger = plugin_logger
+        self.device_name = (
+            f"ModbusSlave-{device_config.name}-{device_config.host}:{device_config.port}"
+        )
+
+        # Calculate GCD of all I/O point cycle times for this device
+        self.gcd_cycle_time_ms = calculate_gcd_of_cycle_times(device_config.io_points)
+        self.logger.info(
+            f"[{self.device_name}] Calculated GCD cycle time: {self.gcd_cycle_time_ms}ms"
+        )
+
+        # Buffer locations of the points: read points journal their values through
+        # input_plan, write points take theirs from output_plan
+        self.input_plan = sba.create_access_plan()
+        self.output_plan = sba.create_access_plan()
+        self.point_slots = {}  # id(point) -> (plan slot, BufferAccessDetails)
+
+        # Merge read points polled on the same cycles into as few requests as possible
+        self.read_blocks = self._plan_read_blocks()
+        read_points = sum(len(block.members) for block in self.read_blocks)
+        self.logger.info(
+            f"[{self.device_name}] {read_points} read points merged into "
+            f"{len(self.read_blocks)} requests"
+        )
+
+        # Write points with their parsed offsets
+        self.write_points = self._parse_write_points()
+
+        self.input_plan.compile()
+        self.output_plan.compile()
+
+    def _add_plan_point(self, plan: Any, point: Any, is_write_op: bool) -> bool:
+        """
+        Compiles the IEC location of a point into an access plan.
+
+        Returns:
+            False if the location cannot be accessed (logged once)
+        """
+        details = get_sba_access_details(point.iec_location, is_write_op=is_write_op)
+        if details is None:
+            msg = "unsupported IEC location"
+        else:
+            slot, msg = plan.add(
+                details.buffer_type_str, details.buffer_idx, details.bit_idx, point.length
+            )
+            if slot is not None:
+                self.point_slots[id(point)] = (slot, details)
+                return True
+        self.logger.error(
+            f"[{self.device_name}] Invalid IEC location for FC {point.fc}, "
+            f"offset {point.offset}: {msg}"
+        )
+        return False
+
+    def _plan_read_blocks(self) -> List[Any]:
+        """
+        Parses the read point offsets and merges the points into read blocks.
+        Points with an invalid offset or IEC size are logged once and skipped.
+        """
+        addressed_points = []
+        for point in self.device_config.io_points:
+            if point.fc not in [1, 2, 3, 4]:  # Read functions
+                continue
+            try:
+                address = parse_modbus_offset(point.offset)
+                get_modbus_read_count(point)
+            except ValueError as ve:
+                self.logger.error(
+                    f"[{self.device_name}] Invalid read point "
+                    f"'{point.offset}' for FC {point.fc}: {ve}"
+                )
+                continue
+            if not self._add_plan_point(self.input_plan, point, is_write_op=True):
+                continue
+            addressed_points.append((point, address))
+
+        return plan_read_blocks(
+            addressed_points, self.gcd_cycle_time_ms,
+            getattr(self.device_config, "max_read_gap", 0),
+        )
+
+    def _parse_write_points(self) -> List[Any]:
+        """
+        Parses the write point offsets. Points with an invalid offset are logged
+        once and skipped.
+        """
+        write_points = []
+        for point in self.device_config.io_points:
+            if point.fc not in [5, 6, 15, 16]:  # Write functions
+                continue
+            try:
+                address = parse_modbus_offset(point.offset)
+            except ValueError as ve:
+                self.logger.error(
+                    f"[{self.device_name}] Invalid offset "
+                    f"'{point.offset}' for FC {point.fc}: {ve}"
+                )
+                continue
+            if not self._add_plan_point(self.output_plan, point, is_write_op=False):
+                continue
+            cycle_multiple = max(1, point.cycle_time_ms // self.gcd_cycle_time_ms)
+            write_points.append((point, address, cycle_multiple))
+        return write_points
+
+    # -----------------------------------------------------------------
+    # Reads
+    # -----------------------------------------------------------------
+
+    def due_read_blocks(self, cycle_counter: int) -> List[Any]:
+        """Read blocks that need to be polled this cycle."""
+        return [
+            block for block in self.read_blocks
+            if (cycle_counter % block.cycle_multiple) == 0
+        ]
+
+    @staticmethod
+    def request_read(client: Any, block: Any) -> Any:
+        """
+        Issues the read request of a block.
+        Note: pymodbus 3.x requires count as keyword argument
+        """
+        if block.fc == 1:  # Read Coils
+            return client.read_coils(block.address, count=block.count)
+        if block.fc == 2:  # Read Discrete Inputs
+            return client.read_discrete_inputs(block.address, count=block.count)
+        if block.fc == 3:  # Read Holding Registers
+            return client.read_holding_registers(block.address, count=block.count)
+        return client.read_input_registers(block.address, count=block.count)  # FC 4
+
+    def collect_read_response(self, block: Any, response: Any, read_results: List) -> bool:
+        """
+        Checks a read response and slices it per point into read_results as
+        (point, modbus_data) tuples.
+
+        Returns:
+            False if the response is an error, True otherwise
+        """
+        if self.response_failed(response, "read", block.fc, block.address, block.count):
+            return False
+
+        # Extract data from response
+        if block.fc in [1, 2]:  # Coils/Discrete Inputs (boolean data)
+            modbus_data = response.bits
+        else:  # Holding/Input Registers (integer data)
+            modbus_data = response.registers
+
+        for point, index, count in block.members:
+            read_results.append((point, modbus_data[index:index + count]))
+        return True
+
+    def store_read_results(self, read_results: List) -> None:
+        """
+        Converts the read data and journals it through the input plan, one
+        journal range per point. Journal writes need no mutex.
+        """
+        for point, modbus_data in read_results:
+            slot, _ = self.point_slots[id(point)]
+            values = convert_modbus_data_to_values(
+                modbus_data, point.length, point.iec_location.size
+            )
+            if not values:
+                self.logger.error(
+                    f"[{self.device_name}] Data conversion failed "
+                    f"for IEC address {point.iec_location}, length={point.length}"
+                )
+                continue
+            success, msg = self.input_plan.write(slot, values)
+            if not success:
+                self.logger.error(
+                    f"[{self.device_name}] Failed to store data "
+                    f"for IEC address {point.iec_location}: {msg}"
+                )
+
+    # -----------------------------------------------------------------
+    # Writes
+    # -----------------------------------------------------------------
+
+    def collect_due_writes(self, cycle_counter: int) -> List[Any]:
+        """
+        Reads the IEC values of the write points due this cycle from the
+        output plan and converts them to Modbus format.
+
+        Returns:
+            List of (point, address, values_to_write) tuples
+        """
+        write_points_due = [
+            (point, address) for point, address, cycle_multiple in self.write_points
+            if (cycle_counter % cycle_multiple) == 0
+        ]
+        if not write_points_due:
+            return []
+
+        # Refresh every write point with one snapshot copy per image area
+        success, msg = self.output_plan.read()
+        if not success:
+            self.logger.error(f"[{self.device_name}] Failed to read IEC data for writes: {msg}")
+            return []
+
+        # Convert raw IEC values to Modbus format
+        writes = []
+        for point, address in write_points_due:
+            slot, details = self.point_slots[id(point)]
+            values_to_write = convert_raw_iec_to_modbus(
+                self.output_plan.values(slot), details, point.iec_location.size
+            )
+            if values_to_write is None:
+                self.logger.error(
+                    f"[{self.device_name}] Failed to convert data "
+                    f"for Modbus write (FC {point.fc}, offset {point.offset})"
+                )
+                continue
+            if point.fc in [5, 6] and len(values_to_write) == 0:
+                self.logger.error(
+                    f"[{self.device_name}] No data to write for FC {point.fc}, offset {address}"
+                )
+                continue
+            writes.append((point, address, values_to_write))
+        return writes
+
+    @staticmethod
+    def request_write(client: Any, point: Any, address: int, values_to_write: List) -> Any:
+        """Issues the write request of a point."""
+        if point.fc == 5:  # Write Single Coil
+            return client.write_coil(address, values_to_write[0])
+        if point.fc == 6:  # Write Single Register
+            return client.write_register(address, values_to_write[0])
+        if point.fc == 15:  # Write Multiple Coils
+            return client.write_coils(address, values_to_write)
+        return client.write_registers(address, values_to_write)  # FC 16
+
+    # -----------------------------------------------------------------
+    # Responses
+    # -----------------------------------------------------------------
+
+    def response_failed(
+        self, response: Any, operation: str, fc: int, address: int, count: int = None
+    ) -> bool:
+        """
+        Logs an error response.
+
+        Returns:
+            True if the response is an error and the connection should be
+            marked as disconnected, False if it is valid
+        """
+        what = f"FC {fc}, addr {address}" + (f", count {count}" if count is not None else "")
+        if isinstance(response, (ModbusIOException, ExceptionResponse)):
+            self.logger.error(f"[{self.device_name}] Modbus {operation} error ({what}): {response}")
+            return True
+        if response.isError():
+            self.logger.error(f"[{self.device_name}] Modbus {operation} failed ({what}): {response}")
+            return True
+        return False
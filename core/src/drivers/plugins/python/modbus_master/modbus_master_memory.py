@@ -241,6 +241,42 @@ def convert_modbus_data_to_iec_values(  # pylint: disable=too-many-locals
         return None, None
 
 
+def convert_modbus_data_to_values(modbus_data: list, length: int, iec_size: str) -> List:
+    """
+    Converts Modbus data to the plain IEC values of one point, for
+    AccessPlan.write(). The buffer location is already compiled into the plan,
+    so unlike convert_modbus_data_to_iec_values() no address is resolved.
+
+    Args:
+        modbus_data: List of values from Modbus (booleans for coils/inputs,
+                     integers for registers)
+        length: Number of IEC elements to convert
+        iec_size: IEC size string ('X', 'B', 'W', 'D', 'L')
+
+    Returns:
+        List of IEC values; shorter than length if modbus_data is short or an
+        element fails to convert
+    """
+    if iec_size == "X":
+        return list(modbus_data[:length])
+
+    registers_per_element = get_modbus_registers_count_for_iec_size(iec_size)
+    values = []
+    for i in range(min(length, len(modbus_data) // registers_per_element)):
+        start_reg_idx = i * registers_per_element
+        element_registers = modbus_data[start_reg_idx:start_reg_idx + registers_per_element]
+        try:
+            values.append(
+                convert_modbus_registers_to_iec_value(
+                    element_registers, iec_size, use_big_endian=False
+                )
+            )
+        except ValueError as e:
+            print(f"(FAIL) Error converting registers to IEC value: {e}")
+            break
+    return values
+
+
 def write_preconverted_iec_values(
     sba, converted_values: List[Tuple], details: BufferAccessDetails
 ) -> bool:
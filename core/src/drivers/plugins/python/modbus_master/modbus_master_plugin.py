@@ -5,8 +5,7 @@ import time
 import traceback
 from typing import Any, List
 
-from pymodbus.exceptions import ConnectionException, ModbusIOException
-from pymodbus.pdu import ExceptionResponse
+from pymodbus.exceptions import ConnectionException
 
 # Add the parent directory to Python path to find shared module
 sys.path.insert(0, os.path.join(os.path.dirname(__file__), ".."))
@@ -29,32 +28,14 @@ from shared.plugin_config_decode.modbus_master_config_model import (
 # Import local modules
 try:
     # Try relative imports first (when used as package)
+    from .modbus_master_async import AsyncModbusSlaveDevice, ModbusMasterEventLoop
     from .modbus_master_connection import ModbusConnectionManager
-    from .modbus_master_memory import (  # Optimized functions for minimal mutex hold time
-        convert_modbus_data_to_iec_values,
-        convert_raw_iec_to_modbus,
-        read_raw_iec_values,
-        write_preconverted_iec_values,
-    )
-    from .modbus_master_utils import (
-        calculate_gcd_of_cycle_times,
-        get_modbus_registers_count_for_iec_size,
-        parse_modbus_offset,
-    )
+    from .modbus_master_device import ModbusDeviceCycle
 except ImportError:
     # Fallback to absolute imports (when run standalone)
+    from modbus_master_async import AsyncModbusSlaveDevice, ModbusMasterEventLoop
     from modbus_master_connection import ModbusConnectionManager
-    from modbus_master_memory import (  # Optimized functions for minimal mutex hold time
-        convert_modbus_data_to_iec_values,
-        convert_raw_iec_to_modbus,
-        read_raw_iec_values,
-        write_preconverted_iec_values,
-    )
-    from modbus_master_utils import (
-        calculate_gcd_of_cycle_times,
-        get_modbus_registers_count_for_iec_size,
-        parse_modbus_offset,
-    )
+    from modbus_master_device import ModbusDeviceCycle
 
 # Global variables for plugin lifecycle and configuration
 # pylint: disable=invalid-name
@@ -66,21 +47,17 @@ slave_threads: List[threading.Thread] = []
 # pylint: enable=invalid-name
 
 
-class ModbusSlaveDevice(threading.Thread):
+class ModbusSlaveDevice(ModbusDeviceCycle, threading.Thread):
+    """Polls one Modbus slave device from a dedicated thread."""
+
     def __init__(self, device_config: Any, sba: SafeBufferAccess, plugin_logger: PluginLogger):
-        super().__init__(daemon=True)
-        self.device_config = device_config
-        self.sba = sba
-        self.logger = plugin_logger
+        threading.Thread.__init__(self, daemon=True)
+        ModbusDeviceCycle.__init__(self, device_config, sba, plugin_logger)
         self._stop_event = threading.Event()
         self.connection_manager = ModbusConnectionManager(
             device_config.host, device_config.port, device_config.timeout_ms
         )
-        self.name = f"ModbusSlave-{device_config.name}-{device_config.host}:{device_config.port}"
-
-        # Calculate GCD of all I/O point cycle times for this device
-        self.gcd_cycle_time_ms = calculate_gcd_of_cycle_times(device_config.io_points)
-        self.logger.info(f"[{self.name}] Calculated GCD cycle time: {self.gcd_cycle_time_ms}ms")
+        self.name = self.device_name
 
     def _ensure_connection(self) -> bool:
         """
@@ -91,7 +68,7 @@ class ModbusSlaveDevice(threading.Thread):
         """
         return self.connection_manager.ensure_connection(self._stop_event)
 
-    def run(self):  # pylint: disable=too-many-locals
+    def run(self):  # pylint: disable=too-many-branches
         self.logger.info(f"[{self.name}] Thread started.")
 
         io_points = self.device_config.io_points
@@ -117,264 +94,46 @@ class ModbusSlaveDevice(threading.Thread):
                 if not self._ensure_connection():
                     break  # Thread was interrupted
 
-                # 1. READ OPERATIONS - Process only I/O points that are due for polling this cycle
-                read_results_to_update = []  # Store tuples: (iec_addr, modbus_data, length)
-
-                # Check each read point individually
-                for point in io_points:
+                # 1. READ OPERATIONS - One request per merged block that is due this cycle
+                read_results_to_update = []  # Store tuples: (point, modbus_data)
+                for block in self.due_read_blocks(cycle_counter):
                     if self._stop_event.is_set():
                         break
 
-                    # Skip if this point doesn't need to be polled this cycle
-                    if point.fc not in [1, 2, 3, 4]:  # Read functions
-                        continue
-
-                    # Check if point should be polled this cycle
-                    point_cycle_multiple = point.cycle_time_ms // self.gcd_cycle_time_ms
-                    if (cycle_counter % point_cycle_multiple) != 0:
-                        continue
-
                     try:
-                        # Parse Modbus offset
-                        address = parse_modbus_offset(point.offset)
-
-                        # Calculate the correct number of Modbus registers/coils needed
-                        if point.fc in [3, 4]:  # Register-based operations (FC 3,4)
-                            iec_size = point.iec_location.size
-                            registers_per_iec_element = get_modbus_registers_count_for_iec_size(
-                                iec_size
-                            )
-                            count = point.length * registers_per_iec_element
-                        else:  # Coil/Discrete Input operations (FC 1,2)
-                            count = point.length  # 1:1 mapping for boolean operations
-
-                        # Perform Modbus read based on function code
-                        # Note: pymodbus 3.x requires count as keyword argument
-                        if point.fc == 1:  # Read Coils
-                            response = self.connection_manager.client.read_coils(
-                                address, count=count
-                            )
-                        elif point.fc == 2:  # Read Discrete Inputs
-                            response = self.connection_manager.client.read_discrete_inputs(
-                                address, count=count
-                            )
-                        elif point.fc == 3:  # Read Holding Registers
-                            response = self.connection_manager.client.read_holding_registers(
-                                address, count=count
-                            )
-                        elif point.fc == 4:  # Read Input Registers
-                            response = self.connection_manager.client.read_input_registers(
-                                address, count=count
-                            )
-                        else:
-                            self.logger.warn(f"[{self.name}] Unsupported read FC: {point.fc}")
-                            continue
-
-                        # Check if response is valid
-                        if isinstance(response, (ModbusIOException, ExceptionResponse)):
-                            self.logger.error(
-                                f"[{self.name}] Modbus read error "
-                                f"(FC {point.fc}, addr {address}): {response}"
-                            )
+                        response = self.request_read(self.connection_manager.client, block)
+                        if not self.collect_read_response(block, response, read_results_to_update):
                             # Mark as disconnected to force reconnection on next cycle
                             self.connection_manager.mark_disconnected()
-                            continue
-                        if response.isError():
-                            self.logger.error(
-                                f"[{self.name}] Modbus read failed "
-                                f"(FC {point.fc}, addr {address}): {response}"
-                            )
-                            # Mark as disconnected to force reconnection on next cycle
-                            self.connection_manager.mark_disconnected()
-                            continue
-
-                        # Extract data from response
-                        if point.fc in [1, 2]:  # Coils/Discrete Inputs (boolean data)
-                            modbus_data = response.bits
-                        else:  # Holding/Input Registers (integer data)
-                            modbus_data = response.registers
-
-                        # Store for batch update
-                        read_results_to_update.append(
-                            (point.iec_location, modbus_data, point.length)
-                        )
-
-                    except ValueError as ve:
-                        self.logger.error(
-                            f"[{self.name}] Invalid offset "
-                            f"'{point.offset}' for FC {point.fc}: {ve}"
-                        )
                     except ConnectionException as ce:
                         self.logger.error(
                             f"[{self.name}] Connection error reading "
-                            f"FC {point.fc}, offset {point.offset}: {ce}"
+                            f"FC {block.fc}, addr {block.address}: {ce}"
                         )
                         # Mark as disconnected to force reconnection
                         self.connection_manager.mark_disconnected()
                     except Exception as e:
                         self.logger.error(
                             f"[{self.name}] Error reading "
-                            f"FC {point.fc}, offset {point.offset}: {e}"
+                            f"FC {block.fc}, addr {block.address}: {e}"
                         )
                         # For other errors also mark disconnected as precaution
                         self.connection_manager.mark_disconnected()
 
-                # Batch update IEC buffers with single mutex acquisition
-                # OPTIMIZATION: Pre-convert all Modbus data to IEC values BEFORE
-                # acquiring the mutex to minimize mutex hold time
-                if read_results_to_update:
-                    # Phase 1: Pre-convert all data outside the mutex
-                    preconverted_updates = []
-                    for iec_addr, modbus_data, length in read_results_to_update:
-                        converted_values, details = convert_modbus_data_to_iec_values(
-                            iec_addr, modbus_data, length
-                        )
-                        if converted_values is not None and details is not None:
-                            preconverted_updates.append((converted_values, details))
-                        else:
-                            self.logger.error(
-                                f"[{self.name}] Data conversion failed "
-                                f"for IEC address {iec_addr}, length={length}"
-                            )
-
-                    # Phase 2: Write pre-converted values under the mutex
-                    if preconverted_updates:
-                        lock_acquired, lock_msg = self.sba.acquire_mutex()
-                        if lock_acquired:
-                            try:
-                                for converted_values, details in preconverted_updates:
-                                    write_preconverted_iec_values(
-                                        self.sba, converted_values, details
-                                    )
-                            finally:
-                                self.sba.release_mutex()
-                        else:
-                            self.logger.error(
-                                f"[{self.name}] Failed to acquire mutex "
-                                f"for read updates: {lock_msg}"
-                            )
-
-                # 2. WRITE OPERATIONS - Process only I/O points that are due for polling this cycle
-                # OPTIMIZATION: Batch all write preparations under a single mutex acquisition
-                # to minimize mutex hold time. Read all raw IEC values at once, then convert
-                # and write to Modbus outside the mutex.
-
-                # Phase 1: Collect all write points that are due this cycle
-                write_points_due = []
-                for point in io_points:
-                    if self._stop_event.is_set():
-                        break
-
-                    if point.fc not in [5, 6, 15, 16]:  # Write functions
-                        continue
-
-                    point_cycle_multiple = point.cycle_time_ms // self.gcd_cycle_time_ms
-                    if (cycle_counter % point_cycle_multiple) != 0:
-                        continue
-
-                    try:
-                        address = parse_modbus_offset(point.offset)
-                        write_points_due.append((point, address))
-                    except ValueError as ve:
-                        self.logger.error(
-                            f"[{self.name}] Invalid offset "
-                            f"'{point.offset}' for FC {point.fc}: {ve}"
-                        )
-
-                # Phase 2: Read all raw IEC values under a single mutex acquisition
-                raw_iec_data = []  # List of (point, address, raw_values, details, iec_size)
-                if write_points_due:
-                    lock_acquired, lock_msg = self.sba.acquire_mutex()
-                    if lock_acquired:
-                        try:
-                            for point, address in write_points_due:
-                                raw_values, details, iec_size = read_raw_iec_values(
-                                    self.sba, point.iec_location, point.length
-                                )
-                                if raw_values is not None:
-                                    raw_iec_data.append(
-                                        (point, address, raw_values, details, iec_size)
-                                    )
-                                else:
-                                    self.logger.error(
-                                        f"[{self.name}] Failed to read raw IEC data "
-                                        f"for write (FC {point.fc}, offset {point.offset})"
-                                    )
-                        finally:
-                            self.sba.release_mutex()
-                    else:
-                        self.logger.error(
-                            f"[{self.name}] Failed to acquire mutex "
-                            f"for batch write prep: {lock_msg}"
-                        )
+                self.store_read_results(read_results_to_update)
 
-                # Phase 3: Convert raw IEC values to Modbus format (outside mutex)
-                # and perform Modbus writes
-                for point, address, raw_values, details, iec_size in raw_iec_data:
+                # 2. WRITE OPERATIONS - IEC values are read under a single mutex
+                # acquisition, then converted and written to Modbus outside the mutex
+                for point, address, values_to_write in self.collect_due_writes(cycle_counter):
                     if self._stop_event.is_set():
                         break
 
                     try:
-                        # Convert raw IEC values to Modbus format (outside mutex)
-                        values_to_write = convert_raw_iec_to_modbus(raw_values, details, iec_size)
-
-                        if values_to_write is None:
-                            self.logger.error(
-                                f"[{self.name}] Failed to convert data "
-                                f"for Modbus write (FC {point.fc}, "
-                                f"offset {point.offset})"
-                            )
-                            continue
-
-                        # Perform Modbus write operation
-                        if point.fc == 5:  # Write Single Coil
-                            if len(values_to_write) > 0:
-                                response = self.connection_manager.client.write_coil(
-                                    address, values_to_write[0]
-                                )
-                            else:
-                                self.logger.error(
-                                    f"[{self.name}] No data to write "
-                                    f"for FC 5, offset {address}"
-                                )
-                                continue
-                        elif point.fc == 6:  # Write Single Register
-                            if len(values_to_write) > 0:
-                                response = self.connection_manager.client.write_register(
-                                    address, values_to_write[0]
-                                )
-                            else:
-                                self.logger.error(
-                                    f"[{self.name}] No data to write "
-                                    f"for FC 6, offset {address}"
-                                )
-                                continue
-                        elif point.fc == 15:  # Write Multiple Coils
-                            response = self.connection_manager.client.write_coils(
-                                address, values_to_write
-                            )
-                        elif point.fc == 16:  # Write Multiple Registers
-                            response = self.connection_manager.client.write_registers(
-                                address, values_to_write
-                            )
-                        else:
-                            self.logger.warn(f"[{self.name}] Unsupported write FC: {point.fc}")
-                            continue
-
-                        # Check write response
-                        if isinstance(response, (ModbusIOException, ExceptionResponse)):
-                            self.logger.error(
-                                f"[{self.name}] Modbus write error "
-                                f"(FC {point.fc}, addr {address}): {response}"
-                            )
-                            self.connection_manager.mark_disconnected()
-                        elif response.isError():
-                            self.logger.error(
-                                f"[{self.name}] Modbus write failed "
-                                f"(FC {point.fc}, addr {address}): {response}"
-                            )
+                        response = self.request_write(
+                            self.connection_manager.client, point, address, values_to_write
+                        )
+                        if self.response_failed(response, "write", point.fc, address):
                             self.connection_manager.mark_disconnected()
-
                     except ConnectionException as ce:
                         self.logger.error(
                             f"[{self.name}] Connection error writing "
@@ -438,8 +197,9 @@ def init(args_capsule):
             logger.error(f"Failed to extract runtime args: {error_msg}")
             return False
 
-        # Re-initialize logger with runtime_args for central logging
-        logger = PluginLogger("MODBUS_MASTER", runtime_args)
+        # Re-initialize logger with runtime_args for central logging, rate limited
+        # because read and write errors repeat every poll while a device is down
+        logger = PluginLogger("MODBUS_MASTER", runtime_args, rate_limited=True)
         logger.info("Runtime arguments extracted successfully")
 
         # Create safe buffer accessor
@@ -489,9 +249,16 @@ def start_loop():
             logger.error("Plugin not properly initialized")
             return False
 
-        # Start a thread for each configured device
+        # Start a thread for each configured device, except devices using the
+        # async scheduler, which all share one event loop thread
+        async_devices = []
         for device_config in modbus_master_config.devices:
             try:
+                if getattr(device_config, "scheduler", "thread") == "async":
+                    async_devices.append(
+                        AsyncModbusSlaveDevice(device_config, safe_buffer_accessor, logger)
+                    )
+                    continue
                 device_thread = ModbusSlaveDevice(device_config, safe_buffer_accessor, logger)
                 device_thread.start()
                 slave_threads.append(device_thread)
@@ -502,6 +269,15 @@ def start_loop():
             except Exception as e:
                 logger.error(f"Failed to start thread for device {device_config.name}: {e}")
 
+        if async_devices:
+            try:
+                event_loop_thread = ModbusMasterEventLoop(async_devices, logger)
+                event_loop_thread.start()
+                slave_threads.append(event_loop_thread)
+                logger.info(f"Started event loop for {len(async_devices)} async device(s)")
+            except Exception as e:
+                logger.error(f"Failed to start event loop for async devices: {e}")
+
         if slave_threads:
             logger.info(f"Successfully started {len(slave_threads)} device thread(s)")
             return True
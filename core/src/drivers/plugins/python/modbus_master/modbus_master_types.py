@@ -1,7 +1,7 @@
 """Modbus Master plugin type definitions."""
 
 from dataclasses import dataclass
-from typing import Optional, Dict, Any, List
+from typing import Optional, Dict, Any, List, Tuple
 
 
 @dataclass
@@ -31,6 +31,8 @@ class ModbusDeviceConfig:
     port: int
     timeout_ms: int
     io_points: List[ModbusIOPoint]
+    max_read_gap: int = 0  # Unconfigured registers/coils a merged read may span
+    scheduler: str = "thread"  # "thread" or "async" (shared event loop)
 
 
 @dataclass
@@ -41,3 +43,13 @@ class BufferAccessDetails:
     bit_idx: Optional[int]
     element_size_bytes: int
     is_boolean: bool
+
+
+@dataclass
+class ModbusReadBlock:
+    """One Modbus read request covering the points merged into it."""
+    fc: int  # Function code
+    address: int  # First register/coil of the request
+    count: int  # Registers/coils requested
+    cycle_multiple: int  # Polled every cycle_multiple GCD cycles
+    members: List[Tuple[Any, int, int]]  # (point, index into the response, count)
@@ -1,7 +1,16 @@
 """Modbus Master plugin utility functions."""
 
 import math
-from typing import List, Dict, Any
+from typing import List, Dict, Any, Tuple
+
+try:
+    from .modbus_master_types import ModbusReadBlock
+except ImportError:
+    from modbus_master_types import ModbusReadBlock
+
+# Protocol limits of a single read request
+MAX_READ_BITS = 2000  # FC 1, 2
+MAX_READ_REGISTERS = 125  # FC 3, 4
 
 
 def gcd(a: int, b: int) -> int:
@@ -66,6 +75,63 @@ def get_batch_write_requests_from_io_points(io_points: List[Any]) -> Dict[int, L
     return write_requests
 
 
+def get_modbus_read_count(point: Any) -> int:
+    """
+    Number of coils (FC 1, 2) or registers (FC 3, 4) a read point covers.
+    """
+    if point.fc in [3, 4]:
+        return point.length * get_modbus_registers_count_for_iec_size(point.iec_location.size)
+    return point.length  # 1:1 mapping for boolean operations
+
+
+def plan_read_blocks(
+    addressed_points: List[Tuple[Any, int]], gcd_cycle_time_ms: int, max_gap: int = 0
+) -> List[ModbusReadBlock]:
+    """
+    Merges read points into as few Modbus requests as possible.
+
+    Points are grouped by (FC, cycle multiple) so every block is due on the
+    same cycles as all of its points, then sorted by address. A point joins
+    the previous block when it overlaps it, touches it, or leaves at most
+    max_gap unconfigured registers/coils in between, and the block stays
+    within the protocol limit of one read request.
+
+    Args:
+        addressed_points: (point, parsed Modbus address) tuples
+        gcd_cycle_time_ms: GCD of the device cycle times
+        max_gap: Unconfigured registers/coils a block may span
+
+    Returns:
+        The blocks, each listing its points with their slice of the response
+    """
+    groups: Dict[Tuple[int, int], List[Tuple[Any, int, int]]] = {}
+    for point, address in addressed_points:
+        if point.fc not in [1, 2, 3, 4]:
+            continue
+        cycle_multiple = max(1, point.cycle_time_ms // gcd_cycle_time_ms)
+        groups.setdefault((point.fc, cycle_multiple), []).append(
+            (point, address, get_modbus_read_count(point))
+        )
+
+    blocks: List[ModbusReadBlock] = []
+    for (fc, cycle_multiple), members in sorted(groups.items()):
+        limit = MAX_READ_BITS if fc in [1, 2] else MAX_READ_REGISTERS
+        members.sort(key=lambda member: (member[1], member[2]))
+
+        block = None
+        for point, address, count in members:
+            if block is not None:
+                end = max(block.address + block.count, address + count)
+                if address <= block.address + block.count + max_gap and end - block.address <= limit:
+                    block.count = end - block.address
+                    block.members.append((point, address - block.address, count))
+                    continue
+            block = ModbusReadBlock(fc, address, count, cycle_multiple, [(point, 0, count)])
+            blocks.append(block)
+
+    return blocks
+
+
 def get_modbus_registers_count_for_iec_size(iec_size: str) -> int:
     """
     Returns how many 16-bit Modbus registers are needed for an IEC data type.
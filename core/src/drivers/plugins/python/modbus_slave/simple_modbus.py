@@ -25,7 +25,7 @@ from pymodbus.server import ServerStop
 from pymodbus.server.server import ModbusTcpServer
 
 MAX_BITS = 8
-BUFFER_SIZE = 1024  # Must match BUFFER_SIZE in image_tables.h
+BUFFER_SIZE = 1024  # Default image table size (BUFFER_SIZE in image_tables.h)
 
 # Default segmentation configuration (matches v3 behavior)
 DEFAULT_HOLDING_REG_CONFIG = {
@@ -59,6 +59,67 @@ from shared import (  # noqa: E402
 )
 
 
+def open_image_view(safe_buffer_access, buffer_type):
+    """Zero-copy snapshot view of a buffer, or None when it is not available"""
+    if not safe_buffer_access.is_valid:
+        return None
+    view, _ = safe_buffer_access.open_image_view(buffer_type)
+    return view
+
+
+def read_image_words(view, start, count):
+    """
+    Slice count elements out of a snapshot view without locking. Returns None
+    if the view is unavailable or the scan overwrote the snapshot meanwhile.
+    """
+    if view is None:
+        return None
+    try:
+        with memoryview(view) as data:
+            values = data[start:start + count].tolist()
+    except BufferError:
+        return None
+    if len(values) != count or not view.valid():
+        return None
+    return values
+
+
+def unpack_bits(data, first_bit, count):
+    """count 0/1 values from first_bit on, out of boolean buffer bytes starting at its index"""
+    first_idx = first_bit // MAX_BITS
+    return [
+        (data[(first_bit + i) // MAX_BITS - first_idx] >> ((first_bit + i) % MAX_BITS)) & 1
+        for i in range(count)
+    ]
+
+
+def read_image_bits(view, first_bit, count):
+    """Like read_image_words for count bits of a boolean buffer, as 0/1 values"""
+    first_idx = first_bit // MAX_BITS
+    last_idx = (first_bit + count - 1) // MAX_BITS
+    data = read_image_words(view, first_idx, last_idx - first_idx + 1)
+    if data is None:
+        return None
+    return unpack_bits(data, first_bit, count)
+
+
+def read_range_values(safe_buffer_access, view, buffer_type, start, count):
+    """
+    count elements of a buffer from start: sliced out of the snapshot view,
+    or copied with one range read when the view is unavailable or stale.
+    Zeros if the range cannot be read.
+    """
+    values = read_image_words(view, start, count)
+    if values is not None:
+        return values
+    data, error_msg = safe_buffer_access.read_range(buffer_type, start, count)
+    if data is None:
+        if logger:
+            logger.error(f"Error reading {buffer_type}[{start}:{start + count}]: {error_msg}")
+        return [0] * count
+    return data.tolist()
+
+
 class OpenPLCCoilsDataBlock(ModbusSparseDataBlock):
     """Custom Modbus coils data block that mirrors OpenPLC bool_output using SafeBufferAccess"""
 
@@ -166,6 +227,8 @@ class OpenPLCDiscreteInputsDataBlock(ModbusSparseDataBlock):
                     f"discrete inputs: {self.safe_buffer_access.error_msg}"
                 )
 
+        self.image_view = open_image_view(self.safe_buffer_access, "bool_input")
+
         # Initialize with zeros
         super().__init__([0] * num_inputs)
 
@@ -180,6 +243,12 @@ class OpenPLCDiscreteInputsDataBlock(ModbusSparseDataBlock):
                 )
             return [0] * count
 
+        # Slice the scan snapshot directly when the whole request is mapped
+        if address >= 0 and address + count <= self.num_inputs:
+            values = read_image_bits(self.image_view, address, count)
+            if values is not None:
+                return values
+
         # Ensure thread-safe access
         self.safe_buffer_access.acquire_mutex()
 
@@ -230,6 +299,8 @@ class OpenPLCInputRegistersDataBlock(ModbusSparseDataBlock):
                     f"input registers: {self.safe_buffer_access.error_msg}"
                 )
 
+        self.image_view = open_image_view(self.safe_buffer_access, "int_input")
+
         # Initialize with zeros
         super().__init__([0] * num_registers)
 
@@ -244,6 +315,12 @@ class OpenPLCInputRegistersDataBlock(ModbusSparseDataBlock):
                 )
             return [0] * count
 
+        # Slice the scan snapshot directly when the whole request is mapped
+        if address >= 0 and address + count <= self.num_registers:
+            values = read_image_words(self.image_view, address, count)
+            if values is not None:
+                return values
+
         # Ensure buffer mutex
         self.safe_buffer_access.acquire_mutex()
 
@@ -378,6 +455,15 @@ class OpenPLCSegmentedCoilsDataBlock(ModbusSparseDataBlock):
                     f"{self.safe_buffer_access.error_msg}"
                 )
 
+        self.qx_view = open_image_view(self.safe_buffer_access, "bool_output")
+        self.mx_view = open_image_view(self.safe_buffer_access, "bool_memory")
+
+        # Address layout, resolved once: (first address, end address, buffer type, view)
+        self.segments = [
+            (0, self.qx_bits, "bool_output", self.qx_view),
+            (self.qx_bits, self.total_bits, "bool_memory", self.mx_view),
+        ]
+
         # Initialize with zeros
         super().__init__([0] * self.total_bits)
         if logger:
@@ -419,40 +505,22 @@ class OpenPLCSegmentedCoilsDataBlock(ModbusSparseDataBlock):
                 )
             return [0] * count
 
-        self.safe_buffer_access.acquire_mutex()
-        try:
-            values = []
-            for i in range(count):
-                coil_addr = address + i
-                segment, buffer_idx, bit_idx = self._get_segment_info(coil_addr)
-
-                if segment == "qx":
-                    value, error_msg = self.safe_buffer_access.read_bool_output(
-                        buffer_idx, bit_idx, thread_safe=False
-                    )
-                    if error_msg == "Success":
-                        values.append(1 if value else 0)
-                    else:
-                        if logger:
-                            logger.error(f"Error reading coil %QX{coil_addr}: {error_msg}")
-                        values.append(0)
-                elif segment == "mx":
-                    mx_addr = coil_addr - self.qx_bits
-                    value, error_msg = self.safe_buffer_access.read_bool_memory(
-                        buffer_idx, bit_idx, thread_safe=False
-                    )
-                    if error_msg == "Success":
-                        values.append(1 if value else 0)
-                    else:
-                        if logger:
-                            logger.error(f"Error reading coil %MX{mx_addr}: {error_msg}")
-                        values.append(0)
-                else:
-                    values.append(0)
-
-            return values
-        finally:
-            self.safe_buffer_access.release_mutex()
+        # One bulk read per segment the request covers, addresses outside
+        # every segment read as 0. Each segment comes from a single scan.
+        values = [0] * count
+        for first, end, buffer_type, view in self.segments:
+            low = max(address, first)
+            high = min(address + count, end)
+            if low >= high:
+                continue
+            first_bit = low - first
+            first_idx = first_bit // MAX_BITS
+            last_idx = (high - 1 - first) // MAX_BITS
+            data = read_range_values(
+                self.safe_buffer_access, view, buffer_type, first_idx, last_idx - first_idx + 1
+            )
+            values[low - address : high - address] = unpack_bits(data, first_bit, high - low)
+        return values
 
     def setValues(self, address, values):
         """Set coil values to appropriate OpenPLC buffer based on address segmentation.
@@ -542,6 +610,22 @@ class OpenPLCSegmentedHoldingRegistersDataBlock(ModbusSparseDataBlock):
                     f"{self.safe_buffer_access.error_msg}"
                 )
 
+        self.qw_view = open_image_view(self.safe_buffer_access, "int_output")
+        self.mw_view = open_image_view(self.safe_buffer_access, "int_memory")
+        self.md_view = open_image_view(self.safe_buffer_access, "dint_memory")
+        self.ml_view = open_image_view(self.safe_buffer_access, "lint_memory")
+
+        # Address layout, resolved once: (first address, end address, buffer
+        # type, view, shifts of the words of one value in register order)
+        dint_shifts = (16, 0) if word_order == "high_word_first" else (0, 16)
+        lint_shifts = (48, 32, 16, 0) if word_order == "high_word_first" else (0, 16, 32, 48)
+        self.segments = [
+            (0, self.qw_end, "int_output", self.qw_view, (0,)),
+            (self.mw_start, self.mw_end, "int_memory", self.mw_view, (0,)),
+            (self.md_start, self.md_end, "dint_memory", self.md_view, dint_shifts),
+            (self.ml_start, self.ml_end, "lint_memory", self.ml_view, lint_shifts),
+        ]
+
         # Initialize with zeros
         super().__init__([0] * self.total_registers)
         if logger:
@@ -640,65 +724,25 @@ class OpenPLCSegmentedHoldingRegistersDataBlock(ModbusSparseDataBlock):
                 )
             return [0] * count
 
-        self.safe_buffer_access.acquire_mutex()
-        try:
-            values = []
-            for i in range(count):
-                reg_addr = address + i
-                segment, value_idx, word_offset = self._get_segment_info(reg_addr)
-
-                if segment == "qw":
-                    value, error_msg = self.safe_buffer_access.read_int_output(
-                        value_idx, thread_safe=False
-                    )
-                    if error_msg == "Success":
-                        values.append(value & 0xFFFF)
-                    else:
-                        if logger:
-                            logger.error(f"Error reading %QW{value_idx}: {error_msg}")
-                        values.append(0)
-
-                elif segment == "mw":
-                    value, error_msg = self.safe_buffer_access.read_int_memory(
-                        value_idx, thread_safe=False
-                    )
-                    if error_msg == "Success":
-                        values.append(value & 0xFFFF)
-                    else:
-                        if logger:
-                            logger.error(f"Error reading %MW{value_idx}: {error_msg}")
-                        values.append(0)
-
-                elif segment == "md":
-                    dint_value, error_msg = self.safe_buffer_access.read_dint_memory(
-                        value_idx, thread_safe=False
-                    )
-                    if error_msg == "Success":
-                        words = self._split_dint_to_words(dint_value)
-                        values.append(words[word_offset])
-                    else:
-                        if logger:
-                            logger.error(f"Error reading %MD{value_idx}: {error_msg}")
-                        values.append(0)
-
-                elif segment == "ml":
-                    lint_value, error_msg = self.safe_buffer_access.read_lint_memory(
-                        value_idx, thread_safe=False
-                    )
-                    if error_msg == "Success":
-                        words = self._split_lint_to_words(lint_value)
-                        values.append(words[word_offset])
-                    else:
-                        if logger:
-                            logger.error(f"Error reading %ML{value_idx}: {error_msg}")
-                        values.append(0)
-
-                else:
-                    values.append(0)
-
-            return values
-        finally:
-            self.safe_buffer_access.release_mutex()
+        # One bulk read per segment the request covers, DINT and LINT values
+        # split into their words in register order. Addresses outside every
+        # segment read as 0. Each segment comes from a single scan.
+        values = [0] * count
+        for first, end, buffer_type, view, shifts in self.segments:
+            low = max(address, first)
+            high = min(address + count, end)
+            if low >= high:
+                continue
+            width = len(shifts)
+            first_value = (low - first) // width
+            last_value = (high - 1 - first) // width
+            data = read_range_values(
+                self.safe_buffer_access, view, buffer_type, first_value, last_value - first_value + 1
+            )
+            words = [(value >> shift) & 0xFFFF for value in data for shift in shifts]
+            skip = low - first - first_value * width
+            values[low - address : high - address] = words[skip : skip + high - low]
+        return values
 
     def setValues(self, address, values):
         """Set holding register values to appropriate OpenPLC buffer based on address segmentation.
@@ -794,11 +838,13 @@ class OpenPLCSegmentedHoldingRegistersDataBlock(ModbusSparseDataBlock):
             self.safe_buffer_access.release_mutex()
 
 
-def parse_buffer_mapping_config(config_map):
+def parse_buffer_mapping_config(config_map, buffer_size=BUFFER_SIZE):
     """
     Parse buffer_mapping configuration from JSON config.
     Supports both legacy format (max_coils, etc.) and new segmented format.
 
+    Counts are clipped to buffer_size, the runtime's image table size.
+
     Returns a dict with parsed configuration for each data block type.
     """
     buffer_mapping = config_map.get("buffer_mapping", {})
@@ -817,38 +863,38 @@ def parse_buffer_mapping_config(config_map):
             "format": "segmented",
             "holding_registers": {
                 "qw_count": min(
-                    hr_config.get("qw_count", DEFAULT_HOLDING_REG_CONFIG["qw_count"]), BUFFER_SIZE
+                    hr_config.get("qw_count", DEFAULT_HOLDING_REG_CONFIG["qw_count"]), buffer_size
                 ),
                 "mw_count": min(
-                    hr_config.get("mw_count", DEFAULT_HOLDING_REG_CONFIG["mw_count"]), BUFFER_SIZE
+                    hr_config.get("mw_count", DEFAULT_HOLDING_REG_CONFIG["mw_count"]), buffer_size
                 ),
                 "md_count": min(
-                    hr_config.get("md_count", DEFAULT_HOLDING_REG_CONFIG["md_count"]), BUFFER_SIZE
+                    hr_config.get("md_count", DEFAULT_HOLDING_REG_CONFIG["md_count"]), buffer_size
                 ),
                 "ml_count": min(
-                    hr_config.get("ml_count", DEFAULT_HOLDING_REG_CONFIG["ml_count"]), BUFFER_SIZE
+                    hr_config.get("ml_count", DEFAULT_HOLDING_REG_CONFIG["ml_count"]), buffer_size
                 ),
             },
             "coils": {
                 "qx_bits": min(
                     coils_config.get("qx_bits", DEFAULT_COILS_CONFIG["qx_bits"]),
-                    BUFFER_SIZE * MAX_BITS,
+                    buffer_size * MAX_BITS,
                 ),
                 "mx_bits": min(
                     coils_config.get("mx_bits", DEFAULT_COILS_CONFIG["mx_bits"]),
-                    BUFFER_SIZE * MAX_BITS,
+                    buffer_size * MAX_BITS,
                 ),
             },
             "discrete_inputs": {
                 "ix_bits": min(
                     di_config.get("ix_bits", DEFAULT_DISCRETE_INPUTS_CONFIG["ix_bits"]),
-                    BUFFER_SIZE * MAX_BITS,
+                    buffer_size * MAX_BITS,
                 ),
             },
             "input_registers": {
                 "iw_count": min(
                     ir_config.get("iw_count", DEFAULT_INPUT_REGISTERS_CONFIG["iw_count"]),
-                    BUFFER_SIZE,
+                    buffer_size,
                 ),
             },
             "word_order": config_map.get("word_order", "high_word_first"),
@@ -864,20 +910,20 @@ def parse_buffer_mapping_config(config_map):
     return {
         "format": "legacy",
         "holding_registers": {
-            "qw_count": min(max_holding_registers, BUFFER_SIZE),
+            "qw_count": min(max_holding_registers, buffer_size),
             "mw_count": 0,  # No memory support in legacy mode
             "md_count": 0,
             "ml_count": 0,
         },
         "coils": {
-            "qx_bits": min(max_coils, BUFFER_SIZE * MAX_BITS),
+            "qx_bits": min(max_coils, buffer_size * MAX_BITS),
             "mx_bits": 0,  # No memory support in legacy mode
         },
         "discrete_inputs": {
-            "ix_bits": min(max_discrete_inputs, BUFFER_SIZE * MAX_BITS),
+            "ix_bits": min(max_discrete_inputs, buffer_size * MAX_BITS),
         },
         "input_registers": {
-            "iw_count": min(max_input_registers, BUFFER_SIZE),
+            "iw_count": min(max_input_registers, buffer_size),
         },
         "word_order": "high_word_first",
     }
@@ -948,7 +994,9 @@ def init(args_capsule):
                     logger.debug(f"Available config sections: {list(config_map.keys())}")
 
                 # Parse buffer mapping configuration
-                buffer_config = parse_buffer_mapping_config(config_map)
+                buffer_config = parse_buffer_mapping_config(
+                    config_map, getattr(runtime_args, "buffer_size", BUFFER_SIZE)
+                )
                 logger.info(f"Buffer mapping format: {buffer_config['format']}")
             else:
                 logger.warn(f"Failed to load configuration file: {status} - using defaults")
@@ -960,7 +1008,9 @@ def init(args_capsule):
 
         # Use default configuration if not loaded from file
         if buffer_config is None:
-            buffer_config = parse_buffer_mapping_config({})
+            buffer_config = parse_buffer_mapping_config(
+                {}, getattr(runtime_args, "buffer_size", BUFFER_SIZE)
+            )
             logger.info("Using default buffer mapping configuration")
 
         # Safely access buffer size using validation
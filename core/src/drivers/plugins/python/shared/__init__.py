@@ -7,6 +7,10 @@ buffer access utilities, configuration handling, and type definitions.
 
 # Core buffer access functionality (refactored modular architecture)
 from .safe_buffer_access_refactored import SafeBufferAccess
+from .access_plan import AccessPlan
+
+# Scan-synchronous plugin threads
+from .cycle_waiter import CycleWaiter, CycleToken
 
 # Safe logging access functionality
 from .safe_logging_access import SafeLoggingAccess
@@ -16,7 +20,7 @@ from .plugin_logger import PluginLogger
 
 # Core type definitions
 from .iec_types import IEC_BOOL, IEC_BYTE, IEC_UINT, IEC_UDINT, IEC_ULINT
-from .plugin_runtime_args import PluginRuntimeArgs
+from .plugin_runtime_args import PluginCycleToken, PluginRuntimeArgs
 from .plugin_structure_validator import PluginStructureValidator
 from .capsule_extraction import safe_extract_runtime_args_from_capsule
 
@@ -33,6 +37,11 @@ from .component_interfaces import (
 __all__ = [
     # Core buffer access (refactored)
     'SafeBufferAccess',
+    'AccessPlan',
+
+    # Scan-synchronous plugin threads
+    'CycleWaiter',
+    'CycleToken',
 
     # Safe logging access functionality
     'SafeLoggingAccess',
@@ -45,6 +54,7 @@ __all__ = [
 
     # Core type definitions
     'PluginRuntimeArgs',
+    'PluginCycleToken',
     'PluginStructureValidator',
     'safe_extract_runtime_args_from_capsule',
 
@@ -0,0 +1,286 @@
+"""
+Access Plan for OpenPLC Python Plugin System
+
+This module compiles a plugin's list of I/O points into a fixed access plan
+once, so the per-cycle buffer access does no address parsing, validation or
+per-element dispatch:
+
+- Reads copy each image area the plan touches with a single range read
+  (GenericBufferAccessor.read_buffer_range_into) into a preallocated ctypes
+  array. Point values are then sliced out of that array (or viewed directly
+  through memoryview, which numpy.frombuffer accepts as well).
+
+- Writes journal each point as one journal_write_range entry. Boolean points
+  only use per-bit journal writes for the bits before the first and after the
+  last whole byte, since a range entry carries all 8 bits of every index.
+
+Range reads come from the lock-free per-scan snapshot, falling back to the
+pointer tables under the buffer mutex until the runtime has enabled it.
+"""
+
+import ctypes
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+try:
+    # Try relative imports first (when used as package)
+    from .buffer_accessor import RANGE_VIEW_FORMATS, GenericBufferAccessor
+    from .buffer_validator import BufferValidator
+except ImportError:
+    # Fall back to absolute imports (when testing standalone)
+    from buffer_accessor import RANGE_VIEW_FORMATS, GenericBufferAccessor
+    from buffer_validator import BufferValidator
+
+
+class _PlanSlot:  # pylint: disable=too-few-public-methods
+    """One compiled point: a run of elements (or bits) of one buffer."""
+
+    def __init__(self, buffer_type: str, buffer_idx: int, bit_idx: Optional[int], length: int):
+        self.buffer_type = buffer_type
+        self.buffer_idx = buffer_idx
+        self.bit_idx = bit_idx
+        self.length = length
+        self.offset = 0  # First element relative to the area start, set by compile()
+        # Boolean points: (element offset, bit) of every bit, set by compile()
+        self.bit_refs: Tuple[Tuple[int, int], ...] = ()
+        # Packing buffer for range writes, allocated by compile()
+        self.pack_buffer = None
+
+    def last_index(self) -> int:
+        """Last buffer index the point touches."""
+        if self.bit_idx is None:
+            return self.buffer_idx + self.length - 1
+        return self.buffer_idx + (self.bit_idx + self.length - 1) // 8
+
+
+class _PlanArea:  # pylint: disable=too-few-public-methods,too-many-instance-attributes
+    """The span of one buffer covered by the plan, copied with one range read."""
+
+    def __init__(self, buffer_type: str, journal_type: int, type_obj: Any):
+        self.buffer_type = buffer_type
+        self.journal_type = journal_type
+        self.type_obj = type_obj
+        self.start = 0
+        self.count = 0
+        self.array = None
+        self.view = None
+
+
+class AccessPlan:
+    """
+    Precompiled buffer access for a fixed list of I/O points.
+
+    Points are registered once with add(), which validates them and returns a
+    slot number. Each cycle, read() refreshes every area of the plan and
+    values(slot) / view(slot) return the values of a point; write(slot, values)
+    journals new values for a point.
+
+    A plan is not thread-safe: use one plan per thread or task.
+    """
+
+    def __init__(self, buffer_accessor: GenericBufferAccessor, validator: BufferValidator):
+        """
+        Initialize an empty access plan.
+
+        Args:
+            buffer_accessor: GenericBufferAccessor instance (range reads, type map)
+            validator: BufferValidator instance (point validation)
+        """
+        self.accessor = buffer_accessor
+        self.args = buffer_accessor.args
+        self.validator = validator
+        self._slots: List[_PlanSlot] = []
+        self._areas: Dict[str, _PlanArea] = {}
+        self._compiled = True
+
+    def __len__(self) -> int:
+        return len(self._slots)
+
+    def add(
+        self, buffer_type: str, buffer_idx: int, bit_idx: Optional[int] = None, length: int = 1
+    ) -> Tuple[Optional[int], str]:
+        """
+        Register a point with the plan.
+
+        Args:
+            buffer_type: Buffer type name (e.g., 'bool_input', 'int_output')
+            buffer_idx: First buffer index
+            bit_idx: First bit (required for boolean buffers, which then
+                     continue into the following indexes)
+            length: Number of consecutive elements (bits for boolean buffers)
+
+        Returns:
+            Tuple[Optional[int], str]: (slot, error_message)
+        """
+        journal_type = GenericBufferAccessor.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return None, f"Unknown buffer type: {buffer_type}"
+        if length < 1:
+            return None, f"Invalid point length: {length}"
+
+        slot = _PlanSlot(buffer_type, buffer_idx, bit_idx, length)
+        for index in (buffer_idx, slot.last_index()):
+            is_valid, msg = self.validator.validate_operation_params(buffer_type, index, bit_idx)
+            if not is_valid:
+                return None, msg
+
+        if buffer_type not in self._areas:
+            type_obj, _ = self.accessor.buffer_types.get_buffer_info(buffer_type)
+            self._areas[buffer_type] = _PlanArea(buffer_type, journal_type, type_obj)
+
+        self._slots.append(slot)
+        self._compiled = False
+        return len(self._slots) - 1, "Success"
+
+    def compile(self) -> None:
+        """
+        Size the areas and allocate the arrays. Called by read() and write()
+        after points were added; call it explicitly to keep the allocation out
+        of the first cycle.
+        """
+        for area in self._areas.values():
+            slots = [slot for slot in self._slots if slot.buffer_type == area.buffer_type]
+            area.start = min(slot.buffer_idx for slot in slots)
+            area.count = max(slot.last_index() for slot in slots) - area.start + 1
+            area.array = (area.type_obj.ctype_class * area.count)()
+            area.view = memoryview(area.array).cast("B").cast(
+                RANGE_VIEW_FORMATS[area.type_obj.size_bytes]
+            )
+
+            for slot in slots:
+                slot.offset = slot.buffer_idx - area.start
+                count = slot.length
+                if slot.bit_idx is not None:
+                    slot.bit_refs = tuple(
+                        (slot.offset + (slot.bit_idx + i) // 8, (slot.bit_idx + i) % 8)
+                        for i in range(slot.length)
+                    )
+                    count = slot.last_index() - slot.buffer_idx + 1
+                slot.pack_buffer = (area.type_obj.ctype_class * count)()
+
+        self._compiled = True
+
+    # ------------------------------------------------------------------
+    # Reads
+    # ------------------------------------------------------------------
+
+    def read(self) -> Tuple[bool, str]:
+        """
+        Refresh every area of the plan from the last completed scan.
+
+        Returns:
+            Tuple[bool, str]: (success, error_message)
+        """
+        if not self._compiled:
+            self.compile()
+
+        for area in self._areas.values():
+            success, msg = self.accessor.read_buffer_range_into(
+                area.buffer_type, area.start, area.array
+            )
+            if not success:
+                return False, msg
+        return True, "Success"
+
+    def values(self, slot: int) -> List[Any]:
+        """
+        Values of a point as of the last read(): booleans for boolean
+        buffers, integers otherwise.
+        """
+        point = self._slots[slot]
+        view = self._areas[point.buffer_type].view
+        if point.bit_idx is not None:
+            return [bool((view[offset] >> bit) & 1) for offset, bit in point.bit_refs]
+        return view[point.offset:point.offset + point.length].tolist()
+
+    def view(self, slot: int) -> Optional[memoryview]:
+        """
+        Zero-copy view of a non-boolean point over the area array, valid until
+        the next read(). Returns None for boolean points.
+        """
+        if not self._compiled:
+            self.compile()
+        point = self._slots[slot]
+        if point.bit_idx is not None:
+            return None
+        return self._areas[point.buffer_type].view[point.offset:point.offset + point.length]
+
+    # ------------------------------------------------------------------
+    # Writes
+    # ------------------------------------------------------------------
+
+    def write(self, slot: int, values: Sequence[Any]) -> Tuple[bool, str]:
+        """
+        Journal new values for a point. Fewer values than the point length
+        update only the leading elements.
+
+        Returns:
+            Tuple[bool, str]: (success, error_message)
+        """
+        if not self._compiled:
+            self.compile()
+
+        point = self._slots[slot]
+        count = min(len(values), point.length)
+        if count == 0:
+            return False, "No values provided"
+
+        area = self._areas[point.buffer_type]
+        try:
+            if point.bit_idx is not None:
+                result = self._write_bits(area, point, values, count)
+            else:
+                mask = (1 << (area.type_obj.size_bytes * 8)) - 1
+                packed = point.pack_buffer
+                for i in range(count):
+                    packed[i] = int(values[i]) & mask
+                result = self.args.journal_write_range(
+                    area.journal_type, point.buffer_idx, count, ctypes.addressof(packed)
+                )
+            if result != 0:
+                return False, f"Journal write failed with code {result}"
+            return True, "Success"
+
+        except (AttributeError, TypeError, ValueError, OSError) as e:
+            return False, f"Buffer write error: {e}"
+
+    def _write_bits(self, area: _PlanArea, point: _PlanSlot, values: Sequence[Any], count: int) -> int:
+        """Journal count bits of a boolean point; returns the first non-zero result."""
+        journal_type = area.journal_type
+        write_bool = self.args.journal_write_bool
+        index, bit = point.buffer_idx, point.bit_idx
+        i = 0
+
+        # Bits before the first whole byte
+        while i < count and (bit != 0 or count - i < 8):
+            result = write_bool(journal_type, index, bit, 1 if values[i] else 0)
+            if result != 0:
+                return result
+            i += 1
+            bit += 1
+            if bit == 8:
+                index, bit = index + 1, 0
+
+        # Whole bytes as one range entry
+        full_bytes = (count - i) // 8
+        if full_bytes:
+            packed = point.pack_buffer
+            for byte in range(full_bytes):
+                value = 0
+                for b in range(8):
+                    if values[i + b]:
+                        value |= 1 << b
+                packed[byte] = value
+                i += 8
+            result = self.args.journal_write_range(
+                journal_type, index, full_bytes, ctypes.addressof(packed)
+            )
+            if result != 0:
+                return result
+            index += full_bytes
+
+        # Bits after the last whole byte
+        for b in range(count - i):
+            result = write_bool(journal_type, index, b, 1 if values[i + b] else 0)
+            if result != 0:
+                return result
+        return 0
@@ -117,7 +117,22 @@ class BatchProcessor(IBatchProcessor):
             return [], "Failed to acquire mutex for batch write"
 
         try:
-            for operation in operations:
+            i = 0
+            while i < len(operations):
+                # Journal runs of consecutive non-boolean writes as one range entry
+                run = self._contiguous_run_length(operations, i)
+                if run > 1:
+                    operation = operations[i]
+                    values = [op[2] for op in operations[i:i + run]]
+                    success, msg = self.accessor.write_buffer_range(operation[0], operation[1], values)
+                    if success:
+                        results.extend([(True, msg)] * run)
+                        i += run
+                        continue
+                    # Fall back to per-element writes so each result is reported individually
+
+                operation = operations[i]
+                i += 1
                 try:
                     if len(operation) < 3:
                         results.append((False, "Invalid operation format"))
@@ -142,6 +157,28 @@ class BatchProcessor(IBatchProcessor):
             # Always release the mutex
             self.mutex.release()
 
+    @staticmethod
+    def _contiguous_run_length(operations: List[Tuple], start: int) -> int:
+        """
+        Count consecutive write operations starting at `start` that target the
+        same non-boolean buffer at increasing indices.
+
+        Returns 0 when the operation at `start` cannot be part of a range.
+        """
+        first = operations[start]
+        if len(first) != 3 or not isinstance(first[0], str) or first[0].startswith("bool"):
+            return 0
+        if not isinstance(first[1], int):
+            return 0
+
+        run = 1
+        while start + run < len(operations):
+            op = operations[start + run]
+            if len(op) != 3 or op[0] != first[0] or op[1] != first[1] + run:
+                break
+            run += 1
+        return run
+
     def process_mixed_operations(self, read_operations: List[Tuple],
                                write_operations: List[Tuple]) -> Tuple[Dict, str]:
         """
@@ -10,7 +10,7 @@ for reading and writing buffer values.
 """
 
 import ctypes
-from typing import Any, Optional, Tuple
+from typing import Any, Optional, Sequence, Tuple
 
 try:
     # Try relative imports first (when used as package)
@@ -25,6 +25,15 @@ except ImportError:
     from component_interfaces import IBufferAccessor
     from mutex_manager import MutexManager
 
+try:
+    # Bulk range access, compiled into the runtime (absent outside of it)
+    import openplc_buffers
+except ImportError:
+    openplc_buffers = None
+
+# Native memoryview formats per element width (ctypes arrays export "<H" etc.)
+RANGE_VIEW_FORMATS = {1: "B", 2: "H", 4: "I", 8: "Q"}
+
 
 class GenericBufferAccessor(IBufferAccessor):
     """
@@ -35,7 +44,12 @@ class GenericBufferAccessor(IBufferAccessor):
     massive code duplication that existed in the original SafeBufferAccess class.
 
     Write operations use the journal buffer system for race-condition-free writes.
-    Read operations access buffers directly (reads are always safe).
+    Read operations use the runtime's lock-free per-scan snapshot when it is
+    available, and otherwise access buffers directly under the mutex.
+
+    Range operations go through the runtime's openplc_buffers module when the
+    runtime args came from a capsule, so a whole range costs one C call with
+    one validation instead of per-element ctypes marshalling.
     """
 
     # Journal buffer type mapping (matches journal_buffer_type_t enum)
@@ -69,6 +83,8 @@ class GenericBufferAccessor(IBufferAccessor):
         self.validator = validator
         self.mutex = mutex_manager
         self.buffer_types = get_buffer_types()
+        # Capsule kept on the args by safe_extract_runtime_args_from_capsule()
+        self.capsule = getattr(runtime_args, "capsule", None) if openplc_buffers else None
 
     def read_buffer(
         self,
@@ -97,6 +113,11 @@ class GenericBufferAccessor(IBufferAccessor):
         # Get buffer type info
         buffer_type_obj, direction = self.buffer_types.get_buffer_info(buffer_type)
 
+        # Lock-free path: values from the last completed scan, no mutex needed
+        snapshot_result = self._perform_snapshot_read(buffer_type, buffer_type_obj, buffer_idx, bit_idx)
+        if snapshot_result is not None:
+            return snapshot_result
+
         # Define the read operation
         def do_read():
             return self._perform_read(buffer_type, buffer_type_obj, direction, buffer_idx, bit_idx)
@@ -148,6 +169,208 @@ class GenericBufferAccessor(IBufferAccessor):
             buffer_type, buffer_type_obj, direction, buffer_idx, value, bit_idx
         )
 
+    def write_buffer_range(
+        self,
+        buffer_type: str,
+        start_idx: int,
+        values: Sequence[int],
+    ) -> Tuple[bool, str]:
+        """
+        Write consecutive non-boolean values as a single journal range entry.
+
+        The values are packed into a native array of the buffer element type
+        and journaled with one call, instead of one journal entry per element.
+
+        Args:
+            buffer_type: Buffer type name (e.g., 'int_output', 'dint_memory')
+            start_idx: First buffer index
+            values: Values for start_idx, start_idx + 1, ...
+
+        Returns:
+            Tuple[bool, str]: (success, error_message)
+        """
+        if not values:
+            return False, "No values provided"
+
+        journal_type = self.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return False, f"Unknown buffer type: {buffer_type}"
+
+        buffer_type_obj, _ = self.buffer_types.get_buffer_info(buffer_type)
+        if buffer_type_obj.requires_bit_index:
+            return False, "Range writes are not supported for boolean buffers"
+
+        for offset, value in enumerate(values):
+            is_valid, msg = self.validator.validate_operation_params(
+                buffer_type, start_idx + offset, None, value
+            )
+            if not is_valid:
+                return False, msg
+
+        if not self.capsule and not getattr(self.args, "journal_write_range", None):
+            return False, "Journal range write not available"
+
+        try:
+            mask = (1 << (buffer_type_obj.size_bytes * 8)) - 1
+            packed = (buffer_type_obj.ctype_class * len(values))(
+                *[int(value) & mask for value in values]
+            )
+            if self.capsule:
+                openplc_buffers.write_range(self.capsule, journal_type, start_idx, packed)
+                return True, "Success"
+            result = self.args.journal_write_range(
+                journal_type, start_idx, len(values), ctypes.cast(packed, ctypes.c_void_p)
+            )
+            if result != 0:
+                return False, f"Journal range write failed with code {result}"
+            return True, "Success"
+
+        except (AttributeError, TypeError, ValueError, OSError, MemoryError, RuntimeError) as e:
+            return False, f"Buffer range write error: {e}"
+
+    def read_buffer_range(
+        self, buffer_type: str, start_idx: int, count: int
+    ) -> Tuple[Optional[memoryview], str]:
+        """
+        Read consecutive elements with a single range copy.
+
+        Args:
+            buffer_type: Buffer type name (e.g., 'int_output', 'bool_input')
+            start_idx: First buffer index
+            count: Number of elements
+
+        Returns:
+            Tuple[Optional[memoryview], str]: (values, error_message). values is a
+            memoryview of native integers; for boolean buffers each element is
+            one byte holding the 8 bits of its index.
+        """
+        journal_type = self.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return None, f"Unknown buffer type: {buffer_type}"
+
+        try:
+            buffer_type_obj, _ = self.buffer_types.get_buffer_info(buffer_type)
+            view_format = RANGE_VIEW_FORMATS[buffer_type_obj.size_bytes]
+
+            if self.capsule:
+                data = openplc_buffers.read_range(self.capsule, journal_type, start_idx, count)
+                return memoryview(data).cast(view_format), "Success"
+
+            if count < 1:
+                return None, f"Invalid range count: {count}"
+            for index in (start_idx, start_idx + count - 1):
+                is_valid, msg = self.validator.validate_buffer_index(index, buffer_type)
+                if not is_valid:
+                    return None, msg
+            dest = (buffer_type_obj.ctype_class * count)()
+            success, msg = self.read_buffer_range_into(buffer_type, start_idx, dest)
+            if not success:
+                return None, msg
+            return memoryview(dest).cast("B").cast(view_format), "Success"
+
+        except (AttributeError, TypeError, ValueError, OSError, MemoryError, RuntimeError) as e:
+            return None, f"Buffer range read error: {e}"
+
+    def read_buffer_range_into(self, buffer_type: str, start_idx: int, dest) -> Tuple[bool, str]:
+        """
+        Fill a preallocated ctypes array of the buffer element type with the
+        elements starting at start_idx, packed like read_buffer_range().
+        The range is not validated on the Python fallback path; callers size
+        dest from validated indexes.
+
+        Returns:
+            Tuple[bool, str]: (success, error_message)
+        """
+        journal_type = self.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return False, f"Unknown buffer type: {buffer_type}"
+
+        try:
+            if self.capsule:
+                openplc_buffers.read_range_into(self.capsule, journal_type, start_idx, dest)
+                return True, "Success"
+
+            count = len(dest)
+            read_snapshot = getattr(self.args, "read_image_snapshot", None)
+            if read_snapshot and read_snapshot(
+                journal_type, start_idx, count, ctypes.addressof(dest)
+            ) == count:
+                return True, "Success"
+
+            return self.mutex.with_mutex(
+                lambda: self._perform_range_read(buffer_type, start_idx, dest)
+            )
+
+        except (AttributeError, TypeError, ValueError, OSError, MemoryError, RuntimeError) as e:
+            return False, f"Buffer range read error: {e}"
+
+    def read_buffer_changes_into(
+        self, buffer_type: str, start_idx: int, dest, changes, generation: int
+    ) -> Tuple[Optional[int], str]:
+        """
+        Fill dest like read_buffer_range_into() and the ctypes byte array
+        changes with the elements that changed since the read that returned
+        generation (0 the first time): for bool buffers one byte per index
+        whose bits are the changed bits, else bit k % 8 of byte k // 8 for
+        element start_idx + k. After missed scans every bit is set, so a
+        plugin that sends the set bits never loses a change.
+
+        Returns:
+            Tuple[Optional[int], str]: (generation to pass to the next read, or
+            None if the runtime cannot provide the changes yet, error_message)
+        """
+        journal_type = self.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return None, f"Unknown buffer type: {buffer_type}"
+
+        read_changes = getattr(self.args, "read_image_changes", None)
+        if not read_changes:
+            return None, "Image changes are not provided by the runtime"
+
+        try:
+            count = len(dest)
+            since = ctypes.c_uint(generation)
+            copied = read_changes(
+                journal_type,
+                start_idx,
+                count,
+                ctypes.addressof(dest),
+                ctypes.addressof(changes),
+                ctypes.byref(since),
+            )
+            if copied != count:
+                return None, "Image changes not available yet"
+            return since.value, "Success"
+
+        except (AttributeError, TypeError, ValueError, OSError) as e:
+            return None, f"Image changes read error: {e}"
+
+    def open_image_view(self, buffer_type: str) -> Tuple[Optional[Any], str]:
+        """
+        Create a zero-copy, read-only view of a buffer's per-scan snapshot.
+
+        memoryview(view) exposes the latest snapshot (one element per index,
+        packed like read_buffer_range()) without copying or locking. Slice the
+        memoryview first and then call view.valid(): if it returns False the
+        scan overwrote the snapshot meanwhile and the slice must be discarded.
+        memoryview() raises BufferError until the runtime has filled the
+        snapshot once.
+
+        Returns:
+            Tuple[Optional[Any], str]: (view, error_message). The view is None
+            when the runtime does not provide openplc_buffers.
+        """
+        journal_type = self.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return None, f"Unknown buffer type: {buffer_type}"
+        if not self.capsule:
+            return None, "Image views require the openplc_buffers module"
+
+        try:
+            return openplc_buffers.image_view(self.capsule, journal_type), "Success"
+        except (TypeError, ValueError) as e:
+            return None, f"Image view error: {e}"
+
     def get_buffer_pointer(self, buffer_type: str) -> Optional[ctypes.POINTER]:
         """
         Get the buffer pointer for a given type.
@@ -188,6 +411,70 @@ class GenericBufferAccessor(IBufferAccessor):
         except (AttributeError, TypeError, ValueError):
             return None
 
+    def _perform_snapshot_read(
+        self,
+        buffer_type: str,
+        buffer_type_obj,
+        buffer_idx: int,
+        bit_idx: Optional[int],
+    ) -> Optional[Tuple[Any, str]]:
+        """
+        Read a value from the runtime snapshot published at the end of each scan.
+
+        Returns None when the snapshot is not available (older runtime, or the
+        area has not been refreshed yet) so the caller falls back to a locked read.
+        """
+        read_snapshot = getattr(self.args, "read_image_snapshot", None)
+        if not read_snapshot:
+            return None
+
+        journal_type = self.JOURNAL_TYPE_MAP.get(buffer_type)
+        if journal_type is None:
+            return None
+
+        if buffer_type_obj.name == "bool" and bit_idx is None:
+            return None, "Bit index required for boolean operations"
+
+        try:
+            cell = buffer_type_obj.ctype_class()
+            copied = read_snapshot(journal_type, buffer_idx, 1, ctypes.addressof(cell))
+            if copied != 1:
+                return None
+
+            if buffer_type_obj.name == "bool":
+                # Snapshot bool areas are bit-packed, one byte per index
+                return bool((cell.value >> bit_idx) & 1), "Success"
+            return cell.value, "Success"
+
+        except (AttributeError, TypeError, ValueError, OSError) as e:
+            return None, f"Snapshot read error: {e}"
+
+    def _perform_range_read(self, buffer_type: str, start_idx: int, dest) -> Tuple[bool, str]:
+        """
+        Locked fallback of read_buffer_range_into(): fill dest from the pointer
+        tables. Unbound locations read as 0.
+        """
+        try:
+            buffer_ptr = self.get_buffer_pointer(buffer_type)
+            if buffer_ptr is None or not buffer_ptr:
+                return False, f"Buffer pointer not available for {buffer_type}"
+
+            buffer_type_obj, _ = self.buffer_types.get_buffer_info(buffer_type)
+            for offset in range(len(dest)):
+                element = buffer_ptr[start_idx + offset]
+                if buffer_type_obj.requires_bit_index:
+                    value = 0
+                    for bit in range(8):
+                        if element[bit] and element[bit].contents.value:
+                            value |= 1 << bit
+                    dest[offset] = value
+                else:
+                    dest[offset] = element.contents.value if element else 0
+            return True, "Success"
+
+        except (AttributeError, TypeError, ValueError, OSError, MemoryError) as e:
+            return False, f"Buffer read error: {e}"
+
     def _perform_read(
         self,
         buffer_type: str,
@@ -38,6 +38,8 @@ def safe_extract_runtime_args_from_capsule(capsule):
             return None, "Failed to cast pointer to PluginRuntimeArgs structure"
 
         runtime_args = args_ptr.contents
+        # Keep the capsule for the openplc_buffers range functions
+        runtime_args.capsule = capsule
 
         # Validate the extracted structure
         is_valid, validation_msg = runtime_args.validate_pointers()
@@ -0,0 +1,109 @@
+"""
+Cycle Waiter for OpenPLC Python Plugin System
+
+Python plugins run in their own threads and are not called from the scan
+cycle. Instead of polling with time.sleep, a plugin thread can block in
+CycleWaiter.wait() until the next PLC scan has completed: the scan thread
+posts each scan to a per-plugin signal and wakes the waiting thread, without
+ever blocking on it.
+
+The signal only holds the latest scan. A thread that takes longer than a
+scan to process one gets the newest scan next, with token.missed counting
+the scans it skipped.
+"""
+
+import ctypes
+from collections import namedtuple
+from typing import Callable, Optional, Tuple
+
+try:
+    # Try relative imports first (when used as package)
+    from .plugin_runtime_args import PluginCycleToken
+except ImportError:
+    # Fall back to absolute imports (when testing standalone)
+    from plugin_runtime_args import PluginCycleToken
+
+# One completed scan: scan counter, image snapshot generation (0 if the
+# snapshot is not enabled) and scans skipped since the previous token
+CycleToken = namedtuple("CycleToken", ["cycle", "generation", "missed"])
+
+
+class CycleWaiter:
+    """
+    Blocks a plugin thread until the next PLC scan completes.
+
+    Only one thread per plugin may wait. The ctypes call releases the GIL
+    while it blocks, so other Python threads keep running.
+    """
+
+    def __init__(self, runtime_args):
+        """
+        Initialize the waiter.
+
+        Args:
+            runtime_args: PluginRuntimeArgs instance
+        """
+        self.args = runtime_args
+        self._wait_cycle = getattr(runtime_args, "wait_cycle", None) or None
+        self._signal = getattr(runtime_args, "cycle_signal", None)
+        self._token = PluginCycleToken()
+        self._token_ref = ctypes.byref(self._token)
+
+        self.is_valid = bool(self._wait_cycle and self._signal)
+        self.error_msg = "" if self.is_valid else "Runtime provides no cycle signal"
+
+        # Totals over the lifetime of this waiter
+        self.cycles = 0
+        self.missed = 0
+
+    def wait(self, timeout: Optional[float] = None) -> Tuple[Optional[CycleToken], str]:
+        """
+        Wait for a scan newer than the last one returned.
+
+        Returns at once without a token while the plugin is being stopped,
+        so callers should check their stop flag whenever no token is returned.
+
+        Args:
+            timeout: Maximum time to wait in seconds, None to wait indefinitely
+
+        Returns:
+            Tuple[Optional[CycleToken], str]: (token, error_message)
+        """
+        if not self.is_valid:
+            return None, self.error_msg
+
+        timeout_ms = -1 if timeout is None else max(0, int(timeout * 1000))
+        result = self._wait_cycle(self._signal, timeout_ms, self._token_ref)
+        if result == 1:
+            token = CycleToken(self._token.cycle, self._token.generation, self._token.missed)
+            self.cycles += 1
+            self.missed += token.missed
+            return token, "Success"
+        if result == 0:
+            return None, "Timeout"
+        return None, f"wait_cycle failed with code {result}"
+
+    def run(
+        self, callback: Callable[[CycleToken], None], stop_event, timeout: float = 0.5
+    ) -> Tuple[bool, str]:
+        """
+        Call callback(token) once per scan until stop_event is set.
+
+        Args:
+            callback: Called with each CycleToken
+            stop_event: threading.Event that ends the loop
+            timeout: Longest time between two stop_event checks, in seconds
+
+        Returns:
+            Tuple[bool, str]: (success, error_message)
+        """
+        if not self.is_valid:
+            return False, self.error_msg
+
+        while not stop_event.is_set():
+            token, msg = self.wait(timeout)
+            if token is not None:
+                callback(token)
+            elif msg != "Timeout":
+                return False, msg
+        return True, "Success"
@@ -73,6 +73,10 @@ class ModbusDeviceConfig:
         self.host: str = "127.0.0.1"
         self.port: int = 502
         self.timeout_ms: int = 1000
+        # Unconfigured registers/coils a merged read may span between points
+        self.max_read_gap: int = 0
+        # "thread" polls from a dedicated thread, "async" from the shared event loop
+        self.scheduler: str = "thread"
         self.io_points: List['ModbusIoPointConfig'] = []
 
     @classmethod
@@ -89,6 +93,8 @@ class ModbusDeviceConfig:
         device.host = config.get("host", "127.0.0.1")
         device.port = config.get("port", 502)
         device.timeout_ms = config.get("timeout_ms", 1000)
+        device.max_read_gap = config.get("max_read_gap", 0)
+        device.scheduler = config.get("scheduler", "thread")
 
         # Parse I/O points
         io_points_data = config.get("io_points", [])
@@ -110,6 +116,10 @@ class ModbusDeviceConfig:
             raise ValueError(f"Invalid port: {self.port}. Must be a positive integer for device {self.name}.")
         if not isinstance(self.timeout_ms, int) or self.timeout_ms <= 0:
             raise ValueError(f"Invalid timeout_ms: {self.timeout_ms}. Must be a positive integer for device {self.name}.")
+        if not isinstance(self.max_read_gap, int) or self.max_read_gap < 0:
+            raise ValueError(f"Invalid max_read_gap: {self.max_read_gap}. Must be a non-negative integer for device {self.name}.")
+        if self.scheduler not in ("thread", "async"):
+            raise ValueError(f"Invalid scheduler: {self.scheduler}. Expected 'thread' or 'async' for device {self.name}.")
 
         for i, point in enumerate(self.io_points):
             if not isinstance(point, ModbusIoPointConfig):
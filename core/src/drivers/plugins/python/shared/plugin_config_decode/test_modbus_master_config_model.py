@@ -83,6 +83,22 @@ def test_device_from_dict_and_validate():
     dev = ModbusDeviceConfig.from_dict(data)
     assert dev.name == "Dev1"
     dev.validate()  # should not raise
+    assert dev.max_read_gap == 0
+    assert dev.scheduler == "thread"
+
+def test_device_invalid_max_read_gap():
+    dev = ModbusDeviceConfig()
+    dev.name = "Gap"
+    dev.max_read_gap = -1
+    with pytest.raises(ValueError):
+        dev.validate()
+
+def test_device_invalid_scheduler():
+    dev = ModbusDeviceConfig()
+    dev.name = "Sched"
+    dev.scheduler = "process"
+    with pytest.raises(ValueError):
+        dev.validate()
 
 def test_device_invalid_fc():
     dev = ModbusDeviceConfig()
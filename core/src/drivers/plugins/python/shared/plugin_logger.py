@@ -39,7 +39,7 @@ class PluginLogger:
         is_valid: True if the logger is properly connected to central logging
     """
 
-    def __init__(self, plugin_name: str, runtime_args=None):
+    def __init__(self, plugin_name: str, runtime_args=None, rate_limited: bool = False):
         """
         Initialize the plugin logger.
 
@@ -48,6 +48,8 @@ class PluginLogger:
                         This will be used as a prefix in all log messages.
             runtime_args: PluginRuntimeArgs instance containing logging function
                          pointers. If None, logger will fall back to print().
+            rate_limited: Limit repeated identical messages in the runtime, for
+                         plugins that log per failed request.
         """
         self.plugin_name = plugin_name
         self._prefix = f"[{plugin_name}]"
@@ -55,7 +57,7 @@ class PluginLogger:
         self._is_valid = False
 
         if runtime_args is not None:
-            self._logging_access = SafeLoggingAccess(runtime_args)
+            self._logging_access = SafeLoggingAccess(runtime_args, rate_limited)
             if self._logging_access.is_valid:
                 self._is_valid = True
             else:
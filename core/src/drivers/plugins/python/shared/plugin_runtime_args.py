@@ -11,6 +11,19 @@ import ctypes
 # Import IEC type definitions
 from .iec_types import IEC_BOOL, IEC_BYTE, IEC_UDINT, IEC_UINT, IEC_ULINT
 
+# Largest image table size the runtime accepts (IMAGE_TABLE_MAX_SIZE in image_tables.h)
+MAX_BUFFER_SIZE = 262144
+
+
+class PluginCycleToken(ctypes.Structure):
+    """Python ctypes structure matching plugin_cycle_token_t from plugin_types.h"""
+
+    _fields_ = [
+        ("cycle", ctypes.c_ulonglong),
+        ("generation", ctypes.c_uint),
+        ("missed", ctypes.c_uint),
+    ]
+
 
 class PluginRuntimeArgs(ctypes.Structure):
     """
@@ -57,6 +70,34 @@ class PluginRuntimeArgs(ctypes.Structure):
         ("journal_write_int", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int)),
         ("journal_write_dint", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_uint)),
         ("journal_write_lint", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_ulonglong)),
+        # int (*func)(int type, int start_index, int count, const void *values)
+        ("journal_write_range", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_void_p)),
+        # Packed image areas: const void *(*func)(int type, int *length)
+        ("get_image_area", ctypes.CFUNCTYPE(ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(ctypes.c_int))),
+        # Lock-free snapshot reads: int (*func)(int type, int start_index, int count, void *dest)
+        ("read_image_snapshot", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_void_p)),
+        # Log source identity and void (*func)(int source, int level, const char *message)
+        ("plugin_id", ctypes.c_int),
+        ("log_message", ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_int, ctypes.c_char_p)),
+        # void (*func)(int source, int level, unsigned int key, const char *message)
+        ("log_limited", ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_int, ctypes.c_uint, ctypes.c_char_p)),
+        # Scan notifications: int (*func)(void *signal, int timeout_ms, plugin_cycle_token_t *token)
+        ("cycle_signal", ctypes.c_void_p),
+        ("wait_cycle", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(PluginCycleToken))),
+        # Metrics: int (*func)(int source, const char *name, const char *help, int type)
+        ("metric_register", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int)),
+        # void (*func)(int handle, long long delta) and void (*func)(int handle, long long value)
+        ("metric_add", ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_longlong)),
+        ("metric_set", ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_longlong)),
+        # Change-of-value reads: int (*func)(int type, int start_index, int count, void *dest,
+        #                                    void *changes, unsigned int *generation)
+        ("read_image_changes", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+                                                ctypes.c_void_p, ctypes.c_void_p,
+                                                ctypes.POINTER(ctypes.c_uint))),
+        # Labelled metrics: int (*func)(int source, const char *name, const char *help, int type,
+        #                               const char *labels)
+        ("metric_register_labels", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, ctypes.c_char_p,
+                                                    ctypes.c_char_p, ctypes.c_int, ctypes.c_char_p)),
     ]
 
     def validate_pointers(self):
@@ -76,7 +117,7 @@ class PluginRuntimeArgs(ctypes.Structure):
                 return False, "mutex_give function pointer is NULL"
 
             # Check buffer size is reasonable
-            if self.buffer_size <= 0 or self.buffer_size > 10000:
+            if self.buffer_size <= 0 or self.buffer_size > MAX_BUFFER_SIZE:
                 return False, f"buffer_size is invalid: {self.buffer_size}"
 
             if self.bits_per_buffer <= 0 or self.bits_per_buffer > 64:
@@ -102,7 +143,7 @@ class PluginRuntimeArgs(ctypes.Structure):
                 return -1, f"Validation failed: {msg}"
 
             size = self.buffer_size
-            if size <= 0 or size > 10000:
+            if size <= 0 or size > MAX_BUFFER_SIZE:
                 return -1, f"Invalid buffer size: {size}"
 
             return size, "Success"
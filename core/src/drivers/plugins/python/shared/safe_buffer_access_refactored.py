@@ -7,10 +7,11 @@ This module provides the refactored SafeBufferAccess class that maintains
 
 # pylint: disable=too-many-instance-attributes,too-many-public-methods
 
-from typing import Any, Dict, List, Tuple
+from typing import Any, Dict, List, Optional, Tuple
 
 try:
     # Try relative imports first (when used as package)
+    from .access_plan import AccessPlan
     from .batch_processor import BatchProcessor
     from .buffer_accessor import GenericBufferAccessor
     from .buffer_types import get_buffer_types
@@ -21,6 +22,7 @@ try:
     from .mutex_manager import MutexManager
 except ImportError:
     # Fall back to absolute imports (when testing standalone)
+    from access_plan import AccessPlan
     from batch_processor import BatchProcessor
     from buffer_accessor import GenericBufferAccessor
     from buffer_types import get_buffer_types
@@ -294,6 +296,45 @@ class SafeBufferAccess(ISafeBufferAccess):
         """Process mixed read and write operations in batch."""
         return self.batch_processor.process_mixed_operations(read_operations, write_operations)
 
+    def read_range(
+        self, buffer_type: str, start_idx: int, count: int
+    ) -> Tuple[Optional[memoryview], str]:
+        """
+        Read count consecutive elements of a buffer with one range copy.
+        Boolean buffers return one byte per index holding its 8 bits.
+        """
+        return self.buffer_accessor.read_buffer_range(buffer_type, start_idx, count)
+
+    def write_range(self, buffer_type: str, start_idx: int, values: List[int]) -> Tuple[bool, str]:
+        """Journal consecutive non-boolean values as a single range entry."""
+        return self.buffer_accessor.write_buffer_range(buffer_type, start_idx, values)
+
+    def read_changes_into(
+        self, buffer_type: str, start_idx: int, dest, changes, generation: int
+    ) -> Tuple[Optional[int], str]:
+        """
+        Read a range and the elements of it that changed since the previous
+        read; see GenericBufferAccessor.read_buffer_changes_into().
+        """
+        return self.buffer_accessor.read_buffer_changes_into(
+            buffer_type, start_idx, dest, changes, generation
+        )
+
+    def open_image_view(self, buffer_type: str) -> Tuple[Optional[Any], str]:
+        """
+        Create a zero-copy view of a buffer's per-scan snapshot; see
+        GenericBufferAccessor.open_image_view() for the read protocol.
+        """
+        return self.buffer_accessor.open_image_view(buffer_type)
+
+    def create_access_plan(self) -> AccessPlan:
+        """
+        Create an empty access plan. Register the plugin's I/O points once
+        with AccessPlan.add(), then access them every cycle with read() /
+        values() and write() instead of per-element calls.
+        """
+        return AccessPlan(self.buffer_accessor, self.validator)
+
     # ============================================================================
     # Debug/Variable Operations
     # ============================================================================
@@ -5,17 +5,45 @@ Safe Logging Access Module
 This module provides safe logging operations for OpenPLC Python plugins
 """
 
+# Level values of plugin_runtime_args_t.log_message (PLUGIN_LOG_LEVEL_* in plugin_types.h)
+PLUGIN_LOG_LEVEL_DEBUG = 0
+PLUGIN_LOG_LEVEL_INFO = 1
+PLUGIN_LOG_LEVEL_WARN = 2
+PLUGIN_LOG_LEVEL_ERROR = 3
+
+
 class SafeLoggingAccess:
     """Wrapper class for safe logging operations with validation"""
 
-    def __init__(self, runtime_args):
+    def __init__(self, runtime_args, rate_limited=False):
         """
         Initialize with validated runtime args
         Args:
             runtime_args: PluginRuntimeArgs instance
+            rate_limited: Send through the runtime rate limiter, so repeats of the
+                          same message beyond a short burst are summarized
         """
         self.args = runtime_args
         self.is_valid, self.error_msg = self._validate_logging_functions()
+        # Preformatted logging tagged with the plugin id, NULL if not provided
+        self._log_message = getattr(runtime_args, 'log_message', None) or None
+        self._plugin_id = getattr(runtime_args, 'plugin_id', 0)
+        self._log_limited = None
+        if rate_limited:
+            self._log_limited = getattr(runtime_args, 'log_limited', None) or None
+
+    def _send(self, level, log_func, message_bytes):
+        """
+        Hand a message to the runtime, tagged with the plugin id when possible.
+        log_message does not treat the message as a format string, so '%' is safe.
+        """
+        if self._log_limited:
+            # Key 0: identical messages share one limit
+            self._log_limited(self._plugin_id, level, 0, message_bytes)
+        elif self._log_message:
+            self._log_message(self._plugin_id, level, message_bytes)
+        else:
+            log_func(message_bytes)
 
     def _validate_logging_functions(self):
         """
@@ -81,7 +109,7 @@ class SafeLoggingAccess:
             message_bytes = message.encode('utf-8')
 
             # Call the C logging function
-            self.args.log_info(message_bytes)
+            self._send(PLUGIN_LOG_LEVEL_INFO, self.args.log_info, message_bytes)
             return True, "Success"
 
         except (AttributeError, TypeError, ValueError, OverflowError, OSError, MemoryError) as e:
@@ -105,7 +133,7 @@ class SafeLoggingAccess:
             message_bytes = message.encode('utf-8')
 
             # Call the C logging function
-            self.args.log_debug(message_bytes)
+            self._send(PLUGIN_LOG_LEVEL_DEBUG, self.args.log_debug, message_bytes)
             return True, "Success"
 
         except (AttributeError, TypeError, ValueError, OverflowError, OSError, MemoryError) as e:
@@ -129,7 +157,7 @@ class SafeLoggingAccess:
             message_bytes = message.encode('utf-8')
 
             # Call the C logging function
-            self.args.log_warn(message_bytes)
+            self._send(PLUGIN_LOG_LEVEL_WARN, self.args.log_warn, message_bytes)
             return True, "Success"
 
         except (AttributeError, TypeError, ValueError, OverflowError, OSError, MemoryError) as e:
@@ -153,7 +181,7 @@ class SafeLoggingAccess:
             message_bytes = message.encode('utf-8')
 
             # Call the C logging function
-            self.args.log_error(message_bytes)
+            self._send(PLUGIN_LOG_LEVEL_ERROR, self.args.log_error, message_bytes)
             return True, "Success"
 
         except (AttributeError, TypeError, ValueError, OverflowError, OSError, MemoryError) as e:
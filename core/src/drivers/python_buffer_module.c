@@ -0,0 +1,518 @@
+#include "python_plugin_bridge.h"
+
+#include "../plc_app/image_shadow.h"
+#include "../plc_app/journal_buffer.h"
+#include "python_buffer_module.h"
+#include "plugin_types.h"
+#include <stdint.h>
+#include <string.h>
+
+#define RUNTIME_ARGS_CAPSULE_NAME "openplc_runtime_args"
+
+// Get the runtime args of a plugin capsule; sets a Python exception on failure
+static plugin_runtime_args_t *args_from_capsule(PyObject *capsule)
+{
+    return (plugin_runtime_args_t *)PyCapsule_GetPointer(capsule, RUNTIME_ARGS_CAPSULE_NAME);
+}
+
+// Validate a whole range once; returns the element width or 0 with a Python exception set
+static size_t check_range(const plugin_runtime_args_t *args, int type, Py_ssize_t start,
+                          Py_ssize_t count)
+{
+    if (type < 0 || type >= JOURNAL_TYPE_COUNT)
+    {
+        PyErr_Format(PyExc_ValueError, "unknown buffer type %d", type);
+        return 0;
+    }
+    if (start < 0 || count < 1 || start > args->buffer_size - count)
+    {
+        PyErr_Format(PyExc_ValueError, "range %zd+%zd outside buffer of %d elements", start,
+                     count, args->buffer_size);
+        return 0;
+    }
+    return journal_type_width((journal_buffer_type_t)type);
+}
+
+// Pack one bit-addressed index of a BOOL pointer table into a byte
+static uint8_t pack_bools(IEC_BOOL *bits[8])
+{
+    uint8_t value = 0;
+    for (int b = 0; b < 8; b++)
+    {
+        if (bits[b] && *bits[b])
+        {
+            value |= (uint8_t)(1u << b);
+        }
+    }
+    return value;
+}
+
+// Copy count elements from the pointer tables; unbound locations read as 0
+static void copy_pointer_tables(const plugin_runtime_args_t *args, int type, int start, int count,
+                                uint8_t *dest)
+{
+    size_t width = journal_type_width((journal_buffer_type_t)type);
+    memset(dest, 0, (size_t)count * width);
+
+    for (int i = 0; i < count; i++)
+    {
+        int index     = start + i;
+        uint8_t *cell = dest + (size_t)i * width;
+        const void *src = NULL;
+
+        switch ((journal_buffer_type_t)type)
+        {
+            case JOURNAL_BOOL_INPUT:
+                *cell = pack_bools(args->bool_input[index]);
+                break;
+            case JOURNAL_BOOL_OUTPUT:
+                *cell = pack_bools(args->bool_output[index]);
+                break;
+            case JOURNAL_BOOL_MEMORY:
+                *cell = pack_bools(args->bool_memory[index]);
+                break;
+            case JOURNAL_BYTE_INPUT:
+                src = args->byte_input[index];
+                break;
+            case JOURNAL_BYTE_OUTPUT:
+                src = args->byte_output[index];
+                break;
+            case JOURNAL_INT_INPUT:
+                src = args->int_input[index];
+                break;
+            case JOURNAL_INT_OUTPUT:
+                src = args->int_output[index];
+                break;
+            case JOURNAL_INT_MEMORY:
+                src = args->int_memory[index];
+                break;
+            case JOURNAL_DINT_INPUT:
+                src = args->dint_input[index];
+                break;
+            case JOURNAL_DINT_OUTPUT:
+                src = args->dint_output[index];
+                break;
+            case JOURNAL_DINT_MEMORY:
+                src = args->dint_memory[index];
+                break;
+            case JOURNAL_LINT_INPUT:
+                src = args->lint_input[index];
+                break;
+            case JOURNAL_LINT_OUTPUT:
+                src = args->lint_output[index];
+                break;
+            case JOURNAL_LINT_MEMORY:
+                src = args->lint_memory[index];
+                break;
+            default:
+                break;
+        }
+
+        if (src)
+        {
+            memcpy(cell, src, width);
+        }
+    }
+}
+
+// Copy a validated range: lock-free snapshot first, locked pointer tables until it is enabled.
+// Called without the GIL.
+static int copy_range(const plugin_runtime_args_t *args, int type, int start, int count,
+                      uint8_t *dest)
+{
+    if (args->read_image_snapshot &&
+        args->read_image_snapshot(type, start, count, dest) == count)
+    {
+        return 0;
+    }
+
+    if (!args->mutex_take || !args->mutex_give || !args->buffer_mutex ||
+        args->mutex_take(args->buffer_mutex) != 0)
+    {
+        return -1;
+    }
+    copy_pointer_tables(args, type, start, count, dest);
+    args->mutex_give(args->buffer_mutex);
+    return 0;
+}
+
+PyDoc_STRVAR(read_range_doc,
+             "read_range(capsule, type, start, count) -> bytes\n\n"
+             "Read count packed elements of image area type starting at start.");
+
+static PyObject *buffers_read_range(PyObject *self, PyObject *pyargs)
+{
+    (void)self;
+    PyObject *capsule;
+    int type;
+    Py_ssize_t start;
+    Py_ssize_t count;
+
+    if (!PyArg_ParseTuple(pyargs, "Oinn:read_range", &capsule, &type, &start, &count))
+    {
+        return NULL;
+    }
+    plugin_runtime_args_t *args = args_from_capsule(capsule);
+    if (!args)
+    {
+        return NULL;
+    }
+    size_t width = check_range(args, type, start, count);
+    if (width == 0)
+    {
+        return NULL;
+    }
+
+    // The bytes object is not shared yet, so it can be filled without the GIL
+    PyObject *result = PyBytes_FromStringAndSize(NULL, count * (Py_ssize_t)width);
+    if (!result)
+    {
+        return NULL;
+    }
+    uint8_t *dest = (uint8_t *)PyBytes_AS_STRING(result);
+    int rc;
+
+    Py_BEGIN_ALLOW_THREADS
+    rc = copy_range(args, type, (int)start, (int)count, dest);
+    Py_END_ALLOW_THREADS
+
+    if (rc != 0)
+    {
+        Py_DECREF(result);
+        PyErr_SetString(PyExc_RuntimeError, "failed to acquire buffer mutex");
+        return NULL;
+    }
+    return result;
+}
+
+PyDoc_STRVAR(read_range_into_doc,
+             "read_range_into(capsule, type, start, buffer) -> int\n\n"
+             "Fill a writable buffer (bytearray, ctypes array, numpy array, ...) with\n"
+             "packed elements of image area type starting at start. The element count\n"
+             "is the buffer size divided by the element width; it is returned.");
+
+static PyObject *buffers_read_range_into(PyObject *self, PyObject *pyargs)
+{
+    (void)self;
+    PyObject *capsule;
+    int type;
+    Py_ssize_t start;
+    Py_buffer view;
+
+    if (!PyArg_ParseTuple(pyargs, "Oinw*:read_range_into", &capsule, &type, &start, &view))
+    {
+        return NULL;
+    }
+
+    PyObject *result = NULL;
+    plugin_runtime_args_t *args = args_from_capsule(capsule);
+    if (args)
+    {
+        size_t width     = journal_type_width((journal_buffer_type_t)type);
+        Py_ssize_t count = width ? view.len / (Py_ssize_t)width : 0;
+        if (width && view.len % (Py_ssize_t)width != 0)
+        {
+            PyErr_Format(PyExc_ValueError, "buffer size %zd is not a multiple of %zu", view.len,
+                         width);
+        }
+        else if (check_range(args, type, start, count) != 0)
+        {
+            int rc;
+            Py_BEGIN_ALLOW_THREADS
+            rc = copy_range(args, type, (int)start, (int)count, (uint8_t *)view.buf);
+            Py_END_ALLOW_THREADS
+
+            if (rc != 0)
+            {
+                PyErr_SetString(PyExc_RuntimeError, "failed to acquire buffer mutex");
+            }
+            else
+            {
+                result = PyLong_FromSsize_t(count);
+            }
+        }
+    }
+
+    PyBuffer_Release(&view);
+    return result;
+}
+
+PyDoc_STRVAR(write_range_doc,
+             "write_range(capsule, type, start, data) -> None\n\n"
+             "Journal the packed elements in data (any bytes-like object) for image\n"
+             "area type starting at start, as a single journal range entry. For BOOL\n"
+             "areas each byte sets all 8 bits of its index.");
+
+static PyObject *buffers_write_range(PyObject *self, PyObject *pyargs)
+{
+    (void)self;
+    PyObject *capsule;
+    int type;
+    Py_ssize_t start;
+    Py_buffer view;
+
+    if (!PyArg_ParseTuple(pyargs, "Oiny*:write_range", &capsule, &type, &start, &view))
+    {
+        return NULL;
+    }
+
+    PyObject *result = NULL;
+    plugin_runtime_args_t *args = args_from_capsule(capsule);
+    if (args)
+    {
+        size_t width     = journal_type_width((journal_buffer_type_t)type);
+        Py_ssize_t count = width ? view.len / (Py_ssize_t)width : 0;
+        if (width && view.len % (Py_ssize_t)width != 0)
+        {
+            PyErr_Format(PyExc_ValueError, "data size %zd is not a multiple of %zu", view.len,
+                         width);
+        }
+        else if (check_range(args, type, start, count) != 0)
+        {
+            if (!args->journal_write_range)
+            {
+                PyErr_SetString(PyExc_RuntimeError, "journal range write not available");
+            }
+            else if (args->journal_write_range(type, (int)start, (int)count, view.buf) != 0)
+            {
+                PyErr_SetString(PyExc_RuntimeError, "journal range write failed");
+            }
+            else
+            {
+                Py_INCREF(Py_None);
+                result = Py_None;
+            }
+        }
+    }
+
+    PyBuffer_Release(&view);
+    return result;
+}
+
+// Read-only buffer-protocol view of one shadow area
+typedef struct
+{
+    PyObject_HEAD
+    int type;
+    Py_ssize_t length;
+    Py_ssize_t itemsize;
+    char format[2];
+    int exported;
+    image_shadow_ticket_t ticket;
+} image_view_t;
+
+// Every export points at the set published at that moment and replaces the ticket
+static int image_view_getbuffer(PyObject *obj, Py_buffer *view, int flags)
+{
+    image_view_t *self = (image_view_t *)obj;
+
+    if (flags & PyBUF_WRITABLE)
+    {
+        PyErr_SetString(PyExc_BufferError, "image views are read-only");
+        view->obj = NULL;
+        return -1;
+    }
+
+    size_t length    = 0;
+    const void *base = image_shadow_peek((journal_buffer_type_t)self->type, &length,
+                                         &self->ticket);
+    if (!base)
+    {
+        self->exported = 0;
+        PyErr_SetString(PyExc_BufferError, "image area not available yet");
+        view->obj = NULL;
+        return -1;
+    }
+    self->exported = 1;
+    self->length   = (Py_ssize_t)length;
+
+    view->buf        = (void *)base;
+    Py_INCREF(obj);
+    view->obj        = obj;
+    view->len        = self->length * self->itemsize;
+    view->readonly   = 1;
+    view->itemsize   = self->itemsize;
+    view->format     = (flags & PyBUF_FORMAT) ? self->format : NULL;
+    view->ndim       = 1;
+    view->shape      = (flags & PyBUF_ND) ? &self->length : NULL;
+    view->strides    = (flags & PyBUF_STRIDES) ? &self->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal   = NULL;
+    return 0;
+}
+
+PyDoc_STRVAR(image_view_valid_doc,
+             "valid() -> bool\n\n"
+             "True if the snapshot behind the most recent export has not been\n"
+             "rewritten since; check it after reading through the memoryview.");
+
+static PyObject *image_view_valid(PyObject *obj, PyObject *unused)
+{
+    (void)unused;
+    image_view_t *self = (image_view_t *)obj;
+    return PyBool_FromLong(self->exported && image_shadow_ticket_valid(&self->ticket));
+}
+
+static PyObject *image_view_get_generation(PyObject *obj, void *closure)
+{
+    (void)closure;
+    image_view_t *self = (image_view_t *)obj;
+    if (!self->exported)
+    {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLong(self->ticket.generation);
+}
+
+static PyMethodDef image_view_methods[] = {
+    {"valid", image_view_valid, METH_NOARGS, image_view_valid_doc},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyGetSetDef image_view_getset[] = {
+    {"generation", image_view_get_generation, NULL,
+     "Scan generation of the snapshot behind the most recent export, or None.", NULL},
+    {NULL, NULL, NULL, NULL, NULL},
+};
+
+static void image_view_dealloc(PyObject *obj)
+{
+    PyTypeObject *type = Py_TYPE(obj);
+    PyObject_Free(obj);
+    Py_DECREF(type);
+}
+
+// A heap type, so that every (sub)interpreter gets its own copy
+static PyType_Slot image_view_slots[] = {
+    {Py_tp_doc, "Zero-copy, read-only view of one image area's per-scan snapshot."},
+    {Py_tp_dealloc, image_view_dealloc},
+    {Py_tp_methods, image_view_methods},
+    {Py_tp_getset, image_view_getset},
+    {Py_bf_getbuffer, image_view_getbuffer},
+    {0, NULL},
+};
+
+static PyType_Spec image_view_spec = {
+    .name      = "openplc_buffers.ImageView",
+    .basicsize = sizeof(image_view_t),
+    .flags     = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots     = image_view_slots,
+};
+
+// Per-module state
+typedef struct
+{
+    PyTypeObject *image_view_type;
+} buffers_state_t;
+
+PyDoc_STRVAR(image_view_doc,
+             "image_view(capsule, type) -> ImageView\n\n"
+             "Create a zero-copy view of image area type. memoryview(view) exposes\n"
+             "the latest snapshot without taking the buffer mutex; slice it and then\n"
+             "call view.valid() to confirm the scan did not overwrite it meanwhile.");
+
+static PyObject *buffers_image_view(PyObject *self, PyObject *pyargs)
+{
+    buffers_state_t *state = (buffers_state_t *)PyModule_GetState(self);
+    PyObject *capsule;
+    int type;
+
+    if (!PyArg_ParseTuple(pyargs, "Oi:image_view", &capsule, &type))
+    {
+        return NULL;
+    }
+    plugin_runtime_args_t *args = args_from_capsule(capsule);
+    if (!args)
+    {
+        return NULL;
+    }
+    size_t width = check_range(args, type, 0, 1);
+    if (width == 0)
+    {
+        return NULL;
+    }
+
+    image_view_t *view = PyObject_New(image_view_t, state->image_view_type);
+    if (!view)
+    {
+        return NULL;
+    }
+    view->type      = type;
+    view->length    = 0;
+    view->itemsize  = (Py_ssize_t)width;
+    view->format[0] = width == 1 ? 'B' : width == 2 ? 'H' : width == 4 ? 'I' : 'Q';
+    view->format[1] = '\0';
+    view->exported  = 0;
+    memset(&view->ticket, 0, sizeof(view->ticket));
+    return (PyObject *)view;
+}
+
+static PyMethodDef buffers_methods[] = {
+    {"read_range", buffers_read_range, METH_VARARGS, read_range_doc},
+    {"read_range_into", buffers_read_range_into, METH_VARARGS, read_range_into_doc},
+    {"write_range", buffers_write_range, METH_VARARGS, write_range_doc},
+    {"image_view", buffers_image_view, METH_VARARGS, image_view_doc},
+    {NULL, NULL, 0, NULL},
+};
+
+static int buffers_exec(PyObject *module)
+{
+    buffers_state_t *state = (buffers_state_t *)PyModule_GetState(module);
+    state->image_view_type =
+        (PyTypeObject *)PyType_FromModuleAndSpec(module, &image_view_spec, NULL);
+    if (!state->image_view_type)
+    {
+        return -1;
+    }
+    return PyModule_AddObjectRef(module, "ImageView", (PyObject *)state->image_view_type);
+}
+
+static int buffers_traverse(PyObject *module, visitproc visit, void *arg)
+{
+    buffers_state_t *state = (buffers_state_t *)PyModule_GetState(module);
+    Py_VISIT(state->image_view_type);
+    return 0;
+}
+
+static int buffers_clear(PyObject *module)
+{
+    buffers_state_t *state = (buffers_state_t *)PyModule_GetState(module);
+    Py_CLEAR(state->image_view_type);
+    return 0;
+}
+
+static void buffers_free(void *module)
+{
+    buffers_clear((PyObject *)module);
+}
+
+// Multi-phase initialization keeps the module importable from plugin subinterpreters
+static PyModuleDef_Slot buffers_slots[] = {
+    {Py_mod_exec, buffers_exec},
+#if PY_VERSION_HEX >= 0x030C0000
+    {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+    {0, NULL},
+};
+
+static struct PyModuleDef buffers_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name     = "openplc_buffers",
+    .m_doc      = "Bulk image table access for OpenPLC Python plugins.",
+    .m_size     = sizeof(buffers_state_t),
+    .m_methods  = buffers_methods,
+    .m_slots    = buffers_slots,
+    .m_traverse = buffers_traverse,
+    .m_clear    = buffers_clear,
+    .m_free     = buffers_free,
+};
+
+static PyObject *PyInit_openplc_buffers(void)
+{
+    return PyModuleDef_Init(&buffers_module);
+}
+
+int python_buffer_module_register(void)
+{
+    return PyImport_AppendInittab("openplc_buffers", PyInit_openplc_buffers) == 0 ? 0 : -1;
+}
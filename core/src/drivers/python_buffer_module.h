@@ -0,0 +1,45 @@
+#ifndef PYTHON_BUFFER_MODULE_H
+#define PYTHON_BUFFER_MODULE_H
+
+/**
+ * @file python_buffer_module.h
+ * @brief Built-in "openplc_buffers" extension module for Python plugins
+ *
+ * Python plugins access the image tables through ctypes, which costs a
+ * pointer dereference, a validation and a mutex round trip per element. This
+ * module moves whole ranges in one call instead, using the
+ * plugin_runtime_args_t capsule every Python plugin receives in init():
+ *
+ * - read_range(capsule, type, start, count) -> bytes
+ * - read_range_into(capsule, type, start, buffer) -> int
+ * - write_range(capsule, type, start, data) -> None
+ * - image_view(capsule, type) -> ImageView
+ *
+ * type is a journal_buffer_type_t value and data is packed like the image
+ * shadow: one element of the IEC type per index in host byte order, and for
+ * BOOL areas one byte per index with bit n holding bit n of that index. The
+ * range is validated once per call. Reads come from the lock-free per-scan
+ * snapshot when it is available and from the pointer tables under
+ * buffer_mutex otherwise; writes are a single journal range entry.
+ *
+ * An ImageView exports the published shadow set of one area through the
+ * buffer protocol, so memoryview(view)[a:b] reads a snapshot without copying
+ * it or taking the mutex. Each export points at the set published at that
+ * moment; view.valid() reports whether the scan thread has since started
+ * rewriting it, and view.generation is the scan generation of that set.
+ *
+ * The module is compiled into the runtime and registered before the
+ * interpreter starts, so it can only be imported by plugins running inside
+ * the runtime.
+ */
+
+/**
+ * @brief Register the module as a built-in of the embedded interpreter
+ *
+ * Must be called before Py_Initialize().
+ *
+ * @return 0 on success, -1 on failure
+ */
+int python_buffer_module_register(void);
+
+#endif // PYTHON_BUFFER_MODULE_H
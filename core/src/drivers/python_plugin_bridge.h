@@ -28,6 +28,8 @@ typedef struct
     PyObject *pFuncStop;
     PyObject *pFuncCleanup;
     PyObject *args_capsule; // Capsule containing plugin_runtime_args_t for lifetime management
+    PyInterpreterState *interp; // Own subinterpreter, NULL when running in the main interpreter
+    PyThreadState *interp_tstate; // First thread state of interp, kept until it is ended
 } python_binds_t;
 
 #endif // __PYTHON_PLUGIN_BRIDGE_H
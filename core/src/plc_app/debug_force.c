@@ -0,0 +1,143 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#include "debug_force.h"
+#include "debug_handler.h"
+#include "image_tables.h"
+#include "plc_state_manager.h"
+#include "utils/utils.h"
+
+// The batch being handed to the scan thread. The scan only trylocks
+// force_mutex to apply it, and the submitter holds it just to copy the batch
+// in or to withdraw it, so a scan never waits on a debug request.
+static pthread_mutex_t submit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t force_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t batch_index[DEBUG_FORCE_MAX_VARS];
+static bool batch_forced[DEBUG_FORCE_MAX_VARS];
+static uint16_t batch_offset[DEBUG_FORCE_MAX_VARS];
+static uint8_t batch_values[DEBUG_FORCE_MAX_BYTES];
+static uint16_t batch_count;
+
+// Set with the batch staged, cleared under force_mutex by whoever takes it
+// (the scan applying it, or an unload or the submitter dropping it) after
+// batch_result and batch_tick are written
+static atomic_bool batch_pending = false;
+static uint8_t batch_result;
+static uint32_t batch_tick;
+
+// A few scans of the loaded program
+static unsigned int apply_wait_ms(void)
+{
+    unsigned int wait_ms = DEBUG_FORCE_MIN_WAIT_MS;
+    if (ext_common_ticktime__ != NULL && *ext_common_ticktime__ / 1000000 * 3 > wait_ms)
+    {
+        wait_ms = (unsigned int)(*ext_common_ticktime__ / 1000000 * 3);
+    }
+    return wait_ms;
+}
+
+static void apply_batch(void)
+{
+    for (uint16_t i = 0; i < batch_count; i++)
+    {
+        ext_set_trace(batch_index[i], batch_forced[i], &batch_values[batch_offset[i]]);
+    }
+}
+
+// Take the staged batch with `result`; force_mutex held
+static void finish_batch(uint8_t result)
+{
+    batch_result = result;
+    batch_tick   = (uint32_t)tick__;
+    atomic_store_explicit(&batch_pending, false, memory_order_release);
+}
+
+uint8_t debug_force_submit(const debug_force_t *forces, uint16_t count, uint32_t *tick)
+{
+    if (count > DEBUG_FORCE_MAX_VARS)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_lock(&submit_mutex);
+    pthread_mutex_lock(&force_mutex);
+    size_t offset = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        size_t size = ext_get_var_size(forces[i].index);
+        if (offset + size > DEBUG_FORCE_MAX_BYTES)
+        {
+            pthread_mutex_unlock(&force_mutex);
+            pthread_mutex_unlock(&submit_mutex);
+            return MB_DEBUG_ERROR_OUT_OF_MEMORY;
+        }
+        batch_index[i]  = forces[i].index;
+        batch_forced[i] = forces[i].forced;
+        batch_offset[i] = (uint16_t)offset;
+        size_t len = forces[i].len < size ? forces[i].len : size;
+        memcpy(&batch_values[offset], forces[i].value, len);
+        memset(&batch_values[offset + len], 0, size - len);
+        offset += size;
+    }
+    batch_count = count;
+
+    if (plc_get_state() != PLC_STATE_RUNNING)
+    {
+        apply_batch();
+        *tick = (uint32_t)tick__;
+        pthread_mutex_unlock(&force_mutex);
+        pthread_mutex_unlock(&submit_mutex);
+        return MB_DEBUG_SUCCESS;
+    }
+    atomic_store_explicit(&batch_pending, true, memory_order_release);
+    pthread_mutex_unlock(&force_mutex);
+
+    unsigned int wait_ms         = apply_wait_ms();
+    const struct timespec one_ms = {.tv_sec = 0, .tv_nsec = 1000000};
+    for (unsigned int waited = 0;
+         atomic_load_explicit(&batch_pending, memory_order_acquire) && waited < wait_ms; waited++)
+    {
+        nanosleep(&one_ms, NULL);
+    }
+
+    // Withdraw the batch if the scan has not taken it yet, so it is either
+    // applied completely or not at all
+    pthread_mutex_lock(&force_mutex);
+    if (atomic_load_explicit(&batch_pending, memory_order_relaxed))
+    {
+        finish_batch(MB_DEBUG_ERROR_INVALID_STATE);
+    }
+    uint8_t result = batch_result;
+    *tick          = batch_tick;
+    pthread_mutex_unlock(&force_mutex);
+    pthread_mutex_unlock(&submit_mutex);
+    return result;
+}
+
+void debug_force_apply(void)
+{
+    if (!atomic_load_explicit(&batch_pending, memory_order_acquire) ||
+        pthread_mutex_trylock(&force_mutex) != 0)
+    {
+        return;
+    }
+
+    if (atomic_load_explicit(&batch_pending, memory_order_relaxed))
+    {
+        apply_batch();
+        finish_batch(MB_DEBUG_SUCCESS);
+    }
+    pthread_mutex_unlock(&force_mutex);
+}
+
+void debug_force_invalidate(void)
+{
+    pthread_mutex_lock(&force_mutex);
+    if (atomic_load_explicit(&batch_pending, memory_order_relaxed))
+    {
+        finish_batch(MB_DEBUG_ERROR_INVALID_STATE);
+    }
+    pthread_mutex_unlock(&force_mutex);
+}
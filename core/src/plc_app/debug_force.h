@@ -0,0 +1,53 @@
+#ifndef DEBUG_FORCE_H
+#define DEBUG_FORCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest batch: variables, and bytes of their values
+#define DEBUG_FORCE_MAX_VARS 512
+#define DEBUG_FORCE_MAX_BYTES 16384
+
+// Shortest time a batch waits for the scan to apply it
+#define DEBUG_FORCE_MIN_WAIT_MS 50
+
+typedef struct
+{
+    uint16_t index;
+    bool forced;       // false releases the variable
+    const void *value; // new value, zero padded to ext_get_var_size(index)
+    uint16_t len;      // bytes at value
+} debug_force_t;
+
+/**
+ * @brief Force and release several debug variables in the same scan
+ *
+ * The batch is copied and handed to the scan thread, which applies all of it
+ * at the start of its next cycle, before the program runs. Waits for that
+ * cycle. When the PLC is not running the batch is applied directly. Batches
+ * from several callers are applied one after the other.
+ *
+ * Called from the debug handler only, with indexes already checked against
+ * the variable count.
+ *
+ * @return MB_DEBUG_SUCCESS with the tick of the scan that first saw the
+ * forces in `tick`, MB_DEBUG_ERROR_OUT_OF_MEMORY if the batch is too large,
+ * or MB_DEBUG_ERROR_INVALID_STATE if the scan did not pick it up in time or
+ * the program changed meanwhile (nothing of the batch was applied)
+ */
+uint8_t debug_force_submit(const debug_force_t *forces, uint16_t count, uint32_t *tick);
+
+/**
+ * @brief Apply a submitted batch
+ *
+ * Called by the scan thread at the start of the cycle with the image mutex
+ * held. Never blocks: a batch being submitted is applied one scan later.
+ */
+void debug_force_apply(void);
+
+// Drop a batch not applied yet because its program is being unloaded or
+// replaced; its submitter gets MB_DEBUG_ERROR_INVALID_STATE
+void debug_force_invalidate(void);
+
+#endif // DEBUG_FORCE_H
@@ -1,25 +1,49 @@
 #include "debug_handler.h"
+#include "debug_force.h"
+#include "debug_snapshot.h"
 #include "image_tables.h"
+#include "trace_recorder.h"
 #include "utils/log.h"
 #include "utils/utils.h"
 #include <string.h>
 
-#define MAX_DEBUG_FRAME 4096
-
 #define MB_FC_DEBUG_INFO 0x41
 #define MB_FC_DEBUG_SET 0x42
 #define MB_FC_DEBUG_GET 0x43
 #define MB_FC_DEBUG_GET_LIST 0x44
 #define MB_FC_DEBUG_GET_MD5 0x45
+#define MB_FC_DEBUG_GET_LIST_DELTA 0x48 // 0x46/0x47 are used by debug_stream.h
+#define MB_FC_DEBUG_SET_LIST 0x4B       // 0x49 is in debug_handler.h, 0x4A in trace_recorder.h
+
+// Delta request: 48 [since tick, 4 bytes] [count, 2 bytes] [indexes...]
+#define DELTA_REQUEST_HEADER 7
+// Delta response: 48 7E [tick, 4 bytes] [covered count, 2 bytes] [bitmap...] [values...]
+#define DELTA_RESPONSE_HEADER 8
 
-#define MB_DEBUG_SUCCESS 0x7E
-#define MB_DEBUG_ERROR_OUT_OF_BOUNDS 0x81
-#define MB_DEBUG_ERROR_OUT_OF_MEMORY 0x82
+// Set list request: 4B [count, 2 bytes] then per variable
+// [index, 2 bytes] [flag] [length, 2 bytes] [value, length bytes]
+#define SET_LIST_REQUEST_HEADER 3
+#define SET_LIST_ENTRY_HEADER 5
 
 #define SAME_ENDIANNESS 0
 #define REVERSE_ENDIANNESS 1
 
-#define VARIDX_SIZE 256
+static size_t debug_frame_size = DEFAULT_DEBUG_FRAME;
+
+int debug_set_frame_size(size_t frame_size)
+{
+    if (frame_size < MIN_DEBUG_FRAME || frame_size > MAX_DEBUG_FRAME)
+    {
+        return -1;
+    }
+    debug_frame_size = frame_size;
+    return 0;
+}
+
+size_t debug_get_frame_size(void)
+{
+    return debug_frame_size;
+}
 
 static void debugInfo(uint8_t *frame, size_t *frame_len)
 {
@@ -49,34 +73,133 @@ static void debugSetTrace(uint8_t *frame, size_t *frame_len, uint16_t varidx, ui
     frame[1]   = MB_DEBUG_SUCCESS;
 }
 
-static void debugGetTrace(uint8_t *frame, size_t *frame_len, uint16_t startidx, uint16_t endidx)
+static void debugSetTraceList(uint8_t *frame, size_t *frame_len, size_t length)
+{
+    static debug_force_t forces[DEBUG_FORCE_MAX_VARS];
+
+    *frame_len = 2;
+    frame[0]   = MB_FC_DEBUG_SET_LIST;
+
+    if (length < SET_LIST_REQUEST_HEADER)
+    {
+        frame[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return;
+    }
+
+    uint16_t count = (uint16_t)frame[1] << 8 | frame[2];
+    if (count > DEBUG_FORCE_MAX_VARS)
+    {
+        frame[1] = MB_DEBUG_ERROR_OUT_OF_MEMORY;
+        return;
+    }
+
+    // Reject the whole batch on any bad entry, nothing is applied then
+    uint16_t variableCount = ext_get_var_count();
+    size_t offset          = SET_LIST_REQUEST_HEADER;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (offset + SET_LIST_ENTRY_HEADER > length)
+        {
+            frame[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+            return;
+        }
+        const uint8_t *entry = &frame[offset];
+        forces[i].index      = (uint16_t)entry[0] << 8 | entry[1];
+        forces[i].forced     = entry[2] != 0;
+        forces[i].len        = (uint16_t)entry[3] << 8 | entry[4];
+        forces[i].value      = entry + SET_LIST_ENTRY_HEADER;
+        offset += SET_LIST_ENTRY_HEADER + forces[i].len;
+
+        // A forced value must be complete, a release needs none
+        if (forces[i].index >= variableCount || offset > length ||
+            (forces[i].forced && forces[i].len < ext_get_var_size(forces[i].index)))
+        {
+            frame[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+            return;
+        }
+    }
+
+    // The values still sit in the request, which the response overwrites
+    uint32_t tick;
+    uint8_t result = debug_force_submit(forces, count, &tick);
+    frame[1]       = result;
+    if (result != MB_DEBUG_SUCCESS)
+    {
+        return;
+    }
+
+    *frame_len = 8;
+    frame[2]   = (uint8_t)((tick >> 24) & 0xFF);
+    frame[3]   = (uint8_t)((tick >> 16) & 0xFF);
+    frame[4]   = (uint8_t)((tick >> 8) & 0xFF);
+    frame[5]   = (uint8_t)(tick & 0xFF);
+    frame[6]   = (uint8_t)(count >> 8);
+    frame[7]   = (uint8_t)(count & 0xFF);
+}
+
+// Copy the values of `indexes` into `dest` and return the tick they belong
+// to. While the scan runs the values come from the end-of-scan snapshot, so a
+// response never mixes two scans; otherwise they are read live.
+static uint32_t copyTraceValues(const uint16_t *indexes, uint16_t count, uint8_t *dest,
+                                size_t size)
 {
+    uint32_t tick;
+    if (debug_snapshot_read(indexes, count, dest, size, &tick, NULL))
+    {
+        return tick;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        size_t varSize = ext_get_var_size(indexes[i]);
+        memcpy(dest, ext_get_var_addr(indexes[i]), varSize);
+        dest += varSize;
+    }
+    return (uint32_t)tick__;
+}
+
+static void setTraceHeader(uint8_t *frame, uint8_t fcode, uint16_t lastVarIdx, uint32_t tick,
+                           uint16_t responseSize)
+{
+    frame[0] = fcode;
+    frame[1] = MB_DEBUG_SUCCESS;
+    frame[2] = (uint8_t)(lastVarIdx >> 8);
+    frame[3] = (uint8_t)(lastVarIdx & 0xFF);
+    frame[4] = (uint8_t)((tick >> 24) & 0xFF);
+    frame[5] = (uint8_t)((tick >> 16) & 0xFF);
+    frame[6] = (uint8_t)((tick >> 8) & 0xFF);
+    frame[7] = (uint8_t)(tick & 0xFF);
+    frame[8] = (uint8_t)(responseSize >> 8);
+    frame[9] = (uint8_t)(responseSize & 0xFF);
+}
+
+static void debugGetTrace(uint8_t *frame, size_t *frame_len, uint16_t startidx, uint16_t endidx,
+                          uint8_t fcode, size_t frame_size)
+{
+    static uint16_t varidx_array[DEBUG_SNAPSHOT_MAX_VARS];
+
     uint16_t variableCount = ext_get_var_count();
     if (startidx >= variableCount || endidx >= variableCount || startidx > endidx)
     {
         *frame_len = 2;
-        frame[0]   = MB_FC_DEBUG_GET;
+        frame[0]   = fcode;
         frame[1]   = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
         return;
     }
 
-    uint16_t lastVarIdx  = startidx;
-    size_t responseSize  = 0;
-    uint8_t *responsePtr = &(frame[10]);
+    uint16_t lastVarIdx = startidx;
+    uint16_t numVars    = 0;
+    size_t responseSize = 0;
 
-    for (uint16_t varidx = startidx; varidx <= endidx; varidx++)
+    for (uint32_t varidx = startidx; varidx <= endidx; varidx++)
     {
         size_t varSize = ext_get_var_size(varidx);
-        if ((responseSize + 10) + varSize <= MAX_DEBUG_FRAME)
+        if ((responseSize + 10) + varSize <= frame_size && numVars < DEBUG_SNAPSHOT_MAX_VARS)
         {
-            void *varAddr = ext_get_var_addr(varidx);
-
-            memcpy(responsePtr, varAddr, varSize);
-
-            responsePtr += varSize;
+            varidx_array[numVars++] = (uint16_t)varidx;
             responseSize += varSize;
 
-            lastVarIdx = varidx;
+            lastVarIdx = (uint16_t)varidx;
         }
         else
         {
@@ -84,30 +207,24 @@ static void debugGetTrace(uint8_t *frame, size_t *frame_len, uint16_t startidx,
         }
     }
 
+    uint32_t tick = copyTraceValues(varidx_array, numVars, &frame[10], responseSize);
+
     *frame_len = 10 + responseSize;
-    frame[0]   = MB_FC_DEBUG_GET;
-    frame[1]   = MB_DEBUG_SUCCESS;
-    frame[2]   = (uint8_t)(lastVarIdx >> 8);
-    frame[3]   = (uint8_t)(lastVarIdx & 0xFF);
-    frame[4]   = (uint8_t)((tick__ >> 24) & 0xFF);
-    frame[5]   = (uint8_t)((tick__ >> 16) & 0xFF);
-    frame[6]   = (uint8_t)((tick__ >> 8) & 0xFF);
-    frame[7]   = (uint8_t)(tick__ & 0xFF);
-    frame[8]   = (uint8_t)(responseSize >> 8);
-    frame[9]   = (uint8_t)(responseSize & 0xFF);
+    setTraceHeader(frame, fcode, lastVarIdx, tick, (uint16_t)responseSize);
 }
 
 static void debugGetTraceList(uint8_t *frame, size_t *frame_len, uint16_t numIndexes,
-                              uint8_t *indexArray)
+                              uint8_t *indexArray, size_t length, size_t frame_size)
 {
-    uint16_t response_idx  = 10;
+    static uint16_t varidx_array[DEBUG_SNAPSHOT_MAX_VARS];
+
+    size_t response_idx    = 10;
     uint16_t responseSize  = 0;
     uint16_t lastVarIdx    = 0;
+    uint16_t numVars       = 0;
     uint16_t variableCount = ext_get_var_count();
 
-    uint16_t varidx_array[VARIDX_SIZE];
-
-    if (numIndexes > VARIDX_SIZE)
+    if (numIndexes > DEBUG_SNAPSHOT_MAX_VARS || length < 3 + (size_t)numIndexes * 2)
     {
         *frame_len = 2;
         frame[0]   = MB_FC_DEBUG_GET_LIST;
@@ -132,14 +249,13 @@ static void debugGetTraceList(uint8_t *frame, size_t *frame_len, uint16_t numInd
 
         size_t varSize = ext_get_var_size(varidx_array[i]);
 
-        if (response_idx + varSize <= MAX_DEBUG_FRAME)
+        if (response_idx + varSize <= frame_size)
         {
-            void *varAddr = ext_get_var_addr(varidx_array[i]);
-            memcpy(&frame[response_idx], varAddr, varSize);
             response_idx += varSize;
             responseSize += varSize;
 
             lastVarIdx = varidx_array[i];
+            numVars++;
         }
         else
         {
@@ -147,17 +263,130 @@ static void debugGetTraceList(uint8_t *frame, size_t *frame_len, uint16_t numInd
         }
     }
 
+    // The values overwrite the index list, which has been copied out above
+    uint32_t tick = copyTraceValues(varidx_array, numVars, &frame[10], responseSize);
+
     *frame_len = response_idx;
-    frame[0]   = MB_FC_DEBUG_GET_LIST;
+    setTraceHeader(frame, MB_FC_DEBUG_GET_LIST, lastVarIdx, tick, responseSize);
+}
+
+// Changed since `since`, allowing for the 32-bit tick to wrap
+static bool changedSince(uint32_t change_tick, uint32_t since)
+{
+    return since == 0 || (int32_t)(change_tick - since) > 0;
+}
+
+static void debugGetTraceListDelta(uint8_t *frame, size_t *frame_len, size_t length,
+                                   size_t frame_size)
+{
+    static uint16_t varidx_array[DEBUG_SNAPSHOT_MAX_VARS];
+    static uint32_t change_ticks[DEBUG_SNAPSHOT_MAX_VARS];
+    static uint8_t values[DEBUG_SNAPSHOT_SIZE];
+
+    *frame_len = 2;
+    frame[0]   = MB_FC_DEBUG_GET_LIST_DELTA;
+
+    if (length < DELTA_REQUEST_HEADER)
+    {
+        frame[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return;
+    }
+
+    uint32_t since = (uint32_t)frame[1] << 24 | (uint32_t)frame[2] << 16 |
+                     (uint32_t)frame[3] << 8 | frame[4];
+    uint16_t numIndexes    = (uint16_t)frame[5] << 8 | frame[6];
+    uint16_t variableCount = ext_get_var_count();
+
+    if (numIndexes > DEBUG_SNAPSHOT_MAX_VARS ||
+        length < DELTA_REQUEST_HEADER + (size_t)numIndexes * 2)
+    {
+        frame[1] = MB_DEBUG_ERROR_OUT_OF_MEMORY;
+        return;
+    }
+
+    // Watch the variables whose values fit in the staging buffer
+    uint16_t numWatched = 0;
+    size_t watchedSize  = 0;
+    for (uint16_t i = 0; i < numIndexes; i++)
+    {
+        const uint8_t *index = &frame[DELTA_REQUEST_HEADER + i * 2];
+        varidx_array[i]      = (uint16_t)index[0] << 8 | index[1];
+        if (varidx_array[i] >= variableCount)
+        {
+            frame[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+            return;
+        }
+
+        size_t varSize = ext_get_var_size(varidx_array[i]);
+        if (numWatched == i && watchedSize + varSize <= DEBUG_SNAPSHOT_SIZE)
+        {
+            watchedSize += varSize;
+            numWatched++;
+        }
+    }
+
+    uint32_t tick;
+    bool tracked =
+        debug_snapshot_read(varidx_array, numWatched, values, watchedSize, &tick, change_ticks);
+    if (!tracked)
+    {
+        // No change tracking without the scan, report every value
+        uint8_t *dest = values;
+        for (uint16_t i = 0; i < numWatched; i++)
+        {
+            size_t varSize = ext_get_var_size(varidx_array[i]);
+            memcpy(dest, ext_get_var_addr(varidx_array[i]), varSize);
+            dest += varSize;
+        }
+        tick = (uint32_t)tick__;
+    }
+
+    // Cover as many list entries as the bitmap and the changed values allow
+    uint16_t covered   = 0;
+    size_t changedSize = 0;
+    for (uint16_t i = 0; i < numWatched; i++)
+    {
+        size_t varSize     = ext_get_var_size(varidx_array[i]);
+        size_t nextChanged = changedSize;
+        if (!tracked || changedSince(change_ticks[i], since))
+        {
+            nextChanged += varSize;
+        }
+        size_t bitmapSize = ((size_t)i + 1 + 7) / 8;
+        if (DELTA_RESPONSE_HEADER + bitmapSize + nextChanged > frame_size)
+        {
+            break;
+        }
+        changedSize = nextChanged;
+        covered++;
+    }
+
+    size_t bitmapSize = ((size_t)covered + 7) / 8;
+    uint8_t *bitmap   = &frame[DELTA_RESPONSE_HEADER];
+    uint8_t *dest     = bitmap + bitmapSize;
+    size_t offset     = 0;
+    memset(bitmap, 0, bitmapSize);
+
+    for (uint16_t i = 0; i < covered; i++)
+    {
+        size_t varSize = ext_get_var_size(varidx_array[i]);
+        if (!tracked || changedSince(change_ticks[i], since))
+        {
+            bitmap[i / 8] |= (uint8_t)(1u << (i % 8));
+            memcpy(dest, &values[offset], varSize);
+            dest += varSize;
+        }
+        offset += varSize;
+    }
+
+    *frame_len = DELTA_RESPONSE_HEADER + bitmapSize + changedSize;
     frame[1]   = MB_DEBUG_SUCCESS;
-    frame[2]   = (uint8_t)(lastVarIdx >> 8);
-    frame[3]   = (uint8_t)(lastVarIdx & 0xFF);
-    frame[4]   = (uint8_t)((tick__ >> 24) & 0xFF);
-    frame[5]   = (uint8_t)((tick__ >> 16) & 0xFF);
-    frame[6]   = (uint8_t)((tick__ >> 8) & 0xFF);
-    frame[7]   = (uint8_t)(tick__ & 0xFF);
-    frame[8]   = (uint8_t)(responseSize >> 8);
-    frame[9]   = (uint8_t)(responseSize & 0xFF);
+    frame[2]   = (uint8_t)((tick >> 24) & 0xFF);
+    frame[3]   = (uint8_t)((tick >> 16) & 0xFF);
+    frame[4]   = (uint8_t)((tick >> 8) & 0xFF);
+    frame[5]   = (uint8_t)(tick & 0xFF);
+    frame[6]   = (uint8_t)(covered >> 8);
+    frame[7]   = (uint8_t)(covered & 0xFF);
 }
 
 static void debugGetMd5(uint8_t *frame, size_t *frame_len, void *endianness)
@@ -193,6 +422,43 @@ static void debugGetMd5(uint8_t *frame, size_t *frame_len, void *endianness)
 }
 
 size_t process_debug_data(uint8_t *data, size_t length)
+{
+    return process_debug_data_limited(data, length, debug_frame_size);
+}
+
+int process_debug_paged(uint8_t *data, size_t length, debug_frame_writer_t writer, void *ctx)
+{
+    if (length < 5)
+    {
+        data[0] = MB_FC_DEBUG_GET_PAGED;
+        data[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return writer(ctx, data, 2);
+    }
+
+    uint16_t cursor = (uint16_t)data[1] << 8 | data[2];
+    uint16_t endidx = (uint16_t)data[3] << 8 | data[4];
+
+    while (true)
+    {
+        size_t frame_len = 0;
+        debugGetTrace(data, &frame_len, cursor, endidx, MB_FC_DEBUG_GET_PAGED, debug_frame_size);
+
+        int result = writer(ctx, data, frame_len);
+        if (result < 0 || data[1] != MB_DEBUG_SUCCESS)
+        {
+            return result;
+        }
+
+        uint16_t lastVarIdx = (uint16_t)data[2] << 8 | data[3];
+        if (lastVarIdx >= endidx)
+        {
+            return 1;
+        }
+        cursor = lastVarIdx + 1;
+    }
+}
+
+size_t process_debug_data_limited(uint8_t *data, size_t length, size_t frame_size)
 {
     if (length < 1)
     {
@@ -242,17 +508,34 @@ size_t process_debug_data(uint8_t *data, size_t length)
         break;
 
     case MB_FC_DEBUG_GET:
-        debugGetTrace(data, &response_len, field1, field2);
+        debugGetTrace(data, &response_len, field1, field2, MB_FC_DEBUG_GET, frame_size);
+        break;
+
+    case MB_FC_DEBUG_GET_PAGED:
+        // Without a frame writer only the first page can be answered
+        debugGetTrace(data, &response_len, field1, field2, MB_FC_DEBUG_GET_PAGED, frame_size);
         break;
 
     case MB_FC_DEBUG_GET_LIST:
-        debugGetTraceList(data, &response_len, field1, &data[3]);
+        debugGetTraceList(data, &response_len, field1, &data[3], length, frame_size);
         break;
 
     case MB_FC_DEBUG_SET:
         debugSetTrace(data, &response_len, field1, flag, len, value);
         break;
 
+    case MB_FC_DEBUG_SET_LIST:
+        debugSetTraceList(data, &response_len, length);
+        break;
+
+    case MB_FC_DEBUG_GET_LIST_DELTA:
+        debugGetTraceListDelta(data, &response_len, length, frame_size);
+        break;
+
+    case MB_FC_DEBUG_TRACE:
+        response_len = trace_recorder_handle_request(data, length, frame_size);
+        break;
+
     case MB_FC_DEBUG_GET_MD5:
         debugGetMd5(data, &response_len, endianness_check);
         break;
@@ -6,6 +6,50 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+// Size of the buffer passed to process_debug_data(), which writes the
+// response frame over the request. This is the largest frame the 16-bit
+// length of the binary framing can describe.
+#define MAX_DEBUG_FRAME 65535
+
+// Limits for the configurable response size (see debug_set_frame_size())
+#define DEFAULT_DEBUG_FRAME 4096
+#define MIN_DEBUG_FRAME 512
+
+// Responses to the legacy DEBUG:<hex> text command keep the original size
+#define LEGACY_DEBUG_FRAME 4096
+
+// Paged read: answered with a sequence of frames (see process_debug_paged())
+#define MB_FC_DEBUG_GET_PAGED 0x49
+
+#define MB_DEBUG_SUCCESS 0x7E
+#define MB_DEBUG_ERROR_OUT_OF_BOUNDS 0x81
+#define MB_DEBUG_ERROR_OUT_OF_MEMORY 0x82
+#define MB_DEBUG_ERROR_INVALID_STATE 0x83
+
+// Process one request, the response is limited to the configured frame size
 size_t process_debug_data(uint8_t *data, size_t length);
 
+// Same as process_debug_data() with an explicit response size limit
+size_t process_debug_data_limited(uint8_t *data, size_t length, size_t frame_size);
+
+// Receives each response frame of a paged request, returns < 0 to abort
+typedef int (*debug_frame_writer_t)(void *ctx, const uint8_t *frame, size_t length);
+
+/**
+ * @brief Process a DEBUG_GET_PAGED request
+ *
+ * Request: 49 [start index, 2 bytes] [end index, 2 bytes]. Each response uses
+ * the DEBUG_GET layout with function code 0x49 and continues from the index
+ * after the previous page's last index; the last page has last index == end.
+ * An error is reported as a single 2-byte frame.
+ *
+ * @return The last writer result, or 1 if every page was written
+ */
+int process_debug_paged(uint8_t *data, size_t length, debug_frame_writer_t writer, void *ctx);
+
+// Set the largest response the binary frames carry, MIN_DEBUG_FRAME to
+// MAX_DEBUG_FRAME bytes. Returns -1 if out of range.
+int debug_set_frame_size(size_t frame_size);
+size_t debug_get_frame_size(void);
+
 #endif // DEBUG_HANDLER_H
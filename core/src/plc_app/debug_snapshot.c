@@ -0,0 +1,172 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#include "debug_snapshot.h"
+#include "image_tables.h"
+#include "plc_state_manager.h"
+#include "utils/seqlock.h"
+#include "utils/utils.h"
+
+// Watch set requested by the debug handler. The scan thread only ever
+// trylocks watch_mutex, so a change in progress delays the capture by one scan
+// instead of blocking the scan.
+static uint16_t requested_indexes[DEBUG_SNAPSHOT_MAX_VARS];
+static uint16_t requested_count;
+static pthread_mutex_t watch_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint watch_generation = 0;
+
+// Scan thread state: the watch set resolved to variable addresses
+static unsigned int applied_generation = 0;
+static uint16_t active_count           = 0;
+static void *active_addr[DEBUG_SNAPSHOT_MAX_VARS];
+static uint16_t active_size[DEBUG_SNAPSHOT_MAX_VARS];
+
+// Written by the scan thread only, read under snapshot_seq
+static atomic_uint snapshot_seq = 0;
+static uint8_t snapshot_data[DEBUG_SNAPSHOT_SIZE];
+static uint32_t snapshot_tick;
+static uint32_t snapshot_changed[DEBUG_SNAPSHOT_MAX_VARS];
+static unsigned int snapshot_generation;
+static bool snapshot_fresh; // first capture of the applied watch set pending
+
+// Long enough for a few scans of the loaded program
+static unsigned int capture_wait_ms(void)
+{
+    unsigned int wait_ms = DEBUG_SNAPSHOT_MIN_WAIT_MS;
+    if (ext_common_ticktime__ != NULL && *ext_common_ticktime__ / 1000000 * 3 > wait_ms)
+    {
+        wait_ms = (unsigned int)(*ext_common_ticktime__ / 1000000 * 3);
+    }
+    return wait_ms;
+}
+
+bool debug_snapshot_read(const uint16_t *indexes, uint16_t count, uint8_t *dest, size_t size,
+                         uint32_t *tick, uint32_t *change_ticks)
+{
+    if (count == 0 || count > DEBUG_SNAPSHOT_MAX_VARS || size > DEBUG_SNAPSHOT_SIZE ||
+        plc_get_state() != PLC_STATE_RUNNING)
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&watch_mutex);
+    if (count != requested_count ||
+        memcmp(indexes, requested_indexes, count * sizeof(indexes[0])) != 0)
+    {
+        memcpy(requested_indexes, indexes, count * sizeof(indexes[0]));
+        requested_count = count;
+        atomic_fetch_add_explicit(&watch_generation, 1, memory_order_release);
+    }
+    unsigned int generation = atomic_load_explicit(&watch_generation, memory_order_relaxed);
+    pthread_mutex_unlock(&watch_mutex);
+
+    unsigned int wait_ms         = capture_wait_ms();
+    const struct timespec one_ms = {.tv_sec = 0, .tv_nsec = 1000000};
+    for (unsigned int waited = 0;; waited++)
+    {
+        bool captured;
+        unsigned int seq;
+        do
+        {
+            seq      = seq_read_begin(&snapshot_seq);
+            captured = snapshot_generation == generation;
+            if (captured)
+            {
+                memcpy(dest, snapshot_data, size);
+                *tick = snapshot_tick;
+                if (change_ticks != NULL)
+                {
+                    memcpy(change_ticks, snapshot_changed, count * sizeof(change_ticks[0]));
+                }
+            }
+        } while (seq_read_retry(&snapshot_seq, seq));
+
+        if (captured)
+        {
+            return true;
+        }
+        if (waited >= wait_ms)
+        {
+            return false;
+        }
+        nanosleep(&one_ms, NULL);
+    }
+}
+
+void debug_snapshot_invalidate(void)
+{
+    pthread_mutex_lock(&watch_mutex);
+    requested_count = 0;
+    atomic_fetch_add_explicit(&watch_generation, 1, memory_order_release);
+    pthread_mutex_unlock(&watch_mutex);
+}
+
+void debug_snapshot_forget(void)
+{
+    active_count       = 0;
+    applied_generation = atomic_load_explicit(&watch_generation, memory_order_acquire);
+}
+
+// Scan thread: pick up a new watch set if the handler is not busy with it
+static void apply_watch_set(unsigned int generation)
+{
+    if (pthread_mutex_trylock(&watch_mutex) != 0)
+    {
+        return;
+    }
+
+    size_t total = 0;
+    active_count = 0;
+    for (uint16_t i = 0; i < requested_count; i++)
+    {
+        size_t size = ext_get_var_size(requested_indexes[i]);
+        if (total + size > DEBUG_SNAPSHOT_SIZE)
+        {
+            break;
+        }
+        active_addr[active_count] = ext_get_var_addr(requested_indexes[i]);
+        active_size[active_count] = (uint16_t)size;
+        total += size;
+        active_count++;
+    }
+
+    applied_generation = generation;
+    snapshot_fresh     = true;
+    pthread_mutex_unlock(&watch_mutex);
+}
+
+void debug_snapshot_capture(void)
+{
+    unsigned int generation = atomic_load_explicit(&watch_generation, memory_order_acquire);
+    if (generation != applied_generation)
+    {
+        apply_watch_set(generation);
+    }
+
+    if (active_count == 0)
+    {
+        return;
+    }
+
+    uint32_t tick = (uint32_t)tick__;
+
+    seq_write_begin(&snapshot_seq);
+    size_t offset = 0;
+    for (uint16_t i = 0; i < active_count; i++)
+    {
+        // The previous capture is still in place, compare before overwriting
+        uint8_t *slot = &snapshot_data[offset];
+        if (snapshot_fresh || memcmp(slot, active_addr[i], active_size[i]) != 0)
+        {
+            memcpy(slot, active_addr[i], active_size[i]);
+            snapshot_changed[i] = tick;
+        }
+        offset += active_size[i];
+    }
+    snapshot_tick       = tick;
+    snapshot_generation = applied_generation;
+    snapshot_fresh      = false;
+    seq_write_end(&snapshot_seq);
+}
@@ -0,0 +1,52 @@
+#ifndef DEBUG_SNAPSHOT_H
+#define DEBUG_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "debug_handler.h"
+
+// Values of the largest frame, and as many indexes as one frame can list
+#define DEBUG_SNAPSHOT_SIZE MAX_DEBUG_FRAME
+#define DEBUG_SNAPSHOT_MAX_VARS (MAX_DEBUG_FRAME / 2)
+
+// Shortest time a read waits for the scan to capture a new watch set
+#define DEBUG_SNAPSHOT_MIN_WAIT_MS 50
+
+/**
+ * @brief Copy debug variable values as captured at the end of a scan
+ *
+ * The requested variables become the watch set that the scan thread copies
+ * into a staging buffer at the end of every cycle. Repeating a request for the
+ * same variables is served from the latest capture without waiting; a new set
+ * waits for the next scan to capture it.
+ *
+ * Called from the debug handler only. `size` must be the total size of the
+ * requested variables. If `change_ticks` is not NULL it receives, for every
+ * variable, the tick of the scan in which its bytes last changed (the first
+ * capture of a watch set counts as a change).
+ *
+ * @return true with the values in `dest` and their scan in `tick`, or false if
+ * no scan captured them in time (PLC not running), in which case the caller
+ * reads the live values itself
+ */
+bool debug_snapshot_read(const uint16_t *indexes, uint16_t count, uint8_t *dest, size_t size,
+                         uint32_t *tick, uint32_t *change_ticks);
+
+/**
+ * @brief Copy the watch set into the staging buffer
+ *
+ * Called by the scan thread at the end of the cycle with the image mutex held.
+ * Never blocks.
+ */
+void debug_snapshot_capture(void);
+
+// Drop the watch set because the program is being unloaded
+void debug_snapshot_invalidate(void);
+
+// Scan thread: stop capturing the applied watch set, whose addresses belong to a program
+// that is being replaced, until the next watch set is requested
+void debug_snapshot_forget(void);
+
+#endif // DEBUG_SNAPSHOT_H
@@ -0,0 +1,269 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "debug_handler.h"
+#include "debug_stream.h"
+#include "image_tables.h"
+#include "plc_state_manager.h"
+#include "utils/log.h"
+#include "utils/utils.h"
+
+// Must be a power of two
+#define DEBUG_STREAM_RING_SLOTS 64
+
+typedef struct
+{
+    uint16_t count;
+    uint16_t indexes[DEBUG_STREAM_MAX_VARS];
+    uint8_t mode;
+    uint16_t rate;
+} debug_subscription_t;
+
+// Subscription requested by the stream socket thread. The scan thread only
+// ever trylocks sub_mutex, so a busy writer delays a change by one scan
+// instead of blocking the scan.
+static debug_subscription_t requested_sub;
+static pthread_mutex_t sub_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint sub_generation = 0;
+static atomic_bool sub_active     = false;
+
+// Scan thread state: the subscription resolved to variable addresses
+static unsigned int applied_generation = 0;
+static uint16_t active_count           = 0;
+static void *active_addr[DEBUG_STREAM_MAX_VARS];
+static uint16_t active_size[DEBUG_STREAM_MAX_VARS];
+static size_t active_bytes       = 0;
+static uint8_t active_mode       = DEBUG_STREAM_MODE_EVERY_N;
+static uint16_t active_rate      = 1;
+static uint32_t scans_since_last = 0;
+static bool have_last            = false;
+static bool dropped_pending      = false;
+static uint8_t capture_buffer[DEBUG_STREAM_SAMPLE_SIZE];
+static uint8_t last_capture[DEBUG_STREAM_SAMPLE_SIZE];
+
+// SPSC ring: the scan thread produces, the stream socket thread consumes
+static debug_sample_t ring[DEBUG_STREAM_RING_SLOTS];
+static atomic_uint ring_head = 0;
+static atomic_uint ring_tail = 0;
+
+static void publish_subscription(const debug_subscription_t *sub)
+{
+    pthread_mutex_lock(&sub_mutex);
+    memcpy(&requested_sub, sub, sizeof(requested_sub));
+    atomic_store_explicit(&sub_active, sub->count > 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&sub_generation, 1, memory_order_release);
+    pthread_mutex_unlock(&sub_mutex);
+}
+
+size_t debug_stream_handle_request(uint8_t *data, size_t length)
+{
+    static debug_subscription_t sub;
+
+    if (length < 3 || data[0] != MB_FC_DEBUG_SUBSCRIBE)
+    {
+        return 0;
+    }
+
+    uint16_t count = (uint16_t)data[1] << 8 | data[2];
+    data[0]        = MB_FC_DEBUG_SUBSCRIBE;
+
+    if (count == 0)
+    {
+        debug_stream_unsubscribe();
+        data[1] = MB_DEBUG_SUCCESS;
+        return 2;
+    }
+
+    if (count > DEBUG_STREAM_MAX_VARS || length < 3 + (size_t)count * 2 + 3)
+    {
+        data[1] = MB_DEBUG_ERROR_OUT_OF_MEMORY;
+        return 2;
+    }
+
+    // Variable metadata is only valid while a program is loaded
+    if (plc_get_state() != PLC_STATE_RUNNING || ext_get_var_count == NULL)
+    {
+        data[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return 2;
+    }
+
+    uint16_t variable_count = ext_get_var_count();
+    size_t total_size       = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        sub.indexes[i] = (uint16_t)data[3 + i * 2] << 8 | data[4 + i * 2];
+        if (sub.indexes[i] >= variable_count)
+        {
+            data[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+            return 2;
+        }
+        total_size += ext_get_var_size(sub.indexes[i]);
+    }
+
+    if (total_size > DEBUG_STREAM_SAMPLE_SIZE)
+    {
+        data[1] = MB_DEBUG_ERROR_OUT_OF_MEMORY;
+        return 2;
+    }
+
+    const uint8_t *tail = &data[3 + count * 2];
+    sub.count           = count;
+    sub.mode            = tail[0] == DEBUG_STREAM_MODE_ON_CHANGE ? DEBUG_STREAM_MODE_ON_CHANGE
+                                                                 : DEBUG_STREAM_MODE_EVERY_N;
+    sub.rate            = (uint16_t)tail[1] << 8 | tail[2];
+    if (sub.rate == 0)
+    {
+        sub.rate = 1;
+    }
+
+    publish_subscription(&sub);
+    log_info("Debug stream subscribed to %u variables (%zu bytes per sample)", count, total_size);
+
+    data[1] = MB_DEBUG_SUCCESS;
+    return 2;
+}
+
+void debug_stream_unsubscribe(void)
+{
+    static const debug_subscription_t none = {0};
+    publish_subscription(&none);
+}
+
+void debug_stream_invalidate(void)
+{
+    if (atomic_load_explicit(&sub_active, memory_order_relaxed))
+    {
+        log_info("Debug stream subscription cancelled, program unloaded");
+    }
+    debug_stream_unsubscribe();
+}
+
+bool debug_stream_active(void)
+{
+    return atomic_load_explicit(&sub_active, memory_order_relaxed);
+}
+
+bool debug_stream_pop(debug_sample_t *sample)
+{
+    unsigned int generation = atomic_load_explicit(&sub_generation, memory_order_relaxed);
+    unsigned int tail       = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    unsigned int head       = atomic_load_explicit(&ring_head, memory_order_acquire);
+
+    while (tail != head)
+    {
+        const debug_sample_t *slot = &ring[tail & (DEBUG_STREAM_RING_SLOTS - 1)];
+        bool current               = slot->generation == generation;
+        if (current)
+        {
+            sample->generation = slot->generation;
+            sample->tick       = slot->tick;
+            sample->flags      = slot->flags;
+            sample->length     = slot->length;
+            memcpy(sample->data, slot->data, slot->length);
+        }
+
+        tail++;
+        atomic_store_explicit(&ring_tail, tail, memory_order_release);
+        if (current)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void debug_stream_forget(void)
+{
+    active_count       = 0;
+    applied_generation = atomic_load_explicit(&sub_generation, memory_order_acquire);
+}
+
+// Scan thread: pick up a new subscription if the writer is not busy with it
+static void apply_subscription(unsigned int generation)
+{
+    if (pthread_mutex_trylock(&sub_mutex) != 0)
+    {
+        return;
+    }
+
+    active_count = 0;
+    active_bytes = 0;
+    for (uint16_t i = 0; i < requested_sub.count; i++)
+    {
+        uint16_t varidx = requested_sub.indexes[i];
+        size_t size     = ext_get_var_size(varidx);
+        if (active_bytes + size > DEBUG_STREAM_SAMPLE_SIZE)
+        {
+            break;
+        }
+        active_addr[active_count] = ext_get_var_addr(varidx);
+        active_size[active_count] = (uint16_t)size;
+        active_bytes += size;
+        active_count++;
+    }
+    active_mode      = requested_sub.mode;
+    active_rate      = requested_sub.rate;
+    scans_since_last = 0;
+    have_last        = false;
+
+    applied_generation = generation;
+    pthread_mutex_unlock(&sub_mutex);
+}
+
+void debug_stream_capture(void)
+{
+    unsigned int generation = atomic_load_explicit(&sub_generation, memory_order_acquire);
+    if (generation != applied_generation)
+    {
+        apply_subscription(generation);
+    }
+
+    if (active_count == 0)
+    {
+        return;
+    }
+
+    if (++scans_since_last < active_rate)
+    {
+        return;
+    }
+
+    size_t offset = 0;
+    for (uint16_t i = 0; i < active_count; i++)
+    {
+        memcpy(&capture_buffer[offset], active_addr[i], active_size[i]);
+        offset += active_size[i];
+    }
+
+    if (active_mode == DEBUG_STREAM_MODE_ON_CHANGE)
+    {
+        if (have_last && memcmp(capture_buffer, last_capture, active_bytes) == 0)
+        {
+            return;
+        }
+        memcpy(last_capture, capture_buffer, active_bytes);
+        have_last = true;
+    }
+    scans_since_last = 0;
+
+    unsigned int head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+    if (head - tail >= DEBUG_STREAM_RING_SLOTS)
+    {
+        // Consumer is behind, drop this sample and flag the gap on the next one
+        dropped_pending = true;
+        return;
+    }
+
+    debug_sample_t *slot = &ring[head & (DEBUG_STREAM_RING_SLOTS - 1)];
+    slot->generation     = applied_generation;
+    slot->tick           = (uint32_t)tick__;
+    slot->length         = (uint16_t)active_bytes;
+    slot->flags          = dropped_pending ? DEBUG_SAMPLE_FLAG_DROPPED : 0;
+    memcpy(slot->data, capture_buffer, active_bytes);
+    dropped_pending = false;
+
+    atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+}
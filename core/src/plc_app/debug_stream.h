@@ -0,0 +1,74 @@
+#ifndef DEBUG_STREAM_H
+#define DEBUG_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DEBUG_STREAM_SOCKET_PATH "/run/runtime/plc_debug_stream.socket"
+
+// Function codes used on the stream socket, next to the 0x41-0x45 debug codes
+#define MB_FC_DEBUG_SUBSCRIBE 0x46
+#define MB_FC_DEBUG_SAMPLE 0x47
+
+// Subscription modes
+#define DEBUG_STREAM_MODE_EVERY_N 0x00  // one sample every `rate` scans
+#define DEBUG_STREAM_MODE_ON_CHANGE 0x01 // a sample when any value changed, at most every `rate` scans
+
+// Limits of one subscription
+#define DEBUG_STREAM_MAX_VARS 512
+#define DEBUG_STREAM_SAMPLE_SIZE 2048
+
+// Sample flags
+#define DEBUG_SAMPLE_FLAG_DROPPED 0x01 // samples were lost before this one (ring full)
+
+typedef struct
+{
+    uint32_t generation; // subscription the sample belongs to
+    uint32_t tick;
+    uint16_t length;
+    uint8_t flags;
+    uint8_t data[DEBUG_STREAM_SAMPLE_SIZE];
+} debug_sample_t;
+
+/**
+ * @brief Handle a request received on the stream socket
+ *
+ * Subscribe payload:
+ *   46 [count hi] [count lo] [index1 hi] [index1 lo] ... [mode] [rate hi] [rate lo]
+ * A count of 0 cancels the subscription. The response (written over `data`,
+ * which must hold at least 2 bytes) is 46 7E on success or 46 [error code].
+ *
+ * @return The response length, or 0 for an unknown request
+ */
+size_t debug_stream_handle_request(uint8_t *data, size_t length);
+
+// Cancel the subscription (stream client went away)
+void debug_stream_unsubscribe(void);
+
+// Cancel the subscription because the program is being unloaded
+void debug_stream_invalidate(void);
+
+// Scan thread: stop capturing the applied subscription, whose addresses belong to a
+// program that is being replaced, until the next subscription is requested
+void debug_stream_forget(void);
+
+// True while a subscription is registered
+bool debug_stream_active(void);
+
+/**
+ * @brief Pop the oldest captured sample of the current subscription (stream
+ * socket thread only). Samples of earlier subscriptions are discarded.
+ * @return true if a sample was copied to `sample`
+ */
+bool debug_stream_pop(debug_sample_t *sample);
+
+/**
+ * @brief Capture the subscribed variables at the end of a scan
+ *
+ * Called by the scan thread after the cycle_end hooks, with the image mutex
+ * held, so every sample is one consistent scan. Never blocks or allocates.
+ */
+void debug_stream_capture(void);
+
+#endif // DEBUG_STREAM_H
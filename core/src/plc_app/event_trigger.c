@@ -0,0 +1,170 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "event_trigger.h"
+#include "image_tables.h"
+#include "journal_buffer.h"
+#include "task_scheduler.h"
+#include "utils/log.h"
+
+#define EVENT_TASK_NAME_MAX 64
+
+typedef struct
+{
+    char address[16]; // as given, for logs
+    journal_buffer_type_t type;
+    uint32_t index;
+    uint8_t bit;
+    char task[EVENT_TASK_NAME_MAX]; // empty for the scan thread's part
+    atomic_uint mask;               // set by event_trigger_bind()
+} event_trigger_t;
+
+static event_trigger_t triggers[EVENT_TRIGGER_MAX];
+static size_t trigger_count = 0;
+
+// Journal watch index to trigger index
+static size_t watch_trigger[JOURNAL_MAX_WATCHES];
+
+static size_t max_scans = EVENT_TRIGGER_DEFAULT_SCANS;
+static size_t scans     = 0; // event scans since the cycle started, scan thread only
+
+static plc_event_t event;
+static atomic_uint pending = 0;
+
+static void on_watch(size_t watch, void *ctx)
+{
+    (void)ctx;
+    event_trigger_t *trigger = &triggers[watch_trigger[watch]];
+    atomic_fetch_or_explicit(&pending, atomic_load_explicit(&trigger->mask, memory_order_relaxed),
+                             memory_order_relaxed);
+    plc_event_post(&event);
+}
+
+int event_trigger_add(const char *text)
+{
+    if (trigger_count >= EVENT_TRIGGER_MAX || trigger_count >= JOURNAL_MAX_WATCHES)
+    {
+        return -1;
+    }
+
+    event_trigger_t *trigger = &triggers[trigger_count];
+    const char *colon        = strchr(text, ':');
+    size_t address_length    = colon != NULL ? (size_t)(colon - text) : strlen(text);
+    if (journal_parse_address(text, address_length, &trigger->type, &trigger->index,
+                              &trigger->bit) != 0)
+    {
+        return -1;
+    }
+
+    trigger->task[0] = '\0';
+    if (colon != NULL)
+    {
+        size_t task_length = strlen(colon + 1);
+        if (task_length == 0 || task_length >= EVENT_TASK_NAME_MAX)
+        {
+            return -1;
+        }
+        memcpy(trigger->task, colon + 1, task_length + 1);
+    }
+    memcpy(trigger->address, text, address_length);
+    trigger->address[address_length] = '\0';
+    atomic_init(&trigger->mask, EVENT_TRIGGER_SCAN);
+    trigger_count++;
+    return 0;
+}
+
+int event_trigger_set_max_scans(size_t count)
+{
+    if (count < 1 || count > EVENT_TRIGGER_MAX_SCANS)
+    {
+        return -1;
+    }
+    max_scans = count;
+    return 0;
+}
+
+int event_trigger_init(void)
+{
+    if (trigger_count == 0)
+    {
+        return 0;
+    }
+
+    plc_event_init(&event);
+    for (size_t i = 0; i < trigger_count; i++)
+    {
+        event_trigger_t *trigger = &triggers[i];
+        if (trigger->index >= image_tables_size())
+        {
+            log_error("Event trigger %s: outside the image tables (%zu indexes)",
+                      trigger->address, image_tables_size());
+            return -1;
+        }
+        int watch = journal_watch_address(trigger->type, trigger->index, trigger->bit);
+        if (watch < 0)
+        {
+            log_error("Event trigger %s: cannot watch the address", trigger->address);
+            return -1;
+        }
+        watch_trigger[watch] = i;
+    }
+    journal_set_watch_handler(on_watch, NULL);
+
+    log_info("Event triggers: %zu, at most %zu event scans per cycle", trigger_count, max_scans);
+    return 0;
+}
+
+void event_trigger_bind(bool multi_task)
+{
+    for (size_t i = 0; i < trigger_count; i++)
+    {
+        event_trigger_t *trigger = &triggers[i];
+        unsigned int mask        = EVENT_TRIGGER_SCAN;
+        if (trigger->task[0] != '\0' && !multi_task)
+        {
+            log_warn("Event trigger %s: tasks run as a single task, %s runs with the scan",
+                     trigger->address, trigger->task);
+        }
+        else if (trigger->task[0] != '\0')
+        {
+            int task = task_scheduler_find(trigger->task);
+            if (task < 0)
+            {
+                log_warn("Event trigger %s: the program has no task %s, running the scan",
+                         trigger->address, trigger->task);
+            }
+            else
+            {
+                mask = 1u << task;
+            }
+        }
+        atomic_store_explicit(&trigger->mask, mask, memory_order_relaxed);
+    }
+    atomic_store_explicit(&pending, 0, memory_order_relaxed);
+    scans = 0;
+}
+
+plc_event_t *event_trigger_event(void)
+{
+    return trigger_count > 0 && scans < max_scans ? &event : NULL;
+}
+
+void event_trigger_cycle_start(void)
+{
+    scans = 0;
+    if (trigger_count > 0)
+    {
+        atomic_fetch_and_explicit(&pending, ~EVENT_TRIGGER_SCAN, memory_order_relaxed);
+    }
+}
+
+unsigned int event_trigger_take(void)
+{
+    unsigned int mask = atomic_exchange_explicit(&pending, 0, memory_order_relaxed);
+    if (mask != 0)
+    {
+        scans++;
+    }
+    return mask;
+}
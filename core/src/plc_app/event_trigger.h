@@ -0,0 +1,97 @@
+#ifndef EVENT_TRIGGER_H
+#define EVENT_TRIGGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/utils.h"
+
+/**
+ * @file event_trigger.h
+ * @brief Scans started by plugin writes to watched addresses
+ *
+ * Plugin writes reach the program at the start of the next cycle, so a input
+ * change waits up to one full cycle before the program sees it. An event
+ * trigger (--event-trigger) watches one address in the journal: when a plugin
+ * write changes its value, the journal wakes the scan thread, which runs an
+ * event scan at once instead of sleeping until the next slot.
+ *
+ * An event scan applies the journal and runs the plugin hooks like a cycle,
+ * then runs the trigger's task:
+ * - without a task, the program part the scan thread ran in the last cycle
+ *   (the whole program without multi-task scheduling), at the same tick
+ * - with a task name and --multi-task, only that task: run on the scan thread
+ *   if it is one of the shortest-interval tasks, or its thread is woken
+ *
+ * The next slot is kept, event scans do not move the periodic schedule, and
+ * they are counted in event_scans instead of the cycle statistics. At most
+ * --event-scans of them run between two cycles; further events wait for the
+ * next cycle, so a chattering input cannot starve the periodic scan.
+ */
+
+#define EVENT_TRIGGER_MAX 32
+#define EVENT_TRIGGER_DEFAULT_SCANS 4
+#define EVENT_TRIGGER_MAX_SCANS 1000
+
+// Trigger mask bit for the scan thread's part of the program, other bits are
+// task indexes
+#define EVENT_TRIGGER_SCAN (1u << 31)
+
+/**
+ * @brief Add an event trigger
+ *
+ * @param text "ADDRESS" or "ADDRESS:TASK", ADDRESS an IEC located address of
+ *             an input, output or memory (%IX0.3, %QW2, %MD10, ...)
+ * @return 0 on success, -1 if the text is invalid or too many triggers are set
+ */
+int event_trigger_add(const char *text);
+
+/**
+ * @brief Set the number of event scans allowed between two cycles
+ *
+ * @param scans 1 to EVENT_TRIGGER_MAX_SCANS
+ * @return 0 on success, -1 if out of range
+ */
+int event_trigger_set_max_scans(size_t scans);
+
+/**
+ * @brief Watch the trigger addresses in the journal
+ *
+ * Call after image_tables_init(), before plugins start.
+ *
+ * @return 0 on success, -1 if an address is outside the image tables
+ */
+int event_trigger_init(void);
+
+/**
+ * @brief Resolve the trigger tasks of a started program
+ *
+ * Called by the scan thread after task_scheduler_start().
+ *
+ * @param multi_task The result of task_scheduler_start()
+ */
+void event_trigger_bind(bool multi_task);
+
+/**
+ * @brief Event the scan thread waits on between two cycles
+ *
+ * @return The event, or NULL when there are no triggers or the event scans
+ *         of this cycle are used up
+ */
+plc_event_t *event_trigger_event(void);
+
+/**
+ * @brief Start of a cycle: it covers every pending trigger for the scan
+ *        thread's part of the program, and the event scan budget restarts
+ */
+void event_trigger_cycle_start(void);
+
+/**
+ * @brief Take the pending triggers for an event scan
+ *
+ * @return Mask of EVENT_TRIGGER_SCAN and task indexes to run, 0 if nothing
+ *         is pending (the event scan is then skipped and not counted)
+ */
+unsigned int event_trigger_take(void);
+
+#endif // EVENT_TRIGGER_H
@@ -0,0 +1,176 @@
+#include "image_gather.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define IMAGE_GATHER_X86
+#include <immintrin.h>
+#endif
+
+// The image tables point into the program's located variables, scattered
+// across its data. Most of the time goes to the loads and, for BOOL, to
+// mispredicted branches on the values, so the portable kernels avoid branching
+// on data and the AVX2 kernels load 4 variables per gather instruction. ARM has
+// no gather instruction, the portable kernels are used there.
+
+typedef struct
+{
+    void (*gather_bool)(uint8_t *dst, IEC_BOOL *(*src)[8], size_t size);
+    void (*gather_dint)(IEC_UDINT *dst, IEC_UDINT **src, size_t size);
+    void (*gather_lint)(IEC_ULINT *dst, IEC_ULINT **src, size_t size);
+    const char *name;
+} gather_kernels_t;
+
+// Portable
+
+#define GATHER_SCALAR(dst, src, size)                                                              \
+    for (size_t n = 0; n < (size); n++)                                                            \
+    {                                                                                              \
+        (dst)[n] = (src)[n] ? *(src)[n] : 0;                                                       \
+    }
+
+static void gather_bool_scalar(uint8_t *dst, IEC_BOOL *(*src)[8], size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        // The 8 values as the bytes of one word, then bit n = byte n is not 0
+        uint64_t bytes = 0;
+        for (int b = 0; b < 8; b++)
+        {
+            IEC_BOOL *ptr = src[i][b];
+            bytes |= (uint64_t)(ptr ? *ptr : 0) << (8 * b);
+        }
+        uint64_t set = (((bytes & 0x7f7f7f7f7f7f7f7full) + 0x7f7f7f7f7f7f7f7full) | bytes) >> 7;
+        set &= 0x0101010101010101ull;
+        dst[i] = (uint8_t)((set * 0x0102040810204080ull) >> 56);
+    }
+}
+
+static void gather_dint_scalar(IEC_UDINT *dst, IEC_UDINT **src, size_t size)
+{
+    GATHER_SCALAR(dst, src, size);
+}
+
+static void gather_lint_scalar(IEC_ULINT *dst, IEC_ULINT **src, size_t size)
+{
+    GATHER_SCALAR(dst, src, size);
+}
+
+// x86-64: AVX2 masked gathers, where NULL lanes are not loaded
+
+#ifdef IMAGE_GATHER_X86
+
+// All ones in the lanes of 4 pointers that are not NULL
+__attribute__((target("avx2"))) static inline __m256i bound_mask64(__m256i ptrs)
+{
+    __m256i null = _mm256_cmpeq_epi64(ptrs, _mm256_setzero_si256());
+    return _mm256_xor_si256(null, _mm256_set1_epi64x(-1));
+}
+
+__attribute__((target("avx2"))) static inline __m128i low_dwords(__m256i qwords)
+{
+    __m256i packed = _mm256_permutevar8x32_epi32(qwords, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0));
+    return _mm256_castsi256_si128(packed);
+}
+
+// The 4 bytes at 4 pointers. A byte cannot be gathered alone, so the aligned
+// dword holding it is loaded, which never crosses into another page, and
+// shifted down.
+__attribute__((target("avx2"))) static inline __m128i gather_bytes4(IEC_BOOL *const *src)
+{
+    __m256i ptrs    = _mm256_loadu_si256((const __m256i *)src);
+    __m256i aligned = _mm256_andnot_si256(_mm256_set1_epi64x(3), ptrs);
+    __m256i shift   = _mm256_slli_epi64(_mm256_and_si256(ptrs, _mm256_set1_epi64x(3)), 3);
+    __m128i dwords  = _mm256_mask_i64gather_epi32(_mm_setzero_si128(), (const int *)0, aligned,
+                                                  low_dwords(bound_mask64(ptrs)), 1);
+    dwords          = _mm_srlv_epi32(dwords, low_dwords(shift));
+    return _mm_and_si128(dwords, _mm_set1_epi32(0xff));
+}
+
+__attribute__((target("avx2"))) static void gather_bool_avx2(uint8_t *dst, IEC_BOOL *(*src)[8],
+                                                              size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        __m256i values = _mm256_set_m128i(gather_bytes4(&src[i][4]), gather_bytes4(&src[i][0]));
+        __m256i zero   = _mm256_cmpeq_epi32(values, _mm256_setzero_si256());
+        dst[i]         = (uint8_t)~_mm256_movemask_ps(_mm256_castsi256_ps(zero));
+    }
+}
+
+__attribute__((target("avx2"))) static void gather_dint_avx2(IEC_UDINT *dst, IEC_UDINT **src,
+                                                              size_t size)
+{
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        __m256i ptrs   = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m128i values = _mm256_mask_i64gather_epi32(_mm_setzero_si128(), (const int *)0, ptrs,
+                                                     low_dwords(bound_mask64(ptrs)), 1);
+        _mm_storeu_si128((__m128i *)(dst + i), values);
+    }
+    GATHER_SCALAR(dst + i, src + i, size - i);
+}
+
+__attribute__((target("avx2"))) static void gather_lint_avx2(IEC_ULINT *dst, IEC_ULINT **src,
+                                                              size_t size)
+{
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        __m256i ptrs   = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i values = _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), (const long long *)0,
+                                                     ptrs, bound_mask64(ptrs), 1);
+        _mm256_storeu_si256((__m256i *)(dst + i), values);
+    }
+    GATHER_SCALAR(dst + i, src + i, size - i);
+}
+
+#endif // IMAGE_GATHER_X86
+
+// Runtime selection
+
+static gather_kernels_t kernels = {gather_bool_scalar, gather_dint_scalar, gather_lint_scalar,
+                                   "scalar"};
+
+// Runs before main(), so the kernels never change while a scan uses them
+__attribute__((constructor)) static void select_kernels(void)
+{
+#ifdef IMAGE_GATHER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels = (gather_kernels_t){gather_bool_avx2, gather_dint_avx2, gather_lint_avx2, "avx2"};
+    }
+#endif
+}
+
+void image_gather_bool(uint8_t *dst, IEC_BOOL *(*src)[8], size_t size)
+{
+    kernels.gather_bool(dst, src, size);
+}
+
+// BYTE and INT gathers would load a dword per element like BOOL, for no gain
+// over plain loads, they are portable only
+void image_gather_byte(IEC_BYTE *dst, IEC_BYTE **src, size_t size)
+{
+    GATHER_SCALAR(dst, src, size);
+}
+
+void image_gather_int(IEC_UINT *dst, IEC_UINT **src, size_t size)
+{
+    GATHER_SCALAR(dst, src, size);
+}
+
+void image_gather_dint(IEC_UDINT *dst, IEC_UDINT **src, size_t size)
+{
+    kernels.gather_dint(dst, src, size);
+}
+
+void image_gather_lint(IEC_ULINT *dst, IEC_ULINT **src, size_t size)
+{
+    kernels.gather_lint(dst, src, size);
+}
+
+const char *image_gather_kernel(void)
+{
+    return kernels.name;
+}
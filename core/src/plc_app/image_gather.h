@@ -0,0 +1,33 @@
+#ifndef IMAGE_GATHER_H
+#define IMAGE_GATHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../lib/iec_types.h"
+
+/**
+ * @file image_gather.h
+ * @brief Bulk reads through the image table pointers
+ *
+ * Each function reads `size` entries of an image table into a contiguous
+ * array, unbound entries (NULL pointers) read as 0. BOOL tables are packed,
+ * bit n of dst[i] holding src[i][n].
+ *
+ * The kernel is chosen once at startup from what the CPU supports, so one
+ * plc_main binary serves every CPU of the architecture: AVX2 gathers on
+ * x86-64 when available, portable C everywhere else.
+ */
+
+void image_gather_bool(uint8_t *dst, IEC_BOOL *(*src)[8], size_t size);
+void image_gather_byte(IEC_BYTE *dst, IEC_BYTE **src, size_t size);
+void image_gather_int(IEC_UINT *dst, IEC_UINT **src, size_t size);
+void image_gather_dint(IEC_UDINT *dst, IEC_UDINT **src, size_t size);
+void image_gather_lint(IEC_ULINT *dst, IEC_ULINT **src, size_t size);
+
+/**
+ * @brief Name of the kernel in use ("avx2" or "scalar")
+ */
+const char *image_gather_kernel(void);
+
+#endif // IMAGE_GATHER_H
@@ -0,0 +1,512 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image_gather.h"
+#include "image_shadow.h"
+#include "image_tables.h"
+
+// Both copies of each packed area, set 0 then set 1, allocated when a plugin
+// first asks for the area and kept for the process lifetime so peeked
+// pointers stay valid. Areas nobody reads cost no memory.
+static _Atomic(uint8_t *) area_data[JOURNAL_TYPE_COUNT];
+
+// Double buffer: the scan thread writes the set that is not published
+// Per-set seqlock counters, odd while the set is being written
+static atomic_uint shadow_seq[2];
+
+// Snapshot generation stored in each set, incremented on every sync
+static uint32_t set_generation[2];
+static uint32_t next_generation = 1;
+
+// Index of the set holding the latest complete snapshot
+static atomic_int published_set = 0;
+
+// Bit t set: area t is refreshed every scan
+static atomic_uint enabled_areas = 0;
+
+// Bit t set: area t holds data from the current program
+static atomic_uint valid_areas = 0;
+
+// Change bits of each area, set 0 then set 1, allocated like area_data when a
+// plugin first asks for the changes of the area
+static _Atomic(uint8_t *) area_changes[JOURNAL_TYPE_COUNT];
+
+// Bit t set: area t is compared with the previous snapshot every scan
+static atomic_uint tracked_areas = 0;
+
+// Areas whose change bits each set holds, written with the set
+static unsigned int set_changes[2];
+
+static bool is_bool_area(journal_buffer_type_t type)
+{
+    return type <= JOURNAL_BOOL_MEMORY;
+}
+
+static uint8_t *area_base(int set, journal_buffer_type_t type)
+{
+    uint8_t *data = atomic_load_explicit(&area_data[type], memory_order_acquire);
+    return data + (size_t)set * image_tables_size() * journal_type_width(type);
+}
+
+// Bytes of change bits in one set: one bit per BOOL, one per element otherwise
+static size_t changes_size(journal_buffer_type_t type)
+{
+    size_t size = image_tables_size();
+    return is_bool_area(type) ? size : (size + 7) / 8;
+}
+
+static uint8_t *changes_base(int set, journal_buffer_type_t type)
+{
+    uint8_t *changes = atomic_load_explicit(&area_changes[type], memory_order_acquire);
+    return changes + (size_t)set * changes_size(type);
+}
+
+// Allocate on first use; concurrent first requests keep one allocation
+static bool buffer_alloc(_Atomic(uint8_t *) *slot, size_t bytes)
+{
+    if (atomic_load_explicit(slot, memory_order_acquire) != NULL)
+    {
+        return true;
+    }
+
+    uint8_t *data = calloc(1, bytes);
+    if (data == NULL)
+    {
+        return false;
+    }
+    uint8_t *expected = NULL;
+    if (!atomic_compare_exchange_strong(slot, &expected, data))
+    {
+        free(data);
+    }
+    return true;
+}
+
+static bool area_alloc(journal_buffer_type_t type)
+{
+    return buffer_alloc(&area_data[type], 2 * image_tables_size() * journal_type_width(type));
+}
+
+// Enable an area and report whether the published set already holds it
+static bool request_area(journal_buffer_type_t type)
+{
+    if ((unsigned int)type >= JOURNAL_TYPE_COUNT)
+    {
+        return false;
+    }
+
+    unsigned int bit = 1u << type;
+    if ((atomic_load_explicit(&enabled_areas, memory_order_relaxed) & bit) == 0)
+    {
+        if (!area_alloc(type))
+        {
+            return false;
+        }
+        atomic_fetch_or(&enabled_areas, bit);
+    }
+    return (atomic_load_explicit(&valid_areas, memory_order_acquire) & bit) != 0;
+}
+
+const void *image_shadow_get_area(journal_buffer_type_t type, size_t *length)
+{
+    if (!request_area(type))
+    {
+        return NULL;
+    }
+
+    // Stable while buffer_mutex is held: the scan thread only swaps sets under it
+    int idx = atomic_load_explicit(&published_set, memory_order_acquire);
+    if (length)
+    {
+        *length = image_tables_size();
+    }
+    return area_base(idx, type);
+}
+
+int image_shadow_read(journal_buffer_type_t type, size_t start, size_t count, void *dest,
+                      uint32_t *generation)
+{
+    if (dest == NULL || !request_area(type))
+    {
+        return -1;
+    }
+    size_t size = image_tables_size();
+    if (start >= size)
+    {
+        return 0;
+    }
+    if (count > size - start)
+    {
+        count = size - start;
+    }
+
+    size_t width = journal_type_width(type);
+    for (;;)
+    {
+        int idx     = atomic_load_explicit(&published_set, memory_order_acquire);
+        unsigned s1 = atomic_load_explicit(&shadow_seq[idx], memory_order_acquire);
+        if (s1 & 1u)
+        {
+            // The scan thread lapped us and is rewriting this set; retry on the other one
+            continue;
+        }
+
+        const uint8_t *base = area_base(idx, type);
+        memcpy(dest, base + start * width, count * width);
+        uint32_t gen = set_generation[idx];
+
+        atomic_thread_fence(memory_order_acquire);
+        unsigned s2 = atomic_load_explicit(&shadow_seq[idx], memory_order_relaxed);
+        if (s1 == s2)
+        {
+            if (generation)
+            {
+                *generation = gen;
+            }
+            return (int)count;
+        }
+    }
+}
+
+// Enable the comparison of an area, then the area itself like request_area()
+static bool request_changes(journal_buffer_type_t type)
+{
+    if ((unsigned int)type >= JOURNAL_TYPE_COUNT)
+    {
+        return false;
+    }
+
+    unsigned int bit = 1u << type;
+    if ((atomic_load_explicit(&tracked_areas, memory_order_relaxed) & bit) == 0)
+    {
+        if (!buffer_alloc(&area_changes[type], 2 * changes_size(type)))
+        {
+            return false;
+        }
+        atomic_fetch_or(&tracked_areas, bit);
+    }
+    return request_area(type);
+}
+
+// Copy bits [first, first + count) of src to the start of dest
+static void copy_bits(uint8_t *dest, const uint8_t *src, size_t first, size_t count)
+{
+    const uint8_t *from = src + first / 8;
+    size_t shift        = first % 8;
+    size_t bytes        = (count + 7) / 8;
+
+    for (size_t b = 0; b < bytes; b++)
+    {
+        unsigned int bits = (unsigned int)from[b] >> shift;
+        // The next source byte only when it holds bits of the range
+        if (shift != 0 && 8 * (b + 1) - shift < count)
+        {
+            bits |= (unsigned int)from[b + 1] << (8 - shift);
+        }
+        dest[b] = (uint8_t)bits;
+    }
+    if (count % 8 != 0)
+    {
+        dest[bytes - 1] &= (uint8_t)((1u << (count % 8)) - 1);
+    }
+}
+
+// Fill the change bits of a range of set idx, relative to generation `since`
+static void read_changes(int idx, journal_buffer_type_t type, size_t start, size_t count,
+                         uint8_t *changes, uint32_t since)
+{
+    uint32_t gen  = set_generation[idx];
+    size_t bytes  = is_bool_area(type) ? count : (count + 7) / 8;
+    bool previous = gen == since + 1 && (set_changes[idx] & (1u << type)) != 0;
+
+    if (gen == since)
+    {
+        memset(changes, 0, bytes);
+    }
+    else if (previous && is_bool_area(type))
+    {
+        memcpy(changes, changes_base(idx, type) + start, count);
+    }
+    else if (previous)
+    {
+        copy_bits(changes, changes_base(idx, type), start, count);
+    }
+    else
+    {
+        // Missed scans, or no comparison yet: everything may have changed
+        memset(changes, 0xff, bytes);
+        if (!is_bool_area(type) && count % 8 != 0)
+        {
+            changes[bytes - 1] = (uint8_t)((1u << (count % 8)) - 1);
+        }
+    }
+}
+
+int image_shadow_read_changes(journal_buffer_type_t type, size_t start, size_t count, void *dest,
+                              uint8_t *changes, uint32_t *generation)
+{
+    if (changes == NULL || generation == NULL || !request_changes(type))
+    {
+        return -1;
+    }
+    size_t size = image_tables_size();
+    if (start >= size)
+    {
+        return 0;
+    }
+    if (count > size - start)
+    {
+        count = size - start;
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    size_t width = journal_type_width(type);
+    for (;;)
+    {
+        int idx     = atomic_load_explicit(&published_set, memory_order_acquire);
+        unsigned s1 = atomic_load_explicit(&shadow_seq[idx], memory_order_acquire);
+        if (s1 & 1u)
+        {
+            continue;
+        }
+
+        if (dest)
+        {
+            memcpy(dest, area_base(idx, type) + start * width, count * width);
+        }
+        read_changes(idx, type, start, count, changes, *generation);
+        uint32_t gen = set_generation[idx];
+
+        atomic_thread_fence(memory_order_acquire);
+        unsigned s2 = atomic_load_explicit(&shadow_seq[idx], memory_order_relaxed);
+        if (s1 == s2)
+        {
+            *generation = gen;
+            return (int)count;
+        }
+    }
+}
+
+const void *image_shadow_peek(journal_buffer_type_t type, size_t *length,
+                              image_shadow_ticket_t *ticket)
+{
+    if (ticket == NULL || !request_area(type))
+    {
+        return NULL;
+    }
+
+    for (;;)
+    {
+        int idx     = atomic_load_explicit(&published_set, memory_order_acquire);
+        unsigned s1 = atomic_load_explicit(&shadow_seq[idx], memory_order_acquire);
+        if (s1 & 1u)
+        {
+            continue;
+        }
+        uint32_t gen = set_generation[idx];
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shadow_seq[idx], memory_order_relaxed) == s1)
+        {
+            ticket->type       = type;
+            ticket->set        = idx;
+            ticket->seq        = s1;
+            ticket->generation = gen;
+            if (length)
+            {
+                *length = image_tables_size();
+            }
+            return area_base(idx, type);
+        }
+    }
+}
+
+bool image_shadow_ticket_valid(const image_shadow_ticket_t *ticket)
+{
+    if (ticket == NULL || ticket->set < 0 || ticket->set > 1)
+    {
+        return false;
+    }
+
+    // Order the caller's reads of the set before the counter check
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&shadow_seq[ticket->set], memory_order_relaxed) != ticket->seq)
+    {
+        return false;
+    }
+    return (atomic_load_explicit(&valid_areas, memory_order_relaxed) & (1u << ticket->type)) != 0;
+}
+
+// Copy one area into `set`, unbound entries read as 0
+static void sync_area(int set, journal_buffer_type_t type)
+{
+    uint8_t *dst = area_base(set, type);
+    size_t size  = image_tables_size();
+
+    switch (type)
+    {
+    case JOURNAL_BOOL_INPUT:
+        image_gather_bool(dst, bool_input, size);
+        break;
+    case JOURNAL_BOOL_OUTPUT:
+        image_gather_bool(dst, bool_output, size);
+        break;
+    case JOURNAL_BOOL_MEMORY:
+        image_gather_bool(dst, bool_memory, size);
+        break;
+    case JOURNAL_BYTE_INPUT:
+        image_gather_byte((IEC_BYTE *)dst, byte_input, size);
+        break;
+    case JOURNAL_BYTE_OUTPUT:
+        image_gather_byte((IEC_BYTE *)dst, byte_output, size);
+        break;
+    case JOURNAL_INT_INPUT:
+        image_gather_int((IEC_UINT *)dst, int_input, size);
+        break;
+    case JOURNAL_INT_OUTPUT:
+        image_gather_int((IEC_UINT *)dst, int_output, size);
+        break;
+    case JOURNAL_INT_MEMORY:
+        image_gather_int((IEC_UINT *)dst, int_memory, size);
+        break;
+    case JOURNAL_DINT_INPUT:
+        image_gather_dint((IEC_UDINT *)dst, dint_input, size);
+        break;
+    case JOURNAL_DINT_OUTPUT:
+        image_gather_dint((IEC_UDINT *)dst, dint_output, size);
+        break;
+    case JOURNAL_DINT_MEMORY:
+        image_gather_dint((IEC_UDINT *)dst, dint_memory, size);
+        break;
+    case JOURNAL_LINT_INPUT:
+        image_gather_lint((IEC_ULINT *)dst, lint_input, size);
+        break;
+    case JOURNAL_LINT_OUTPUT:
+        image_gather_lint((IEC_ULINT *)dst, lint_output, size);
+        break;
+    case JOURNAL_LINT_MEMORY:
+        image_gather_lint((IEC_ULINT *)dst, lint_memory, size);
+        break;
+    default:
+        break;
+    }
+}
+
+// Bits of one block of up to 64 elements of type T that differ
+#define DIFF_BLOCK(T, cur, prev, first, n, bits)                                                  \
+    for (size_t k = 0; k < (n); k++)                                                               \
+    {                                                                                              \
+        (bits) |= (uint64_t)(((const T *)(cur))[(first) + k] != ((const T *)(prev))[(first) + k])  \
+                  << k;                                                                            \
+    }
+
+// Set the change bits of `set` from its snapshot of an area and the previous one
+static void diff_area(int set, journal_buffer_type_t type)
+{
+    const uint8_t *cur  = area_base(set, type);
+    const uint8_t *prev = area_base(1 - set, type);
+    uint8_t *changes    = changes_base(set, type);
+    size_t size         = image_tables_size();
+
+    if (is_bool_area(type))
+    {
+        // The changed bits of packed BOOLs are the XOR of the two snapshots
+        for (size_t i = 0; i < size; i++)
+        {
+            changes[i] = cur[i] ^ prev[i];
+        }
+        return;
+    }
+
+    // One word of change bits per block of 64 elements. Most blocks are
+    // unchanged from one scan to the next, memcmp() rules them out at memory
+    // speed and only the others are compared element by element.
+    size_t width = journal_type_width(type);
+    for (size_t first = 0; first < size; first += 64)
+    {
+        size_t n      = size - first < 64 ? size - first : 64;
+        uint64_t bits = 0;
+        if (memcmp(cur + first * width, prev + first * width, n * width) != 0)
+        {
+            switch (width)
+            {
+            case 1:
+                DIFF_BLOCK(uint8_t, cur, prev, first, n, bits);
+                break;
+            case 2:
+                DIFF_BLOCK(uint16_t, cur, prev, first, n, bits);
+                break;
+            case 4:
+                DIFF_BLOCK(uint32_t, cur, prev, first, n, bits);
+                break;
+            default:
+                DIFF_BLOCK(uint64_t, cur, prev, first, n, bits);
+                break;
+            }
+        }
+        for (size_t b = 0; b < (n + 7) / 8; b++)
+        {
+            changes[first / 8 + b] = (uint8_t)(bits >> (8 * b));
+        }
+    }
+}
+
+void image_shadow_sync(void)
+{
+    // Acquire pairs with area_alloc(), which publishes an area before enabling it
+    unsigned int areas = atomic_load_explicit(&enabled_areas, memory_order_acquire);
+    if (areas == 0)
+    {
+        return;
+    }
+    unsigned int synced = areas;
+
+    // Areas to compare whose other set holds the previous scan, the last sync
+    // wrote every valid area
+    unsigned int compared = atomic_load_explicit(&tracked_areas, memory_order_acquire) & areas &
+                            atomic_load_explicit(&valid_areas, memory_order_relaxed);
+
+    // Write into the set readers are not directed to
+    int idx     = 1 - atomic_load_explicit(&published_set, memory_order_relaxed);
+    unsigned s0 = atomic_load_explicit(&shadow_seq[idx], memory_order_relaxed);
+    atomic_store_explicit(&shadow_seq[idx], s0 + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    while (areas != 0)
+    {
+        journal_buffer_type_t type = (journal_buffer_type_t)__builtin_ctz(areas);
+        areas &= areas - 1;
+        sync_area(idx, type);
+        if (compared & (1u << type))
+        {
+            diff_area(idx, type);
+        }
+    }
+    set_generation[idx] = next_generation++;
+    set_changes[idx]    = compared;
+
+    atomic_store_explicit(&shadow_seq[idx], s0 + 2, memory_order_release);
+    atomic_store_explicit(&published_set, idx, memory_order_release);
+
+    // Areas enabled while this sync ran become valid on the next one
+    atomic_fetch_or_explicit(&valid_areas, synced, memory_order_release);
+}
+
+uint32_t image_shadow_generation(void)
+{
+    if (atomic_load_explicit(&valid_areas, memory_order_relaxed) == 0)
+    {
+        return 0;
+    }
+    return set_generation[atomic_load_explicit(&published_set, memory_order_relaxed)];
+}
+
+void image_shadow_invalidate(void)
+{
+    atomic_store(&valid_areas, 0);
+}
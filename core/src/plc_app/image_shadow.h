@@ -0,0 +1,162 @@
+#ifndef IMAGE_SHADOW_H
+#define IMAGE_SHADOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "journal_buffer.h"
+
+/**
+ * @file image_shadow.h
+ * @brief Packed, contiguous copies of the image tables
+ *
+ * The image tables are arrays of pointers into the PLC program's located
+ * variables, so reading N elements means chasing N pointers. The shadow keeps
+ * one contiguous array per area, refreshed once per scan by the scan thread,
+ * so bulk readers can memcpy a whole range instead.
+ *
+ * The shadow is double-buffered behind a seqlock: each scan writes the set
+ * readers are not pointed at and then publishes it, so image_shadow_read()
+ * never takes buffer_mutex and a slow reader never delays the scan.
+ *
+ * Layout per area (indexed like the image tables):
+ * - BOOL areas: one byte per index, bit n holds %IXi.n / %QXi.n / %MXi.n
+ * - BYTE/INT/DINT/LINT areas: one element of the IEC type per index
+ *
+ * Areas are identified by journal_buffer_type_t values. Only areas that a
+ * plugin asked for are allocated and refreshed, so the shadow costs nothing
+ * when unused.
+ *
+ * For plugins that only send what changed, each set can also carry the
+ * variables of an area that differ from the previous scan's snapshot, one bit
+ * per variable: bit n of byte i for %QXi.n in BOOL areas (the layout of the
+ * packed values), bit i % 8 of byte i / 8 for element i in the others. The
+ * comparison runs for the areas whose changes a plugin asked for.
+ */
+
+/**
+ * @brief Get the base pointer and length of a shadow area
+ *
+ * The first call for an area enables its refresh; the area becomes available
+ * after the next scan. Until then (and after a program unload) NULL is
+ * returned and the caller should fall back to the image table pointers.
+ *
+ * The returned pointer refers to the currently published set, which is only
+ * swapped while buffer_mutex is held. Callers must hold buffer_mutex while
+ * using it and fetch it again after each mutex_take. Readers that do not want
+ * to take the mutex should use image_shadow_read() instead.
+ *
+ * @param type Area to get (journal_buffer_type_t)
+ * @param length Receives the number of elements in the area (may be NULL)
+ * @return Base pointer of the area, or NULL if unavailable
+ */
+const void *image_shadow_get_area(journal_buffer_type_t type, size_t *length);
+
+/**
+ * @brief Copy elements of a shadow area without taking buffer_mutex
+ *
+ * Copies from the latest published snapshot, retrying if the scan thread
+ * rewrites that set during the copy. All elements come from the same scan.
+ * Like image_shadow_get_area(), the first call enables the area and fails
+ * until the next scan has refreshed it.
+ *
+ * @param type Area to read (journal_buffer_type_t)
+ * @param start First element index
+ * @param count Number of elements to copy (clipped to the area)
+ * @param dest Destination, count * element width bytes (see journal_type_width)
+ * @param generation Receives the snapshot generation, which increments every
+ *                   scan (may be NULL)
+ * @return Number of elements copied, or -1 if the area is unavailable
+ */
+int image_shadow_read(journal_buffer_type_t type, size_t start, size_t count, void *dest,
+                      uint32_t *generation);
+
+/**
+ * @brief Copy elements of a shadow area and which of them changed
+ *
+ * Like image_shadow_read(), and also fills `changes` with the change bits of
+ * the range relative to the snapshot the caller read before, identified by
+ * its generation: the bits of the last scan if that snapshot was the previous
+ * one, none if it is the same one, and all bits if it is older (or the
+ * caller has none yet, generation 0), so a caller that missed scans sends
+ * everything once instead of losing changes. The first call enables the
+ * comparison for the area; the bits are all set until it has run once.
+ *
+ * @param type Area to read (journal_buffer_type_t)
+ * @param start First element index
+ * @param count Number of elements (clipped to the area)
+ * @param dest Destination of the values, see image_shadow_read() (may be NULL)
+ * @param changes Destination of the change bits: count bytes for BOOL areas,
+ *                (count + 7) / 8 for the others
+ * @param generation In: generation of the caller's previous read, 0 if none.
+ *                   Out: generation of the snapshot read.
+ * @return Number of elements copied, or -1 if the area is unavailable
+ */
+int image_shadow_read_changes(journal_buffer_type_t type, size_t start, size_t count, void *dest,
+                              uint8_t *changes, uint32_t *generation);
+
+/**
+ * @brief Identifies the snapshot set a zero-copy reader was pointed at
+ */
+typedef struct
+{
+    int type;            // Area (journal_buffer_type_t)
+    int set;             // Shadow set index
+    unsigned seq;        // Seqlock counter of the set when it was handed out
+    uint32_t generation; // Snapshot generation of the set
+} image_shadow_ticket_t;
+
+/**
+ * @brief Get the published copy of a shadow area without taking buffer_mutex
+ *
+ * Unlike image_shadow_get_area(), the pointer may be used without the mutex:
+ * the sets are never freed, so it always points at valid memory, but the scan
+ * thread rewrites that set two scans later. Read the data first and then call
+ * image_shadow_ticket_valid(); only if it returns true do the values form one
+ * consistent snapshot. Enables the area like image_shadow_read().
+ *
+ * @param type Area to get (journal_buffer_type_t)
+ * @param length Receives the number of elements in the area (may be NULL)
+ * @param ticket Receives the set handed out, for image_shadow_ticket_valid()
+ * @return Base pointer of the area, or NULL if unavailable
+ */
+const void *image_shadow_peek(journal_buffer_type_t type, size_t *length,
+                              image_shadow_ticket_t *ticket);
+
+/**
+ * @brief Check that the set behind a ticket was not rewritten since it was handed out
+ *
+ * @param ticket Ticket filled in by image_shadow_peek()
+ * @return true if data read through the peeked pointer is consistent
+ */
+bool image_shadow_ticket_valid(const image_shadow_ticket_t *ticket);
+
+/**
+ * @brief Refresh all enabled shadow areas from the image tables
+ *
+ * Called once per scan by the scan thread after the PLC program has run.
+ * Writes the unpublished set and then publishes it.
+ *
+ * @note buffer_mutex MUST be held by the caller.
+ */
+void image_shadow_sync(void);
+
+/**
+ * @brief Generation of the published snapshot set
+ *
+ * Scan thread only, after image_shadow_sync().
+ *
+ * @return Generation of the latest snapshot, or 0 while no area is valid
+ */
+uint32_t image_shadow_generation(void);
+
+/**
+ * @brief Mark all shadow areas as stale
+ *
+ * Called when the PLC program is unloaded. Areas stay enabled and become
+ * available again after the first scan of the next program.
+ */
+void image_shadow_invalidate(void);
+
+#endif // IMAGE_SHADOW_H
@@ -1,37 +1,39 @@
 #include <dlfcn.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "image_tables.h"
+#include "huge_pages.h"
 #include "include/iec_python.h"
 #include "log.h"
 #include "utils.h"
 
 // Internal buffers for I/O and memory.
 // Booleans
-IEC_BOOL *bool_input[BUFFER_SIZE][8];
-IEC_BOOL *bool_output[BUFFER_SIZE][8];
+IEC_BOOL *(*bool_input)[8];
+IEC_BOOL *(*bool_output)[8];
 
 // Bytes
-IEC_BYTE *byte_input[BUFFER_SIZE];
-IEC_BYTE *byte_output[BUFFER_SIZE];
+IEC_BYTE **byte_input;
+IEC_BYTE **byte_output;
 
 // Analog I/O
-IEC_UINT *int_input[BUFFER_SIZE];
-IEC_UINT *int_output[BUFFER_SIZE];
+IEC_UINT **int_input;
+IEC_UINT **int_output;
 
 // 32bit I/O
-IEC_UDINT *dint_input[BUFFER_SIZE];
-IEC_UDINT *dint_output[BUFFER_SIZE];
+IEC_UDINT **dint_input;
+IEC_UDINT **dint_output;
 
 // 64bit I/O
-IEC_ULINT *lint_input[BUFFER_SIZE];
-IEC_ULINT *lint_output[BUFFER_SIZE];
+IEC_ULINT **lint_input;
+IEC_ULINT **lint_output;
 
 // Memory
-IEC_UINT *int_memory[BUFFER_SIZE];
-IEC_UDINT *dint_memory[BUFFER_SIZE];
-IEC_ULINT *lint_memory[BUFFER_SIZE];
-IEC_BOOL *bool_memory[BUFFER_SIZE][8];
+IEC_UINT **int_memory;
+IEC_UDINT **dint_memory;
+IEC_ULINT **lint_memory;
+IEC_BOOL *(*bool_memory)[8];
 
 void (*ext_config_run__)(unsigned long tick);
 void (*ext_config_init__)(void);
@@ -63,73 +65,93 @@ size_t (*ext_get_var_size)(size_t idx);
 void *(*ext_get_var_addr)(size_t idx);
 void (*ext_set_trace)(size_t idx, bool forced, void *val);
 
-int symbols_init(PluginManager *pm)
+// An entry a program bound to one of its located variables
+typedef struct
+{
+    uint32_t table;
+    uint32_t slot;
+} glue_entry_t;
+
+struct image_table_set
 {
+    IEC_BOOL *(*bool_input)[8];
+    IEC_BOOL *(*bool_output)[8];
+    IEC_BOOL *(*bool_memory)[8];
+    IEC_BYTE **byte_input;
+    IEC_BYTE **byte_output;
+    IEC_UINT **int_input;
+    IEC_UINT **int_output;
+    IEC_UINT **int_memory;
+    IEC_UDINT **dint_input;
+    IEC_UDINT **dint_output;
+    IEC_UDINT **dint_memory;
+    IEC_ULINT **lint_input;
+    IEC_ULINT **lint_output;
+    IEC_ULINT **lint_memory;
+
+    // Filled by image_table_set_collect()
+    glue_entry_t *bindings;
+    size_t binding_count;
+
+    // Backing of the entries left NULL, allocated by image_table_set_fill()
+    unsigned char *temp;
+};
+
+int symbols_resolve(PluginManager *pm, plc_symbols_t *symbols)
+{
+    memset(symbols, 0, sizeof(*symbols));
+
     // Get pointer to external functions
-    *(void **)(&ext_config_run__) =
+    *(void **)(&symbols->config_run__) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "config_run__");
 
-    *(void **)(&ext_config_init__) =
+    *(void **)(&symbols->config_init__) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "config_init__");
 
-    *(void **)(&ext_glueVars) = plugin_manager_get_func(pm, void (*)(unsigned long), "glueVars");
+    *(void **)(&symbols->glueVars) =
+        plugin_manager_get_func(pm, void (*)(unsigned long), "glueVars");
 
-    *(void **)(&ext_updateTime) =
+    *(void **)(&symbols->updateTime) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "updateTime");
 
-    *(void **)(&ext_setBufferPointers) =
+    *(void **)(&symbols->setBufferPointers) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "setBufferPointers");
 
     // Try to load v4 version with bool_memory support (optional - only present in v4 programs)
-    *(void **)(&ext_setBufferPointers_v4) =
+    *(void **)(&symbols->setBufferPointers_v4) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "setBufferPointers_v4");
 
-    *(void **)(&ext_common_ticktime__) =
+    *(void **)(&symbols->common_ticktime__) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "common_ticktime__");
 
-    *(void **)(&ext_plc_program_md5) =
+    *(void **)(&symbols->plc_program_md5) =
         plugin_manager_get_func(pm, char *(*)(unsigned long), "plc_program_md5");
 
-    *(void **)(&ext_set_endianness) =
+    *(void **)(&symbols->set_endianness) =
         plugin_manager_get_func(pm, void (*)(unsigned long), "set_endianness");
 
-    *(void **)(&ext_get_var_count) =
+    *(void **)(&symbols->get_var_count) =
         plugin_manager_get_func(pm, uint16_t (*)(uint16_t), "get_var_count");
 
-    *(void **)(&ext_get_var_size) = plugin_manager_get_func(pm, size_t (*)(size_t), "get_var_size");
+    *(void **)(&symbols->get_var_size) =
+        plugin_manager_get_func(pm, size_t (*)(size_t), "get_var_size");
 
-    *(void **)(&ext_get_var_addr) =
+    *(void **)(&symbols->get_var_addr) =
         plugin_manager_get_func(pm, void *(*)(unsigned long), "get_var_addr");
 
-    *(void **)(&ext_set_trace) = plugin_manager_get_func(pm, void (*)(unsigned long), "set_trace");
+    *(void **)(&symbols->set_trace) =
+        plugin_manager_get_func(pm, void (*)(unsigned long), "set_trace");
 
     // Check if all symbols were loaded successfully
-    if (!ext_config_run__ || !ext_config_init__ || !ext_glueVars || !ext_updateTime ||
-        !ext_setBufferPointers || !ext_common_ticktime__ || !ext_plc_program_md5 ||
-        !ext_set_endianness || !ext_get_var_count || !ext_get_var_size || !ext_get_var_addr ||
-        !ext_set_trace)
+    if (!symbols->config_run__ || !symbols->config_init__ || !symbols->glueVars ||
+        !symbols->updateTime || !symbols->setBufferPointers || !symbols->common_ticktime__ ||
+        !symbols->plc_program_md5 || !symbols->set_endianness || !symbols->get_var_count ||
+        !symbols->get_var_size || !symbols->get_var_addr || !symbols->set_trace)
     {
         log_error("Failed to load all symbols");
         return -1;
     }
 
-    // Send buffer pointers to .so
-    // Try v4 version first (with bool_memory support for %MX), fall back to v1 for older programs
-    if (ext_setBufferPointers_v4)
-    {
-        log_info("Using setBufferPointers_v4 with bool_memory support");
-        ext_setBufferPointers_v4(bool_input, bool_output, byte_input, byte_output, int_input,
-                                 int_output, dint_input, dint_output, lint_input, lint_output,
-                                 int_memory, dint_memory, lint_memory, bool_memory);
-    }
-    else
-    {
-        log_info("Using setBufferPointers (legacy, no bool_memory support)");
-        ext_setBufferPointers(bool_input, bool_output, byte_input, byte_output, int_input,
-                              int_output, dint_input, dint_output, lint_input, lint_output,
-                              int_memory, dint_memory, lint_memory);
-    }
-
     // Initialize Python loader logging callbacks (optional - only present if Python FBs are used)
     void (*ext_python_loader_set_loggers)(void (*)(const char *, ...), void (*)(const char *, ...));
     *(void **)(&ext_python_loader_set_loggers) =
@@ -143,290 +165,501 @@ int symbols_init(PluginManager *pm)
     return 0;
 }
 
-// Static backing arrays for NULL pointer fill
-// These provide temporary storage for image table entries not used by the PLC program
-static IEC_BOOL temp_bool_input[BUFFER_SIZE][8];
-static IEC_BOOL temp_bool_output[BUFFER_SIZE][8];
-static IEC_BYTE temp_byte_input[BUFFER_SIZE];
-static IEC_BYTE temp_byte_output[BUFFER_SIZE];
-static IEC_UINT temp_int_input[BUFFER_SIZE];
-static IEC_UINT temp_int_output[BUFFER_SIZE];
-static IEC_UDINT temp_dint_input[BUFFER_SIZE];
-static IEC_UDINT temp_dint_output[BUFFER_SIZE];
-static IEC_ULINT temp_lint_input[BUFFER_SIZE];
-static IEC_ULINT temp_lint_output[BUFFER_SIZE];
-static IEC_UINT temp_int_memory[BUFFER_SIZE];
-static IEC_UDINT temp_dint_memory[BUFFER_SIZE];
-static IEC_ULINT temp_lint_memory[BUFFER_SIZE];
-static IEC_BOOL temp_bool_memory[BUFFER_SIZE][8];
-
-void image_tables_fill_null_pointers(void)
+void symbols_install(const plc_symbols_t *symbols)
 {
-    int filled_count = 0;
+    ext_config_run__         = symbols->config_run__;
+    ext_config_init__        = symbols->config_init__;
+    ext_glueVars             = symbols->glueVars;
+    ext_updateTime           = symbols->updateTime;
+    ext_setBufferPointers    = symbols->setBufferPointers;
+    ext_setBufferPointers_v4 = symbols->setBufferPointers_v4;
+    ext_common_ticktime__    = symbols->common_ticktime__;
+    ext_plc_program_md5      = symbols->plc_program_md5;
+    ext_set_endianness       = symbols->set_endianness;
+    ext_get_var_count        = symbols->get_var_count;
+    ext_get_var_size         = symbols->get_var_size;
+    ext_get_var_addr         = symbols->get_var_addr;
+    ext_set_trace            = symbols->set_trace;
+}
 
-    // Fill boolean input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+void symbols_set_buffers(const plc_symbols_t *symbols, image_table_set_t *set)
+{
+    // Try v4 version first (with bool_memory support for %MX), fall back to v1 for older programs
+    if (!set && symbols->setBufferPointers_v4)
     {
-        for (int b = 0; b < 8; b++)
-        {
-            if (bool_input[i][b] == NULL)
-            {
-                temp_bool_input[i][b] = 0;
-                bool_input[i][b]      = &temp_bool_input[i][b];
-                filled_count++;
-            }
-        }
+        symbols->setBufferPointers_v4(bool_input, bool_output, byte_input, byte_output, int_input,
+                                      int_output, dint_input, dint_output, lint_input,
+                                      lint_output, int_memory, dint_memory, lint_memory,
+                                      bool_memory);
     }
-
-    // Fill boolean output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    else if (!set)
     {
-        for (int b = 0; b < 8; b++)
-        {
-            if (bool_output[i][b] == NULL)
-            {
-                temp_bool_output[i][b] = 0;
-                bool_output[i][b]      = &temp_bool_output[i][b];
-                filled_count++;
-            }
-        }
+        symbols->setBufferPointers(bool_input, bool_output, byte_input, byte_output, int_input,
+                                   int_output, dint_input, dint_output, lint_input, lint_output,
+                                   int_memory, dint_memory, lint_memory);
     }
-
-    // Fill byte input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    else if (symbols->setBufferPointers_v4)
     {
-        if (byte_input[i] == NULL)
-        {
-            temp_byte_input[i] = 0;
-            byte_input[i]      = &temp_byte_input[i];
-            filled_count++;
-        }
+        symbols->setBufferPointers_v4(
+            set->bool_input, set->bool_output, set->byte_input, set->byte_output, set->int_input,
+            set->int_output, set->dint_input, set->dint_output, set->lint_input, set->lint_output,
+            set->int_memory, set->dint_memory, set->lint_memory, set->bool_memory);
     }
-
-    // Fill byte output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    else
     {
-        if (byte_output[i] == NULL)
-        {
-            temp_byte_output[i] = 0;
-            byte_output[i]      = &temp_byte_output[i];
-            filled_count++;
-        }
+        symbols->setBufferPointers(set->bool_input, set->bool_output, set->byte_input,
+                                   set->byte_output, set->int_input, set->int_output,
+                                   set->dint_input, set->dint_output, set->lint_input,
+                                   set->lint_output, set->int_memory, set->dint_memory,
+                                   set->lint_memory);
     }
+}
 
-    // Fill int input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+int symbols_init(PluginManager *pm)
+{
+    plc_symbols_t symbols;
+    if (symbols_resolve(pm, &symbols) != 0)
     {
-        if (int_input[i] == NULL)
-        {
-            temp_int_input[i] = 0;
-            int_input[i]      = &temp_int_input[i];
-            filled_count++;
-        }
+        return -1;
     }
+    symbols_install(&symbols);
 
-    // Fill int output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    // Send buffer pointers to .so
+    if (symbols.setBufferPointers_v4)
     {
-        if (int_output[i] == NULL)
-        {
-            temp_int_output[i] = 0;
-            int_output[i]      = &temp_int_output[i];
-            filled_count++;
-        }
+        log_info("Using setBufferPointers_v4 with bool_memory support");
     }
-
-    // Fill dint input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    else
     {
-        if (dint_input[i] == NULL)
-        {
-            temp_dint_input[i] = 0;
-            dint_input[i]      = &temp_dint_input[i];
-            filled_count++;
-        }
+        log_info("Using setBufferPointers (legacy, no bool_memory support)");
     }
+    symbols_set_buffers(&symbols, NULL);
+
+    return 0;
+}
+
+// One image table seen as a flat array of entries. BOOL tables are rows of
+// 8 contiguous entries, so entry i is bit i % 8 of index i / 8. Tables are in
+// journal_buffer_type_t order.
+typedef struct
+{
+    void **entries;
+    size_t count;
+    size_t width;
+    unsigned char *temp; // Temporary backing, count * width bytes
+} image_table_t;
+
+#define TABLE_COUNT 14
+
+static size_t table_size = BUFFER_SIZE;
 
-    // Fill dint output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+static image_table_t tables[TABLE_COUNT];
+
+// Glue map: every live entry not listed here points at its temporary backing
+static glue_entry_t *glue_map = NULL;
+static size_t glue_count      = 0;
+static size_t glue_capacity   = 0;
+
+// Set once every entry points either at a program variable or at its temporary backing
+static bool tables_backed = false;
+
+int image_tables_set_size(size_t size)
+{
+    if (tables[0].entries != NULL || size < BUFFER_SIZE || size > IMAGE_TABLE_MAX_SIZE)
     {
-        if (dint_output[i] == NULL)
+        return -1;
+    }
+    table_size = size;
+    return 0;
+}
+
+size_t image_tables_size(void)
+{
+    return table_size;
+}
+
+// Describe the tables of a set, in the order of the tables array
+static void describe_set(const image_table_set_t *set, image_table_t out[TABLE_COUNT])
+{
+    void **entries[TABLE_COUNT] = {
+        (void **)set->bool_input, (void **)set->bool_output, (void **)set->bool_memory,
+        (void **)set->byte_input, (void **)set->byte_output, (void **)set->int_input,
+        (void **)set->int_output, (void **)set->int_memory,  (void **)set->dint_input,
+        (void **)set->dint_output, (void **)set->dint_memory, (void **)set->lint_input,
+        (void **)set->lint_output, (void **)set->lint_memory,
+    };
+    static const size_t widths[TABLE_COUNT] = {
+        sizeof(IEC_BOOL),  sizeof(IEC_BOOL),  sizeof(IEC_BOOL),  sizeof(IEC_BYTE),
+        sizeof(IEC_BYTE),  sizeof(IEC_UINT),  sizeof(IEC_UINT),  sizeof(IEC_UINT),
+        sizeof(IEC_UDINT), sizeof(IEC_UDINT), sizeof(IEC_UDINT), sizeof(IEC_ULINT),
+        sizeof(IEC_ULINT), sizeof(IEC_ULINT),
+    };
+
+    for (size_t t = 0; t < TABLE_COUNT; t++)
+    {
+        out[t].entries = entries[t];
+        out[t].count   = t <= 2 ? table_size * 8 : table_size;
+        out[t].width   = widths[t];
+        out[t].temp    = NULL;
+    }
+}
+
+static int set_alloc(image_table_set_t *set)
+{
+    set->bool_input  = calloc(table_size, sizeof(*set->bool_input));
+    set->bool_output = calloc(table_size, sizeof(*set->bool_output));
+    set->bool_memory = calloc(table_size, sizeof(*set->bool_memory));
+    set->byte_input  = calloc(table_size, sizeof(*set->byte_input));
+    set->byte_output = calloc(table_size, sizeof(*set->byte_output));
+    set->int_input   = calloc(table_size, sizeof(*set->int_input));
+    set->int_output  = calloc(table_size, sizeof(*set->int_output));
+    set->int_memory  = calloc(table_size, sizeof(*set->int_memory));
+    set->dint_input  = calloc(table_size, sizeof(*set->dint_input));
+    set->dint_output = calloc(table_size, sizeof(*set->dint_output));
+    set->dint_memory = calloc(table_size, sizeof(*set->dint_memory));
+    set->lint_input  = calloc(table_size, sizeof(*set->lint_input));
+    set->lint_output = calloc(table_size, sizeof(*set->lint_output));
+    set->lint_memory = calloc(table_size, sizeof(*set->lint_memory));
+
+    image_table_t described[TABLE_COUNT];
+    describe_set(set, described);
+    for (size_t t = 0; t < TABLE_COUNT; t++)
+    {
+        if (described[t].entries == NULL)
         {
-            temp_dint_output[i] = 0;
-            dint_output[i]      = &temp_dint_output[i];
-            filled_count++;
+            return -1;
         }
     }
+    return 0;
+}
 
-    // Fill lint input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+static void set_free(image_table_set_t *set)
+{
+    image_table_t described[TABLE_COUNT];
+    describe_set(set, described);
+    for (size_t t = 0; t < TABLE_COUNT; t++)
     {
-        if (lint_input[i] == NULL)
-        {
-            temp_lint_input[i] = 0;
-            lint_input[i]      = &temp_lint_input[i];
-            filled_count++;
-        }
+        free(described[t].entries);
     }
+    free(set->bindings);
+    free(set->temp);
+}
 
-    // Fill lint output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+// Next 64 byte aligned block of the live arena
+static void *arena_take(unsigned char **next, size_t bytes)
+{
+    void *block = *next;
+    *next += (bytes + 63) & ~(size_t)63;
+    return block;
+}
+
+int image_tables_init(void)
+{
+    if (tables[0].entries != NULL)
     {
-        if (lint_output[i] == NULL)
-        {
-            temp_lint_output[i] = 0;
-            lint_output[i]      = &temp_lint_output[i];
-            filled_count++;
-        }
+        return 0;
     }
 
-    // Fill int memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    // The live tables are a set too, published through the globals. Their
+    // entries and temporary backing share one block, on huge pages if
+    // enabled, since the scan touches all of them every cycle.
+    image_table_set_t live = {0};
+    describe_set(&live, tables);
+    size_t arena_size = 0;
+    for (size_t t = 0; t < TABLE_COUNT; t++)
     {
-        if (int_memory[i] == NULL)
-        {
-            temp_int_memory[i] = 0;
-            int_memory[i]      = &temp_int_memory[i];
-            filled_count++;
-        }
+        arena_size += (tables[t].count * sizeof(void *) + 63) & ~(size_t)63;
+        arena_size += (tables[t].count * tables[t].width + 63) & ~(size_t)63;
     }
 
-    // Fill dint memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    huge_pages_mode_t backing;
+    unsigned char *next = huge_pages_alloc(arena_size, &backing);
+    if (next == NULL)
     {
-        if (dint_memory[i] == NULL)
-        {
-            temp_dint_memory[i] = 0;
-            dint_memory[i]      = &temp_dint_memory[i];
-            filled_count++;
-        }
+        log_error("Failed to allocate image tables of %zu indexes", table_size);
+        return -1;
     }
 
-    // Fill lint memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    live.bool_input  = arena_take(&next, table_size * sizeof(*live.bool_input));
+    live.bool_output = arena_take(&next, table_size * sizeof(*live.bool_output));
+    live.bool_memory = arena_take(&next, table_size * sizeof(*live.bool_memory));
+    live.byte_input  = arena_take(&next, table_size * sizeof(*live.byte_input));
+    live.byte_output = arena_take(&next, table_size * sizeof(*live.byte_output));
+    live.int_input   = arena_take(&next, table_size * sizeof(*live.int_input));
+    live.int_output  = arena_take(&next, table_size * sizeof(*live.int_output));
+    live.int_memory  = arena_take(&next, table_size * sizeof(*live.int_memory));
+    live.dint_input  = arena_take(&next, table_size * sizeof(*live.dint_input));
+    live.dint_output = arena_take(&next, table_size * sizeof(*live.dint_output));
+    live.dint_memory = arena_take(&next, table_size * sizeof(*live.dint_memory));
+    live.lint_input  = arena_take(&next, table_size * sizeof(*live.lint_input));
+    live.lint_output = arena_take(&next, table_size * sizeof(*live.lint_output));
+    live.lint_memory = arena_take(&next, table_size * sizeof(*live.lint_memory));
+
+    describe_set(&live, tables);
+    for (size_t t = 0; t < TABLE_COUNT; t++)
+    {
+        tables[t].temp = arena_take(&next, tables[t].count * tables[t].width);
+    }
+
+    bool_input  = live.bool_input;
+    bool_output = live.bool_output;
+    bool_memory = live.bool_memory;
+    byte_input  = live.byte_input;
+    byte_output = live.byte_output;
+    int_input   = live.int_input;
+    int_output  = live.int_output;
+    int_memory  = live.int_memory;
+    dint_input  = live.dint_input;
+    dint_output = live.dint_output;
+    dint_memory = live.dint_memory;
+    lint_input  = live.lint_input;
+    lint_output = live.lint_output;
+    lint_memory = live.lint_memory;
+
+    log_info("Image tables allocated with %zu indexes (%zu KiB, huge pages: %s)", table_size,
+             arena_size / 1024, huge_pages_mode_name(backing));
+    return 0;
+}
+
+image_table_set_t *image_table_set_create(void)
+{
+    image_table_set_t *set = calloc(1, sizeof(image_table_set_t));
+    if (set == NULL)
     {
-        if (lint_memory[i] == NULL)
-        {
-            temp_lint_memory[i] = 0;
-            lint_memory[i]      = &temp_lint_memory[i];
-            filled_count++;
-        }
+        return NULL;
+    }
+    if (set_alloc(set) != 0)
+    {
+        image_table_set_destroy(set);
+        return NULL;
     }
+    return set;
+}
 
-    // Fill bool memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+void image_table_set_destroy(image_table_set_t *set)
+{
+    if (set == NULL)
     {
-        for (int b = 0; b < 8; b++)
-        {
-            if (bool_memory[i][b] == NULL)
-            {
-                temp_bool_memory[i][b] = 0;
-                bool_memory[i][b]      = &temp_bool_memory[i][b];
-                filled_count++;
-            }
-        }
+        return;
     }
+    set_free(set);
+    free(set);
+}
 
-    log_info("Filled %d NULL pointers in image tables with temporary buffers", filled_count);
+static void *temp_slot(const image_table_t *table, size_t slot)
+{
+    return table->temp + slot * table->width;
 }
 
-void image_tables_clear_null_pointers(void)
+static int glue_map_reserve(size_t count)
 {
-    // Clear all pointers in image tables
-    // All pointers will be remapped when a new program is loaded via glueVars()
+    if (count <= glue_capacity)
+    {
+        return 0;
+    }
+    size_t capacity = glue_capacity ? glue_capacity : 256;
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+    glue_entry_t *larger = realloc(glue_map, capacity * sizeof(glue_entry_t));
+    if (larger == NULL)
+    {
+        return -1;
+    }
+    glue_map      = larger;
+    glue_capacity = capacity;
+    return 0;
+}
 
-    // Clear boolean input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+// Point the entries in the glue map back at their temporary backing, cleared
+static void glue_map_release(void)
+{
+    for (size_t i = 0; i < glue_count; i++)
     {
-        for (int b = 0; b < 8; b++)
-        {
-            bool_input[i][b] = NULL;
-        }
+        image_table_t *table = &tables[glue_map[i].table];
+        void *temp           = temp_slot(table, glue_map[i].slot);
+        memset(temp, 0, table->width);
+        table->entries[glue_map[i].slot] = temp;
     }
+    glue_count = 0;
+}
 
-    // Clear boolean output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+void image_tables_fill_null_pointers(void)
+{
+    // glueVars() is opaque, so finding what it bound takes one read of every
+    // entry. Only the entries it left NULL (all of them on the first load)
+    // and the ones it bound are written.
+    int filled_count = 0;
+    int lost_count   = 0;
+    glue_count       = 0;
+    for (uint32_t t = 0; t < TABLE_COUNT; t++)
     {
-        for (int b = 0; b < 8; b++)
+        image_table_t *table = &tables[t];
+        for (uint32_t slot = 0; slot < table->count; slot++)
         {
-            bool_output[i][b] = NULL;
+            void *entry = table->entries[slot];
+            void *temp  = temp_slot(table, slot);
+            if (entry == temp)
+            {
+                continue;
+            }
+            if (entry == NULL)
+            {
+                table->entries[slot] = temp;
+                filled_count++;
+            }
+            else if (glue_map_reserve(glue_count + 1) == 0)
+            {
+                glue_map[glue_count].table = t;
+                glue_map[glue_count].slot  = slot;
+                glue_count++;
+            }
+            else
+            {
+                // Untracked, it could not be released: keep the program off it
+                table->entries[slot] = temp;
+                lost_count++;
+            }
         }
     }
+    tables_backed = true;
 
-    // Clear byte input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    if (filled_count > 0)
     {
-        byte_input[i] = NULL;
+        log_info("Filled %d NULL pointers in image tables with temporary buffers", filled_count);
     }
-
-    // Clear byte output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    if (lost_count > 0)
     {
-        byte_output[i] = NULL;
+        log_error("Out of memory recording image table bindings, %d entries unbound",
+                  lost_count);
     }
+    log_info("Program bound %zu image table entries", glue_count);
+}
 
-    // Clear int input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+size_t image_tables_bound_slots(uint32_t table, uint32_t *slots, size_t max)
+{
+    // The glue map is filled table by table in slot order
+    size_t count = 0;
+    for (size_t i = 0; i < glue_count; i++)
     {
-        int_input[i] = NULL;
+        if (glue_map[i].table != table)
+        {
+            continue;
+        }
+        if (slots != NULL && count < max)
+        {
+            slots[count] = glue_map[i].slot;
+        }
+        count++;
     }
+    return count;
+}
 
-    // Clear int output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+void image_tables_clear_null_pointers(void)
+{
+    if (!tables_backed)
     {
-        int_output[i] = NULL;
+        // Nothing was filled yet: the tables hold no pointers
+        return;
     }
+    size_t released = glue_count;
+    glue_map_release();
+    log_info("Released %zu image table entries bound by the program", released);
+}
 
-    // Clear dint input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
-    {
-        dint_input[i] = NULL;
-    }
+int image_table_set_collect(image_table_set_t *set)
+{
+    image_table_t staged[TABLE_COUNT];
+    describe_set(set, staged);
 
-    // Clear dint output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    size_t count = 0;
+    for (size_t t = 0; t < TABLE_COUNT; t++)
     {
-        dint_output[i] = NULL;
+        for (size_t slot = 0; slot < staged[t].count; slot++)
+        {
+            count += staged[t].entries[slot] != NULL;
+        }
     }
 
-    // Clear lint input pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    free(set->bindings);
+    set->bindings      = malloc((count ? count : 1) * sizeof(glue_entry_t));
+    set->binding_count = 0;
+    if (set->bindings == NULL || glue_map_reserve(count) != 0)
     {
-        lint_input[i] = NULL;
+        return -1;
     }
 
-    // Clear lint output pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    for (uint32_t t = 0; t < TABLE_COUNT; t++)
     {
-        lint_output[i] = NULL;
+        for (uint32_t slot = 0; slot < staged[t].count; slot++)
+        {
+            if (staged[t].entries[slot] != NULL)
+            {
+                set->bindings[set->binding_count].table = t;
+                set->bindings[set->binding_count].slot  = slot;
+                set->binding_count++;
+            }
+        }
     }
+    return 0;
+}
+
+void image_tables_adopt(const image_table_set_t *set)
+{
+    image_table_t staged[TABLE_COUNT];
+    describe_set(set, staged);
 
-    // Clear int memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    // image_table_set_collect() reserved the glue map, so nothing is allocated here
+    glue_map_release();
+    for (size_t i = 0; i < set->binding_count; i++)
     {
-        int_memory[i] = NULL;
+        const glue_entry_t *binding = &set->bindings[i];
+        tables[binding->table].entries[binding->slot] = staged[binding->table].entries[binding->slot];
+        glue_map[glue_count++] = *binding;
     }
+}
 
-    // Clear dint memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+int image_table_set_fill(image_table_set_t *set)
+{
+    image_table_t staged[TABLE_COUNT];
+    describe_set(set, staged);
+
+    size_t bytes = 0;
+    for (size_t t = 0; t < TABLE_COUNT; t++)
     {
-        dint_memory[i] = NULL;
+        bytes += staged[t].count * staged[t].width;
     }
-
-    // Clear lint memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    free(set->temp);
+    set->temp = calloc(1, bytes);
+    if (set->temp == NULL)
     {
-        lint_memory[i] = NULL;
+        return -1;
     }
 
-    // Clear bool memory pointers
-    for (int i = 0; i < BUFFER_SIZE; i++)
+    unsigned char *next = set->temp;
+    for (size_t t = 0; t < TABLE_COUNT; t++)
     {
-        for (int b = 0; b < 8; b++)
+        for (size_t slot = 0; slot < staged[t].count; slot++)
         {
-            bool_memory[i][b] = NULL;
+            if (staged[t].entries[slot] == NULL)
+            {
+                staged[t].entries[slot] = next + slot * staged[t].width;
+            }
         }
+        next += staged[t].count * staged[t].width;
     }
+    return 0;
+}
 
-    log_info("Cleared all pointers in image tables");
+void **image_table_set_entries(const image_table_set_t *set, uint32_t table, size_t *count)
+{
+    if (table >= TABLE_COUNT)
+    {
+        return NULL;
+    }
+    image_table_t described[TABLE_COUNT];
+    describe_set(set, described);
+    *count = described[table].count;
+    return described[table].entries;
 }
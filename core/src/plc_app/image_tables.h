@@ -4,35 +4,69 @@
 #include "../lib/iec_types.h"
 #include "plcapp_manager.h"
 
+// Default number of indexes per image table, and the smallest size the
+// runtime accepts: generated programs may address any index below it
 #define BUFFER_SIZE 1024
+
+// Largest number of indexes per image table (%IW0..%IW262143, 2M bits)
+#define IMAGE_TABLE_MAX_SIZE 262144
+
 #define libplc_build_dir "./build"
 
-// Internal buffers for I/O and memory.
+// Internal buffers for I/O and memory, image_tables_size() entries each
+// (times 8 bits for the BOOL tables), allocated by image_tables_init().
 // Booleans
-extern IEC_BOOL *bool_input[BUFFER_SIZE][8];
-extern IEC_BOOL *bool_output[BUFFER_SIZE][8];
+extern IEC_BOOL *(*bool_input)[8];
+extern IEC_BOOL *(*bool_output)[8];
 
 // Bytes
-extern IEC_BYTE *byte_input[BUFFER_SIZE];
-extern IEC_BYTE *byte_output[BUFFER_SIZE];
+extern IEC_BYTE **byte_input;
+extern IEC_BYTE **byte_output;
 
 // Analog I/O
-extern IEC_UINT *int_input[BUFFER_SIZE];
-extern IEC_UINT *int_output[BUFFER_SIZE];
+extern IEC_UINT **int_input;
+extern IEC_UINT **int_output;
 
 // 32bit I/O
-extern IEC_UDINT *dint_input[BUFFER_SIZE];
-extern IEC_UDINT *dint_output[BUFFER_SIZE];
+extern IEC_UDINT **dint_input;
+extern IEC_UDINT **dint_output;
 
 // 64bit I/O
-extern IEC_ULINT *lint_input[BUFFER_SIZE];
-extern IEC_ULINT *lint_output[BUFFER_SIZE];
+extern IEC_ULINT **lint_input;
+extern IEC_ULINT **lint_output;
 
 // Memory
-extern IEC_UINT *int_memory[BUFFER_SIZE];
-extern IEC_UDINT *dint_memory[BUFFER_SIZE];
-extern IEC_ULINT *lint_memory[BUFFER_SIZE];
-extern IEC_BOOL *bool_memory[BUFFER_SIZE][8];
+extern IEC_UINT **int_memory;
+extern IEC_UDINT **dint_memory;
+extern IEC_ULINT **lint_memory;
+extern IEC_BOOL *(*bool_memory)[8];
+
+/**
+ * @brief Set the number of indexes per image table
+ *
+ * Must be called before image_tables_init(). The size cannot change once the
+ * tables exist, since plugins keep pointers to them.
+ *
+ * @param[in]  size  Indexes per table, BUFFER_SIZE to IMAGE_TABLE_MAX_SIZE
+ * @return 0 on success, -1 if the size is out of range or the tables exist
+ */
+int image_tables_set_size(size_t size);
+
+/**
+ * @brief Number of indexes per image table
+ */
+size_t image_tables_size(void);
+
+/**
+ * @brief Allocate the image tables
+ *
+ * Called once at startup, before any program or plugin is loaded. Tables are
+ * calloc()ed, so a large address space only costs memory in the pages that
+ * are used.
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+int image_tables_init(void);
 
 /**
  * @brief Set the buffer pointers for the plugin manager
@@ -90,6 +124,119 @@ extern size_t (*ext_get_var_size)(size_t idx);
 extern void *(*ext_get_var_addr)(size_t idx);
 extern void (*ext_set_trace)(size_t idx, bool forced, void *val);
 
+/**
+ * @brief A complete set of image tables
+ *
+ * Used to glue a program that is not running yet to tables of its own, off
+ * the scan thread, before it replaces the running program.
+ */
+typedef struct image_table_set image_table_set_t;
+
+/**
+ * @brief Allocate an empty set of image tables, sized like the live ones
+ *
+ * @return The set, or NULL on allocation failure
+ */
+image_table_set_t *image_table_set_create(void);
+
+/**
+ * @brief Free a set of image tables
+ */
+void image_table_set_destroy(image_table_set_t *set);
+
+/**
+ * @brief Record the entries a program bound in a set
+ *
+ * Called after the program's glueVars() has filled the set, so that
+ * image_tables_adopt() does not have to search the set or allocate.
+ *
+ * @param[in]  set  The filled set
+ * @return 0 on success, -1 on allocation failure
+ */
+int image_table_set_collect(image_table_set_t *set);
+
+/**
+ * @brief Point the entries a program left NULL at temporary backing of the set
+ *
+ * For a set that stays a program's own tables (a program instance, see
+ * plc_instances.h) instead of being adopted by the live ones. Called once,
+ * after the program's glueVars() has filled the set.
+ *
+ * @param[in]  set  The filled set
+ * @return 0 on success, -1 on allocation failure
+ */
+int image_table_set_fill(image_table_set_t *set);
+
+/**
+ * @brief Entries of one table of a set
+ *
+ * @param[in]  set    The set
+ * @param[in]  table  Table in journal_buffer_type_t order
+ * @param[out] count  Receives the entries, index * 8 + bit for the BOOL tables
+ * @return The entries, NULL if table is out of range
+ */
+void **image_table_set_entries(const image_table_set_t *set, uint32_t table, size_t *count);
+
+/**
+ * @brief Entry points of one PLC program library, as installed in the ext_* pointers
+ */
+typedef struct
+{
+    void (*config_run__)(unsigned long tick);
+    void (*config_init__)(void);
+    void (*glueVars)(void);
+    void (*updateTime)(void);
+    void (*setBufferPointers)(
+        IEC_BOOL *input_bool[BUFFER_SIZE][8], IEC_BOOL *output_bool[BUFFER_SIZE][8],
+        IEC_BYTE *input_byte[BUFFER_SIZE], IEC_BYTE *output_byte[BUFFER_SIZE],
+        IEC_UINT *input_int[BUFFER_SIZE], IEC_UINT *output_int[BUFFER_SIZE],
+        IEC_UDINT *input_dint[BUFFER_SIZE], IEC_UDINT *output_dint[BUFFER_SIZE],
+        IEC_ULINT *input_lint[BUFFER_SIZE], IEC_ULINT *output_lint[BUFFER_SIZE],
+        IEC_UINT *int_memory[BUFFER_SIZE], IEC_UDINT *dint_memory[BUFFER_SIZE],
+        IEC_ULINT *lint_memory[BUFFER_SIZE]);
+    void (*setBufferPointers_v4)(
+        IEC_BOOL *input_bool[BUFFER_SIZE][8], IEC_BOOL *output_bool[BUFFER_SIZE][8],
+        IEC_BYTE *input_byte[BUFFER_SIZE], IEC_BYTE *output_byte[BUFFER_SIZE],
+        IEC_UINT *input_int[BUFFER_SIZE], IEC_UINT *output_int[BUFFER_SIZE],
+        IEC_UDINT *input_dint[BUFFER_SIZE], IEC_UDINT *output_dint[BUFFER_SIZE],
+        IEC_ULINT *input_lint[BUFFER_SIZE], IEC_ULINT *output_lint[BUFFER_SIZE],
+        IEC_UINT *int_memory[BUFFER_SIZE], IEC_UDINT *dint_memory[BUFFER_SIZE],
+        IEC_ULINT *lint_memory[BUFFER_SIZE], IEC_BOOL *memory_bool[BUFFER_SIZE][8]);
+    unsigned long long *common_ticktime__;
+    char *plc_program_md5;
+    void (*set_endianness)(uint8_t value);
+    uint16_t (*get_var_count)(void);
+    size_t (*get_var_size)(size_t idx);
+    void *(*get_var_addr)(size_t idx);
+    void (*set_trace)(size_t idx, bool forced, void *val);
+} plc_symbols_t;
+
+/**
+ * @brief Look up the entry points of a loaded program without installing them
+ *
+ * Also hands the runtime's loggers to the program's Python loader, if it has one.
+ *
+ * @param[in]  pm       The plugin manager of the program
+ * @param[out] symbols  Receives the entry points
+ * @return 0 on success, -1 if a required symbol is missing
+ */
+int symbols_resolve(PluginManager *pm, plc_symbols_t *symbols);
+
+/**
+ * @brief Make resolved entry points the ones the runtime calls (the ext_* pointers)
+ *
+ * @param[in]  symbols  Entry points from symbols_resolve()
+ */
+void symbols_install(const plc_symbols_t *symbols);
+
+/**
+ * @brief Point a program at the image tables glueVars() fills
+ *
+ * @param[in]  symbols  Entry points of the program
+ * @param[in]  set      Tables to use, or NULL for the runtime's image tables
+ */
+void symbols_set_buffers(const plc_symbols_t *symbols, image_table_set_t *set);
+
 /**
  * @brief Initialize symbols for the plugin manager
  *
@@ -101,9 +248,12 @@ int symbols_init(PluginManager *pm);
 /**
  * @brief Fill NULL pointers in image tables with temporary backing buffers
  *
- * This function iterates through all image table arrays and points any NULL
- * entries to temporary backing storage. This ensures that plugins accessing
- * addresses not used by the PLC program won't fail due to NULL pointer access.
+ * This function points any NULL entries to temporary backing storage. This
+ * ensures that plugins accessing addresses not used by the PLC program won't
+ * fail due to NULL pointer access. It also records which entries glueVars()
+ * bound in a glue map, so image_tables_clear_null_pointers() only has to
+ * touch those. Once filled, unbound entries keep pointing at their temporary
+ * backing across program loads, together with the values plugins wrote there.
  *
  * Must be called after ext_glueVars() has mapped the user program's located
  * variables to the image tables.
@@ -113,10 +263,12 @@ int symbols_init(PluginManager *pm);
 void image_tables_fill_null_pointers(void);
 
 /**
- * @brief Clear all pointers from image tables
+ * @brief Release the image table entries bound by the PLC program
  *
- * This function resets all pointers in the image tables back to NULL.
- * All pointers will be remapped when a new program is loaded via glueVars().
+ * This function points the entries in the glue map back at their temporary
+ * backing, cleared, so no entry refers to the program's variables. Entries
+ * the program did not bind are not touched. Before the first fill the tables
+ * hold no pointers and nothing is done.
  *
  * Must be called before unloading a PLC program to ensure clean state for
  * the next program load.
@@ -125,4 +277,32 @@ void image_tables_fill_null_pointers(void);
  */
 void image_tables_clear_null_pointers(void);
 
+/**
+ * @brief Entries of one image table the PLC program bound
+ *
+ * Slots number the entries of the table, index * 8 + bit in the BOOL tables
+ * and the index in the others, and are listed in increasing order.
+ *
+ * @note This function should be called with buffer_mutex held for thread safety.
+ *
+ * @param[in]  table  Table in journal_buffer_type_t order
+ * @param[out] slots  Receives up to max slots, may be NULL to count them
+ * @param[in]  max    Room in slots
+ * @return Number of entries the program bound in the table
+ */
+size_t image_tables_bound_slots(uint32_t table, uint32_t *slots, size_t max);
+
+/**
+ * @brief Install a staged set of pointers in the image tables
+ *
+ * The set must have been collected with image_table_set_collect().
+ * Entries the staged program glued take its pointers. The others point at
+ * their temporary buffers, which keep the values plugins wrote to addresses
+ * neither program uses; entries that belonged to the previous program get a
+ * cleared temporary buffer.
+ *
+ * @note This function should be called with buffer_mutex held for thread safety.
+ */
+void image_tables_adopt(const image_table_set_t *set);
+
 #endif // IMAGE_TABLES_H
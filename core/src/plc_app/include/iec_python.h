@@ -27,6 +27,7 @@
 #define IEC_PYTHON_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #ifdef __cplusplus
@@ -50,8 +51,12 @@ extern "C"
      * @brief Load and start a Python function block
      *
      * Writes the Python script to disk, creates shared memory regions for
-     * input/output data exchange, and spawns a Python process to execute
-     * the function block.
+     * input/output data exchange, and hands the script to the Python host
+     * process shared by all function blocks of the program, which runs it in
+     * a thread of its own. The host is started by the first call and ends
+     * when the program is unloaded. With OPENPLC_PYTHON_FB_POOL=0 in the
+     * environment, or if the host cannot be used, the block gets a python3
+     * process of its own instead.
      *
      * @param script_name Path where the Python script will be written
      * @param script_content The Python script content (with format specifiers for pid and shm_name)
@@ -67,6 +72,85 @@ extern "C"
                             size_t shm_in_size, size_t shm_out_size, void **shm_in_ptr,
                             void **shm_out_ptr, pid_t pid);
 
+    /**
+     * @brief Exchange protocol header for a Python function block
+     *
+     * Lives in a third shared memory region, "<shm_name>_sync", next to the
+     * _in and _out regions, whose layout it does not change. All fields are
+     * 32-bit words in host byte order, accessed atomically:
+     *
+     * - in_seq / out_seq: seqlocks over the _in and _out regions, odd while
+     *   the PLC (in) or the Python process (out) is writing the region.
+     * - request: number of the latest inputs, incremented by the PLC once per
+     *   scan. The Python process waits on it with FUTEX_WAIT (Linux), so it
+     *   wakes exactly once per PLC cycle.
+     * - response: request the data in _out answers, written by the Python
+     *   process after releasing out_seq.
+     * - late: scans whose outputs were not ready when the PLC took them.
+     *
+     * Each scan the function block calls python_block_outputs_read() for the
+     * previous request and then publishes the new inputs between
+     * python_block_inputs_begin() and python_block_inputs_publish(). None of
+     * these calls block or spin on the Python process.
+     */
+    typedef struct
+    {
+        uint32_t magic;   // PYTHON_BLOCK_SYNC_MAGIC
+        uint32_t version; // PYTHON_BLOCK_SYNC_VERSION
+        uint32_t in_seq;
+        uint32_t request;
+        uint32_t out_seq;
+        uint32_t response;
+        uint32_t late;
+        uint32_t reserved;
+    } python_block_sync_t;
+
+#define PYTHON_BLOCK_SYNC_MAGIC 0x53424650u // "PFBS"
+#define PYTHON_BLOCK_SYNC_VERSION 1u
+
+    /**
+     * @brief Create and map the exchange header of a Python function block
+     *
+     * Call after python_block_loader() with the same shm_name.
+     *
+     * @param shm_name Base name for shared memory regions
+     * @param sync Pointer to store the mapped header
+     * @return 0 on success, -1 on failure
+     */
+    int python_block_sync_open(const char *shm_name, python_block_sync_t **sync);
+
+    /**
+     * @brief Mark the _in region as being written
+     *
+     * @param sync Exchange header
+     */
+    void python_block_inputs_begin(python_block_sync_t *sync);
+
+    /**
+     * @brief Publish the inputs written since python_block_inputs_begin()
+     *
+     * Ends the write, increments request and wakes the Python process.
+     *
+     * @param sync Exchange header
+     * @return The new request number
+     */
+    uint32_t python_block_inputs_publish(python_block_sync_t *sync);
+
+    /**
+     * @brief Copy the outputs if the Python process answered the last request
+     *
+     * Never waits: outputs that are missing or still being written count as
+     * late and dest is not updated, so the block keeps its previous outputs.
+     *
+     * @param sync Exchange header
+     * @param shm_out Mapped _out region
+     * @param dest Destination for size bytes of outputs
+     * @param size Number of bytes to copy
+     * @return 1 if fresh outputs were copied, 0 if the response is late
+     */
+    int python_block_outputs_read(python_block_sync_t *sync, const void *shm_out, void *dest,
+                                  size_t size);
+
     /**
      * @brief Set logging function pointers for the Python loader
      *
@@ -3,16 +3,83 @@
  * @brief Journal Buffer Implementation for Race-Condition-Free Plugin Writes
  *
  * This implementation provides:
- * - Static journal buffer with configurable max entries
- * - Thread-safe write operations with mutex protection
- * - Atomic application of journal entries at cycle start
- * - Emergency flush when buffer is full
- * - Last-writer-wins conflict resolution via sequence numbers
+ * - One single-producer/single-consumer ring per writer thread
+ * - Wait-free write operations (no shared lock on the writer path)
+ * - Lock-free application of journal entries at cycle start
+ * - Range entries whose packed payload lives in a per-producer arena
+ * - Emergency flush when a producer ring is full
+ * - Optional coalescing mode backed by per-type dirty bitmaps and value slots
+ * - Last-writer-wins conflict resolution via a global sequence number
+ *
+ * Each thread claims a ring on its first write. The scan thread is the only
+ * consumer; it merges all rings by sequence number while holding the image
+ * table mutex. The emergency flush path also holds the image table mutex,
+ * which is what serializes the consumer side.
  */
 
 #include "journal_buffer.h"
+#include "utils/huge_pages.h"
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/*
+ * =============================================================================
+ * Types
+ * =============================================================================
+ */
+
+#define JOURNAL_RING_MASK (JOURNAL_MAX_ENTRIES - 1)
+#define JOURNAL_PAYLOAD_MASK (JOURNAL_PAYLOAD_BYTES - 1)
+#define JOURNAL_CACHE_LINE 64
+
+/* Largest payload a single range entry may reserve */
+#define JOURNAL_RANGE_MAX_BYTES (JOURNAL_PAYLOAD_BYTES / 2)
+
+_Static_assert((JOURNAL_MAX_ENTRIES & JOURNAL_RING_MASK) == 0,
+               "JOURNAL_MAX_ENTRIES must be a power of two");
+_Static_assert((JOURNAL_PAYLOAD_BYTES & JOURNAL_PAYLOAD_MASK) == 0,
+               "JOURNAL_PAYLOAD_BYTES must be a power of two");
+
+/* Producer ring states */
+enum {
+    RING_FREE = 0,   /* Not owned by any thread */
+    RING_ACTIVE,     /* Owned by a live thread */
+    RING_RETIRED     /* Owner exited, released once drained */
+};
+
+/**
+ * @brief Single-producer/single-consumer ring owned by one writer thread
+ *
+ * head is only written by the owning thread, tail only by the consumer.
+ * They live on separate cache lines to avoid false sharing. The payload
+ * arena follows the same split: payload_head belongs to the producer and
+ * payload_tail is advanced by the consumer as range entries are applied.
+ */
+typedef struct {
+    _Alignas(JOURNAL_CACHE_LINE) atomic_size_t head;
+    uint32_t payload_head;
+    _Alignas(JOURNAL_CACHE_LINE) atomic_size_t tail;
+    atomic_uint payload_tail;
+    _Alignas(JOURNAL_CACHE_LINE) atomic_int state;
+    journal_entry_t entries[JOURNAL_MAX_ENTRIES];
+    _Alignas(8) uint8_t payload[JOURNAL_PAYLOAD_BYTES];
+} journal_ring_t;
+
+/**
+ * @brief Coalescing table for one buffer type
+ *
+ * One value slot and one dirty bit per address. Bool types have 8 slots
+ * per index (slot = index * 8 + bit).
+ */
+typedef struct {
+    size_t slots;
+    _Atomic uint64_t *dirty;
+    _Atomic uint64_t *values;
+} journal_coalesce_table_t;
 
 /*
  * =============================================================================
@@ -20,23 +87,100 @@
  * =============================================================================
  */
 
-/* Journal entries buffer */
-static journal_entry_t g_entries[JOURNAL_MAX_ENTRIES];
+/* Producer rings, allocated by the first journal_init() (on huge pages if
+ * enabled) and kept for the process lifetime */
+static journal_ring_t *g_rings = NULL;
+
+/* Set once g_rings is allocated, for the diagnostics that may run before */
+static atomic_bool g_rings_allocated = false;
+
+/* Bit r set when ring r may have entries to apply or was retired. Set by
+ * producers after publishing, cleared by the consumer before draining, so
+ * the scan thread only visits rings with work. */
+static atomic_uint g_pending_rings = 0;
 
-/* Current number of entries in journal */
-static size_t g_count = 0;
+_Static_assert(JOURNAL_MAX_PRODUCERS <= 32, "g_pending_rings holds one bit per ring");
 
-/* Next sequence number to assign (auto-increment) */
-static uint32_t g_next_sequence = 0;
+/* Next sequence number to assign (shared by all producers) */
+static atomic_uint g_next_sequence = 0;
 
-/* Journal mutex - protects g_entries, g_count, g_next_sequence */
-static pthread_mutex_t g_journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* Ring owned by the calling thread, NULL until its first write */
+static _Thread_local journal_ring_t *t_ring = NULL;
+
+/* Releases a thread's ring when the thread exits */
+static pthread_key_t g_ring_key;
+static pthread_once_t g_ring_key_once = PTHREAD_ONCE_INIT;
 
 /* Buffer pointers for applying entries */
 static journal_buffer_ptrs_t g_buffer_ptrs;
 
 /* Initialization flag */
-static bool g_initialized = false;
+static atomic_bool g_initialized = false;
+
+/* Coalescing mode requested for the next journal_init() */
+static bool g_coalesce_requested = false;
+
+/* Coalescing mode in effect */
+static atomic_bool g_coalescing = false;
+
+/* Coalescing tables, allocated on first use and kept for the process
+ * lifetime since plugin threads may keep writing across program reloads */
+static journal_coalesce_table_t g_coalesce[JOURNAL_TYPE_COUNT];
+
+/* Bit t set when table t may have dirty slots */
+static atomic_uint g_coalesce_dirty_types = 0;
+
+/**
+ * @brief One address watched for value changes
+ *
+ * last is the value of the latest write seen by watch_notify(), so only
+ * writes that change the value call the handler.
+ */
+typedef struct {
+    uint8_t type;
+    uint8_t bit;
+    uint32_t index;
+    atomic_bool seen;
+    _Atomic uint64_t last;
+} journal_watch_t;
+
+static journal_watch_t g_watches[JOURNAL_MAX_WATCHES];
+static atomic_size_t g_watch_count = 0;
+
+/* Bit t set when some watch is on buffer type t */
+static atomic_uint g_watched_types = 0;
+
+static journal_watch_fn g_watch_handler = NULL;
+static void *g_watch_ctx = NULL;
+
+/* Write maps of journal_track_writes(), per buffer type. Set from any thread,
+ * the maps themselves are only written by the image table mutex holder. */
+static journal_write_map_t *_Atomic g_write_maps[JOURNAL_TYPE_COUNT];
+
+/* Emergency flushes since startup, kept across journal_init() like a counter */
+static _Atomic uint64_t g_emergency_flushes = 0;
+
+/**
+ * @brief Counters behind journal_get_stats(), also kept across journal_init()
+ *
+ * The apply and dropped counters are only written by the image table mutex
+ * holder; the rejected counters by any writer thread.
+ */
+typedef struct {
+    _Atomic uint64_t applies;
+    _Atomic uint64_t entries_applied;
+    _Atomic uint64_t last_applied;
+    _Atomic uint64_t max_applied;
+    _Atomic uint64_t apply_ns_last;
+    _Atomic uint64_t apply_ns_max;
+    _Atomic uint64_t apply_ns_total;
+    _Atomic uint64_t rejected[JOURNAL_TYPE_COUNT];
+    _Atomic uint64_t rejected_invalid_type;
+    _Atomic uint64_t rejected_no_producer;
+    _Atomic uint64_t dropped[JOURNAL_TYPE_COUNT];
+} journal_counters_t;
+
+static journal_counters_t g_counters;
 
 /*
  * =============================================================================
@@ -44,7 +188,51 @@ static bool g_initialized = false;
  * =============================================================================
  */
 static void apply_entry(const journal_entry_t *entry);
-static void emergency_flush_locked(void);
+static void apply_range(const journal_entry_t *entry, const uint8_t *src);
+static size_t drain_rings(void);
+static void discard_rings(void);
+static int coalesce_init(size_t buffer_size);
+static int coalesce_store(uint8_t type, uint32_t index, uint8_t bit, uint64_t value);
+static size_t coalesce_apply(void);
+static size_t coalesce_pending_count(void);
+static void watch_notify(uint8_t type, uint32_t index, uint8_t bit, uint64_t value);
+static void watch_notify_range(uint8_t type, uint32_t start_index, uint32_t count,
+                               const uint8_t *src);
+static inline void mark_written(uint8_t type, size_t index, size_t count);
+
+/*
+ * =============================================================================
+ * Counters
+ * =============================================================================
+ */
+
+/* Add to a counter with a single writer, cheaper than a locked fetch_add */
+static inline void counter_add(_Atomic uint64_t *counter, uint64_t n)
+{
+    uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, value + n, memory_order_relaxed);
+}
+
+/**
+ * @brief Count a rejected write of the given type
+ *
+ * @return -1, for the caller to return
+ */
+static int reject_write(int type)
+{
+    _Atomic uint64_t *counter = (type >= 0 && type < JOURNAL_TYPE_COUNT)
+                                    ? &g_counters.rejected[type]
+                                    : &g_counters.rejected_invalid_type;
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+    return -1;
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
 
 /*
  * =============================================================================
@@ -52,6 +240,24 @@ static void emergency_flush_locked(void);
  * =============================================================================
  */
 
+/**
+ * @brief Discard the entries published so far, as the consumer
+ *
+ * Takes the image mutex like any apply, so it never runs beside the scan
+ * thread or an emergency flush. Producers may keep writing; the sequence
+ * counter keeps counting so their later entries still order after each
+ * other.
+ */
+static void reset_rings(pthread_mutex_t *image_mutex)
+{
+    if (g_rings == NULL || image_mutex == NULL) {
+        return;
+    }
+    pthread_mutex_lock(image_mutex);
+    discard_rings();
+    pthread_mutex_unlock(image_mutex);
+}
+
 int journal_init(const journal_buffer_ptrs_t *buffer_ptrs)
 {
     if (buffer_ptrs == NULL) {
@@ -64,230 +270,712 @@ int journal_init(const journal_buffer_ptrs_t *buffer_ptrs)
         return -1;
     }
 
-    pthread_mutex_lock(&g_journal_mutex);
+    if (g_rings == NULL) {
+        g_rings = huge_pages_alloc(JOURNAL_MAX_PRODUCERS * sizeof(journal_ring_t), NULL);
+        if (g_rings == NULL) {
+            fprintf(stderr, "[JOURNAL] Error: failed to allocate the producer rings\n");
+            return -1;
+        }
+        atomic_store_explicit(&g_rings_allocated, true, memory_order_release);
+    }
 
     /* Copy buffer pointers */
     memcpy(&g_buffer_ptrs, buffer_ptrs, sizeof(journal_buffer_ptrs_t));
 
     /* Reset journal state */
-    g_count = 0;
-    g_next_sequence = 0;
-    memset(g_entries, 0, sizeof(g_entries));
+    reset_rings(buffer_ptrs->image_mutex);
 
-    g_initialized = true;
+    bool coalescing = g_coalesce_requested;
+    if (coalescing && coalesce_init((size_t)buffer_ptrs->buffer_size) != 0) {
+        fprintf(stderr, "[JOURNAL] Error: coalescing tables unavailable, using ordered mode\n");
+        coalescing = false;
+    }
+    atomic_store_explicit(&g_coalescing, coalescing, memory_order_release);
 
-    pthread_mutex_unlock(&g_journal_mutex);
+    atomic_store_explicit(&g_initialized, true, memory_order_release);
 
     return 0;
 }
 
 void journal_cleanup(void)
 {
-    pthread_mutex_lock(&g_journal_mutex);
+    atomic_store_explicit(&g_initialized, false, memory_order_release);
+    reset_rings(g_buffer_ptrs.image_mutex);
+}
 
-    g_initialized = false;
-    g_count = 0;
-    g_next_sequence = 0;
-    memset(&g_buffer_ptrs, 0, sizeof(g_buffer_ptrs));
+bool journal_is_initialized(void)
+{
+    return atomic_load_explicit(&g_initialized, memory_order_acquire);
+}
 
-    pthread_mutex_unlock(&g_journal_mutex);
+void journal_set_coalescing(bool enable)
+{
+    g_coalesce_requested = enable;
 }
 
-bool journal_is_initialized(void)
+bool journal_is_coalescing(void)
 {
-    bool result;
-    pthread_mutex_lock(&g_journal_mutex);
-    result = g_initialized;
-    pthread_mutex_unlock(&g_journal_mutex);
-    return result;
+    return atomic_load_explicit(&g_coalescing, memory_order_acquire);
 }
 
 /*
  * =============================================================================
- * Write Functions
+ * Producer Rings
  * =============================================================================
  */
 
 /**
- * @brief Internal function to add an entry to the journal
+ * @brief Thread exit hook: hand the ring back to the consumer for release
+ */
+static void release_ring(void *ptr)
+{
+    journal_ring_t *ring = (journal_ring_t *)ptr;
+    if (ring != NULL) {
+        atomic_store_explicit(&ring->state, RING_RETIRED, memory_order_release);
+        atomic_fetch_or_explicit(&g_pending_rings, 1u << (ring - g_rings), memory_order_release);
+    }
+}
+
+static void create_ring_key(void)
+{
+    pthread_key_create(&g_ring_key, release_ring);
+}
+
+/**
+ * @brief Claim a free ring for the calling thread
  *
- * Must be called with g_journal_mutex held.
- * Handles emergency flush if buffer is full.
+ * Only runs on a thread's first write, so the linear scan is not on the
+ * hot path. A freed ring is always empty (head == tail) when reclaimed.
  *
- * @return Pointer to the new entry, or NULL on failure
+ * @return Pointer to the claimed ring, or NULL if all rings are in use
  */
-static journal_entry_t *add_entry_locked(void)
+static journal_ring_t *claim_ring(void)
 {
-    /* Check if buffer is full */
-    if (g_count >= JOURNAL_MAX_ENTRIES) {
+    pthread_once(&g_ring_key_once, create_ring_key);
+
+    for (size_t i = 0; i < JOURNAL_MAX_PRODUCERS; i++) {
+        int expected = RING_FREE;
+        if (atomic_compare_exchange_strong(&g_rings[i].state, &expected, RING_ACTIVE)) {
+            pthread_setspecific(g_ring_key, &g_rings[i]);
+            return &g_rings[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get the calling thread's ring, claiming one on first use
+ */
+static journal_ring_t *get_ring(void)
+{
+    if (t_ring == NULL) {
+        t_ring = claim_ring();
+    }
+    return t_ring;
+}
+
+/**
+ * @brief Reserve the next entry slot and payload_len bytes of payload
+ *
+ * Handles emergency flush if the ring or its payload arena is full. A
+ * payload that would straddle the end of the arena starts at offset 0
+ * instead, so range data is always contiguous.
+ *
+ * @param ring Calling thread's ring
+ * @param payload_len Payload bytes needed (0 for single-element writes)
+ * @param payload_off Receives the payload offset (may be NULL if len is 0)
+ * @return Pointer to the entry slot, published by publish_entry()
+ */
+static journal_entry_t *reserve_entry(journal_ring_t *ring, uint32_t payload_len,
+                                      uint32_t *payload_off)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    uint32_t start = ring->payload_head;
+    if (payload_len > 0) {
+        uint32_t pos = start & JOURNAL_PAYLOAD_MASK;
+        if (pos + payload_len > JOURNAL_PAYLOAD_BYTES) {
+            start += JOURNAL_PAYLOAD_BYTES - pos;
+        }
+    }
+
+    uint32_t payload_tail = atomic_load_explicit(&ring->payload_tail, memory_order_acquire);
+    bool payload_full = (start + payload_len - payload_tail) > JOURNAL_PAYLOAD_BYTES;
+
+    /* Check if ring is full */
+    if (head - tail >= JOURNAL_MAX_ENTRIES || payload_full) {
         /* Emergency flush: apply all entries and clear */
-        emergency_flush_locked();
+        atomic_fetch_add_explicit(&g_emergency_flushes, 1, memory_order_relaxed);
+        pthread_mutex_lock(g_buffer_ptrs.image_mutex);
+        counter_add(&g_counters.entries_applied, drain_rings());
+        pthread_mutex_unlock(g_buffer_ptrs.image_mutex);
+
+        /* Ring is now empty, so the arena can restart at its base */
+        start = ring->payload_head;
+        if (payload_len > 0 && (start & JOURNAL_PAYLOAD_MASK) + payload_len > JOURNAL_PAYLOAD_BYTES) {
+            start += JOURNAL_PAYLOAD_BYTES - (start & JOURNAL_PAYLOAD_MASK);
+        }
     }
 
-    /* Add new entry */
-    journal_entry_t *entry = &g_entries[g_count];
-    entry->sequence = g_next_sequence++;
-    g_count++;
+    if (payload_len > 0) {
+        ring->payload_head = start + payload_len;
+        *payload_off = start;
+    }
 
+    journal_entry_t *entry = &ring->entries[head & JOURNAL_RING_MASK];
+    entry->sequence = atomic_fetch_add_explicit(&g_next_sequence, 1, memory_order_relaxed);
     return entry;
 }
 
-int journal_write_bool(journal_buffer_type_t type, uint16_t index,
+/**
+ * @brief Make the most recently reserved entry visible to the consumer
+ */
+static void publish_entry(journal_ring_t *ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    /* After the head store: a consumer that clears the bit first sees the
+     * entry, one that clears it later sees the bit */
+    atomic_fetch_or_explicit(&g_pending_rings, 1u << (ring - g_rings), memory_order_release);
+}
+
+/**
+ * @brief Internal function to push a single-element entry
+ *
+ * @return 0 on success, -1 on failure
+ */
+static int push_entry(uint8_t type, uint32_t index, uint8_t bit, uint64_t value)
+{
+    if (atomic_load_explicit(&g_coalescing, memory_order_relaxed)) {
+        if (coalesce_store(type, index, bit, value) != 0) {
+            return reject_write(type);
+        }
+        watch_notify(type, index, bit, value);
+        return 0;
+    }
+
+    journal_ring_t *ring = get_ring();
+    if (ring == NULL) {
+        atomic_fetch_add_explicit(&g_counters.rejected_no_producer, 1, memory_order_relaxed);
+        return reject_write(type);
+    }
+
+    journal_entry_t *entry = reserve_entry(ring, 0, NULL);
+    entry->buffer_type = type;
+    entry->index = index;
+    entry->bit_index = bit;
+    entry->count = 1;
+    entry->payload = 0;
+    entry->value = value;
+
+    publish_entry(ring);
+    watch_notify(type, index, bit, value);
+    return 0;
+}
+
+/*
+ * =============================================================================
+ * Write Functions
+ * =============================================================================
+ */
+
+int journal_write_bool(journal_buffer_type_t type, uint32_t index,
                        uint8_t bit, bool value)
 {
-    if (!g_initialized) {
-        return -1;
+    if (!journal_is_initialized()) {
+        return reject_write(type);
     }
 
     /* Validate type */
     if (type != JOURNAL_BOOL_INPUT &&
         type != JOURNAL_BOOL_OUTPUT &&
         type != JOURNAL_BOOL_MEMORY) {
-        return -1;
+        return reject_write(type);
     }
 
     /* Validate bit index */
     if (bit > 7) {
-        return -1;
+        return reject_write(type);
     }
 
-    pthread_mutex_lock(&g_journal_mutex);
+    return push_entry((uint8_t)type, index, bit, value ? 1 : 0);
+}
 
-    journal_entry_t *entry = add_entry_locked();
-    if (entry == NULL) {
-        pthread_mutex_unlock(&g_journal_mutex);
-        return -1;
+int journal_write_byte(journal_buffer_type_t type, uint32_t index,
+                       uint8_t value)
+{
+    if (!journal_is_initialized()) {
+        return reject_write(type);
     }
 
-    entry->buffer_type = (uint8_t)type;
-    entry->index = index;
-    entry->bit_index = bit;
-    entry->value = value ? 1 : 0;
+    /* Validate type */
+    if (type != JOURNAL_BYTE_INPUT && type != JOURNAL_BYTE_OUTPUT) {
+        return reject_write(type);
+    }
 
-    pthread_mutex_unlock(&g_journal_mutex);
-    return 0;
+    /* bit_index 0xFF: not applicable for non-bool types */
+    return push_entry((uint8_t)type, index, 0xFF, value);
 }
 
-int journal_write_byte(journal_buffer_type_t type, uint16_t index,
-                       uint8_t value)
+int journal_write_int(journal_buffer_type_t type, uint32_t index,
+                      uint16_t value)
 {
-    if (!g_initialized) {
-        return -1;
+    if (!journal_is_initialized()) {
+        return reject_write(type);
     }
 
     /* Validate type */
-    if (type != JOURNAL_BYTE_INPUT && type != JOURNAL_BYTE_OUTPUT) {
-        return -1;
+    if (type != JOURNAL_INT_INPUT &&
+        type != JOURNAL_INT_OUTPUT &&
+        type != JOURNAL_INT_MEMORY) {
+        return reject_write(type);
     }
 
-    pthread_mutex_lock(&g_journal_mutex);
+    return push_entry((uint8_t)type, index, 0xFF, value);
+}
 
-    journal_entry_t *entry = add_entry_locked();
-    if (entry == NULL) {
-        pthread_mutex_unlock(&g_journal_mutex);
-        return -1;
+int journal_write_dint(journal_buffer_type_t type, uint32_t index,
+                       uint32_t value)
+{
+    if (!journal_is_initialized()) {
+        return reject_write(type);
     }
 
-    entry->buffer_type = (uint8_t)type;
-    entry->index = index;
-    entry->bit_index = 0xFF;  /* Not applicable for non-bool types */
-    entry->value = value;
+    /* Validate type */
+    if (type != JOURNAL_DINT_INPUT &&
+        type != JOURNAL_DINT_OUTPUT &&
+        type != JOURNAL_DINT_MEMORY) {
+        return reject_write(type);
+    }
 
-    pthread_mutex_unlock(&g_journal_mutex);
-    return 0;
+    return push_entry((uint8_t)type, index, 0xFF, value);
 }
 
-int journal_write_int(journal_buffer_type_t type, uint16_t index,
-                      uint16_t value)
+int journal_write_lint(journal_buffer_type_t type, uint32_t index,
+                       uint64_t value)
 {
-    if (!g_initialized) {
-        return -1;
+    if (!journal_is_initialized()) {
+        return reject_write(type);
     }
 
     /* Validate type */
-    if (type != JOURNAL_INT_INPUT &&
-        type != JOURNAL_INT_OUTPUT &&
-        type != JOURNAL_INT_MEMORY) {
+    if (type != JOURNAL_LINT_INPUT &&
+        type != JOURNAL_LINT_OUTPUT &&
+        type != JOURNAL_LINT_MEMORY) {
+        return reject_write(type);
+    }
+
+    return push_entry((uint8_t)type, index, 0xFF, value);
+}
+
+size_t journal_type_width(journal_buffer_type_t type)
+{
+    switch (type) {
+        case JOURNAL_BOOL_INPUT:
+        case JOURNAL_BOOL_OUTPUT:
+        case JOURNAL_BOOL_MEMORY:
+        case JOURNAL_BYTE_INPUT:
+        case JOURNAL_BYTE_OUTPUT:
+            return 1;
+        case JOURNAL_INT_INPUT:
+        case JOURNAL_INT_OUTPUT:
+        case JOURNAL_INT_MEMORY:
+            return 2;
+        case JOURNAL_DINT_INPUT:
+        case JOURNAL_DINT_OUTPUT:
+        case JOURNAL_DINT_MEMORY:
+            return 4;
+        case JOURNAL_LINT_INPUT:
+        case JOURNAL_LINT_OUTPUT:
+        case JOURNAL_LINT_MEMORY:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+int journal_parse_address(const char *text, size_t length, journal_buffer_type_t *type,
+                          uint32_t *index, uint8_t *bit)
+{
+    static const struct {
+        char area;
+        char size;
+        journal_buffer_type_t type;
+    } areas[] = {
+        {'I', 'X', JOURNAL_BOOL_INPUT}, {'Q', 'X', JOURNAL_BOOL_OUTPUT},
+        {'M', 'X', JOURNAL_BOOL_MEMORY}, {'I', 'B', JOURNAL_BYTE_INPUT},
+        {'Q', 'B', JOURNAL_BYTE_OUTPUT}, {'I', 'W', JOURNAL_INT_INPUT},
+        {'Q', 'W', JOURNAL_INT_OUTPUT}, {'M', 'W', JOURNAL_INT_MEMORY},
+        {'I', 'D', JOURNAL_DINT_INPUT}, {'Q', 'D', JOURNAL_DINT_OUTPUT},
+        {'M', 'D', JOURNAL_DINT_MEMORY}, {'I', 'L', JOURNAL_LINT_INPUT},
+        {'Q', 'L', JOURNAL_LINT_OUTPUT}, {'M', 'L', JOURNAL_LINT_MEMORY},
+    };
+
+    char buffer[16];
+    if (length < 4 || length >= sizeof(buffer) || text[0] != '%') {
         return -1;
     }
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
 
-    pthread_mutex_lock(&g_journal_mutex);
+    size_t a = 0;
+    while (a < sizeof(areas) / sizeof(areas[0]) &&
+           (areas[a].area != buffer[1] || areas[a].size != buffer[2])) {
+        a++;
+    }
+    if (a == sizeof(areas) / sizeof(areas[0]) || buffer[3] < '0' || buffer[3] > '9') {
+        return -1;
+    }
 
-    journal_entry_t *entry = add_entry_locked();
-    if (entry == NULL) {
-        pthread_mutex_unlock(&g_journal_mutex);
+    char *end;
+    unsigned long value = strtoul(&buffer[3], &end, 10);
+    if (value > UINT32_MAX) {
         return -1;
     }
+    *type = areas[a].type;
+    *index = (uint32_t)value;
+    *bit = 0;
 
-    entry->buffer_type = (uint8_t)type;
-    entry->index = index;
-    entry->bit_index = 0xFF;
-    entry->value = value;
+    if (buffer[2] == 'X') {
+        if (end[0] != '.' || end[1] < '0' || end[1] > '7' || end[2] != '\0') {
+            return -1;
+        }
+        *bit = (uint8_t)(end[1] - '0');
+        return 0;
+    }
+    return *end == '\0' ? 0 : -1;
+}
+
+int journal_write_range(journal_buffer_type_t type, uint32_t start_index,
+                        uint32_t count, const void *values)
+{
+    if (!journal_is_initialized()) {
+        return reject_write(type);
+    }
+
+    size_t width = journal_type_width(type);
+    if (width == 0 || values == NULL || count == 0) {
+        return reject_write(type);
+    }
+
+    if (atomic_load_explicit(&g_coalescing, memory_order_relaxed)) {
+        /* Every element gets its own slot; no payload arena involved */
+        const uint8_t *src = (const uint8_t *)values;
+        bool is_bool = type <= JOURNAL_BOOL_MEMORY;
+        uint32_t i = 0;
+        for (; i < count && start_index + i < (uint32_t)g_buffer_ptrs.buffer_size; i++) {
+            uint32_t index = start_index + i;
+            uint64_t v = 0;
+            memcpy(&v, src + i * width, width);
+            if (is_bool) {
+                for (uint8_t b = 0; b < 8; b++) {
+                    coalesce_store((uint8_t)type, index, b, (v >> b) & 1);
+                }
+            } else {
+                coalesce_store((uint8_t)type, index, 0xFF, v);
+            }
+        }
+        if (i < count) {
+            atomic_fetch_add_explicit(&g_counters.dropped[type], count - i, memory_order_relaxed);
+        }
+        watch_notify_range((uint8_t)type, start_index, count, src);
+        return 0;
+    }
+
+    journal_ring_t *ring = get_ring();
+    if (ring == NULL) {
+        atomic_fetch_add_explicit(&g_counters.rejected_no_producer, 1, memory_order_relaxed);
+        return reject_write(type);
+    }
 
-    pthread_mutex_unlock(&g_journal_mutex);
+    /* Split oversized ranges so each chunk fits in half the arena */
+    const uint8_t *src = (const uint8_t *)values;
+    size_t max_chunk = JOURNAL_RANGE_MAX_BYTES / width;
+    uint32_t index = start_index;
+    size_t remaining = count;
+
+    while (remaining > 0) {
+        size_t chunk = remaining < max_chunk ? remaining : max_chunk;
+        uint32_t len = (uint32_t)(chunk * width);
+        uint32_t off;
+
+        journal_entry_t *entry = reserve_entry(ring, len, &off);
+        memcpy(&ring->payload[off & JOURNAL_PAYLOAD_MASK], src, len);
+        entry->buffer_type = (uint8_t)type;
+        entry->index = index;
+        entry->bit_index = JOURNAL_BIT_RANGE;
+        entry->count = (uint16_t)chunk;
+        entry->payload = off;
+        entry->value = 0;
+        publish_entry(ring);
+
+        src += len;
+        index += (uint32_t)chunk;
+        remaining -= chunk;
+        if (index >= (uint32_t)g_buffer_ptrs.buffer_size) {
+            /* Rest of the range is beyond any addressable index */
+            if (remaining > 0) {
+                atomic_fetch_add_explicit(&g_counters.dropped[type], remaining,
+                                          memory_order_relaxed);
+            }
+            break;
+        }
+    }
+
+    watch_notify_range((uint8_t)type, start_index, count, (const uint8_t *)values);
     return 0;
 }
 
-int journal_write_dint(journal_buffer_type_t type, uint16_t index,
-                       uint32_t value)
+/*
+ * =============================================================================
+ * Coalescing Mode
+ * =============================================================================
+ */
+
+/**
+ * @brief Allocate (once) and clear the coalescing tables
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+static int coalesce_init(size_t buffer_size)
 {
-    if (!g_initialized) {
-        return -1;
+    for (int t = 0; t < JOURNAL_TYPE_COUNT; t++) {
+        journal_coalesce_table_t *table = &g_coalesce[t];
+        size_t slots = (t <= JOURNAL_BOOL_MEMORY) ? buffer_size * 8 : buffer_size;
+        size_t words = (slots + 63) / 64;
+
+        if (table->slots < slots) {
+            /* Tables are never freed (see g_coalesce), only replaced if the
+             * buffer size grows, which does not happen at runtime */
+            _Atomic uint64_t *dirty = calloc(words, sizeof(*dirty));
+            _Atomic uint64_t *values = calloc(slots, sizeof(*values));
+            if (dirty == NULL || values == NULL) {
+                free(dirty);
+                free(values);
+                return -1;
+            }
+            table->dirty = dirty;
+            table->values = values;
+            table->slots = slots;
+        } else {
+            for (size_t k = 0; k < (table->slots + 63) / 64; k++) {
+                atomic_store_explicit(&table->dirty[k], 0, memory_order_relaxed);
+            }
+        }
     }
 
-    /* Validate type */
-    if (type != JOURNAL_DINT_INPUT &&
-        type != JOURNAL_DINT_OUTPUT &&
-        type != JOURNAL_DINT_MEMORY) {
+    atomic_store_explicit(&g_coalesce_dirty_types, 0, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Overwrite the value slot for an address and mark it dirty
+ *
+ * Concurrent writers to the same address resolve by whichever store lands
+ * last, which is the coalescing equivalent of last-writer-wins.
+ *
+ * @return 0 on success, -1 if the address is outside the table
+ */
+static int coalesce_store(uint8_t type, uint32_t index, uint8_t bit, uint64_t value)
+{
+    journal_coalesce_table_t *table = &g_coalesce[type];
+    size_t slot = (type <= JOURNAL_BOOL_MEMORY) ? (size_t)index * 8 + bit : index;
+
+    if (slot >= table->slots) {
         return -1;
     }
 
-    pthread_mutex_lock(&g_journal_mutex);
+    atomic_store_explicit(&table->values[slot], value, memory_order_relaxed);
+    atomic_fetch_or_explicit(&table->dirty[slot / 64], (uint64_t)1 << (slot % 64),
+                             memory_order_release);
+    atomic_fetch_or_explicit(&g_coalesce_dirty_types, 1u << type, memory_order_release);
+    return 0;
+}
 
-    journal_entry_t *entry = add_entry_locked();
-    if (entry == NULL) {
-        pthread_mutex_unlock(&g_journal_mutex);
+/**
+ * @brief Apply and clear every dirty slot
+ *
+ * Must be called with the image table mutex held (consumer side). Cost is
+ * one bitmap scan per dirty type plus one apply per dirty address.
+ *
+ * @return Number of addresses applied
+ */
+static size_t coalesce_apply(void)
+{
+    size_t applied = 0;
+    unsigned int types = atomic_exchange_explicit(&g_coalesce_dirty_types, 0,
+                                                  memory_order_acquire);
+
+    while (types != 0) {
+        uint8_t type = (uint8_t)__builtin_ctz(types);
+        types &= types - 1;
+
+        journal_coalesce_table_t *table = &g_coalesce[type];
+        bool is_bool = type <= JOURNAL_BOOL_MEMORY;
+        size_t words = (table->slots + 63) / 64;
+
+        for (size_t k = 0; k < words; k++) {
+            if (atomic_load_explicit(&table->dirty[k], memory_order_relaxed) == 0) {
+                continue;
+            }
+
+            uint64_t bits = atomic_exchange_explicit(&table->dirty[k], 0, memory_order_acquire);
+            while (bits != 0) {
+                size_t slot = k * 64 + (size_t)__builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                journal_entry_t entry = {0};
+                entry.buffer_type = type;
+                entry.index = (uint32_t)(is_bool ? slot / 8 : slot);
+                entry.bit_index = is_bool ? (uint8_t)(slot % 8) : 0xFF;
+                entry.count = 1;
+                entry.value = atomic_load_explicit(&table->values[slot], memory_order_relaxed);
+                apply_entry(&entry);
+                applied++;
+            }
+        }
+    }
+    return applied;
+}
+
+/**
+ * @brief Number of dirty addresses across all coalescing tables
+ */
+static size_t coalesce_pending_count(void)
+{
+    size_t count = 0;
+    for (int t = 0; t < JOURNAL_TYPE_COUNT; t++) {
+        journal_coalesce_table_t *table = &g_coalesce[t];
+        for (size_t k = 0; k < (table->slots + 63) / 64; k++) {
+            count += (size_t)__builtin_popcountll(
+                atomic_load_explicit(&table->dirty[k], memory_order_relaxed));
+        }
+    }
+    return count;
+}
+
+/*
+ * =============================================================================
+ * Watches
+ * =============================================================================
+ */
+
+int journal_watch_address(journal_buffer_type_t type, uint32_t index, uint8_t bit)
+{
+    size_t count = atomic_load_explicit(&g_watch_count, memory_order_relaxed);
+    if (journal_type_width(type) == 0 || count >= JOURNAL_MAX_WATCHES) {
+        return -1;
+    }
+    bool is_bool = type <= JOURNAL_BOOL_MEMORY;
+    if (is_bool && bit > 7) {
         return -1;
     }
 
-    entry->buffer_type = (uint8_t)type;
-    entry->index = index;
-    entry->bit_index = 0xFF;
-    entry->value = value;
+    journal_watch_t *watch = &g_watches[count];
+    watch->type = (uint8_t)type;
+    watch->index = index;
+    watch->bit = is_bool ? bit : 0xFF;
+    atomic_store_explicit(&watch->seen, false, memory_order_relaxed);
 
-    pthread_mutex_unlock(&g_journal_mutex);
-    return 0;
+    /* Publish the watch before writers can see its type bit */
+    atomic_store_explicit(&g_watch_count, count + 1, memory_order_release);
+    atomic_fetch_or_explicit(&g_watched_types, 1u << type, memory_order_release);
+    return (int)count;
 }
 
-int journal_write_lint(journal_buffer_type_t type, uint16_t index,
-                       uint64_t value)
+void journal_set_watch_handler(journal_watch_fn handler, void *ctx)
+{
+    g_watch_ctx = ctx;
+    g_watch_handler = handler;
+}
+
+/*
+ * =============================================================================
+ * Write Maps
+ * =============================================================================
+ */
+
+int journal_track_writes(journal_buffer_type_t type, journal_write_map_t *map)
 {
-    if (!g_initialized) {
+    if ((int)type < 0 || type >= JOURNAL_TYPE_COUNT) {
         return -1;
     }
+    atomic_store_explicit(&g_write_maps[type], map, memory_order_release);
+    return 0;
+}
 
-    /* Validate type */
-    if (type != JOURNAL_LINT_INPUT &&
-        type != JOURNAL_LINT_OUTPUT &&
-        type != JOURNAL_LINT_MEMORY) {
-        return -1;
+/**
+ * @brief Record that count indexes from index were written
+ *
+ * Consumer side (image table mutex held), after the bounds check. Types
+ * nobody tracks cost one relaxed load.
+ */
+static inline void mark_written(uint8_t type, size_t index, size_t count)
+{
+    journal_write_map_t *map = atomic_load_explicit(&g_write_maps[type], memory_order_acquire);
+    if (map == NULL) {
+        return;
     }
+    for (size_t i = index; i < index + count; i++) {
+        map->bits[i / 64] |= (uint64_t)1 << (i % 64);
+        map->summary[i / 4096] |= (uint64_t)1 << ((i / 64) % 64);
+    }
+}
 
-    pthread_mutex_lock(&g_journal_mutex);
+/**
+ * @brief Call the watch handler for watches a write changes
+ *
+ * Runs on the writer thread after the entry is published, so a scan started
+ * by the handler applies the write. Writes to types nobody watches return
+ * after one relaxed load.
+ */
+static void watch_notify(uint8_t type, uint32_t index, uint8_t bit, uint64_t value)
+{
+    if ((atomic_load_explicit(&g_watched_types, memory_order_relaxed) & (1u << type)) == 0) {
+        return;
+    }
 
-    journal_entry_t *entry = add_entry_locked();
-    if (entry == NULL) {
-        pthread_mutex_unlock(&g_journal_mutex);
-        return -1;
+    size_t count = atomic_load_explicit(&g_watch_count, memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        journal_watch_t *watch = &g_watches[i];
+        if (watch->type != type || watch->index != index || watch->bit != bit) {
+            continue;
+        }
+        bool first = !atomic_exchange_explicit(&watch->seen, true, memory_order_relaxed);
+        uint64_t previous = atomic_exchange_explicit(&watch->last, value, memory_order_relaxed);
+        if ((first || previous != value) && g_watch_handler != NULL) {
+            g_watch_handler(i, g_watch_ctx);
+        }
     }
+}
 
-    entry->buffer_type = (uint8_t)type;
-    entry->index = index;
-    entry->bit_index = 0xFF;
-    entry->value = value;
+static void watch_notify_range(uint8_t type, uint32_t start_index, uint32_t count,
+                               const uint8_t *src)
+{
+    if ((atomic_load_explicit(&g_watched_types, memory_order_relaxed) & (1u << type)) == 0) {
+        return;
+    }
 
-    pthread_mutex_unlock(&g_journal_mutex);
-    return 0;
+    size_t width = journal_type_width((journal_buffer_type_t)type);
+    bool is_bool = type <= JOURNAL_BOOL_MEMORY;
+    size_t watches = atomic_load_explicit(&g_watch_count, memory_order_acquire);
+    for (size_t i = 0; i < watches; i++) {
+        journal_watch_t *watch = &g_watches[i];
+        if (watch->type != type || watch->index < start_index ||
+            watch->index - start_index >= count) {
+            continue;
+        }
+        uint64_t v = 0;
+        memcpy(&v, src + (size_t)(watch->index - start_index) * width, width);
+        if (is_bool) {
+            watch_notify(type, watch->index, watch->bit, (v >> watch->bit) & 1);
+        } else {
+            watch_notify(type, watch->index, 0xFF, v);
+        }
+    }
 }
 
 /*
@@ -303,12 +991,14 @@ int journal_write_lint(journal_buffer_type_t type, uint16_t index,
  */
 static void apply_entry(const journal_entry_t *entry)
 {
-    uint16_t idx = entry->index;
+    uint32_t idx = entry->index;
 
     /* Bounds check */
-    if (idx >= (uint16_t)g_buffer_ptrs.buffer_size) {
+    if (idx >= (uint32_t)g_buffer_ptrs.buffer_size) {
+        counter_add(&g_counters.dropped[entry->buffer_type], 1);
         return;
     }
+    mark_written(entry->buffer_type, idx, 1);
 
     switch ((journal_buffer_type_t)entry->buffer_type) {
         case JOURNAL_BOOL_INPUT: {
@@ -415,70 +1105,231 @@ static void apply_entry(const journal_entry_t *entry)
     }
 }
 
-void journal_apply_and_clear(void)
-{
-    if (!g_initialized) {
-        return;
+/* Copy a packed run of fixed-width elements into a pointer table */
+#define APPLY_RANGE_TABLE(table, ctype)                                  \
+    for (size_t i = 0; i < n; i++) {                                     \
+        ctype *ptr = (table)[idx + i];                                   \
+        if (ptr != NULL) {                                               \
+            ctype v;                                                     \
+            memcpy(&v, src + i * sizeof(ctype), sizeof(ctype));          \
+            *ptr = v;                                                    \
+        }                                                                \
     }
 
-    pthread_mutex_lock(&g_journal_mutex);
-
-    /* Apply all entries in sequence order (they're already in order) */
-    for (size_t i = 0; i < g_count; i++) {
-        apply_entry(&g_entries[i]);
+/* Unpack a run of bytes into the 8 bit pointers of each bool index */
+#define APPLY_RANGE_BOOL(table)                                          \
+    for (size_t i = 0; i < n; i++) {                                     \
+        uint8_t bits = src[i];                                           \
+        for (int b = 0; b < 8; b++) {                                    \
+            IEC_BOOL *ptr = (table)[idx + i][b];                         \
+            if (ptr != NULL) {                                           \
+                *ptr = (IEC_BOOL)((bits >> b) & 1);                      \
+            }                                                            \
+        }                                                                \
     }
 
-    /* Clear journal */
-    g_count = 0;
-    g_next_sequence = 0;
+/**
+ * @brief Apply a range entry to the image tables
+ *
+ * @param entry The range entry to apply
+ * @param src Start of the entry's packed payload
+ */
+static void apply_range(const journal_entry_t *entry, const uint8_t *src)
+{
+    size_t idx = entry->index;
+    size_t size = (size_t)g_buffer_ptrs.buffer_size;
+
+    /* Bounds check: clip the run at the end of the buffer */
+    if (idx >= size) {
+        counter_add(&g_counters.dropped[entry->buffer_type], entry->count);
+        return;
+    }
+    size_t n = entry->count;
+    if (n > size - idx) {
+        counter_add(&g_counters.dropped[entry->buffer_type], n - (size - idx));
+        n = size - idx;
+    }
+    mark_written(entry->buffer_type, idx, n);
 
-    pthread_mutex_unlock(&g_journal_mutex);
+    switch ((journal_buffer_type_t)entry->buffer_type) {
+        case JOURNAL_BOOL_INPUT:  APPLY_RANGE_BOOL(g_buffer_ptrs.bool_input); break;
+        case JOURNAL_BOOL_OUTPUT: APPLY_RANGE_BOOL(g_buffer_ptrs.bool_output); break;
+        case JOURNAL_BOOL_MEMORY: APPLY_RANGE_BOOL(g_buffer_ptrs.bool_memory); break;
+        case JOURNAL_BYTE_INPUT:  APPLY_RANGE_TABLE(g_buffer_ptrs.byte_input, IEC_BYTE); break;
+        case JOURNAL_BYTE_OUTPUT: APPLY_RANGE_TABLE(g_buffer_ptrs.byte_output, IEC_BYTE); break;
+        case JOURNAL_INT_INPUT:   APPLY_RANGE_TABLE(g_buffer_ptrs.int_input, IEC_UINT); break;
+        case JOURNAL_INT_OUTPUT:  APPLY_RANGE_TABLE(g_buffer_ptrs.int_output, IEC_UINT); break;
+        case JOURNAL_INT_MEMORY:  APPLY_RANGE_TABLE(g_buffer_ptrs.int_memory, IEC_UINT); break;
+        case JOURNAL_DINT_INPUT:  APPLY_RANGE_TABLE(g_buffer_ptrs.dint_input, IEC_UDINT); break;
+        case JOURNAL_DINT_OUTPUT: APPLY_RANGE_TABLE(g_buffer_ptrs.dint_output, IEC_UDINT); break;
+        case JOURNAL_DINT_MEMORY: APPLY_RANGE_TABLE(g_buffer_ptrs.dint_memory, IEC_UDINT); break;
+        case JOURNAL_LINT_INPUT:  APPLY_RANGE_TABLE(g_buffer_ptrs.lint_input, IEC_ULINT); break;
+        case JOURNAL_LINT_OUTPUT: APPLY_RANGE_TABLE(g_buffer_ptrs.lint_output, IEC_ULINT); break;
+        case JOURNAL_LINT_MEMORY: APPLY_RANGE_TABLE(g_buffer_ptrs.lint_memory, IEC_ULINT); break;
+        default:
+            /* Unknown type - ignore */
+            break;
+    }
 }
 
-/*
- * =============================================================================
- * Emergency Flush
- * =============================================================================
- */
+#undef APPLY_RANGE_TABLE
+#undef APPLY_RANGE_BOOL
 
 /**
- * @brief Emergency flush - apply all entries when buffer is full
+ * @brief Merge all producer rings in sequence order and apply them
+ *
+ * Each ring is already ordered by sequence, so this is a k-way merge over
+ * the rings that have pending entries. The end of each ring is snapshotted
+ * up front; entries published after that are applied on the next call.
  *
- * Called when a new write is attempted but the journal buffer is full.
- * Must be called with g_journal_mutex already held.
+ * Must be called with the image table mutex held (consumer side).
  *
- * Lock ordering to prevent deadlock:
- * 1. Release journal mutex
- * 2. Acquire image mutex
- * 3. Re-acquire journal mutex
- * 4. Apply entries
- * 5. Release image mutex
- * (Continue holding journal mutex for the pending write)
+ * @return Number of entries applied
  */
-static void emergency_flush_locked(void)
+static size_t drain_rings(void)
 {
-    /* Release journal mutex to respect lock ordering */
-    pthread_mutex_unlock(&g_journal_mutex);
+    size_t applied = 0;
+    size_t pos[JOURNAL_MAX_PRODUCERS];
+    size_t end[JOURNAL_MAX_PRODUCERS];
+    uint8_t active[JOURNAL_MAX_PRODUCERS];
+    size_t active_count = 0;
+
+    unsigned int pending = atomic_exchange_explicit(&g_pending_rings, 0, memory_order_acquire);
+    while (pending != 0) {
+        size_t i = (size_t)__builtin_ctz(pending);
+        pending &= pending - 1;
+
+        journal_ring_t *ring = &g_rings[i];
+        int state = atomic_load_explicit(&ring->state, memory_order_acquire);
+        if (state == RING_FREE) {
+            continue;
+        }
 
-    /* Acquire image mutex first (lock ordering) */
-    pthread_mutex_lock(g_buffer_ptrs.image_mutex);
+        pos[i] = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        end[i] = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if (pos[i] != end[i]) {
+            active[active_count++] = (uint8_t)i;
+        } else if (state == RING_RETIRED) {
+            /* Owner exited and everything was applied: release the ring */
+            atomic_store_explicit(&ring->state, RING_FREE, memory_order_release);
+        }
+    }
 
-    /* Re-acquire journal mutex */
-    pthread_mutex_lock(&g_journal_mutex);
+    while (active_count > 0) {
+        /* Pick the ring whose next entry has the lowest sequence number.
+         * Compare with wrap-around so ordering survives counter overflow. */
+        size_t best = 0;
+        const journal_entry_t *best_entry =
+            &g_rings[active[0]].entries[pos[active[0]] & JOURNAL_RING_MASK];
+
+        for (size_t k = 1; k < active_count; k++) {
+            const journal_entry_t *candidate =
+                &g_rings[active[k]].entries[pos[active[k]] & JOURNAL_RING_MASK];
+            if ((int32_t)(candidate->sequence - best_entry->sequence) < 0) {
+                best = k;
+                best_entry = candidate;
+            }
+        }
+
+        uint8_t r = active[best];
+
+        if (best_entry->bit_index == JOURNAL_BIT_RANGE) {
+            journal_ring_t *ring = &g_rings[r];
+            apply_range(best_entry, &ring->payload[best_entry->payload & JOURNAL_PAYLOAD_MASK]);
+            uint32_t len = (uint32_t)(best_entry->count *
+                                      journal_type_width((journal_buffer_type_t)best_entry->buffer_type));
+            atomic_store_explicit(&ring->payload_tail, best_entry->payload + len,
+                                  memory_order_release);
+        } else {
+            apply_entry(best_entry);
+        }
+        applied++;
+
+        if (++pos[r] == end[r]) {
+            atomic_store_explicit(&g_rings[r].tail, pos[r], memory_order_release);
+            active[best] = active[--active_count];
+        }
+    }
+    return applied;
+}
+
+/**
+ * @brief Drop the published entries of every ring without applying them
+ *
+ * The payload of each range entry is released from the entry's own offset,
+ * so payload a producer is reserving for an unpublished entry stays in use.
+ * Retired rings are released by the next drain_rings().
+ *
+ * Must be called with the image table mutex held (consumer side).
+ */
+static void discard_rings(void)
+{
+    for (size_t i = 0; i < JOURNAL_MAX_PRODUCERS; i++) {
+        journal_ring_t *ring = &g_rings[i];
+        size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t end = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (pos == end) {
+            continue;
+        }
 
-    /* Apply all entries */
-    for (size_t i = 0; i < g_count; i++) {
-        apply_entry(&g_entries[i]);
+        bool ranges = false;
+        uint32_t payload_tail = 0;
+        for (; pos != end; pos++) {
+            const journal_entry_t *entry = &ring->entries[pos & JOURNAL_RING_MASK];
+            if (entry->bit_index == JOURNAL_BIT_RANGE) {
+                ranges = true;
+                payload_tail = entry->payload +
+                               (uint32_t)(entry->count *
+                                          journal_type_width((journal_buffer_type_t)entry->buffer_type));
+            }
+        }
+        if (ranges) {
+            atomic_store_explicit(&ring->payload_tail, payload_tail, memory_order_release);
+        }
+        atomic_store_explicit(&ring->tail, end, memory_order_release);
     }
+}
 
-    /* Clear journal */
-    g_count = 0;
-    g_next_sequence = 0;
+void journal_apply_and_clear(void)
+{
+    if (!journal_is_initialized()) {
+        return;
+    }
 
-    /* Release image mutex (keep journal mutex for the pending write) */
-    pthread_mutex_unlock(g_buffer_ptrs.image_mutex);
+    /* An empty journal costs two relaxed loads */
+    bool rings = atomic_load_explicit(&g_pending_rings, memory_order_relaxed) != 0;
+    bool dirty = atomic_load_explicit(&g_coalescing, memory_order_relaxed) &&
+                 atomic_load_explicit(&g_coalesce_dirty_types, memory_order_relaxed) != 0;
+    if (!rings && !dirty) {
+        return;
+    }
 
-    /* Note: We return with g_journal_mutex still held */
+    uint64_t start = monotonic_ns();
+    size_t applied = 0;
+    if (rings) {
+        applied += drain_rings();
+    }
+    if (dirty) {
+        applied += coalesce_apply();
+    }
+    if (applied == 0) {
+        /* Only retired rings were released */
+        return;
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+
+    counter_add(&g_counters.applies, 1);
+    counter_add(&g_counters.entries_applied, applied);
+    counter_add(&g_counters.apply_ns_total, elapsed);
+    atomic_store_explicit(&g_counters.last_applied, applied, memory_order_relaxed);
+    atomic_store_explicit(&g_counters.apply_ns_last, elapsed, memory_order_relaxed);
+    if (applied > atomic_load_explicit(&g_counters.max_applied, memory_order_relaxed)) {
+        atomic_store_explicit(&g_counters.max_applied, applied, memory_order_relaxed);
+    }
+    if (elapsed > atomic_load_explicit(&g_counters.apply_ns_max, memory_order_relaxed)) {
+        atomic_store_explicit(&g_counters.apply_ns_max, elapsed, memory_order_relaxed);
+    }
 }
 
 /*
@@ -489,18 +1340,130 @@ static void emergency_flush_locked(void)
 
 size_t journal_pending_count(void)
 {
-    size_t count;
-    pthread_mutex_lock(&g_journal_mutex);
-    count = g_count;
-    pthread_mutex_unlock(&g_journal_mutex);
+    size_t count = 0;
+    if (!atomic_load_explicit(&g_rings_allocated, memory_order_acquire)) {
+        return 0;
+    }
+    for (size_t i = 0; i < JOURNAL_MAX_PRODUCERS; i++) {
+        size_t head = atomic_load_explicit(&g_rings[i].head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&g_rings[i].tail, memory_order_acquire);
+        count += head - tail;
+    }
+    if (atomic_load_explicit(&g_coalescing, memory_order_relaxed)) {
+        count += coalesce_pending_count();
+    }
     return count;
 }
 
 uint32_t journal_get_sequence(void)
 {
-    uint32_t seq;
-    pthread_mutex_lock(&g_journal_mutex);
-    seq = g_next_sequence;
-    pthread_mutex_unlock(&g_journal_mutex);
-    return seq;
+    return atomic_load_explicit(&g_next_sequence, memory_order_relaxed);
+}
+
+uint64_t journal_emergency_flush_count(void)
+{
+    return atomic_load_explicit(&g_emergency_flushes, memory_order_relaxed);
+}
+
+size_t journal_producer_count(void)
+{
+    size_t count = 0;
+    if (!atomic_load_explicit(&g_rings_allocated, memory_order_acquire)) {
+        return 0;
+    }
+    for (size_t i = 0; i < JOURNAL_MAX_PRODUCERS; i++) {
+        if (atomic_load_explicit(&g_rings[i].state, memory_order_relaxed) == RING_ACTIVE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void journal_get_stats(journal_stats_t *stats)
+{
+    stats->applies = atomic_load_explicit(&g_counters.applies, memory_order_relaxed);
+    stats->entries_applied =
+        atomic_load_explicit(&g_counters.entries_applied, memory_order_relaxed);
+    stats->last_applied = atomic_load_explicit(&g_counters.last_applied, memory_order_relaxed);
+    stats->max_applied = atomic_load_explicit(&g_counters.max_applied, memory_order_relaxed);
+    stats->apply_ns_last = atomic_load_explicit(&g_counters.apply_ns_last, memory_order_relaxed);
+    stats->apply_ns_max = atomic_load_explicit(&g_counters.apply_ns_max, memory_order_relaxed);
+    stats->apply_ns_total = atomic_load_explicit(&g_counters.apply_ns_total, memory_order_relaxed);
+    stats->emergency_flushes = journal_emergency_flush_count();
+    for (int t = 0; t < JOURNAL_TYPE_COUNT; t++) {
+        stats->rejected[t] = atomic_load_explicit(&g_counters.rejected[t], memory_order_relaxed);
+        stats->dropped[t] = atomic_load_explicit(&g_counters.dropped[t], memory_order_relaxed);
+    }
+    stats->rejected_invalid_type =
+        atomic_load_explicit(&g_counters.rejected_invalid_type, memory_order_relaxed);
+    stats->rejected_no_producer =
+        atomic_load_explicit(&g_counters.rejected_no_producer, memory_order_relaxed);
+}
+
+/* Append to buffer at *written, returns false (leaving *written alone) if it does not fit */
+static bool stats_append(char *buffer, size_t buffer_size, size_t *written, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static bool stats_append(char *buffer, size_t buffer_size, size_t *written, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buffer + *written, buffer_size - *written, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)n >= buffer_size - *written) {
+        return false;
+    }
+    *written += (size_t)n;
+    return true;
+}
+
+/* Append "name":{"bool_input":N,...} */
+static bool stats_append_types(char *buffer, size_t buffer_size, size_t *written,
+                               const char *name, const uint64_t values[JOURNAL_TYPE_COUNT])
+{
+    static const char *const type_names[JOURNAL_TYPE_COUNT] = {
+        "bool_input", "bool_output", "bool_memory", "byte_input", "byte_output",
+        "int_input",  "int_output",  "int_memory",  "dint_input", "dint_output",
+        "dint_memory", "lint_input", "lint_output", "lint_memory",
+    };
+
+    bool ok = stats_append(buffer, buffer_size, written, ",\"%s\":{", name);
+    for (int t = 0; ok && t < JOURNAL_TYPE_COUNT; t++) {
+        ok = stats_append(buffer, buffer_size, written, "%s\"%s\":%llu", t == 0 ? "" : ",",
+                          type_names[t], (unsigned long long)values[t]);
+    }
+    return ok && stats_append(buffer, buffer_size, written, "}");
+}
+
+int format_journal_stats_response(char *buffer, size_t buffer_size)
+{
+    journal_stats_t stats;
+    journal_get_stats(&stats);
+
+    uint64_t avg_ns = stats.applies > 0 ? stats.apply_ns_total / stats.applies : 0;
+    size_t written = 0;
+    bool ok = stats_append(
+        buffer, buffer_size, &written,
+        "JOURNAL_STATS:{\"mode\":\"%s\",\"producers\":%zu,\"pending\":%zu,\"sequence\":%u,"
+        "\"applies\":%llu,\"entries_applied\":%llu,\"last_applied\":%llu,"
+        "\"max_applied\":%llu,\"apply_us_last\":%llu,\"apply_us_avg\":%llu,"
+        "\"apply_us_max\":%llu,\"emergency_flushes\":%llu,\"rejected_invalid_type\":%llu,"
+        "\"rejected_no_producer\":%llu",
+        journal_is_coalescing() ? "coalescing" : "ordered", journal_producer_count(),
+        journal_pending_count(), journal_get_sequence(), (unsigned long long)stats.applies,
+        (unsigned long long)stats.entries_applied, (unsigned long long)stats.last_applied,
+        (unsigned long long)stats.max_applied, (unsigned long long)(stats.apply_ns_last / 1000),
+        (unsigned long long)(avg_ns / 1000), (unsigned long long)(stats.apply_ns_max / 1000),
+        (unsigned long long)stats.emergency_flushes,
+        (unsigned long long)stats.rejected_invalid_type,
+        (unsigned long long)stats.rejected_no_producer);
+    ok = ok && stats_append_types(buffer, buffer_size, &written, "rejected", stats.rejected) &&
+         stats_append_types(buffer, buffer_size, &written, "dropped", stats.dropped) &&
+         stats_append(buffer, buffer_size, &written, "}\n");
+
+    if (!ok) {
+        return snprintf(buffer, buffer_size, "JOURNAL_STATS:ERROR\n");
+    }
+    return (int)written;
 }
@@ -12,6 +12,10 @@
  * - Reads are direct: Plugins read directly from image tables
  * - Atomic application: Journal is applied at cycle_start before plugin hooks
  * - Last writer wins: Entries applied in sequence order
+ * - Lock-free producers: Each writer thread owns a single-producer ring, so
+ *   writers never contend with each other or with the scan thread
+ * - Optional coalescing mode: Repeated writes to one address within a cycle
+ *   overwrite a single value slot instead of appending entries
  *
  * Usage:
  *   // In plugin code, instead of:
@@ -19,7 +23,8 @@
  *   // Use:
  *   journal_write_bool(JOURNAL_BOOL_OUTPUT, 5, 3, true);
  *
- * @note Thread-safe. Uses internal mutex for journal operations.
+ * @note Thread-safe. Writers are wait-free in the common case; the image
+ *       table mutex is only taken when a producer ring overflows.
  */
 
 #ifndef JOURNAL_BUFFER_H
@@ -36,13 +41,35 @@ extern "C" {
 #endif
 
 /**
- * @brief Maximum number of journal entries per cycle
+ * @brief Maximum number of journal entries per producer ring per cycle
  *
- * If this limit is reached, an emergency flush is triggered to apply
- * pending entries and make room for new ones.
+ * If a producer fills its ring, an emergency flush is triggered to apply
+ * pending entries and make room for new ones. Must be a power of two.
  */
 #define JOURNAL_MAX_ENTRIES 1024
 
+/**
+ * @brief Maximum number of concurrent producer threads
+ *
+ * Each thread that writes to the journal claims one ring on its first write
+ * and releases it when the thread exits. Writes from additional threads are
+ * rejected while all rings are in use.
+ */
+#define JOURNAL_MAX_PRODUCERS 32
+
+/**
+ * @brief Size in bytes of each producer's range payload arena
+ *
+ * Range writes store their packed element data here. Ranges larger than
+ * half the arena are split into several entries. Must be a power of two.
+ */
+#define JOURNAL_PAYLOAD_BYTES 16384
+
+/**
+ * @brief Maximum number of addresses watched with journal_watch_address()
+ */
+#define JOURNAL_MAX_WATCHES 64
+
 /**
  * @brief Buffer type enumeration for journal entries
  *
@@ -66,17 +93,28 @@ typedef enum {
     JOURNAL_TYPE_COUNT
 } journal_buffer_type_t;
 
+/**
+ * @brief bit_index marker for range entries
+ */
+#define JOURNAL_BIT_RANGE 0xFE
+
 /**
  * @brief Journal entry structure
  *
  * Each entry represents a single write operation to be applied.
  * Entries are applied in sequence order during journal_apply_and_clear().
+ *
+ * Range entries (bit_index == JOURNAL_BIT_RANGE) cover count consecutive
+ * elements starting at index; their packed payload lives in the producer's
+ * payload arena at offset payload.
  */
 typedef struct {
     uint32_t sequence;          /**< Auto-increment, determines apply order */
     uint8_t  buffer_type;       /**< journal_buffer_type_t enum */
     uint8_t  bit_index;         /**< For bool types: 0-7, for others: 0xFF */
-    uint16_t index;             /**< Buffer array index */
+    uint16_t count;             /**< Number of elements (1 for single writes) */
+    uint32_t index;             /**< Buffer array index (first element for ranges) */
+    uint32_t payload;           /**< Payload arena offset (range entries only) */
     uint64_t value;             /**< Value to write (sized for largest type) */
 } journal_entry_t;
 
@@ -117,10 +155,35 @@ typedef struct {
     pthread_mutex_t *image_mutex;
 } journal_buffer_ptrs_t;
 
+/**
+ * @brief Select coalescing mode for the next journal_init()
+ *
+ * In coalescing mode every address (type, index, bit) has one value slot
+ * and one dirty bit. Writes overwrite the slot and set the bit, so the
+ * journal is bounded by the address space instead of by the write rate and
+ * emergency flushes cannot occur. journal_apply_and_clear() only visits
+ * dirty addresses. The cost is that intermediate values written within
+ * one cycle are not applied; only the latest value per address is.
+ *
+ * Takes effect at the next journal_init(). Defaults to false (ordered).
+ *
+ * @param enable true for coalescing mode, false for ordered rings
+ */
+void journal_set_coalescing(bool enable);
+
+/**
+ * @brief Check whether the journal is running in coalescing mode
+ *
+ * @return true if coalescing mode is active
+ */
+bool journal_is_coalescing(void);
+
 /**
  * @brief Initialize the journal buffer system
  *
  * Must be called during runtime initialization, after image tables are set up.
+ * Entries still pending are discarded; takes the image mutex to do so, so it
+ * must not be held by the caller.
  *
  * @param buffer_ptrs Pointer to structure containing image table pointers
  * @return 0 on success, -1 on failure
@@ -130,7 +193,8 @@ int journal_init(const journal_buffer_ptrs_t *buffer_ptrs);
 /**
  * @brief Cleanup journal buffer resources
  *
- * Should be called during runtime shutdown.
+ * Should be called during runtime shutdown. Discards pending entries like
+ * journal_init(), with the image mutex not held by the caller.
  */
 void journal_cleanup(void);
 
@@ -150,7 +214,7 @@ bool journal_is_initialized(void);
  * @param value Boolean value to write
  * @return 0 on success, -1 on failure
  */
-int journal_write_bool(journal_buffer_type_t type, uint16_t index,
+int journal_write_bool(journal_buffer_type_t type, uint32_t index,
                        uint8_t bit, bool value);
 
 /**
@@ -161,7 +225,7 @@ int journal_write_bool(journal_buffer_type_t type, uint16_t index,
  * @param value Byte value to write
  * @return 0 on success, -1 on failure
  */
-int journal_write_byte(journal_buffer_type_t type, uint16_t index,
+int journal_write_byte(journal_buffer_type_t type, uint32_t index,
                        uint8_t value);
 
 /**
@@ -172,7 +236,7 @@ int journal_write_byte(journal_buffer_type_t type, uint16_t index,
  * @param value 16-bit value to write
  * @return 0 on success, -1 on failure
  */
-int journal_write_int(journal_buffer_type_t type, uint16_t index,
+int journal_write_int(journal_buffer_type_t type, uint32_t index,
                       uint16_t value);
 
 /**
@@ -183,7 +247,7 @@ int journal_write_int(journal_buffer_type_t type, uint16_t index,
  * @param value 32-bit value to write
  * @return 0 on success, -1 on failure
  */
-int journal_write_dint(journal_buffer_type_t type, uint16_t index,
+int journal_write_dint(journal_buffer_type_t type, uint32_t index,
                        uint32_t value);
 
 /**
@@ -194,17 +258,126 @@ int journal_write_dint(journal_buffer_type_t type, uint16_t index,
  * @param value 64-bit value to write
  * @return 0 on success, -1 on failure
  */
-int journal_write_lint(journal_buffer_type_t type, uint16_t index,
+int journal_write_lint(journal_buffer_type_t type, uint32_t index,
                        uint64_t value);
 
+/**
+ * @brief Write a contiguous block of elements to the journal as one entry
+ *
+ * values holds count elements packed at the natural width of the type
+ * (1 byte for BYTE, 2 for INT, 4 for DINT, 8 for LINT), in host byte order.
+ * For BOOL types each element is one byte whose bit n is written to bit n
+ * of that index, so all 8 bits of every covered index are written.
+ *
+ * Elements past the end of the buffer are dropped when applied, matching
+ * the single-element writes.
+ *
+ * @param type Buffer type (any journal_buffer_type_t)
+ * @param start_index First buffer array index
+ * @param count Number of elements in values
+ * @param values Packed element data (need not be aligned)
+ * @return 0 on success, -1 on failure
+ */
+int journal_write_range(journal_buffer_type_t type, uint32_t start_index,
+                        uint32_t count, const void *values);
+
+/**
+ * @brief Get the packed element width of a journal buffer type
+ *
+ * @param type Buffer type
+ * @return Element width in bytes, or 0 for an invalid type
+ */
+size_t journal_type_width(journal_buffer_type_t type);
+
+/**
+ * @brief Parse an IEC located address, %<area><size><index>[.<bit>]
+ *
+ * Areas I, Q and M with sizes X (with a bit), B, W, D and L, as far as the
+ * journal has a buffer for them (%IX0.3, %QW2, %MD10, ...).
+ *
+ * @param text Address, not necessarily terminated
+ * @param length Characters of text to parse
+ * @param type Receives the buffer type
+ * @param index Receives the buffer index
+ * @param bit Receives the bit index, 0 for non-BOOL types
+ * @return 0 on success, -1 if the address is invalid
+ */
+int journal_parse_address(const char *text, size_t length, journal_buffer_type_t *type,
+                          uint32_t *index, uint8_t *bit);
+
+/**
+ * @brief Called on the writer thread when a write changes a watched address
+ *
+ * @param watch Index returned by journal_watch_address()
+ * @param ctx Context given to journal_set_watch_handler()
+ */
+typedef void (*journal_watch_fn)(size_t watch, void *ctx);
+
+/**
+ * @brief Watch an address for writes that change its value
+ *
+ * Single and range writes covering the address call the watch handler once
+ * they are journaled, if the value differs from the previous one written
+ * there (the first write always does). Watches cannot be removed and must be
+ * added before plugins start writing.
+ *
+ * @param type Buffer type
+ * @param index Buffer array index
+ * @param bit Bit index for bool types (0-7), ignored for others
+ * @return The watch index passed to the handler, or -1 if the address is
+ *         invalid or JOURNAL_MAX_WATCHES are already in use
+ */
+int journal_watch_address(journal_buffer_type_t type, uint32_t index, uint8_t bit);
+
+/**
+ * @brief Set the function called when a watched address changes
+ *
+ * The handler runs on plugin threads, inside the journal write, and must not
+ * block or write to the journal. Set it before plugins start writing.
+ *
+ * @param handler Function to call, NULL to stop notifications
+ * @param ctx Passed to the handler
+ */
+void journal_set_watch_handler(journal_watch_fn handler, void *ctx);
+
+/**
+ * @brief Indexes of one buffer the journal wrote, as a two-level bitmap
+ *
+ * bits has one bit per index (bit i % 64 of word i / 64), summary one bit per
+ * word of bits (bit w % 64 of word w / 64), so a reader only visits the words
+ * that hold set bits.
+ */
+typedef struct {
+    uint64_t *bits;
+    uint64_t *summary;
+} journal_write_map_t;
+
+/**
+ * @brief Record the indexes of a buffer that applied entries write
+ *
+ * Every applied entry of the type, single or range, in ordered and coalescing
+ * mode, sets the bits of its indexes below buffer_size. The map is only
+ * written with the image table mutex held, so its owner reads and clears it
+ * with the mutex held too. Kept across journal_init().
+ *
+ * @param type Buffer type
+ * @param map Map sized for buffer_size indexes, NULL to stop recording
+ * @return 0 on success, -1 if the type is invalid
+ */
+int journal_track_writes(journal_buffer_type_t type, journal_write_map_t *map);
+
 /**
  * @brief Apply all pending journal entries to image tables and clear the journal
  *
  * This function should be called at the start of each PLC scan cycle,
  * BEFORE plugin cycle_start hooks are called.
  *
+ * Entries from all producer rings are merged by sequence number, so the
+ * last-writer-wins ordering is preserved across threads. In coalescing
+ * mode the dirty addresses are applied instead.
+ *
  * @note The image table mutex (image_mutex) MUST be held by the caller.
- *       This function acquires the journal mutex internally.
+ *       No other lock is taken.
  */
 void journal_apply_and_clear(void);
 
@@ -221,12 +394,77 @@ size_t journal_pending_count(void);
  * @brief Get the current sequence number
  *
  * Useful for diagnostics. The sequence number increments with each write
- * and resets to 0 when the journal is cleared.
+ * and wraps around; it is never reset, so entries written across a
+ * journal_init() keep their order.
  *
  * @return Current sequence number
  */
 uint32_t journal_get_sequence(void);
 
+/**
+ * @brief Get the number of producer rings currently claimed by threads
+ *
+ * @return Number of active producer rings
+ */
+size_t journal_producer_count(void);
+
+/**
+ * @brief Get the number of emergency flushes since startup
+ *
+ * Each one is a producer that filled its ring (or payload arena) and applied
+ * the journal itself, on its own thread, outside the scan.
+ *
+ * @return Emergency flushes, never reset
+ */
+uint64_t journal_emergency_flush_count(void);
+
+/**
+ * @brief Journal counters since startup, for sizing the journal
+ *
+ * An apply is a journal_apply_and_clear() call that found entries; the
+ * entries an emergency flush applies count in entries_applied only.
+ * max_applied is the largest journal a scan had to apply (the high-water
+ * mark of pending entries per cycle). Entries are addresses in coalescing
+ * mode.
+ */
+typedef struct {
+    uint64_t applies;                         /**< Applies that found entries */
+    uint64_t entries_applied;                 /**< Entries applied, flushes included */
+    uint64_t last_applied;                    /**< Entries applied by the latest apply */
+    uint64_t max_applied;                     /**< Most entries applied in one apply */
+    uint64_t apply_ns_last;                   /**< Duration of the latest apply */
+    uint64_t apply_ns_max;                    /**< Longest apply */
+    uint64_t apply_ns_total;                  /**< Time spent in applies */
+    uint64_t emergency_flushes;               /**< See journal_emergency_flush_count() */
+    uint64_t rejected[JOURNAL_TYPE_COUNT];    /**< Writes that returned -1, by type */
+    uint64_t rejected_invalid_type;           /**< Writes with a type out of range */
+    uint64_t rejected_no_producer;            /**< Of rejected[]: all rings were in use */
+    uint64_t dropped[JOURNAL_TYPE_COUNT];     /**< Elements past buffer_size, discarded */
+} journal_stats_t;
+
+/**
+ * @brief Copy the journal counters
+ *
+ * Each counter is read atomically, but the set is not one consistent
+ * snapshot. The counters are never reset.
+ *
+ * @param stats Receives the counters
+ */
+void journal_get_stats(journal_stats_t *stats);
+
+/**
+ * @brief Format the JOURNAL_STATS command response
+ *
+ * JOURNAL_STATS:{"mode":..,"producers":..,"pending":..,"sequence":..,
+ * "applies":..,...,"rejected":{"bool_input":..,...},"dropped":{...}}
+ * followed by a newline. Apply times are in microseconds.
+ *
+ * @param buffer Response buffer
+ * @param buffer_size Size of buffer
+ * @return Number of characters written (excluding null terminator)
+ */
+int format_journal_stats_response(char *buffer, size_t buffer_size);
+
 #ifdef __cplusplus
 }
 #endif
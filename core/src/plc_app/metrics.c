@@ -0,0 +1,634 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "../drivers/plugin_driver.h"
+#include "journal_buffer.h"
+#include "metrics.h"
+#include "plc_state_manager.h"
+#include "scan_cycle_manager.h"
+#include "utils/log.h"
+
+#define METRICS_POLL_MS 1000
+#define METRICS_IO_TIMEOUT_S 2
+#define METRICS_REQUEST_SIZE 1024
+#define METRICS_INITIAL_RESPONSE 16384
+#define METRICS_MAX_RESPONSE (1024 * 1024)
+
+#define METRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+extern volatile sig_atomic_t keep_running;
+extern plugin_driver_t *plugin_driver;
+
+typedef struct
+{
+    char name[METRICS_NAME_SIZE]; // family name, without _total for counters
+    char help[METRICS_HELP_SIZE];
+    char labels[METRICS_LABELS_SIZE];
+    metric_type_t type;
+    _Atomic int64_t value;
+} metric_entry_t;
+
+// Entries below metric_count are never changed again except for their value,
+// so the scrape reads them without the registration mutex
+static metric_entry_t metrics[METRICS_MAX];
+static atomic_int metric_count       = 0;
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char source_names[METRICS_MAX_SOURCES][METRICS_NAME_SIZE];
+
+static char listen_address[INET_ADDRSTRLEN] = METRICS_DEFAULT_ADDRESS;
+static int listen_port                      = 0;
+
+static bool valid_metric_name(const char *name)
+{
+    if (name == NULL || name[0] == '\0' || (name[0] >= '0' && name[0] <= '9'))
+    {
+        return false;
+    }
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        if (!((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+              *c == '_' || *c == ':'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copy `text` with backslash, newline and (for label values) double quote
+// escaped. Returns false if it was truncated to fit.
+static bool escape_text(char *dest, size_t dest_size, const char *text, bool quotes)
+{
+    size_t n = 0;
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        const char *escaped = NULL;
+        if (*c == '\\')
+        {
+            escaped = "\\\\";
+        }
+        else if (*c == '\n')
+        {
+            escaped = "\\n";
+        }
+        else if (*c == '"' && quotes)
+        {
+            escaped = "\\\"";
+        }
+
+        size_t length = escaped ? strlen(escaped) : 1;
+        if (n + length >= dest_size)
+        {
+            dest[n] = '\0';
+            return false;
+        }
+        memcpy(&dest[n], escaped ? escaped : c, length);
+        n += length;
+    }
+    dest[n] = '\0';
+    return true;
+}
+
+int metrics_register(const char *name, const char *help, metric_type_t type, const char *labels)
+{
+    char family[METRICS_NAME_SIZE];
+    char escaped_help[METRICS_HELP_SIZE];
+
+    if (!valid_metric_name(name) || (type != METRIC_COUNTER && type != METRIC_GAUGE) ||
+        strlen(name) >= sizeof(family) || (labels && strlen(labels) >= METRICS_LABELS_SIZE))
+    {
+        return -1;
+    }
+    strcpy(family, name);
+    size_t length = strlen(family);
+    if (type == METRIC_COUNTER && length > 6 && strcmp(&family[length - 6], "_total") == 0)
+    {
+        family[length - 6] = '\0';
+    }
+    escape_text(escaped_help, sizeof(escaped_help), help ? help : "", false);
+
+    pthread_mutex_lock(&metrics_mutex);
+    int count  = atomic_load_explicit(&metric_count, memory_order_relaxed);
+    int handle = -1;
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(metrics[i].name, family) != 0)
+        {
+            continue;
+        }
+        if (metrics[i].type != type)
+        {
+            pthread_mutex_unlock(&metrics_mutex);
+            return -1;
+        }
+        if (strcmp(metrics[i].labels, labels ? labels : "") == 0)
+        {
+            handle = i;
+            break;
+        }
+    }
+    if (handle < 0 && count < METRICS_MAX)
+    {
+        metric_entry_t *entry = &metrics[count];
+        strcpy(entry->name, family);
+        strcpy(entry->help, escaped_help);
+        strcpy(entry->labels, labels ? labels : "");
+        entry->type = type;
+        atomic_store_explicit(&entry->value, 0, memory_order_relaxed);
+        atomic_store_explicit(&metric_count, count + 1, memory_order_release);
+        handle = count;
+    }
+    pthread_mutex_unlock(&metrics_mutex);
+
+    if (handle < 0)
+    {
+        log_warn("Metrics registry full, %s not registered", name);
+    }
+    return handle;
+}
+
+void metrics_set_source_name(int source, const char *name)
+{
+    if (source < 0 || source >= METRICS_MAX_SOURCES || name == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&metrics_mutex);
+    snprintf(source_names[source], sizeof(source_names[source]), "%s", name);
+    pthread_mutex_unlock(&metrics_mutex);
+}
+
+int metrics_register_source(int source, const char *name, const char *help, int type)
+{
+    return metrics_register_source_labels(source, name, help, type, NULL);
+}
+
+int metrics_register_source_labels(int source, const char *name, const char *help, int type,
+                                   const char *labels)
+{
+    char plugin[METRICS_NAME_SIZE] = "";
+    char escaped[METRICS_LABELS_SIZE - 10];
+    char label_set[METRICS_LABELS_SIZE];
+
+    if (source >= 0 && source < METRICS_MAX_SOURCES)
+    {
+        pthread_mutex_lock(&metrics_mutex);
+        strcpy(plugin, source_names[source]);
+        pthread_mutex_unlock(&metrics_mutex);
+    }
+    if (plugin[0] == '\0')
+    {
+        snprintf(plugin, sizeof(plugin), "%d", source);
+    }
+    if (!escape_text(escaped, sizeof(escaped), plugin, true))
+    {
+        return -1;
+    }
+    int length = snprintf(label_set, sizeof(label_set), "plugin=\"%s\"%s%s", escaped,
+                          labels != NULL && labels[0] != '\0' ? "," : "", labels ? labels : "");
+    if (length < 0 || (size_t)length >= sizeof(label_set))
+    {
+        return -1;
+    }
+    return metrics_register(name, help, (metric_type_t)type, label_set);
+}
+
+void metrics_add(int handle, long long delta)
+{
+    if (handle >= 0 && handle < atomic_load_explicit(&metric_count, memory_order_acquire))
+    {
+        atomic_fetch_add_explicit(&metrics[handle].value, delta, memory_order_relaxed);
+    }
+}
+
+void metrics_set(int handle, long long value)
+{
+    if (handle >= 0 && handle < atomic_load_explicit(&metric_count, memory_order_acquire))
+    {
+        atomic_store_explicit(&metrics[handle].value, value, memory_order_relaxed);
+    }
+}
+
+static bool format_family(char *buffer, size_t size, size_t *written, const char *name,
+                          const char *type, const char *help)
+{
+    return timing_format_append(buffer, size, written, "# TYPE %s %s\n# HELP %s %s\n", name, type,
+                                name, help);
+}
+
+// One family with one unlabelled sample
+static bool format_single(char *buffer, size_t size, size_t *written, const char *name,
+                          metric_type_t type, const char *help, long long value)
+{
+    bool counter = type == METRIC_COUNTER;
+    return format_family(buffer, size, written, name, counter ? "counter" : "gauge", help) &&
+           timing_format_append(buffer, size, written, "%s%s %lld\n", name,
+                                counter ? "_total" : "", value);
+}
+
+// A timing histogram as a summary, plus a gauge with its maximum
+static bool format_summary(char *buffer, size_t size, size_t *written, const char *name,
+                           const char *help, const timing_histogram_t *hist)
+{
+    static const double quantiles[]    = {0.5, 0.9, 0.99, 0.999};
+    static const char *const q_names[] = {"0.5", "0.9", "0.99", "0.999"};
+
+    bool ok = format_family(buffer, size, written, name, "summary", help);
+    for (size_t q = 0; ok && q < sizeof(quantiles) / sizeof(quantiles[0]); q++)
+    {
+        int64_t value = timing_histogram_percentile(hist, quantiles[q]);
+        if (value >= 0)
+        {
+            ok = timing_format_append(buffer, size, written, "%s{quantile=\"%s\"} %" PRId64 "\n",
+                                      name, q_names[q], value);
+        }
+    }
+    return ok &&
+           timing_format_append(buffer, size, written, "%s_count %" PRIu64 "\n", name,
+                                hist->total) &&
+           timing_format_append(buffer, size, written,
+                                "# TYPE %s_max gauge\n# HELP %s_max Largest sample since the last "
+                                "reset\n%s_max %" PRIu64 "\n",
+                                name, name, name, hist->max);
+}
+
+static bool format_runtime_metrics(char *buffer, size_t size, size_t *written)
+{
+    plc_timing_stats_t stats;
+    timing_histogram_t hists[TIMING_SNAPSHOT_METRICS];
+
+    if (!get_timing_stats_snapshot(&stats))
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+    get_timing_histograms_snapshot(hists);
+
+    bool running = plc_get_state() == PLC_STATE_RUNNING;
+
+    return format_single(buffer, size, written, "openplc_running", METRIC_GAUGE,
+                         "1 while the PLC program is running", running) &&
+           format_single(buffer, size, written, "openplc_scans", METRIC_COUNTER,
+                         "Scans completed since the last reset", stats.scan_count) &&
+           format_single(buffer, size, written, "openplc_scan_overruns", METRIC_COUNTER,
+                         "Scans that ran past their cycle", stats.overruns) &&
+           format_single(buffer, size, written, "openplc_event_scans", METRIC_COUNTER,
+                         "Scans run between cycles for event triggers", stats.event_scans) &&
+           format_summary(buffer, size, written, "openplc_scan_time_microseconds",
+                          "Time spent in the scan", &hists[0]) &&
+           format_summary(buffer, size, written, "openplc_cycle_time_microseconds",
+                          "Time between the starts of consecutive cycles", &hists[1]) &&
+           format_summary(buffer, size, written, "openplc_cycle_latency_microseconds",
+                          "Delay of the cycle start after its scheduled time", &hists[2]) &&
+           format_single(buffer, size, written, "openplc_journal_pending_entries", METRIC_GAUGE,
+                         "Journal entries waiting for the next scan",
+                         (long long)journal_pending_count()) &&
+           format_single(buffer, size, written, "openplc_journal_producers", METRIC_GAUGE,
+                         "Threads that have written to the journal",
+                         (long long)journal_producer_count()) &&
+           format_single(buffer, size, written, "openplc_journal_emergency_flushes",
+                         METRIC_COUNTER, "Journal flushes forced by a full buffer",
+                         (long long)journal_emergency_flush_count());
+}
+
+// The four hook families, each with a sample per native plugin and hook
+static bool format_hook_metrics(char *buffer, size_t size, size_t *written)
+{
+    static const char *const families[] = {
+        "openplc_plugin_hook_calls",
+        "openplc_plugin_hook_overruns",
+        "openplc_plugin_hook_time_microseconds",
+        "openplc_plugin_hook_max_microseconds",
+    };
+    static const char *const helps[] = {
+        "Cycle hook calls",
+        "Cycle hook calls that exceeded the hook budget",
+        "Time spent in the cycle hook",
+        "Longest cycle hook call since the plugin started",
+    };
+    static const char *const hooks[] = {"cycle_start", "cycle_end"};
+
+    if (plugin_driver == NULL)
+    {
+        return true;
+    }
+
+    bool ok = true;
+    for (int f = 0; ok && f < 4; f++)
+    {
+        bool counter = f < 3;
+        ok = format_family(buffer, size, written, families[f], counter ? "counter" : "gauge",
+                           helps[f]);
+        for (int i = 0; ok && i < plugin_driver->plugin_count; i++)
+        {
+            plugin_hook_stats_t stats[2];
+            char plugin[METRICS_LABELS_SIZE];
+            if (!plugin_driver_get_hook_stats(plugin_driver, i, stats) ||
+                !escape_text(plugin, sizeof(plugin), plugin_driver->plugins[i].config.name, true))
+            {
+                continue;
+            }
+            for (int h = 0; ok && h < 2; h++)
+            {
+                unsigned long long values[] = {stats[h].calls, stats[h].overruns,
+                                               stats[h].total_ns / 1000, stats[h].max_ns / 1000};
+                ok = timing_format_append(buffer, size, written,
+                                          "%s%s{plugin=\"%s\",hook=\"%s\"} %llu\n", families[f],
+                                          counter ? "_total" : "", plugin, hooks[h], values[f]);
+            }
+        }
+    }
+    return ok;
+}
+
+// Registered metrics, each family (name) once with all its label sets
+static bool format_registered_metrics(char *buffer, size_t size, size_t *written)
+{
+    int count = atomic_load_explicit(&metric_count, memory_order_acquire);
+    bool ok   = true;
+
+    for (int i = 0; ok && i < count; i++)
+    {
+        bool seen = false;
+        for (int j = 0; j < i && !seen; j++)
+        {
+            seen = strcmp(metrics[j].name, metrics[i].name) == 0;
+        }
+        if (seen)
+        {
+            continue;
+        }
+
+        bool counter = metrics[i].type == METRIC_COUNTER;
+        ok = format_family(buffer, size, written, metrics[i].name, counter ? "counter" : "gauge",
+                           metrics[i].help);
+        for (int k = i; ok && k < count; k++)
+        {
+            if (strcmp(metrics[k].name, metrics[i].name) != 0)
+            {
+                continue;
+            }
+            int64_t value = atomic_load_explicit(&metrics[k].value, memory_order_relaxed);
+            ok = timing_format_append(buffer, size, written, "%s%s%s%s%s %" PRId64 "\n",
+                                      metrics[k].name, counter ? "_total" : "",
+                                      metrics[k].labels[0] ? "{" : "", metrics[k].labels,
+                                      metrics[k].labels[0] ? "}" : "", value);
+        }
+    }
+    return ok;
+}
+
+int metrics_format(char *buffer, size_t buffer_size)
+{
+    size_t written = 0;
+    if (buffer_size == 0)
+    {
+        return -1;
+    }
+    buffer[0] = '\0';
+
+    if (!format_runtime_metrics(buffer, buffer_size, &written) ||
+        !format_hook_metrics(buffer, buffer_size, &written) ||
+        !format_registered_metrics(buffer, buffer_size, &written) ||
+        !timing_format_append(buffer, buffer_size, &written, "# EOF\n"))
+    {
+        return -1;
+    }
+    return (int)written;
+}
+
+int metrics_set_listen(const char *listen)
+{
+    char address[INET_ADDRSTRLEN] = METRICS_DEFAULT_ADDRESS;
+    const char *port_text         = listen;
+    const char *colon             = listen ? strrchr(listen, ':') : NULL;
+    struct in_addr parsed;
+
+    if (listen == NULL)
+    {
+        return -1;
+    }
+    if (colon != NULL)
+    {
+        size_t length = (size_t)(colon - listen);
+        if (length == 0 || length >= sizeof(address))
+        {
+            return -1;
+        }
+        memcpy(address, listen, length);
+        address[length] = '\0';
+        port_text       = colon + 1;
+    }
+
+    char *end;
+    unsigned long port = strtoul(port_text, &end, 10);
+    if (*port_text == '\0' || *end != '\0' || port == 0 || port > 65535 ||
+        inet_pton(AF_INET, address, &parsed) != 1)
+    {
+        return -1;
+    }
+
+    strcpy(listen_address, address);
+    listen_port = (int)port;
+    return 0;
+}
+
+static int write_all(int fd, const char *buffer, size_t length)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        ssize_t n = write(fd, buffer + written, length - written);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        written += (size_t)n;
+    }
+    return 0;
+}
+
+static void send_response(int fd, const char *status, const char *content_type,
+                          const char *body, size_t length)
+{
+    char header[256];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n",
+                     status, content_type, length);
+    if (write_all(fd, header, (size_t)n) == 0 && length > 0)
+    {
+        write_all(fd, body, length);
+    }
+}
+
+// Render the exposition into *body, growing it until it fits
+static int render_metrics(char **body, size_t *body_size)
+{
+    while (true)
+    {
+        int length = *body ? metrics_format(*body, *body_size) : -1;
+        if (length >= 0)
+        {
+            return length;
+        }
+        if (*body && *body_size >= METRICS_MAX_RESPONSE)
+        {
+            return -1;
+        }
+
+        size_t size = *body ? *body_size * 2 : METRICS_INITIAL_RESPONSE;
+        char *grown = realloc(*body, size);
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        *body      = grown;
+        *body_size = size;
+    }
+}
+
+static void serve_metrics_client(int fd, char **body, size_t *body_size)
+{
+    char request[METRICS_REQUEST_SIZE];
+    size_t length = 0;
+
+    struct timeval timeout = {.tv_sec = METRICS_IO_TIMEOUT_S, .tv_usec = 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters, read until the end of the headers
+    while (length < sizeof(request) - 1)
+    {
+        ssize_t n = read(fd, request + length, sizeof(request) - 1 - length);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        length += (size_t)n;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+        {
+            break;
+        }
+    }
+    request[length] = '\0';
+
+    char method[8];
+    char path[256];
+    if (sscanf(request, "%7s %255s", method, path) != 2)
+    {
+        send_response(fd, "400 Bad Request", "text/plain", "", 0);
+        return;
+    }
+    if (strcmp(method, "GET") != 0)
+    {
+        send_response(fd, "405 Method Not Allowed", "text/plain", "", 0);
+        return;
+    }
+    if (strcmp(path, "/metrics") != 0 && strncmp(path, "/metrics?", 9) != 0)
+    {
+        send_response(fd, "404 Not Found", "text/plain", "", 0);
+        return;
+    }
+
+    int body_length = render_metrics(body, body_size);
+    if (body_length < 0)
+    {
+        send_response(fd, "500 Internal Server Error", "text/plain", "", 0);
+        return;
+    }
+    send_response(fd, "200 OK", METRICS_CONTENT_TYPE, *body, (size_t)body_length);
+}
+
+static void *metrics_thread(void *arg)
+{
+    int server_fd    = (int)(intptr_t)arg;
+    char *body       = NULL;
+    size_t body_size = 0;
+
+    while (keep_running)
+    {
+        struct pollfd pfd = {.fd = server_fd, .events = POLLIN};
+        if (poll(&pfd, 1, METRICS_POLL_MS) <= 0)
+        {
+            continue;
+        }
+
+        int client_fd = accept(server_fd, NULL, NULL);
+        if (client_fd < 0)
+        {
+            continue;
+        }
+        serve_metrics_client(client_fd, &body, &body_size);
+        close(client_fd);
+    }
+
+    free(body);
+    close(server_fd);
+    return NULL;
+}
+
+int metrics_start_server(void)
+{
+    if (listen_port == 0)
+    {
+        return 0;
+    }
+
+    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0)
+    {
+        log_error("Metrics socket creation failed: %s", strerror(errno));
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons((uint16_t)listen_port);
+    inet_pton(AF_INET, listen_address, &address.sin_addr);
+
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        listen(server_fd, 4) < 0)
+    {
+        log_error("Metrics socket bind on %s:%d failed: %s", listen_address, listen_port,
+                  strerror(errno));
+        close(server_fd);
+        return -1;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, metrics_thread, (void *)(intptr_t)server_fd) != 0)
+    {
+        log_error("Failed to create metrics thread: %s", strerror(errno));
+        close(server_fd);
+        return -1;
+    }
+    pthread_detach(thread);
+
+    log_info("Metrics endpoint at http://%s:%d/metrics", listen_address, listen_port);
+    return 0;
+}
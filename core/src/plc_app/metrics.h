@@ -0,0 +1,66 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Runtime and plugin metrics, exported as OpenMetrics text over HTTP when
+// --metrics-listen is given (GET /metrics).
+//
+// The scan, journal and plugin hook metrics are read at scrape time from the
+// snapshots those modules already publish lock-free. Anything else (plugins,
+// through plugin_runtime_args_t) registers counters and gauges here.
+// Registration takes a mutex and is meant for init time; metrics_add() and
+// metrics_set() are one relaxed atomic operation, safe from any thread
+// including the scan thread.
+
+#define METRICS_MAX 256
+#define METRICS_NAME_SIZE 64
+#define METRICS_HELP_SIZE 128
+#define METRICS_LABELS_SIZE 96
+#define METRICS_MAX_SOURCES 64
+
+#define METRICS_DEFAULT_ADDRESS "127.0.0.1"
+
+typedef enum
+{
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE   = 1
+} metric_type_t;
+
+// Register a metric, or look up the one already registered with the same name
+// and labels. `name` must match [a-zA-Z_:][a-zA-Z0-9_:]*; a counter is
+// exported with the _total suffix (a name that has it already keeps one).
+// `labels` is the label set without braces (e.g. `hook="cycle_end"`) or NULL.
+// Returns the handle, or -1 if the name is invalid, used with another type, or
+// the registry is full.
+int metrics_register(const char *name, const char *help, metric_type_t type, const char *labels);
+
+// metrics_register() for the plugin with id `source` (plugin_runtime_args_t
+// plugin_id), the metric gets a plugin="<name>" label
+int metrics_register_source(int source, const char *name, const char *help, int type);
+
+// metrics_register_source() with `labels` added after the plugin label
+int metrics_register_source_labels(int source, const char *name, const char *help, int type,
+                                   const char *labels);
+
+// Name used for the plugin="..." label of plugin `source`, set by the plugin driver
+void metrics_set_source_name(int source, const char *name);
+
+// Add to a counter or gauge, or set a gauge. Invalid handles are ignored.
+void metrics_add(int handle, long long delta);
+void metrics_set(int handle, long long value);
+
+// Write the OpenMetrics exposition, terminated by "# EOF". Returns the length,
+// or -1 if the buffer is too small.
+int metrics_format(char *buffer, size_t buffer_size);
+
+// [ADDRESS:]PORT for the HTTP endpoint, ADDRESS defaults to METRICS_DEFAULT_ADDRESS.
+// Returns -1 if it cannot be parsed.
+int metrics_set_listen(const char *listen);
+
+// Start the HTTP endpoint if metrics_set_listen() was called. Returns 0 when it
+// is running or not configured, -1 if the socket cannot be set up.
+int metrics_start_server(void);
+
+#endif // METRICS_H
@@ -0,0 +1,308 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug_force.h"
+#include "debug_snapshot.h"
+#include "debug_stream.h"
+#include "image_tables.h"
+#include "online_change.h"
+#include "retain_memory.h"
+#include "task_scheduler.h"
+#include "trace_recorder.h"
+#include "utils/log.h"
+#include "utils/utils.h"
+
+typedef const char *(*get_var_name_fn)(size_t idx);
+
+// One block of memory to copy from the running program into the new one
+typedef struct
+{
+    void *dst;
+    const void *src;
+    size_t size;
+} migration_t;
+
+struct online_change
+{
+    plc_symbols_t symbols;
+    image_table_set_t *staging;
+    migration_t *migrations;
+    size_t migration_count;
+    size_t migrated;
+    const plc_task_info_t *tasks;
+};
+
+static void add_migration(online_change_t *change, void *dst, const void *src, size_t size)
+{
+    if (dst == NULL || src == NULL || size == 0)
+    {
+        return;
+    }
+
+    // Variables of a POU are laid out together in both programs, so most
+    // entries extend the previous one and the swap is a few large copies
+    if (change->migration_count > 0)
+    {
+        migration_t *last = &change->migrations[change->migration_count - 1];
+        if ((char *)last->dst + last->size == (char *)dst &&
+            (const char *)last->src + last->size == (const char *)src)
+        {
+            last->size += size;
+            return;
+        }
+    }
+
+    migration_t *entry = &change->migrations[change->migration_count++];
+    entry->dst         = dst;
+    entry->src         = src;
+    entry->size        = size;
+}
+
+static uint32_t name_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+    {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+// Match variables by name, copying those whose size did not change
+static int match_by_name(online_change_t *change, get_var_name_fn next_name,
+                         get_var_name_fn current_name)
+{
+    size_t current_count = ext_get_var_count();
+    size_t next_count    = change->symbols.get_var_count();
+
+    size_t slots = 16;
+    while (slots < current_count * 2)
+    {
+        slots *= 2;
+    }
+
+    // Open addressing over the running program's indexes, SIZE_MAX marks a free slot
+    size_t *table = malloc(slots * sizeof(size_t));
+    if (table == NULL)
+    {
+        return -1;
+    }
+    memset(table, 0xFF, slots * sizeof(size_t));
+
+    for (size_t i = 0; i < current_count; i++)
+    {
+        const char *name = current_name(i);
+        if (name == NULL)
+        {
+            continue;
+        }
+        size_t slot = name_hash(name) & (slots - 1);
+        while (table[slot] != SIZE_MAX)
+        {
+            slot = (slot + 1) & (slots - 1);
+        }
+        table[slot] = i;
+    }
+
+    for (size_t i = 0; i < next_count; i++)
+    {
+        const char *name = next_name(i);
+        if (name == NULL)
+        {
+            continue;
+        }
+        for (size_t slot = name_hash(name) & (slots - 1); table[slot] != SIZE_MAX;
+             slot = (slot + 1) & (slots - 1))
+        {
+            size_t old = table[slot];
+            if (strcmp(current_name(old), name) == 0)
+            {
+                size_t size = change->symbols.get_var_size(i);
+                if (size == ext_get_var_size(old))
+                {
+                    add_migration(change, change->symbols.get_var_addr(i), ext_get_var_addr(old),
+                                  size);
+                    change->migrated++;
+                }
+                break;
+            }
+        }
+    }
+
+    free(table);
+    return 0;
+}
+
+static uint64_t hash_word(uint64_t hash, uint64_t word)
+{
+    for (int b = 0; b < 8; b++)
+    {
+        hash = (hash ^ (word & 0xFF)) * 1099511628211ull;
+        word >>= 8;
+    }
+    return hash;
+}
+
+// FNV-1a over the variable count and the size of each variable, in debug order
+static uint64_t layout_hash(uint16_t (*get_count)(void), size_t (*get_size)(size_t idx))
+{
+    size_t count  = get_count();
+    uint64_t hash = hash_word(14695981039346656037ull, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        hash = hash_word(hash, get_size(i));
+    }
+    return hash;
+}
+
+// Without names nothing tells a moved or replaced variable from an unchanged
+// one, so values are only carried over when both programs have the same layout
+static bool match_by_index(online_change_t *change)
+{
+    if (layout_hash(change->symbols.get_var_count, change->symbols.get_var_size) !=
+        layout_hash(ext_get_var_count, ext_get_var_size))
+    {
+        return false;
+    }
+
+    size_t count = ext_get_var_count();
+    for (size_t i = 0; i < count; i++)
+    {
+        add_migration(change, change->symbols.get_var_addr(i), ext_get_var_addr(i),
+                      change->symbols.get_var_size(i));
+        change->migrated++;
+    }
+    return true;
+}
+
+online_change_t *online_change_prepare(PluginManager *next, PluginManager *current)
+{
+    online_change_t *change = calloc(1, sizeof(online_change_t));
+    if (change == NULL)
+    {
+        log_error("Online change: out of memory");
+        return NULL;
+    }
+
+    if (symbols_resolve(next, &change->symbols) != 0)
+    {
+        free(change);
+        return NULL;
+    }
+
+    // The scan timer and the IEC time base both run on the cycle time
+    if (*change->symbols.common_ticktime__ != *ext_common_ticktime__)
+    {
+        log_error("Online change: cycle time changed from %llu ns to %llu ns, a restart is "
+                  "required",
+                  *ext_common_ticktime__, *change->symbols.common_ticktime__);
+        free(change);
+        return NULL;
+    }
+
+    // Task threads keep their intervals, so the tasks must not change
+    if (task_scheduler_check(next, &change->tasks) != 0)
+    {
+        free(change);
+        return NULL;
+    }
+
+    change->staging    = image_table_set_create();
+    change->migrations = calloc((size_t)change->symbols.get_var_count() + 1, sizeof(migration_t));
+    if (change->staging == NULL || change->migrations == NULL)
+    {
+        log_error("Online change: out of memory");
+        online_change_free(change);
+        return NULL;
+    }
+
+    // Initialize the new program and glue it to the staging tables, while
+    // the running program keeps scanning against the live ones
+    symbols_set_buffers(&change->symbols, change->staging);
+    change->symbols.config_init__();
+    change->symbols.glueVars();
+    if (image_table_set_collect(change->staging) != 0)
+    {
+        log_error("Online change: out of memory");
+        online_change_free(change);
+        return NULL;
+    }
+
+    get_var_name_fn next_name    = NULL;
+    get_var_name_fn current_name = NULL;
+    *(void **)(&next_name)       = plugin_manager_find_symbol(next, ONLINE_CHANGE_NAME_SYMBOL);
+    *(void **)(&current_name)    = plugin_manager_find_symbol(current, ONLINE_CHANGE_NAME_SYMBOL);
+    if (next_name != NULL && current_name != NULL)
+    {
+        if (match_by_name(change, next_name, current_name) != 0)
+        {
+            log_error("Online change: out of memory");
+            online_change_free(change);
+            return NULL;
+        }
+        log_info("Online change: matched variables by name");
+    }
+    else if (match_by_index(change))
+    {
+        log_info("Online change: no variable names, same variable layout, matched by index");
+    }
+    else
+    {
+        log_error("Online change: the programs have no variable names and their variables "
+                  "differ, a restart is required");
+        online_change_free(change);
+        return NULL;
+    }
+
+    IEC_TIME *next_time    = plugin_manager_find_symbol(next, ONLINE_CHANGE_TIME_SYMBOL);
+    IEC_TIME *current_time = plugin_manager_find_symbol(current, ONLINE_CHANGE_TIME_SYMBOL);
+    if (next_time != NULL && current_time != NULL)
+    {
+        add_migration(change, next_time, current_time, sizeof(IEC_TIME));
+    }
+
+    return change;
+}
+
+void online_change_apply(online_change_t *change)
+{
+    for (size_t i = 0; i < change->migration_count; i++)
+    {
+        memcpy(change->migrations[i].dst, change->migrations[i].src, change->migrations[i].size);
+    }
+
+    // The image shadow needs no invalidation: it is resynchronized every scan
+    image_tables_adopt(change->staging);
+    retain_rebind();
+    symbols_set_buffers(&change->symbols, NULL);
+    symbols_install(&change->symbols);
+
+    debug_snapshot_forget();
+    debug_stream_forget();
+    // Traced variables point into the previous program
+    trace_recorder_invalidate();
+    debug_force_invalidate();
+}
+
+size_t online_change_migrated(const online_change_t *change)
+{
+    return change->migrated;
+}
+
+const plc_task_info_t *online_change_tasks(const online_change_t *change)
+{
+    return change->tasks;
+}
+
+void online_change_free(online_change_t *change)
+{
+    if (change == NULL)
+    {
+        return;
+    }
+    free(change->migrations);
+    image_table_set_destroy(change->staging);
+    free(change);
+}
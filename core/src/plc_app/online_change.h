@@ -0,0 +1,65 @@
+#ifndef ONLINE_CHANGE_H
+#define ONLINE_CHANGE_H
+
+#include <stddef.h>
+
+#include "plcapp_manager.h"
+#include "task_scheduler.h"
+
+// Symbol a program exports to migrate variables by name, generated from
+// debug.c by scripts/generate-var-names.py:
+// const char *get_var_name(size_t idx), the name of debug variable idx
+#define ONLINE_CHANGE_NAME_SYMBOL "get_var_name"
+
+// Optional symbol holding the program's IEC time base, carried over so that
+// running timers keep their elapsed time
+#define ONLINE_CHANGE_TIME_SYMBOL "__CURRENT_TIME"
+
+/**
+ * @brief A program prepared to replace the running one
+ *
+ * Everything slow happens in online_change_prepare() on the calling thread:
+ * the new library is resolved, initialized and glued to a staging set of
+ * image tables, and the variables to carry over are matched to the running
+ * program. online_change_apply() then only copies memory, so the scan thread
+ * switches programs between two scans.
+ */
+typedef struct online_change online_change_t;
+
+/**
+ * @brief Prepare a loaded library to replace the running program
+ *
+ * Variables are matched by name when both programs export get_var_name().
+ * Otherwise they are copied by debug index, and only if both programs have
+ * the same number of variables with the same sizes (compared by hash);
+ * any other change is refused.
+ *
+ * @param[in]  next     Plugin manager of the new program, already loaded
+ * @param[in]  current  Plugin manager of the running program
+ * @return The prepared change, or NULL if the program cannot be switched
+ *         online, e.g. its cycle time, tasks or (without names) variables
+ *         changed (the reason is logged)
+ */
+online_change_t *online_change_prepare(PluginManager *next, PluginManager *current);
+
+/**
+ * @brief Switch the runtime to the prepared program
+ *
+ * Called by the scan thread between two scans with buffer_mutex held: copies
+ * the matched variables, installs the staged image table pointers and makes
+ * the new program's entry points current. The previous library stays loaded
+ * until the caller destroys its plugin manager.
+ */
+void online_change_apply(online_change_t *change);
+
+// Number of variables online_change_apply() carries over
+size_t online_change_migrated(const online_change_t *change);
+
+// Task table of the new program for task_scheduler_resume(), NULL if tasks
+// do not run on separate threads
+const plc_task_info_t *online_change_tasks(const online_change_t *change);
+
+// Free a change, applied or not. The plugin managers are not touched.
+void online_change_free(online_change_t *change);
+
+#endif // ONLINE_CHANGE_H
@@ -0,0 +1,695 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "image_gather.h"
+#include "image_tables.h"
+#include "journal_buffer.h"
+#include "plc_instances.h"
+#include "plcapp_manager.h"
+#include "scan_cycle_manager.h"
+#include "task_scheduler.h"
+#include "utils/log.h"
+#include "utils/seqlock.h"
+#include "utils/utils.h"
+
+// Real-time scheduling and CPU affinity are only available on Linux
+#if !defined(__CYGWIN__) && !defined(__MSYS__)
+#define HAS_REALTIME_FEATURES 1
+#else
+#define HAS_REALTIME_FEATURES 0
+#endif
+
+#define TABLE_COUNT 14
+
+extern PluginManager *plc_program;
+
+// One journaled write, its values at offset in the payload of its side
+typedef struct
+{
+    uint8_t type;
+    int8_t bit; // >= 0 for a single BOOL bit
+    uint32_t index;
+    uint32_t count;
+    uint32_t offset;
+} instance_write_t;
+
+typedef struct
+{
+    instance_write_t *writes;
+    size_t write_count;
+    uint8_t *payload;
+    size_t payload_used;
+} journal_side_t;
+
+// Microseconds, written by the instance's scan thread
+typedef struct
+{
+    uint64_t scans;
+    uint64_t overruns; // slots skipped because a scan was late
+    int64_t scan_min;
+    int64_t scan_max;
+    int64_t scan_total;
+    int64_t latency_max; // start after the slot
+    int64_t latency_total;
+    timing_histogram_t scan_hist;
+} instance_stats_t;
+
+typedef struct
+{
+    char path[PATH_MAX];
+    int cpu; // -1 keeps the housekeeping affinity
+    bool running;
+
+    PluginManager *pm;
+    plc_symbols_t symbols;
+    image_table_set_t *tables;
+    void **entries[TABLE_COUNT];
+    size_t counts[TABLE_COUNT]; // entries, index * 8 + bit for the BOOL tables
+    size_t size;                // indexes per table
+    uint64_t period_ns;
+
+    // Held by the scan thread while it runs the program and by readers
+    pthread_mutex_t mutex;
+    atomic_uint generation; // Scans completed
+
+    // Writers append to sides[active], the scan applies the other one
+    pthread_mutex_t journal_mutex;
+    journal_side_t sides[2];
+    int active;
+    atomic_ullong rejected;
+
+    pthread_t thread;
+    atomic_bool stopping;
+    plc_event_t wake;
+    atomic_uint stats_seq;
+    instance_stats_t stats;
+} plc_instance_t;
+
+// Slot 0 stands for the main program and is not used
+static plc_instance_t instances[PLC_INSTANCE_MAX];
+static int instance_total = 1;
+
+// Taken for writing to start and stop the instances, for reading by every
+// plugin call and report, so an instance is not unloaded under a caller.
+// Writers are preferred, plugins polling all the time cannot hold off a stop.
+static pthread_rwlock_t instances_lock;
+static pthread_once_t instances_once = PTHREAD_ONCE_INIT;
+
+static void instances_lock_init(void)
+{
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#if HAS_REALTIME_FEATURES
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&instances_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int plc_instance_add(const char *text)
+{
+    if (instance_total >= PLC_INSTANCE_MAX || text == NULL || text[0] == '\0')
+    {
+        return -1;
+    }
+
+    plc_instance_t *instance = &instances[instance_total];
+    const char *at           = strrchr(text, '@');
+    size_t path_length       = at != NULL ? (size_t)(at - text) : strlen(text);
+    long cpu                 = -1;
+    if (path_length == 0 || path_length >= sizeof(instance->path))
+    {
+        return -1;
+    }
+    if (at != NULL)
+    {
+        char *end;
+        cpu = strtol(at + 1, &end, 10);
+        if (end == at + 1 || *end != '\0' || cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            return -1;
+        }
+    }
+
+    memset(instance, 0, sizeof(*instance));
+    memcpy(instance->path, text, path_length);
+    instance->path[path_length] = '\0';
+    instance->cpu               = (int)cpu;
+    pthread_mutex_init(&instance->mutex, NULL);
+    pthread_mutex_init(&instance->journal_mutex, NULL);
+    plc_event_init(&instance->wake);
+    instance_total++;
+    return 0;
+}
+
+int plc_instance_count(void)
+{
+    return instance_total;
+}
+
+static void apply_thread_settings(plc_instance_t *instance, int number)
+{
+#if HAS_REALTIME_FEATURES
+    struct sched_param param = {.sched_priority = TASK_SCAN_PRIORITY};
+    int err                  = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0)
+    {
+        log_error("Instance %d: failed to set priority %d: %s", number, TASK_SCAN_PRIORITY,
+                  strerror(err));
+    }
+
+    if (instance->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(instance->cpu, &set);
+        err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+        if (err != 0)
+        {
+            log_error("Instance %d: failed to pin to CPU %d: %s", number, instance->cpu,
+                      strerror(err));
+        }
+    }
+#else
+    (void)instance;
+    (void)number;
+#endif
+}
+
+static void record_scan(plc_instance_t *instance, uint64_t slot_ns, uint64_t begin_ns,
+                        uint64_t end_ns, uint64_t skipped)
+{
+    int64_t scan        = (int64_t)(end_ns - begin_ns) / 1000;
+    int64_t latency     = begin_ns > slot_ns ? (int64_t)(begin_ns - slot_ns) / 1000 : 0;
+    instance_stats_t *s = &instance->stats;
+
+    seq_write_begin(&instance->stats_seq);
+    if (s->scans == 0 || scan < s->scan_min)
+    {
+        s->scan_min = scan;
+    }
+    if (scan > s->scan_max)
+    {
+        s->scan_max = scan;
+    }
+    if (latency > s->latency_max)
+    {
+        s->latency_max = latency;
+    }
+    s->scan_total += scan;
+    s->latency_total += latency;
+    s->overruns += skipped;
+    s->scans++;
+    timing_histogram_record(&s->scan_hist, scan);
+    seq_write_end(&instance->stats_seq);
+}
+
+// Scan thread, with the instance's mutex held
+static void journal_apply(plc_instance_t *instance)
+{
+    pthread_mutex_lock(&instance->journal_mutex);
+    journal_side_t *side = &instance->sides[instance->active];
+    instance->active ^= 1;
+    pthread_mutex_unlock(&instance->journal_mutex);
+
+    for (size_t i = 0; i < side->write_count; i++)
+    {
+        const instance_write_t *write = &side->writes[i];
+        const uint8_t *values         = side->payload + write->offset;
+        void **entries                = instance->entries[write->type];
+        if (write->type <= JOURNAL_BOOL_MEMORY && write->bit >= 0)
+        {
+            *(IEC_BOOL *)entries[write->index * 8 + (uint32_t)write->bit] = values[0] & 1;
+        }
+        else if (write->type <= JOURNAL_BOOL_MEMORY)
+        {
+            for (uint32_t k = 0; k < write->count; k++)
+            {
+                for (uint32_t bit = 0; bit < 8; bit++)
+                {
+                    *(IEC_BOOL *)entries[(write->index + k) * 8 + bit] = (values[k] >> bit) & 1;
+                }
+            }
+        }
+        else
+        {
+            size_t width = journal_type_width((journal_buffer_type_t)write->type);
+            for (uint32_t k = 0; k < write->count; k++)
+            {
+                memcpy(entries[write->index + k], values + k * width, width);
+            }
+        }
+    }
+    side->write_count  = 0;
+    side->payload_used = 0;
+}
+
+static void *instance_main(void *arg)
+{
+    plc_instance_t *instance = (plc_instance_t *)arg;
+    int number               = (int)(instance - instances);
+    apply_thread_settings(instance, number);
+
+    periodic_timer_t timer;
+    periodic_timer_start(&timer, instance->period_ns, &scheduler_config);
+    unsigned long tick = 0;
+    uint64_t skipped   = 0;
+
+    while (!atomic_load(&instance->stopping))
+    {
+        uint64_t begin_ns = now_ns();
+        pthread_mutex_lock(&instance->mutex);
+        journal_apply(instance);
+        instance->symbols.config_run__(tick++);
+        instance->symbols.updateTime();
+        atomic_fetch_add_explicit(&instance->generation, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&instance->mutex);
+        record_scan(instance, timer.next_ns, begin_ns, now_ns(), skipped);
+
+        // A stop posts the event, the slot is not waited for
+        while (!periodic_timer_wait_event(&timer, &instance->wake, &skipped))
+        {
+            if (atomic_load(&instance->stopping))
+            {
+                return NULL;
+            }
+        }
+        for (uint64_t i = 0; i < skipped; i++)
+        {
+            instance->symbols.updateTime();
+        }
+        tick += skipped;
+    }
+    return NULL;
+}
+
+static void instance_unload(plc_instance_t *instance)
+{
+    plugin_manager_destroy(instance->pm);
+    image_table_set_destroy(instance->tables);
+    for (int side = 0; side < 2; side++)
+    {
+        free(instance->sides[side].writes);
+        free(instance->sides[side].payload);
+    }
+    instance->pm     = NULL;
+    instance->tables = NULL;
+    memset(instance->sides, 0, sizeof(instance->sides));
+}
+
+// dlopen() of a library already loaded hands back the loaded one, whose variables
+// belong to the program using it. The main program's entry points may not be
+// installed yet, its scan thread does that, so its library is asked.
+static bool shares_library(const plc_instance_t *instance)
+{
+    if (plc_program != NULL &&
+        plugin_manager_find_symbol(plc_program, "config_run__") ==
+            (void *)instance->symbols.config_run__)
+    {
+        return true;
+    }
+    for (int i = 1; i < instance_total; i++)
+    {
+        if (&instances[i] != instance && instances[i].pm != NULL &&
+            instances[i].symbols.config_run__ == instance->symbols.config_run__)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int instance_load(plc_instance_t *instance, int number)
+{
+    instance->pm = plugin_manager_create(instance->path);
+    if (instance->pm == NULL || !plugin_manager_load(instance->pm) ||
+        symbols_resolve(instance->pm, &instance->symbols) != 0)
+    {
+        log_error("Instance %d: failed to load %s", number, instance->path);
+        instance_unload(instance);
+        return -1;
+    }
+    if (shares_library(instance))
+    {
+        log_error("Instance %d: %s is already loaded by another instance, give each instance "
+                  "a copy of its own",
+                  number, instance->path);
+        instance_unload(instance);
+        return -1;
+    }
+
+    instance->tables = image_table_set_create();
+    for (int side = 0; side < 2; side++)
+    {
+        instance->sides[side].writes =
+            malloc(PLC_INSTANCE_JOURNAL_WRITES * sizeof(instance_write_t));
+        instance->sides[side].payload = malloc(PLC_INSTANCE_JOURNAL_PAYLOAD);
+    }
+    if (instance->tables == NULL || instance->sides[0].writes == NULL ||
+        instance->sides[0].payload == NULL || instance->sides[1].writes == NULL ||
+        instance->sides[1].payload == NULL)
+    {
+        log_error("Instance %d: out of memory", number);
+        instance_unload(instance);
+        return -1;
+    }
+
+    // Glued to its own tables, unbound entries backed like in the live ones
+    symbols_set_buffers(&instance->symbols, instance->tables);
+    instance->symbols.config_init__();
+    instance->symbols.glueVars();
+    if (image_table_set_fill(instance->tables) != 0)
+    {
+        log_error("Instance %d: out of memory", number);
+        instance_unload(instance);
+        return -1;
+    }
+    for (uint32_t t = 0; t < TABLE_COUNT; t++)
+    {
+        instance->entries[t] = image_table_set_entries(instance->tables, t, &instance->counts[t]);
+    }
+    instance->size      = image_tables_size();
+    instance->period_ns = *instance->symbols.common_ticktime__;
+    instance->active    = 0;
+    atomic_store(&instance->generation, 0);
+    atomic_store(&instance->rejected, 0);
+
+    seq_write_begin(&instance->stats_seq);
+    memset(&instance->stats, 0, sizeof(instance->stats));
+    seq_write_end(&instance->stats_seq);
+    return 0;
+}
+
+int plc_instances_start(void)
+{
+    pthread_once(&instances_once, instances_lock_init);
+
+    int started = 0;
+    pthread_rwlock_wrlock(&instances_lock);
+    for (int i = 1; i < instance_total; i++)
+    {
+        plc_instance_t *instance = &instances[i];
+        if (instance->running || instance_load(instance, i) != 0)
+        {
+            continue;
+        }
+        atomic_store(&instance->stopping, false);
+        if (pthread_create(&instance->thread, NULL, instance_main, instance) != 0)
+        {
+            log_error("Instance %d: failed to create its scan thread", i);
+            instance_unload(instance);
+            continue;
+        }
+        instance->running = true;
+        started++;
+        log_info("Instance %d: %s running every %" PRIu64 " ns on CPU %d", i, instance->path,
+                 instance->period_ns, instance->cpu);
+    }
+    pthread_rwlock_unlock(&instances_lock);
+
+    if (instance_total > 1)
+    {
+        log_info("Program instances: %d of %d running beside the main program", started,
+                 instance_total - 1);
+    }
+    return started;
+}
+
+void plc_instances_stop(void)
+{
+    pthread_once(&instances_once, instances_lock_init);
+
+    pthread_rwlock_wrlock(&instances_lock);
+    for (int i = 1; i < instance_total; i++)
+    {
+        plc_instance_t *instance = &instances[i];
+        if (!instance->running)
+        {
+            continue;
+        }
+        atomic_store(&instance->stopping, true);
+        plc_event_post(&instance->wake);
+        pthread_join(instance->thread, NULL);
+        instance->running = false;
+        instance_unload(instance);
+        log_info("Instance %d: stopped", i);
+    }
+    pthread_rwlock_unlock(&instances_lock);
+}
+
+// The instance, with instances_lock held for reading, or NULL if it is not running
+static plc_instance_t *instance_acquire(int number)
+{
+    if (number < 1 || number >= instance_total)
+    {
+        return NULL;
+    }
+    pthread_once(&instances_once, instances_lock_init);
+    pthread_rwlock_rdlock(&instances_lock);
+    if (!instances[number].running)
+    {
+        pthread_rwlock_unlock(&instances_lock);
+        return NULL;
+    }
+    return &instances[number];
+}
+
+// Append one write to the side writers fill, with journal_mutex held
+static bool journal_append(plc_instance_t *instance, const plugin_journal_write_t *write)
+{
+    journal_side_t *side = &instance->sides[instance->active];
+    size_t width         = journal_type_width((journal_buffer_type_t)write->type);
+    if (width == 0 || write->values == NULL || write->start_index < 0 ||
+        (size_t)write->start_index >= instance->size ||
+        side->write_count >= PLC_INSTANCE_JOURNAL_WRITES)
+    {
+        return false;
+    }
+
+    instance_write_t *entry = &side->writes[side->write_count];
+    size_t bytes;
+    if (write->bit >= 0)
+    {
+        if (write->type > JOURNAL_BOOL_MEMORY || write->bit > 7)
+        {
+            return false;
+        }
+        entry->bit   = (int8_t)write->bit;
+        entry->count = 1;
+        bytes        = 1;
+    }
+    else
+    {
+        // Elements past the end of the tables are dropped, like in the journal
+        size_t count = write->count > 0 ? (size_t)write->count : 0;
+        if (count > instance->size - (size_t)write->start_index)
+        {
+            count = instance->size - (size_t)write->start_index;
+        }
+        if (count == 0)
+        {
+            return false;
+        }
+        entry->bit   = -1;
+        entry->count = (uint32_t)count;
+        bytes        = count * width;
+    }
+    if (bytes > PLC_INSTANCE_JOURNAL_PAYLOAD - side->payload_used)
+    {
+        return false;
+    }
+
+    entry->type   = (uint8_t)write->type;
+    entry->index  = (uint32_t)write->start_index;
+    entry->offset = (uint32_t)side->payload_used;
+    memcpy(side->payload + side->payload_used, write->values, bytes);
+    side->payload_used += bytes;
+    side->write_count++;
+    return true;
+}
+
+int plc_instance_write_batch(int number, const plugin_journal_write_t *writes, int count)
+{
+    if (writes == NULL || count < 0)
+    {
+        return -1;
+    }
+    plc_instance_t *instance = instance_acquire(number);
+    if (instance == NULL)
+    {
+        return -1;
+    }
+
+    int journaled = 0;
+    pthread_mutex_lock(&instance->journal_mutex);
+    while (journaled < count && journal_append(instance, &writes[journaled]))
+    {
+        journaled++;
+    }
+    pthread_mutex_unlock(&instance->journal_mutex);
+    if (journaled < count)
+    {
+        atomic_fetch_add_explicit(&instance->rejected, 1, memory_order_relaxed);
+    }
+
+    pthread_rwlock_unlock(&instances_lock);
+    return journaled;
+}
+
+// Gather count elements from start of one table, with the instance's mutex held
+static int read_range(plc_instance_t *instance, const plugin_image_read_t *read)
+{
+    if (read->type < 0 || read->type >= TABLE_COUNT || read->start_index < 0 ||
+        read->count < 0 || read->dest == NULL || (size_t)read->start_index >= instance->size)
+    {
+        return -1;
+    }
+    size_t start = (size_t)read->start_index;
+    size_t count = (size_t)read->count;
+    if (count > instance->size - start)
+    {
+        count = instance->size - start;
+    }
+
+    void **entries = instance->entries[read->type];
+    switch (journal_type_width((journal_buffer_type_t)read->type))
+    {
+    case 1:
+        if (read->type <= JOURNAL_BOOL_MEMORY)
+        {
+            image_gather_bool(read->dest, (IEC_BOOL * (*)[8])(entries + start * 8), count);
+        }
+        else
+        {
+            image_gather_byte(read->dest, (IEC_BYTE **)(entries + start), count);
+        }
+        break;
+    case 2:
+        image_gather_int(read->dest, (IEC_UINT **)(entries + start), count);
+        break;
+    case 4:
+        image_gather_dint(read->dest, (IEC_UDINT **)(entries + start), count);
+        break;
+    default:
+        image_gather_lint(read->dest, (IEC_ULINT **)(entries + start), count);
+        break;
+    }
+    return (int)count;
+}
+
+int plc_instance_read_batch(int number, plugin_image_read_t *reads, int count,
+                            unsigned int *generation)
+{
+    if (reads == NULL || count < 0 || generation == NULL)
+    {
+        return -1;
+    }
+    plc_instance_t *instance = instance_acquire(number);
+    if (instance == NULL)
+    {
+        return -1;
+    }
+
+    int available = 0;
+    pthread_mutex_lock(&instance->mutex);
+    for (int i = 0; i < count; i++)
+    {
+        reads[i].copied = read_range(instance, &reads[i]);
+        available += reads[i].copied >= 0 ? 1 : 0;
+    }
+    *generation = atomic_load_explicit(&instance->generation, memory_order_relaxed);
+    pthread_mutex_unlock(&instance->mutex);
+
+    pthread_rwlock_unlock(&instances_lock);
+    return available;
+}
+
+static bool format_instance(char *buffer, size_t buffer_size, size_t *written, int number)
+{
+    plc_instance_t *instance = &instances[number];
+
+    // Copies are large, keep them off the caller's stack (instances_lock held)
+    static instance_stats_t s;
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&instance->stats_seq);
+        memcpy(&s, &instance->stats, sizeof(s));
+    } while (seq_read_retry(&instance->stats_seq, seq));
+
+    bool ok = timing_format_append(
+        buffer, buffer_size, written,
+        ",{\"instance\":%d,\"path\":\"%s\",\"running\":%s,\"cpu\":%d,\"cycle_time_ns\":%" PRIu64
+        ",\"scans\":%" PRIu64 ",\"overruns\":%" PRIu64 ",\"rejected\":%llu,",
+        number, instance->path, instance->running ? "true" : "false", instance->cpu,
+        instance->running ? instance->period_ns : 0, s.scans, s.overruns,
+        (unsigned long long)atomic_load_explicit(&instance->rejected, memory_order_relaxed));
+    if (ok && s.scans > 0)
+    {
+        ok = timing_format_append(buffer, buffer_size, written,
+                                  "\"scan_time_min\":%" PRId64 ",\"scan_time_max\":%" PRId64
+                                  ",\"scan_time_avg\":%" PRId64 ",\"latency_max\":%" PRId64
+                                  ",\"latency_avg\":%" PRId64 ",",
+                                  s.scan_min, s.scan_max, s.scan_total / (int64_t)s.scans,
+                                  s.latency_max, s.latency_total / (int64_t)s.scans);
+    }
+    else if (ok)
+    {
+        ok = timing_format_append(buffer, buffer_size, written,
+                                  "\"scan_time_min\":null,\"scan_time_max\":null,"
+                                  "\"scan_time_avg\":null,\"latency_max\":null,"
+                                  "\"latency_avg\":null,");
+    }
+    return ok && timing_format_append(buffer, buffer_size, written, "\"scan_time\":{") &&
+           timing_histogram_format_fields(buffer, buffer_size, written, &s.scan_hist) &&
+           timing_format_append(buffer, buffer_size, written, "}}");
+}
+
+int format_instance_stats_response(char *buffer, size_t buffer_size)
+{
+    pthread_once(&instances_once, instances_lock_init);
+    pthread_rwlock_rdlock(&instances_lock);
+
+    // The main program's timing is the one of STATS and HISTOGRAM
+    const char *main_path = plc_program != NULL ? plugin_manager_get_path(plc_program) : NULL;
+    size_t written        = 0;
+    bool ok               = main_path != NULL
+                                ? timing_format_append(buffer, buffer_size, &written,
+                                                       "INSTANCES:{\"instances\":[{\"instance\":0,"
+                                                       "\"path\":\"%s\",\"running\":true}",
+                                                       main_path)
+                                : timing_format_append(buffer, buffer_size, &written,
+                                                       "INSTANCES:{\"instances\":[{\"instance\":0,"
+                                                       "\"path\":null,\"running\":false}");
+    for (int i = 1; ok && i < instance_total; i++)
+    {
+        ok = format_instance(buffer, buffer_size, &written, i);
+    }
+    ok = ok && timing_format_append(buffer, buffer_size, &written, "]}\n");
+
+    pthread_rwlock_unlock(&instances_lock);
+
+    if (!ok)
+    {
+        return snprintf(buffer, buffer_size, "INSTANCES:ERROR\n");
+    }
+    return (int)written;
+}
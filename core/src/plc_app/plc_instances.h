@@ -0,0 +1,100 @@
+#ifndef PLC_INSTANCES_H
+#define PLC_INSTANCES_H
+
+#include <stddef.h>
+
+#include "../drivers/plugin_types.h"
+
+/**
+ * @file plc_instances.h
+ * @brief Additional PLC programs running beside the main one
+ *
+ * Instance 0 is the program the state manager loads from the build directory,
+ * with everything that comes with it: plugin hooks, the journal, the image
+ * shadow, debugging, retain memory and online changes. Every --instance adds
+ * a program of its own:
+ *
+ * - its own library (PluginManager), loaded from its own file, since
+ *   dlopen() of a path already loaded would share the program's variables
+ * - its own image tables (an image_table_set_t), with every entry it does not
+ *   bind backed like in the live tables
+ * - its own scan thread at the program's cycle time, SCHED_FIFO at the scan
+ *   thread's priority and pinned to its CPU, with its own timing statistics
+ * - its own journal, double-buffered: writers append under a short lock, the
+ *   scan swaps the buffers and applies the full one in order at its start
+ *
+ * The instances start after the main program's scan thread and stop before it
+ * is unloaded. Plugins keep being shared: they address an instance through the
+ * PLUGIN_CAP_INSTANCES entry points of ABI version 2, with instance 0 going to
+ * the main program's journal and image shadow.
+ */
+
+// Programs in one runtime, the main one included
+#define PLC_INSTANCE_MAX 8
+
+// Writes and payload bytes one side of an instance journal holds per scan
+#define PLC_INSTANCE_JOURNAL_WRITES 4096
+#define PLC_INSTANCE_JOURNAL_PAYLOAD (256 * 1024)
+
+/**
+ * @brief Add a program instance
+ *
+ * Call before the PLC is first started.
+ *
+ * @param text "PATH" or "PATH@CPU", the program library and the CPU its scan
+ *             thread is pinned to
+ * @return 0 on success, -1 if the text is invalid or PLC_INSTANCE_MAX
+ *         programs are configured
+ */
+int plc_instance_add(const char *text);
+
+/**
+ * @brief Load, initialize and start the configured instances
+ *
+ * Called by the state manager once the main program's scan thread runs. An
+ * instance that fails to load is logged and stays stopped; the others run.
+ *
+ * @return Number of instances running
+ */
+int plc_instances_start(void);
+
+/**
+ * @brief Stop the scan threads of the instances and unload their programs
+ *
+ * Plugin calls addressing them fail from then on.
+ */
+void plc_instances_stop(void);
+
+/**
+ * @brief Number of instances, the main program included
+ */
+int plc_instance_count(void);
+
+/**
+ * @brief Journal writes for an instance other than 0
+ *
+ * Like journal_write_batch of plugin_capabilities_t: returns the writes
+ * journaled before the first one rejected (a full journal or an invalid
+ * address), or -1 if the instance is not running.
+ */
+int plc_instance_write_batch(int instance, const plugin_journal_write_t *writes, int count);
+
+/**
+ * @brief Read ranges of an instance other than 0
+ *
+ * Like read_image_batch of plugin_capabilities_t. Takes the instance's mutex,
+ * so it waits for a scan of the instance in progress; all ranges come from the
+ * same scan and *generation receives its number. Returns -1 if the instance is
+ * not running.
+ */
+int plc_instance_read_batch(int instance, plugin_image_read_t *reads, int count,
+                            unsigned int *generation);
+
+/**
+ * @brief Format the instances and their scan timing for the INSTANCES command
+ *
+ * @return The number of characters written
+ */
+int format_instance_stats_response(char *buffer, size_t buffer_size);
+
+#endif // PLC_INSTANCES_H
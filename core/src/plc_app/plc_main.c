@@ -10,11 +10,23 @@
 #include <unistd.h>
 
 #include "../drivers/plugin_driver.h"
+#include "debug_handler.h"
+#include "event_trigger.h"
+#include "image_gather.h"
 #include "image_tables.h"
+#include "journal_buffer.h"
+#include "metrics.h"
+#include "plc_instances.h"
 #include "plc_state_manager.h"
 #include "plcapp_manager.h"
+#include "retain_memory.h"
+#include "safe_state.h"
 #include "scan_cycle_manager.h"
+#include "simulation.h"
+#include "task_scheduler.h"
 #include "unix_socket.h"
+#include "utils/boot_timeline.h"
+#include "utils/huge_pages.h"
 #include "utils/log.h"
 #include "utils/utils.h"
 #include "utils/watchdog.h"
@@ -32,16 +44,283 @@ void handle_sigint(int sig)
 
 int main(int argc, char *argv[])
 {
-    // Check for --print-logs argument
+    boot_timeline_start();
+
+    // Parse command line arguments
     for (int i = 1; i < argc; i++)
     {
         if (strcmp(argv[i], "--print-logs") == 0)
         {
             print_logs = true;
-            break;
+        }
+        else if (strcmp(argv[i], "--sync-logs") == 0)
+        {
+            // Deliver log messages on the calling thread instead of queueing them
+            log_set_async(false);
+        }
+        else if (strcmp(argv[i], "--log-backlog") == 0 && i + 1 < argc)
+        {
+            // Bytes of log lines kept while the log socket is disconnected
+            if (log_set_backlog_size(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid log backlog size: %s (%d to %d bytes)\n", argv[i],
+                        LOG_BACKLOG_MIN_SIZE, LOG_BACKLOG_MAX_SIZE);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--log-rate-limit") == 0 && i + 1 < argc)
+        {
+            // BURST:PER_SECOND for repeated plugin messages, 0 as rate disables it
+            unsigned int burst, rate;
+            if (sscanf(argv[++i], "%u:%u", &burst, &rate) != 2 ||
+                log_set_rate_limit(burst, rate) != 0)
+            {
+                fprintf(stderr, "Invalid log rate limit: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--journal-coalesce") == 0)
+        {
+            // Deduplicate plugin writes per address instead of journaling each one
+            journal_set_coalescing(true);
+        }
+        else if (strcmp(argv[i], "--warm-reload") == 0)
+        {
+            // Keep plugins and their connections running across program downloads
+            plc_set_warm_reload(true);
+        }
+        else if (strcmp(argv[i], "--image-size") == 0 && i + 1 < argc)
+        {
+            // Indexes per image table, for programs with more than BUFFER_SIZE I/O
+            if (image_tables_set_size(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid image table size: %s (%d to %d indexes)\n", argv[i],
+                        BUFFER_SIZE, IMAGE_TABLE_MAX_SIZE);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--retain-file") == 0 && i + 1 < argc)
+        {
+            // Keep %MW, %MD and %ML across restarts in this file
+            if (retain_set_file(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid retain file: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--retain-interval") == 0 && i + 1 < argc)
+        {
+            // Milliseconds between two writes of the retain file
+            if (retain_set_interval(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid retain interval: %s (%d to %d ms)\n", argv[i],
+                        RETAIN_MIN_INTERVAL_MS, RETAIN_MAX_INTERVAL_MS);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--multi-task") == 0)
+        {
+            // Run tasks with longer intervals on their own threads
+            task_scheduler_set_enabled(true);
+        }
+        else if (strcmp(argv[i], "--task") == 0 && i + 1 < argc)
+        {
+            // NAME:PRIORITY[:CPU] of a task thread
+            if (task_scheduler_set_task(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid task setting: %s (NAME:PRIORITY[:CPU], at most %d)\n",
+                        argv[i], TASK_MAX_COUNT);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--instance") == 0 && i + 1 < argc)
+        {
+            // PATH[@CPU], another program library run beside the main one
+            if (plc_instance_add(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid program instance: %s (PATH[@CPU], at most %d programs)\n",
+                        argv[i], PLC_INSTANCE_MAX);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--event-trigger") == 0 && i + 1 < argc)
+        {
+            // ADDRESS[:TASK], scan as soon as a plugin write changes ADDRESS
+            if (event_trigger_add(argv[++i]) != 0)
+            {
+                fprintf(stderr,
+                        "Invalid event trigger: %s (ADDRESS[:TASK], e.g. %%IX0.3, at most %d)\n",
+                        argv[i], EVENT_TRIGGER_MAX);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--event-scans") == 0 && i + 1 < argc)
+        {
+            // Event scans allowed between two cycles
+            if (event_trigger_set_max_scans(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid event scan limit: %s (1 to %d)\n", argv[i],
+                        EVENT_TRIGGER_MAX_SCANS);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--overrun-policy") == 0 && i + 1 < argc)
+        {
+            // skip | catch-up[:N] | degrade
+            if (scheduler_parse_overrun_policy(argv[++i], &scheduler_config) != 0)
+            {
+                fprintf(stderr, "Invalid overrun policy: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--spin-us") == 0 && i + 1 < argc)
+        {
+            // Busy-wait the last N microseconds before each cycle for lower jitter
+            scheduler_config.spin_ns = strtoull(argv[++i], NULL, 10) * 1000ull;
+        }
+        else if (strcmp(argv[i], "--scan-cpu") == 0 && i + 1 < argc)
+        {
+            // Pin the scan thread to this (ideally isolated) CPU
+            if (affinity_set_scan_cpu(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid scan CPU: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--housekeeping-cpus") == 0 && i + 1 < argc)
+        {
+            // CPU list for all other runtime and plugin threads
+            if (affinity_set_housekeeping_cpus(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid housekeeping CPU list: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--huge-pages") == 0 && i + 1 < argc)
+        {
+            // off | thp | explicit backing of the image tables and journal rings
+            if (huge_pages_set_mode(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid huge page mode: %s (off, thp or explicit)\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--prefault-heap") == 0 && i + 1 < argc)
+        {
+            // KiB of heap the scan thread touches before its first cycle
+            if (prefault_set_heap_kb(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid heap prefault: %s (0 to %d KiB)\n", argv[i],
+                        PREFAULT_HEAP_MAX_KB);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--fault-report-scans") == 0 && i + 1 < argc)
+        {
+            // Log the page faults of the first N scans, 0 disables it
+            if (fault_report_set_scans(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid fault report scans: %s (0 to %d)\n", argv[i],
+                        FAULT_REPORT_MAX_SCANS);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--simulate") == 0)
+        {
+            // Free-running scans on virtual time, for offline validation
+            simulation_set_enabled(true);
+        }
+        else if (strcmp(argv[i], "--sim-input") == 0 && i + 1 < argc)
+        {
+            if (simulation_set_input(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid simulation input: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--sim-output") == 0 && i + 1 < argc)
+        {
+            if (simulation_set_output(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid simulation output: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--sim-scans") == 0 && i + 1 < argc)
+        {
+            // End the simulation after N scans, 0 for no limit
+            simulation_set_scans(strtoull(argv[++i], NULL, 10));
+        }
+        else if (strcmp(argv[i], "--debug-frame-size") == 0 && i + 1 < argc)
+        {
+            // Largest binary debug response, fewer round trips on large programs
+            if (debug_set_frame_size(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid debug frame size: %s (%d to %d bytes)\n", argv[i],
+                        MIN_DEBUG_FRAME, MAX_DEBUG_FRAME);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--metrics-listen") == 0 && i + 1 < argc)
+        {
+            // OpenMetrics endpoint for Prometheus, off unless given
+            if (metrics_set_listen(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid metrics address: %s ([ADDRESS:]PORT)\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--watchdog-cycles") == 0 && i + 1 < argc)
+        {
+            // Missed scans before the watchdog acts, instead of the fixed default
+            if (watchdog_set_cycles(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid watchdog cycles: %s (1 to %d)\n", argv[i],
+                        WATCHDOG_MAX_CYCLES);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--safe-output") == 0 && i + 1 < argc)
+        {
+            // Value an output takes in the safe state instead of 0, repeatable
+            if (safe_state_add(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid safe output: %s (ADDRESS=VALUE, at most %d)\n",
+                        argv[i], SAFE_STATE_MAX_OUTPUTS);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--safe-output-file") == 0 && i + 1 < argc)
+        {
+            if (safe_state_load_file(argv[++i]) != 0)
+            {
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--safe-state-overrun") == 0 && i + 1 < argc)
+        {
+            // Enter the safe state when one overrun skips this many slots
+            if (safe_state_set_overrun(strtoul(argv[++i], NULL, 10)) != 0)
+            {
+                fprintf(stderr, "Invalid safe state overrun: %s (0 to %d slots)\n", argv[i],
+                        SAFE_STATE_MAX_OVERRUN);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--watchdog-action") == 0 && i + 1 < argc)
+        {
+            if (watchdog_set_action(argv[++i]) != 0)
+            {
+                fprintf(stderr, "Invalid watchdog action: %s (exit, safe-state or restart)\n",
+                        argv[i]);
+                return -1;
+            }
         }
     }
 
+    // Before any thread exists, so they all inherit the housekeeping set
+    apply_housekeeping_affinity();
+
     // Initialize logging system
     log_set_level(LOG_LEVEL_DEBUG);
 
@@ -51,6 +330,8 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    boot_timeline_mark("logging");
+
     // Handle SIGINT for graceful shutdown
     struct sigaction sa;
     sa.sa_handler = handle_sigint;
@@ -58,10 +339,39 @@ int main(int argc, char *argv[])
     sa.sa_flags = 0;
     sigaction(SIGINT, &sa, NULL);
 
+    // Allocate the image tables before anything can bind to them
+    if (image_tables_init() != 0)
+    {
+        return -1;
+    }
+    log_info("Image table gather kernel: %s", image_gather_kernel());
+
+    // Precompute the safe output image against the table size
+    if (safe_state_init() != 0)
+    {
+        return -1;
+    }
+
+    // Load retained memory, restored when the program starts
+    if (retain_init() != 0)
+    {
+        log_error("Failed to initialize retain memory");
+        return -1;
+    }
+
+    // Watch the event trigger addresses before plugins write to them
+    if (event_trigger_init() != 0)
+    {
+        return -1;
+    }
+
+    boot_timeline_mark("image tables and retain");
+
     // Make sure PLC starts in STOP state
     plc_set_state(PLC_STATE_STOPPED);
 
-    // Initialize watchdog
+    // Initialize watchdog, a restart re-executes the same command line
+    watchdog_set_argv(argv);
     if (watchdog_init() != 0)
     {
         log_error("Failed to initialize watchdog");
@@ -75,29 +385,48 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    // Start PLC
-    if (plc_set_state(PLC_STATE_RUNNING) != true)
+    // The debug stream is optional, the runtime works without it
+    if (setup_debug_stream_socket() != 0)
     {
-        log_error("Failed to set PLC state to RUNNING");
+        log_error("Failed to set up the debug stream socket");
+    }
+
+    // Likewise the metrics endpoint, started only with --metrics-listen
+    if (metrics_start_server() != 0)
+    {
+        log_error("Failed to start the metrics endpoint");
     }
 
-    // Initialize plugin driver system
+    boot_timeline_mark("sockets");
+
+    // Create the plugin driver before the program starts, which starts the native
+    // plugins ahead of its scan thread and the Python plugins in the background after it
     plugin_driver = plugin_driver_create();
     if (plugin_driver)
     {
         log_info("[PLUGIN]: Plugin driver system created");
-        // Load plugin configuration
-        if (plugin_driver_load_config(plugin_driver, "./plugins.conf") == 0)
+        if (plugin_driver_load_config(plugin_driver, "./plugins.conf") != 0)
         {
-            // Start plugins
-            plugin_driver_init(plugin_driver);
-            plugin_driver_start(plugin_driver);
-            log_info("[PLUGIN]: Plugin driver system initialized");
+            log_error("[PLUGIN]: Failed to load plugin configuration");
         }
-        else
+    }
+    boot_timeline_mark("plugins loaded");
+
+    // Start PLC
+    if (plc_set_state(PLC_STATE_RUNNING) != true)
+    {
+        log_error("Failed to set PLC state to RUNNING");
+    }
+
+    // Without a program the plugins still run
+    if (plugin_driver && !plugin_driver_is_started(plugin_driver))
+    {
+        plugin_driver_start_native(plugin_driver);
+        if (plugin_driver_start_python(plugin_driver) != 1)
         {
-            log_error("[PLUGIN]: Failed to load plugin configuration");
+            boot_timeline_end();
         }
+        log_info("[PLUGIN]: Plugin driver system initialized");
     }
 
     while (keep_running)
@@ -115,5 +444,7 @@ int main(int argc, char *argv[])
     // Cleanup
     log_info("Shutting down...");
     plc_state_manager_cleanup();
+    retain_shutdown();
+    log_shutdown();
     return 0;
 }
@@ -1,40 +1,141 @@
+#include <errno.h>
 #include <pthread.h>
 #include <stdatomic.h>
+#include <string.h>
+#include <time.h>
 
 #include "../drivers/plugin_driver.h"
+#include "debug_force.h"
+#include "debug_snapshot.h"
+#include "debug_stream.h"
+#include "event_trigger.h"
+#include "image_shadow.h"
 #include "image_tables.h"
 #include "journal_buffer.h"
+#include "online_change.h"
+#include "plc_instances.h"
 #include "plc_state_manager.h"
+#include "retain_memory.h"
+#include "safe_state.h"
 #include "scan_cycle_manager.h"
+#include "scan_profiler.h"
+#include "simulation.h"
+#include "task_scheduler.h"
+#include "trace_recorder.h"
+#include "utils/boot_timeline.h"
 #include "utils/log.h"
 #include "utils/utils.h"
+#include "utils/watchdog.h"
 
 static PLCState plc_state          = PLC_STATE_STOPPED;
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-struct timespec timer_start;
+// Keep plugins running while the program is stopped and swapped
+static bool warm_reload = false;
+
+static periodic_timer_t plc_timer;
 pthread_t plc_thread;
 PluginManager *plc_program = NULL;
 
-extern plc_timing_stats_t plc_timing_stats;
-extern atomic_long plc_heartbeat;
+// Program switch posted to the scan thread by plc_online_change()
+static _Atomic(online_change_t *) pending_change = NULL;
+static pthread_mutex_t change_mutex           = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t change_done             = PTHREAD_COND_INITIALIZER;
+static bool change_applied                    = false;
+
 extern plugin_driver_t *plugin_driver;
 
+// Scan thread: switch programs between two scans, with buffer_mutex held
+static void apply_pending_change(void)
+{
+    // Task threads must be between two runs, otherwise try again next scan
+    if (!task_scheduler_pause())
+    {
+        return;
+    }
+    online_change_t *change = atomic_exchange(&pending_change, NULL);
+    if (change == NULL)
+    {
+        task_scheduler_resume(NULL);
+        return;
+    }
+    online_change_apply(change);
+    if (simulation_enabled())
+    {
+        simulation_bind_outputs();
+    }
+    task_scheduler_resume(online_change_tasks(change));
+
+    pthread_mutex_lock(&change_mutex);
+    change_applied = true;
+    pthread_cond_signal(&change_done);
+    pthread_mutex_unlock(&change_mutex);
+}
+
+// Scan thread: run the triggered tasks between two cycles, see event_trigger.h
+static void run_event_scan(bool multi_task)
+{
+    unsigned int triggered = event_trigger_take();
+    if (triggered == 0)
+    {
+        return;
+    }
+
+    plugin_mutex_take(&plugin_driver->buffer_mutex);
+    journal_apply_and_clear();
+    plugin_driver_cycle_start(plugin_driver);
+
+    // Same tick as the last cycle, the IEC time base only moves with slots
+    if ((triggered & EVENT_TRIGGER_SCAN) != 0)
+    {
+        if (multi_task)
+        {
+            task_scheduler_run(tick__ - 1);
+        }
+        else
+        {
+            ext_config_run__(tick__ - 1);
+        }
+    }
+    if (multi_task)
+    {
+        task_scheduler_trigger(triggered & ~EVENT_TRIGGER_SCAN);
+    }
+
+    image_shadow_sync();
+    plugin_driver_cycle_end(plugin_driver);
+    debug_snapshot_capture();
+    debug_stream_capture();
+    trace_recorder_sample();
+    retain_capture();
+    watchdog_heartbeat();
+    plugin_mutex_give(&plugin_driver->buffer_mutex);
+
+    scan_cycle_event_scan();
+}
+
 void *plc_cycle_thread(void *arg)
 {
     PluginManager *pm = (PluginManager *)arg;
 
     // Initialize PLC with real-time optimizations
     set_realtime_priority();
+    pin_scan_thread();
     lock_memory();
     symbols_init(pm);
     ext_config_init__();
-    ext_glueVars();
 
-    // Fill NULL pointers in image tables with temporary buffers
-    // This ensures plugins can access addresses not used by the PLC program
+    // Bind the image tables to this program's located variables and fill the
+    // remaining NULL pointers with temporary buffers, so plugins can access
+    // addresses not used by the PLC program. Plugins may already be running
+    // (across a warm reload they never stop), so they are held off the tables
+    // until every pointer is rebound. Retained memory then replaces the
+    // initial values.
     plugin_mutex_take(&plugin_driver->buffer_mutex);
+    image_tables_clear_null_pointers();
+    ext_glueVars();
     image_tables_fill_null_pointers();
+    retain_restore();
     plugin_mutex_give(&plugin_driver->buffer_mutex);
 
     // Initialize journal buffer for race-condition-free plugin writes
@@ -53,7 +154,7 @@ void *plc_cycle_thread(void *arg)
         .lint_input = lint_input,
         .lint_output = lint_output,
         .lint_memory = lint_memory,
-        .buffer_size = BUFFER_SIZE,
+        .buffer_size = (int)image_tables_size(),
         .image_mutex = &plugin_driver->buffer_mutex
     };
     if (journal_init(&journal_ptrs) != 0) {
@@ -62,6 +163,25 @@ void *plc_cycle_thread(void *arg)
         log_info("Journal buffer initialized");
     }
 
+    // A simulation feeds and records the image itself and ends the runtime
+    // when that fails, there is no operator to notice
+    bool simulating = simulation_enabled();
+    if (simulating && simulation_start() != 0)
+    {
+        plc_set_state(PLC_STATE_ERROR);
+        simulation_finish(true);
+        return NULL;
+    }
+
+    // Tasks with longer intervals get their own threads if enabled. A
+    // simulation runs them all in the scan, task threads keep wall time.
+    bool multi_task = !simulating && task_scheduler_start(pm);
+    event_trigger_bind(multi_task);
+
+    // Map the stack and heap the loop uses now that the program is set up,
+    // rather than on first touch inside a cycle
+    prefault_scan_thread();
+
     log_info("Starting main loop");
 
     pthread_mutex_lock(&state_mutex);
@@ -69,44 +189,138 @@ void *plc_cycle_thread(void *arg)
     pthread_mutex_unlock(&state_mutex);
     log_info("PLC State: RUNNING");
 
-    plc_timing_stats.scan_count = 0;
+    scan_cycle_time_reset();
+    scan_profiler_reset();
+    fault_report_start();
 
-    // Get the start time for the running program
-    clock_gettime(CLOCK_MONOTONIC, &timer_start);
+    // Slots are absolute multiples of the tick time from this start time
+    periodic_timer_start(&plc_timer, *ext_common_ticktime__, &scheduler_config);
+    watchdog_arm(*ext_common_ticktime__);
 
+    bool sim_done = false;
     while (plc_state == PLC_STATE_RUNNING)
     {
         scan_cycle_time_start();
+        scan_profiler_begin_cycle();
         plugin_mutex_take(&plugin_driver->buffer_mutex);
+        scan_profiler_mark(SCAN_PHASE_LOCK_WAIT);
+
+        // Switch to a program loaded online before anything touches the image
+        if (atomic_load_explicit(&pending_change, memory_order_relaxed) != NULL)
+        {
+            apply_pending_change();
+        }
 
         // Apply pending journal entries before plugin hooks run
         // This ensures all plugin writes from the previous cycle are visible
+        event_trigger_cycle_start();
         journal_apply_and_clear();
+        // A batch of debug forces lands as a whole before the program runs
+        if (simulating)
+        {
+            simulation_cycle_start();
+        }
+        debug_force_apply();
+        scan_profiler_mark(SCAN_PHASE_JOURNAL);
 
         // Call cycle_start for all active native plugins that registered the hook
         plugin_driver_cycle_start(plugin_driver);
+        scan_profiler_mark(SCAN_PHASE_CYCLE_START);
 
         // Execute the PLC cycle
-        ext_config_run__(tick__++);
+        if (multi_task)
+        {
+            task_scheduler_run(tick__++);
+        }
+        else
+        {
+            ext_config_run__(tick__++);
+        }
+        scan_profiler_mark(SCAN_PHASE_PROGRAM);
         ext_updateTime();
+        scan_profiler_mark(SCAN_PHASE_UPDATE_TIME);
+
+        // Refresh packed shadow areas for bulk plugin readers
+        image_shadow_sync();
+        scan_profiler_mark(SCAN_PHASE_SHADOW_SYNC);
 
         // Call cycle_end for all active native plugins that registered the hook
         plugin_driver_cycle_end(plugin_driver);
+        scan_profiler_mark(SCAN_PHASE_CYCLE_END);
+
+        // Capture watched, subscribed and traced debug variables while the
+        // image is still consistent
+        debug_snapshot_capture();
+        debug_stream_capture();
+        trace_recorder_sample();
+
+        // Record changed retained memory for the next checkpoint
+        retain_capture();
 
         // Update Watchdog Heartbeat
-        atomic_store(&plc_heartbeat, time(NULL));
+        watchdog_heartbeat();
 
+        sim_done = simulating && !simulation_cycle_end();
         plugin_mutex_give(&plugin_driver->buffer_mutex);
         scan_cycle_time_end();
+        scan_profiler_end_cycle();
+        fault_report_scan();
 
-        // Calculate next start time
-        timer_start.tv_nsec += *ext_common_ticktime__;
-        normalize_timespec(&timer_start);
+        // A simulation starts the next scan right away, on virtual time
+        if (simulating)
+        {
+            if (sim_done)
+            {
+                pthread_mutex_lock(&state_mutex);
+                plc_state = PLC_STATE_STOPPED;
+                pthread_mutex_unlock(&state_mutex);
+                break;
+            }
+            continue;
+        }
+
+        // Sleep until the next slot, applying the overrun policy. Writes to
+        // event trigger addresses wake the thread for event scans meanwhile.
+        uint64_t skipped;
+        while (!periodic_timer_wait_event(&plc_timer, event_trigger_event(), &skipped))
+        {
+            run_event_scan(multi_task);
+        }
+        if (skipped > 0)
+        {
+            // Keep the IEC time base and task schedule on wall time even
+            // though the program did not run for the skipped slots
+            for (uint64_t i = 0; i < skipped; i++)
+            {
+                ext_updateTime();
+            }
+            tick__ += skipped;
+            scan_cycle_slots_skipped(skipped);
+
+            if (safe_state_overrun(skipped))
+            {
+                log_error("Scan cycle overran by %llu slots, entering the safe state",
+                          (unsigned long long)skipped);
+                plc_set_state(PLC_STATE_ERROR);
+            }
+        }
+    }
 
-        // Sleep until the next cycle should start
-        sleep_until(&timer_start);
+    task_scheduler_stop();
+    if (simulating)
+    {
+        simulation_finish(sim_done);
     }
 
+    // Leaving for ERROR: apply the safe outputs, again if the watchdog already did
+    // while this thread was stuck, since the cycle it was in may have written outputs
+    if (plc_get_state() == PLC_STATE_ERROR)
+    {
+        plugin_mutex_take(&plugin_driver->buffer_mutex);
+        safe_state_apply(true);
+        plugin_mutex_give(&plugin_driver->buffer_mutex);
+        log_info("PLC State: ERROR, outputs in the safe state");
+    }
     return NULL;
 }
 
@@ -127,6 +341,8 @@ int load_plc_program(PluginManager *pm)
     if (plugin_manager_load(pm))
     {
         log_info("Loading PLC application");
+        boot_timeline_mark("program loaded");
+        bool start_python = false;
 
         pthread_mutex_lock(&state_mutex);
         plc_state = PLC_STATE_INIT;
@@ -137,13 +353,25 @@ int load_plc_program(PluginManager *pm)
         if (plugin_driver)
         {
             log_info("[PLUGIN]: Plugin driver system created");
-            // Load plugin configuration
-            if (plugin_driver_update_config(plugin_driver, "./plugins.conf") == 0)
+            if (warm_reload && plugin_driver_is_started(plugin_driver))
+            {
+                // Plugins still running from the previous program are kept
+                if (plugin_driver_reload(plugin_driver, "./plugins.conf") == 0)
+                {
+                    log_info("[PLUGIN]: Plugin driver system reloaded");
+                }
+                else
+                {
+                    log_error("[PLUGIN]: Failed to reload plugins");
+                }
+            }
+            // Load plugin configuration and start the native plugins, Python plugins
+            // follow once the scan runs
+            else if (plugin_driver_update_config(plugin_driver, "./plugins.conf") == 0)
             {
-                // Start plugins
-                plugin_driver_init(plugin_driver);
-                plugin_driver_start(plugin_driver);
-                log_info("[PLUGIN]: Plugin driver system initialized");
+                plugin_driver_start_native(plugin_driver);
+                start_python = true;
+                log_info("[PLUGIN]: Native plugins initialized");
             }
             else
             {
@@ -162,6 +390,16 @@ int load_plc_program(PluginManager *pm)
 
             return -1;
         }
+        boot_timeline_mark("scan thread");
+
+        // Programs added with --instance, each on a scan thread of its own
+        plc_instances_start();
+
+        // Imported and attached in the background, the scan does not wait for them
+        if (!start_python || plugin_driver_start_python(plugin_driver) != 1)
+        {
+            boot_timeline_end();
+        }
 
         return 0;
     }
@@ -189,6 +427,12 @@ int unload_plc_program(PluginManager *pm)
 
         // Wait for the PLC thread to finish
         pthread_join(plc_thread, NULL);
+        plc_instances_stop();
+
+        // Persist the last scans while the program's variables are still bound
+        plugin_mutex_take(&plugin_driver->buffer_mutex);
+        retain_flush();
+        plugin_mutex_give(&plugin_driver->buffer_mutex);
 
         // Cleanup journal buffer before clearing image tables
         journal_cleanup();
@@ -198,12 +442,21 @@ int unload_plc_program(PluginManager *pm)
         // The S7Comm plugin's RWArea callback acquires buffer_mutex during
         // client read operations. If we try to acquire the mutex before
         // stopping the plugin, we can deadlock if a client is connected.
-        plugin_driver_stop(plugin_driver);
+        if (!warm_reload)
+        {
+            plugin_driver_stop(plugin_driver);
+        }
 
-        // Clear temporary pointers from image tables before unloading
-        // This ensures clean state for the next program load
+        // Release the program's entries in the image tables before unloading,
+        // since its variables go away with the library. They point at
+        // temporary buffers again, which plugins kept running keep using.
         plugin_mutex_take(&plugin_driver->buffer_mutex);
         image_tables_clear_null_pointers();
+        image_shadow_invalidate();
+        debug_snapshot_invalidate();
+        debug_stream_invalidate();
+        trace_recorder_invalidate();
+        debug_force_invalidate();
         plugin_mutex_give(&plugin_driver->buffer_mutex);
 
         // Destroy the plugin manager
@@ -222,6 +475,114 @@ int unload_plc_program(PluginManager *pm)
     }
 }
 
+bool plc_online_change(void)
+{
+    if (plc_get_state() != PLC_STATE_RUNNING || plc_program == NULL)
+    {
+        log_error("Online change: PLC is not running");
+        return false;
+    }
+
+    char *libplc_path = find_libplc_file(libplc_build_dir);
+    if (libplc_path == NULL)
+    {
+        log_error("Online change: failed to find libplc file");
+        return false;
+    }
+    if (strcmp(libplc_path, plugin_manager_get_path(plc_program)) == 0)
+    {
+        // dlopen() would hand back the running library instead of loading the new one
+        log_error("Online change: %s is the running program", libplc_path);
+        free(libplc_path);
+        return false;
+    }
+
+    PluginManager *next = plugin_manager_create(libplc_path);
+    free(libplc_path);
+    if (next == NULL)
+    {
+        log_error("Online change: failed to create PluginManager");
+        return false;
+    }
+    if (!plugin_manager_load(next))
+    {
+        log_error("Online change: failed to load the new program");
+        plugin_manager_destroy(next);
+        return false;
+    }
+
+    online_change_t *change = online_change_prepare(next, plc_program);
+    if (change == NULL)
+    {
+        plugin_manager_destroy(next);
+        return false;
+    }
+
+    // Wait for the switch for at least a second, or ten scans on slow tasks
+    unsigned long long timeout_ns = *ext_common_ticktime__ * 10;
+    if (timeout_ns < 1000000000ULL)
+    {
+        timeout_ns = 1000000000ULL;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ns / 1000000000ULL);
+    deadline.tv_nsec += (long)(timeout_ns % 1000000000ULL);
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&change_mutex);
+    change_applied = false;
+    atomic_store(&pending_change, change);
+    while (!change_applied)
+    {
+        if (pthread_cond_timedwait(&change_done, &change_mutex, &deadline) == ETIMEDOUT)
+        {
+            // Take the change back, unless the scan thread is applying it right now
+            if (atomic_exchange(&pending_change, NULL) != NULL)
+            {
+                break;
+            }
+            deadline.tv_sec++;
+        }
+    }
+    bool applied = change_applied;
+    pthread_mutex_unlock(&change_mutex);
+
+    if (!applied)
+    {
+        log_error("Online change: the scan thread did not pick up the new program");
+        online_change_free(change);
+        plugin_manager_destroy(next);
+        return false;
+    }
+
+    PluginManager *previous = plc_program;
+    plc_program             = next;
+    log_info("Online change: switched program, %zu variables carried over",
+             online_change_migrated(change));
+    online_change_free(change);
+
+    // Debug requests made against the previous program's variables are
+    // cancelled before its library goes away
+    plugin_mutex_take(&plugin_driver->buffer_mutex);
+    debug_snapshot_invalidate();
+    debug_stream_invalidate();
+    debug_force_invalidate();
+    plugin_mutex_give(&plugin_driver->buffer_mutex);
+
+    plugin_manager_destroy(previous);
+    return true;
+}
+
+void plc_set_warm_reload(bool enable)
+{
+    warm_reload = enable;
+}
+
 PLCState plc_get_state(void)
 {
     PLCState state;
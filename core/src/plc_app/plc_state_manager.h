@@ -26,6 +26,30 @@ PLCState plc_get_state(void);
  */
 bool plc_set_state(PLCState new_state);
 
+/**
+ * @brief Switch the running PLC to the program in the build directory without stopping it.
+ *
+ * The new library is loaded and initialized beside the running one, then the
+ * scan thread swaps the programs between two scans, carrying over the values
+ * of the variables both programs share. Plugins keep running. Fails, leaving
+ * the running program untouched, if the PLC is not running or the new
+ * program has a different cycle time.
+ * @return true if the new program is running, false otherwise
+ */
+bool plc_online_change(void);
+
+/**
+ * @brief Keep plugins running across program reloads.
+ *
+ * When enabled, stopping the PLC leaves the plugins running against temporary
+ * buffers, and starting it again restarts only the plugins whose line in
+ * plugins.conf changed. Plugins must only touch the image tables while holding
+ * buffer_mutex. Call before the PLC is first started.
+ * @param enable true to keep plugins running, false to stop them with the PLC
+ * @return void
+ */
+void plc_set_warm_reload(bool enable);
+
 /**
  * @brief Cleanup the PLC state manager and unloads the plugin manager.
  * @return void
@@ -111,3 +111,19 @@ void *plugin_manager_get_symbol(PluginManager *pm, const char *symbol_name)
     }
     return sym;
 }
+
+void *plugin_manager_find_symbol(PluginManager *pm, const char *symbol_name)
+{
+    if (!pm || !pm->handle)
+    {
+        return NULL;
+    }
+    dlerror(); // clear old error
+    void *sym = dlsym(pm->handle, symbol_name);
+    return dlerror() ? NULL : sym;
+}
+
+const char *plugin_manager_get_path(PluginManager *pm)
+{
+    return pm ? pm->so_path : NULL;
+}
@@ -45,6 +45,23 @@ bool plugin_manager_load(PluginManager *pm);
  */
 void *plugin_manager_get_symbol(PluginManager *pm, const char *symbol_name);
 
+/**
+ * @brief Get a symbol the library may not define, without logging its absence
+ *
+ * @param[in]  pm  The plugin manager to get the symbol from
+ * @param[in]  symbol_name  The name of the symbol to get
+ * @return A pointer to the symbol, or NULL if the library does not define it
+ */
+void *plugin_manager_find_symbol(PluginManager *pm, const char *symbol_name);
+
+/**
+ * @brief Path of the library managed by the plugin manager
+ *
+ * @param[in]  pm  The plugin manager
+ * @return The .so path given to plugin_manager_create()
+ */
+const char *plugin_manager_get_path(PluginManager *pm);
+
 /**
  * @brief Type-safe function getter
  *
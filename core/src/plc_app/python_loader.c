@@ -28,14 +28,24 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
 #include "include/iec_python.h"
 
 // Function pointers for logging - set by python_loader_set_loggers()
@@ -54,6 +64,24 @@ void python_loader_set_loggers(void (*log_info_func)(const char *, ...),
     py_log_error = log_error_func;
 }
 
+extern char **environ;
+
+// Log every line a Python process prints until it closes its output
+static void log_process_output(FILE *fp)
+{
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    {
+        // Remove trailing newline if present
+        size_t len = strlen(buffer);
+        if (len > 0 && buffer[len - 1] == '\n')
+        {
+            buffer[len - 1] = '\0';
+        }
+        LOG_INFO("[Python] %s", buffer);
+    }
+}
+
 /**
  * @brief Thread function that runs the Python script and logs its output
  *
@@ -74,23 +102,219 @@ static void *runner_thread(void *arg)
         return NULL;
     }
 
+    log_process_output(fp);
+
+    pclose(fp);
+    free((void *)cmd);
+    return NULL;
+}
+
+// Host process shared by all Python function blocks of the program: every
+// line on its stdin is the path of a block script, which it runs in a thread
+// of its own. Output lines are tagged with the script name. The host exits
+// when its stdin closes, i.e. when the program is unloaded or the PLC exits.
+static const char pool_host_code[] =
+    "import os, runpy, sys, threading, traceback\n"
+    "out = sys.stdout\n"
+    "local = threading.local()\n"
+    "class Tagged:\n"
+    "    def write(self, text):\n"
+    "        *lines, local.buf = (getattr(local, 'buf', '') + text).split('\\n')\n"
+    "        for line in lines:\n"
+    "            out.write('[%s] %s\\n' % (getattr(local, 'tag', 'pool'), line))\n"
+    "        return len(text)\n"
+    "    def flush(self):\n"
+    "        out.flush()\n"
+    "sys.stdout = sys.stderr = Tagged()\n"
+    "def run(path):\n"
+    "    local.tag = os.path.basename(path)\n"
+    "    try:\n"
+    "        runpy.run_path(path, run_name='__main__')\n"
+    "    except SystemExit:\n"
+    "        pass\n"
+    "    except BaseException:\n"
+    "        traceback.print_exc()\n"
+    "    print('function block exited')\n"
+    "for line in sys.stdin:\n"
+    "    if line.strip():\n"
+    "        threading.Thread(target=run, args=(line.strip(),), daemon=True).start()\n"
+    "out.flush()\n"
+    "os._exit(0)\n";
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int pool_control           = -1; // Write end of the host's stdin
+static int pool_output            = -1; // Read end of the host's stdout/stderr
+static pid_t pool_pid             = -1;
+static pthread_t pool_tid;
+static volatile int pool_stopping = 0;
+
+// Log the host's output. Polls so pool_stop() can end it even if a process
+// started by a block script still holds the pipe open.
+static void *pool_output_thread(void *arg)
+{
+    (void)arg;
     char buffer[512];
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    size_t used = 0;
+
+    while (!pool_stopping)
     {
-        // Remove trailing newline if present
-        size_t len = strlen(buffer);
-        if (len > 0 && buffer[len - 1] == '\n')
+        struct pollfd pfd = {.fd = pool_output, .events = POLLIN};
+        if (poll(&pfd, 1, 200) <= 0)
         {
-            buffer[len - 1] = '\0';
+            continue;
+        }
+        ssize_t n = read(pool_output, buffer + used, sizeof(buffer) - 1 - used);
+        if (n <= 0)
+        {
+            break;
+        }
+        used += (size_t)n;
+
+        // Log complete lines; a line longer than the buffer is logged in pieces
+        char *line = buffer;
+        char *nl;
+        while ((nl = memchr(line, '\n', used - (size_t)(line - buffer))) != NULL)
+        {
+            *nl = '\0';
+            LOG_INFO("[Python] %s", line);
+            line = nl + 1;
+        }
+        used -= (size_t)(line - buffer);
+        memmove(buffer, line, used);
+        if (used == sizeof(buffer) - 1)
+        {
+            buffer[used] = '\0';
+            LOG_INFO("[Python] %s", buffer);
+            used = 0;
         }
-        LOG_INFO("[Python] %s", buffer);
     }
 
-    pclose(fp);
-    free((void *)cmd);
+    // The host exits as soon as its stdin closes; do not wait on a stuck one
+    for (int i = 0; i < 10 && waitpid(pool_pid, NULL, WNOHANG) == 0; i++)
+    {
+        usleep(100000);
+    }
+    if (waitpid(pool_pid, NULL, WNOHANG) == 0)
+    {
+        kill(pool_pid, SIGKILL);
+        waitpid(pool_pid, NULL, 0);
+    }
     return NULL;
 }
 
+// Start the host process. Called with pool_mutex held.
+static int pool_start(void)
+{
+    int control[2], output[2];
+    if (pipe(control) != 0)
+    {
+        LOG_ERROR("[Python loader] pipe failed: %s", strerror(errno));
+        return -1;
+    }
+    if (pipe(output) != 0)
+    {
+        LOG_ERROR("[Python loader] pipe failed: %s", strerror(errno));
+        close(control[0]);
+        close(control[1]);
+        return -1;
+    }
+    // The runtime's ends must not leak into the host (or any other child)
+    fcntl(control[1], F_SETFD, FD_CLOEXEC);
+    fcntl(output[0], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, control[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose(&actions, control[0]);
+    posix_spawn_file_actions_addclose(&actions, output[1]);
+
+    char *argv[] = {"python3", "-u", "-c", (char *)pool_host_code, NULL};
+    int ret      = posix_spawnp(&pool_pid, "python3", &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(control[0]);
+    close(output[1]);
+    if (ret != 0)
+    {
+        LOG_ERROR("[Python loader] Failed to start Python host process: %s", strerror(ret));
+        close(control[1]);
+        close(output[0]);
+        return -1;
+    }
+
+    pool_control  = control[1];
+    pool_output   = output[0];
+    pool_stopping = 0;
+    if (pthread_create(&pool_tid, NULL, pool_output_thread, NULL) != 0)
+    {
+        LOG_ERROR("[Python loader] pthread_create failed for Python host output");
+        close(pool_control);
+        close(pool_output);
+        pool_control = -1;
+        pool_output  = -1;
+        kill(pool_pid, SIGKILL);
+        waitpid(pool_pid, NULL, 0);
+        return -1;
+    }
+
+    LOG_INFO("[Python loader] Started Python host process (pid %d)", (int)pool_pid);
+    return 0;
+}
+
+// Hand a block script to the host process, starting it on first use
+static int pool_submit(const char *script_name)
+{
+    char line[512];
+    int len = snprintf(line, sizeof(line), "%s\n", script_name);
+    if (len <= 0 || (size_t)len >= sizeof(line) || strchr(script_name, '\n'))
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool_mutex);
+    int ret = pool_control < 0 ? pool_start() : 0;
+    if (ret == 0)
+    {
+        // A dead host must fail the write with EPIPE instead of killing the runtime
+        sigset_t pipe_set, old_set;
+        sigemptyset(&pipe_set);
+        sigaddset(&pipe_set, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+        if (write(pool_control, line, (size_t)len) != len)
+        {
+            LOG_ERROR("[Python loader] Python host process is gone");
+            if (errno == EPIPE)
+            {
+                struct timespec no_wait = {0, 0};
+                sigtimedwait(&pipe_set, NULL, &no_wait);
+            }
+            ret = -1;
+        }
+        pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return ret;
+}
+
+// Runs when the program library is unloaded: closing the host's stdin ends
+// it, together with the blocks of the program. The output thread must be
+// gone before the library's code is unmapped.
+__attribute__((destructor)) static void pool_stop(void)
+{
+    if (pool_control < 0)
+    {
+        return;
+    }
+    close(pool_control);
+    pool_control  = -1;
+    pool_stopping = 1;
+    pthread_join(pool_tid, NULL);
+    close(pool_output);
+    pool_output = -1;
+}
+
 int create_shm_name(char *buf, size_t size)
 {
     char shm_mask[] = "/tmp/shmXXXXXXXXXXXX";
@@ -108,6 +332,48 @@ int create_shm_name(char *buf, size_t size)
     return 0;
 }
 
+// Map an exchange header region; create (and initialize) it when create is set
+static python_block_sync_t *map_sync_region(const char *shm_name, int create)
+{
+    char shm_sync_name[256];
+    snprintf(shm_sync_name, sizeof(shm_sync_name), "%s_sync", shm_name);
+
+    int fd = shm_open(shm_sync_name, create ? (O_CREAT | O_RDWR) : O_RDWR, 0660);
+    if (fd < 0)
+    {
+        LOG_ERROR("[Python loader] shm_open (sync) error: %s", strerror(errno));
+        return NULL;
+    }
+    if (create && ftruncate(fd, sizeof(python_block_sync_t)) == -1)
+    {
+        LOG_ERROR("[Python loader] ftruncate (sync) error: %s", strerror(errno));
+        close(fd);
+        shm_unlink(shm_sync_name);
+        return NULL;
+    }
+    void *ptr = mmap(NULL, sizeof(python_block_sync_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        LOG_ERROR("[Python loader] mmap (sync) error: %s", strerror(errno));
+        if (create)
+        {
+            shm_unlink(shm_sync_name);
+        }
+        return NULL;
+    }
+
+    python_block_sync_t *sync = (python_block_sync_t *)ptr;
+    if (create)
+    {
+        memset(sync, 0, sizeof(*sync));
+        sync->version = PYTHON_BLOCK_SYNC_VERSION;
+        // Written last: the Python process waits for the magic before using the header
+        __atomic_store_n(&sync->magic, PYTHON_BLOCK_SYNC_MAGIC, __ATOMIC_RELEASE);
+    }
+    return sync;
+}
+
 int python_block_loader(const char *script_name, const char *script_content, char *shm_name,
                         size_t shm_in_size, size_t shm_out_size, void **shm_in_ptr,
                         void **shm_out_ptr, pid_t pid)
@@ -190,6 +456,23 @@ int python_block_loader(const char *script_name, const char *script_content, cha
     close(shm_in_fd);
     close(shm_out_fd);
 
+    // Exchange header, created before the Python process starts so it never
+    // sees a missing region. Blocks that do not use it simply ignore it.
+    python_block_sync_t *sync = map_sync_region(shm_name, 1);
+    if (sync == NULL)
+    {
+        return -1;
+    }
+    munmap(sync, sizeof(*sync));
+
+    // Run the block in the shared host process; fall back to a process of its own
+    const char *pool = getenv("OPENPLC_PYTHON_FB_POOL");
+    if ((pool == NULL || strcmp(pool, "0") != 0) && pool_submit(script_name) == 0)
+    {
+        LOG_INFO("[Python loader] Started Python function block: %s", script_name);
+        return 0;
+    }
+
     // Prepare command to run Python script
     char *cmd = malloc(512);
     if (cmd == NULL)
@@ -213,3 +496,84 @@ int python_block_loader(const char *script_name, const char *script_content, cha
 
     return 0;
 }
+
+int python_block_sync_open(const char *shm_name, python_block_sync_t **sync)
+{
+    *sync = map_sync_region(shm_name, 0);
+    if (*sync == NULL)
+    {
+        return -1;
+    }
+    if (__atomic_load_n(&(*sync)->magic, __ATOMIC_ACQUIRE) != PYTHON_BLOCK_SYNC_MAGIC)
+    {
+        LOG_ERROR("[Python loader] Invalid exchange header for %s", shm_name);
+        munmap(*sync, sizeof(python_block_sync_t));
+        *sync = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void python_block_inputs_begin(python_block_sync_t *sync)
+{
+    uint32_t seq = __atomic_load_n(&sync->in_seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&sync->in_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+uint32_t python_block_inputs_publish(python_block_sync_t *sync)
+{
+    uint32_t seq = __atomic_load_n(&sync->in_seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&sync->in_seq, seq + 1, __ATOMIC_RELEASE);
+    uint32_t request = __atomic_add_fetch(&sync->request, 1, __ATOMIC_SEQ_CST);
+
+#if defined(__linux__)
+    // Shared (not FUTEX_PRIVATE) wake: the waiter is another process. Does not block.
+    syscall(SYS_futex, &sync->request, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+    return request;
+}
+
+int python_block_outputs_read(python_block_sync_t *sync, const void *shm_out, void *dest,
+                              size_t size)
+{
+    uint32_t request = __atomic_load_n(&sync->request, __ATOMIC_RELAXED);
+    if (request == 0)
+    {
+        return 0; // Nothing asked yet
+    }
+
+    // Copied aside first, dest only receives outputs the seqlock vouched for.
+    // Per thread, blocks run on the scan and task threads; grown once per size.
+    static __thread unsigned char *scratch = NULL;
+    static __thread size_t scratch_size    = 0;
+    if (size > scratch_size)
+    {
+        unsigned char *grown = realloc(scratch, size);
+        if (grown == NULL)
+        {
+            __atomic_add_fetch(&sync->late, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        scratch      = grown;
+        scratch_size = size;
+    }
+
+    if (__atomic_load_n(&sync->response, __ATOMIC_ACQUIRE) == request)
+    {
+        uint32_t seq = __atomic_load_n(&sync->out_seq, __ATOMIC_ACQUIRE);
+        if ((seq & 1u) == 0)
+        {
+            memcpy(scratch, shm_out, size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&sync->out_seq, __ATOMIC_RELAXED) == seq)
+            {
+                memcpy(dest, scratch, size);
+                return 1;
+            }
+        }
+    }
+
+    __atomic_add_fetch(&sync->late, 1, __ATOMIC_RELAXED);
+    return 0;
+}
@@ -0,0 +1,839 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "image_tables.h"
+#include "journal_buffer.h"
+#include "retain_memory.h"
+#include "utils/log.h"
+
+#define RETAIN_MAGIC "OPLCRTN"
+#define RETAIN_VERSION 1
+
+// First page of each slot. The slot is valid when both CRCs match.
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t table_size;
+    uint64_t sequence;
+    uint32_t data_size;
+    uint32_t data_crc;
+    uint32_t header_crc; // over the fields above
+} retain_header_t;
+
+static char *retain_path        = NULL;
+static size_t checkpoint_ms     = RETAIN_DEFAULT_INTERVAL_MS;
+static bool enabled             = false;
+static uint32_t crc_table[256];
+
+// Mapping of the whole file: slot 0, then slot 1
+static uint8_t *map      = NULL;
+static size_t map_size   = 0;
+static size_t page_size  = 0;
+static size_t slot_size  = 0;
+static size_t table_size = 0;
+
+// Packed copy of the areas, laid out like a slot's data: lint_memory, then
+// dint_memory, then int_memory, each table_size elements
+static uint8_t *staging   = NULL;
+static size_t data_size   = 0;
+static size_t lint_offset = 0;
+static size_t dint_offset = 0;
+static size_t int_offset  = 0;
+
+// Per slot, bit p set: data page p changed since the slot was last written
+static uint64_t *dirty[2] = {NULL, NULL};
+static size_t page_count  = 0;
+static size_t dirty_words = 0;
+
+// Set by a scan that changed a value, cleared by the next checkpoint
+static bool changed = false;
+
+// Areas in staging order, the order of the arrays below
+enum
+{
+    AREA_LINT,
+    AREA_DINT,
+    AREA_INT,
+    AREA_COUNT
+};
+
+static const journal_buffer_type_t area_types[AREA_COUNT] = {
+    JOURNAL_LINT_MEMORY, JOURNAL_DINT_MEMORY, JOURNAL_INT_MEMORY};
+
+// Indexes the program bound, the only ones the program itself can change.
+// bound_all: they are not recorded (yet), every index of the area is compared.
+static uint32_t *bound[AREA_COUNT];
+static size_t bound_count[AREA_COUNT];
+static size_t bound_capacity[AREA_COUNT];
+static bool bound_all[AREA_COUNT];
+
+// Indexes journal writes changed since the last capture, which also reach
+// entries no program variable is bound to
+static journal_write_map_t written[AREA_COUNT];
+
+// The next capture compares every index, set when the bindings changed
+static bool capture_all = true;
+
+// staging holds values to restore: loaded from the file or captured.
+// Indexes from restore_count on were not in the file's layout and keep their
+// initial values.
+static bool have_data       = false;
+static size_t restore_count = 0;
+
+// Guards staging and dirty between the scan thread and checkpoints
+static pthread_mutex_t staging_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Serializes checkpoints of the writer thread and retain_flush()
+static pthread_mutex_t checkpoint_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int next_slot                    = 0;
+static uint64_t next_sequence           = 1;
+static bool write_failed                = false;
+
+static pthread_t writer_thread;
+static bool writer_running           = false;
+static bool writer_stop              = false;
+static pthread_mutex_t writer_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_wake    = PTHREAD_COND_INITIALIZER;
+
+static void crc_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+}
+
+static uint32_t crc32(const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    uint32_t crc     = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static uint8_t *slot_base(int slot)
+{
+    return map + (size_t)slot * slot_size;
+}
+
+static uint8_t *slot_data(int slot)
+{
+    return slot_base(slot) + page_size;
+}
+
+static void mark_all_dirty(int slot)
+{
+    memset(dirty[slot], 0xFF, dirty_words * sizeof(uint64_t));
+}
+
+// The header fields of a slot, or NULL if the slot does not hold valid data
+static const retain_header_t *slot_valid(int slot)
+{
+    const retain_header_t *header = (const retain_header_t *)slot_base(slot);
+    if (memcmp(header->magic, RETAIN_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != RETAIN_VERSION || header->table_size != table_size ||
+        header->data_size != data_size ||
+        header->header_crc != crc32(header, offsetof(retain_header_t, header_crc)) ||
+        header->data_crc != crc32(slot_data(slot), data_size))
+    {
+        return NULL;
+    }
+    return header;
+}
+
+#define CAPTURE_ENTRY(type, table, offset, i)                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        type value   = (table)[i] ? *(table)[i] : 0;                                               \
+        type *staged = &((type *)(staging + (offset)))[i];                                         \
+        if (*staged != value)                                                                      \
+        {                                                                                          \
+            *staged     = value;                                                                   \
+            size_t page = ((offset) + (i) * sizeof(type)) / page_size;                             \
+            dirty[0][page / 64] |= 1ULL << (page % 64);                                            \
+            dirty[1][page / 64] |= 1ULL << (page % 64);                                            \
+            changed = true;                                                                        \
+        }                                                                                          \
+    } while (0)
+
+static void capture_area(int area, size_t i)
+{
+    switch (area)
+    {
+        case AREA_LINT:
+            CAPTURE_ENTRY(IEC_ULINT, lint_memory, lint_offset, i);
+            break;
+        case AREA_DINT:
+            CAPTURE_ENTRY(IEC_UDINT, dint_memory, dint_offset, i);
+            break;
+        default:
+            CAPTURE_ENTRY(IEC_UINT, int_memory, int_offset, i);
+            break;
+    }
+}
+
+// Capture the indexes set in an area's write map and clear them
+static void capture_written(int area)
+{
+    journal_write_map_t *map = &written[area];
+    size_t summary_words     = (table_size + 4095) / 4096;
+    for (size_t s = 0; s < summary_words; s++)
+    {
+        uint64_t words = map->summary[s];
+        map->summary[s] = 0;
+        while (words != 0)
+        {
+            size_t w = s * 64 + (size_t)__builtin_ctzll(words);
+            words &= words - 1;
+
+            uint64_t bits = map->bits[w];
+            map->bits[w]  = 0;
+            while (bits != 0)
+            {
+                capture_area(area, w * 64 + (size_t)__builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+static void clear_written(void)
+{
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        memset(written[area].bits, 0, (table_size + 63) / 64 * sizeof(uint64_t));
+        memset(written[area].summary, 0, (table_size + 4095) / 4096 * sizeof(uint64_t));
+    }
+}
+
+// staging_mutex and buffer_mutex held. Only the bound indexes and the ones
+// the journal wrote can have changed since the last capture, so the cost
+// follows the program, not the image table size.
+static void capture_locked(void)
+{
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        if (capture_all || bound_all[area])
+        {
+            for (size_t i = 0; i < table_size; i++)
+            {
+                capture_area(area, i);
+            }
+        }
+        else
+        {
+            for (size_t k = 0; k < bound_count[area]; k++)
+            {
+                capture_area(area, bound[area][k]);
+            }
+            capture_written(area);
+        }
+    }
+    if (capture_all)
+    {
+        clear_written();
+        capture_all = false;
+    }
+    have_data     = true;
+    restore_count = table_size;
+}
+
+// Record the indexes the program bound, buffer_mutex held
+static void collect_bound(void)
+{
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        size_t count = image_tables_bound_slots((uint32_t)area_types[area], NULL, 0);
+        if (count > bound_capacity[area])
+        {
+            uint32_t *larger = realloc(bound[area], count * sizeof(uint32_t));
+            if (larger == NULL)
+            {
+                log_error("Retain: out of memory recording the bound memory, comparing all of it");
+                bound_count[area] = 0;
+                bound_all[area]   = true;
+                continue;
+            }
+            bound[area]          = larger;
+            bound_capacity[area] = count;
+        }
+        bound_count[area] = image_tables_bound_slots((uint32_t)area_types[area], bound[area], count);
+        bound_all[area]   = false;
+    }
+}
+
+// Write the pages changed since the target slot was last written, then its
+// header. The other slot is not touched, so it stays valid until this one is.
+static void checkpoint(void)
+{
+    pthread_mutex_lock(&checkpoint_mutex);
+    int slot      = next_slot;
+    uint8_t *data = slot_data(slot);
+
+    pthread_mutex_lock(&staging_mutex);
+    if (!changed)
+    {
+        pthread_mutex_unlock(&staging_mutex);
+        pthread_mutex_unlock(&checkpoint_mutex);
+        return;
+    }
+    changed = false;
+    for (size_t p = 0; p < page_count; p++)
+    {
+        if (dirty[slot][p / 64] & (1ULL << (p % 64)))
+        {
+            size_t offset = p * page_size;
+            size_t length = data_size - offset < page_size ? data_size - offset : page_size;
+            memcpy(data + offset, staging + offset, length);
+        }
+    }
+    memset(dirty[slot], 0, dirty_words * sizeof(uint64_t));
+    pthread_mutex_unlock(&staging_mutex);
+
+    // Only the writer touches the slot, the CRC and syncs run unlocked
+    retain_header_t header = {0};
+    memcpy(header.magic, RETAIN_MAGIC, sizeof(header.magic));
+    header.version    = RETAIN_VERSION;
+    header.table_size = (uint32_t)table_size;
+    header.sequence   = next_sequence;
+    header.data_size  = (uint32_t)data_size;
+    header.data_crc   = crc32(data, data_size);
+    header.header_crc = crc32(&header, offsetof(retain_header_t, header_crc));
+
+    int result = msync(data, slot_size - page_size, MS_SYNC);
+    if (result == 0)
+    {
+        memcpy(slot_base(slot), &header, sizeof(header));
+        result = msync(slot_base(slot), page_size, MS_SYNC);
+    }
+
+    if (result != 0)
+    {
+        // Write the whole slot again on the next checkpoint
+        if (!write_failed)
+        {
+            log_error("Retain: failed to write %s: %s", retain_path, strerror(errno));
+            write_failed = true;
+        }
+        pthread_mutex_lock(&staging_mutex);
+        mark_all_dirty(slot);
+        changed = true;
+        pthread_mutex_unlock(&staging_mutex);
+    }
+    else
+    {
+        if (write_failed)
+        {
+            log_info("Retain: writing %s again", retain_path);
+            write_failed = false;
+        }
+        next_sequence++;
+        next_slot = 1 - slot;
+    }
+    pthread_mutex_unlock(&checkpoint_mutex);
+}
+
+static void *writer_main(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&writer_mutex);
+    while (!writer_stop)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)(checkpoint_ms / 1000);
+        deadline.tv_nsec += (long)(checkpoint_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&writer_wake, &writer_mutex, &deadline);
+
+        pthread_mutex_unlock(&writer_mutex);
+        checkpoint();
+        pthread_mutex_lock(&writer_mutex);
+    }
+    pthread_mutex_unlock(&writer_mutex);
+    return NULL;
+}
+
+// Load the newest valid slot of the mapping into staging, false if none
+static bool load_current(void)
+{
+    const retain_header_t *headers[2] = {slot_valid(0), slot_valid(1)};
+    int current                       = -1;
+    if (headers[0] != NULL && (headers[1] == NULL || headers[0]->sequence > headers[1]->sequence))
+    {
+        current = 0;
+    }
+    else if (headers[1] != NULL)
+    {
+        current = 1;
+    }
+    if (current < 0)
+    {
+        return false;
+    }
+
+    // The other slot is older or torn: rewrite it completely next
+    memcpy(staging, slot_data(current), data_size);
+    have_data     = true;
+    restore_count = table_size;
+    next_sequence = headers[current]->sequence + 1;
+    next_slot     = 1 - current;
+    mark_all_dirty(next_slot);
+    log_info("Retain: restored memory from %s (checkpoint %llu)", retain_path,
+             (unsigned long long)headers[current]->sequence);
+    return true;
+}
+
+// Read the newest valid slot of a file written with another table size and
+// copy the indexes both layouts have into staging. Returns 1 when data was
+// loaded, 0 when the file holds no valid slot, -1 on a read error.
+static int load_other_layout(int fd, size_t file_bytes)
+{
+    size_t old_slot_size = file_bytes / 2;
+    retain_header_t newest = {0};
+    uint8_t *newest_data   = NULL;
+
+    for (int slot = 0; slot < 2; slot++)
+    {
+        off_t base = (off_t)((size_t)slot * old_slot_size);
+        retain_header_t header;
+        if (pread(fd, &header, sizeof(header), base) != (ssize_t)sizeof(header))
+        {
+            free(newest_data);
+            return -1;
+        }
+
+        size_t old_data = (size_t)header.table_size *
+                          (sizeof(IEC_ULINT) + sizeof(IEC_UDINT) + sizeof(IEC_UINT));
+        if (memcmp(header.magic, RETAIN_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != RETAIN_VERSION ||
+            header.header_crc != crc32(&header, offsetof(retain_header_t, header_crc)) ||
+            header.data_size != old_data ||
+            page_size + (old_data + page_size - 1) / page_size * page_size != old_slot_size ||
+            (newest_data != NULL && header.sequence <= newest.sequence))
+        {
+            continue;
+        }
+
+        uint8_t *data = malloc(old_data > 0 ? old_data : 1);
+        if (data == NULL)
+        {
+            free(newest_data);
+            return -1;
+        }
+        if (pread(fd, data, old_data, base + (off_t)page_size) != (ssize_t)old_data)
+        {
+            free(data);
+            free(newest_data);
+            return -1;
+        }
+        if (header.data_crc != crc32(data, old_data))
+        {
+            free(data);
+            continue;
+        }
+        free(newest_data);
+        newest_data = data;
+        newest      = header;
+    }
+
+    if (newest_data == NULL)
+    {
+        return 0;
+    }
+
+    size_t old_size = newest.table_size;
+    size_t count    = old_size < table_size ? old_size : table_size;
+    memcpy(staging + lint_offset, newest_data, count * sizeof(IEC_ULINT));
+    memcpy(staging + dint_offset, newest_data + old_size * sizeof(IEC_ULINT),
+           count * sizeof(IEC_UDINT));
+    memcpy(staging + int_offset,
+           newest_data + old_size * (sizeof(IEC_ULINT) + sizeof(IEC_UDINT)),
+           count * sizeof(IEC_UINT));
+    free(newest_data);
+
+    have_data     = true;
+    restore_count = count;
+    next_sequence = newest.sequence + 1;
+    log_info("Retain: migrating %s from %zu to %zu indexes per area (checkpoint %llu)",
+             retain_path, old_size, table_size, (unsigned long long)newest.sequence);
+    return 1;
+}
+
+// Write the migrated staging to a new file in this layout and replace the
+// old file with it, so a crash before the rename keeps the old one
+static int replace_file(void)
+{
+    size_t file_size = 2 * slot_size;
+    size_t length    = strlen(retain_path) + sizeof(".new");
+    char *new_path   = malloc(length);
+    if (new_path == NULL)
+    {
+        log_error("Retain: out of memory");
+        return -1;
+    }
+    snprintf(new_path, length, "%s.new", retain_path);
+
+    int fd = open(new_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)file_size) != 0)
+    {
+        log_error("Retain: failed to create %s: %s", new_path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(new_path);
+        }
+        free(new_path);
+        return -1;
+    }
+    void *addr = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        log_error("Retain: failed to map %s: %s", new_path, strerror(errno));
+        unlink(new_path);
+        free(new_path);
+        return -1;
+    }
+    map      = addr;
+    map_size = file_size;
+
+    next_slot = 0;
+    mark_all_dirty(0);
+    mark_all_dirty(1);
+    changed = true;
+    checkpoint();
+
+    if (write_failed || rename(new_path, retain_path) != 0)
+    {
+        log_error("Retain: failed to replace %s, keeping it", retain_path);
+        munmap(map, map_size);
+        map = NULL;
+        unlink(new_path);
+        free(new_path);
+        return -1;
+    }
+    free(new_path);
+    return 0;
+}
+
+// Size or create the file and map it, load the newest valid slot. A file
+// written with another table size is migrated; when its data cannot be read
+// the file is kept and retain does not start.
+static int map_file(void)
+{
+    size_t file_size = 2 * slot_size;
+
+    int fd = open(retain_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        log_error("Retain: failed to open %s: %s", retain_path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        log_error("Retain: failed to stat %s: %s", retain_path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0 && ftruncate(fd, (off_t)file_size) != 0)
+    {
+        log_error("Retain: failed to size %s: %s", retain_path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (st.st_size == 0 || (size_t)st.st_size == file_size)
+    {
+        void *addr = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            log_error("Retain: failed to map %s: %s", retain_path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        map      = addr;
+        map_size = file_size;
+
+        if (st.st_size == 0 || load_current())
+        {
+            close(fd);
+            if (!have_data)
+            {
+                mark_all_dirty(0);
+                mark_all_dirty(1);
+            }
+            return 0;
+        }
+    }
+
+    // Another layout, or no valid slot of this one
+    int loaded = load_other_layout(fd, (size_t)st.st_size);
+    close(fd);
+    if (loaded > 0)
+    {
+        if (map != NULL)
+        {
+            munmap(map, map_size);
+            map = NULL;
+        }
+        return replace_file();
+    }
+    if (loaded == 0 && map != NULL)
+    {
+        log_warn("Retain: no valid data in %s, starting with empty memory", retain_path);
+        mark_all_dirty(0);
+        mark_all_dirty(1);
+        return 0;
+    }
+
+    log_error("Retain: %s has another layout and no data that can be read, keeping it",
+              retain_path);
+    return -1;
+}
+
+static void release(void)
+{
+    if (map != NULL)
+    {
+        munmap(map, map_size);
+        map = NULL;
+    }
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        journal_track_writes(area_types[area], NULL);
+        free(bound[area]);
+        free(written[area].bits);
+        free(written[area].summary);
+        bound[area]          = NULL;
+        bound_count[area]    = 0;
+        bound_capacity[area] = 0;
+        bound_all[area]      = false;
+        written[area].bits    = NULL;
+        written[area].summary = NULL;
+    }
+    free(staging);
+    free(dirty[0]);
+    free(dirty[1]);
+    staging  = NULL;
+    dirty[0] = NULL;
+    dirty[1] = NULL;
+}
+
+int retain_set_file(const char *path)
+{
+    if (path == NULL || path[0] == '\0')
+    {
+        return -1;
+    }
+    char *copy = strdup(path);
+    if (copy == NULL)
+    {
+        return -1;
+    }
+    free(retain_path);
+    retain_path = copy;
+    return 0;
+}
+
+int retain_set_interval(size_t interval_ms)
+{
+    if (interval_ms < RETAIN_MIN_INTERVAL_MS || interval_ms > RETAIN_MAX_INTERVAL_MS)
+    {
+        return -1;
+    }
+    checkpoint_ms = interval_ms;
+    return 0;
+}
+
+int retain_init(void)
+{
+    if (retain_path == NULL || enabled)
+    {
+        return 0;
+    }
+
+    crc_init();
+    long system_page = sysconf(_SC_PAGESIZE);
+    page_size        = system_page > 0 ? (size_t)system_page : 4096;
+    table_size       = image_tables_size();
+
+    lint_offset = 0;
+    dint_offset = lint_offset + table_size * sizeof(IEC_ULINT);
+    int_offset  = dint_offset + table_size * sizeof(IEC_UDINT);
+    data_size   = int_offset + table_size * sizeof(IEC_UINT);
+    page_count  = (data_size + page_size - 1) / page_size;
+    dirty_words = (page_count + 63) / 64;
+    slot_size   = page_size + page_count * page_size;
+
+    staging  = calloc(1, data_size);
+    dirty[0] = calloc(dirty_words, sizeof(uint64_t));
+    dirty[1] = calloc(dirty_words, sizeof(uint64_t));
+    bool allocated = staging != NULL && dirty[0] != NULL && dirty[1] != NULL;
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        written[area].bits    = calloc((table_size + 63) / 64, sizeof(uint64_t));
+        written[area].summary = calloc((table_size + 4095) / 4096, sizeof(uint64_t));
+        allocated = allocated && written[area].bits != NULL && written[area].summary != NULL;
+    }
+    if (!allocated)
+    {
+        log_error("Retain: out of memory");
+        release();
+        return -1;
+    }
+
+    // Nothing of a previous retain_init() carries over to this file
+    have_data     = false;
+    restore_count = 0;
+    changed       = false;
+    capture_all   = true;
+    next_slot     = 0;
+    next_sequence = 1;
+    write_failed  = false;
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        bound_all[area] = true;
+    }
+
+    if (map_file() != 0)
+    {
+        release();
+        return -1;
+    }
+
+    writer_stop = false;
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0)
+    {
+        log_error("Retain: failed to create the writer thread");
+        release();
+        return -1;
+    }
+    writer_running = true;
+    enabled        = true;
+
+    for (int area = 0; area < AREA_COUNT; area++)
+    {
+        journal_track_writes(area_types[area], &written[area]);
+    }
+
+    log_info("Retain: %%MW, %%MD and %%ML kept in %s, written every %zu ms", retain_path,
+             checkpoint_ms);
+    return 0;
+}
+
+#define RESTORE_TABLE(type, table, offset)                                                         \
+    for (size_t i = 0; i < restore_count; i++)                                                     \
+    {                                                                                              \
+        if ((table)[i])                                                                            \
+        {                                                                                          \
+            *(table)[i] = ((const type *)(staging + (offset)))[i];                                 \
+        }                                                                                          \
+    }
+
+void retain_restore(void)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&staging_mutex);
+    if (have_data)
+    {
+        RESTORE_TABLE(IEC_ULINT, lint_memory, lint_offset);
+        RESTORE_TABLE(IEC_UDINT, dint_memory, dint_offset);
+        RESTORE_TABLE(IEC_UINT, int_memory, int_offset);
+    }
+    // Every entry now holds its staged value, only the program's can move
+    collect_bound();
+    pthread_mutex_unlock(&staging_mutex);
+}
+
+void retain_rebind(void)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&staging_mutex);
+    collect_bound();
+    // Entries the previous program left were cleared, record that once
+    capture_all = true;
+    pthread_mutex_unlock(&staging_mutex);
+}
+
+void retain_capture(void)
+{
+    if (!enabled || pthread_mutex_trylock(&staging_mutex) != 0)
+    {
+        return;
+    }
+    capture_locked();
+    pthread_mutex_unlock(&staging_mutex);
+}
+
+void retain_flush(void)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&staging_mutex);
+    capture_locked();
+    pthread_mutex_unlock(&staging_mutex);
+    checkpoint();
+}
+
+void retain_shutdown(void)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    if (writer_running)
+    {
+        pthread_mutex_lock(&writer_mutex);
+        writer_stop = true;
+        pthread_cond_signal(&writer_wake);
+        pthread_mutex_unlock(&writer_mutex);
+        pthread_join(writer_thread, NULL);
+        writer_running = false;
+    }
+
+    // Values captured since the last checkpoint
+    checkpoint();
+
+    enabled = false;
+    release();
+}
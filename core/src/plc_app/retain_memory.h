@@ -0,0 +1,107 @@
+#ifndef RETAIN_MEMORY_H
+#define RETAIN_MEMORY_H
+
+#include <stddef.h>
+
+/**
+ * @file retain_memory.h
+ * @brief Persistent %MW, %MD and %ML memory
+ *
+ * The memory areas (int_memory, dint_memory and lint_memory) are kept in a
+ * memory-mapped file so they survive restarts and power loss.
+ *
+ * At the end of every scan the scan thread compares the entries the program
+ * bound, and the ones journal writes reached since the last scan, with a
+ * packed staging copy and marks the pages that changed. A writer thread
+ * copies the changed pages into the file every interval and syncs them, so
+ * the scan only pays for the comparison of the program's own memory and the
+ * disk is written only where values changed.
+ *
+ * The file holds two slots, each a header page followed by the packed areas.
+ * Checkpoints alternate between them and a slot's header, with the sequence
+ * number and a CRC of its data, is only written once its data is on disk. A
+ * checkpoint interrupted by a crash therefore leaves the other slot intact,
+ * and the newest slot whose CRC matches is restored on the next start.
+ */
+
+#define RETAIN_DEFAULT_INTERVAL_MS 100
+#define RETAIN_MIN_INTERVAL_MS 10
+#define RETAIN_MAX_INTERVAL_MS 60000
+
+/**
+ * @brief Keep the memory areas in a file
+ *
+ * Retain is disabled unless a file is set. Call before retain_init().
+ *
+ * @param path File to map, created if missing
+ * @return 0 on success, -1 if path is empty
+ */
+int retain_set_file(const char *path);
+
+/**
+ * @brief Set the time between two checkpoints
+ *
+ * This bounds how many scans of changes a power loss can lose. Call before
+ * retain_init().
+ *
+ * @param interval_ms RETAIN_MIN_INTERVAL_MS to RETAIN_MAX_INTERVAL_MS
+ * @return 0 on success, -1 if out of range
+ */
+int retain_set_interval(size_t interval_ms);
+
+/**
+ * @brief Map the retain file and start the writer thread
+ *
+ * Call after image_tables_init(). Loads the newest valid slot, which the next
+ * retain_restore() writes into the areas. A file written with another image
+ * table size is migrated: the indexes both sizes have are kept, and the file
+ * is replaced by one in the new layout. When no slot of such a file can be
+ * read, the file is left as it is and -1 is returned. Does nothing if no
+ * file was set.
+ *
+ * @return 0 on success or when disabled, -1 on error
+ */
+int retain_init(void);
+
+/**
+ * @brief Write the retained values into the memory areas
+ *
+ * Called by the scan thread once the program is initialized and glued, with
+ * buffer_mutex held, so retained values replace the initial ones. Records
+ * the entries the program bound for retain_capture().
+ */
+void retain_restore(void);
+
+/**
+ * @brief Record the entries a new program bound
+ *
+ * Called with buffer_mutex held after an online change installed the new
+ * program's pointers. The next retain_capture() compares all entries once,
+ * so the ones the previous program released are recorded as well.
+ */
+void retain_rebind(void);
+
+/**
+ * @brief Record the memory areas after a scan
+ *
+ * Called by the scan thread at the end of every scan with buffer_mutex held.
+ * Never blocks: while a checkpoint is copying pages the scan is skipped and
+ * its changes are picked up by the next one.
+ */
+void retain_capture(void);
+
+/**
+ * @brief Record the memory areas and write them to disk now
+ *
+ * Called after the scan thread stopped, with buffer_mutex held and before the
+ * program's variables are unbound, so the last scans are not lost. Blocks
+ * until the data is synced.
+ */
+void retain_flush(void);
+
+/**
+ * @brief Stop the writer thread, write the last checkpoint and unmap the file
+ */
+void retain_shutdown(void);
+
+#endif // RETAIN_MEMORY_H
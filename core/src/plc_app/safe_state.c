@@ -0,0 +1,299 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../drivers/plugin_driver.h"
+#include "image_shadow.h"
+#include "image_tables.h"
+#include "journal_buffer.h"
+#include "plc_state_manager.h"
+#include "safe_state.h"
+#include "utils/log.h"
+#include "utils/utils.h"
+
+// How long safe_state_apply() waits for the scan lock before writing anyway
+#define SAFE_STATE_LOCK_WAIT_MS 5
+
+#define SAFE_STATE_LINE_MAX 128
+
+typedef struct
+{
+    journal_buffer_type_t type;
+    uint32_t index;
+    uint8_t bit;
+    uint64_t value;
+} safe_output_t;
+
+extern plugin_driver_t *plugin_driver;
+
+static safe_output_t outputs[SAFE_STATE_MAX_OUTPUTS];
+static size_t output_count         = 0;
+static unsigned long overrun_slots = 0;
+
+// Safe output image, one entry per image table index (8 bits per entry for
+// BOOL). NULL when no value is configured: every output is then 0.
+static uint8_t *safe_bool  = NULL;
+static uint8_t *safe_byte  = NULL;
+static uint16_t *safe_int  = NULL;
+static uint32_t *safe_dint = NULL;
+static uint64_t *safe_lint = NULL;
+
+// Parse VALUE for an output `bits` wide, negative values as two's complement
+static int parse_value(const char *text, unsigned bits, uint64_t *value)
+{
+    char *end;
+    errno = 0;
+    if (text[0] == '-')
+    {
+        long long number = strtoll(text, &end, 0);
+        if (errno != 0 || end == text || *end != '\0' || bits == 1 ||
+            (bits < 64 && number < -(1ll << (bits - 1))))
+        {
+            return -1;
+        }
+        *value = (uint64_t)number & (bits < 64 ? (1ull << bits) - 1 : ~0ull);
+        return 0;
+    }
+
+    unsigned long long number = strtoull(text, &end, 0);
+    if (errno != 0 || end == text || *end != '\0' || (bits < 64 && number >> bits != 0))
+    {
+        return -1;
+    }
+    *value = number;
+    return 0;
+}
+
+int safe_state_add(const char *text)
+{
+    if (output_count >= SAFE_STATE_MAX_OUTPUTS)
+    {
+        return -1;
+    }
+
+    const char *equals = strchr(text, '=');
+    if (equals == NULL)
+    {
+        return -1;
+    }
+
+    safe_output_t *output = &outputs[output_count];
+    if (journal_parse_address(text, (size_t)(equals - text), &output->type, &output->index,
+                              &output->bit) != 0)
+    {
+        return -1;
+    }
+
+    unsigned bits;
+    switch (output->type)
+    {
+    case JOURNAL_BOOL_OUTPUT:
+        bits = 1;
+        break;
+    case JOURNAL_BYTE_OUTPUT:
+    case JOURNAL_INT_OUTPUT:
+    case JOURNAL_DINT_OUTPUT:
+    case JOURNAL_LINT_OUTPUT:
+        bits = (unsigned)journal_type_width(output->type) * 8;
+        break;
+    default:
+        return -1; // Inputs and memory have no safe value
+    }
+
+    if (parse_value(equals + 1, bits, &output->value) != 0)
+    {
+        return -1;
+    }
+    output_count++;
+    return 0;
+}
+
+int safe_state_load_file(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Cannot open safe output file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char line[SAFE_STATE_LINE_MAX];
+    int number = 0;
+    int result = 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        number++;
+        char *start = line + strspn(line, " \t");
+        start[strcspn(start, " \t\r\n")] = '\0';
+        if (start[0] == '\0' || start[0] == '#')
+        {
+            continue;
+        }
+        if (safe_state_add(start) != 0)
+        {
+            fprintf(stderr, "%s:%d: invalid safe output: %s\n", path, number, start);
+            result = -1;
+            break;
+        }
+    }
+
+    fclose(fp);
+    return result;
+}
+
+int safe_state_set_overrun(unsigned long slots)
+{
+    if (slots > SAFE_STATE_MAX_OVERRUN)
+    {
+        return -1;
+    }
+    overrun_slots = slots;
+    return 0;
+}
+
+bool safe_state_overrun(uint64_t skipped)
+{
+    return overrun_slots > 0 && skipped >= overrun_slots;
+}
+
+int safe_state_init(void)
+{
+    if (output_count == 0)
+    {
+        return 0;
+    }
+
+    size_t size = image_tables_size();
+    for (size_t i = 0; i < output_count; i++)
+    {
+        if (outputs[i].index >= size)
+        {
+            log_error("Safe output index %u is outside the image tables (%zu indexes)",
+                      outputs[i].index, size);
+            return -1;
+        }
+    }
+
+    safe_bool = calloc(size, sizeof(*safe_bool));
+    safe_byte = calloc(size, sizeof(*safe_byte));
+    safe_int  = calloc(size, sizeof(*safe_int));
+    safe_dint = calloc(size, sizeof(*safe_dint));
+    safe_lint = calloc(size, sizeof(*safe_lint));
+    if (!safe_bool || !safe_byte || !safe_int || !safe_dint || !safe_lint)
+    {
+        log_error("Failed to allocate the safe output image");
+        return -1;
+    }
+
+    // Later values for the same address win
+    for (size_t i = 0; i < output_count; i++)
+    {
+        const safe_output_t *output = &outputs[i];
+        switch (output->type)
+        {
+        case JOURNAL_BOOL_OUTPUT:
+            safe_bool[output->index] &= (uint8_t) ~(1u << output->bit);
+            safe_bool[output->index] |= (uint8_t)(output->value << output->bit);
+            break;
+        case JOURNAL_BYTE_OUTPUT:
+            safe_byte[output->index] = (uint8_t)output->value;
+            break;
+        case JOURNAL_INT_OUTPUT:
+            safe_int[output->index] = (uint16_t)output->value;
+            break;
+        case JOURNAL_DINT_OUTPUT:
+            safe_dint[output->index] = (uint32_t)output->value;
+            break;
+        default:
+            safe_lint[output->index] = output->value;
+            break;
+        }
+    }
+
+    log_info("Safe output image: %zu values set, other outputs 0", output_count);
+    return 0;
+}
+
+void safe_state_apply(bool locked)
+{
+    if (bool_output == NULL)
+    {
+        return; // No image tables yet
+    }
+
+    // The scan thread may be stuck holding the lock, take it only if it comes quickly
+    bool taken = false;
+    if (!locked && plugin_driver != NULL)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += SAFE_STATE_LOCK_WAIT_MS * 1000000L;
+        normalize_timespec(&deadline);
+        taken = pthread_mutex_timedlock(&plugin_driver->buffer_mutex, &deadline) == 0;
+    }
+
+    // One pass over the bound outputs
+    bool values = safe_bool != NULL;
+    size_t size = image_tables_size();
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t bits = values ? safe_bool[i] : 0;
+        for (int b = 0; b < 8; b++)
+        {
+            if (bool_output[i][b] != NULL)
+            {
+                *bool_output[i][b] = (bits >> b) & 1;
+            }
+        }
+        if (byte_output[i] != NULL)
+        {
+            *byte_output[i] = values ? safe_byte[i] : 0;
+        }
+        if (int_output[i] != NULL)
+        {
+            *int_output[i] = values ? safe_int[i] : 0;
+        }
+        if (dint_output[i] != NULL)
+        {
+            *dint_output[i] = values ? safe_dint[i] : 0;
+        }
+        if (lint_output[i] != NULL)
+        {
+            *lint_output[i] = values ? safe_lint[i] : 0;
+        }
+    }
+
+    if (!locked && !taken)
+    {
+        // Without the lock a resumed scan could sync the shadow or run the hooks
+        // at the same time, so plugins reading the shadow keep the last scan's outputs
+        if (plugin_driver != NULL)
+        {
+            log_error("[SAFE STATE] Scan lock not available, only the image tables were "
+                      "forced to the safe values");
+        }
+        return;
+    }
+
+    // Plugins reading outputs from the shadow (snapshots, changes, image areas)
+    // see the safe values too, no scan will refresh it in ERROR
+    image_shadow_sync();
+
+    // Write them out now instead of at the end of a scan that may never come
+    plugin_driver_push_outputs(plugin_driver);
+
+    if (taken)
+    {
+        pthread_mutex_unlock(&plugin_driver->buffer_mutex);
+    }
+}
+
+void safe_state_enter(const char *reason, bool locked)
+{
+    safe_state_apply(locked);
+    plc_set_state(PLC_STATE_ERROR);
+    log_error("[SAFE STATE] %s: outputs set to their safe values", reason);
+    log_info("PLC State: ERROR");
+}
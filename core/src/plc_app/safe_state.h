@@ -0,0 +1,89 @@
+#ifndef SAFE_STATE_H
+#define SAFE_STATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file safe_state.h
+ * @brief Safe output values applied when the scan faults
+ *
+ * When the watchdog fires with --watchdog-action safe-state, or a cycle
+ * overruns by --safe-state-overrun slots or more, the runtime writes the safe
+ * output image to every bound output in one pass and calls the inline
+ * cycle_end hooks of the native plugins, so the values reach the devices
+ * without waiting for (or running) the program. The PLC is then put in ERROR.
+ *
+ * Outputs default to 0; --safe-output and --safe-output-file set other values
+ * per address. The image is precomputed by safe_state_init(), applying it does
+ * no parsing or lookups.
+ */
+
+#define SAFE_STATE_MAX_OUTPUTS 4096
+#define SAFE_STATE_MAX_OVERRUN 100000
+
+/**
+ * @brief Set the safe value of one output
+ *
+ * @param text "ADDRESS=VALUE", ADDRESS an output (%QX0.3, %QB1, %QW2, %QD4,
+ *             %QL8), VALUE decimal or 0x hex and in range for the size
+ * @return 0 on success, -1 if the text is invalid or too many outputs are set
+ */
+int safe_state_add(const char *text);
+
+/**
+ * @brief Read safe values from a file, one "ADDRESS=VALUE" per line
+ *
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * @return 0 on success, -1 if the file cannot be read or a line is invalid
+ *         (the line is reported on stderr)
+ */
+int safe_state_load_file(const char *path);
+
+/**
+ * @brief Enter the safe state when one overrun skips this many slots
+ *
+ * @param slots 1 to SAFE_STATE_MAX_OVERRUN, 0 turns it off (the default)
+ * @return 0 on success, -1 if out of range
+ */
+int safe_state_set_overrun(unsigned long slots);
+
+/**
+ * @brief Whether an overrun that skipped `skipped` slots enters the safe state
+ */
+bool safe_state_overrun(uint64_t skipped);
+
+/**
+ * @brief Build the safe output image
+ *
+ * Call after image_tables_init(), the addresses are checked against the
+ * image table size.
+ *
+ * @return 0 on success, -1 if an address is out of range or allocation fails
+ */
+int safe_state_init(void);
+
+/**
+ * @brief Write the safe output image and push it through the native plugins
+ *
+ * Safe from any thread. Without `locked` the scan lock is waited on for a
+ * bounded time only, since the scan thread may be stuck holding it; the
+ * image tables are written either way. With the lock the image shadow is
+ * refreshed and the native plugins' cycle_end hooks run; when it cannot be
+ * taken both are skipped and logged.
+ *
+ * @param locked The caller holds the plugin driver's buffer_mutex
+ */
+void safe_state_apply(bool locked);
+
+/**
+ * @brief Apply the safe state and put the PLC in ERROR
+ *
+ * @param reason For the log, e.g. "watchdog"
+ * @param locked As for safe_state_apply()
+ */
+void safe_state_enter(const char *reason, bool locked);
+
+#endif // SAFE_STATE_H
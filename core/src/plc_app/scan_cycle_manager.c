@@ -1,23 +1,68 @@
 #include <inttypes.h>
 #include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 
 #include "scan_cycle_manager.h"
+#include "utils/seqlock.h"
 #include "utils/utils.h"
 
-// CLOCK_MONOTONIC_RAW is Linux-specific, use CLOCK_MONOTONIC on other platforms
-#if defined(__CYGWIN__) || defined(__MSYS__) || !defined(CLOCK_MONOTONIC_RAW)
-#define OPENPLC_CLOCK CLOCK_MONOTONIC
-#else
-#define OPENPLC_CLOCK CLOCK_MONOTONIC_RAW
-#endif
+enum
+{
+    TIMING_METRIC_SCAN = 0,
+    TIMING_METRIC_CYCLE,
+    TIMING_METRIC_LATENCY,
+    TIMING_METRIC_COUNT
+};
+
+static const char *const timing_metric_names[TIMING_METRIC_COUNT] = {
+    "scan_time", "cycle_time", "cycle_latency"};
+
+// Tumbling window: samples go into `current` until period_us has elapsed,
+// then it becomes `last` (the window reported to clients) and starts over.
+typedef struct
+{
+    const char *name;
+    uint64_t period_us;
+    uint64_t start_us;
+    bool has_last;
+    timing_histogram_t current[TIMING_METRIC_COUNT];
+    timing_histogram_t last[TIMING_METRIC_COUNT];
+} timing_window_t;
+
+#define TIMING_WINDOW_COUNT 3
 
 static uint64_t expected_start_us  = 0;
 static uint64_t last_start_us      = 0;
-static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The scan thread is the only writer of the stats and the histograms. Readers
+// (the unix socket thread) copy them under a seqlock and retry if the scan
+// thread wrote in the meantime, so the real-time path never blocks on them.
+// The counters are odd while a write is in progress.
+static atomic_uint stats_seq = 0;
+static atomic_uint hist_seq  = 0;
+
+// Set by reset_timing_histograms(), applied by the scan thread
+static atomic_bool hist_reset_pending = false;
+
+// Exact sums for the averages, a running average in integer math stops
+// moving once scan_count grows large
+static int64_t scan_time_sum     = 0;
+static int64_t scan_time_samples = 0;
+static int64_t cycle_time_sum    = 0;
+static int64_t cycle_latency_sum = 0;
+static int64_t cycle_samples     = 0;
+
+static timing_histogram_t timing_hist_all[TIMING_METRIC_COUNT];
+static timing_window_t timing_windows[TIMING_WINDOW_COUNT] = {
+    {.name = "1s", .period_us = 1000000ull},
+    {.name = "10s", .period_us = 10000000ull},
+    {.name = "60s", .period_us = 60000000ull},
+};
 
 plc_timing_stats_t plc_timing_stats = {.scan_time_min     = INT64_MAX,
                                        .cycle_latency_min = INT64_MAX,
@@ -30,29 +75,191 @@ plc_timing_stats_t plc_timing_stats = {.scan_time_min     = INT64_MAX,
 static uint64_t ts_now_us(void)
 {
     struct timespec ts;
-    clock_gettime(OPENPLC_CLOCK, &ts);
+    clock_gettime(PLC_CLOCK, &ts);
     return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
 }
 
+static size_t timing_histogram_bucket(uint64_t value)
+{
+    if (value < TIMING_HIST_LINEAR)
+    {
+        return (size_t)value;
+    }
+
+    // TIMING_HIST_LINEAR is 2^5 and TIMING_HIST_SUB is 2^4: the top bit picks
+    // the power of two, the next four bits pick the sub-bucket
+    int exponent = 63 - __builtin_clzll(value);
+    size_t sub   = (size_t)(value >> (exponent - 4)) & (TIMING_HIST_SUB - 1);
+    size_t index = TIMING_HIST_LINEAR + (size_t)(exponent - 5) * TIMING_HIST_SUB + sub;
+
+    if (index >= TIMING_HIST_BUCKETS)
+    {
+        index = TIMING_HIST_BUCKETS - 1;
+    }
+    return index;
+}
+
+// Highest value that maps to the given bucket
+static uint64_t timing_histogram_bucket_high(size_t index)
+{
+    if (index < TIMING_HIST_LINEAR)
+    {
+        return index;
+    }
+
+    int exponent = (int)((index - TIMING_HIST_LINEAR) / TIMING_HIST_SUB) + 5;
+    uint64_t sub = (index - TIMING_HIST_LINEAR) % TIMING_HIST_SUB;
+    uint64_t low = (TIMING_HIST_SUB + sub) << (exponent - 4);
+
+    return low + (1ull << (exponent - 4)) - 1;
+}
+
+void timing_histogram_record(timing_histogram_t *hist, int64_t value)
+{
+    uint64_t v = value < 0 ? 0 : (uint64_t)value;
+
+    hist->counts[timing_histogram_bucket(v)]++;
+    hist->total++;
+    if (v > hist->max)
+    {
+        hist->max = v;
+    }
+}
+
+int64_t timing_histogram_percentile(const timing_histogram_t *hist, double q)
+{
+    if (hist->total == 0)
+    {
+        return -1;
+    }
+
+    uint64_t target = (uint64_t)(q * (double)hist->total + 0.5);
+    if (target < 1)
+    {
+        target = 1;
+    }
+    if (target > hist->total)
+    {
+        target = hist->total;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < TIMING_HIST_BUCKETS; i++)
+    {
+        seen += hist->counts[i];
+        if (seen >= target)
+        {
+            uint64_t high = timing_histogram_bucket_high(i);
+            return (int64_t)(high < hist->max ? high : hist->max);
+        }
+    }
+
+    return (int64_t)hist->max;
+}
+
+// Called by the scan thread inside a hist_seq write section
+static void timing_record_metric(int metric, int64_t value_us)
+{
+    timing_histogram_record(&timing_hist_all[metric], value_us);
+    for (int w = 0; w < TIMING_WINDOW_COUNT; w++)
+    {
+        timing_histogram_record(&timing_windows[w].current[metric], value_us);
+    }
+}
+
+// Called by the scan thread inside a hist_seq write section
+static void timing_rotate_windows(uint64_t now_us)
+{
+    for (int w = 0; w < TIMING_WINDOW_COUNT; w++)
+    {
+        timing_window_t *window = &timing_windows[w];
+
+        if (window->start_us == 0)
+        {
+            window->start_us = now_us;
+            continue;
+        }
+        if (now_us - window->start_us < window->period_us)
+        {
+            continue;
+        }
+
+        memcpy(window->last, window->current, sizeof(window->last));
+        memset(window->current, 0, sizeof(window->current));
+        window->has_last = true;
+        window->start_us = now_us;
+    }
+}
+
+// Called by the scan thread inside a hist_seq write section
+static void timing_clear_histograms(void)
+{
+    memset(timing_hist_all, 0, sizeof(timing_hist_all));
+    for (int w = 0; w < TIMING_WINDOW_COUNT; w++)
+    {
+        memset(timing_windows[w].current, 0, sizeof(timing_windows[w].current));
+        memset(timing_windows[w].last, 0, sizeof(timing_windows[w].last));
+        timing_windows[w].has_last = false;
+        timing_windows[w].start_us = 0;
+    }
+}
+
+void scan_cycle_time_reset(void)
+{
+    seq_write_begin(&stats_seq);
+    plc_timing_stats.scan_count  = 0;
+    plc_timing_stats.event_scans = 0;
+    seq_write_end(&stats_seq);
+}
+
+void scan_cycle_slots_skipped(uint64_t slots)
+{
+    expected_start_us += slots * (*ext_common_ticktime__ / 1000); // Convert ns to us
+}
+
+void scan_cycle_event_scan(void)
+{
+    seq_write_begin(&stats_seq);
+    plc_timing_stats.event_scans++;
+    seq_write_end(&stats_seq);
+}
+
 void scan_cycle_time_start(void)
 {
     uint64_t now_us = ts_now_us();
 
-    pthread_mutex_lock(&stats_mutex);
-
     if (plc_timing_stats.scan_count == 0)
     {
         // Ignore full calculations for the first cycle
         expected_start_us = now_us + *ext_common_ticktime__ / 1000; // Convert ns to us
         last_start_us     = now_us;
-        plc_timing_stats.scan_count++;
+        scan_time_sum     = 0;
+        scan_time_samples = 0;
+        cycle_time_sum    = 0;
+        cycle_latency_sum = 0;
+        cycle_samples     = 0;
+
+        seq_write_begin(&hist_seq);
+        atomic_store_explicit(&hist_reset_pending, false, memory_order_relaxed);
+        timing_clear_histograms();
+        timing_rotate_windows(now_us);
+        seq_write_end(&hist_seq);
 
-        pthread_mutex_unlock(&stats_mutex);
+        seq_write_begin(&stats_seq);
+        plc_timing_stats.scan_count++;
+        seq_write_end(&stats_seq);
         return;
     }
 
-    // Calculate cycle time
+    cycle_samples++;
     int64_t cycle_time_us = now_us - last_start_us;
+    int64_t latency_us    = (int64_t)(now_us - expected_start_us);
+    cycle_time_sum += cycle_time_us;
+    cycle_latency_sum += latency_us;
+
+    seq_write_begin(&stats_seq);
+
+    // Calculate cycle time
     if (cycle_time_us < plc_timing_stats.cycle_time_min)
     {
         plc_timing_stats.cycle_time_min = cycle_time_us;
@@ -61,11 +268,9 @@ void scan_cycle_time_start(void)
     {
         plc_timing_stats.cycle_time_max = cycle_time_us;
     }
-    plc_timing_stats.cycle_time_avg +=
-        (cycle_time_us - plc_timing_stats.cycle_time_avg) / plc_timing_stats.scan_count;
+    plc_timing_stats.cycle_time_avg = cycle_time_sum / cycle_samples;
 
     // Calculate cycle latency
-    int64_t latency_us = (int64_t)(now_us - expected_start_us);
     if (latency_us < plc_timing_stats.cycle_latency_min)
     {
         plc_timing_stats.cycle_latency_min = latency_us;
@@ -74,25 +279,38 @@ void scan_cycle_time_start(void)
     {
         plc_timing_stats.cycle_latency_max = latency_us;
     }
-    plc_timing_stats.cycle_latency_avg +=
-        (latency_us - plc_timing_stats.cycle_latency_avg) / plc_timing_stats.scan_count;
-
-    last_start_us = now_us;
-    expected_start_us += *ext_common_ticktime__ / 1000; // Convert ns to us
+    plc_timing_stats.cycle_latency_avg = cycle_latency_sum / cycle_samples;
 
     plc_timing_stats.scan_count++;
 
-    pthread_mutex_unlock(&stats_mutex);
+    seq_write_end(&stats_seq);
+
+    seq_write_begin(&hist_seq);
+    if (atomic_load_explicit(&hist_reset_pending, memory_order_relaxed) &&
+        atomic_exchange_explicit(&hist_reset_pending, false, memory_order_acquire))
+    {
+        timing_clear_histograms();
+    }
+    timing_rotate_windows(now_us);
+    timing_record_metric(TIMING_METRIC_CYCLE, cycle_time_us);
+    timing_record_metric(TIMING_METRIC_LATENCY, latency_us);
+    seq_write_end(&hist_seq);
+
+    last_start_us = now_us;
+    expected_start_us += *ext_common_ticktime__ / 1000; // Convert ns to us
 }
 
 void scan_cycle_time_end(void)
 {
     uint64_t now_us = ts_now_us();
 
-    pthread_mutex_lock(&stats_mutex);
+    int64_t scan_time_us = now_us - last_start_us;
+    scan_time_sum += scan_time_us;
+    scan_time_samples++;
+
+    seq_write_begin(&stats_seq);
 
     // Calculate scan time
-    int64_t scan_time_us = now_us - last_start_us;
     if (scan_time_us < plc_timing_stats.scan_time_min)
     {
         plc_timing_stats.scan_time_min = scan_time_us;
@@ -101,8 +319,7 @@ void scan_cycle_time_end(void)
     {
         plc_timing_stats.scan_time_max = scan_time_us;
     }
-    plc_timing_stats.scan_time_avg +=
-        (scan_time_us - plc_timing_stats.scan_time_avg) / plc_timing_stats.scan_count;
+    plc_timing_stats.scan_time_avg = scan_time_sum / scan_time_samples;
 
     // Check for overrun
     if (now_us > expected_start_us)
@@ -110,7 +327,11 @@ void scan_cycle_time_end(void)
         plc_timing_stats.overruns++;
     }
 
-    pthread_mutex_unlock(&stats_mutex);
+    seq_write_end(&stats_seq);
+
+    seq_write_begin(&hist_seq);
+    timing_record_metric(TIMING_METRIC_SCAN, scan_time_us);
+    seq_write_end(&hist_seq);
 }
 
 bool get_timing_stats_snapshot(plc_timing_stats_t *snapshot)
@@ -120,9 +341,12 @@ bool get_timing_stats_snapshot(plc_timing_stats_t *snapshot)
         return false;
     }
 
-    pthread_mutex_lock(&stats_mutex);
-    memcpy(snapshot, &plc_timing_stats, sizeof(plc_timing_stats_t));
-    pthread_mutex_unlock(&stats_mutex);
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&stats_seq);
+        memcpy(snapshot, &plc_timing_stats, sizeof(plc_timing_stats_t));
+    } while (seq_read_retry(&stats_seq, seq));
 
     return snapshot->scan_count > 0;
 }
@@ -146,7 +370,8 @@ int format_timing_stats_response(char *buffer, size_t buffer_size)
                         "\"cycle_latency_min\":null,"
                         "\"cycle_latency_max\":null,"
                         "\"cycle_latency_avg\":null,"
-                        "\"overruns\":0"
+                        "\"overruns\":0,"
+                        "\"event_scans\":0"
                         "}\n");
     }
 
@@ -162,9 +387,142 @@ int format_timing_stats_response(char *buffer, size_t buffer_size)
                     "\"cycle_latency_min\":%" PRId64 ","
                     "\"cycle_latency_max\":%" PRId64 ","
                     "\"cycle_latency_avg\":%" PRId64 ","
-                    "\"overruns\":%" PRId64 "}\n",
+                    "\"overruns\":%" PRId64 ","
+                    "\"event_scans\":%" PRId64 "}\n",
                     snapshot.scan_count, snapshot.scan_time_min, snapshot.scan_time_max,
                     snapshot.scan_time_avg, snapshot.cycle_time_min, snapshot.cycle_time_max,
                     snapshot.cycle_time_avg, snapshot.cycle_latency_min, snapshot.cycle_latency_max,
-                    snapshot.cycle_latency_avg, snapshot.overruns);
+                    snapshot.cycle_latency_avg, snapshot.overruns, snapshot.event_scans);
+}
+
+bool timing_format_append(char *buffer, size_t buffer_size, size_t *written, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buffer + *written, buffer_size - *written, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)n >= buffer_size - *written)
+    {
+        return false;
+    }
+    *written += (size_t)n;
+    return true;
+}
+
+bool timing_histogram_format_fields(char *buffer, size_t buffer_size, size_t *written,
+                                    const timing_histogram_t *hist)
+{
+    static const double quantiles[]    = {0.50, 0.90, 0.99, 0.999};
+    static const char *const q_names[] = {"p50", "p90", "p99", "p999"};
+
+    if (!timing_format_append(buffer, buffer_size, written, "\"count\":%" PRIu64, hist->total))
+    {
+        return false;
+    }
+
+    for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++)
+    {
+        int64_t value = timing_histogram_percentile(hist, quantiles[q]);
+        bool ok       = value < 0 ? timing_format_append(buffer, buffer_size, written,
+                                                         ",\"%s\":null", q_names[q])
+                                  : timing_format_append(buffer, buffer_size, written,
+                                                         ",\"%s\":%" PRId64, q_names[q], value);
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    return hist->total == 0
+               ? timing_format_append(buffer, buffer_size, written, ",\"max\":null")
+               : timing_format_append(buffer, buffer_size, written, ",\"max\":%" PRIu64,
+                                      hist->max);
+}
+
+static bool format_histogram_set(char *buffer, size_t buffer_size, size_t *written,
+                                 const timing_histogram_t hists[TIMING_METRIC_COUNT])
+{
+    if (!timing_format_append(buffer, buffer_size, written, "{"))
+    {
+        return false;
+    }
+
+    for (int m = 0; m < TIMING_METRIC_COUNT; m++)
+    {
+        if (!timing_format_append(buffer, buffer_size, written, "%s\"%s\":{", m == 0 ? "" : ",",
+                                  timing_metric_names[m]) ||
+            !timing_histogram_format_fields(buffer, buffer_size, written, &hists[m]) ||
+            !timing_format_append(buffer, buffer_size, written, "}"))
+        {
+            return false;
+        }
+    }
+
+    return timing_format_append(buffer, buffer_size, written, "}");
+}
+
+int format_timing_histogram_response(char *buffer, size_t buffer_size)
+{
+    // The copies are large, keep them off the caller's stack. format_mutex
+    // only serializes readers, the scan thread never takes it.
+    static timing_histogram_t all[TIMING_METRIC_COUNT];
+    static timing_histogram_t windows[TIMING_WINDOW_COUNT][TIMING_METRIC_COUNT];
+    static pthread_mutex_t format_mutex = PTHREAD_MUTEX_INITIALIZER;
+    bool has_last[TIMING_WINDOW_COUNT];
+
+    pthread_mutex_lock(&format_mutex);
+
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&hist_seq);
+        memcpy(all, timing_hist_all, sizeof(all));
+        for (int w = 0; w < TIMING_WINDOW_COUNT; w++)
+        {
+            memcpy(windows[w], timing_windows[w].last, sizeof(windows[w]));
+            has_last[w] = timing_windows[w].has_last;
+        }
+    } while (seq_read_retry(&hist_seq, seq));
+
+    size_t written = 0;
+    bool ok        = timing_format_append(buffer, buffer_size, &written, "HISTOGRAM:{\"all\":") &&
+              format_histogram_set(buffer, buffer_size, &written, all);
+
+    for (int w = 0; ok && w < TIMING_WINDOW_COUNT; w++)
+    {
+        ok = timing_format_append(buffer, buffer_size, &written, ",\"%s\":", timing_windows[w].name);
+        if (ok)
+        {
+            ok = has_last[w] ? format_histogram_set(buffer, buffer_size, &written, windows[w])
+                             : timing_format_append(buffer, buffer_size, &written, "null");
+        }
+    }
+    ok = ok && timing_format_append(buffer, buffer_size, &written, "}\n");
+
+    pthread_mutex_unlock(&format_mutex);
+
+    if (!ok)
+    {
+        return snprintf(buffer, buffer_size, "HISTOGRAM:ERROR\n");
+    }
+    return (int)written;
+}
+
+_Static_assert(TIMING_SNAPSHOT_METRICS == TIMING_METRIC_COUNT,
+               "get_timing_histograms_snapshot() copies every metric");
+
+void get_timing_histograms_snapshot(timing_histogram_t hists[TIMING_SNAPSHOT_METRICS])
+{
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&hist_seq);
+        memcpy(hists, timing_hist_all, sizeof(timing_hist_all));
+    } while (seq_read_retry(&hist_seq, seq));
+}
+
+void reset_timing_histograms(void)
+{
+    atomic_store_explicit(&hist_reset_pending, true, memory_order_release);
 }
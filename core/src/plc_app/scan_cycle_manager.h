@@ -2,8 +2,42 @@
 #define SCAN_CYCLE_MANAGER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+// Log-bucketed (HDR-style) histogram of non-negative integer durations
+// (microseconds for the scan stats, nanoseconds for the scan profiler).
+// Values below TIMING_HIST_LINEAR get one bucket each; above that every power
+// of two is split into TIMING_HIST_SUB buckets, so the relative error of a
+// reported percentile is at most 1/TIMING_HIST_SUB (about 6%).
+#define TIMING_HIST_LINEAR 32
+#define TIMING_HIST_SUB 16
+#define TIMING_HIST_MAX_EXP 36
+#define TIMING_HIST_BUCKETS (TIMING_HIST_LINEAR + TIMING_HIST_SUB * TIMING_HIST_MAX_EXP)
+
+typedef struct
+{
+    uint32_t counts[TIMING_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} timing_histogram_t;
+
+// Record one value (negative values are recorded as 0)
+void timing_histogram_record(timing_histogram_t *hist, int64_t value);
+
+// Value at quantile q (0.0 - 1.0), or -1 if the histogram is empty
+int64_t timing_histogram_percentile(const timing_histogram_t *hist, double q);
+
+// Append printf-style text at buffer + *written and advance *written.
+// Returns false (leaving *written alone) if the text does not fit.
+bool timing_format_append(char *buffer, size_t buffer_size, size_t *written, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+// Append "count":N,"p50":..,"p90":..,"p99":..,"p999":..,"max":.. (JSON object
+// members without the braces, percentiles are null for an empty histogram)
+bool timing_histogram_format_fields(char *buffer, size_t buffer_size, size_t *written,
+                                    const timing_histogram_t *hist);
+
 typedef struct
 {
     int64_t scan_time_min;
@@ -20,12 +54,22 @@ typedef struct
 
     int64_t scan_count;
     int64_t overruns;
+    int64_t event_scans; // scans between cycles for event triggers, not in the times above
 } plc_timing_stats_t;
 
+// Called from the scan thread only, the stats have a single writer
+void scan_cycle_time_reset(void);
 void scan_cycle_time_start(void);
 void scan_cycle_time_end(void);
 
-// Thread-safe function to get a snapshot of timing stats
+// Move the expected start of the next cycle past slots the scheduler skipped,
+// so latency is measured against the slot the cycle actually runs in
+void scan_cycle_slots_skipped(uint64_t slots);
+
+// Count a scan run between two cycles for an event trigger
+void scan_cycle_event_scan(void);
+
+// Thread-safe, lock-free function to get a snapshot of timing stats
 // Returns true if stats are valid (scan_count > 0), false otherwise
 bool get_timing_stats_snapshot(plc_timing_stats_t *snapshot);
 
@@ -33,4 +77,18 @@ bool get_timing_stats_snapshot(plc_timing_stats_t *snapshot);
 // Returns the number of characters written (excluding null terminator)
 int format_timing_stats_response(char *buffer, size_t buffer_size);
 
+// Format scan time, cycle time and latency percentiles for the HISTOGRAM
+// command: since the last reset ("all") and for the last complete 1s, 10s and
+// 60s windows. Returns the number of characters written.
+int format_timing_histogram_response(char *buffer, size_t buffer_size);
+
+// Copy the histograms since the last reset, in the order scan time, cycle time,
+// cycle latency, lock-free like get_timing_stats_snapshot()
+#define TIMING_SNAPSHOT_METRICS 3
+void get_timing_histograms_snapshot(timing_histogram_t hists[TIMING_SNAPSHOT_METRICS]);
+
+// Clear the histograms (the "all" window and the rolling windows). The scan
+// thread applies the reset at the start of its next cycle.
+void reset_timing_histograms(void);
+
 #endif // SCAN_CYCLE_MANAGER_H
@@ -0,0 +1,257 @@
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "scan_cycle_manager.h"
+#include "scan_profiler.h"
+#include "utils/seqlock.h"
+#include "utils/utils.h"
+
+// Same limit as MAX_PLUGINS in plugin_driver.h
+#define SCAN_PROFILER_MAX_PLUGINS 16
+#define SCAN_PROFILER_NAME_LEN 64
+
+static const char *const phase_names[SCAN_PHASE_COUNT] = {
+    "lock_wait", "journal", "cycle_start", "program", "update_time", "shadow_sync", "cycle_end"};
+
+static const char *const hook_names[SCAN_HOOK_COUNT] = {"cycle_start", "cycle_end"};
+
+typedef struct
+{
+    timing_histogram_t hist;
+    uint64_t min;
+    uint64_t sum;
+} profile_metric_t;
+
+typedef struct
+{
+    uint64_t cycles;
+    profile_metric_t phases[SCAN_PHASE_COUNT];
+    profile_metric_t hooks[SCAN_PROFILER_MAX_PLUGINS][SCAN_HOOK_COUNT];
+    char plugin_names[SCAN_PROFILER_MAX_PLUGINS][SCAN_PROFILER_NAME_LEN];
+} profile_data_t;
+
+bool scan_profiler_cycle_active = false;
+
+static atomic_bool profiler_enabled = false;
+static atomic_bool reset_pending    = false;
+
+// Written by the scan thread only, read under profile_seq
+static atomic_uint profile_seq = 0;
+static profile_data_t profile_data;
+
+// Samples of the cycle in progress, published in one write section at the end
+static uint64_t last_mark_ns;
+static uint64_t pending_phase_ns[SCAN_PHASE_COUNT];
+static uint32_t pending_phase_mask;
+static uint64_t pending_hook_ns[SCAN_PROFILER_MAX_PLUGINS][SCAN_HOOK_COUNT];
+static const char *pending_hook_names[SCAN_PROFILER_MAX_PLUGINS];
+static uint32_t pending_hook_mask[SCAN_HOOK_COUNT];
+
+uint64_t scan_profiler_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void scan_profiler_set_enabled(bool enabled)
+{
+    atomic_store_explicit(&profiler_enabled, enabled, memory_order_relaxed);
+}
+
+bool scan_profiler_is_enabled(void)
+{
+    return atomic_load_explicit(&profiler_enabled, memory_order_relaxed);
+}
+
+void scan_profiler_reset(void)
+{
+    atomic_store_explicit(&reset_pending, true, memory_order_release);
+}
+
+static void profile_metric_record(profile_metric_t *metric, uint64_t value_ns)
+{
+    if (metric->hist.total == 0 || value_ns < metric->min)
+    {
+        metric->min = value_ns;
+    }
+    metric->sum += value_ns;
+    timing_histogram_record(&metric->hist, (int64_t)value_ns);
+}
+
+void scan_profiler_begin_cycle(void)
+{
+    if (atomic_load_explicit(&reset_pending, memory_order_relaxed) &&
+        atomic_exchange_explicit(&reset_pending, false, memory_order_acquire))
+    {
+        seq_write_begin(&profile_seq);
+        memset(&profile_data, 0, sizeof(profile_data));
+        seq_write_end(&profile_seq);
+    }
+
+    scan_profiler_cycle_active = atomic_load_explicit(&profiler_enabled, memory_order_relaxed);
+    if (!scan_profiler_cycle_active)
+    {
+        return;
+    }
+
+    pending_phase_mask                       = 0;
+    pending_hook_mask[SCAN_HOOK_CYCLE_START] = 0;
+    pending_hook_mask[SCAN_HOOK_CYCLE_END]   = 0;
+    last_mark_ns                             = scan_profiler_now_ns();
+}
+
+void scan_profiler_record_phase(scan_phase_t phase)
+{
+    uint64_t now_ns = scan_profiler_now_ns();
+
+    pending_phase_ns[phase] = now_ns - last_mark_ns;
+    pending_phase_mask |= 1u << phase;
+    last_mark_ns = now_ns;
+}
+
+void scan_profiler_record_hook(int plugin_index, const char *plugin_name, scan_hook_t hook,
+                               uint64_t duration_ns)
+{
+    if (plugin_index < 0 || plugin_index >= SCAN_PROFILER_MAX_PLUGINS)
+    {
+        return;
+    }
+
+    pending_hook_ns[plugin_index][hook] = duration_ns;
+    pending_hook_names[plugin_index]    = plugin_name;
+    pending_hook_mask[hook] |= 1u << plugin_index;
+}
+
+// Keep the name safe to embed in a JSON string
+static void copy_plugin_name(char *dest, const char *src)
+{
+    size_t i = 0;
+    for (; i < SCAN_PROFILER_NAME_LEN - 1 && src[i] != '\0'; i++)
+    {
+        char c  = src[i];
+        dest[i] = (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+    }
+    dest[i] = '\0';
+}
+
+void scan_profiler_publish_cycle(void)
+{
+    seq_write_begin(&profile_seq);
+
+    profile_data.cycles++;
+
+    for (int p = 0; p < SCAN_PHASE_COUNT; p++)
+    {
+        if (pending_phase_mask & (1u << p))
+        {
+            profile_metric_record(&profile_data.phases[p], pending_phase_ns[p]);
+        }
+    }
+
+    for (int h = 0; h < SCAN_HOOK_COUNT; h++)
+    {
+        for (int i = 0; i < SCAN_PROFILER_MAX_PLUGINS; i++)
+        {
+            if ((pending_hook_mask[h] & (1u << i)) == 0)
+            {
+                continue;
+            }
+            if (profile_data.plugin_names[i][0] == '\0' && pending_hook_names[i] != NULL)
+            {
+                copy_plugin_name(profile_data.plugin_names[i], pending_hook_names[i]);
+            }
+            profile_metric_record(&profile_data.hooks[i][h], pending_hook_ns[i][h]);
+        }
+    }
+
+    seq_write_end(&profile_seq);
+
+    scan_profiler_cycle_active = false;
+}
+
+static bool format_metric(char *buffer, size_t buffer_size, size_t *written,
+                          const profile_metric_t *metric)
+{
+    if (metric->hist.total == 0)
+    {
+        if (!timing_format_append(buffer, buffer_size, written, "\"min\":null,\"avg\":null,"))
+        {
+            return false;
+        }
+    }
+    else if (!timing_format_append(buffer, buffer_size, written,
+                                   "\"min\":%" PRIu64 ",\"avg\":%" PRIu64 ",", metric->min,
+                                   metric->sum / metric->hist.total))
+    {
+        return false;
+    }
+
+    return timing_histogram_format_fields(buffer, buffer_size, written, &metric->hist);
+}
+
+int format_scan_profile_response(char *buffer, size_t buffer_size)
+{
+    // Too large for the caller's stack; format_mutex only serializes readers
+    static profile_data_t snapshot;
+    static pthread_mutex_t format_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&format_mutex);
+
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&profile_seq);
+        memcpy(&snapshot, &profile_data, sizeof(snapshot));
+    } while (seq_read_retry(&profile_seq, seq));
+
+    size_t written = 0;
+    bool ok        = timing_format_append(buffer, buffer_size, &written,
+                                          "PROFILE:{\"enabled\":%s,\"cycles\":%" PRIu64
+                                          ",\"unit\":\"ns\",\"phases\":{",
+                                          scan_profiler_is_enabled() ? "true" : "false",
+                                          snapshot.cycles);
+
+    for (int p = 0; ok && p < SCAN_PHASE_COUNT; p++)
+    {
+        ok = timing_format_append(buffer, buffer_size, &written, "%s\"%s\":{", p == 0 ? "" : ",",
+                                  phase_names[p]) &&
+             format_metric(buffer, buffer_size, &written, &snapshot.phases[p]) &&
+             timing_format_append(buffer, buffer_size, &written, "}");
+    }
+    ok = ok && timing_format_append(buffer, buffer_size, &written, "},\"hooks\":[");
+
+    bool first = true;
+    for (int i = 0; ok && i < SCAN_PROFILER_MAX_PLUGINS; i++)
+    {
+        for (int h = 0; ok && h < SCAN_HOOK_COUNT; h++)
+        {
+            const profile_metric_t *metric = &snapshot.hooks[i][h];
+            if (metric->hist.total == 0)
+            {
+                continue;
+            }
+
+            ok = timing_format_append(buffer, buffer_size, &written,
+                                      "%s{\"plugin\":\"%s\",\"hook\":\"%s\",", first ? "" : ",",
+                                      snapshot.plugin_names[i], hook_names[h]) &&
+                 format_metric(buffer, buffer_size, &written, metric) &&
+                 timing_format_append(buffer, buffer_size, &written, "}");
+            first = false;
+        }
+    }
+    ok = ok && timing_format_append(buffer, buffer_size, &written, "]}\n");
+
+    pthread_mutex_unlock(&format_mutex);
+
+    if (!ok)
+    {
+        return snprintf(buffer, buffer_size, "PROFILE:ERROR\n");
+    }
+    return (int)written;
+}
@@ -0,0 +1,73 @@
+#ifndef SCAN_PROFILER_H
+#define SCAN_PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Phases of one scan cycle, in the order plc_cycle_thread runs them. Each
+// scan_profiler_mark() closes the phase passed to it: the recorded duration is
+// the time since the previous mark (or since scan_profiler_begin_cycle()).
+typedef enum
+{
+    SCAN_PHASE_LOCK_WAIT = 0, // waiting for the image mutex
+    SCAN_PHASE_JOURNAL,       // journal_apply_and_clear
+    SCAN_PHASE_CYCLE_START,   // plugin_driver_cycle_start
+    SCAN_PHASE_PROGRAM,       // ext_config_run__
+    SCAN_PHASE_UPDATE_TIME,   // ext_updateTime
+    SCAN_PHASE_SHADOW_SYNC,   // image_shadow_sync
+    SCAN_PHASE_CYCLE_END,     // plugin_driver_cycle_end
+    SCAN_PHASE_COUNT
+} scan_phase_t;
+
+typedef enum
+{
+    SCAN_HOOK_CYCLE_START = 0,
+    SCAN_HOOK_CYCLE_END,
+    SCAN_HOOK_COUNT
+} scan_hook_t;
+
+// True while the current cycle is being profiled. Latched by
+// scan_profiler_begin_cycle() so enabling profiling mid-cycle does not
+// produce a partial sample. Only the scan thread reads or writes it.
+extern bool scan_profiler_cycle_active;
+
+// Turn profiling on or off (takes effect at the next cycle)
+void scan_profiler_set_enabled(bool enabled);
+bool scan_profiler_is_enabled(void);
+
+// Clear the collected data (applied by the scan thread at its next cycle)
+void scan_profiler_reset(void);
+
+// Monotonic timestamp in nanoseconds
+uint64_t scan_profiler_now_ns(void);
+
+// Scan thread side
+void scan_profiler_begin_cycle(void);
+void scan_profiler_record_phase(scan_phase_t phase);
+void scan_profiler_record_hook(int plugin_index, const char *plugin_name, scan_hook_t hook,
+                               uint64_t duration_ns);
+void scan_profiler_publish_cycle(void);
+
+// The inline wrappers cost one branch per call when profiling is off
+static inline void scan_profiler_mark(scan_phase_t phase)
+{
+    if (scan_profiler_cycle_active)
+    {
+        scan_profiler_record_phase(phase);
+    }
+}
+
+static inline void scan_profiler_end_cycle(void)
+{
+    if (scan_profiler_cycle_active)
+    {
+        scan_profiler_publish_cycle();
+    }
+}
+
+// Format the per-phase and per-hook durations (nanoseconds) for the PROFILE
+// command. Returns the number of characters written.
+int format_scan_profile_response(char *buffer, size_t buffer_size);
+
+#endif // SCAN_PROFILER_H
@@ -0,0 +1,462 @@
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "image_tables.h"
+#include "journal_buffer.h"
+#include "simulation.h"
+#include "utils/log.h"
+#include "utils/utils.h"
+
+extern volatile sig_atomic_t keep_running;
+
+// Output records collected before one write()
+#define SIM_OUTPUT_BUFFER_RECORDS 4096
+
+// One bound output, with the value last recorded
+typedef struct
+{
+    void *addr;
+    uint64_t last;
+    uint32_t index;
+    uint8_t type;
+    uint8_t bit;
+    uint8_t width;
+} sim_output_t;
+
+static bool enabled            = false;
+static const char *input_path  = NULL;
+static const char *output_path = NULL;
+static uint64_t max_scans      = 0;
+
+// Run state, scan thread only
+static bool running = false;
+static uint64_t scan;
+static uint64_t start_ns;
+
+static void *input_map = NULL;
+static size_t input_map_size;
+static const sim_trace_record_t *input_records;
+static size_t input_count;
+static size_t input_next;
+
+static int output_fd = -1;
+static sim_output_t *outputs;
+static size_t output_count;
+static bool outputs_fresh; // record every output at the end of the next scan
+static sim_trace_record_t output_buffer[SIM_OUTPUT_BUFFER_RECORDS];
+static size_t output_fill;
+static uint64_t output_written;
+
+static const journal_buffer_type_t output_types[] = {
+    JOURNAL_BOOL_OUTPUT, JOURNAL_BYTE_OUTPUT, JOURNAL_INT_OUTPUT,
+    JOURNAL_DINT_OUTPUT, JOURNAL_LINT_OUTPUT,
+};
+
+void simulation_set_enabled(bool enable)
+{
+    enabled = enable;
+}
+
+bool simulation_enabled(void)
+{
+    return enabled;
+}
+
+int simulation_set_input(const char *path)
+{
+    if (path == NULL || path[0] == '\0')
+    {
+        return -1;
+    }
+    input_path = path;
+    return 0;
+}
+
+int simulation_set_output(const char *path)
+{
+    if (path == NULL || path[0] == '\0')
+    {
+        return -1;
+    }
+    output_path = path;
+    return 0;
+}
+
+void simulation_set_scans(uint64_t scans)
+{
+    max_scans = scans;
+}
+
+static uint64_t sim_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Current image table entry of an address, NULL outside the tables
+static void *entry_addr(uint8_t type, uint32_t index, uint8_t bit)
+{
+    switch (type)
+    {
+    case JOURNAL_BOOL_INPUT:
+        return bool_input[index][bit];
+    case JOURNAL_BOOL_OUTPUT:
+        return bool_output[index][bit];
+    case JOURNAL_BOOL_MEMORY:
+        return bool_memory[index][bit];
+    case JOURNAL_BYTE_INPUT:
+        return byte_input[index];
+    case JOURNAL_BYTE_OUTPUT:
+        return byte_output[index];
+    case JOURNAL_INT_INPUT:
+        return int_input[index];
+    case JOURNAL_INT_OUTPUT:
+        return int_output[index];
+    case JOURNAL_INT_MEMORY:
+        return int_memory[index];
+    case JOURNAL_DINT_INPUT:
+        return dint_input[index];
+    case JOURNAL_DINT_OUTPUT:
+        return dint_output[index];
+    case JOURNAL_DINT_MEMORY:
+        return dint_memory[index];
+    case JOURNAL_LINT_INPUT:
+        return lint_input[index];
+    case JOURNAL_LINT_OUTPUT:
+        return lint_output[index];
+    case JOURNAL_LINT_MEMORY:
+        return lint_memory[index];
+    default:
+        return NULL;
+    }
+}
+
+static uint64_t load_value(const void *addr, size_t width)
+{
+    switch (width)
+    {
+    case 1:
+        return *(const uint8_t *)addr;
+    case 2:
+        return *(const uint16_t *)addr;
+    case 4:
+        return *(const uint32_t *)addr;
+    default:
+        return *(const uint64_t *)addr;
+    }
+}
+
+static void store_value(void *addr, size_t width, uint64_t value)
+{
+    switch (width)
+    {
+    case 1:
+        *(uint8_t *)addr = (uint8_t)value;
+        break;
+    case 2:
+        *(uint16_t *)addr = (uint16_t)value;
+        break;
+    case 4:
+        *(uint32_t *)addr = (uint32_t)value;
+        break;
+    default:
+        *(uint64_t *)addr = value;
+        break;
+    }
+}
+
+static void flush_outputs(void)
+{
+    size_t bytes      = output_fill * sizeof(sim_trace_record_t);
+    const char *data  = (const char *)output_buffer;
+    while (output_fd >= 0 && bytes > 0)
+    {
+        ssize_t n = write(output_fd, data, bytes);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            log_error("Simulation output %s: write failed: %s, recording stopped", output_path,
+                      strerror(errno));
+            close(output_fd);
+            output_fd = -1;
+            break;
+        }
+        data += n;
+        bytes -= (size_t)n;
+    }
+    output_fill = 0;
+}
+
+static void record_output(const sim_output_t *output, uint64_t value)
+{
+    sim_trace_record_t *record = &output_buffer[output_fill++];
+    record->scan               = htole64(scan);
+    record->index              = htole32(output->index);
+    record->type               = output->type;
+    record->bit                = output->bit;
+    record->reserved           = 0;
+    record->value              = htole64(value);
+    output_written++;
+    if (output_fill == SIM_OUTPUT_BUFFER_RECORDS)
+    {
+        flush_outputs();
+    }
+}
+
+static int open_input(void)
+{
+    int fd = open(input_path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        log_error("Simulation input %s: %s", input_path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(sim_trace_header_t) ||
+        (size - sizeof(sim_trace_header_t)) % sizeof(sim_trace_record_t) != 0)
+    {
+        log_error("Simulation input %s: not a trace file (size %zu)", input_path, size);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        log_error("Simulation input %s: %s", input_path, strerror(errno));
+        return -1;
+    }
+    input_map      = map;
+    input_map_size = size;
+
+    const sim_trace_header_t *header = map;
+    if (memcmp(header->magic, SIM_TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        le32toh(header->version) != SIM_TRACE_VERSION ||
+        le32toh(header->record_size) != sizeof(sim_trace_record_t))
+    {
+        log_error("Simulation input %s: not a version %d trace file", input_path,
+                  SIM_TRACE_VERSION);
+        return -1;
+    }
+    input_records = (const sim_trace_record_t *)(header + 1);
+    input_count   = (size - sizeof(*header)) / sizeof(sim_trace_record_t);
+    input_next    = 0;
+
+    // Checked once here, so applying a record needs no checks
+    size_t table_size = image_tables_size();
+    uint64_t previous = 0;
+    for (size_t i = 0; i < input_count; i++)
+    {
+        const sim_trace_record_t *record = &input_records[i];
+        uint64_t record_scan             = le64toh(record->scan);
+        bool bool_type                   = record->type <= JOURNAL_BOOL_MEMORY;
+        if (record->type >= JOURNAL_TYPE_COUNT || le32toh(record->index) >= table_size ||
+            record->bit >= (bool_type ? 8 : 1) || record_scan < previous)
+        {
+            log_error("Simulation input %s: record %zu is out of range or out of order",
+                      input_path, i);
+            return -1;
+        }
+        previous = record_scan;
+    }
+    return 0;
+}
+
+static int open_output(void)
+{
+    output_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (output_fd < 0)
+    {
+        log_error("Simulation output %s: %s", output_path, strerror(errno));
+        return -1;
+    }
+
+    sim_trace_header_t header;
+    memcpy(header.magic, SIM_TRACE_MAGIC, sizeof(header.magic));
+    header.version     = htole32(SIM_TRACE_VERSION);
+    header.record_size = htole32(sizeof(sim_trace_record_t));
+    if (write(output_fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+    {
+        log_error("Simulation output %s: %s", output_path, strerror(errno));
+        close(output_fd);
+        output_fd = -1;
+        return -1;
+    }
+    output_fill    = 0;
+    output_written = 0;
+    simulation_bind_outputs();
+    return 0;
+}
+
+void simulation_bind_outputs(void)
+{
+    if (output_fd < 0)
+    {
+        return;
+    }
+
+    size_t total = 0;
+    for (size_t t = 0; t < sizeof(output_types) / sizeof(output_types[0]); t++)
+    {
+        total += image_tables_bound_slots(output_types[t], NULL, 0);
+    }
+
+    sim_output_t *bound = realloc(outputs, (total ? total : 1) * sizeof(*bound));
+    uint32_t *slots     = malloc((total ? total : 1) * sizeof(*slots));
+    if (bound == NULL || slots == NULL)
+    {
+        log_error("Simulation output %s: out of memory, recording stopped", output_path);
+        free(slots);
+        close(output_fd);
+        output_fd    = -1;
+        output_count = 0;
+        return;
+    }
+    outputs      = bound;
+    output_count = 0;
+
+    for (size_t t = 0; t < sizeof(output_types) / sizeof(output_types[0]); t++)
+    {
+        journal_buffer_type_t type = output_types[t];
+        bool bool_type             = type == JOURNAL_BOOL_OUTPUT;
+        size_t count               = image_tables_bound_slots(type, slots, total);
+        for (size_t i = 0; i < count; i++)
+        {
+            sim_output_t *output = &outputs[output_count++];
+            output->type         = (uint8_t)type;
+            output->index        = bool_type ? slots[i] / 8 : slots[i];
+            output->bit          = (uint8_t)(bool_type ? slots[i] % 8 : 0);
+            output->width        = (uint8_t)journal_type_width(type);
+            output->addr         = entry_addr(output->type, output->index, output->bit);
+        }
+    }
+    free(slots);
+    outputs_fresh = true;
+}
+
+int simulation_start(void)
+{
+    scan            = 0;
+    input_count     = 0;
+    input_next      = 0;
+    output_count    = 0;
+    output_written  = 0;
+
+    if (input_path != NULL && open_input() != 0)
+    {
+        simulation_finish(false);
+        return -1;
+    }
+    if (output_path != NULL && open_output() != 0)
+    {
+        simulation_finish(false);
+        return -1;
+    }
+
+    log_info("Simulation: free-running on the virtual clock, %zu input records, %zu outputs "
+             "recorded",
+             input_count, output_count);
+    running  = true;
+    start_ns = sim_now_ns();
+    return 0;
+}
+
+void simulation_cycle_start(void)
+{
+    while (input_next < input_count && le64toh(input_records[input_next].scan) <= scan)
+    {
+        const sim_trace_record_t *record = &input_records[input_next++];
+        void *addr = entry_addr(record->type, le32toh(record->index), record->bit);
+        if (addr != NULL)
+        {
+            uint64_t value = le64toh(record->value);
+            if (record->type <= JOURNAL_BOOL_MEMORY)
+            {
+                value = value != 0;
+            }
+            store_value(addr, journal_type_width(record->type), value);
+        }
+    }
+}
+
+bool simulation_cycle_end(void)
+{
+    if (output_fd >= 0)
+    {
+        for (size_t i = 0; i < output_count; i++)
+        {
+            sim_output_t *output = &outputs[i];
+            uint64_t value       = load_value(output->addr, output->width);
+            if (outputs_fresh || value != output->last)
+            {
+                output->last = value;
+                record_output(output, value);
+            }
+        }
+        outputs_fresh = false;
+    }
+
+    scan++;
+    if (max_scans > 0)
+    {
+        return scan < max_scans;
+    }
+    return input_path == NULL || input_next < input_count;
+}
+
+void simulation_finish(bool complete)
+{
+    if (running)
+    {
+        uint64_t elapsed_ns = sim_now_ns() - start_ns;
+        double seconds      = elapsed_ns > 0 ? (double)elapsed_ns / 1e9 : 1e-9;
+        double virtual_s    = ext_common_ticktime__ != NULL
+                                  ? (double)scan * (double)*ext_common_ticktime__ / 1e9
+                                  : 0.0;
+        log_info("Simulation: %llu scans in %.3f s (%.0f scans/s), %.3f s of virtual time "
+                 "(%.1fx real time), %zu input records applied, %llu output changes recorded",
+                 (unsigned long long)scan, seconds, (double)scan / seconds, virtual_s,
+                 virtual_s / seconds, input_next, (unsigned long long)output_written);
+    }
+    running = false;
+
+    if (output_fd >= 0)
+    {
+        flush_outputs();
+    }
+    if (output_fd >= 0)
+    {
+        close(output_fd);
+        output_fd = -1;
+    }
+    if (input_map != NULL)
+    {
+        munmap(input_map, input_map_size);
+        input_map = NULL;
+    }
+    input_count   = 0;
+    input_records = NULL;
+
+    // A batch run is over, shut the runtime down like SIGINT does
+    if (complete)
+    {
+        keep_running = 0;
+    }
+}
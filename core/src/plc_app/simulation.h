@@ -0,0 +1,123 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file simulation.h
+ * @brief Free-running scans on a virtual clock, for offline validation
+ *
+ * With --simulate the scan thread starts the next cycle as soon as one ends
+ * instead of sleeping until its slot. tick__ and the IEC time base still move
+ * one tick time per scan, so the program sees the same time it would see in
+ * real time and timers expire after the same number of scans, only sooner.
+ * The program runs as a single task and event triggers are not served.
+ *
+ * Inputs can be fed from a trace file (--sim-input), memory-mapped and applied
+ * at the start of the scans its records name, after the plugin writes. The
+ * outputs the program bound can be recorded to a trace file (--sim-output):
+ * their values in the first scan, then every change. The run ends after
+ * --sim-scans scans, or after the last input record without it, and the
+ * runtime then logs the scans per second and exits. Without either it runs
+ * until stopped.
+ *
+ * Trace file: a sim_trace_header_t, then sim_trace_record_t records, both in
+ * little-endian byte order. Input records must be sorted by scan.
+ * scripts/sim-trace.py converts traces from and to CSV.
+ */
+
+#define SIM_TRACE_MAGIC "OPLCSIM1"
+#define SIM_TRACE_VERSION 1
+
+typedef struct
+{
+    char magic[8]; // SIM_TRACE_MAGIC, not terminated
+    uint32_t version;
+    uint32_t record_size; // sizeof(sim_trace_record_t)
+} sim_trace_header_t;
+
+typedef struct
+{
+    uint64_t scan;     // Scan the value applies from (inputs) or changed in (outputs), from 0
+    uint32_t index;    // Image table index
+    uint8_t type;      // Area, journal_buffer_type_t
+    uint8_t bit;       // Bit of BOOL areas, 0 otherwise
+    uint16_t reserved; // 0
+    uint64_t value;    // Zero extended value
+} sim_trace_record_t;
+
+_Static_assert(sizeof(sim_trace_header_t) == 16, "trace header layout");
+_Static_assert(sizeof(sim_trace_record_t) == 24, "trace record layout");
+
+/**
+ * @brief Run the scans free on the virtual clock (--simulate)
+ */
+void simulation_set_enabled(bool enable);
+
+/**
+ * @brief Whether --simulate was given
+ */
+bool simulation_enabled(void);
+
+/**
+ * @brief Feed inputs from this trace file
+ * @return 0 on success, -1 if the path is empty
+ */
+int simulation_set_input(const char *path);
+
+/**
+ * @brief Record the bound outputs to this trace file, replaced if it exists
+ * @return 0 on success, -1 if the path is empty
+ */
+int simulation_set_output(const char *path);
+
+/**
+ * @brief End the run after this many scans, 0 for no limit
+ */
+void simulation_set_scans(uint64_t scans);
+
+/**
+ * @brief Open the traces of a run
+ *
+ * Called by the scan thread before its first cycle, with the program bound
+ * to the image tables. Checks every input record against the tables.
+ *
+ * @return 0 on success, -1 if a trace cannot be used (logged)
+ */
+int simulation_start(void);
+
+/**
+ * @brief Look up the outputs to record again, after an online change
+ *
+ * Called by the scan thread with the image mutex held.
+ */
+void simulation_bind_outputs(void);
+
+/**
+ * @brief Apply the input records of the scan about to run
+ *
+ * Called by the scan thread at the start of the cycle with the image mutex
+ * held.
+ */
+void simulation_cycle_start(void);
+
+/**
+ * @brief Record the outputs that changed and count the scan
+ *
+ * Called by the scan thread at the end of the cycle with the image mutex
+ * held.
+ *
+ * @return false once the run is complete
+ */
+bool simulation_cycle_end(void);
+
+/**
+ * @brief Close the traces and log the run
+ *
+ * @param complete The run ended by itself rather than by a stop, the runtime
+ *                 then exits
+ */
+void simulation_finish(bool complete);
+
+#endif // SIMULATION_H
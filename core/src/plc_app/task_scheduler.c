@@ -0,0 +1,598 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scan_cycle_manager.h"
+#include "task_scheduler.h"
+#include "utils/log.h"
+#include "utils/seqlock.h"
+#include "utils/utils.h"
+
+// Real-time scheduling and CPU affinity are only available on Linux
+#if !defined(__CYGWIN__) && !defined(__MSYS__)
+#define HAS_REALTIME_FEATURES 1
+#else
+#define HAS_REALTIME_FEATURES 0
+#endif
+
+#define TASK_NAME_MAX 64
+
+typedef struct
+{
+    char name[TASK_NAME_MAX];
+    int priority;
+    int cpu; // -1 keeps the affinity inherited from the scan thread
+} task_override_t;
+
+// Microseconds, written by the thread that runs the task
+typedef struct
+{
+    uint64_t runs;
+    uint64_t event_runs; // runs started by an event trigger, included in runs
+    uint64_t overruns;   // slots skipped because the previous run was late
+    int64_t exec_min;
+    int64_t exec_max;
+    int64_t exec_total;
+    int64_t latency_max; // start after the slot, task threads only
+    int64_t latency_total;
+    timing_histogram_t exec_hist;
+} task_stats_t;
+
+typedef struct
+{
+    const plc_task_info_t *info; // changed by an online change, under the write lock
+    char name[TASK_NAME_MAX];    // copied, the report outlives the program
+    unsigned long interval;
+    uint64_t period_ns;
+    int priority;
+    int cpu;
+    bool on_scan_thread;
+    bool has_thread;
+    bool triggered;      // under sleep_mutex, set by task_scheduler_trigger()
+    uint64_t trigger_ns; // under sleep_mutex
+    pthread_t thread;
+    atomic_uint stats_seq;
+    task_stats_t stats;
+} task_t;
+
+static bool enabled = false;
+static task_override_t overrides[TASK_MAX_COUNT];
+static size_t override_count = 0;
+
+static task_t tasks[TASK_MAX_COUNT];
+static size_t task_count = 0;
+
+// Written by the scan thread under report_mutex, which also keeps readers
+// of the task list (TASKS, online change checks) off it while it changes
+static bool active                  = false;
+static pthread_mutex_t report_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Task threads hold it for reading while they run the program
+static pthread_rwlock_t program_lock = PTHREAD_RWLOCK_INITIALIZER;
+static bool paused                   = false; // scan thread only
+
+// Task threads sleep on sleep_cond (PLC_CLOCK) until their next slot
+static pthread_mutex_t sleep_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sleep_cond;
+static pthread_once_t sleep_once = PTHREAD_ONCE_INIT;
+static bool stopping             = false;
+static uint64_t start_ns         = 0;
+
+static void sleep_cond_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, PLC_CLOCK);
+    pthread_cond_init(&sleep_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Latency is measured from slot_ns, the trigger time for event runs
+static void record_run(task_t *task, uint64_t slot_ns, uint64_t begin_ns, uint64_t end_ns,
+                       uint64_t skipped, bool event)
+{
+    int64_t exec    = (int64_t)(end_ns - begin_ns) / 1000;
+    int64_t latency = begin_ns > slot_ns ? (int64_t)(begin_ns - slot_ns) / 1000 : 0;
+    task_stats_t *s = &task->stats;
+
+    seq_write_begin(&task->stats_seq);
+    if (s->runs == 0 || exec < s->exec_min)
+    {
+        s->exec_min = exec;
+    }
+    if (exec > s->exec_max)
+    {
+        s->exec_max = exec;
+    }
+    if (latency > s->latency_max)
+    {
+        s->latency_max = latency;
+    }
+    s->exec_total += exec;
+    s->latency_total += latency;
+    s->overruns += skipped;
+    s->event_runs += event ? 1 : 0;
+    s->runs++;
+    timing_histogram_record(&s->exec_hist, exec);
+    seq_write_end(&task->stats_seq);
+}
+
+static void apply_thread_settings(task_t *task)
+{
+#if HAS_REALTIME_FEATURES
+    struct sched_param param = {.sched_priority = task->priority};
+    int err                  = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0)
+    {
+        log_error("Task %s: failed to set priority %d: %s", task->name, task->priority,
+                  strerror(err));
+    }
+
+    if (task->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(task->cpu, &set);
+        err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+        if (err != 0)
+        {
+            log_error("Task %s: failed to pin to CPU %d: %s", task->name, task->cpu,
+                      strerror(err));
+        }
+    }
+#else
+    (void)task;
+#endif
+}
+
+static void *task_main(void *arg)
+{
+    task_t *task = (task_t *)arg;
+    apply_thread_settings(task);
+
+    // All tasks run at tick 0, like the resource does on its first tick
+    uint64_t slot_ns = start_ns;
+
+    pthread_mutex_lock(&sleep_mutex);
+    while (!stopping)
+    {
+        struct timespec deadline = {.tv_sec  = (time_t)(slot_ns / 1000000000ULL),
+                                    .tv_nsec = (long)(slot_ns % 1000000000ULL)};
+        while (!stopping && !task->triggered &&
+               pthread_cond_timedwait(&sleep_cond, &sleep_mutex, &deadline) != ETIMEDOUT)
+        {
+        }
+        if (stopping)
+        {
+            break;
+        }
+        bool event       = task->triggered;
+        uint64_t from_ns = event ? task->trigger_ns : slot_ns;
+        task->triggered  = false;
+        pthread_mutex_unlock(&sleep_mutex);
+
+        pthread_rwlock_rdlock(&program_lock);
+        uint64_t begin_ns = now_ns();
+        task->info->body();
+        uint64_t end_ns = now_ns();
+        pthread_rwlock_unlock(&program_lock);
+
+        if (event)
+        {
+            // An extra run, the slot is kept
+            record_run(task, from_ns, begin_ns, end_ns, 0, true);
+            pthread_mutex_lock(&sleep_mutex);
+            continue;
+        }
+
+        // Slots already over when the run finished are skipped
+        uint64_t next_ns = slot_ns + task->period_ns;
+        uint64_t skipped = 0;
+        if (end_ns >= next_ns)
+        {
+            skipped = (end_ns - next_ns) / task->period_ns + 1;
+            next_ns += skipped * task->period_ns;
+        }
+        record_run(task, slot_ns, begin_ns, end_ns, skipped, false);
+        slot_ns = next_ns;
+
+        pthread_mutex_lock(&sleep_mutex);
+    }
+    pthread_mutex_unlock(&sleep_mutex);
+    return NULL;
+}
+
+void task_scheduler_set_enabled(bool enable)
+{
+    enabled = enable;
+}
+
+int task_scheduler_set_task(const char *text)
+{
+    if (override_count >= TASK_MAX_COUNT)
+    {
+        return -1;
+    }
+
+    task_override_t *entry = &overrides[override_count];
+    const char *colon      = strchr(text, ':');
+    size_t name_length     = colon != NULL ? (size_t)(colon - text) : 0;
+    if (name_length == 0 || name_length >= TASK_NAME_MAX)
+    {
+        return -1;
+    }
+
+    char *end;
+    long priority = strtol(colon + 1, &end, 10);
+    long cpu      = -1;
+    if (end == colon + 1 || priority < 1 || priority > 99)
+    {
+        return -1;
+    }
+    if (*end == ':')
+    {
+        const char *cpu_text = end + 1;
+        cpu                  = strtol(cpu_text, &end, 10);
+        if (end == cpu_text || cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            return -1;
+        }
+    }
+    if (*end != '\0')
+    {
+        return -1;
+    }
+
+    memcpy(entry->name, text, name_length);
+    entry->name[name_length] = '\0';
+    entry->priority          = (int)priority;
+    entry->cpu               = (int)cpu;
+    override_count++;
+    return 0;
+}
+
+// Default priority: below the scan thread, one step per shorter interval
+static int default_priority(const plc_task_info_t *table, size_t count, unsigned long interval)
+{
+    int rank = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        bool shorter = table[i].interval < interval;
+        for (size_t j = 0; shorter && j < i; j++)
+        {
+            shorter = table[j].interval != table[i].interval;
+        }
+        rank += shorter ? 1 : 0;
+    }
+    int priority = TASK_SCAN_PRIORITY - rank;
+    return priority < 1 ? 1 : priority;
+}
+
+bool task_scheduler_start(PluginManager *pm)
+{
+    if (!enabled)
+    {
+        return false;
+    }
+
+    const plc_task_info_t *table = plugin_manager_find_symbol(pm, TASK_TABLE_SYMBOL);
+    const unsigned int *count    = plugin_manager_find_symbol(pm, TASK_COUNT_SYMBOL);
+    if (table == NULL || count == NULL || *count == 0)
+    {
+        log_info("Multi-task: the program has no task table, running it as a single task");
+        return false;
+    }
+    if (*count > TASK_MAX_COUNT)
+    {
+        log_error("Multi-task: %u tasks, at most %d are supported, running them as a single task",
+                  *count, TASK_MAX_COUNT);
+        return false;
+    }
+
+    unsigned long base_interval = table[0].interval;
+    for (unsigned int i = 1; i < *count; i++)
+    {
+        if (table[i].interval < base_interval)
+        {
+            base_interval = table[i].interval;
+        }
+    }
+
+    pthread_once(&sleep_once, sleep_cond_init);
+
+    pthread_mutex_lock(&report_mutex);
+    task_count = *count;
+    for (size_t i = 0; i < task_count; i++)
+    {
+        task_t *task = &tasks[i];
+        memset(task, 0, sizeof(*task));
+        task->info           = &table[i];
+        task->interval       = table[i].interval;
+        task->period_ns      = (uint64_t)table[i].interval * *ext_common_ticktime__;
+        task->on_scan_thread = table[i].interval == base_interval;
+        task->priority       = task->on_scan_thread
+                                   ? TASK_SCAN_PRIORITY
+                                   : default_priority(table, task_count, table[i].interval);
+        task->cpu            = -1;
+        snprintf(task->name, sizeof(task->name), "%s", table[i].name);
+
+        for (size_t o = 0; o < override_count; o++)
+        {
+            if (strcmp(overrides[o].name, task->name) != 0)
+            {
+                continue;
+            }
+            if (task->on_scan_thread)
+            {
+                log_warn("Multi-task: %s has the shortest interval and runs on the scan thread, "
+                         "ignoring its priority",
+                         task->name);
+                break;
+            }
+            task->priority = overrides[o].priority;
+            task->cpu      = overrides[o].cpu;
+        }
+    }
+
+    stopping        = false;
+    paused          = false;
+    start_ns        = now_ns();
+    size_t threaded = 0;
+    for (size_t i = 0; i < task_count; i++)
+    {
+        task_t *task = &tasks[i];
+        if (task->on_scan_thread)
+        {
+            continue;
+        }
+        if (pthread_create(&task->thread, NULL, task_main, task) != 0)
+        {
+            // Still runs, only without its own priority
+            log_error("Multi-task: failed to create the thread of %s, running it on the scan "
+                      "thread",
+                      task->name);
+            task->on_scan_thread = true;
+            continue;
+        }
+        task->has_thread = true;
+        threaded++;
+    }
+    active = true;
+    pthread_mutex_unlock(&report_mutex);
+
+    log_info("Multi-task: %zu tasks, %zu on their own threads", task_count, threaded);
+    return true;
+}
+
+void task_scheduler_run(unsigned long tick)
+{
+    for (size_t i = 0; i < task_count; i++)
+    {
+        task_t *task = &tasks[i];
+        if (task->on_scan_thread && tick % task->interval == 0)
+        {
+            uint64_t begin_ns = now_ns();
+            task->info->body();
+            record_run(task, begin_ns, begin_ns, now_ns(), 0, false);
+        }
+    }
+}
+
+int task_scheduler_find(const char *name)
+{
+    for (size_t i = 0; active && i < task_count; i++)
+    {
+        if (strcmp(tasks[i].name, name) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void task_scheduler_trigger(unsigned int mask)
+{
+    bool wake = false;
+    for (size_t i = 0; i < task_count; i++)
+    {
+        task_t *task = &tasks[i];
+        if ((mask & (1u << i)) == 0)
+        {
+            continue;
+        }
+        if (task->has_thread)
+        {
+            wake = true;
+            continue;
+        }
+        uint64_t begin_ns = now_ns();
+        task->info->body();
+        record_run(task, begin_ns, begin_ns, now_ns(), 0, true);
+    }
+    if (!wake)
+    {
+        return;
+    }
+
+    uint64_t trigger_ns = now_ns();
+    pthread_mutex_lock(&sleep_mutex);
+    for (size_t i = 0; i < task_count; i++)
+    {
+        task_t *task = &tasks[i];
+        if ((mask & (1u << i)) != 0 && task->has_thread && !task->triggered)
+        {
+            task->triggered  = true;
+            task->trigger_ns = trigger_ns;
+        }
+    }
+    pthread_cond_broadcast(&sleep_cond);
+    pthread_mutex_unlock(&sleep_mutex);
+}
+
+void task_scheduler_stop(void)
+{
+    if (!active)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&sleep_mutex);
+    stopping = true;
+    pthread_cond_broadcast(&sleep_cond);
+    pthread_mutex_unlock(&sleep_mutex);
+
+    for (size_t i = 0; i < task_count; i++)
+    {
+        if (tasks[i].has_thread)
+        {
+            pthread_join(tasks[i].thread, NULL);
+            tasks[i].has_thread = false;
+        }
+    }
+    if (paused)
+    {
+        paused = false;
+        pthread_rwlock_unlock(&program_lock);
+    }
+
+    pthread_mutex_lock(&report_mutex);
+    active = false;
+    pthread_mutex_unlock(&report_mutex);
+    log_info("Multi-task: task threads stopped");
+}
+
+int task_scheduler_check(PluginManager *next, const plc_task_info_t **table)
+{
+    *table = NULL;
+
+    pthread_mutex_lock(&report_mutex);
+    if (!active)
+    {
+        pthread_mutex_unlock(&report_mutex);
+        return 0;
+    }
+
+    const plc_task_info_t *next_table = plugin_manager_find_symbol(next, TASK_TABLE_SYMBOL);
+    const unsigned int *next_count    = plugin_manager_find_symbol(next, TASK_COUNT_SYMBOL);
+    bool same = next_table != NULL && next_count != NULL && *next_count == task_count;
+    for (size_t i = 0; same && i < task_count; i++)
+    {
+        same = strcmp(next_table[i].name, tasks[i].name) == 0 &&
+               next_table[i].interval == tasks[i].interval;
+    }
+    pthread_mutex_unlock(&report_mutex);
+
+    if (!same)
+    {
+        log_error("Online change: the tasks changed, a restart is required");
+        return -1;
+    }
+    *table = next_table;
+    return 0;
+}
+
+bool task_scheduler_pause(void)
+{
+    if (!active)
+    {
+        return true;
+    }
+    if (pthread_rwlock_trywrlock(&program_lock) != 0)
+    {
+        return false;
+    }
+    paused = true;
+    return true;
+}
+
+void task_scheduler_resume(const plc_task_info_t *table)
+{
+    if (table != NULL)
+    {
+        for (size_t i = 0; i < task_count; i++)
+        {
+            tasks[i].info = &table[i];
+        }
+    }
+    if (paused)
+    {
+        paused = false;
+        pthread_rwlock_unlock(&program_lock);
+    }
+}
+
+static bool format_task(char *buffer, size_t buffer_size, size_t *written, task_t *task)
+{
+    // Copies are large, keep them off the caller's stack (report_mutex held)
+    static task_stats_t s;
+    unsigned seq;
+    do
+    {
+        seq = seq_read_begin(&task->stats_seq);
+        memcpy(&s, &task->stats, sizeof(s));
+    } while (seq_read_retry(&task->stats_seq, seq));
+
+    bool ok = timing_format_append(
+        buffer, buffer_size, written,
+        "{\"name\":\"%s\",\"interval_ns\":%" PRIu64 ",\"scan_thread\":%s,\"priority\":%d,"
+        "\"cpu\":%d,\"runs\":%" PRIu64 ",\"event_runs\":%" PRIu64 ",\"overruns\":%" PRIu64 ",",
+        task->name, task->period_ns, task->on_scan_thread ? "true" : "false", task->priority,
+        task->cpu, s.runs, s.event_runs, s.overruns);
+    if (ok && s.runs > 0)
+    {
+        ok = timing_format_append(buffer, buffer_size, written,
+                                  "\"exec_time_min\":%" PRId64 ",\"exec_time_max\":%" PRId64
+                                  ",\"exec_time_avg\":%" PRId64 ",\"latency_max\":%" PRId64
+                                  ",\"latency_avg\":%" PRId64 ",",
+                                  s.exec_min, s.exec_max, s.exec_total / (int64_t)s.runs,
+                                  s.latency_max, s.latency_total / (int64_t)s.runs);
+    }
+    else if (ok)
+    {
+        ok = timing_format_append(buffer, buffer_size, written,
+                                  "\"exec_time_min\":null,\"exec_time_max\":null,"
+                                  "\"exec_time_avg\":null,\"latency_max\":null,"
+                                  "\"latency_avg\":null,");
+    }
+    return ok && timing_format_append(buffer, buffer_size, written, "\"exec_time\":{") &&
+           timing_histogram_format_fields(buffer, buffer_size, written, &s.exec_hist) &&
+           timing_format_append(buffer, buffer_size, written, "}}");
+}
+
+int format_task_stats_response(char *buffer, size_t buffer_size)
+{
+    pthread_mutex_lock(&report_mutex);
+
+    size_t written = 0;
+    bool ok        = timing_format_append(buffer, buffer_size, &written,
+                                          "TASKS:{\"multi_task\":%s,\"tasks\":[",
+                                          active ? "true" : "false");
+    for (size_t i = 0; ok && active && i < task_count; i++)
+    {
+        ok = (i == 0 || timing_format_append(buffer, buffer_size, &written, ",")) &&
+             format_task(buffer, buffer_size, &written, &tasks[i]);
+    }
+    ok = ok && timing_format_append(buffer, buffer_size, &written, "]}\n");
+
+    pthread_mutex_unlock(&report_mutex);
+
+    if (!ok)
+    {
+        return snprintf(buffer, buffer_size, "TASKS:ERROR\n");
+    }
+    return (int)written;
+}
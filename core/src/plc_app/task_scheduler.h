@@ -0,0 +1,152 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "plcapp_manager.h"
+
+/**
+ * @file task_scheduler.h
+ * @brief Run the IEC tasks of a program on separate periodic threads
+ *
+ * Normally the scan thread calls config_run__() every common tick and the
+ * resource runs each task whose interval divides the tick. With multi-task
+ * scheduling enabled (--multi-task) and a program built with a task table
+ * (scripts/generate-tasks.py), the tasks with the shortest interval still
+ * run on the scan thread, and every other task runs on its own SCHED_FIFO
+ * thread at its own interval, priority and CPU. A slow task then no longer
+ * stretches the scans of a fast one.
+ *
+ * Locking model:
+ * - The scan thread keeps every image table duty (journal, plugin hooks,
+ *   shadow, debug, retain) and holds buffer_mutex for them as before.
+ * - Task threads run their programs without buffer_mutex. They only read and
+ *   write variables, never the image table pointers, which change only while
+ *   the task threads are stopped or paused (program load and online change).
+ *   Values a task shares with plugins or other tasks are exchanged at the
+ *   granularity of the scan thread, like the process image of a PLC task.
+ *   Element-sized values are never torn, but a task can see another task's
+ *   variables change during its run, as with preemptive tasks on a PLC.
+ * - Task threads hold a read lock on the program while they run. An online
+ *   change takes it for writing between two scans without waiting, so it is
+ *   applied at the first scan boundary where no task thread is running.
+ */
+
+// Symbols of the task table, see scripts/generate-tasks.py
+#define TASK_TABLE_SYMBOL "plc_tasks"
+#define TASK_COUNT_SYMBOL "plc_task_count"
+
+#define TASK_MAX_COUNT 16
+
+// SCHED_FIFO priority of the scan thread (set_realtime_priority). Other tasks
+// default to the priorities below it, shorter intervals first.
+#define TASK_SCAN_PRIORITY 20
+
+// One element of the task table
+typedef struct
+{
+    const char *name;
+    unsigned long interval; // in common ticks
+    void (*body)(void);     // runs the programs of the task once
+} plc_task_info_t;
+
+/**
+ * @brief Enable running tasks on separate threads
+ *
+ * Programs without a task table always run as a single task. Call before the
+ * PLC is first started.
+ *
+ * @param enable true to run tasks on separate threads
+ */
+void task_scheduler_set_enabled(bool enable);
+
+/**
+ * @brief Override the priority and CPU of a task thread
+ *
+ * @param text "NAME:PRIORITY" or "NAME:PRIORITY:CPU", priority 1 to 99
+ * @return 0 on success, -1 if the text is invalid or too many tasks are set
+ */
+int task_scheduler_set_task(const char *text);
+
+/**
+ * @brief Start the task threads of a program
+ *
+ * Called by the scan thread after the program is initialized and glued.
+ *
+ * @param pm The loaded program
+ * @return true if tasks are run by task_scheduler_run() and the task
+ *         threads, false if the scan thread must call config_run__()
+ */
+bool task_scheduler_start(PluginManager *pm);
+
+/**
+ * @brief Run the tasks assigned to the scan thread that are due at tick
+ */
+void task_scheduler_run(unsigned long tick);
+
+/**
+ * @brief Find a task of the running program by name
+ *
+ * @return Its index, -1 if there is no such task or tasks are not run on
+ *         separate threads
+ */
+int task_scheduler_find(const char *name);
+
+/**
+ * @brief Run tasks once now, outside their schedule
+ *
+ * Called by the scan thread for event scans. Tasks on the scan thread run
+ * before it returns, task threads are woken for an extra run and keep their
+ * next slot. A thread already triggered and not yet running is not
+ * triggered twice.
+ *
+ * @param mask Bit i set to run the task at index i
+ */
+void task_scheduler_trigger(unsigned int mask);
+
+/**
+ * @brief Stop and join the task threads
+ *
+ * Called by the scan thread when it leaves its loop. A task thread sleeping
+ * until its next run is woken; one that is running finishes its run first.
+ */
+void task_scheduler_stop(void);
+
+/**
+ * @brief Check that a program can replace the running one online
+ *
+ * The running task threads keep their intervals, priorities and CPUs, so the
+ * new program must have the same tasks.
+ *
+ * @param next The new program
+ * @param tasks Receives the new task table, NULL if tasks are not running
+ *              on separate threads
+ * @return 0 if the program can be switched online, -1 otherwise (logged)
+ */
+int task_scheduler_check(PluginManager *next, const plc_task_info_t **tasks);
+
+/**
+ * @brief Keep task threads from starting a run, without waiting
+ *
+ * @return true if no task thread is running (always when tasks are not run on
+ *         separate threads), false if the caller should try again later
+ */
+bool task_scheduler_pause(void);
+
+/**
+ * @brief Install the task table of a new program and let task threads run
+ *
+ * @param tasks The table from task_scheduler_check(), or NULL to keep the
+ *              current one
+ */
+void task_scheduler_resume(const plc_task_info_t *tasks);
+
+/**
+ * @brief Format per-task timing for the TASKS command
+ *
+ * @return The number of characters written
+ */
+int format_task_stats_response(char *buffer, size_t buffer_size);
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,554 @@
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "debug_handler.h"
+#include "image_tables.h"
+#include "plc_state_manager.h"
+#include "trace_recorder.h"
+#include "utils/log.h"
+#include "utils/utils.h"
+
+#define TRACE_RECORD_HEADER 4
+#define TRACE_CONFIGURE_TAIL 23 // pre, post, decimation, trigger index, mode, op, type, threshold
+#define TRACE_READ_HEADER 12
+
+typedef union
+{
+    int64_t i;
+    uint64_t u;
+    double f;
+} trace_threshold_t;
+
+typedef struct
+{
+    uint16_t count;
+    void *addr[TRACE_MAX_VARS];
+    uint16_t size[TRACE_MAX_VARS];
+    size_t record_size;
+    uint32_t depth;
+    uint32_t pre;
+    uint32_t post;
+    uint16_t decimation;
+    uint8_t mode;
+    uint8_t op;
+    uint8_t type;
+    void *trigger_addr;
+    uint16_t trigger_size;
+    trace_threshold_t threshold;
+} trace_config_t;
+
+// Written by the debug handler while no capture runs, read by the scan thread
+// while one does
+static trace_config_t config;
+static atomic_bool configured = false;
+
+// The scan thread owns ARMED -> TRIGGERED -> DONE; the handler moves to
+// ARMED and, for a stop, to IDLE. `sampling` is set while the scan thread
+// records, so a stop can wait until the buffer is no longer touched.
+static atomic_int trace_state     = TRACE_STATE_IDLE;
+static atomic_bool sampling       = false;
+static atomic_bool force_pending  = false;
+static atomic_uint progress_count = 0;
+
+// Scan thread state of the running capture, read by the handler once the
+// state it published says the values are final
+static uint8_t trace_buffer[TRACE_BUFFER_SIZE];
+static uint32_t records_written;
+static uint32_t trigger_record;
+static uint32_t trigger_tick;
+static uint32_t post_remaining;
+static uint16_t scans_to_next;
+static bool last_condition;
+static bool have_condition;
+
+static bool compare_signed(int64_t value, int64_t threshold)
+{
+    switch (config.op)
+    {
+    case TRACE_OP_GREATER:
+        return value > threshold;
+    case TRACE_OP_LESS:
+        return value < threshold;
+    case TRACE_OP_EQUAL:
+        return value == threshold;
+    default:
+        return value != threshold;
+    }
+}
+
+static bool compare_unsigned(uint64_t value, uint64_t threshold)
+{
+    switch (config.op)
+    {
+    case TRACE_OP_GREATER:
+        return value > threshold;
+    case TRACE_OP_LESS:
+        return value < threshold;
+    case TRACE_OP_EQUAL:
+        return value == threshold;
+    default:
+        return value != threshold;
+    }
+}
+
+static bool compare_real(double value, double threshold)
+{
+    switch (config.op)
+    {
+    case TRACE_OP_GREATER:
+        return value > threshold;
+    case TRACE_OP_LESS:
+        return value < threshold;
+    case TRACE_OP_EQUAL:
+        return value == threshold;
+    default:
+        return value != threshold;
+    }
+}
+
+static bool trigger_condition(void)
+{
+    const void *addr = config.trigger_addr;
+
+    if (config.type == TRACE_TYPE_REAL)
+    {
+        if (config.trigger_size == sizeof(float))
+        {
+            float value;
+            memcpy(&value, addr, sizeof(value));
+            return compare_real(value, config.threshold.f);
+        }
+        double value;
+        memcpy(&value, addr, sizeof(value));
+        return compare_real(value, config.threshold.f);
+    }
+
+    if (config.type == TRACE_TYPE_UNSIGNED)
+    {
+        switch (config.trigger_size)
+        {
+        case 1:
+            return compare_unsigned(*(const uint8_t *)addr, config.threshold.u);
+        case 2:
+            return compare_unsigned(*(const uint16_t *)addr, config.threshold.u);
+        case 4:
+            return compare_unsigned(*(const uint32_t *)addr, config.threshold.u);
+        default:
+            return compare_unsigned(*(const uint64_t *)addr, config.threshold.u);
+        }
+    }
+
+    switch (config.trigger_size)
+    {
+    case 1:
+        return compare_signed(*(const int8_t *)addr, config.threshold.i);
+    case 2:
+        return compare_signed(*(const int16_t *)addr, config.threshold.i);
+    case 4:
+        return compare_signed(*(const int32_t *)addr, config.threshold.i);
+    default:
+        return compare_signed(*(const int64_t *)addr, config.threshold.i);
+    }
+}
+
+// Evaluated on every sample so edges are seen against the previous sample
+static bool trigger_fired(void)
+{
+    if (config.mode == TRACE_TRIGGER_NONE)
+    {
+        return true;
+    }
+
+    bool condition = trigger_condition();
+    bool previous  = last_condition;
+    bool baseline  = have_condition;
+    last_condition = condition;
+    have_condition = true;
+
+    switch (config.mode)
+    {
+    case TRACE_TRIGGER_RISING:
+        return baseline && !previous && condition;
+    case TRACE_TRIGGER_FALLING:
+        return baseline && previous && !condition;
+    default:
+        return condition;
+    }
+}
+
+static void finish_state(int from, int to)
+{
+    // Fails only if the handler stopped the capture meanwhile
+    atomic_compare_exchange_strong(&trace_state, &from, to);
+}
+
+static void record_sample(int state)
+{
+    if (scans_to_next > 1)
+    {
+        scans_to_next--;
+        return;
+    }
+    scans_to_next = config.decimation;
+
+    uint32_t index  = records_written;
+    uint32_t tick   = (uint32_t)tick__;
+    uint8_t *record = &trace_buffer[(size_t)(index % config.depth) * config.record_size];
+    memcpy(record, &tick, TRACE_RECORD_HEADER);
+
+    size_t offset = TRACE_RECORD_HEADER;
+    for (uint16_t i = 0; i < config.count; i++)
+    {
+        memcpy(&record[offset], config.addr[i], config.size[i]);
+        offset += config.size[i];
+    }
+    records_written = index + 1;
+    atomic_store_explicit(&progress_count, records_written, memory_order_relaxed);
+
+    if (state == TRACE_STATE_ARMED)
+    {
+        // Hold the trigger until the pre-trigger window is filled, unless forced
+        bool forced = atomic_load_explicit(&force_pending, memory_order_relaxed);
+        bool fired  = trigger_fired();
+        if (!forced && (!fired || index < config.pre))
+        {
+            return;
+        }
+
+        trigger_record = index;
+        trigger_tick   = tick;
+        post_remaining = config.post - 1;
+        finish_state(TRACE_STATE_ARMED,
+                     post_remaining == 0 ? TRACE_STATE_DONE : TRACE_STATE_TRIGGERED);
+        return;
+    }
+
+    if (--post_remaining == 0)
+    {
+        finish_state(TRACE_STATE_TRIGGERED, TRACE_STATE_DONE);
+    }
+}
+
+void trace_recorder_sample(void)
+{
+    // Cheap exit while no capture runs
+    int state = atomic_load_explicit(&trace_state, memory_order_relaxed);
+    if (state != TRACE_STATE_ARMED && state != TRACE_STATE_TRIGGERED)
+    {
+        return;
+    }
+
+    // Pairs with stop_capture(): either the stop is seen here, or the stop
+    // sees `sampling` and waits for this sample to finish
+    atomic_store(&sampling, true);
+    state = atomic_load(&trace_state);
+    if (state == TRACE_STATE_ARMED || state == TRACE_STATE_TRIGGERED)
+    {
+        record_sample(state);
+    }
+    atomic_store_explicit(&sampling, false, memory_order_release);
+}
+
+static void stop_capture(void)
+{
+    atomic_store(&trace_state, TRACE_STATE_IDLE);
+    while (atomic_load(&sampling))
+    {
+        sched_yield();
+    }
+}
+
+void trace_recorder_invalidate(void)
+{
+    stop_capture();
+    atomic_store(&configured, false);
+}
+
+static uint32_t read_u32(const uint8_t *data)
+{
+    return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+static void write_u32(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)(value & 0xFF);
+}
+
+// Samples before the trigger that are part of the capture
+static uint32_t pre_kept(void)
+{
+    return trigger_record < config.pre ? trigger_record : config.pre;
+}
+
+static bool capture_running(void)
+{
+    int state = atomic_load(&trace_state);
+    return state == TRACE_STATE_ARMED || state == TRACE_STATE_TRIGGERED;
+}
+
+static uint8_t trace_configure(const uint8_t *data, size_t length)
+{
+    if (capture_running())
+    {
+        return MB_DEBUG_ERROR_INVALID_STATE;
+    }
+    if (length < 4 || plc_get_state() != PLC_STATE_RUNNING || ext_get_var_count == NULL)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+    }
+
+    uint16_t count = (uint16_t)data[2] << 8 | data[3];
+    if (count == 0 || count > TRACE_MAX_VARS)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_MEMORY;
+    }
+    if (length < 4 + (size_t)count * 2 + TRACE_CONFIGURE_TAIL)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+    }
+
+    uint16_t variable_count = ext_get_var_count();
+    trace_config_t next;
+    size_t sample_size = 0;
+
+    next.count = count;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint16_t varidx = (uint16_t)data[4 + i * 2] << 8 | data[5 + i * 2];
+        if (varidx >= variable_count)
+        {
+            return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        }
+        next.addr[i] = ext_get_var_addr(varidx);
+        next.size[i] = (uint16_t)ext_get_var_size(varidx);
+        sample_size += next.size[i];
+    }
+    if (sample_size > TRACE_MAX_SAMPLE_SIZE)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_MEMORY;
+    }
+
+    const uint8_t *tail = &data[4 + count * 2];
+    next.pre            = read_u32(&tail[0]);
+    next.post           = read_u32(&tail[4]);
+    next.decimation     = (uint16_t)tail[8] << 8 | tail[9];
+    uint16_t trigger    = (uint16_t)tail[10] << 8 | tail[11];
+    next.mode           = tail[12];
+    next.op             = tail[13];
+    next.type           = tail[14];
+    next.threshold.u    = (uint64_t)read_u32(&tail[15]) << 32 | read_u32(&tail[19]);
+
+    next.record_size = TRACE_RECORD_HEADER + sample_size;
+    next.depth       = (uint32_t)(TRACE_BUFFER_SIZE / next.record_size);
+    if (next.post == 0 || next.pre > next.depth || next.post > next.depth - next.pre)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_MEMORY;
+    }
+    if (next.decimation == 0)
+    {
+        next.decimation = 1;
+    }
+
+    if (next.mode > TRACE_TRIGGER_LEVEL || next.op > TRACE_OP_NOT_EQUAL ||
+        next.type > TRACE_TYPE_REAL)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+    }
+
+    next.trigger_addr = NULL;
+    next.trigger_size = 0;
+    if (next.mode != TRACE_TRIGGER_NONE)
+    {
+        if (trigger >= variable_count)
+        {
+            return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        }
+        next.trigger_addr = ext_get_var_addr(trigger);
+        next.trigger_size = (uint16_t)ext_get_var_size(trigger);
+
+        bool size_ok = next.type == TRACE_TYPE_REAL
+                           ? next.trigger_size == sizeof(float) ||
+                                 next.trigger_size == sizeof(double)
+                           : next.trigger_size == 1 || next.trigger_size == 2 ||
+                                 next.trigger_size == 4 || next.trigger_size == 8;
+        if (!size_ok)
+        {
+            return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        }
+    }
+
+    memcpy(&config, &next, sizeof(config));
+    atomic_store(&configured, true);
+    atomic_store(&trace_state, TRACE_STATE_IDLE);
+
+    log_info("Trace configured: %u variables, %u+%u samples of %zu bytes", count, next.pre,
+             next.post, sample_size);
+    return MB_DEBUG_SUCCESS;
+}
+
+static uint8_t trace_arm(void)
+{
+    if (!atomic_load(&configured) || plc_get_state() != PLC_STATE_RUNNING)
+    {
+        return MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+    }
+    if (capture_running())
+    {
+        return MB_DEBUG_ERROR_INVALID_STATE;
+    }
+
+    records_written = 0;
+    trigger_record  = 0;
+    trigger_tick    = 0;
+    scans_to_next   = 1;
+    have_condition  = false;
+    last_condition  = false;
+    atomic_store(&force_pending, false);
+    atomic_store(&progress_count, 0);
+
+    // Publishes the reset state above to the scan thread
+    atomic_store(&trace_state, TRACE_STATE_ARMED);
+    return MB_DEBUG_SUCCESS;
+}
+
+static size_t trace_status(uint8_t *data)
+{
+    int state         = atomic_load(&trace_state);
+    uint32_t captured = 0;
+    uint32_t position = 0;
+    uint32_t tick     = 0;
+
+    if (state == TRACE_STATE_DONE)
+    {
+        captured = pre_kept() + config.post;
+        position = pre_kept();
+        tick     = trigger_tick;
+    }
+    else if (state == TRACE_STATE_ARMED || state == TRACE_STATE_TRIGGERED)
+    {
+        captured = atomic_load_explicit(&progress_count, memory_order_relaxed);
+        if (captured > config.depth)
+        {
+            captured = config.depth;
+        }
+        if (state == TRACE_STATE_TRIGGERED)
+        {
+            position = pre_kept();
+            tick     = trigger_tick;
+        }
+    }
+
+    bool ready     = atomic_load(&configured);
+    uint16_t rsize = ready ? (uint16_t)config.record_size : 0;
+    uint32_t depth = ready ? config.depth : 0;
+
+    data[1] = MB_DEBUG_SUCCESS;
+    data[2] = (uint8_t)state;
+    write_u32(&data[3], captured);
+    write_u32(&data[7], position);
+    write_u32(&data[11], tick);
+    write_u32(&data[15], depth);
+    data[19] = (uint8_t)(rsize >> 8);
+    data[20] = (uint8_t)(rsize & 0xFF);
+    return 21;
+}
+
+static size_t trace_read(uint8_t *data, size_t length, size_t frame_size)
+{
+    if (atomic_load(&trace_state) != TRACE_STATE_DONE)
+    {
+        data[1] = MB_DEBUG_ERROR_INVALID_STATE;
+        return 2;
+    }
+
+    uint32_t total = pre_kept() + config.post;
+    uint32_t first = length >= 6 ? read_u32(&data[2]) : 0;
+    if (first > total)
+    {
+        data[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return 2;
+    }
+
+    uint32_t count = (uint32_t)((frame_size - TRACE_READ_HEADER) / config.record_size);
+    if (count > total - first)
+    {
+        count = total - first;
+    }
+    if (count > 0xFFFF)
+    {
+        count = 0xFFFF;
+    }
+
+    uint32_t start  = trigger_record - pre_kept() + first;
+    uint8_t *record = &data[TRACE_READ_HEADER];
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t *stored =
+            &trace_buffer[(size_t)((start + i) % config.depth) * config.record_size];
+
+        uint32_t tick;
+        memcpy(&tick, stored, TRACE_RECORD_HEADER);
+        write_u32(record, tick);
+        memcpy(&record[TRACE_RECORD_HEADER], &stored[TRACE_RECORD_HEADER],
+               config.record_size - TRACE_RECORD_HEADER);
+        record += config.record_size;
+    }
+
+    data[1] = MB_DEBUG_SUCCESS;
+    write_u32(&data[2], total);
+    write_u32(&data[6], first);
+    data[10] = (uint8_t)(count >> 8);
+    data[11] = (uint8_t)(count & 0xFF);
+    return TRACE_READ_HEADER + (size_t)count * config.record_size;
+}
+
+size_t trace_recorder_handle_request(uint8_t *data, size_t length, size_t frame_size)
+{
+    data[0] = MB_FC_DEBUG_TRACE;
+    if (length < 2)
+    {
+        data[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return 2;
+    }
+
+    switch (data[1])
+    {
+    case TRACE_CMD_CONFIGURE:
+        data[1] = trace_configure(data, length);
+        return 2;
+
+    case TRACE_CMD_ARM:
+        data[1] = trace_arm();
+        return 2;
+
+    case TRACE_CMD_FORCE:
+        if (atomic_load(&trace_state) != TRACE_STATE_ARMED)
+        {
+            data[1] = MB_DEBUG_ERROR_INVALID_STATE;
+            return 2;
+        }
+        atomic_store(&force_pending, true);
+        data[1] = MB_DEBUG_SUCCESS;
+        return 2;
+
+    case TRACE_CMD_STOP:
+        stop_capture();
+        data[1] = MB_DEBUG_SUCCESS;
+        return 2;
+
+    case TRACE_CMD_STATUS:
+        return trace_status(data);
+
+    case TRACE_CMD_READ:
+        return trace_read(data, length, frame_size);
+
+    default:
+        data[1] = MB_DEBUG_ERROR_OUT_OF_BOUNDS;
+        return 2;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Function code of the trace recorder requests on the debug protocol
+#define MB_FC_DEBUG_TRACE 0x4A
+
+// Subcommands, the byte after the function code
+#define TRACE_CMD_CONFIGURE 0x01
+#define TRACE_CMD_ARM 0x02
+#define TRACE_CMD_FORCE 0x03
+#define TRACE_CMD_STOP 0x04
+#define TRACE_CMD_STATUS 0x05
+#define TRACE_CMD_READ 0x06
+
+// The per-scan cost is bounded by these: at most TRACE_MAX_VARS copies
+// totalling TRACE_MAX_SAMPLE_SIZE bytes, plus one trigger comparison
+#define TRACE_MAX_VARS 32
+#define TRACE_MAX_SAMPLE_SIZE 256
+
+// Preallocated ring storage. Every record is a 4-byte tick followed by the
+// values, so the depth in samples is TRACE_BUFFER_SIZE / (4 + sample size).
+#define TRACE_BUFFER_SIZE (256 * 1024)
+
+typedef enum
+{
+    TRACE_STATE_IDLE = 0,  // not configured, stopped or program unloaded
+    TRACE_STATE_ARMED,     // recording the pre-trigger window, waiting for the trigger
+    TRACE_STATE_TRIGGERED, // recording the post-trigger window
+    TRACE_STATE_DONE       // capture complete, ready to download
+} trace_state_t;
+
+typedef enum
+{
+    TRACE_TRIGGER_NONE = 0, // trigger on the first sample after arming
+    TRACE_TRIGGER_RISING,   // condition changes from false to true
+    TRACE_TRIGGER_FALLING,  // condition changes from true to false
+    TRACE_TRIGGER_LEVEL     // condition is true
+} trace_trigger_mode_t;
+
+typedef enum
+{
+    TRACE_OP_GREATER = 0,
+    TRACE_OP_LESS,
+    TRACE_OP_EQUAL,
+    TRACE_OP_NOT_EQUAL
+} trace_trigger_op_t;
+
+// How the trigger variable's bytes are compared with the threshold
+typedef enum
+{
+    TRACE_TYPE_SIGNED = 0,
+    TRACE_TYPE_UNSIGNED,
+    TRACE_TYPE_REAL
+} trace_value_type_t;
+
+/**
+ * @brief Handle a MB_FC_DEBUG_TRACE request in place
+ *
+ * Called by the debug handler; `data` holds `frame_size` bytes and receives
+ * the response. See docs/DEBUG_PROTOCOL.md for the request layouts.
+ *
+ * @return The response length
+ */
+size_t trace_recorder_handle_request(uint8_t *data, size_t length, size_t frame_size);
+
+/**
+ * @brief Record one sample if a capture is running
+ *
+ * Called by the scan thread after the cycle_end hooks, with the image mutex
+ * held. Never blocks or allocates.
+ */
+void trace_recorder_sample(void);
+
+// Stop any capture and drop the configuration because the program is being
+// unloaded
+void trace_recorder_invalidate(void);
+
+#endif // TRACE_RECORDER_H
@@ -3,43 +3,31 @@
 #include <signal.h>
 #include <stdatomic.h>
 #include <stdio.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include "../drivers/plugin_driver.h"
 #include "debug_handler.h"
+#include "debug_stream.h"
+#include "journal_buffer.h"
+#include "plc_instances.h"
 #include "plc_state_manager.h"
 #include "scan_cycle_manager.h"
+#include "scan_profiler.h"
+#include "task_scheduler.h"
 #include "unix_socket.h"
 #include "utils/log.h"
 #include "utils/utils.h"
 
 extern volatile sig_atomic_t keep_running;
 extern PLCState plc_state;
-
-// helper: read one line terminated by '\n' from a socket
-static ssize_t read_line(int fd, char *buffer, size_t max_length)
-{
-    size_t total_read = 0;
-    char ch;
-    while (total_read < max_length - 1)
-    {
-        ssize_t bytes_read = read(fd, &ch, 1);
-        if (bytes_read <= 0)
-        {
-            return bytes_read; // error or connection closed
-        }
-        if (ch == '\n')
-        {
-            break; // end of line
-        }
-        buffer[total_read++] = ch;
-    }
-    buffer[total_read] = '\0'; // null-terminate the string
-    return total_read;
-}
+extern plugin_driver_t *plugin_driver;
 
 void handle_unix_socket_commands(const char *command, char *response, size_t response_size)
 {
@@ -64,6 +52,10 @@ void handle_unix_socket_commands(const char *command, char *response, size_t res
         else
             strncpy(response, "STATUS:UNKNOWN\n", response_size);
     }
+    else if (strcmp(command, "AFFINITY") == 0)
+    {
+        format_affinity_report(response, response_size);
+    }
     else if (strcmp(command, "STOP") == 0)
     {
         if (plc_set_state(PLC_STATE_STOPPED))
@@ -91,17 +83,108 @@ void handle_unix_socket_commands(const char *command, char *response, size_t res
             log_error("Received START command but PLC is already RUNNING");
         }
     }
+    else if (strcmp(command, "ONLINE_CHANGE") == 0)
+    {
+        if (plc_online_change())
+        {
+            strncpy(response, "ONLINE_CHANGE:OK\n", response_size);
+        }
+        else
+        {
+            strncpy(response, "ONLINE_CHANGE:ERROR\n", response_size);
+        }
+    }
     else if (strcmp(command, "STATS") == 0)
     {
-        format_timing_stats_response(response, response_size);
+        // The plugin hook timing goes inside the STATS object, before its "}\n"
+        int length     = format_timing_stats_response(response, response_size);
+        size_t written = length > 2 ? (size_t)length - 2 : 0;
+        if (written == 0 || written + 2 >= response_size ||
+            !timing_format_append(response, response_size, &written, ",") ||
+            !plugin_driver_format_hook_stats(plugin_driver, response, response_size, &written) ||
+            !timing_format_append(response, response_size, &written, "}\n"))
+        {
+            format_timing_stats_response(response, response_size);
+        }
+    }
+    else if (strcmp(command, "JOURNAL_STATS") == 0)
+    {
+        // The per-plugin rejected writes go inside the object, like the hooks in STATS
+        int length     = format_journal_stats_response(response, response_size);
+        size_t written = length > 2 ? (size_t)length - 2 : 0;
+        if (written == 0 || written + 2 >= response_size ||
+            !timing_format_append(response, response_size, &written, ",") ||
+            !plugin_driver_format_journal_rejects(plugin_driver, response, response_size,
+                                                  &written) ||
+            !timing_format_append(response, response_size, &written, "}\n"))
+        {
+            format_journal_stats_response(response, response_size);
+        }
+    }
+    else if (strncmp(command, "PLUGIN:", 7) == 0)
+    {
+        // PLUGIN:<name>:<command>, answered by the native plugin <name>
+        char name[MAX_PLUGIN_NAME_LEN];
+        const char *separator = strchr(&command[7], ':');
+        size_t name_length    = separator ? (size_t)(separator - &command[7]) : 0;
+        if (name_length == 0 || name_length >= sizeof(name))
+        {
+            strncpy(response, "PLUGIN:ERROR_PARSING\n", response_size);
+        }
+        else
+        {
+            memcpy(name, &command[7], name_length);
+            name[name_length] = '\0';
+            if (plugin_driver_command(plugin_driver, name, separator + 1, response,
+                                      response_size) != 0)
+            {
+                strncpy(response, "PLUGIN:ERROR_UNKNOWN\n", response_size);
+            }
+        }
+    }
+    else if (strcmp(command, "TASKS") == 0)
+    {
+        format_task_stats_response(response, response_size);
+    }
+    else if (strcmp(command, "INSTANCES") == 0)
+    {
+        format_instance_stats_response(response, response_size);
+    }
+    else if (strcmp(command, "HISTOGRAM") == 0)
+    {
+        format_timing_histogram_response(response, response_size);
+    }
+    else if (strcmp(command, "HISTOGRAM:RESET") == 0)
+    {
+        reset_timing_histograms();
+        strncpy(response, "HISTOGRAM:OK\n", response_size);
+    }
+    else if (strcmp(command, "PROFILE") == 0)
+    {
+        format_scan_profile_response(response, response_size);
+    }
+    else if (strcmp(command, "PROFILE:ON") == 0)
+    {
+        scan_profiler_set_enabled(true);
+        strncpy(response, "PROFILE:OK\n", response_size);
+    }
+    else if (strcmp(command, "PROFILE:OFF") == 0)
+    {
+        scan_profiler_set_enabled(false);
+        strncpy(response, "PROFILE:OK\n", response_size);
+    }
+    else if (strcmp(command, "PROFILE:RESET") == 0)
+    {
+        scan_profiler_reset();
+        strncpy(response, "PROFILE:OK\n", response_size);
     }
     else if (strncmp(command, "DEBUG:", 6) == 0)
     {
-        uint8_t debug_data[4096] = {0};
-        size_t data_length       = parse_hex_string(&command[6], debug_data);
+        uint8_t debug_data[LEGACY_DEBUG_FRAME] = {0};
+        size_t data_length = parse_hex_string(&command[6], debug_data);
         if (data_length > 0)
         {
-            data_length = process_debug_data(debug_data, data_length);
+            data_length = process_debug_data_limited(debug_data, data_length, LEGACY_DEBUG_FRAME);
             if (data_length > 0)
             {
                 bytes_to_hex_string(debug_data, data_length, response, response_size, "DEBUG:");
@@ -132,75 +215,661 @@ void handle_unix_socket_commands(const char *command, char *response, size_t res
     response[response_size - 1] = '\0';
 }
 
-void *unix_socket_thread(void *arg)
+// helper: read exactly `length` bytes, returns 1 on success, 0 on close, -1 on error
+static int read_exact(int fd, uint8_t *buffer, size_t length)
 {
-    (void)arg;
-    int *server_fd_pt = (int *)arg;
-    int client_fd;
-    char command_buffer[COMMAND_BUFFER_SIZE];
+    size_t total_read = 0;
+    while (total_read < length)
+    {
+        ssize_t bytes_read = read(fd, buffer + total_read, length - total_read);
+        if (bytes_read == 0)
+        {
+            return 0;
+        }
+        if (bytes_read < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        total_read += (size_t)bytes_read;
+    }
+    return 1;
+}
 
-    if (server_fd_pt == NULL)
+// helper: write all of `length` bytes, returns 1 on success, -1 on error
+static int write_all(int fd, const uint8_t *buffer, size_t length)
+{
+    size_t written = 0;
+    while (written < length)
     {
-        log_error("Server file descriptor is NULL");
-        return NULL;
+        // A client that went away must not raise SIGPIPE
+        ssize_t bytes_written = send(fd, buffer + written, length - written, MSG_NOSIGNAL);
+        if (bytes_written <= 0)
+        {
+            if (bytes_written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            log_error("Error writing on unix socket: %s", strerror(errno));
+            return -1;
+        }
+        written += (size_t)bytes_written;
     }
+    return 1;
+}
 
-    int server_fd = *server_fd_pt;
-    if (server_fd < 0)
+// Send `payload` as one binary debug frame
+static int write_debug_frame(int fd, const uint8_t *payload, size_t length)
+{
+    uint8_t header[DEBUG_FRAME_HEADER_SIZE] = {DEBUG_FRAME_MAGIC, (uint8_t)(length >> 8),
+                                               (uint8_t)(length & 0xFF)};
+    if (write_all(fd, header, sizeof(header)) < 0)
     {
-        log_error("Failed to set up UNIX socket");
-        return NULL;
+        return -1;
+    }
+    return length > 0 ? write_all(fd, payload, length) : 1;
+}
+
+// Read and handle one binary debug frame on the debug stream socket, the
+// magic byte has already been consumed. `payload` must hold MAX_DEBUG_FRAME
+// bytes. `handler` processes the payload in place and returns the response
+// length. Returns the read_exact() result so the caller can tell a closed
+// connection.
+static int handle_debug_frame(int fd, uint8_t *payload, size_t (*handler)(uint8_t *, size_t))
+{
+    uint8_t header[2];
+    int result = read_exact(fd, header, 2);
+    if (result <= 0)
+    {
+        return result;
+    }
+
+    size_t length          = (size_t)header[0] << 8 | header[1];
+    size_t response_length = 0;
+
+    if (length > MAX_DEBUG_FRAME)
+    {
+        // Drain the oversized payload so the stream stays in sync
+        log_error("Debug frame too large: %zu bytes", length);
+        while (length > 0)
+        {
+            size_t chunk = length > MAX_DEBUG_FRAME ? MAX_DEBUG_FRAME : length;
+            result       = read_exact(fd, payload, chunk);
+            if (result <= 0)
+            {
+                return result;
+            }
+            length -= chunk;
+        }
+    }
+    else
+    {
+        result = read_exact(fd, payload, length);
+        if (result <= 0)
+        {
+            return result;
+        }
+        if (length > 0)
+        {
+            response_length = handler(payload, length);
+        }
+    }
+
+    return write_debug_frame(fd, payload, response_length);
+}
+
+// The connection of a command client. The lanes answering its tagged
+// requests hold references and the descriptor is closed with the last one,
+// so a late reply never goes to a reused descriptor. Replies are written
+// under write_mutex one frame at a time.
+typedef struct
+{
+    int fd;
+    atomic_int refs;
+    atomic_bool closed; // client gone, its queued requests are dropped
+    pthread_mutex_t write_mutex;
+} command_conn_t;
+
+// One connected command client. Input is buffered until a full line or
+// binary frame is available; a frame never exceeds the buffer since its
+// length field is 16-bit.
+typedef struct
+{
+    command_conn_t *conn;
+    uint8_t *buffer;
+    size_t length;
+    bool discard_line; // dropping the rest of an overlong text command
+} command_client_t;
+
+#define CLIENT_BUFFER_SIZE (TAGGED_FRAME_HEADER_SIZE + MAX_DEBUG_FRAME)
+#define UNIX_SOCKET_POLL_MS 1000
+
+// A client that stops reading must not stall the others for long
+#define CLIENT_SEND_TIMEOUT_S 2
+
+static void release_conn(command_conn_t *conn)
+{
+    if (atomic_fetch_sub(&conn->refs, 1) == 1)
+    {
+        close(conn->fd);
+        pthread_mutex_destroy(&conn->write_mutex);
+        free(conn);
     }
+}
+
+// Write a frame header and its body without other replies in between
+static int write_conn_frame(command_conn_t *conn, const uint8_t *header, size_t header_length,
+                            const uint8_t *body, size_t length)
+{
+    pthread_mutex_lock(&conn->write_mutex);
+    int result = write_all(conn->fd, header, header_length);
+    if (result > 0 && length > 0)
+    {
+        result = write_all(conn->fd, body, length);
+    }
+    pthread_mutex_unlock(&conn->write_mutex);
+    return result;
+}
+
+// Send `payload` as one binary debug frame on a command connection
+static int write_conn_debug_frame(command_conn_t *conn, const uint8_t *payload, size_t length)
+{
+    uint8_t header[DEBUG_FRAME_HEADER_SIZE] = {DEBUG_FRAME_MAGIC, (uint8_t)(length >> 8),
+                                               (uint8_t)(length & 0xFF)};
+    return write_conn_frame(conn, header, sizeof(header), payload, length);
+}
+
+// debug_frame_writer_t for untagged paged responses, `ctx` is the connection
+static int write_debug_page(void *ctx, const uint8_t *frame, size_t length)
+{
+    return write_conn_debug_frame((command_conn_t *)ctx, frame, length);
+}
+
+// Send one reply frame of tagged request `id`. A failed write leaves the
+// stream out of sync, so the connection is shut down and the socket thread
+// drops the client.
+static int write_tagged_frame(command_conn_t *conn, uint32_t id, uint8_t flags,
+                              const uint8_t *body, size_t length)
+{
+    uint8_t header[TAGGED_FRAME_HEADER_SIZE] = {TAGGED_FRAME_MAGIC,     (uint8_t)(id >> 24),
+                                                (uint8_t)(id >> 16),    (uint8_t)(id >> 8),
+                                                (uint8_t)(id & 0xFF),   flags,
+                                                (uint8_t)(length >> 8), (uint8_t)(length & 0xFF)};
+    int result = write_conn_frame(conn, header, sizeof(header), body, length);
+    if (result < 0)
+    {
+        atomic_store(&conn->closed, true);
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    return result;
+}
+
+typedef struct
+{
+    command_conn_t *conn;
+    uint32_t id;
+} tagged_page_ctx_t;
+
+// debug_frame_writer_t for tagged paged responses
+static int write_tagged_page(void *ctx, const uint8_t *frame, size_t length)
+{
+    tagged_page_ctx_t *page = (tagged_page_ctx_t *)ctx;
+    return write_tagged_frame(page->conn, page->id, 0, frame, length);
+}
+
+// A queued tagged request, the body is NUL terminated for text commands
+typedef struct tagged_request
+{
+    struct tagged_request *next;
+    command_conn_t *conn;
+    uint32_t id;
+    uint8_t kind;
+    uint16_t length;
+    uint8_t body[];
+} tagged_request_t;
+
+// Requests of one lane are handled one at a time, by its worker for tagged
+// requests and by the socket thread for untagged ones, so the handlers see
+// the same serialization as with a single thread within a lane
+typedef struct
+{
+    const char *name;
+    pthread_mutex_t serve_mutex; // held while a request of the lane is handled
+    pthread_mutex_t queue_mutex;
+    pthread_cond_t queue_cond;
+    tagged_request_t *head;
+    tagged_request_t *tail;
+    unsigned int queued;
+} request_lane_t;
+
+enum
+{
+    LANE_QUERY,   // state and statistics, answered at once
+    LANE_PROGRAM, // anything that may wait on the scan or swap the program
+    LANE_COUNT
+};
+
+static request_lane_t lanes[LANE_COUNT] = {
+    [LANE_QUERY]   = {.name        = "query",
+                      .serve_mutex = PTHREAD_MUTEX_INITIALIZER,
+                      .queue_mutex = PTHREAD_MUTEX_INITIALIZER,
+                      .queue_cond  = PTHREAD_COND_INITIALIZER},
+    [LANE_PROGRAM] = {.name        = "program",
+                      .serve_mutex = PTHREAD_MUTEX_INITIALIZER,
+                      .queue_mutex = PTHREAD_MUTEX_INITIALIZER,
+                      .queue_cond  = PTHREAD_COND_INITIALIZER},
+};
+
+// Starting, stopping and changing the program, plugin commands and debug
+// requests share the program lane: debug handlers read the loaded program
+// and must not overlap with its replacement
+static request_lane_t *command_lane(const char *command)
+{
+    if (strcmp(command, "START") == 0 || strcmp(command, "STOP") == 0 ||
+        strcmp(command, "ONLINE_CHANGE") == 0 || strncmp(command, "PLUGIN:", 7) == 0 ||
+        strncmp(command, "DEBUG:", 6) == 0)
+    {
+        return &lanes[LANE_PROGRAM];
+    }
+    return &lanes[LANE_QUERY];
+}
+
+static void serve_tagged_request(request_lane_t *lane, const tagged_request_t *request)
+{
+    if (request->kind == TAGGED_KIND_COMMAND)
+    {
+        char response[MAX_RESPONSE_SIZE] = {0};
+        pthread_mutex_lock(&lane->serve_mutex);
+        handle_unix_socket_commands((const char *)request->body, response, MAX_RESPONSE_SIZE);
+        pthread_mutex_unlock(&lane->serve_mutex);
+        write_tagged_frame(request->conn, request->id, TAGGED_FLAG_FINAL,
+                           (const uint8_t *)response, strlen(response));
+        return;
+    }
+
+    // Debug payloads are only served by the program lane's worker
+    static uint8_t payload[MAX_DEBUG_FRAME];
+    memcpy(payload, request->body, request->length);
+
+    pthread_mutex_lock(&lane->serve_mutex);
+    if (request->length > 0 && payload[0] == MB_FC_DEBUG_GET_PAGED)
+    {
+        tagged_page_ctx_t page = {.conn = request->conn, .id = request->id};
+        int result = process_debug_paged(payload, request->length, write_tagged_page, &page);
+        pthread_mutex_unlock(&lane->serve_mutex);
+        if (result > 0)
+        {
+            write_tagged_frame(request->conn, request->id, TAGGED_FLAG_FINAL, NULL, 0);
+        }
+        return;
+    }
+    size_t response_length = request->length > 0 ? process_debug_data(payload, request->length) : 0;
+    pthread_mutex_unlock(&lane->serve_mutex);
+    write_tagged_frame(request->conn, request->id, TAGGED_FLAG_FINAL, payload, response_length);
+}
+
+static void *lane_thread(void *arg)
+{
+    request_lane_t *lane = (request_lane_t *)arg;
 
     while (keep_running)
     {
-        client_fd = accept(server_fd, NULL, NULL);
-        if (client_fd < 0)
+        pthread_mutex_lock(&lane->queue_mutex);
+        if (lane->head == NULL)
         {
-            if (errno == EINTR)
+            // Wake up now and then to notice the shutdown
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += 1;
+            pthread_cond_timedwait(&lane->queue_cond, &lane->queue_mutex, &deadline);
+        }
+        tagged_request_t *request = lane->head;
+        if (request != NULL)
+        {
+            lane->head = request->next;
+            if (lane->head == NULL)
             {
-                continue; // Interrupted by signal, retry
+                lane->tail = NULL;
             }
+            lane->queued--;
+        }
+        pthread_mutex_unlock(&lane->queue_mutex);
+
+        if (request == NULL)
+        {
+            continue;
+        }
+        if (!atomic_load(&request->conn->closed))
+        {
+            serve_tagged_request(lane, request);
+        }
+        release_conn(request->conn);
+        free(request);
+    }
+    return NULL;
+}
+
+// Hand a tagged request to its lane, or reject it at once. Returns -1 on a
+// write error.
+static int queue_tagged_request(command_conn_t *conn, uint32_t id, uint8_t kind,
+                                const uint8_t *body, size_t length)
+{
+    tagged_request_t *request = NULL;
+    if (kind == TAGGED_KIND_DEBUG || (kind == TAGGED_KIND_COMMAND && length < COMMAND_BUFFER_SIZE))
+    {
+        request = malloc(sizeof(tagged_request_t) + length + 1);
+    }
+    else
+    {
+        log_error("Unix socket tagged request %u with kind %u and %zu bytes rejected", id, kind,
+                  length);
+    }
+    if (request == NULL)
+    {
+        return write_tagged_frame(conn, id, TAGGED_FLAG_FINAL | TAGGED_FLAG_REJECTED, NULL, 0);
+    }
+
+    request->next   = NULL;
+    request->conn   = conn;
+    request->id     = id;
+    request->kind   = kind;
+    request->length = (uint16_t)length;
+    memcpy(request->body, body, length);
+    request->body[length] = '\0';
+
+    request_lane_t *lane = kind == TAGGED_KIND_DEBUG ? &lanes[LANE_PROGRAM]
+                                                     : command_lane((const char *)request->body);
+    pthread_mutex_lock(&lane->queue_mutex);
+    if (lane->queued >= TAGGED_QUEUE_DEPTH)
+    {
+        pthread_mutex_unlock(&lane->queue_mutex);
+        free(request);
+        log_warn("Unix socket %s lane full, request %u rejected", lane->name, id);
+        return write_tagged_frame(conn, id, TAGGED_FLAG_FINAL | TAGGED_FLAG_REJECTED, NULL, 0);
+    }
+    atomic_fetch_add(&conn->refs, 1);
+    if (lane->tail != NULL)
+    {
+        lane->tail->next = request;
+    }
+    else
+    {
+        lane->head = request;
+    }
+    lane->tail = request;
+    lane->queued++;
+    pthread_cond_signal(&lane->queue_cond);
+    pthread_mutex_unlock(&lane->queue_mutex);
+    return 1;
+}
+
+static void close_command_client(command_client_t *client)
+{
+    // Replies still being written by a lane end here too
+    atomic_store(&client->conn->closed, true);
+    shutdown(client->conn->fd, SHUT_RDWR);
+    release_conn(client->conn);
+    free(client->buffer);
+    client->conn   = NULL;
+    client->buffer = NULL;
+    client->length = 0;
+}
+
+static void accept_command_client(int server_fd, command_client_t clients[MAX_CLIENTS])
+{
+    int client_fd = accept(server_fd, NULL, NULL);
+    if (client_fd < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN)
+        {
             log_error("Unix socket accept failed: %s", strerror(errno));
+        }
+        return;
+    }
 
-            // Retry after a short delay
-            sleep(1);
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (clients[i].conn == NULL)
+        {
+            command_conn_t *conn = malloc(sizeof(command_conn_t));
+            clients[i].buffer    = malloc(CLIENT_BUFFER_SIZE);
+            if (conn == NULL || clients[i].buffer == NULL)
+            {
+                free(conn);
+                free(clients[i].buffer);
+                clients[i].buffer = NULL;
+                break;
+            }
+            struct timeval timeout = {.tv_sec = CLIENT_SEND_TIMEOUT_S};
+            setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            conn->fd = client_fd;
+            atomic_init(&conn->refs, 1);
+            atomic_init(&conn->closed, false);
+            pthread_mutex_init(&conn->write_mutex, NULL);
+            clients[i].conn         = conn;
+            clients[i].length       = 0;
+            clients[i].discard_line = false;
+            log_info("Unix socket client connected");
+            return;
+        }
+    }
+
+    log_warn("Unix socket client rejected, %d clients already connected", MAX_CLIENTS);
+    close(client_fd);
+}
+
+// Answer one text command, returns -1 on a write error
+static int serve_command(command_conn_t *conn, const char *command)
+{
+    char response[MAX_RESPONSE_SIZE] = {0};
+    request_lane_t *lane             = command_lane(command);
+    pthread_mutex_lock(&lane->serve_mutex);
+    handle_unix_socket_commands(command, response, MAX_RESPONSE_SIZE);
+    pthread_mutex_unlock(&lane->serve_mutex);
+    size_t length = strlen(response);
+    return length > 0 ? write_conn_frame(conn, (const uint8_t *)response, length, NULL, 0) : 1;
+}
+
+// Answer one binary debug frame, `payload` holds MAX_DEBUG_FRAME bytes
+static int serve_debug_frame(command_conn_t *conn, uint8_t *payload, size_t length)
+{
+    request_lane_t *lane = &lanes[LANE_PROGRAM];
+    pthread_mutex_lock(&lane->serve_mutex);
+    if (length > 0 && payload[0] == MB_FC_DEBUG_GET_PAGED)
+    {
+        int result = process_debug_paged(payload, length, write_debug_page, conn);
+        pthread_mutex_unlock(&lane->serve_mutex);
+        return result;
+    }
+    size_t response_length = length > 0 ? process_debug_data(payload, length) : 0;
+    pthread_mutex_unlock(&lane->serve_mutex);
+    return write_conn_debug_frame(conn, payload, response_length);
+}
+
+// Serve every complete line and frame in the client's buffer, keeping a
+// partial one for the next read. Returns -1 if the client must be dropped.
+static int serve_buffered_requests(command_client_t *client, uint8_t *payload)
+{
+    size_t offset = 0;
+    int result    = 1;
+
+    while (result > 0 && offset < client->length)
+    {
+        uint8_t *start   = client->buffer + offset;
+        size_t available = client->length - offset;
+
+        if (!client->discard_line && start[0] == DEBUG_FRAME_MAGIC)
+        {
+            if (available < DEBUG_FRAME_HEADER_SIZE)
+            {
+                break;
+            }
+            size_t length = (size_t)start[1] << 8 | start[2];
+            if (available < DEBUG_FRAME_HEADER_SIZE + length)
+            {
+                break;
+            }
+            // The handler writes its response over the payload, copy it out
+            // so requests pipelined behind this one stay intact
+            memcpy(payload, start + DEBUG_FRAME_HEADER_SIZE, length);
+            offset += DEBUG_FRAME_HEADER_SIZE + length;
+            result = serve_debug_frame(client->conn, payload, length);
             continue;
         }
 
-        log_info("Unix socket client connected");
+        if (!client->discard_line && start[0] == TAGGED_FRAME_MAGIC)
+        {
+            if (available < TAGGED_FRAME_HEADER_SIZE)
+            {
+                break;
+            }
+            size_t length = (size_t)start[6] << 8 | start[7];
+            if (available < TAGGED_FRAME_HEADER_SIZE + length)
+            {
+                break;
+            }
+            uint32_t id = (uint32_t)start[1] << 24 | (uint32_t)start[2] << 16 |
+                          (uint32_t)start[3] << 8 | start[4];
+            result = queue_tagged_request(client->conn, id, start[5],
+                                          start + TAGGED_FRAME_HEADER_SIZE, length);
+            offset += TAGGED_FRAME_HEADER_SIZE + length;
+            continue;
+        }
 
-        while (keep_running)
+        uint8_t *newline = memchr(start, '\n', available);
+        if (newline == NULL)
         {
-            ssize_t bytes_read = read_line(client_fd, command_buffer, COMMAND_BUFFER_SIZE);
-            if (bytes_read > 0)
+            if (available >= COMMAND_BUFFER_SIZE - 1)
             {
-                // Handle the command
-                char response[MAX_RESPONSE_SIZE] = {0};
-                handle_unix_socket_commands(command_buffer, response, MAX_RESPONSE_SIZE);
-                if (strlen(response) > 0)
+                // Same limit as before: a command that cannot end within the
+                // command buffer is answered as an error and skipped
+                if (!client->discard_line)
                 {
-                    ssize_t bytes_written = write(client_fd, response, strlen(response));
-                    if (bytes_written <= 0)
-                    {
-                        log_error("Error writing on unix socket: %s", strerror(errno));
-                    }
+                    log_error("Unix socket command longer than %d bytes", COMMAND_BUFFER_SIZE - 1);
+                    result = write_conn_frame(client->conn, (const uint8_t *)"COMMAND:ERROR\n",
+                                              14, NULL, 0);
                 }
+                client->discard_line = true;
+                offset += available;
             }
-            else if (bytes_read == 0)
+            break;
+        }
+
+        *newline = '\0';
+        offset += (size_t)(newline - start) + 1;
+        if (client->discard_line)
+        {
+            client->discard_line = false;
+            continue;
+        }
+        result = serve_command(client->conn, (const char *)start);
+    }
+
+    client->length -= offset;
+    memmove(client->buffer, client->buffer + offset, client->length);
+    return result > 0 ? 0 : -1;
+}
+
+// Read what the client sent and serve it. Returns -1 once it disconnected
+static int read_command_client(command_client_t *client, uint8_t *payload)
+{
+    ssize_t bytes_read =
+        read(client->conn->fd, client->buffer + client->length, CLIENT_BUFFER_SIZE - client->length);
+    if (bytes_read == 0)
+    {
+        log_info("Unix socket client disconnected");
+        return -1;
+    }
+    if (bytes_read < 0)
+    {
+        if (errno == EINTR || errno == EAGAIN)
+        {
+            return 0;
+        }
+        log_error("Unix socket read failed: %s", strerror(errno));
+        return -1;
+    }
+    client->length += (size_t)bytes_read;
+    return serve_buffered_requests(client, payload);
+}
+
+// Serves up to MAX_CLIENTS command clients at once (the webserver, a CLI, a
+// metrics scraper). Untagged requests are handled one at a time on this
+// thread, tagged ones are queued to the lane workers.
+void *unix_socket_thread(void *arg)
+{
+    int *server_fd_pt = (int *)arg;
+    static uint8_t debug_payload[MAX_DEBUG_FRAME];
+    command_client_t clients[MAX_CLIENTS];
+
+    if (server_fd_pt == NULL)
+    {
+        log_error("Server file descriptor is NULL");
+        return NULL;
+    }
+
+    int server_fd = *server_fd_pt;
+    if (server_fd < 0)
+    {
+        log_error("Failed to set up UNIX socket");
+        return NULL;
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        clients[i].conn   = NULL;
+        clients[i].buffer = NULL;
+    }
+
+    while (keep_running)
+    {
+        // Slot 0 is the listening socket, slot i + 1 is clients[i]
+        struct pollfd fds[MAX_CLIENTS + 1];
+        fds[0].fd     = server_fd;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < MAX_CLIENTS; i++)
+        {
+            // negative fds are ignored
+            fds[i + 1].fd     = clients[i].conn != NULL ? clients[i].conn->fd : -1;
+            fds[i + 1].events = POLLIN;
+        }
+
+        int ready = poll(fds, MAX_CLIENTS + 1, UNIX_SOCKET_POLL_MS);
+        if (ready < 0)
+        {
+            if (errno != EINTR)
             {
-                log_info("Unix socket client disconnected");
-                break;
+                log_error("Unix socket poll failed: %s", strerror(errno));
+                sleep(1);
             }
-            else
+            continue;
+        }
+
+        for (int i = 0; i < MAX_CLIENTS; i++)
+        {
+            if (clients[i].conn != NULL && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) &&
+                read_command_client(&clients[i], debug_payload) < 0)
             {
-                log_error("Unix socket read failed: %s", strerror(errno));
-                break;
+                close_command_client(&clients[i]);
             }
         }
-        close(client_fd);
+
+        if (fds[0].revents & POLLIN)
+        {
+            accept_command_client(server_fd, clients);
+        }
     }
 
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (clients[i].conn != NULL)
+        {
+            close_command_client(&clients[i]);
+        }
+    }
     close_unix_socket(server_fd);
     return NULL;
 }
@@ -215,13 +884,14 @@ void close_unix_socket(int server_fd)
     }
 }
 
-int setup_unix_socket(void)
+// Create, bind and listen on a unix stream socket at `path`
+static int create_server_socket(const char *path)
 {
     int server_fd;
     struct sockaddr_un address;
 
     // Remove any existing socket file
-    unlink(SOCKET_PATH);
+    unlink(path);
 
     // Create socket
     if ((server_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
@@ -233,7 +903,7 @@ int setup_unix_socket(void)
     // Configure socket address structure
     memset(&address, 0, sizeof(address));
     address.sun_family = AF_UNIX;
-    strncpy(address.sun_path, SOCKET_PATH, sizeof(address.sun_path) - 1);
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
 
     // Bind socket to the address
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0)
@@ -251,19 +921,170 @@ int setup_unix_socket(void)
         return -1;
     }
 
-    log_info("UNIX socket server setup at %s", SOCKET_PATH);
+    log_info("UNIX socket server setup at %s", path);
+    return server_fd;
+}
 
-    // Create a thread to handle socket commands
+// Start `thread_fn` with a heap copy of `server_fd` as its argument
+static int start_server_thread(int server_fd, void *(*thread_fn)(void *))
+{
     pthread_t socket_thread;
     int *fd_ptr = malloc(sizeof(int));
     *fd_ptr     = server_fd;
-    if (pthread_create(&socket_thread, NULL, unix_socket_thread, fd_ptr) != 0)
+    if (pthread_create(&socket_thread, NULL, thread_fn, fd_ptr) != 0)
     {
         log_error("Failed to create UNIX socket thread: %s", strerror(errno));
         close(server_fd);
         free(fd_ptr);
         return -1;
     }
-
     return 0;
 }
+
+int setup_unix_socket(void)
+{
+    int server_fd = create_server_socket(SOCKET_PATH);
+    if (server_fd < 0)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < LANE_COUNT; i++)
+    {
+        pthread_t lane;
+        if (pthread_create(&lane, NULL, lane_thread, &lanes[i]) != 0)
+        {
+            log_error("Failed to create the unix socket %s lane: %s", lanes[i].name,
+                      strerror(errno));
+            close(server_fd);
+            return -1;
+        }
+        pthread_detach(lane);
+    }
+
+    // Create a thread to handle socket commands
+    return start_server_thread(server_fd, unix_socket_thread);
+}
+
+// Send every queued sample as a binary frame, returns -1 on a write error
+static int send_debug_samples(int fd)
+{
+    static debug_sample_t sample;
+    uint8_t frame[DEBUG_FRAME_HEADER_SIZE + DEBUG_SAMPLE_HEADER_SIZE + DEBUG_STREAM_SAMPLE_SIZE];
+
+    while (debug_stream_pop(&sample))
+    {
+        size_t payload_length = DEBUG_SAMPLE_HEADER_SIZE + sample.length;
+        uint8_t *payload      = &frame[DEBUG_FRAME_HEADER_SIZE];
+
+        frame[0]   = DEBUG_FRAME_MAGIC;
+        frame[1]   = (uint8_t)(payload_length >> 8);
+        frame[2]   = (uint8_t)(payload_length & 0xFF);
+        payload[0] = MB_FC_DEBUG_SAMPLE;
+        payload[1] = (uint8_t)(sample.tick >> 24);
+        payload[2] = (uint8_t)(sample.tick >> 16);
+        payload[3] = (uint8_t)(sample.tick >> 8);
+        payload[4] = (uint8_t)(sample.tick & 0xFF);
+        payload[5] = sample.flags;
+        payload[6] = (uint8_t)(sample.length >> 8);
+        payload[7] = (uint8_t)(sample.length & 0xFF);
+        memcpy(&payload[DEBUG_SAMPLE_HEADER_SIZE], sample.data, sample.length);
+
+        if (write_all(fd, frame, DEBUG_FRAME_HEADER_SIZE + payload_length) < 0)
+        {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+void *debug_stream_thread(void *arg)
+{
+    static uint8_t request_payload[MAX_DEBUG_FRAME];
+
+    int *server_fd_pt = (int *)arg;
+    if (server_fd_pt == NULL || *server_fd_pt < 0)
+    {
+        log_error("Debug stream socket is not set up");
+        return NULL;
+    }
+    int server_fd = *server_fd_pt;
+
+    while (keep_running)
+    {
+        int client_fd = accept(server_fd, NULL, NULL);
+        if (client_fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            log_error("Debug stream accept failed: %s", strerror(errno));
+            sleep(1);
+            continue;
+        }
+
+        log_info("Debug stream client connected");
+
+        while (keep_running)
+        {
+            // Requests are rare; mostly this loop forwards samples. Without a
+            // subscription there is nothing to forward, so wake up less often.
+            struct pollfd pfd = {.fd = client_fd, .events = POLLIN};
+            int timeout_ms    = debug_stream_active() ? DEBUG_STREAM_POLL_MS : 1000;
+            int ready         = poll(&pfd, 1, timeout_ms);
+            if (ready < 0 && errno != EINTR)
+            {
+                log_error("Debug stream poll failed: %s", strerror(errno));
+                break;
+            }
+
+            if (ready > 0)
+            {
+                uint8_t magic;
+                int result = read_exact(client_fd, &magic, 1);
+                if (result > 0 && magic != DEBUG_FRAME_MAGIC)
+                {
+                    log_error("Debug stream received an unframed byte 0x%02X", magic);
+                    break;
+                }
+                if (result > 0)
+                {
+                    result =
+                        handle_debug_frame(client_fd, request_payload, debug_stream_handle_request);
+                }
+                if (result <= 0)
+                {
+                    if (result == 0)
+                    {
+                        log_info("Debug stream client disconnected");
+                    }
+                    break;
+                }
+            }
+
+            if (send_debug_samples(client_fd) < 0)
+            {
+                break;
+            }
+        }
+
+        debug_stream_unsubscribe();
+        close(client_fd);
+    }
+
+    close(server_fd);
+    unlink(DEBUG_STREAM_SOCKET_PATH);
+    return NULL;
+}
+
+int setup_debug_stream_socket(void)
+{
+    int server_fd = create_server_socket(DEBUG_STREAM_SOCKET_PATH);
+    if (server_fd < 0)
+    {
+        return -1;
+    }
+
+    return start_server_thread(server_fd, debug_stream_thread);
+}
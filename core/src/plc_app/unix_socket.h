@@ -4,10 +4,49 @@
 #define SOCKET_PATH "/run/runtime/plc_runtime.socket"
 #define COMMAND_BUFFER_SIZE 8192
 #define MAX_RESPONSE_SIZE 16384
-#define MAX_CLIENTS 1
+// Command clients served at once (the webserver plus monitoring tools)
+#define MAX_CLIENTS 8
+
+// Binary debug frames: DEBUG_FRAME_MAGIC, 16-bit big-endian payload length,
+// then the raw debug payload (function codes 0x41-0x45). Replies use the same
+// framing; a zero length reply means the request could not be processed.
+// The magic byte can never start a text command, so both modes share the
+// connection.
+#define DEBUG_FRAME_MAGIC 0xFE
+#define DEBUG_FRAME_HEADER_SIZE 3
+
+// Tagged requests, for clients that keep several requests in flight:
+// TAGGED_FRAME_MAGIC [request id, 4 bytes BE] [kind] [length, 2 bytes BE]
+// [body...]. The body is a text command without its newline (kind 0) or a
+// debug payload (kind 1). Every reply frame has the same header with the
+// request id and flags instead of the kind; the last one carries
+// TAGGED_FLAG_FINAL. A text command is answered by one frame holding the
+// response line, a debug payload by one frame like an untagged debug frame,
+// and DEBUG_GET_PAGED by one frame per page followed by an empty final frame.
+// Tagged requests are queued to a worker per lane, so replies come back out
+// of order: queries (STATUS, STATS, ...) never wait behind the program lane
+// (START, STOP, ONLINE_CHANGE, PLUGIN:, DEBUG: and debug payloads). Untagged
+// requests are still answered in order on the socket thread.
+#define TAGGED_FRAME_MAGIC 0xFD
+#define TAGGED_FRAME_HEADER_SIZE 8
+#define TAGGED_KIND_COMMAND 0
+#define TAGGED_KIND_DEBUG 1
+#define TAGGED_FLAG_FINAL 0x01
+#define TAGGED_FLAG_REJECTED 0x02 // not served: lane queue full or bad request, empty body
+// Requests waiting per lane before new ones are rejected
+#define TAGGED_QUEUE_DEPTH 64
 
 int setup_unix_socket(void);
 void close_unix_socket(int server_fd);
 void *unix_socket_thread(void *arg);
 
+// Debug stream socket (DEBUG_STREAM_SOCKET_PATH): the client sends subscribe
+// requests as binary frames and the runtime pushes one frame per captured
+// sample: 47 [tick, 4 bytes BE] [flags] [length, 2 bytes BE] [data...]
+#define DEBUG_SAMPLE_HEADER_SIZE 8
+#define DEBUG_STREAM_POLL_MS 2
+
+int setup_debug_stream_socket(void);
+void *debug_stream_thread(void *arg);
+
 #endif // UNIX_SOCKET_H
@@ -0,0 +1,80 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "boot_timeline.h"
+#include "log.h"
+#include "utils.h"
+
+typedef struct
+{
+    const char *phase;
+    uint64_t ns;
+} boot_mark_t;
+
+static pthread_mutex_t timeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+static boot_mark_t marks[BOOT_TIMELINE_MAX_MARKS];
+static size_t mark_count = 0;
+static uint64_t start_ns = 0;
+static bool open        = false;
+
+static uint64_t boot_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void boot_timeline_start(void)
+{
+    pthread_mutex_lock(&timeline_mutex);
+    start_ns   = boot_now_ns();
+    mark_count = 0;
+    open       = true;
+    pthread_mutex_unlock(&timeline_mutex);
+}
+
+void boot_timeline_mark(const char *phase)
+{
+    uint64_t now = boot_now_ns();
+    pthread_mutex_lock(&timeline_mutex);
+    if (open && mark_count < BOOT_TIMELINE_MAX_MARKS)
+    {
+        marks[mark_count++] = (boot_mark_t){.phase = phase, .ns = now - start_ns};
+    }
+    pthread_mutex_unlock(&timeline_mutex);
+}
+
+void boot_timeline_end(void)
+{
+    uint64_t now = boot_now_ns();
+    char line[768];
+    size_t written = 0;
+
+    pthread_mutex_lock(&timeline_mutex);
+    if (!open)
+    {
+        pthread_mutex_unlock(&timeline_mutex);
+        return;
+    }
+    open = false;
+
+    // "phase +ms" entries in the order they were marked, cut short if too long
+    for (size_t i = 0; i < mark_count && written < sizeof(line); i++)
+    {
+        int n = snprintf(line + written, sizeof(line) - written, "%s%s %.1f", i > 0 ? ", " : "",
+                         marks[i].phase, (double)marks[i].ns / 1e6);
+        written += n > 0 ? (size_t)n : 0;
+    }
+    if (written >= sizeof(line))
+    {
+        written = sizeof(line) - 1;
+    }
+    line[written] = '\0';
+    pthread_mutex_unlock(&timeline_mutex);
+
+    log_info("[BOOT] Ready after %.1f ms (ms since start: %s)", (double)(now - start_ns) / 1e6,
+             line);
+}
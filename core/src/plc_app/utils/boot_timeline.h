@@ -0,0 +1,26 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+// Startup phases and their time since boot_timeline_start(), logged in one line
+// by boot_timeline_end(). Marks after the end are ignored, so code that also
+// runs on later program starts can mark unconditionally. Thread-safe.
+
+#define BOOT_TIMELINE_MAX_MARKS 32
+
+/**
+ * @brief Start the timeline, first thing in main()
+ */
+void boot_timeline_start(void);
+
+/**
+ * @brief Record that a startup phase finished
+ * @param phase A string literal, kept until the timeline is logged
+ */
+void boot_timeline_mark(const char *phase);
+
+/**
+ * @brief Record the runtime as ready and log the timeline, once
+ */
+void boot_timeline_end(void);
+
+#endif // BOOT_TIMELINE_H
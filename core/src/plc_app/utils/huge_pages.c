@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "huge_pages.h"
+
+// MSYS2/Cygwin has neither transparent nor explicit huge pages
+#if !defined(__CYGWIN__) && !defined(__MSYS__)
+#include <sys/mman.h>
+#define HAS_HUGE_PAGES 1
+#else
+#define HAS_HUGE_PAGES 0
+#endif
+
+// Size of a transparent huge page, and of an explicit one when
+// /proc/meminfo does not say
+#define HUGE_PAGE_DEFAULT_SIZE (2u * 1024u * 1024u)
+
+// Alignment of heap memory in the off mode
+#define HUGE_PAGES_MIN_ALIGN 64u
+
+static huge_pages_mode_t requested_mode = HUGE_PAGES_OFF;
+
+int huge_pages_set_mode(const char *text)
+{
+    if (strcmp(text, "off") == 0)
+    {
+        requested_mode = HUGE_PAGES_OFF;
+    }
+    else if (strcmp(text, "thp") == 0)
+    {
+        requested_mode = HUGE_PAGES_TRANSPARENT;
+    }
+    else if (strcmp(text, "explicit") == 0)
+    {
+        requested_mode = HUGE_PAGES_EXPLICIT;
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+huge_pages_mode_t huge_pages_mode(void)
+{
+    return requested_mode;
+}
+
+const char *huge_pages_mode_name(huge_pages_mode_t mode)
+{
+    switch (mode)
+    {
+    case HUGE_PAGES_TRANSPARENT:
+        return "thp";
+    case HUGE_PAGES_EXPLICIT:
+        return "explicit";
+    default:
+        return "off";
+    }
+}
+
+static size_t round_up(size_t size, size_t multiple)
+{
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+#if HAS_HUGE_PAGES
+#ifdef MAP_HUGETLB
+// Default size of the reserved pool's pages, which MAP_HUGETLB maps
+static size_t explicit_page_size(void)
+{
+    size_t size = HUGE_PAGE_DEFAULT_SIZE;
+    FILE *meminfo = fopen("/proc/meminfo", "r");
+    if (meminfo == NULL)
+    {
+        return size;
+    }
+
+    char line[128];
+    unsigned long kb;
+    while (fgets(line, sizeof(line), meminfo) != NULL)
+    {
+        if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1 && kb > 0)
+        {
+            size = (size_t)kb * 1024u;
+            break;
+        }
+    }
+    fclose(meminfo);
+    return size;
+}
+
+static void *alloc_explicit(size_t size)
+{
+    void *mem = mmap(NULL, round_up(size, explicit_page_size()), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return mem == MAP_FAILED ? NULL : mem;
+}
+#endif
+
+// Map one huge page more than needed and trim both ends, so the region
+// starts on a huge page boundary and the kernel can back all of it
+static void *alloc_transparent(size_t size)
+{
+    size_t length = round_up(size, HUGE_PAGE_DEFAULT_SIZE);
+    uint8_t *mem  = mmap(NULL, length + HUGE_PAGE_DEFAULT_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    uint8_t *aligned = (uint8_t *)round_up((uintptr_t)mem, HUGE_PAGE_DEFAULT_SIZE);
+    if (aligned > mem)
+    {
+        munmap(mem, (size_t)(aligned - mem));
+    }
+    size_t tail = (size_t)(mem + length + HUGE_PAGE_DEFAULT_SIZE - (aligned + length));
+    if (tail > 0)
+    {
+        munmap(aligned + length, tail);
+    }
+
+#ifdef MADV_HUGEPAGE
+    // Advisory only: with THP disabled this is regular memory
+    madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+#endif
+
+void *huge_pages_alloc(size_t size, huge_pages_mode_t *backing)
+{
+    void *mem              = NULL;
+    huge_pages_mode_t used = HUGE_PAGES_OFF;
+
+#if HAS_HUGE_PAGES
+    if (size > 0 && requested_mode == HUGE_PAGES_EXPLICIT)
+    {
+#ifdef MAP_HUGETLB
+        mem  = alloc_explicit(size);
+        used = HUGE_PAGES_EXPLICIT;
+#endif
+    }
+    if (size > 0 && mem == NULL && requested_mode != HUGE_PAGES_OFF)
+    {
+        mem  = alloc_transparent(size);
+        used = HUGE_PAGES_TRANSPARENT;
+    }
+#endif
+
+    // Anonymous mappings are zeroed already. Heap memory is cache line
+    // aligned like them, which the journal rings rely on.
+    if (mem == NULL)
+    {
+        size_t length = round_up(size > 0 ? size : 1, HUGE_PAGES_MIN_ALIGN);
+        mem           = aligned_alloc(HUGE_PAGES_MIN_ALIGN, length);
+        if (mem != NULL)
+        {
+            memset(mem, 0, length);
+        }
+        used = HUGE_PAGES_OFF;
+    }
+
+    if (backing != NULL)
+    {
+        *backing = used;
+    }
+    return mem;
+}
@@ -0,0 +1,48 @@
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <stddef.h>
+
+// Backing for memory the scan touches every cycle (image tables, journal
+// rings), so it sits in a few TLB entries instead of hundreds of 4K pages.
+// Set from the command line before the first allocation. Does not log, the
+// journal uses it outside plc_main too.
+
+typedef enum
+{
+    HUGE_PAGES_OFF,         // regular heap memory
+    HUGE_PAGES_TRANSPARENT, // 2 MiB aligned anonymous memory advised as MADV_HUGEPAGE
+    HUGE_PAGES_EXPLICIT     // MAP_HUGETLB from the reserved pool (vm.nr_hugepages)
+} huge_pages_mode_t;
+
+/**
+ * @brief Set the huge page mode for later allocations
+ *
+ * @param text "off", "thp" or "explicit"
+ * @return 0 on success, -1 if the mode is not known
+ */
+int huge_pages_set_mode(const char *text);
+
+/**
+ * @brief The requested huge page mode
+ */
+huge_pages_mode_t huge_pages_mode(void);
+
+/**
+ * @brief Name of a mode as accepted by huge_pages_set_mode()
+ */
+const char *huge_pages_mode_name(huge_pages_mode_t mode);
+
+/**
+ * @brief Allocate zeroed memory kept for the process lifetime
+ *
+ * In explicit mode, falls back to transparent huge pages when the pool is
+ * empty. The memory is at least 64 byte aligned and never freed.
+ *
+ * @param size Bytes to allocate
+ * @param backing Set to the backing actually used, may be NULL
+ * @return The memory, or NULL on failure
+ */
+void *huge_pages_alloc(size_t size, huge_pages_mode_t *backing);
+
+#endif // HUGE_PAGES_H
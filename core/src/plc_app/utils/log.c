@@ -1,13 +1,17 @@
 #include "log.h"
 #include <errno.h>
+#include <poll.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
@@ -24,75 +28,393 @@ void log_set_level(LogLevel level)
     current_level = level;
 }
 
-// Create circular buffer for unsent logs
-#define LOG_BUFFER_SIZE 1024
+// Largest record sent to the socket
 #define LOG_MESSAGE_SIZE 2048
-char log_buffer[LOG_BUFFER_SIZE][LOG_MESSAGE_SIZE];
-int log_buffer_start = 0;
-int log_buffer_end   = 0;
+
+// Backlog of records not yet sent, kept while the log socket is disconnected.
+// Records are a 2-byte length followed by the line and never wrap: when one
+// does not fit before the end of the ring, a zero length (or fewer than two
+// bytes left) sends the reader back to offset 0. The oldest records are
+// dropped to make room. (The record itself carries its own length too.)
+#define LOG_BACKLOG_BATCH 64 // records per writev() when flushing
+
+static uint8_t *backlog_data           = NULL;
+static size_t backlog_size             = LOG_BACKLOG_DEFAULT_SIZE;
+static size_t backlog_head             = 0; // oldest record
+static size_t backlog_tail             = 0; // next free byte
+static size_t backlog_count            = 0;
+static unsigned long long backlog_lost = 0; // records dropped for room since the last flush
+
+// Queue between the logging threads and the log thread. Callers only format
+// the message into a free slot; building the record, stdout and socket I/O
+// are all done by the log thread. Bounded MPSC ring in the style of
+// Vyukov's queue: a slot is free for position `pos` when its sequence equals
+// `pos`, and holds a message for the consumer when it equals `pos + 1`.
+#define LOG_QUEUE_SLOTS 256 // power of two
+#define LOG_QUEUE_MESSAGE_SIZE 1024
+
+typedef struct
+{
+    atomic_size_t sequence;
+    LogLevel level;
+    uint16_t source;
+    uint64_t timestamp_ns;
+    char message[LOG_QUEUE_MESSAGE_SIZE];
+} log_slot_t;
+
+static log_slot_t log_queue[LOG_QUEUE_SLOTS];
+static atomic_size_t log_queue_head = 0; // next position claimed by a producer
+static size_t log_queue_tail        = 0; // next position read by the log thread
+
+static bool log_async_enabled            = true;
+static atomic_bool log_async_running     = false;
+static atomic_bool log_thread_waiting    = false;
+static atomic_ullong log_dropped         = 0;
+static unsigned long long log_drops_seen = 0;
+static int log_wake_fd                   = -1;
+static pthread_t log_thread_id;
+
+// How long the log thread sleeps without messages, between connection checks
+#define LOG_RECONNECT_INTERVAL_MS 1000
+
+static uint64_t log_timestamp_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Encode one socket record, see LOG_RECORD_MAGIC. Returns its length.
+static size_t format_record(uint8_t *record, size_t size, LogLevel level, uint16_t source,
+                            uint64_t timestamp_ns, const char *message)
+{
+    size_t length = strnlen(message, size - LOG_RECORD_HEADER_SIZE);
+    size_t body   = LOG_RECORD_HEADER_SIZE - 3 + length;
+
+    record[0] = LOG_RECORD_MAGIC;
+    record[1] = (uint8_t)(body & 0xFF);
+    record[2] = (uint8_t)(body >> 8);
+    for (int i = 0; i < 8; i++)
+    {
+        record[3 + i] = (uint8_t)(timestamp_ns >> (8 * i));
+    }
+    record[11] = (uint8_t)level;
+    record[12] = (uint8_t)(source & 0xFF);
+    record[13] = (uint8_t)(source >> 8);
+    memcpy(&record[LOG_RECORD_HEADER_SIZE], message, length);
+
+    return LOG_RECORD_HEADER_SIZE + length;
+}
+
+void log_set_async(bool enabled)
+{
+    log_async_enabled = enabled;
+}
+
+static void deliver_message(LogLevel level, uint16_t source, uint64_t timestamp_ns,
+                            const char *message);
+static void flush_backlog(void);
+static void limiter_sweep(void);
+
+// Hand every published message to the socket, stdout or the backlog
+static void drain_queue(void)
+{
+    for (;;)
+    {
+        log_slot_t *slot = &log_queue[log_queue_tail & (LOG_QUEUE_SLOTS - 1)];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != log_queue_tail + 1)
+        {
+            break;
+        }
+
+        pthread_mutex_lock(&log_mutex);
+        deliver_message(slot->level, slot->source, slot->timestamp_ns, slot->message);
+        pthread_mutex_unlock(&log_mutex);
+
+        atomic_store_explicit(&slot->sequence, log_queue_tail + LOG_QUEUE_SLOTS,
+                              memory_order_release);
+        log_queue_tail++;
+    }
+
+    unsigned long long dropped = atomic_load_explicit(&log_dropped, memory_order_relaxed);
+    if (dropped != log_drops_seen)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "Log queue full, %llu messages dropped",
+                 dropped - log_drops_seen);
+        log_drops_seen = dropped;
+
+        pthread_mutex_lock(&log_mutex);
+        deliver_message(LOG_LEVEL_WARN, LOG_SOURCE_RUNTIME, log_timestamp_ns(), message);
+        pthread_mutex_unlock(&log_mutex);
+    }
+}
+
+// Sleep until a producer publishes a message or the timeout expires
+static void wait_for_messages(int timeout_ms)
+{
+    // Pairs with the fence in log_write: either the producer sees the flag and
+    // wakes us, or we see its message here and do not sleep
+    atomic_store_explicit(&log_thread_waiting, true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    log_slot_t *slot = &log_queue[log_queue_tail & (LOG_QUEUE_SLOTS - 1)];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != log_queue_tail + 1)
+    {
+        struct pollfd pfd = {.fd = log_wake_fd, .events = POLLIN};
+        if (poll(&pfd, 1, timeout_ms) > 0)
+        {
+            uint64_t count;
+            if (read(log_wake_fd, &count, sizeof(count)) < 0)
+            {
+                // Nothing to do, the counter is reset by the next successful read
+            }
+        }
+    }
+
+    atomic_store_explicit(&log_thread_waiting, false, memory_order_relaxed);
+}
 
 void *log_thread_management(void *arg)
 {
     char *unix_socket_path = (char *)arg;
+    time_t next_connect    = 0;
 
     while (keep_running)
     {
-        if (socket_fd < 0)
+        if (socket_fd < 0 && time(NULL) >= next_connect)
         {
+            // Wait before retrying
+            next_connect = time(NULL) + LOG_RECONNECT_INTERVAL_MS / 1000;
+
             struct sockaddr_un addr;
-            socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
-            if (socket_fd < 0)
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
             {
                 log_error("Log socket creation failed: %s", strerror(errno));
-                // Wait before retrying
-                sleep(1);
-                continue;
             }
-
-            memset(&addr, 0, sizeof(addr));
-            addr.sun_family = AF_UNIX;
-            strncpy(addr.sun_path, unix_socket_path, sizeof(addr.sun_path) - 1);
-            if (connect(socket_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+            else
             {
-                log_error("Log socket connection failed: %s", strerror(errno));
-                close(socket_fd);
-                socket_fd = -1;
+                memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                strncpy(addr.sun_path, unix_socket_path, sizeof(addr.sun_path) - 1);
+                if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+                {
+                    log_error("Log socket connection failed: %s", strerror(errno));
+                    close(fd);
+                }
+                else
+                {
+                    // Send what was stored while disconnected right away
+                    pthread_mutex_lock(&log_mutex);
+                    socket_fd = fd;
+                    flush_backlog();
+                    pthread_mutex_unlock(&log_mutex);
+                }
             }
         }
 
-        // Wait before rechecking the connection
-        sleep(1);
+        drain_queue();
+        limiter_sweep();
+        wait_for_messages(LOG_RECONNECT_INTERVAL_MS);
     }
 
-    close(socket_fd);
-    socket_fd = -1;
+    // Later messages are delivered by their callers. One that was queued just
+    // before the switch would wait in the ring, so drain once more after it.
+    atomic_store(&log_async_running, false);
+    drain_queue();
+
+    pthread_mutex_lock(&log_mutex);
+    if (socket_fd >= 0)
+    {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    pthread_mutex_unlock(&log_mutex);
 
     return NULL;
 }
 
-static void store_on_buffer(const char *msg)
+int log_set_backlog_size(size_t bytes)
+{
+    if (backlog_data != NULL || bytes < LOG_BACKLOG_MIN_SIZE || bytes > LOG_BACKLOG_MAX_SIZE)
+    {
+        return -1;
+    }
+    backlog_size = bytes;
+    return 0;
+}
+
+static bool backlog_alloc(void)
+{
+    if (backlog_data == NULL)
+    {
+        backlog_data = malloc(backlog_size);
+    }
+    return backlog_data != NULL;
+}
+
+// Offset of the oldest record, following the wrap marker if there is one
+static size_t backlog_record_at(size_t offset, uint16_t *length)
+{
+    if (backlog_size - offset < sizeof(*length))
+    {
+        offset = 0;
+    }
+    memcpy(length, &backlog_data[offset], sizeof(*length));
+    if (*length == 0)
+    {
+        offset = 0;
+        memcpy(length, &backlog_data[offset], sizeof(*length));
+    }
+    return offset;
+}
+
+static void backlog_pop(void)
 {
-    strncpy(log_buffer[log_buffer_end], msg, sizeof(log_buffer[log_buffer_end]) - 1);
-    log_buffer[log_buffer_end][sizeof(log_buffer[log_buffer_end]) - 1] = '\0';
-    log_buffer_end = (log_buffer_end + 1) % LOG_BUFFER_SIZE;
+    uint16_t length;
+    backlog_head = backlog_record_at(backlog_head, &length) + sizeof(length) + length;
+    if (--backlog_count == 0)
+    {
+        backlog_head = 0;
+        backlog_tail = 0;
+    }
+}
 
-    // If buffer is full, move start forward
-    if (log_buffer_end == log_buffer_start)
+static void store_on_buffer(const uint8_t *msg, size_t length)
+{
+    if (!backlog_alloc())
     {
-        log_buffer_start = (log_buffer_start + 1) % LOG_BUFFER_SIZE;
+        return;
     }
+
+    size_t need = sizeof(uint16_t) + length;
+    for (;;)
+    {
+        if (backlog_count == 0)
+        {
+            break; // the minimum size always holds one record
+        }
+        if (backlog_tail > backlog_head)
+        {
+            if (backlog_tail + need <= backlog_size)
+            {
+                break;
+            }
+            if (need <= backlog_head)
+            {
+                // Wrap: mark the rest of the ring unused
+                if (backlog_size - backlog_tail >= sizeof(uint16_t))
+                {
+                    memset(&backlog_data[backlog_tail], 0, sizeof(uint16_t));
+                }
+                backlog_tail = 0;
+                break;
+            }
+        }
+        else if (backlog_tail + need <= backlog_head)
+        {
+            break;
+        }
+
+        // If buffer is full, drop the oldest record
+        backlog_pop();
+        backlog_lost++;
+    }
+
+    uint16_t record_length = (uint16_t)length;
+    memcpy(&backlog_data[backlog_tail], &record_length, sizeof(record_length));
+    memcpy(&backlog_data[backlog_tail + sizeof(record_length)], msg, length);
+    backlog_tail += need;
+    backlog_count++;
 }
 
-static char *retrieve_from_buffer(void)
+// Write the rest of a record that writev() sent only partly
+static bool write_remaining(const uint8_t *data, size_t length)
 {
-    if (log_buffer_start == log_buffer_end)
+    while (length > 0)
     {
-        return NULL; // Buffer is empty
+        ssize_t n = write(socket_fd, data, length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
     }
+    return true;
+}
+
+// Send the stored lines, oldest first, in batches of records. On error the
+// socket is closed and the records not fully sent stay in the backlog.
+static void flush_backlog(void)
+{
+    while (socket_fd >= 0 && backlog_count > 0)
+    {
+        struct iovec iov[LOG_BACKLOG_BATCH];
+        size_t records = 0;
+        size_t offset  = backlog_head;
+        while (records < LOG_BACKLOG_BATCH && records < backlog_count)
+        {
+            uint16_t length;
+            offset                = backlog_record_at(offset, &length);
+            iov[records].iov_base = &backlog_data[offset + sizeof(length)];
+            iov[records].iov_len  = length;
+            offset += sizeof(length) + length;
+            records++;
+        }
 
-    char *msg        = log_buffer[log_buffer_start];
-    log_buffer_start = (log_buffer_start + 1) % LOG_BUFFER_SIZE;
-    return msg;
+        ssize_t sent = writev(socket_fd, iov, (int)records);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        size_t written = sent < 0 ? 0 : (size_t)sent;
+        bool failed    = sent <= 0;
+        for (size_t i = 0; i < records && !failed && written > 0; i++)
+        {
+            if (written < iov[i].iov_len)
+            {
+                failed = !write_remaining((uint8_t *)iov[i].iov_base + written,
+                                          iov[i].iov_len - written);
+                if (failed)
+                {
+                    break;
+                }
+                written = iov[i].iov_len;
+            }
+            written -= iov[i].iov_len;
+            backlog_pop();
+        }
+
+        if (failed)
+        {
+            // On error, close the socket to trigger reconnection
+            close(socket_fd);
+            socket_fd = -1;
+        }
+    }
+
+    if (socket_fd >= 0 && backlog_lost > 0)
+    {
+        char message[128];
+        uint8_t record[LOG_RECORD_HEADER_SIZE + sizeof(message)];
+        snprintf(message, sizeof(message),
+                 "Log backlog full, %llu messages dropped while disconnected", backlog_lost);
+        size_t length = format_record(record, sizeof(record), LOG_LEVEL_WARN, LOG_SOURCE_RUNTIME,
+                                      log_timestamp_ns(), message);
+        backlog_lost  = 0;
+        if (!write_remaining(record, length))
+        {
+            close(socket_fd);
+            socket_fd = -1;
+        }
+    }
 }
 
 int log_init(char *unix_socket_path)
@@ -106,10 +428,37 @@ int log_init(char *unix_socket_path)
     }
     strcpy(path_copy, unix_socket_path);
 
+    // Allocate the backlog now so it is part of the locked memory
+    pthread_mutex_lock(&log_mutex);
+    bool allocated = backlog_alloc();
+    pthread_mutex_unlock(&log_mutex);
+    if (!allocated)
+    {
+        free(path_copy);
+        perror("Failed to allocate the log backlog");
+        return -1;
+    }
+
+    if (log_async_enabled)
+    {
+        log_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (log_wake_fd < 0)
+        {
+            free(path_copy);
+            perror("Failed to create log wake-up descriptor");
+            return -1;
+        }
+        for (size_t i = 0; i < LOG_QUEUE_SLOTS; i++)
+        {
+            atomic_init(&log_queue[i].sequence, i);
+        }
+        atomic_store(&log_async_running, true);
+    }
+
     // Create the logging thread
-    pthread_t thread_id;
-    if (pthread_create(&thread_id, NULL, log_thread_management, path_copy) != 0)
+    if (pthread_create(&log_thread_id, NULL, log_thread_management, path_copy) != 0)
     {
+        atomic_store(&log_async_running, false);
         free(path_copy);
         perror("Failed to create log thread");
         return -1;
@@ -118,6 +467,25 @@ int log_init(char *unix_socket_path)
     return 0; // Success
 }
 
+void log_shutdown(void)
+{
+    if (log_wake_fd < 0)
+    {
+        return;
+    }
+
+    // keep_running is already cleared, wake the thread so it notices now
+    uint64_t one = 1;
+    if (write(log_wake_fd, &one, sizeof(one)) < 0)
+    {
+        // The thread still exits at its next timeout
+    }
+    pthread_join(log_thread_id, NULL);
+
+    // Nothing consumes the ring any more, pick up a late message
+    drain_queue();
+}
+
 static const char *level_to_str(LogLevel level)
 {
     switch (level)
@@ -135,100 +503,114 @@ static const char *level_to_str(LogLevel level)
     }
 }
 
-static void log_write(LogLevel level, const char *fmt, va_list args)
+// Format the message for stdout and the socket and send, or store it for
+// later. Called with log_mutex held.
+static void deliver_message(LogLevel level, uint16_t source, uint64_t timestamp_ns,
+                            const char *message)
 {
-    if (level < current_level)
+    uint8_t log_msg[LOG_MESSAGE_SIZE];
+    size_t length = format_record(log_msg, sizeof(log_msg), level, source, timestamp_ns, message);
+
+    // Send any buffered messages first, then the current one
+    flush_backlog();
+    if (socket_fd >= 0 && !write_remaining(log_msg, length))
     {
-        return;
+        // On error, close the socket to trigger reconnection
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    if (socket_fd < 0)
+    {
+        // Store message in buffer
+        store_on_buffer(log_msg, length);
     }
 
-    // Capture time for timestamp
-    time_t now = time(NULL);
-    struct tm t;
-    localtime_r(&now, &t);
-
-    char stdout_msg[LOG_MESSAGE_SIZE];
-    char log_msg[LOG_MESSAGE_SIZE];
-
+    // Print to stdout if enabled
     if (print_logs)
     {
-        // Create a copy of va_list for stdout formatting
-        va_list args_copy;
-        va_copy(args_copy, args);
+        time_t timestamp = (time_t)(timestamp_ns / 1000000000ull);
+        struct tm t;
+        localtime_r(&timestamp, &t);
 
-        // Format for stdout
         char time_buf[20];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &t);
+        fprintf(stdout, "[%s] [%s] %s\n", time_buf, level_to_str(level), message);
+    }
+}
 
-        int n =
-            snprintf(stdout_msg, sizeof(stdout_msg), "[%s] [%s] ", time_buf, level_to_str(level));
-        n += vsnprintf(stdout_msg + n, sizeof(stdout_msg) - n, fmt, args_copy);
-        snprintf(stdout_msg + n, sizeof(stdout_msg) - n, "\n");
-
-        // Cleanup
-        va_end(args_copy);
+static void log_write(LogLevel level, uint16_t source, const char *fmt, va_list args)
+{
+    if (level < current_level)
+    {
+        return;
     }
 
-    // Format the log message in JSON format
-    int n =
-        snprintf(log_msg, sizeof(log_msg), "{\"timestamp\":\"%ld\",\"level\":\"%s\",\"message\":\"",
-                 (long)now, level_to_str(level));
-    n += vsnprintf(log_msg + n, sizeof(log_msg) - n, fmt, args);
-    snprintf(log_msg + n, sizeof(log_msg) - n, "\"}\n");
+    // Capture time for timestamp
+    uint64_t now = log_timestamp_ns();
+
+    if (!atomic_load_explicit(&log_async_running, memory_order_acquire))
+    {
+        // No log thread (synchronous mode, or before init or after shutdown)
+        char message[LOG_QUEUE_MESSAGE_SIZE];
+        vsnprintf(message, sizeof(message), fmt, args);
 
-    // Send to unix socket if connected
-    pthread_mutex_lock(&log_mutex);
-    if (socket_fd >= 0)
+        pthread_mutex_lock(&log_mutex);
+        deliver_message(level, source, now, message);
+        pthread_mutex_unlock(&log_mutex);
+        return;
+    }
+
+    // Claim a free slot, or drop the message if the log thread is behind
+    log_slot_t *slot;
+    size_t pos = atomic_load_explicit(&log_queue_head, memory_order_relaxed);
+    for (;;)
     {
-        // Send any buffered messages first
-        char *buffered_msg = retrieve_from_buffer();
-        while (buffered_msg != NULL)
+        slot          = &log_queue[pos & (LOG_QUEUE_SLOTS - 1)];
+        size_t seq    = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
         {
-            if (write(socket_fd, buffered_msg, strlen(buffered_msg)) == -1)
+            if (atomic_compare_exchange_weak_explicit(&log_queue_head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
             {
-                // On error, close the socket to trigger reconnection
-                close(socket_fd);
-                socket_fd = -1;
-                // Rewind index to re-store the message
-                log_buffer_start = (log_buffer_start - 1 + LOG_BUFFER_SIZE) % LOG_BUFFER_SIZE;
                 break;
             }
-            buffered_msg = retrieve_from_buffer();
         }
-
-        // Send current message
-        if (socket_fd >= 0)
+        else if (diff < 0)
         {
-            if (write(socket_fd, log_msg, strlen(log_msg)) == -1)
-            {
-                // On error, close the socket to trigger reconnection
-                close(socket_fd);
-                socket_fd = -1;
-
-                // Store message in buffer
-                store_on_buffer(log_msg);
-            }
+            atomic_fetch_add_explicit(&log_dropped, 1, memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&log_queue_head, memory_order_relaxed);
         }
-    }
-    else
-    {
-        store_on_buffer(log_msg);
     }
 
-    // Print to stdout if enabled
-    if (print_logs)
+    slot->level        = level;
+    slot->source       = source;
+    slot->timestamp_ns = now;
+    vsnprintf(slot->message, sizeof(slot->message), fmt, args);
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    // Pairs with the fence in wait_for_messages
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&log_thread_waiting, memory_order_relaxed) &&
+        atomic_exchange_explicit(&log_thread_waiting, false, memory_order_relaxed))
     {
-        fputs(stdout_msg, stdout);
+        uint64_t one = 1;
+        if (write(log_wake_fd, &one, sizeof(one)) < 0)
+        {
+            // Counter saturated, the thread is being woken anyway
+        }
     }
-
-    pthread_mutex_unlock(&log_mutex);
 }
 
 void log_info(const char *fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    log_write(LOG_LEVEL_INFO, fmt, args);
+    log_write(LOG_LEVEL_INFO, LOG_SOURCE_RUNTIME, fmt, args);
     va_end(args);
 }
 
@@ -236,7 +618,7 @@ void log_debug(const char *fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    log_write(LOG_LEVEL_DEBUG, fmt, args);
+    log_write(LOG_LEVEL_DEBUG, LOG_SOURCE_RUNTIME, fmt, args);
     va_end(args);
 }
 
@@ -244,7 +626,7 @@ void log_warn(const char *fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    log_write(LOG_LEVEL_WARN, fmt, args);
+    log_write(LOG_LEVEL_WARN, LOG_SOURCE_RUNTIME, fmt, args);
     va_end(args);
 }
 
@@ -252,6 +634,213 @@ void log_error(const char *fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    log_write(LOG_LEVEL_ERROR, fmt, args);
+    log_write(LOG_LEVEL_ERROR, LOG_SOURCE_RUNTIME, fmt, args);
+    va_end(args);
+}
+
+static void log_source_write(LogLevel level, uint16_t source, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    log_write(level, source, fmt, args);
     va_end(args);
 }
+
+void log_message(int source, int level, const char *message)
+{
+    if (message == NULL || level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_ERROR)
+    {
+        return;
+    }
+    // The message is never used as a format string
+    log_source_write((LogLevel)level, (uint16_t)source, "%s", message);
+}
+
+// Rate limiting for log_message_limited. Every key gets a token bucket,
+// implemented as GCRA: a burst of limit_burst messages, then one every
+// limit_interval_ns. Messages over the limit are counted; the count is logged
+// once the key may log again, or by the log thread after LOG_LIMIT_SUMMARY_NS.
+#define LOG_LIMIT_SLOTS 64 // power of two
+#define LOG_LIMIT_PROBES 4
+#define LOG_LIMIT_SAMPLE_SIZE 128
+#define LOG_LIMIT_SUMMARY_NS (5ull * 1000000000ull)
+#define LOG_LIMIT_IDLE_NS (60ull * 1000000000ull) // free keys unused this long
+
+typedef struct
+{
+    uint32_t key; // 0 = free slot
+    uint16_t source;
+    LogLevel level;
+    uint64_t tat_ns;   // theoretical arrival time of the next conforming message
+    uint64_t last_ns;  // last message for this key
+    uint64_t first_ns; // first message suppressed since the last summary
+    uint32_t suppressed;
+    char sample[LOG_LIMIT_SAMPLE_SIZE]; // first suppressed message
+} log_limit_t;
+
+static log_limit_t limits[LOG_LIMIT_SLOTS];
+static pthread_mutex_t limit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int limit_burst    = LOG_RATE_LIMIT_DEFAULT_BURST;
+static uint64_t limit_interval_ns  = 1000000000ull / LOG_RATE_LIMIT_DEFAULT_RATE;
+static uint64_t limit_last_sweep   = 0;
+
+int log_set_rate_limit(unsigned int burst, unsigned int per_second)
+{
+    if (burst == 0 || per_second > 1000000000u)
+    {
+        return -1;
+    }
+    limit_burst       = burst;
+    limit_interval_ns = per_second == 0 ? 0 : 1000000000ull / per_second;
+    return 0;
+}
+
+// FNV-1a over the message, mixed with the source and level
+static uint32_t limit_key(int source, int level, unsigned int key, const char *message)
+{
+    uint32_t hash = key;
+    if (hash == 0)
+    {
+        hash = 2166136261u;
+        for (const unsigned char *c = (const unsigned char *)message; *c != '\0'; c++)
+        {
+            hash = (hash ^ *c) * 16777619u;
+        }
+    }
+    hash ^= ((uint32_t)source * 0x9E3779B1u) ^ (uint32_t)level;
+    return hash == 0 ? 1 : hash;
+}
+
+static void limit_summary(const log_limit_t *limit, char *summary, size_t size)
+{
+    snprintf(summary, size, "%s (repeated %u more times)", limit->sample, limit->suppressed);
+}
+
+// Decide whether the message may be logged. If an earlier run of suppressed
+// messages has to be reported first, the summary is written to `summary`.
+// Called with limit_mutex held.
+static bool limit_allow(uint32_t key, uint16_t source, LogLevel level, const char *message,
+                        uint64_t now, char *summary, size_t size)
+{
+    log_limit_t *limit  = NULL;
+    log_limit_t *victim = NULL;
+    for (uint32_t i = 0; i < LOG_LIMIT_PROBES; i++)
+    {
+        log_limit_t *slot = &limits[(key + i) & (LOG_LIMIT_SLOTS - 1)];
+        if (slot->key == key && slot->source == source && slot->level == level)
+        {
+            limit = slot;
+            break;
+        }
+        if (victim == NULL ||
+            (victim->key != 0 && (slot->key == 0 || slot->last_ns < victim->last_ns)))
+        {
+            victim = slot;
+        }
+    }
+
+    uint64_t tolerance = limit_interval_ns * (limit_burst - 1);
+    if (limit == NULL)
+    {
+        // Take a free slot or the least recently used one of the probe range
+        if (victim->key != 0 && victim->suppressed > 0)
+        {
+            limit_summary(victim, summary, size);
+        }
+        victim->key        = key;
+        victim->source     = source;
+        victim->level      = level;
+        victim->tat_ns     = now + limit_interval_ns;
+        victim->last_ns    = now;
+        victim->suppressed = 0;
+        return true;
+    }
+
+    limit->last_ns = now;
+    if (now + tolerance >= limit->tat_ns)
+    {
+        limit->tat_ns = (limit->tat_ns > now ? limit->tat_ns : now) + limit_interval_ns;
+        if (limit->suppressed > 0)
+        {
+            limit_summary(limit, summary, size);
+            limit->suppressed = 0;
+        }
+        return true;
+    }
+
+    if (limit->suppressed++ == 0)
+    {
+        limit->first_ns = now;
+        strncpy(limit->sample, message, sizeof(limit->sample) - 1);
+        limit->sample[sizeof(limit->sample) - 1] = '\0';
+    }
+    return false;
+}
+
+void log_message_limited(int source, int level, unsigned int key, const char *message)
+{
+    if (message == NULL || level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_ERROR ||
+        (LogLevel)level < current_level)
+    {
+        return;
+    }
+    if (limit_interval_ns == 0)
+    {
+        log_message(source, level, message);
+        return;
+    }
+
+    // Never wait for another thread here: when the table is busy, log anyway
+    char summary[LOG_LIMIT_SAMPLE_SIZE + 48] = "";
+    bool allow                               = true;
+    if (pthread_mutex_trylock(&limit_mutex) == 0)
+    {
+        allow = limit_allow(limit_key(source, level, key, message), (uint16_t)source,
+                            (LogLevel)level, message, log_timestamp_ns(), summary,
+                            sizeof(summary));
+        pthread_mutex_unlock(&limit_mutex);
+    }
+
+    if (summary[0] != '\0')
+    {
+        log_source_write((LogLevel)level, (uint16_t)source, "%s", summary);
+    }
+    if (allow)
+    {
+        log_source_write((LogLevel)level, (uint16_t)source, "%s", message);
+    }
+}
+
+// Log thread: report runs of suppressed messages that went quiet and free
+// keys that are no longer used
+static void limiter_sweep(void)
+{
+    uint64_t now = log_timestamp_ns();
+    if (now - limit_last_sweep < 1000000000ull)
+    {
+        return;
+    }
+    limit_last_sweep = now;
+
+    pthread_mutex_lock(&limit_mutex);
+    for (size_t i = 0; i < LOG_LIMIT_SLOTS; i++)
+    {
+        log_limit_t *limit = &limits[i];
+        if (limit->key == 0)
+        {
+            continue;
+        }
+        if (limit->suppressed > 0 && now - limit->first_ns >= LOG_LIMIT_SUMMARY_NS)
+        {
+            char summary[LOG_LIMIT_SAMPLE_SIZE + 48];
+            limit_summary(limit, summary, sizeof(summary));
+            limit->suppressed = 0;
+            log_source_write(limit->level, limit->source, "%s", summary);
+        }
+        else if (limit->suppressed == 0 && now - limit->last_ns >= LOG_LIMIT_IDLE_NS)
+        {
+            limit->key = 0;
+        }
+    }
+    pthread_mutex_unlock(&limit_mutex);
+}
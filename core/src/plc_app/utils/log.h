@@ -1,10 +1,36 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #define LOG_SOCKET_PATH "/run/runtime/log_runtime.socket"
 
+// Bytes kept for lines logged while the log socket is disconnected
+#define LOG_BACKLOG_DEFAULT_SIZE (64 * 1024)
+#define LOG_BACKLOG_MIN_SIZE (4 * 1024)
+#define LOG_BACKLOG_MAX_SIZE (16 * 1024 * 1024)
+
+// Default limit of log_message_limited: a burst of 10 messages per key, then
+// 2 per second
+#define LOG_RATE_LIMIT_DEFAULT_BURST 10
+#define LOG_RATE_LIMIT_DEFAULT_RATE 2
+
+/*
+ * Records are sent to the log socket in a binary format, the log server turns
+ * them into JSON. All fields are little-endian:
+ *
+ *   [magic 0xB1] [length 2] [timestamp_ns 8] [level 1] [source 2] [message]
+ *
+ * `length` counts the bytes after itself, `timestamp_ns` is CLOCK_REALTIME,
+ * `source` is LOG_SOURCE_RUNTIME or a plugin id, and the message is UTF-8
+ * without a terminator.
+ */
+#define LOG_RECORD_MAGIC 0xB1
+#define LOG_RECORD_HEADER_SIZE 14
+#define LOG_SOURCE_RUNTIME 0
+
 typedef enum {
     LOG_LEVEL_DEBUG,
     LOG_LEVEL_INFO,
@@ -19,6 +45,39 @@ typedef enum {
  */
 int log_init(char *unix_socket_path);
 
+/**
+ * @brief Choose between queued and synchronous logging
+ *
+ * By default log calls only format the message into a preallocated queue and
+ * return; the log thread timestamps, prints and sends it. When the queue is
+ * full the message is dropped and counted, and the log thread reports the
+ * count. Synchronous mode delivers every message on the calling thread, which
+ * can block it on a slow log consumer. Must be called before log_init().
+ *
+ * @param[in]  enabled  true for queued logging
+ */
+void log_set_async(bool enabled);
+
+/**
+ * @brief Set the size of the backlog of unsent lines
+ *
+ * Lines are stored with a 2-byte length while the log socket is disconnected;
+ * the oldest are dropped when the backlog is full. Must be called before
+ * log_init().
+ *
+ * @param[in]  bytes  LOG_BACKLOG_MIN_SIZE to LOG_BACKLOG_MAX_SIZE
+ * @return 0 on success, -1 if the size is out of range or the backlog exists
+ */
+int log_set_backlog_size(size_t bytes);
+
+/**
+ * @brief Stop the log thread after it delivered every queued message
+ *
+ * Called on shutdown once keep_running is cleared. Later messages are
+ * delivered synchronously.
+ */
+void log_shutdown(void);
+
 /**
  * @brief Set the log level
  *
@@ -58,4 +117,41 @@ void log_warn(const char *fmt, ...);
  */
 void log_error(const char *fmt, ...);
 
+/**
+ * @brief Log a preformatted message on behalf of a plugin
+ *
+ * Handed to plugins as plugin_runtime_args_t.log_message. The message is not
+ * a format string, so it may contain '%'.
+ *
+ * @param[in]  source   The plugin id from plugin_runtime_args_t
+ * @param[in]  level    A LogLevel value
+ * @param[in]  message  The message text
+ */
+void log_message(int source, int level, const char *message);
+
+/**
+ * @brief Log a preformatted message unless it repeats too often
+ *
+ * Messages with the same source, level and key share a token bucket (see
+ * log_set_rate_limit). Messages over the limit are dropped and counted, and
+ * the count is logged as "<message> (repeated N more times)" when the key may
+ * log again or after a few seconds. Handed to plugins as
+ * plugin_runtime_args_t.log_limited. Never waits for another thread.
+ *
+ * @param[in]  source   The plugin id from plugin_runtime_args_t
+ * @param[in]  level    A LogLevel value
+ * @param[in]  key      Identifies the call site; 0 uses a hash of the message
+ * @param[in]  message  The message text
+ */
+void log_message_limited(int source, int level, unsigned int key, const char *message);
+
+/**
+ * @brief Set the limit of log_message_limited
+ *
+ * @param[in]  burst       Messages a key may log back to back, at least 1
+ * @param[in]  per_second  Rate at which the burst refills, 0 for no limit
+ * @return 0 on success, -1 on invalid values
+ */
+int log_set_rate_limit(unsigned int burst, unsigned int per_second);
+
 #endif
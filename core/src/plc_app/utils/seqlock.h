@@ -0,0 +1,44 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/**
+ * @brief Single-writer sequence lock helpers
+ *
+ * The counter is odd while the writer is updating the protected data. A reader
+ * copies the data between seq_read_begin() and seq_read_retry() and starts
+ * over if the counter moved, so the writer never waits for readers.
+ */
+static inline void seq_write_begin(atomic_uint *seq)
+{
+    unsigned s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seq_write_end(atomic_uint *seq)
+{
+    unsigned s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_release);
+}
+
+static inline unsigned seq_read_begin(atomic_uint *seq)
+{
+    unsigned s;
+    while ((s = atomic_load_explicit(seq, memory_order_acquire)) & 1)
+    {
+        sched_yield();
+    }
+    return s;
+}
+
+static inline bool seq_read_retry(atomic_uint *seq, unsigned start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(seq, memory_order_relaxed) != start;
+}
+
+#endif // SEQLOCK_H
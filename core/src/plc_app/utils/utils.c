@@ -1,5 +1,8 @@
+#define _GNU_SOURCE
 #include "utils.h"
 #include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -7,7 +10,10 @@
 // MSYS2/Cygwin does not support mlockall or real-time scheduling
 // These features are only available on Linux
 #if !defined(__CYGWIN__) && !defined(__MSYS__)
+#include <alloca.h>
+#include <malloc.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #define HAS_REALTIME_FEATURES 1
 #else
 #define HAS_REALTIME_FEATURES 0
@@ -17,6 +23,14 @@ unsigned long long *ext_common_ticktime__ = NULL;
 unsigned long tick__                      = 0;
 char *ext_plc_program_md5                 = NULL;
 
+scheduler_config_t scheduler_config = {
+    .policy = OVERRUN_POLICY_SKIP, .max_catch_up = 1, .spin_ns = 0};
+
+// DEGRADE: largest period multiplier, and on-time cycles needed before
+// halving it again
+#define SCHEDULER_MAX_DEGRADE 8
+#define SCHEDULER_DEGRADE_RECOVER_CYCLES 100
+
 void normalize_timespec(struct timespec *ts)
 {
     while (ts->tv_nsec >= 1e9)
@@ -29,11 +43,11 @@ void normalize_timespec(struct timespec *ts)
 void sleep_until(struct timespec *ts)
 {
 #if HAS_REALTIME_FEATURES
-    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, ts, NULL);
+    clock_nanosleep(PLC_CLOCK, TIMER_ABSTIME, ts, NULL);
 #else
     // Fallback for MSYS2/Cygwin: use nanosleep (relative sleep)
     struct timespec now, remaining;
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    clock_gettime(PLC_CLOCK, &now);
     remaining.tv_sec  = ts->tv_sec - now.tv_sec;
     remaining.tv_nsec = ts->tv_nsec - now.tv_nsec;
     if (remaining.tv_nsec < 0)
@@ -48,6 +62,224 @@ void sleep_until(struct timespec *ts)
 #endif
 }
 
+static uint64_t clock_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Sleep until deadline_ns, spinning for the last spin_ns
+static void sleep_until_ns(uint64_t deadline_ns, uint64_t spin_ns)
+{
+    uint64_t wake_ns = deadline_ns > spin_ns ? deadline_ns - spin_ns : 0;
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(wake_ns / 1000000000ull);
+    ts.tv_nsec = (long)(wake_ns % 1000000000ull);
+
+#if HAS_REALTIME_FEATURES
+    while (clock_nanosleep(PLC_CLOCK, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+#else
+    sleep_until(&ts);
+#endif
+
+    if (spin_ns > 0)
+    {
+        while (clock_now_ns() < deadline_ns)
+        {
+        }
+    }
+}
+
+int scheduler_parse_overrun_policy(const char *text, scheduler_config_t *config)
+{
+    if (strcmp(text, "skip") == 0)
+    {
+        config->policy = OVERRUN_POLICY_SKIP;
+        return 0;
+    }
+    if (strcmp(text, "degrade") == 0)
+    {
+        config->policy = OVERRUN_POLICY_DEGRADE;
+        return 0;
+    }
+    if (strncmp(text, "catch-up", 8) == 0)
+    {
+        unsigned int max_catch_up = 1;
+        if (text[8] == ':')
+        {
+            char *end;
+            unsigned long value = strtoul(&text[9], &end, 10);
+            if (end == &text[9] || *end != '\0' || value == 0 || value > 1000)
+            {
+                return -1;
+            }
+            max_catch_up = (unsigned int)value;
+        }
+        else if (text[8] != '\0')
+        {
+            return -1;
+        }
+        config->policy       = OVERRUN_POLICY_CATCH_UP;
+        config->max_catch_up = max_catch_up;
+        return 0;
+    }
+    return -1;
+}
+
+static uint64_t timer_now_ns(const periodic_timer_t *timer)
+{
+    return timer->clock != NULL ? timer->clock->now_ns(timer->clock->ctx) : clock_now_ns();
+}
+
+void periodic_timer_start(periodic_timer_t *timer, uint64_t period_ns,
+                          const scheduler_config_t *config)
+{
+    periodic_timer_start_on(timer, period_ns, config, NULL);
+}
+
+void periodic_timer_start_on(periodic_timer_t *timer, uint64_t period_ns,
+                             const scheduler_config_t *config, const periodic_clock_t *clock)
+{
+    timer->clock          = clock;
+    timer->next_ns        = timer_now_ns(timer);
+    timer->period_ns      = period_ns > 0 ? period_ns : 1;
+    timer->config         = *config;
+    timer->catch_up_used  = 0;
+    timer->degrade_factor = 1;
+    timer->on_time_cycles = 0;
+    timer->armed          = false;
+}
+
+// Choose the next slot, applying the overrun policy. must_sleep is set when the
+// slot is still in the future and the caller must wait for it.
+static uint64_t timer_advance(periodic_timer_t *timer, bool *must_sleep)
+{
+    uint64_t skipped = timer->degrade_factor - 1;
+    timer->next_ns += timer->period_ns * timer->degrade_factor;
+
+    uint64_t now_ns = timer_now_ns(timer);
+    if (now_ns <= timer->next_ns)
+    {
+        // On time
+        timer->catch_up_used = 0;
+        if (timer->degrade_factor > 1 &&
+            ++timer->on_time_cycles >= SCHEDULER_DEGRADE_RECOVER_CYCLES)
+        {
+            timer->degrade_factor /= 2;
+            timer->on_time_cycles = 0;
+        }
+        *must_sleep = true;
+        return skipped;
+    }
+
+    // Overrun: the slot we should start now is already in the past
+    timer->on_time_cycles = 0;
+    if (timer->config.policy == OVERRUN_POLICY_CATCH_UP &&
+        timer->catch_up_used < timer->config.max_catch_up)
+    {
+        timer->catch_up_used++;
+        *must_sleep = false;
+        return skipped;
+    }
+    timer->catch_up_used = 0;
+
+    if (timer->config.policy == OVERRUN_POLICY_DEGRADE &&
+        timer->degrade_factor < SCHEDULER_MAX_DEGRADE)
+    {
+        timer->degrade_factor *= 2;
+    }
+
+    // Skip to the first slot that is still in the future
+    uint64_t missed = (now_ns - timer->next_ns) / timer->period_ns + 1;
+    timer->next_ns += missed * timer->period_ns;
+    *must_sleep = true;
+
+    return skipped + missed;
+}
+
+uint64_t periodic_timer_wait(periodic_timer_t *timer)
+{
+    bool must_sleep;
+    uint64_t skipped = timer_advance(timer, &must_sleep);
+    if (must_sleep && timer->clock != NULL)
+    {
+        timer->clock->sleep_until_ns(timer->clock->ctx, timer->next_ns);
+    }
+    else if (must_sleep)
+    {
+        sleep_until_ns(timer->next_ns, timer->config.spin_ns);
+    }
+    return skipped;
+}
+
+void plc_event_init(plc_event_t *event)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, PLC_CLOCK);
+    pthread_cond_init(&event->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&event->mutex, NULL);
+    event->posted = false;
+}
+
+void plc_event_post(plc_event_t *event)
+{
+    pthread_mutex_lock(&event->mutex);
+    event->posted = true;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+}
+
+// Wait until the event is posted or deadline_ns passes. Returns true and
+// consumes the post if it was posted.
+static bool plc_event_wait_until(plc_event_t *event, uint64_t deadline_ns)
+{
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(deadline_ns / 1000000000ull);
+    ts.tv_nsec = (long)(deadline_ns % 1000000000ull);
+
+    pthread_mutex_lock(&event->mutex);
+    while (!event->posted)
+    {
+        if (pthread_cond_timedwait(&event->cond, &event->mutex, &ts) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    bool posted   = event->posted;
+    event->posted = false;
+    pthread_mutex_unlock(&event->mutex);
+    return posted;
+}
+
+bool periodic_timer_wait_event(periodic_timer_t *timer, plc_event_t *event, uint64_t *skipped)
+{
+    if (!timer->armed)
+    {
+        timer->armed_skipped = timer_advance(timer, &timer->armed_sleep);
+        timer->armed         = true;
+    }
+
+    if (timer->armed_sleep)
+    {
+        uint64_t spin_ns = timer->config.spin_ns;
+        uint64_t wake_ns = timer->next_ns > spin_ns ? timer->next_ns - spin_ns : 0;
+        if (event != NULL && plc_event_wait_until(event, wake_ns))
+        {
+            return false;
+        }
+        sleep_until_ns(timer->next_ns, spin_ns);
+    }
+
+    timer->armed = false;
+    *skipped     = timer->armed_skipped;
+    return true;
+}
+
 void timespec_diff(struct timespec *a, struct timespec *b, struct timespec *result)
 {
     // Calculate the difference in seconds
@@ -86,6 +318,205 @@ void set_realtime_priority(void)
 #endif
 }
 
+#if HAS_REALTIME_FEATURES
+static int affinity_scan_cpu = -1;
+static cpu_set_t affinity_housekeeping;
+static bool affinity_has_housekeeping = false;
+
+// Affinity the scan thread ended up with, recorded by pin_scan_thread()
+static cpu_set_t scan_thread_affinity;
+static bool scan_thread_affinity_valid = false;
+static pthread_mutex_t affinity_mutex  = PTHREAD_MUTEX_INITIALIZER;
+
+static int parse_cpu_list(const char *text, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    const char *ptr = text;
+
+    while (*ptr != '\0')
+    {
+        char *end;
+        unsigned long first = strtoul(ptr, &end, 10);
+        if (end == ptr || first >= CPU_SETSIZE)
+        {
+            return -1;
+        }
+        unsigned long last = first;
+        ptr                = end;
+
+        if (*ptr == '-')
+        {
+            last = strtoul(ptr + 1, &end, 10);
+            if (end == ptr + 1 || last >= CPU_SETSIZE || last < first)
+            {
+                return -1;
+            }
+            ptr = end;
+        }
+
+        for (unsigned long cpu = first; cpu <= last; cpu++)
+        {
+            CPU_SET(cpu, set);
+        }
+
+        if (*ptr == ',')
+        {
+            ptr++;
+        }
+        else if (*ptr != '\0')
+        {
+            return -1;
+        }
+    }
+
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// Format a CPU set as a compact list, e.g. "0-2,5"
+static void format_cpu_list(const cpu_set_t *set, char *buffer, size_t buffer_size)
+{
+    size_t written = 0;
+    buffer[0]      = '\0';
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, set))
+        {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set))
+        {
+            last++;
+        }
+
+        int n = last > cpu ? snprintf(buffer + written, buffer_size - written, "%s%d-%d",
+                                      written ? "," : "", cpu, last)
+                           : snprintf(buffer + written, buffer_size - written, "%s%d",
+                                      written ? "," : "", cpu);
+        if (n < 0 || (size_t)n >= buffer_size - written)
+        {
+            return;
+        }
+        written += (size_t)n;
+        cpu = last;
+    }
+}
+#endif
+
+int affinity_set_scan_cpu(const char *text)
+{
+#if HAS_REALTIME_FEATURES
+    char *end;
+    unsigned long cpu = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || cpu >= CPU_SETSIZE)
+    {
+        return -1;
+    }
+    affinity_scan_cpu = (int)cpu;
+#else
+    (void)text;
+#endif
+    return 0;
+}
+
+int affinity_set_housekeeping_cpus(const char *text)
+{
+#if HAS_REALTIME_FEATURES
+    cpu_set_t set;
+    if (parse_cpu_list(text, &set) != 0)
+    {
+        return -1;
+    }
+    affinity_housekeeping     = set;
+    affinity_has_housekeeping = true;
+#else
+    (void)text;
+#endif
+    return 0;
+}
+
+void apply_housekeeping_affinity(void)
+{
+#if HAS_REALTIME_FEATURES
+    if (!affinity_has_housekeeping)
+    {
+        return;
+    }
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &affinity_housekeeping) != 0)
+    {
+        log_error("Failed to set housekeeping CPU affinity");
+    }
+#endif
+}
+
+void pin_scan_thread(void)
+{
+#if HAS_REALTIME_FEATURES
+    if (affinity_scan_cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(affinity_scan_cpu, &set);
+
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+        if (err != 0)
+        {
+            log_error("Failed to pin scan thread to CPU %d: %s", affinity_scan_cpu, strerror(err));
+        }
+        else
+        {
+            log_info("Scan thread pinned to CPU %d", affinity_scan_cpu);
+        }
+    }
+
+    pthread_mutex_lock(&affinity_mutex);
+    scan_thread_affinity_valid =
+        pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &scan_thread_affinity) == 0;
+    pthread_mutex_unlock(&affinity_mutex);
+#endif
+}
+
+int format_affinity_report(char *buffer, size_t buffer_size)
+{
+#if HAS_REALTIME_FEATURES
+    char scan_cpus[256]         = "";
+    char housekeeping_cpus[256] = "";
+    bool scan_valid;
+
+    pthread_mutex_lock(&affinity_mutex);
+    scan_valid = scan_thread_affinity_valid;
+    if (scan_valid)
+    {
+        format_cpu_list(&scan_thread_affinity, scan_cpus, sizeof(scan_cpus));
+    }
+    pthread_mutex_unlock(&affinity_mutex);
+
+    // Every non-scan thread inherits the housekeeping set, so the calling
+    // thread's mask is the actual one
+    cpu_set_t current;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &current) == 0)
+    {
+        format_cpu_list(&current, housekeeping_cpus, sizeof(housekeeping_cpus));
+    }
+
+    if (!scan_valid)
+    {
+        return snprintf(buffer, buffer_size,
+                        "AFFINITY:{\"scan_thread\":null,\"housekeeping\":\"%s\","
+                        "\"online_cpus\":%ld}\n",
+                        housekeeping_cpus, sysconf(_SC_NPROCESSORS_ONLN));
+    }
+    return snprintf(buffer, buffer_size,
+                    "AFFINITY:{\"scan_thread\":\"%s\",\"housekeeping\":\"%s\","
+                    "\"online_cpus\":%ld}\n",
+                    scan_cpus, housekeeping_cpus, sysconf(_SC_NPROCESSORS_ONLN));
+#else
+    return snprintf(buffer, buffer_size, "AFFINITY:{\"scan_thread\":null,\"housekeeping\":null}\n");
+#endif
+}
+
 // Lock all memory pages to prevent page faults during PLC execution
 void lock_memory(void)
 {
@@ -104,6 +535,136 @@ void lock_memory(void)
 #endif
 }
 
+// Stack touched by prefault_scan_thread(), at most half the thread's stack
+#define PREFAULT_STACK_BYTES (256u * 1024u)
+
+static size_t prefault_heap_bytes = 0;
+
+static unsigned long fault_report_scans = FAULT_REPORT_DEFAULT_SCANS;
+static unsigned long fault_report_left  = 0;
+#if HAS_REALTIME_FEATURES
+static struct rusage fault_report_thread;
+static struct rusage fault_report_process;
+#endif
+
+int prefault_set_heap_kb(unsigned long kb)
+{
+    if (kb > PREFAULT_HEAP_MAX_KB)
+    {
+        return -1;
+    }
+    prefault_heap_bytes = (size_t)kb * 1024u;
+    return 0;
+}
+
+#if HAS_REALTIME_FEATURES
+// Not inlined, so the frame is released again before the scan loop
+static __attribute__((noinline)) void touch_stack(size_t bytes, size_t page)
+{
+    volatile unsigned char *stack = alloca(bytes);
+    for (size_t i = 0; i < bytes; i += page)
+    {
+        stack[i] = 0;
+    }
+}
+
+static void touch_heap(size_t bytes, size_t page)
+{
+    // Freed memory stays in the arena and large blocks come from it instead
+    // of fresh mappings, so the touched pages are reused by later allocations
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    volatile unsigned char *heap = malloc(bytes);
+    if (heap == NULL)
+    {
+        log_error("Failed to prefault %zu KiB of heap", bytes / 1024);
+        return;
+    }
+    for (size_t i = 0; i < bytes; i += page)
+    {
+        heap[i] = 0;
+    }
+    free((void *)heap);
+}
+#endif
+
+void prefault_scan_thread(void)
+{
+#if HAS_REALTIME_FEATURES
+    size_t page        = (size_t)sysconf(_SC_PAGESIZE);
+    size_t stack_bytes = PREFAULT_STACK_BYTES;
+    pthread_attr_t attr;
+    void *stack_addr;
+    size_t stack_size;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0)
+    {
+        if (pthread_attr_getstack(&attr, &stack_addr, &stack_size) == 0 &&
+            stack_size / 2 < stack_bytes)
+        {
+            stack_bytes = stack_size / 2;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    struct rusage before, after;
+    getrusage(RUSAGE_THREAD, &before);
+    touch_stack(stack_bytes, page);
+    if (prefault_heap_bytes > 0)
+    {
+        touch_heap(prefault_heap_bytes, page);
+    }
+    getrusage(RUSAGE_THREAD, &after);
+
+    log_info("Scan thread prefaulted %zu KiB of stack and %zu KiB of heap (%ld page faults)",
+             stack_bytes / 1024, prefault_heap_bytes / 1024,
+             (after.ru_minflt - before.ru_minflt) + (after.ru_majflt - before.ru_majflt));
+#endif
+}
+
+int fault_report_set_scans(unsigned long scans)
+{
+    if (scans > FAULT_REPORT_MAX_SCANS)
+    {
+        return -1;
+    }
+    fault_report_scans = scans;
+    return 0;
+}
+
+void fault_report_start(void)
+{
+#if HAS_REALTIME_FEATURES
+    fault_report_left = fault_report_scans;
+    if (fault_report_left > 0)
+    {
+        getrusage(RUSAGE_THREAD, &fault_report_thread);
+        getrusage(RUSAGE_SELF, &fault_report_process);
+    }
+#endif
+}
+
+void fault_report_scan(void)
+{
+    // One decrement per scan until the report is out
+    if (fault_report_left == 0 || --fault_report_left > 0)
+    {
+        return;
+    }
+
+#if HAS_REALTIME_FEATURES
+    struct rusage thread, process;
+    getrusage(RUSAGE_THREAD, &thread);
+    getrusage(RUSAGE_SELF, &process);
+    log_info("Page faults in the first %lu scans: scan thread %ld minor, %ld major; "
+             "process %ld minor, %ld major",
+             fault_report_scans, thread.ru_minflt - fault_report_thread.ru_minflt,
+             thread.ru_majflt - fault_report_thread.ru_majflt,
+             process.ru_minflt - fault_report_process.ru_minflt,
+             process.ru_majflt - fault_report_process.ru_majflt);
+#endif
+}
+
 size_t parse_hex_string(const char *hex_string, uint8_t *data)
 {
     size_t count    = 0;
@@ -2,10 +2,12 @@
 #define UTILS_H
 
 #include <dlfcn.h>
+#include <pthread.h>
 #include <sched.h>
 #include <sys/mman.h>
-#include <time.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 #include "log.h"
 
@@ -13,6 +15,147 @@ extern unsigned long long *ext_common_ticktime__;
 extern unsigned long tick__;
 extern char *ext_plc_program_md5;
 
+/**
+ * @brief Clock used for scan scheduling and timing statistics
+ *
+ * clock_nanosleep() cannot sleep on CLOCK_MONOTONIC_RAW, so the scheduler,
+ * the scan statistics and the profiler all measure against CLOCK_MONOTONIC to
+ * stay in the same clock domain.
+ */
+#define PLC_CLOCK CLOCK_MONOTONIC
+
+/**
+ * @brief What the scan scheduler does when a cycle overruns its slot
+ */
+typedef enum
+{
+    OVERRUN_POLICY_SKIP,     // drop the missed slots, start at the next one
+    OVERRUN_POLICY_CATCH_UP, // run up to max_catch_up late cycles back-to-back, then skip
+    OVERRUN_POLICY_DEGRADE   // skip, and double the period until cycles fit again
+} overrun_policy_t;
+
+typedef struct
+{
+    overrun_policy_t policy;
+    unsigned int max_catch_up; // OVERRUN_POLICY_CATCH_UP only
+    uint64_t spin_ns;          // busy-wait this long before each deadline (0 = off)
+} scheduler_config_t;
+
+/**
+ * @brief Scheduler settings for the PLC scan thread, set from the command line
+ */
+extern scheduler_config_t scheduler_config;
+
+/**
+ * @brief Time source of a periodic timer, for running the scheduler on a
+ *        simulated clock
+ *
+ * sleep_until_ns() returns once now_ns() has reached deadline_ns.
+ */
+typedef struct
+{
+    uint64_t (*now_ns)(void *ctx);
+    void (*sleep_until_ns)(void *ctx, uint64_t deadline_ns);
+    void *ctx;
+} periodic_clock_t;
+
+/**
+ * @brief Periodic absolute-time scheduler state
+ */
+typedef struct
+{
+    const periodic_clock_t *clock; // NULL: PLC_CLOCK
+    uint64_t next_ns;   // absolute start of the next slot on the timer's clock
+    uint64_t period_ns; // base period
+    scheduler_config_t config;
+    unsigned int catch_up_used;
+    unsigned int degrade_factor; // current period multiplier (DEGRADE only)
+    unsigned int on_time_cycles;
+    bool armed;             // next slot chosen, waiting for it (wait_event only)
+    bool armed_sleep;       // the armed slot is in the future
+    uint64_t armed_skipped; // slots passed before the armed one
+} periodic_timer_t;
+
+/**
+ * @brief Wakes a thread waiting for its next slot early
+ *
+ * Posts are not counted: any number of posts before the waiter wakes count
+ * as one.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond; // waits on PLC_CLOCK
+    bool posted;
+} plc_event_t;
+
+/**
+ * @brief Parse an overrun policy: "skip", "catch-up", "catch-up:N" or "degrade"
+ *
+ * @param text The policy text
+ * @param config Updated with the parsed policy
+ * @return 0 on success, -1 if the text is not a valid policy
+ */
+int scheduler_parse_overrun_policy(const char *text, scheduler_config_t *config);
+
+/**
+ * @brief Start a periodic timer with its first slot at the current time
+ *
+ * @param timer The timer to initialize
+ * @param period_ns The period in nanoseconds
+ * @param config Overrun policy and spin settings (copied)
+ */
+void periodic_timer_start(periodic_timer_t *timer, uint64_t period_ns,
+                          const scheduler_config_t *config);
+
+/**
+ * @brief Start a periodic timer on another time source
+ *
+ * Like periodic_timer_start(), with slots measured and waited for on clock
+ * instead of PLC_CLOCK. Wait with periodic_timer_wait(): events of
+ * periodic_timer_wait_event() are only waited for on PLC_CLOCK.
+ *
+ * @param clock The time source (not copied), NULL for PLC_CLOCK
+ */
+void periodic_timer_start_on(periodic_timer_t *timer, uint64_t period_ns,
+                             const scheduler_config_t *config, const periodic_clock_t *clock);
+
+/**
+ * @brief Wait for the next slot, applying the overrun policy
+ *
+ * Deadlines are absolute multiples of the period from the start time, so
+ * they never drift with the time spent running a cycle.
+ *
+ * @param timer The timer
+ * @return The number of slots that passed without a cycle (skipped or
+ *         stretched by degrade), 0 when on time
+ */
+uint64_t periodic_timer_wait(periodic_timer_t *timer);
+
+/**
+ * @brief Initialize an event, not posted
+ */
+void plc_event_init(plc_event_t *event);
+
+/**
+ * @brief Post an event, waking its waiter. Safe from any thread.
+ */
+void plc_event_post(plc_event_t *event);
+
+/**
+ * @brief Wait for the next slot like periodic_timer_wait(), or for an event
+ *
+ * When the event is posted before the slot starts, returns false at once and
+ * keeps the slot: the next call waits for the same slot again. The spin
+ * phase before the deadline (spin_ns) is not interrupted by events.
+ *
+ * @param timer The timer
+ * @param event The event to wait for, NULL to wait for the slot only
+ * @param skipped Receives periodic_timer_wait()'s result when true is returned
+ * @return true when the slot started, false when woken by the event
+ */
+bool periodic_timer_wait_event(periodic_timer_t *timer, plc_event_t *event, uint64_t *skipped);
+
 
 /**
  * @brief Normalize a timespec structure
@@ -43,6 +186,47 @@ void timespec_diff(struct timespec *a, struct timespec *b,
  */
 void set_realtime_priority(void);
 
+/**
+ * @brief Set the CPU the scan thread pins itself to
+ *
+ * @param text A CPU number, e.g. "3"
+ * @return 0 on success, -1 if the text is not a valid CPU number
+ */
+int affinity_set_scan_cpu(const char *text);
+
+/**
+ * @brief Set the CPUs for every other runtime thread (unix socket, logging,
+ * watchdog, plugins)
+ *
+ * @param text A CPU list, e.g. "0-2" or "0,1,4-5"
+ * @return 0 on success, -1 if the list is not valid
+ */
+int affinity_set_housekeeping_cpus(const char *text);
+
+/**
+ * @brief Apply the housekeeping CPU set to the calling thread
+ *
+ * Call from main() before any thread is created: new threads inherit the
+ * affinity of their creator, so every runtime and plugin thread lands on the
+ * housekeeping set unless it pins itself elsewhere.
+ */
+void apply_housekeeping_affinity(void);
+
+/**
+ * @brief Pin the calling thread (the scan thread) to the configured scan CPU
+ * and remember its resulting affinity for reporting
+ */
+void pin_scan_thread(void);
+
+/**
+ * @brief Format the actual scan thread and housekeeping affinity as JSON
+ *
+ * @param buffer The output buffer
+ * @param buffer_size The size of the output buffer
+ * @return The number of characters written
+ */
+int format_affinity_report(char *buffer, size_t buffer_size);
+
 /**
  * @brief Lock all current and future memory pages to prevent page faults
  * 
@@ -51,6 +235,49 @@ void set_realtime_priority(void);
  */
 void lock_memory(void);
 
+// Largest heap prefault, and the longest and default startup page fault report
+#define PREFAULT_HEAP_MAX_KB (1024 * 1024)
+#define FAULT_REPORT_MAX_SCANS 1000000
+#define FAULT_REPORT_DEFAULT_SCANS 1000
+
+/**
+ * @brief Set how much heap prefault_scan_thread() touches
+ *
+ * @param kb KiB of heap, 0 leaves the allocator as it is
+ * @return 0 on success, -1 above PREFAULT_HEAP_MAX_KB
+ */
+int prefault_set_heap_kb(unsigned long kb);
+
+/**
+ * @brief Touch the scan thread's stack and heap before the scan loop
+ *
+ * Call on the scan thread after lock_memory(). The stack pages the scan may
+ * reach are written once, so they are mapped (and locked) before the first
+ * cycle instead of faulting in during it. With a heap size set, the
+ * allocator is told to keep freed memory and to serve large blocks from the
+ * heap, and that much of the scan thread's arena is touched and released.
+ */
+void prefault_scan_thread(void);
+
+/**
+ * @brief Set after how many scans the page fault report is logged
+ *
+ * @param scans Scans counted, 0 disables the report
+ * @return 0 on success, -1 above FAULT_REPORT_MAX_SCANS
+ */
+int fault_report_set_scans(unsigned long scans);
+
+/**
+ * @brief Start counting page faults, on the scan thread before its first cycle
+ */
+void fault_report_start(void);
+
+/**
+ * @brief Count one scan; logs the minor and major faults of the scan thread
+ * and of the process once the configured scans have run
+ */
+void fault_report_scan(void);
+
 /**
  * @brief Parse a hex string into a byte array
  *
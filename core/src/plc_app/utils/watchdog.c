@@ -1,43 +1,219 @@
+#include <dirent.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "../plc_state_manager.h"
+#include "../safe_state.h"
 #include "log.h"
 #include "utils.h"
 #include "watchdog.h"
 
-atomic_long plc_heartbeat;
+#define NS_PER_MS 1000000ull
+
+// Shortest poll interval, a quarter of the minimum timeout, and the interval
+// while the PLC is not running
+#define WATCHDOG_MIN_POLL_NS (WATCHDOG_MIN_TIMEOUT_MS * NS_PER_MS / 4)
+#define WATCHDOG_IDLE_POLL_NS (100 * NS_PER_MS)
+
+atomic_ulong plc_heartbeat;
 extern PLCState plc_state;
 
+static unsigned long watchdog_cycles     = 0; // 0 = WATCHDOG_DEFAULT_TIMEOUT_MS
+static watchdog_action_t watchdog_action = WATCHDOG_ACTION_EXIT;
+static char **saved_argv                 = NULL;
+
+// Set by the scan thread on each start, read by the watchdog thread
+static atomic_ullong armed_timeout_ns;
+static atomic_uint arm_generation;
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(PLC_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static const char *action_name(watchdog_action_t action)
+{
+    switch (action)
+    {
+    case WATCHDOG_ACTION_SAFE_STATE:
+        return "safe-state";
+    case WATCHDOG_ACTION_RESTART:
+        return "restart";
+    default:
+        return "exit";
+    }
+}
+
+int watchdog_set_cycles(unsigned long cycles)
+{
+    if (cycles < 1 || cycles > WATCHDOG_MAX_CYCLES)
+    {
+        return -1;
+    }
+    watchdog_cycles = cycles;
+    return 0;
+}
+
+int watchdog_set_action(const char *name)
+{
+    if (strcmp(name, "exit") == 0)
+    {
+        watchdog_action = WATCHDOG_ACTION_EXIT;
+    }
+    else if (strcmp(name, "safe-state") == 0)
+    {
+        watchdog_action = WATCHDOG_ACTION_SAFE_STATE;
+    }
+    else if (strcmp(name, "restart") == 0)
+    {
+        watchdog_action = WATCHDOG_ACTION_RESTART;
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+void watchdog_set_argv(char *argv[])
+{
+    saved_argv = argv;
+}
+
+void watchdog_arm(uint64_t cycle_ns)
+{
+    uint64_t timeout_ns = (uint64_t)WATCHDOG_DEFAULT_TIMEOUT_MS * NS_PER_MS;
+    if (watchdog_cycles > 0)
+    {
+        timeout_ns = cycle_ns * watchdog_cycles;
+        if (timeout_ns < WATCHDOG_MIN_TIMEOUT_MS * NS_PER_MS)
+        {
+            timeout_ns = WATCHDOG_MIN_TIMEOUT_MS * NS_PER_MS;
+        }
+    }
+
+    atomic_store(&armed_timeout_ns, timeout_ns);
+    atomic_fetch_add(&arm_generation, 1);
+}
+
+// Re-execute the runtime. The scan thread cannot be joined while it is stuck,
+// so the whole process image is replaced; descriptors are marked close-on-exec
+// first so the listening sockets are free for the new image to bind.
+static void restart_runtime(void)
+{
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir != NULL)
+    {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            int fd = atoi(entry->d_name);
+            if (fd > STDERR_FILENO && fd != dirfd(dir))
+            {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+        }
+        closedir(dir);
+    }
+    else
+    {
+        long max_fd = sysconf(_SC_OPEN_MAX);
+        for (long fd = STDERR_FILENO + 1; fd < max_fd; fd++)
+        {
+            fcntl((int)fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+
+    if (saved_argv != NULL)
+    {
+        execv("/proc/self/exe", saved_argv);
+    }
+    fprintf(stderr, "[Watchdog] Restart failed, exiting.\n");
+    exit(EXIT_FAILURE);
+}
+
+static void watchdog_trip(uint64_t stalled_ns)
+{
+    // Use stderr to ensure visibility and avoid lockups in log system
+    fprintf(stderr, "[Watchdog] No heartbeat for %llu ms! PLC unresponsive, action: %s.\n",
+            (unsigned long long)(stalled_ns / NS_PER_MS), action_name(watchdog_action));
+
+    switch (watchdog_action)
+    {
+    case WATCHDOG_ACTION_SAFE_STATE:
+        safe_state_enter("Watchdog", false);
+        break;
+    case WATCHDOG_ACTION_RESTART:
+        restart_runtime();
+        break;
+    default:
+        exit(EXIT_FAILURE);
+    }
+}
+
 void *watchdog_thread(void *arg)
 {
     (void)arg;
-    long last = atomic_load(&plc_heartbeat);
+    bool watching        = false;
+    unsigned generation  = 0;
+    unsigned long last   = 0;
+    uint64_t last_change = 0;
+    uint64_t allowed_ns  = 0;
 
     while (1)
     {
-        sleep(2); // Watch every 2 seconds
+        uint64_t timeout_ns = atomic_load(&armed_timeout_ns);
+        uint64_t poll_ns    = watching ? timeout_ns / 4 : WATCHDOG_IDLE_POLL_NS;
+        if (poll_ns < WATCHDOG_MIN_POLL_NS)
+        {
+            poll_ns = WATCHDOG_MIN_POLL_NS;
+        }
+        struct timespec interval = {.tv_sec  = (time_t)(poll_ns / 1000000000ull),
+                                    .tv_nsec = (long)(poll_ns % 1000000000ull)};
+        clock_nanosleep(PLC_CLOCK, 0, &interval, NULL);
 
-        if (plc_get_state() != PLC_STATE_RUNNING)
+        if (timeout_ns == 0 || plc_get_state() != PLC_STATE_RUNNING)
         {
-            continue; // Only monitor when PLC is running
+            watching = false; // Only monitor when PLC is running
+            continue;
         }
 
-        long now = atomic_load(&plc_heartbeat);
-        if (now == last)
+        uint64_t now       = monotonic_ns();
+        unsigned long beat = atomic_load_explicit(&plc_heartbeat, memory_order_acquire);
+        unsigned armed     = atomic_load(&arm_generation);
+
+        // (Re)started, give the first scan time to load and run
+        if (!watching || armed != generation)
         {
-            fprintf(
-                stderr,
-                "[Watchdog] No heartbeat! PLC unresponsive.\n"); // Use stderr to ensure visibility
-                                                                 // and avoid lockups in log system
-            exit(EXIT_FAILURE);
+            watching    = true;
+            generation  = armed;
+            last        = beat;
+            last_change = now;
+            allowed_ns  = timeout_ns > WATCHDOG_STARTUP_GRACE_MS * NS_PER_MS
+                              ? timeout_ns
+                              : WATCHDOG_STARTUP_GRACE_MS * NS_PER_MS;
+            continue;
         }
 
-        last = now;
+        if (beat != last)
+        {
+            last        = beat;
+            last_change = now;
+            allowed_ns  = timeout_ns;
+        }
+        else if (now - last_change > allowed_ns)
+        {
+            watchdog_trip(now - last_change);
+            watching = false;
+        }
     }
 
     return NULL;
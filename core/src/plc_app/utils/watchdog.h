@@ -1,6 +1,63 @@
 #ifndef WATCHDOG_H
 #define WATCHDOG_H
 
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Timeout when --watchdog-cycles is not given, and the floor for short cycles
+#define WATCHDOG_DEFAULT_TIMEOUT_MS 2000
+#define WATCHDOG_MIN_TIMEOUT_MS 10
+#define WATCHDOG_MAX_CYCLES 100000
+
+// Time allowed for the first scan after the PLC starts
+#define WATCHDOG_STARTUP_GRACE_MS 2000
+
+typedef enum
+{
+    WATCHDOG_ACTION_EXIT = 0,   // Terminate the runtime
+    WATCHDOG_ACTION_SAFE_STATE, // Apply the safe outputs and put the PLC in ERROR
+    WATCHDOG_ACTION_RESTART     // Re-execute the runtime with the same arguments
+} watchdog_action_t;
+
+// Completed scans, written only by the scan thread
+extern atomic_ulong plc_heartbeat;
+
+/**
+ * @brief Record a completed scan, called by the scan thread once per cycle
+ *
+ * A relaxed increment with a release store since the scan thread is the only
+ * writer, no syscall and no locked instruction on the scan path.
+ */
+static inline void watchdog_heartbeat(void)
+{
+    unsigned long beats = atomic_load_explicit(&plc_heartbeat, memory_order_relaxed);
+    atomic_store_explicit(&plc_heartbeat, beats + 1, memory_order_release);
+}
+
+/**
+ * @brief Set the timeout in scan cycles (--watchdog-cycles)
+ * @return int 0 on success, -1 if outside 1 to WATCHDOG_MAX_CYCLES
+ */
+int watchdog_set_cycles(unsigned long cycles);
+
+/**
+ * @brief Set the action taken on a missed heartbeat (--watchdog-action)
+ * @param name "exit", "safe-state" or "restart"
+ * @return int 0 on success, -1 if the name is unknown
+ */
+int watchdog_set_action(const char *name);
+
+/**
+ * @brief Keep the command line for WATCHDOG_ACTION_RESTART
+ */
+void watchdog_set_argv(char *argv[]);
+
+/**
+ * @brief Start watching, called by the scan thread when its timer starts
+ * @param cycle_ns Scan cycle time, the timeout is a multiple of it
+ */
+void watchdog_arm(uint64_t cycle_ns);
+
 /**
  * @brief Initialize the watchdog
  * @return int 0 on success, -1 on failure
@@ -10,6 +10,42 @@ PYTHON_INCLUDE_PATH="core/src/plc_app/include"
 PYTHON_LOADER_SRC="core/src/plc_app/python_loader.c"
 
 FLAGS="-w -O3 -fPIC"
+LINK_FLAGS=""
+
+# Build profile, OPENPLC_BUILD_PROFILE:
+#   default    -O3 only
+#   lto        link-time optimization, only the symbols in EXPORT_MAP exported
+#   pgo-train  lto's exports, instrumented to write a profile to PGO_PATH when
+#              the runtime unloads the program
+#   pgo        lto using the profile of a pgo-train run of the same program
+BUILD_PROFILE="${OPENPLC_BUILD_PROFILE:-default}"
+EXPORT_MAP="scripts/libplc.map"
+PGO_PATH="$(pwd)/$BUILD_PATH/pgo"
+
+case "$BUILD_PROFILE" in
+    default) ;;
+    lto)
+        FLAGS="$FLAGS -flto=auto -fno-semantic-interposition"
+        LINK_FLAGS="-Wl,--version-script=$EXPORT_MAP"
+        ;;
+    pgo-train)
+        # Atomic counters, the program may run on several task threads
+        FLAGS="$FLAGS -fno-semantic-interposition -fprofile-generate=$PGO_PATH"
+        FLAGS="$FLAGS -fprofile-update=atomic"
+        LINK_FLAGS="-Wl,--version-script=$EXPORT_MAP"
+        ;;
+    pgo)
+        # POUs changed since the training run are optimized as without a profile
+        FLAGS="$FLAGS -flto=auto -fno-semantic-interposition -fprofile-use=$PGO_PATH"
+        FLAGS="$FLAGS -fprofile-partial-training -Wno-error=coverage-mismatch"
+        LINK_FLAGS="-Wl,--version-script=$EXPORT_MAP"
+        ;;
+    *)
+        echo "[ERROR] Unknown OPENPLC_BUILD_PROFILE: $BUILD_PROFILE" >&2
+        echo "  Use default, lto, pgo-train or pgo" >&2
+        exit 1
+        ;;
+esac
 
 check_required_files() {
     local missing_files=()
@@ -37,8 +73,26 @@ check_required_files() {
     fi
 }
 
+# Target CPU, OPENPLC_BUILD_CPU: "native" for the CPU of this machine, or any
+# -march value (x86-64-v3, armv8-a+simd, ...). Unset, the program is built for
+# the compiler's generic target and runs on any CPU of the architecture.
+BUILD_CPU="${OPENPLC_BUILD_CPU:-}"
+if [ -n "$BUILD_CPU" ]; then
+    FLAGS="$FLAGS -march=$BUILD_CPU"
+fi
+
 check_required_files
 
+if [ "$BUILD_PROFILE" != "default" ]; then
+    echo "[INFO] Build profile: $BUILD_PROFILE"
+fi
+if [ -n "$BUILD_CPU" ]; then
+    echo "[INFO] Target CPU: $BUILD_CPU"
+fi
+if [ "$BUILD_PROFILE" = "pgo" ] && ! ls "$PGO_PATH"/*.gcda > /dev/null 2>&1; then
+    echo "[WARNING] No profile in $PGO_PATH, run a pgo-train build of the program first"
+fi
+
 # Ensure build directory exists
 mkdir -p "$BUILD_PATH"
 if [ ! -d "$BUILD_PATH" ]; then
@@ -46,22 +100,115 @@ if [ ! -d "$BUILD_PATH" ]; then
     exit 1
 fi
 
+# Each translation unit is compiled as its own job, up to JOBS at a time
+# (OPENPLC_BUILD_JOBS=1 compiles them one after the other). Objects are kept in
+# CACHE_PATH by a hash of the compiler, the flags and the preprocessed source,
+# so units that did not change since an earlier build are not recompiled.
+# OPENPLC_BUILD_CACHE= (empty) turns the cache off. The pgo profile is not
+# cached, its objects also depend on the profile data.
+JOBS="${OPENPLC_BUILD_JOBS:-$(nproc 2>/dev/null || echo 1)}"
+CACHE_PATH="${OPENPLC_BUILD_CACHE-$BUILD_PATH/cache}"
+if [ "$BUILD_PROFILE" = "pgo" ]; then
+    CACHE_PATH=""
+fi
+CACHE_KEEP=64
+FAILED_FILE="$BUILD_PATH/.compile_failed"
+
+if [ -n "$CACHE_PATH" ]; then
+    mkdir -p "$CACHE_PATH"
+    COMPILER_ID="$(gcc -dumpfullversion -dumpmachine 2>/dev/null | tr '\n' ' ')"
+    if [ "$BUILD_CPU" = "native" ]; then
+        # What native resolves to, a cache moved to another machine stays valid
+        NATIVE_CPU="$(gcc -march=native -Q --help=target 2>/dev/null | grep -E '^ +-march=' || true)"
+        COMPILER_ID="$COMPILER_ID $NATIVE_CPU"
+    fi
+fi
+rm -f "$FAILED_FILE"
+
+# compile_unit <compiler> <source> <object> [compiler args...]
+# Runs in the background, so failures are returned explicitly instead of
+# relying on set -e.
+compile_unit() {
+    local compiler="$1" src="$2" obj="$3"
+    shift 3
+    local name key
+    name="$(basename "$src")"
+
+    if [ -n "$CACHE_PATH" ] &&
+        key="$({ echo "$COMPILER_ID $compiler $FLAGS $*"; "$compiler" $FLAGS "$@" -E "$src"; } |
+            sha256sum)"; then
+        key="${key%% *}"
+        if [ -f "$CACHE_PATH/$key.o" ]; then
+            echo "[INFO] Compiling $name... (cached)"
+            cp "$CACHE_PATH/$key.o" "$obj" || return 1
+            touch "$CACHE_PATH/$key.o"
+            return 0
+        fi
+    else
+        key=""
+    fi
+
+    echo "[INFO] Compiling $name..."
+    "$compiler" $FLAGS "$@" -c "$src" -o "$obj" || return 1
+
+    if [ -n "$key" ]; then
+        # Copy then rename, a build running alongside never sees a partial object
+        cp "$obj" "$CACHE_PATH/$key.o.$$" && mv "$CACHE_PATH/$key.o.$$" "$CACHE_PATH/$key.o"
+    fi
+    return 0
+}
+
+run_job() {
+    local src="$2"
+    if [ "$JOBS" -le 1 ]; then
+        compile_unit "$@" || echo "$src" >> "$FAILED_FILE"
+        return 0
+    fi
+    while [ "$(jobs -rp | wc -l)" -ge "$JOBS" ]; do
+        wait -n || true
+    done
+    { compile_unit "$@" || echo "$src" >> "$FAILED_FILE"; } &
+}
+
+# Res0.c plus the task table the runtime needs to run each task on its own thread
+if python3 scripts/generate-tasks.py "$SRC_PATH/Res0.c" "$BUILD_PATH/Res0_tasks.c"; then
+    RES0_SRC="$BUILD_PATH/Res0_tasks.c"
+else
+    RES0_SRC="$SRC_PATH/Res0.c"
+fi
+
+# debug.c plus the variable names an online change matches variables by
+if python3 scripts/generate-var-names.py "$SRC_PATH/debug.c" "$BUILD_PATH/debug_names.c"; then
+    DEBUG_SRC="$BUILD_PATH/debug_names.c"
+else
+    DEBUG_SRC="$SRC_PATH/debug.c"
+fi
+
 # Compile objects into build/
-echo "[INFO] Compiling Config0.c..."
-gcc $FLAGS -I "$LIB_PATH" -I "$PYTHON_INCLUDE_PATH" -include iec_python.h -c "$SRC_PATH/Config0.c" -o "$BUILD_PATH/Config0.o"
-echo "[INFO] Compiling Res0.c..."
-gcc $FLAGS -I "$LIB_PATH" -I "$PYTHON_INCLUDE_PATH" -include iec_python.h -c "$SRC_PATH/Res0.c" -o "$BUILD_PATH/Res0.o"
-echo "[INFO] Compiling debug.c..."
-gcc $FLAGS -I "$LIB_PATH" -c "$SRC_PATH/debug.c" -o "$BUILD_PATH/debug.o"
-echo "[INFO] Compiling glueVars.c..."
-gcc $FLAGS -I "$LIB_PATH" -DOPENPLC_V4 -c "$SRC_PATH/glueVars.c" -o "$BUILD_PATH/glueVars.o"
-echo "[INFO] Compiling c_blocks_code.cpp..."
-g++ $FLAGS -I "$LIB_PATH" -c "$SRC_PATH/c_blocks_code.cpp" -o "$BUILD_PATH/c_blocks_code.o"
-echo "[INFO] Compiling python_loader.c..."
-gcc $FLAGS -I "core/src/plc_app" -c "$PYTHON_LOADER_SRC" -o "$BUILD_PATH/python_loader.o"
+run_job gcc "$SRC_PATH/Config0.c" "$BUILD_PATH/Config0.o" \
+    -I "$LIB_PATH" -I "$PYTHON_INCLUDE_PATH" -include iec_python.h
+run_job gcc "$RES0_SRC" "$BUILD_PATH/Res0.o" \
+    -I "$SRC_PATH" -I "$LIB_PATH" -I "$PYTHON_INCLUDE_PATH" -include iec_python.h
+run_job gcc "$DEBUG_SRC" "$BUILD_PATH/debug.o" -I "$SRC_PATH" -I "$LIB_PATH"
+run_job gcc "$SRC_PATH/glueVars.c" "$BUILD_PATH/glueVars.o" -I "$LIB_PATH" -DOPENPLC_V4
+run_job g++ "$SRC_PATH/c_blocks_code.cpp" "$BUILD_PATH/c_blocks_code.o" -I "$LIB_PATH"
+run_job gcc "$PYTHON_LOADER_SRC" "$BUILD_PATH/python_loader.o" -I "core/src/plc_app"
+wait
+
+if [ -f "$FAILED_FILE" ]; then
+    echo "[ERROR] Compilation failed:" >&2
+    sed 's/^/  /' "$FAILED_FILE" >&2
+    rm -f "$FAILED_FILE"
+    exit 1
+fi
+
+# Keep the most recently used objects only
+if [ -n "$CACHE_PATH" ]; then
+    ls -1t "$CACHE_PATH"/*.o 2>/dev/null | tail -n +$((CACHE_KEEP + 1)) | xargs -r rm -f || true
+fi
 
 # Link shared library into build/
 echo "[INFO] Linking shared library..."
 g++ $FLAGS -shared -o "$BUILD_PATH/new_libplc.so" "$BUILD_PATH/Config0.o" \
     "$BUILD_PATH/Res0.o" "$BUILD_PATH/debug.o" "$BUILD_PATH/glueVars.o" \
-    "$BUILD_PATH/c_blocks_code.o" "$BUILD_PATH/python_loader.o" -lpthread -lrt
+    "$BUILD_PATH/c_blocks_code.o" "$BUILD_PATH/python_loader.o" $LINK_FLAGS -lpthread -lrt
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Generate the task table of a PLC program from its Res0.c.
+
+The generated resource runs every task from one function, called once per
+common tick:
+
+    void RES0_run__(unsigned long tick) {
+      TASK0 = !(tick % 1);
+      if (TASK0) {
+        PROGRAM0_body__(&INSTANCE0);
+      }
+      ...
+    }
+
+The output file includes Res0.c and adds one function per periodic task plus
+a table the runtime uses to run each task on its own thread (--multi-task):
+
+    const plc_task_info_t plc_tasks[];
+    const unsigned int plc_task_count;
+
+Usage: generate-tasks.py <Res0.c> <output.c>
+
+Exits with status 1, writing nothing, if the resource has a task the table
+cannot describe (e.g. a task triggered by a variable). The program is then
+built from Res0.c alone and always runs as a single task.
+"""
+
+import re
+import sys
+
+RUN_FUNCTION = re.compile(r"void\s+(\w+)_run__\s*\(\s*unsigned\s+long\s+tick\s*\)\s*\{")
+PERIODIC_TASK = re.compile(r"(\w+)\s*=\s*!\s*\(\s*tick\s*%\s*(\d+)\s*\)\s*;")
+TASK_BLOCK = re.compile(r"if\s*\(\s*(\w+)\s*\)\s*\{")
+
+
+def matching_brace(text, start):
+    """Index just past the brace closing the one at text[start]."""
+    depth = 0
+    for i in range(start, len(text)):
+        if text[i] == "{":
+            depth += 1
+        elif text[i] == "}":
+            depth -= 1
+            if depth == 0:
+                return i + 1
+    raise ValueError("unbalanced braces")
+
+
+def parse_tasks(source):
+    """Return [(name, interval, body)] in the order the resource runs them."""
+    match = RUN_FUNCTION.search(source)
+    if match is None:
+        raise ValueError("no resource run function")
+    end = matching_brace(source, match.end() - 1)
+    body = source[match.end() : end - 1]
+
+    intervals = {}
+    tasks = []
+    pos = 0
+    while True:
+        rest = body[pos:].lstrip()
+        if not rest:
+            break
+        pos = len(body) - len(rest)
+
+        periodic = PERIODIC_TASK.match(rest)
+        if periodic:
+            intervals[periodic.group(1)] = int(periodic.group(2))
+            pos += periodic.end()
+            continue
+
+        block = TASK_BLOCK.match(rest)
+        if block and block.group(1) in intervals:
+            block_end = matching_brace(rest, block.end() - 1)
+            tasks.append(
+                (block.group(1), intervals[block.group(1)], rest[block.end() : block_end - 1])
+            )
+            pos += block_end
+            continue
+
+        raise ValueError(f"unsupported statement: {rest.splitlines()[0].strip()}")
+
+    if not tasks or any(interval == 0 for _, interval, _ in tasks):
+        raise ValueError("no periodic tasks")
+    return tasks
+
+
+def generate(tasks):
+    lines = [
+        "// Generated by scripts/generate-tasks.py from Res0.c, do not edit",
+        '#include "Res0.c"',
+        "",
+        "typedef struct",
+        "{",
+        "    const char *name;",
+        "    unsigned long interval;",
+        "    void (*body)(void);",
+        "} plc_task_info_t;",
+        "",
+    ]
+    for index, (_, _, body) in enumerate(tasks):
+        lines += [f"static void plc_task_{index}(void)", "{", body.strip("\n").rstrip(), "}", ""]
+    lines.append("const plc_task_info_t plc_tasks[] = {")
+    for index, (name, interval, _) in enumerate(tasks):
+        lines.append(f'    {{"{name}", {interval}UL, plc_task_{index}}},')
+    lines += ["};", f"const unsigned int plc_task_count = {len(tasks)};", ""]
+    return "\n".join(lines)
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(f"Usage: {argv[0]} <Res0.c> <output.c>", file=sys.stderr)
+        return 2
+
+    with open(argv[1], encoding="utf-8", errors="replace") as f:
+        source = f.read()
+    try:
+        tasks = parse_tasks(source)
+    except ValueError as e:
+        print(f"[INFO] No task table generated: {e}", file=sys.stderr)
+        return 1
+
+    with open(argv[2], "w", encoding="utf-8") as f:
+        f.write(generate(tasks))
+    print(f"[INFO] Task table generated: {', '.join(f'{n} ({i})' for n, i, _ in tasks)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Generate the variable names of a PLC program from its debug.c.
+
+The generated debug.c lists the program's debug variables in one table,
+indexed like get_var_addr() and get_var_size():
+
+    static const struct {
+        void *ptr;
+        __IEC_types_enum type;
+    } debug_vars[] = {
+        {&(RES0__INSTANCE0.START), BOOL_ENUM},
+        {&(RES0__INSTANCE0.TON0.ET), TIME_ENUM},
+        ...
+    };
+
+The output file includes debug.c and adds the name of each variable, the
+path of its address, so an online change can match the variables of two
+builds by name (see core/src/plc_app/online_change.h):
+
+    const char *get_var_name(size_t idx);
+
+Usage: generate-var-names.py <debug.c> <output.c>
+
+Exits with status 1, writing nothing, if the table is not found. The program
+is then built from debug.c alone and online changes are only accepted when
+both programs have the same variable layout.
+"""
+
+import re
+import sys
+
+TABLE = re.compile(r"\bdebug_vars\s*\[\s*\]\s*=\s*\{")
+ENTRY = re.compile(r"\{\s*&\s*\(\s*([A-Za-z_][\w.\[\]]*)\s*\)\s*,\s*\w+\s*\}")
+
+
+def matching_brace(text, start):
+    """Index just past the brace closing the one at text[start]."""
+    depth = 0
+    for i in range(start, len(text)):
+        if text[i] == "{":
+            depth += 1
+        elif text[i] == "}":
+            depth -= 1
+            if depth == 0:
+                return i + 1
+    raise ValueError("unbalanced braces")
+
+
+def parse_names(source):
+    """Return the variable names in debug index order."""
+    match = TABLE.search(source)
+    if match is None:
+        raise ValueError("no debug_vars table")
+    end = matching_brace(source, match.end() - 1)
+    body = source[match.end() : end - 1]
+
+    names = ENTRY.findall(body)
+    # Every entry must have been understood, or the indexes would shift
+    if not names or len(names) != body.count("&"):
+        raise ValueError("unsupported debug_vars entry")
+    return names
+
+
+def generate(names):
+    lines = [
+        "// Generated by scripts/generate-var-names.py from debug.c, do not edit",
+        "#include <stddef.h>",
+        '#include "debug.c"',
+        "",
+        "static const char *const plc_var_names[] = {",
+    ]
+    lines += [f'    "{name}",' for name in names]
+    lines += [
+        "};",
+        "",
+        "_Static_assert(sizeof(plc_var_names) / sizeof(plc_var_names[0]) ==",
+        "                   sizeof(debug_vars) / sizeof(debug_vars[0]),",
+        '               "one name per debug variable");',
+        "",
+        "const char *get_var_name(size_t idx)",
+        "{",
+        "    return idx < sizeof(plc_var_names) / sizeof(plc_var_names[0]) ? plc_var_names[idx] : NULL;",
+        "}",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(f"Usage: {argv[0]} <debug.c> <output.c>", file=sys.stderr)
+        return 2
+
+    with open(argv[1], encoding="utf-8", errors="replace") as f:
+        source = f.read()
+    try:
+        names = parse_names(source)
+    except ValueError as e:
+        print(f"[INFO] No variable names generated: {e}", file=sys.stderr)
+        return 1
+
+    with open(argv[2], "w", encoding="utf-8") as f:
+        f.write(generate(names))
+    print(f"[INFO] Variable names generated: {len(names)} variables")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
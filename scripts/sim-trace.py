@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Convert the trace files of a simulation run (--simulate) from and to CSV.
+
+A CSV trace has one value per line, the scan it applies from (inputs) or
+changed in (outputs) first:
+
+    scan,address,value
+    0,%IX0.0,1
+    100,%IW2,1500
+    250,%IX0.0,0
+
+Lines starting with # and a "scan,address,value" header are skipped. Values
+are integers, negative ones are stored in two's complement of the address
+width. Decoded values are printed unsigned.
+
+Usage: sim-trace.py encode <input.csv> <output.trace>
+       sim-trace.py decode <input.trace> [output.csv]
+
+Input records are sorted by scan when encoding, lines of the same scan keep
+their order. The runtime applies them in that order.
+"""
+
+import csv
+import re
+import struct
+import sys
+
+MAGIC = b"OPLCSIM1"
+VERSION = 1
+HEADER = struct.Struct("<8sII")
+RECORD = struct.Struct("<QIBBHQ")
+
+# journal_buffer_type_t, address prefix and width in bytes
+AREAS = [
+    ("IX", 1), ("QX", 1), ("MX", 1), ("IB", 1), ("QB", 1),
+    ("IW", 2), ("QW", 2), ("MW", 2),
+    ("ID", 4), ("QD", 4), ("MD", 4),
+    ("IL", 8), ("QL", 8), ("ML", 8),
+]
+ADDRESS = re.compile(r"%([IQM][XBWDL])(\d+)(?:\.([0-7]))?$")
+
+
+def parse_address(text):
+    """(type, index, bit) of a located address such as %IX0.3 or %QW2."""
+    match = ADDRESS.match(text.strip().upper())
+    prefixes = [prefix for prefix, _ in AREAS]
+    if not match or match.group(1) not in prefixes:
+        raise ValueError(f"unknown address {text!r}")
+    area, index, bit = match.groups()
+    if (area[1] == "X") != (bit is not None):
+        raise ValueError(f"bit addresses need a bit, others none: {text!r}")
+    return prefixes.index(area), int(index), int(bit or 0)
+
+
+def format_address(kind, index, bit):
+    prefix = AREAS[kind][0]
+    return f"%{prefix}{index}.{bit}" if prefix[1] == "X" else f"%{prefix}{index}"
+
+
+def encode(csv_path, trace_path):
+    records = []
+    with open(csv_path, newline="", encoding="utf-8") as f:
+        for line, row in enumerate(csv.reader(f), 1):
+            if not row or row[0].startswith("#") or row[0].strip() == "scan":
+                continue
+            try:
+                scan, address, value = (cell.strip() for cell in row)
+                kind, index, bit = parse_address(address)
+                value = int(value, 0)
+                if AREAS[kind][0][1] == "X":
+                    value = 1 if value else 0
+                value &= (1 << (8 * AREAS[kind][1])) - 1
+                records.append((int(scan), kind, index, bit, value))
+            except ValueError as e:
+                raise ValueError(f"{csv_path}:{line}: {e}") from None
+
+    records.sort(key=lambda record: record[0])
+    with open(trace_path, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, RECORD.size))
+        for scan, kind, index, bit, value in records:
+            f.write(RECORD.pack(scan, index, kind, bit, 0, value))
+    return len(records)
+
+
+def decode(trace_path, out):
+    with open(trace_path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise ValueError(f"{trace_path}: not a trace file")
+    magic, version, record_size = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+        raise ValueError(f"{trace_path}: not a version {VERSION} trace file")
+
+    writer = csv.writer(out, lineterminator="\n")
+    writer.writerow(["scan", "address", "value"])
+    count = 0
+    for offset in range(HEADER.size, len(data) - RECORD.size + 1, RECORD.size):
+        scan, index, kind, bit, _, value = RECORD.unpack_from(data, offset)
+        if kind >= len(AREAS):
+            raise ValueError(f"{trace_path}: record {count} has unknown area {kind}")
+        writer.writerow([scan, format_address(kind, index, bit), value])
+        count += 1
+    return count
+
+
+def main(argv):
+    if len(argv) not in (3, 4) or argv[1] not in ("encode", "decode") or \
+            (argv[1] == "encode" and len(argv) != 4):
+        print(f"Usage: {argv[0]} encode <input.csv> <output.trace>", file=sys.stderr)
+        print(f"       {argv[0]} decode <input.trace> [output.csv]", file=sys.stderr)
+        return 2
+
+    try:
+        if argv[1] == "encode":
+            count = encode(argv[2], argv[3])
+            print(f"[INFO] {count} records written to {argv[3]}")
+        elif len(argv) == 4:
+            with open(argv[3], "w", newline="", encoding="utf-8") as f:
+                count = decode(argv[2], f)
+            print(f"[INFO] {count} records written to {argv[3]}")
+        else:
+            decode(argv[2], sys.stdout)
+    except (OSError, ValueError) as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
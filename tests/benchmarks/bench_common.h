@@ -0,0 +1,186 @@
+/**
+ * @file bench_common.h
+ * @brief Timing, sample statistics and a fake image table for the benchmarks
+ *
+ * Header-only so the C and C++ benchmarks share it without a library. Every
+ * function is static inline: a benchmark pays only for what it uses.
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../core/src/lib/iec_types.h"
+
+// Indexes per image table, the runtime's default BUFFER_SIZE
+#define BENCH_IMAGE_SIZE 1024
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline void bench_sleep_until(uint64_t deadline_ns)
+{
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(deadline_ns / 1000000000ULL);
+    ts.tv_nsec = (long)(deadline_ns % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+    {
+    }
+}
+
+// Fixed-capacity sample set; samples past the capacity are counted but dropped
+typedef struct
+{
+    uint64_t *values;
+    size_t count;
+    size_t capacity;
+    uint64_t dropped;
+} bench_samples_t;
+
+static inline int bench_samples_init(bench_samples_t *samples, size_t capacity)
+{
+    samples->values   = (uint64_t *)calloc(capacity, sizeof(uint64_t));
+    samples->count    = 0;
+    samples->capacity = capacity;
+    samples->dropped  = 0;
+    return samples->values != NULL ? 0 : -1;
+}
+
+static inline void bench_samples_free(bench_samples_t *samples)
+{
+    free(samples->values);
+    samples->values = NULL;
+}
+
+static inline void bench_samples_add(bench_samples_t *samples, uint64_t value)
+{
+    if (samples->count < samples->capacity)
+    {
+        samples->values[samples->count++] = value;
+    }
+    else
+    {
+        samples->dropped++;
+    }
+}
+
+// Append the samples of other, used to merge per-thread sets
+static inline void bench_samples_merge(bench_samples_t *samples, const bench_samples_t *other)
+{
+    for (size_t i = 0; i < other->count; i++)
+    {
+        bench_samples_add(samples, other->values[i]);
+    }
+    samples->dropped += other->dropped;
+}
+
+static inline int bench_compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Print "<label>: n=.. min=.. p50=.. p90=.. p99=.. p999=.. max=.." in microseconds,
+// sorting the samples in place
+static inline void bench_samples_report(bench_samples_t *samples, const char *label)
+{
+    if (samples->count == 0)
+    {
+        printf("%-24s n=0\n", label);
+        return;
+    }
+    qsort(samples->values, samples->count, sizeof(uint64_t), bench_compare_u64);
+
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    static const char *names[]      = {"p50", "p90", "p99", "p999"};
+    printf("%-24s n=%zu min=%.2f", label, samples->count, samples->values[0] / 1000.0);
+    for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++)
+    {
+        size_t rank = (size_t)(quantiles[q] * (double)(samples->count - 1));
+        printf(" %s=%.2f", names[q], samples->values[rank] / 1000.0);
+    }
+    printf(" max=%.2f us\n", samples->values[samples->count - 1] / 1000.0);
+}
+
+// Image tables as the runtime lays them out: pointer tables into value arrays,
+// in journal_buffer_type_t order
+typedef struct
+{
+    IEC_BOOL *bool_input[BENCH_IMAGE_SIZE][8];
+    IEC_BOOL *bool_output[BENCH_IMAGE_SIZE][8];
+    IEC_BOOL *bool_memory[BENCH_IMAGE_SIZE][8];
+    IEC_BYTE *byte_input[BENCH_IMAGE_SIZE];
+    IEC_BYTE *byte_output[BENCH_IMAGE_SIZE];
+    IEC_UINT *int_input[BENCH_IMAGE_SIZE];
+    IEC_UINT *int_output[BENCH_IMAGE_SIZE];
+    IEC_UINT *int_memory[BENCH_IMAGE_SIZE];
+    IEC_UDINT *dint_input[BENCH_IMAGE_SIZE];
+    IEC_UDINT *dint_output[BENCH_IMAGE_SIZE];
+    IEC_UDINT *dint_memory[BENCH_IMAGE_SIZE];
+    IEC_ULINT *lint_input[BENCH_IMAGE_SIZE];
+    IEC_ULINT *lint_output[BENCH_IMAGE_SIZE];
+    IEC_ULINT *lint_memory[BENCH_IMAGE_SIZE];
+
+    IEC_BOOL bools[3][BENCH_IMAGE_SIZE][8];
+    IEC_BYTE bytes[2][BENCH_IMAGE_SIZE];
+    IEC_UINT ints[3][BENCH_IMAGE_SIZE];
+    IEC_UDINT dints[3][BENCH_IMAGE_SIZE];
+    IEC_ULINT lints[3][BENCH_IMAGE_SIZE];
+} bench_image_t;
+
+// Allocate an image with every pointer bound, as after image_tables_fill_null_pointers()
+static inline bench_image_t *bench_image_create(void)
+{
+    bench_image_t *image = (bench_image_t *)calloc(1, sizeof(bench_image_t));
+    if (image == NULL)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < BENCH_IMAGE_SIZE; i++)
+    {
+        for (size_t b = 0; b < 8; b++)
+        {
+            image->bool_input[i][b]  = &image->bools[0][i][b];
+            image->bool_output[i][b] = &image->bools[1][i][b];
+            image->bool_memory[i][b] = &image->bools[2][i][b];
+        }
+        image->byte_input[i]  = &image->bytes[0][i];
+        image->byte_output[i] = &image->bytes[1][i];
+        image->int_input[i]   = &image->ints[0][i];
+        image->int_output[i]  = &image->ints[1][i];
+        image->int_memory[i]  = &image->ints[2][i];
+        image->dint_input[i]  = &image->dints[0][i];
+        image->dint_output[i] = &image->dints[1][i];
+        image->dint_memory[i] = &image->dints[2][i];
+        image->lint_input[i]  = &image->lints[0][i];
+        image->lint_output[i] = &image->lints[1][i];
+        image->lint_memory[i] = &image->lints[2][i];
+    }
+    return image;
+}
+
+// Parse a positive integer option value, exiting on a bad one
+static inline unsigned long bench_parse_count(const char *option, const char *value)
+{
+    char *end;
+    unsigned long count = strtoul(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || count == 0)
+    {
+        fprintf(stderr, "Invalid value for %s: %s\n", option, value);
+        exit(2);
+    }
+    return count;
+}
+
+#endif // BENCH_COMMON_H
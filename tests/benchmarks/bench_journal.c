@@ -0,0 +1,249 @@
+/**
+ * @file bench_journal.c
+ * @brief Journal write throughput and apply cost with N producer threads
+ *
+ * Producers write %MW values (or ranges of them) as fast as they can while
+ * the main thread plays the scan thread: every period it takes the image
+ * mutex and calls journal_apply_and_clear(). Reports write throughput, write
+ * and apply latency percentiles, and the cost of applying an empty journal.
+ *
+ * Usage: bench_journal [--producers N] [--writes N] [--range N] [--period-us N]
+ *                      [--coalesce]
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "bench_common.h"
+#include "journal_buffer.h"
+
+// One write latency sample every this many writes
+#define SAMPLE_EVERY 16
+#define EMPTY_APPLIES 100000
+
+typedef struct
+{
+    pthread_t thread;
+    unsigned index;
+    unsigned long writes;
+    unsigned range;
+    unsigned long failed;
+    bench_samples_t latency;
+} producer_t;
+
+static pthread_mutex_t image_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool go              = false;
+static atomic_uint running         = 0;
+
+static void *producer_thread(void *arg)
+{
+    producer_t *producer = (producer_t *)arg;
+    IEC_UINT values[BENCH_IMAGE_SIZE];
+    for (unsigned i = 0; i < BENCH_IMAGE_SIZE; i++)
+    {
+        values[i] = (IEC_UINT)i;
+    }
+
+    while (!atomic_load(&go))
+    {
+    }
+
+    for (unsigned long i = 0; i < producer->writes; i++)
+    {
+        uint32_t index = (uint32_t)((producer->index * 37 + i) % BENCH_IMAGE_SIZE);
+        uint64_t start = i % SAMPLE_EVERY == 0 ? bench_now_ns() : 0;
+        int result;
+        if (producer->range == 0)
+        {
+            result = journal_write_int(JOURNAL_INT_MEMORY, index, (uint16_t)i);
+        }
+        else
+        {
+            if (index + producer->range > BENCH_IMAGE_SIZE)
+            {
+                index = 0;
+            }
+            result = journal_write_range(JOURNAL_INT_MEMORY, index, producer->range, values);
+        }
+        if (start != 0)
+        {
+            bench_samples_add(&producer->latency, bench_now_ns() - start);
+        }
+        producer->failed += result != 0;
+    }
+
+    atomic_fetch_sub(&running, 1);
+    return NULL;
+}
+
+static uint64_t timed_apply(void)
+{
+    pthread_mutex_lock(&image_mutex);
+    uint64_t start = bench_now_ns();
+    journal_apply_and_clear();
+    uint64_t elapsed = bench_now_ns() - start;
+    pthread_mutex_unlock(&image_mutex);
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned producers      = 4;
+    unsigned long count     = 2000000;
+    unsigned range          = 0;
+    unsigned long period_us = 250;
+    bool coalesce           = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--producers") == 0 && i + 1 < argc)
+        {
+            producers = (unsigned)bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--writes") == 0 && i + 1 < argc)
+        {
+            count = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--range") == 0 && i + 1 < argc)
+        {
+            range = (unsigned)bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--period-us") == 0 && i + 1 < argc)
+        {
+            period_us = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--coalesce") == 0)
+        {
+            coalesce = true;
+        }
+        else
+        {
+            fprintf(stderr,
+                    "Usage: %s [--producers N] [--writes N] [--range N] [--period-us N] "
+                    "[--coalesce]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (producers > JOURNAL_MAX_PRODUCERS || range > BENCH_IMAGE_SIZE)
+    {
+        fprintf(stderr, "At most %d producers and %d elements per range\n", JOURNAL_MAX_PRODUCERS,
+                BENCH_IMAGE_SIZE);
+        return 2;
+    }
+
+    bench_image_t *image = bench_image_create();
+    if (image == NULL)
+    {
+        return 1;
+    }
+    journal_buffer_ptrs_t ptrs = {
+        .bool_input  = image->bool_input,
+        .bool_output = image->bool_output,
+        .bool_memory = image->bool_memory,
+        .byte_input  = image->byte_input,
+        .byte_output = image->byte_output,
+        .int_input   = image->int_input,
+        .int_output  = image->int_output,
+        .int_memory  = image->int_memory,
+        .dint_input  = image->dint_input,
+        .dint_output = image->dint_output,
+        .dint_memory = image->dint_memory,
+        .lint_input  = image->lint_input,
+        .lint_output = image->lint_output,
+        .lint_memory = image->lint_memory,
+        .buffer_size = BENCH_IMAGE_SIZE,
+        .image_mutex = &image_mutex,
+    };
+    journal_set_coalescing(coalesce);
+    if (journal_init(&ptrs) != 0)
+    {
+        return 1;
+    }
+
+    printf("journal: %u producers, %lu %s each, apply every %lu us, %s mode\n", producers, count,
+           range == 0 ? "single writes" : "range writes", period_us,
+           journal_is_coalescing() ? "coalescing" : "ordered");
+    if (range > 0)
+    {
+        printf("journal: %u elements per range write\n", range);
+    }
+
+    producer_t *threads = (producer_t *)calloc(producers, sizeof(producer_t));
+    bench_samples_t apply;
+    if (threads == NULL || bench_samples_init(&apply, 1000000) != 0)
+    {
+        return 1;
+    }
+    atomic_store(&running, producers);
+    for (unsigned p = 0; p < producers; p++)
+    {
+        threads[p].index  = p;
+        threads[p].writes = count;
+        threads[p].range  = range;
+        if (bench_samples_init(&threads[p].latency, count / SAMPLE_EVERY + 1) != 0 ||
+            pthread_create(&threads[p].thread, NULL, producer_thread, &threads[p]) != 0)
+        {
+            return 1;
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    atomic_store(&go, true);
+    uint64_t next = start;
+    while (atomic_load(&running) > 0)
+    {
+        next += period_us * 1000;
+        bench_sleep_until(next);
+        bench_samples_add(&apply, timed_apply());
+    }
+    for (unsigned p = 0; p < producers; p++)
+    {
+        pthread_join(threads[p].thread, NULL);
+    }
+    bench_samples_add(&apply, timed_apply());
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_samples_t writes;
+    unsigned long failed = 0;
+    if (bench_samples_init(&writes, producers * (count / SAMPLE_EVERY + 1)) != 0)
+    {
+        return 1;
+    }
+    for (unsigned p = 0; p < producers; p++)
+    {
+        bench_samples_merge(&writes, &threads[p].latency);
+        failed += threads[p].failed;
+        bench_samples_free(&threads[p].latency);
+    }
+
+    double total = (double)producers * (double)count;
+    printf("journal: %.0f writes in %.3f s, %.0f writes/s, %lu failed\n", total, elapsed / 1e9,
+           total / (elapsed / 1e9), failed);
+    bench_samples_report(&writes, "write latency");
+    bench_samples_report(&apply, "apply (busy)");
+
+    bench_samples_t empty;
+    if (bench_samples_init(&empty, EMPTY_APPLIES) != 0)
+    {
+        return 1;
+    }
+    for (int i = 0; i < EMPTY_APPLIES; i++)
+    {
+        bench_samples_add(&empty, timed_apply());
+    }
+    bench_samples_report(&empty, "apply (empty)");
+
+    bench_samples_free(&writes);
+    bench_samples_free(&apply);
+    bench_samples_free(&empty);
+    free(threads);
+    journal_cleanup();
+    free(image);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file bench_libplc.c
+ * @brief Synthetic PLC program for bench_scan
+ *
+ * Exports what the runtime loads from a compiled program. Every scan copies
+ * %IW0.. to %QW0.., adds a counter, and spins for a configured number of
+ * iterations, so the scan time is set by the benchmark rather than by a real
+ * program. bench_scan calls bench_configure() before the runtime starts it.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../core/src/lib/iec_types.h"
+
+#define BENCH_MAX_WORDS 1024
+
+unsigned long long common_ticktime__ = 1000000ULL;
+char plc_program_md5[]               = "bench";
+
+static IEC_UINT **int_input;
+static IEC_UINT **int_output;
+
+static IEC_UINT inputs[BENCH_MAX_WORDS];
+static IEC_UINT outputs[BENCH_MAX_WORDS];
+static IEC_UDINT counter;
+
+static unsigned words           = 64;
+static volatile unsigned spin   = 0;
+static unsigned long spin_count = 0;
+
+void bench_configure(unsigned long long tick_ns, unsigned io_words, unsigned long work)
+{
+    common_ticktime__ = tick_ns;
+    words             = io_words < BENCH_MAX_WORDS ? io_words : BENCH_MAX_WORDS;
+    spin_count        = work;
+}
+
+IEC_UDINT bench_scans(void)
+{
+    return counter;
+}
+
+void setBufferPointers(IEC_BOOL *input_bool[][8], IEC_BOOL *output_bool[][8],
+                       IEC_BYTE *input_byte[], IEC_BYTE *output_byte[], IEC_UINT *input_int[],
+                       IEC_UINT *output_int[], IEC_UDINT *input_dint[], IEC_UDINT *output_dint[],
+                       IEC_ULINT *input_lint[], IEC_ULINT *output_lint[], IEC_UINT *memory_int[],
+                       IEC_UDINT *memory_dint[], IEC_ULINT *memory_lint[])
+{
+    (void)input_bool;
+    (void)output_bool;
+    (void)input_byte;
+    (void)output_byte;
+    (void)input_dint;
+    (void)output_dint;
+    (void)input_lint;
+    (void)output_lint;
+    (void)memory_int;
+    (void)memory_dint;
+    (void)memory_lint;
+    int_input  = input_int;
+    int_output = output_int;
+}
+
+void config_init__(void)
+{
+    counter = 0;
+}
+
+void glueVars(void)
+{
+    for (unsigned i = 0; i < words; i++)
+    {
+        int_input[i]  = &inputs[i];
+        int_output[i] = &outputs[i];
+    }
+}
+
+void config_run__(unsigned long tick)
+{
+    (void)tick;
+    counter++;
+    for (unsigned i = 0; i < words; i++)
+    {
+        outputs[i] = (IEC_UINT)(inputs[i] + counter);
+    }
+    for (unsigned long i = 0; i < spin_count; i++)
+    {
+        spin++;
+    }
+}
+
+void updateTime(void)
+{
+}
+
+void set_endianness(uint8_t value)
+{
+    (void)value;
+}
+
+uint16_t get_var_count(void)
+{
+    return 1;
+}
+
+size_t get_var_size(size_t index)
+{
+    return index == 0 ? sizeof(counter) : 0;
+}
+
+void *get_var_addr(size_t index)
+{
+    return index == 0 ? &counter : NULL;
+}
+
+void set_trace(size_t index, bool forced, void *value)
+{
+    (void)index;
+    (void)forced;
+    (void)value;
+}
@@ -0,0 +1,360 @@
+/**
+ * @file bench_s7comm.cpp
+ * @brief S7 read/write throughput through s7comm_rw_area_callback
+ *
+ * Builds the plugin into this file to reach its Snap7 callbacks, initializes
+ * it with s7comm_config.json against a fake image table and the real journal,
+ * and calls the RWArea callback from N client threads the way Snap7 worker
+ * threads do, without sockets. A scan thread applies the journal and runs
+ * cycle_end every period, which rebuilds the read caches; --no-cache leaves
+ * them unbuilt so every read takes the image mutex.
+ *
+ * Usage: bench_s7comm [--clients N] [--duration-s N] [--db N] [--size N]
+ *                     [--writes-percent N] [--period-us N] [--no-cache]
+ */
+
+#include "s7comm_plugin.cpp"
+
+#include <stdarg.h>
+#include <unistd.h>
+
+extern "C" {
+#include "bench_common.h"
+#include "journal_buffer.h"
+}
+
+#define SAMPLE_EVERY 16
+
+typedef struct
+{
+    pthread_t thread;
+    unsigned index;
+    int db;
+    int size;
+    unsigned writes_percent;
+    unsigned long reads;
+    unsigned long writes;
+    unsigned long rejected;
+    bench_samples_t read_latency;
+    bench_samples_t write_latency;
+} client_t;
+
+static pthread_mutex_t image_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<bool> stop_clients(false);
+static std::atomic<bool> stop_scan(false);
+
+static void quiet_log(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+static int take_mutex(pthread_mutex_t *mutex)
+{
+    return pthread_mutex_lock(mutex);
+}
+
+static int give_mutex(pthread_mutex_t *mutex)
+{
+    return pthread_mutex_unlock(mutex);
+}
+
+static int write_bool(int type, int index, int bit, int value)
+{
+    return journal_write_bool((journal_buffer_type_t)type, (uint32_t)index, (uint8_t)bit,
+                              value != 0);
+}
+
+static int write_byte(int type, int index, int value)
+{
+    return journal_write_byte((journal_buffer_type_t)type, (uint32_t)index, (uint8_t)value);
+}
+
+static int write_int(int type, int index, int value)
+{
+    return journal_write_int((journal_buffer_type_t)type, (uint32_t)index, (uint16_t)value);
+}
+
+static int write_dint(int type, int index, unsigned int value)
+{
+    return journal_write_dint((journal_buffer_type_t)type, (uint32_t)index, value);
+}
+
+static int write_lint(int type, int index, unsigned long long value)
+{
+    return journal_write_lint((journal_buffer_type_t)type, (uint32_t)index, value);
+}
+
+static int write_range(int type, int start_index, int count, const void *values)
+{
+    return journal_write_range((journal_buffer_type_t)type, (uint32_t)start_index,
+                               (uint32_t)count, values);
+}
+
+static void *client_thread(void *arg)
+{
+    client_t *client = (client_t *)arg;
+    uint8_t data[S7COMM_MAX_DB_SIZE];
+    memset(data, 0x5a, sizeof(data));
+
+    TS7Tag tag;
+    tag.Area     = S7AreaDB;
+    tag.DBNumber = client->db;
+    tag.Start    = 0;
+    tag.Size     = client->size;
+    tag.WordLen  = S7WLByte;
+
+    // Deterministic per-client mix of reads and writes
+    unsigned state = 0x9e3779b9u * (client->index + 1);
+    for (unsigned long op = 0; !stop_clients.load(std::memory_order_relaxed); op++)
+    {
+        state            = state * 1664525u + 1013904223u;
+        bool write       = (state >> 8) % 100 < client->writes_percent;
+        bool sample      = op % SAMPLE_EVERY == 0;
+        uint64_t start   = sample ? bench_now_ns() : 0;
+        int operation    = write ? OperationWrite : OperationRead;
+        int result       = s7comm_rw_area_callback(NULL, (int)client->index, operation, &tag, data);
+        uint64_t elapsed = sample ? bench_now_ns() - start : 0;
+
+        client->rejected += result != 0;
+        if (write)
+        {
+            client->writes++;
+            if (sample)
+            {
+                bench_samples_add(&client->write_latency, elapsed);
+            }
+        }
+        else
+        {
+            client->reads++;
+            if (sample)
+            {
+                bench_samples_add(&client->read_latency, elapsed);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void *scan_thread(void *arg)
+{
+    unsigned long period_us = *(unsigned long *)arg;
+    uint64_t next           = bench_now_ns();
+    while (!stop_scan.load(std::memory_order_relaxed))
+    {
+        pthread_mutex_lock(&image_mutex);
+        journal_apply_and_clear();
+        cycle_end();
+        pthread_mutex_unlock(&image_mutex);
+        next += period_us * 1000;
+        bench_sleep_until(next);
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long clients        = 2;
+    unsigned long duration_s     = 3;
+    unsigned long db             = 10;
+    unsigned long size           = 64;
+    unsigned long writes_percent = 10;
+    unsigned long period_us      = 1000;
+    bool cache                   = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc)
+        {
+            clients = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--duration-s") == 0 && i + 1 < argc)
+        {
+            duration_s = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)
+        {
+            db = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            size = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--writes-percent") == 0 && i + 1 < argc)
+        {
+            writes_percent = strtoul(argv[i + 1], NULL, 10);
+            i++;
+        }
+        else if (strcmp(argv[i], "--period-us") == 0 && i + 1 < argc)
+        {
+            period_us = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--no-cache") == 0)
+        {
+            cache = false;
+        }
+        else
+        {
+            fprintf(stderr,
+                    "Usage: %s [--clients N] [--duration-s N] [--db N] [--size N] "
+                    "[--writes-percent N] [--period-us N] [--no-cache]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (writes_percent > 100 || size > S7COMM_MAX_DB_SIZE || clients > JOURNAL_MAX_PRODUCERS)
+    {
+        fprintf(stderr, "writes-percent must be 0-100, size at most %d, at most %d clients\n",
+                S7COMM_MAX_DB_SIZE, JOURNAL_MAX_PRODUCERS);
+        return 2;
+    }
+
+    bench_image_t *image = bench_image_create();
+    if (image == NULL)
+    {
+        return 1;
+    }
+    journal_buffer_ptrs_t ptrs;
+    memset(&ptrs, 0, sizeof(ptrs));
+    ptrs.bool_input  = image->bool_input;
+    ptrs.bool_output = image->bool_output;
+    ptrs.bool_memory = image->bool_memory;
+    ptrs.byte_input  = image->byte_input;
+    ptrs.byte_output = image->byte_output;
+    ptrs.int_input   = image->int_input;
+    ptrs.int_output  = image->int_output;
+    ptrs.int_memory  = image->int_memory;
+    ptrs.dint_input  = image->dint_input;
+    ptrs.dint_output = image->dint_output;
+    ptrs.dint_memory = image->dint_memory;
+    ptrs.lint_input  = image->lint_input;
+    ptrs.lint_output = image->lint_output;
+    ptrs.lint_memory = image->lint_memory;
+    ptrs.buffer_size = BENCH_IMAGE_SIZE;
+    ptrs.image_mutex = &image_mutex;
+    if (journal_init(&ptrs) != 0)
+    {
+        return 1;
+    }
+
+    plugin_runtime_args_t args;
+    memset(&args, 0, sizeof(args));
+    args.bool_input          = image->bool_input;
+    args.bool_output         = image->bool_output;
+    args.bool_memory         = image->bool_memory;
+    args.byte_input          = image->byte_input;
+    args.byte_output         = image->byte_output;
+    args.int_input           = image->int_input;
+    args.int_output          = image->int_output;
+    args.int_memory          = image->int_memory;
+    args.dint_input          = image->dint_input;
+    args.dint_output         = image->dint_output;
+    args.dint_memory         = image->dint_memory;
+    args.lint_input          = image->lint_input;
+    args.lint_output         = image->lint_output;
+    args.lint_memory         = image->lint_memory;
+    args.mutex_take          = take_mutex;
+    args.mutex_give          = give_mutex;
+    args.buffer_mutex        = &image_mutex;
+    args.buffer_size         = BENCH_IMAGE_SIZE;
+    args.bits_per_buffer     = 8;
+    args.log_info            = quiet_log;
+    args.log_debug           = quiet_log;
+    args.log_warn            = quiet_log;
+    args.log_error           = quiet_log;
+    args.journal_write_bool  = write_bool;
+    args.journal_write_byte  = write_byte;
+    args.journal_write_int   = write_int;
+    args.journal_write_dint  = write_dint;
+    args.journal_write_lint  = write_lint;
+    args.journal_write_range = write_range;
+    snprintf(args.plugin_specific_config_file_path, sizeof(args.plugin_specific_config_file_path),
+             "%s", S7COMM_BENCH_CONFIG);
+    if (init(&args) != 0 || find_db_runtime((int)db) == NULL)
+    {
+        fprintf(stderr, "DB%lu is not configured in %s\n", db, S7COMM_BENCH_CONFIG);
+        return 1;
+    }
+    if (size > (unsigned long)find_db_runtime((int)db)->size_bytes)
+    {
+        size = (unsigned long)find_db_runtime((int)db)->size_bytes;
+    }
+
+    // cycle_end only rebuilds the read caches of a running server; the server
+    // is not started, no Snap7 listener is needed
+    g_running = cache;
+
+    printf("s7comm: %lu clients, DB%lu, %lu bytes per request, %lu%% writes, scan every %lu us, "
+           "read cache %s, %lu s\n",
+           clients, db, size, writes_percent, period_us, cache ? "on" : "off", duration_s);
+
+    client_t *threads = (client_t *)calloc(clients, sizeof(client_t));
+    if (threads == NULL)
+    {
+        return 1;
+    }
+    pthread_t scan;
+    if (pthread_create(&scan, NULL, scan_thread, &period_us) != 0)
+    {
+        return 1;
+    }
+    for (unsigned long c = 0; c < clients; c++)
+    {
+        client_t *client       = &threads[c];
+        client->index          = (unsigned)c;
+        client->db             = (int)db;
+        client->size           = (int)size;
+        client->writes_percent = (unsigned)writes_percent;
+        if (bench_samples_init(&client->read_latency, 1 << 20) != 0 ||
+            bench_samples_init(&client->write_latency, 1 << 20) != 0 ||
+            pthread_create(&client->thread, NULL, client_thread, client) != 0)
+        {
+            return 1;
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    sleep((unsigned)duration_s);
+    stop_clients.store(true);
+    bench_samples_t reads, writes;
+    if (bench_samples_init(&reads, clients << 20) != 0 ||
+        bench_samples_init(&writes, clients << 20) != 0)
+    {
+        return 1;
+    }
+    unsigned long read_count = 0, write_count = 0, rejected = 0;
+    for (unsigned long c = 0; c < clients; c++)
+    {
+        pthread_join(threads[c].thread, NULL);
+        read_count += threads[c].reads;
+        write_count += threads[c].writes;
+        rejected += threads[c].rejected;
+        bench_samples_merge(&reads, &threads[c].read_latency);
+        bench_samples_merge(&writes, &threads[c].write_latency);
+        bench_samples_free(&threads[c].read_latency);
+        bench_samples_free(&threads[c].write_latency);
+    }
+    double elapsed = (bench_now_ns() - start) / 1e9;
+    stop_scan.store(true);
+    pthread_join(scan, NULL);
+
+    printf("s7comm: %.0f reads/s, %.0f writes/s, %.1f MB/s, %lu rejected\n",
+           read_count / elapsed, write_count / elapsed,
+           (double)(read_count + write_count) * (double)size / elapsed / 1e6, rejected);
+    bench_samples_report(&reads, "read latency");
+    bench_samples_report(&writes, "write latency");
+
+    g_running = false;
+    cleanup();
+    journal_cleanup();
+    bench_samples_free(&reads);
+    bench_samples_free(&writes);
+    free(threads);
+    free(image);
+    return 0;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file bench_scan.c
+ * @brief Scan jitter of plc_cycle_thread running a synthetic program
+ *
+ * Starts the real scan thread through plc_set_state() against bench_libplc,
+ * optionally with threads journaling %IW writes like plugins do, and prints
+ * the runtime's own STATS and HISTOGRAM output for the run: cycle_latency is
+ * the wake-up jitter against the slot, scan_time the time under buffer_mutex.
+ * Runs in a scratch directory so no plugins.conf is picked up.
+ *
+ * Usage: bench_scan LIBPLC [--duration-s N] [--tick-us N] [--work N] [--words N]
+ *                   [--writers N] [--write-interval-us N] [--profile] [--verbose]
+ *
+ * Without real-time privileges the scan thread runs SCHED_OTHER and the
+ * latencies include ordinary scheduling noise.
+ */
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "../../core/src/drivers/plugin_driver.h"
+#include "bench_common.h"
+#include "image_tables.h"
+#include "journal_buffer.h"
+#include "plc_state_manager.h"
+#include "scan_cycle_manager.h"
+#include "scan_profiler.h"
+#include "utils/log.h"
+
+// Globals plc_main.c provides to the rest of the runtime
+volatile sig_atomic_t keep_running = 1;
+plugin_driver_t *plugin_driver     = NULL;
+
+extern PluginManager *plc_program;
+extern bool print_logs;
+
+typedef void (*bench_configure_t)(unsigned long long tick_ns, unsigned words, unsigned long work);
+typedef IEC_UDINT (*bench_scans_t)(void);
+
+typedef struct
+{
+    pthread_t thread;
+    unsigned index;
+    unsigned words;
+    unsigned long interval_us;
+    unsigned long writes;
+} writer_t;
+
+static atomic_bool writers_stop = false;
+
+static void *writer_thread(void *arg)
+{
+    writer_t *writer = (writer_t *)arg;
+    uint64_t next    = bench_now_ns();
+    while (!atomic_load(&writers_stop))
+    {
+        uint32_t index = (uint32_t)((writer->index * 7 + writer->writes) % writer->words);
+        if (journal_write_int(JOURNAL_INT_INPUT, index, (uint16_t)writer->writes) == 0)
+        {
+            writer->writes++;
+        }
+        next += writer->interval_us * 1000;
+        bench_sleep_until(next);
+    }
+    return NULL;
+}
+
+static void print_response(int (*format)(char *, size_t))
+{
+    static char buffer[65536];
+    if (format(buffer, sizeof(buffer)) > 0)
+    {
+        fputs(buffer, stdout);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *library       = NULL;
+    unsigned long duration_s  = 5;
+    unsigned long tick_us     = 1000;
+    unsigned long work        = 0;
+    unsigned long words       = 64;
+    unsigned long writers     = 0;
+    unsigned long interval_us = 100;
+    bool profile              = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--duration-s") == 0 && i + 1 < argc)
+        {
+            duration_s = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--tick-us") == 0 && i + 1 < argc)
+        {
+            tick_us = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--work") == 0 && i + 1 < argc)
+        {
+            work = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--words") == 0 && i + 1 < argc)
+        {
+            words = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--writers") == 0 && i + 1 < argc)
+        {
+            writers = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--write-interval-us") == 0 && i + 1 < argc)
+        {
+            interval_us = bench_parse_count(argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            profile = true;
+        }
+        else if (strcmp(argv[i], "--verbose") == 0)
+        {
+            print_logs = true;
+        }
+        else if (argv[i][0] != '-' && library == NULL)
+        {
+            library = argv[i];
+        }
+        else
+        {
+            library = NULL;
+            break;
+        }
+    }
+    if (library == NULL || words > BENCH_IMAGE_SIZE || writers > JOURNAL_MAX_PRODUCERS)
+    {
+        fprintf(stderr,
+                "Usage: %s LIBPLC [--duration-s N] [--tick-us N] [--work N] [--words N] "
+                "[--writers N] [--write-interval-us N] [--profile] [--verbose]\n",
+                argv[0]);
+        return 2;
+    }
+
+    // The runtime dlopen()s the same file and gets this configured instance back
+    char path[PATH_MAX];
+    void *handle = realpath(library, path) != NULL ? dlopen(path, RTLD_NOW) : NULL;
+    bench_configure_t configure =
+        handle != NULL ? (bench_configure_t)dlsym(handle, "bench_configure") : NULL;
+    bench_scans_t scans = handle != NULL ? (bench_scans_t)dlsym(handle, "bench_scans") : NULL;
+    if (configure == NULL || scans == NULL)
+    {
+        fprintf(stderr, "Cannot load the benchmark program %s: %s\n", library, dlerror());
+        return 1;
+    }
+    configure(tick_us * 1000ULL, (unsigned)words, work);
+
+    char scratch[] = "/tmp/bench_scan.XXXXXX";
+    if (mkdtemp(scratch) == NULL || chdir(scratch) != 0)
+    {
+        perror("bench_scan: scratch directory");
+        return 1;
+    }
+
+    log_set_async(false);
+    scan_profiler_set_enabled(profile);
+    if (image_tables_init() != 0 || (plugin_driver = plugin_driver_create()) == NULL ||
+        (plc_program = plugin_manager_create(path)) == NULL)
+    {
+        return 1;
+    }
+
+    printf("scan: tick %lu us, %lu I/O words, %lu spin iterations, %lu writers every %lu us, "
+           "%lu s\n",
+           tick_us, words, work, writers, interval_us, duration_s);
+    if (!plc_set_state(PLC_STATE_RUNNING))
+    {
+        fprintf(stderr, "The benchmark program did not start\n");
+        return 1;
+    }
+
+    writer_t *threads = (writer_t *)calloc(writers > 0 ? writers : 1, sizeof(writer_t));
+    if (threads == NULL)
+    {
+        return 1;
+    }
+    for (unsigned long w = 0; w < writers; w++)
+    {
+        threads[w].index       = (unsigned)w;
+        threads[w].words       = (unsigned)words;
+        threads[w].interval_us = interval_us;
+        pthread_create(&threads[w].thread, NULL, writer_thread, &threads[w]);
+    }
+
+    sleep((unsigned)duration_s);
+
+    atomic_store(&writers_stop, true);
+    unsigned long total_writes = 0;
+    for (unsigned long w = 0; w < writers; w++)
+    {
+        pthread_join(threads[w].thread, NULL);
+        total_writes += threads[w].writes;
+    }
+
+    // Read the statistics while the scan thread is still running
+    print_response(format_timing_stats_response);
+    print_response(format_timing_histogram_response);
+    if (profile)
+    {
+        print_response(format_scan_profile_response);
+    }
+    printf("scan: %u program scans, %lu journal writes\n", (unsigned)scans(), total_writes);
+
+    plc_set_state(PLC_STATE_STOPPED);
+    plugin_driver_destroy(plugin_driver);
+    free(threads);
+    dlclose(handle);
+    rmdir(scratch);
+    return 0;
+}
@@ -0,0 +1,725 @@
+/**
+ * @file load_generator.cpp
+ * @brief S7 and Modbus TCP load against a running plc_main, correlated with its scan timing
+ *
+ * Ramps the number of client connections (and optionally the request rate of
+ * each client) in steps. Every step connects the clients, resets the
+ * runtime's histograms over the unix socket, runs for --step-s seconds and
+ * then samples STATS and HISTOGRAM again, so each report row pairs the load
+ * the clients achieved with the scans, overruns and cycle latency the runtime
+ * saw under it. S7 clients use the bundled Snap7 micro client; Modbus clients
+ * speak Modbus TCP directly (FC3 reads, FC16 writes).
+ *
+ * Usage: load_generator [--s7 HOST[:PORT]] [--modbus HOST[:PORT]] [--clients LIST]
+ *                       [--rates LIST] [--step-s N] [--writes-percent N]
+ *                       [--s7-db N] [--s7-size N] [--modbus-start N] [--modbus-count N]
+ *                       [--socket PATH] [--csv]
+ *
+ * LIST is comma separated, e.g. "1,2,4,8". A rate of 0 means as fast as the
+ * server answers.
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "s7_micro_client.h"
+
+extern "C" {
+#include "../../core/src/plc_app/unix_socket.h"
+#include "bench_common.h"
+}
+
+#define SAMPLE_EVERY 4
+#define SAMPLE_CAPACITY (1 << 18)
+#define MAX_STEPS 32
+#define MAX_CLIENTS_PER_PROTOCOL 256
+#define MODBUS_MAX_REGISTERS 123
+#define CONNECT_TIMEOUT_S 10
+
+enum protocol_t
+{
+    PROTOCOL_S7,
+    PROTOCOL_MODBUS,
+    PROTOCOL_COUNT
+};
+
+static const char *const protocol_names[PROTOCOL_COUNT] = {"s7", "modbus"};
+
+typedef struct
+{
+    bool enabled;
+    char host[256];
+    int port;
+} target_t;
+
+typedef struct
+{
+    target_t targets[PROTOCOL_COUNT];
+    int s7_db;
+    int s7_size;
+    int modbus_start;
+    int modbus_count;
+    unsigned writes_percent;
+} load_config_t;
+
+typedef struct
+{
+    pthread_t thread;
+    protocol_t protocol;
+    unsigned index;
+    unsigned long rate;
+    const load_config_t *config;
+    bool connected;
+    unsigned long requests;
+    unsigned long errors;
+    bench_samples_t latency;
+} client_t;
+
+// Runtime timing read over the unix socket, -1 when not reported
+typedef struct
+{
+    long long scan_count;
+    long long overruns;
+    long long latency_p50;
+    long long latency_p99;
+    long long latency_max;
+    long long scan_p99;
+} runtime_sample_t;
+
+static std::atomic<bool> stop_clients(false);
+static std::atomic<unsigned> clients_ready(0);
+
+// Parse "1,2,4" into values, returns the count or -1
+static int parse_list(const char *text, unsigned long *values, int max)
+{
+    int count = 0;
+    while (*text != '\0')
+    {
+        char *end;
+        unsigned long value = strtoul(text, &end, 10);
+        if (end == text || count == max || (*end != ',' && *end != '\0'))
+        {
+            return -1;
+        }
+        values[count++] = value;
+        text            = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static bool parse_target(const char *text, int default_port, target_t *target)
+{
+    snprintf(target->host, sizeof(target->host), "%s", text);
+    target->port = default_port;
+    char *colon  = strrchr(target->host, ':');
+    if (colon != NULL)
+    {
+        *colon       = '\0';
+        target->port = atoi(colon + 1);
+    }
+    target->enabled = target->host[0] != '\0' && target->port > 0 && target->port < 65536;
+    return target->enabled;
+}
+
+// Find "key":<number> after `from` in a JSON response, -1 if missing or null
+static long long json_number(const char *from, const char *key)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *found = from != NULL ? strstr(from, pattern) : NULL;
+    if (found == NULL)
+    {
+        return -1;
+    }
+    char *end;
+    long long value = strtoll(found + strlen(pattern), &end, 10);
+    return end == found + strlen(pattern) ? -1 : value;
+}
+
+// ---------------------------------------------------------------------------
+// Runtime unix socket
+// ---------------------------------------------------------------------------
+
+static int runtime_connect(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    // Do not hang on a runtime that stopped answering
+    struct timeval timeout = {CONNECT_TIMEOUT_S, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Send one command and read its single-line response
+static bool runtime_command(int fd, const char *command, char *response, size_t size)
+{
+    char line[64];
+    int length = snprintf(line, sizeof(line), "%s\n", command);
+    if (write(fd, line, (size_t)length) != length)
+    {
+        return false;
+    }
+    size_t total = 0;
+    while (total < size - 1)
+    {
+        ssize_t received = read(fd, response + total, size - 1 - total);
+        if (received <= 0)
+        {
+            return false;
+        }
+        total += (size_t)received;
+        if (response[total - 1] == '\n')
+        {
+            break;
+        }
+    }
+    response[total] = '\0';
+    return true;
+}
+
+static bool runtime_sample(int fd, runtime_sample_t *sample)
+{
+    static char response[MAX_RESPONSE_SIZE];
+    if (!runtime_command(fd, "STATS", response, sizeof(response)) ||
+        strncmp(response, "STATS:", 6) != 0)
+    {
+        return false;
+    }
+    sample->scan_count = json_number(response, "scan_count");
+    sample->overruns   = json_number(response, "overruns");
+
+    if (!runtime_command(fd, "HISTOGRAM", response, sizeof(response)) ||
+        strncmp(response, "HISTOGRAM:", 10) != 0)
+    {
+        return false;
+    }
+    // Only the "all" set, which the step started by resetting
+    const char *all     = strstr(response, "\"all\":");
+    const char *latency = all != NULL ? strstr(all, "\"cycle_latency\":") : NULL;
+    sample->latency_p50 = json_number(latency, "p50");
+    sample->latency_p99 = json_number(latency, "p99");
+    sample->latency_max = json_number(latency, "max");
+    sample->scan_p99    = json_number(all != NULL ? strstr(all, "\"scan_time\":") : NULL, "p99");
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Modbus TCP client
+// ---------------------------------------------------------------------------
+
+static int modbus_connect(const target_t *target)
+{
+    char port[16];
+    snprintf(port, sizeof(port), "%d", target->port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *result;
+    if (getaddrinfo(target->host, port, &hints, &result) != 0)
+    {
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo *ai = result; ai != NULL && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    if (fd >= 0)
+    {
+        int one                = 1;
+        struct timeval timeout = {3, 0};
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+    return fd;
+}
+
+static bool modbus_read_exact(int fd, uint8_t *buffer, size_t length)
+{
+    size_t total = 0;
+    while (total < length)
+    {
+        ssize_t received = read(fd, buffer + total, length - total);
+        if (received <= 0)
+        {
+            return false;
+        }
+        total += (size_t)received;
+    }
+    return true;
+}
+
+// One FC3 read or FC16 write of `count` holding registers. Returns 0 on
+// success, 1 on an exception response, -1 when the connection failed.
+static int modbus_request(int fd, uint16_t transaction, bool is_write, int start, int count)
+{
+    uint8_t request[13 + 2 * MODBUS_MAX_REGISTERS];
+    size_t length = 12;
+    request[7]    = is_write ? 0x10 : 0x03;
+    request[8]    = (uint8_t)(start >> 8);
+    request[9]    = (uint8_t)start;
+    request[10]   = (uint8_t)(count >> 8);
+    request[11]   = (uint8_t)count;
+    if (is_write)
+    {
+        request[12] = (uint8_t)(2 * count);
+        for (int i = 0; i < count; i++)
+        {
+            request[13 + 2 * i] = (uint8_t)(transaction >> 8);
+            request[14 + 2 * i] = (uint8_t)transaction;
+        }
+        length = 13 + 2 * (size_t)count;
+    }
+    request[0] = (uint8_t)(transaction >> 8);
+    request[1] = (uint8_t)transaction;
+    request[2] = 0;
+    request[3] = 0;
+    request[4] = (uint8_t)((length - 6) >> 8);
+    request[5] = (uint8_t)(length - 6);
+    request[6] = 1;
+    if (write(fd, request, length) != (ssize_t)length)
+    {
+        return -1;
+    }
+
+    uint8_t response[9 + 2 * MODBUS_MAX_REGISTERS];
+    if (!modbus_read_exact(fd, response, 7))
+    {
+        return -1;
+    }
+    size_t remaining = (size_t)response[4] << 8 | response[5];
+    if (remaining < 2 || remaining - 1 > sizeof(response) - 7 ||
+        !modbus_read_exact(fd, response + 7, remaining - 1))
+    {
+        return -1;
+    }
+    uint16_t answered = (uint16_t)(response[0] << 8 | response[1]);
+    if (answered != transaction)
+    {
+        return -1;
+    }
+    return (response[7] & 0x80) != 0 ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Client threads
+// ---------------------------------------------------------------------------
+
+static void pace(uint64_t *next, unsigned long rate)
+{
+    if (rate > 0)
+    {
+        *next += 1000000000ULL / rate;
+        bench_sleep_until(*next);
+    }
+}
+
+static void run_s7_client(client_t *client)
+{
+    const load_config_t *config = client->config;
+    const target_t *target      = &config->targets[PROTOCOL_S7];
+    TSnap7MicroClient s7;
+    uint16_t port = (uint16_t)target->port;
+    s7.SetParam(p_u16_RemotePort, &port);
+    client->connected = s7.ConnectTo(target->host, 0, 1) == 0;
+    clients_ready.fetch_add(1);
+    if (!client->connected)
+    {
+        return;
+    }
+
+    uint8_t data[65536];
+    memset(data, 0, sizeof(data));
+    unsigned state = 0x9e3779b9u * (client->index + 1);
+    uint64_t next  = bench_now_ns();
+    for (unsigned long op = 0; !stop_clients.load(std::memory_order_relaxed); op++)
+    {
+        state          = state * 1664525u + 1013904223u;
+        bool write     = (state >> 8) % 100 < config->writes_percent;
+        bool sample    = op % SAMPLE_EVERY == 0;
+        uint64_t start = sample ? bench_now_ns() : 0;
+        int result     = write ? s7.DBWrite(config->s7_db, 0, config->s7_size, data)
+                               : s7.DBRead(config->s7_db, 0, config->s7_size, data);
+        if (sample)
+        {
+            bench_samples_add(&client->latency, bench_now_ns() - start);
+        }
+        client->requests++;
+        if (result != 0)
+        {
+            client->errors++;
+            // A TCP level failure leaves the client disconnected, stop counting it
+            if (!s7.Connected)
+            {
+                break;
+            }
+        }
+        pace(&next, client->rate);
+    }
+    s7.Disconnect();
+}
+
+static void run_modbus_client(client_t *client)
+{
+    const load_config_t *config = client->config;
+    int fd                      = modbus_connect(&config->targets[PROTOCOL_MODBUS]);
+    client->connected           = fd >= 0;
+    clients_ready.fetch_add(1);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    unsigned state = 0x7f4a7c15u * (client->index + 1);
+    uint64_t next  = bench_now_ns();
+    for (unsigned long op = 0; !stop_clients.load(std::memory_order_relaxed); op++)
+    {
+        state          = state * 1664525u + 1013904223u;
+        bool write     = (state >> 8) % 100 < config->writes_percent;
+        bool sample    = op % SAMPLE_EVERY == 0;
+        uint64_t start = sample ? bench_now_ns() : 0;
+        int result     = modbus_request(fd, (uint16_t)op, write, config->modbus_start,
+                                        config->modbus_count);
+        if (sample)
+        {
+            bench_samples_add(&client->latency, bench_now_ns() - start);
+        }
+        client->requests++;
+        if (result != 0)
+        {
+            client->errors++;
+            if (result < 0)
+            {
+                break;
+            }
+        }
+        pace(&next, client->rate);
+    }
+    close(fd);
+}
+
+static void *client_thread(void *arg)
+{
+    client_t *client = (client_t *)arg;
+    if (client->protocol == PROTOCOL_S7)
+    {
+        run_s7_client(client);
+    }
+    else
+    {
+        run_modbus_client(client);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Steps and report
+// ---------------------------------------------------------------------------
+
+static double percentile_us(bench_samples_t *samples, double q)
+{
+    if (samples->count == 0)
+    {
+        return 0.0;
+    }
+    qsort(samples->values, samples->count, sizeof(uint64_t), bench_compare_u64);
+    return samples->values[(size_t)(q * (double)(samples->count - 1))] / 1000.0;
+}
+
+static void print_header(bool csv)
+{
+    if (csv)
+    {
+        printf("protocol,clients,rate,connected,requests_per_s,errors,req_p50_us,req_p99_us,"
+               "scans,overruns,latency_p50_us,latency_p99_us,latency_max_us,scan_p99_us\n");
+        return;
+    }
+    printf("%-7s %7s %6s %5s %10s %7s %9s %9s | %8s %8s %8s %8s %8s %8s\n", "proto", "clients",
+           "rate", "conn", "req/s", "errors", "req p50", "req p99", "scans", "overrun",
+           "lat p50", "lat p99", "lat max", "scan p99");
+}
+
+static void print_row(bool csv, const char *protocol, unsigned long clients, unsigned long rate,
+                      unsigned connected, double per_second, unsigned long errors,
+                      bench_samples_t *latency, const runtime_sample_t *before,
+                      const runtime_sample_t *after)
+{
+    double p50        = percentile_us(latency, 0.50);
+    double p99        = percentile_us(latency, 0.99);
+    long long scans   = after->scan_count - before->scan_count;
+    long long overrun = after->overruns - before->overruns;
+    const char *fmt   = csv ? "%s,%lu,%lu,%u,%.0f,%lu,%.1f,%.1f,%lld,%lld,%lld,%lld,%lld,%lld\n"
+                            : "%-7s %7lu %6lu %5u %10.0f %7lu %9.1f %9.1f | %8lld %8lld %8lld "
+                              "%8lld %8lld %8lld\n";
+    printf(fmt, protocol, clients, rate, connected, per_second, errors, p50, p99, scans, overrun,
+           after->latency_p50, after->latency_p99, after->latency_max, after->scan_p99);
+}
+
+// Run one step: `clients` connections per enabled protocol at `rate`
+// requests per second each. Returns false if the runtime stopped answering.
+static bool run_step(int runtime, const load_config_t *config, unsigned long clients,
+                     unsigned long rate, unsigned long step_s, bool csv)
+{
+    unsigned protocols = 0;
+    for (int p = 0; p < PROTOCOL_COUNT; p++)
+    {
+        protocols += config->targets[p].enabled;
+    }
+    unsigned total    = (unsigned)clients * protocols;
+    client_t *threads = (client_t *)calloc(total, sizeof(client_t));
+    if (threads == NULL)
+    {
+        return false;
+    }
+
+    stop_clients.store(false);
+    clients_ready.store(0);
+    unsigned started = 0;
+    for (int p = 0; p < PROTOCOL_COUNT; p++)
+    {
+        for (unsigned long c = 0; config->targets[p].enabled && c < clients; c++)
+        {
+            client_t *client = &threads[started];
+            client->protocol = (protocol_t)p;
+            client->index    = (unsigned)c;
+            client->rate     = rate;
+            client->config   = config;
+            if (bench_samples_init(&client->latency, SAMPLE_CAPACITY) != 0 ||
+                pthread_create(&client->thread, NULL, client_thread, client) != 0)
+            {
+                fprintf(stderr, "Cannot start client thread\n");
+                break;
+            }
+            started++;
+        }
+    }
+
+    // Measure only once every client has connected (or failed to)
+    while (clients_ready.load() < started)
+    {
+        usleep(1000);
+    }
+
+    char response[64];
+    runtime_sample_t before, after;
+    bool ok = runtime_command(runtime, "HISTOGRAM:RESET", response, sizeof(response)) &&
+              runtime_sample(runtime, &before);
+    uint64_t start = bench_now_ns();
+    if (ok)
+    {
+        sleep((unsigned)step_s);
+        ok = runtime_sample(runtime, &after);
+    }
+    double elapsed = (bench_now_ns() - start) / 1e9;
+    stop_clients.store(true);
+
+    for (int p = 0; p < PROTOCOL_COUNT; p++)
+    {
+        bench_samples_t latency;
+        unsigned connected     = 0;
+        unsigned long requests = 0, errors = 0;
+        bool used              = false;
+        bench_samples_init(&latency, (size_t)SAMPLE_CAPACITY * (clients > 0 ? clients : 1));
+        for (unsigned i = 0; i < started; i++)
+        {
+            if (threads[i].protocol != p)
+            {
+                continue;
+            }
+            used = true;
+            pthread_join(threads[i].thread, NULL);
+            connected += threads[i].connected;
+            requests += threads[i].requests;
+            errors += threads[i].errors;
+            bench_samples_merge(&latency, &threads[i].latency);
+            bench_samples_free(&threads[i].latency);
+        }
+        if (used && ok)
+        {
+            print_row(csv, protocol_names[p], clients, rate, connected, requests / elapsed, errors,
+                      &latency, &before, &after);
+        }
+        bench_samples_free(&latency);
+    }
+    fflush(stdout);
+    free(threads);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    load_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.s7_db          = 10;
+    config.s7_size        = 64;
+    config.modbus_start   = 0;
+    config.modbus_count   = 16;
+    config.writes_percent = 10;
+
+    unsigned long client_steps[MAX_STEPS] = {1, 2, 4, 8};
+    unsigned long rates[MAX_STEPS]        = {0};
+    int client_count                      = 4;
+    int rate_count                        = 1;
+    unsigned long step_s                  = 5;
+    const char *socket_path               = SOCKET_PATH;
+    bool csv                              = false;
+    bool usage                            = false;
+
+    for (int i = 1; i < argc && !usage; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+            continue;
+        }
+        if (value == NULL)
+        {
+            usage = true;
+        }
+        else if (strcmp(argv[i], "--s7") == 0)
+        {
+            usage = !parse_target(value, 102, &config.targets[PROTOCOL_S7]);
+        }
+        else if (strcmp(argv[i], "--modbus") == 0)
+        {
+            usage = !parse_target(value, 502, &config.targets[PROTOCOL_MODBUS]);
+        }
+        else if (strcmp(argv[i], "--clients") == 0)
+        {
+            client_count = parse_list(value, client_steps, MAX_STEPS);
+            usage        = client_count <= 0;
+        }
+        else if (strcmp(argv[i], "--rates") == 0)
+        {
+            rate_count = parse_list(value, rates, MAX_STEPS);
+            usage      = rate_count <= 0;
+        }
+        else if (strcmp(argv[i], "--step-s") == 0)
+        {
+            step_s = bench_parse_count(argv[i], value);
+        }
+        else if (strcmp(argv[i], "--writes-percent") == 0)
+        {
+            config.writes_percent = (unsigned)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(argv[i], "--s7-db") == 0)
+        {
+            config.s7_db = (int)bench_parse_count(argv[i], value);
+        }
+        else if (strcmp(argv[i], "--s7-size") == 0)
+        {
+            config.s7_size = (int)bench_parse_count(argv[i], value);
+        }
+        else if (strcmp(argv[i], "--modbus-start") == 0)
+        {
+            config.modbus_start = (int)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(argv[i], "--modbus-count") == 0)
+        {
+            config.modbus_count = (int)bench_parse_count(argv[i], value);
+        }
+        else if (strcmp(argv[i], "--socket") == 0)
+        {
+            socket_path = value;
+        }
+        else
+        {
+            usage = true;
+        }
+        i++;
+    }
+    for (int c = 0; c < client_count; c++)
+    {
+        usage = usage || client_steps[c] == 0 || client_steps[c] > MAX_CLIENTS_PER_PROTOCOL;
+    }
+    if (usage || (!config.targets[PROTOCOL_S7].enabled && !config.targets[PROTOCOL_MODBUS].enabled))
+    {
+        fprintf(stderr,
+                "Usage: %s [--s7 HOST[:PORT]] [--modbus HOST[:PORT]] [--clients LIST] "
+                "[--rates LIST]\n"
+                "       [--step-s N] [--writes-percent N] [--s7-db N] [--s7-size N]\n"
+                "       [--modbus-start N] [--modbus-count N] [--socket PATH] [--csv]\n"
+                "At least one of --s7 and --modbus is required, with 1-%d clients per step\n",
+                argv[0], MAX_CLIENTS_PER_PROTOCOL);
+        return 2;
+    }
+    if (config.writes_percent > 100 || config.s7_size > 65536 || config.modbus_count < 1 ||
+        config.modbus_count > MODBUS_MAX_REGISTERS ||
+        config.modbus_start + config.modbus_count > 65536)
+    {
+        fprintf(stderr, "writes-percent must be 0-100, s7-size at most 65536 and modbus-count "
+                        "1-%d within the register space\n",
+                MODBUS_MAX_REGISTERS);
+        return 2;
+    }
+
+    int runtime = runtime_connect(socket_path);
+    char response[64];
+    if (runtime < 0 || !runtime_command(runtime, "STATUS", response, sizeof(response)))
+    {
+        fprintf(stderr,
+                "Cannot reach the runtime on %s: it must be running with no more than "
+                "%d other socket clients\n",
+                socket_path, MAX_CLIENTS - 1);
+        return 1;
+    }
+    if (strcmp(response, "STATUS:RUNNING\n") != 0)
+    {
+        fprintf(stderr, "The runtime is not running a program (%.*s)\n",
+                (int)strcspn(response, "\n"), response);
+        close(runtime);
+        return 1;
+    }
+
+    if (!csv)
+    {
+        printf("load: %d client steps x %d rate steps, %lu s each, %u%% writes; "
+               "request latency in us, runtime latency and scan time in us\n",
+               client_count, rate_count, step_s, config.writes_percent);
+    }
+    print_header(csv);
+    for (int c = 0; c < client_count; c++)
+    {
+        for (int r = 0; r < rate_count; r++)
+        {
+            if (!run_step(runtime, &config, client_steps[c], rates[r], step_s, csv))
+            {
+                fprintf(stderr, "The runtime stopped answering on %s\n", socket_path);
+                close(runtime);
+                return 1;
+            }
+        }
+    }
+    close(runtime);
+    return 0;
+}
@@ -1,6 +1,11 @@
 # tests/pytest/test_logger_buffer.py
+import logging
+import threading
+
 import pytest
 
+from webserver.logger import BufferHandler, JsonFormatter
+
 def test_buffer_stores_logs(test_logger):
     logger, buffer = test_logger
     logger.info("Hello World")
@@ -67,3 +72,61 @@ def test_filter_logs_by_min_id(test_logger):
     assert "Log 2" in logs[0]["message"]
     assert "Log 3" in logs[1]["message"]
 
+
+def test_ring_drops_oldest_logs():
+    handler = BufferHandler(capacity=3)
+    handler.setFormatter(JsonFormatter())
+    ring_logger = logging.getLogger("ring_logger")
+    ring_logger.propagate = False
+    ring_logger.addHandler(handler)
+    try:
+        for i in range(5):
+            ring_logger.error("Log %d", i)
+        logs = handler.get_logs()
+        assert [log["message"] for log in logs] == ["Log 2", "Log 3", "Log 4"]
+        assert handler.get_logs(min_id=logs[1]["id"]) == logs[1:]
+        assert handler.get_logs(count=1) == logs[2:]
+        assert len(handler) == 3
+    finally:
+        ring_logger.removeHandler(handler)
+
+def test_level_filter_skips_dropped_logs():
+    handler = BufferHandler(capacity=2)
+    handler.setFormatter(JsonFormatter())
+    ring_logger = logging.getLogger("level_ring_logger")
+    ring_logger.propagate = False
+    ring_logger.setLevel(logging.DEBUG)
+    ring_logger.addHandler(handler)
+    try:
+        ring_logger.error("Old error")
+        ring_logger.info("Info 1")
+        ring_logger.info("Info 2")
+        assert handler.get_logs(level="ERROR") == []
+        assert len(handler.get_logs(level="INFO")) == 2
+    finally:
+        ring_logger.removeHandler(handler)
+
+def test_logs_are_normalized_when_stored(test_logger):
+    logger, buffer = test_logger
+    logger.info("Normalized")
+    log = buffer.get_logs()[0]
+    assert "." not in log["timestamp"]
+    # Callers get copies
+    log["message"] = "changed"
+    assert buffer.get_logs()[0]["message"] == "Normalized"
+
+def test_wait_returns_new_log(test_logger):
+    logger, buffer = test_logger
+    logger.info("First")
+    last_id = buffer.get_logs()[-1]["id"]
+    timer = threading.Timer(0.05, logger.info, args=("Second",))
+    timer.start()
+    logs = buffer.get_logs(min_id=last_id + 1, wait=2.0)
+    timer.join()
+    assert [log["message"] for log in logs] == ["Second"]
+
+def test_wait_times_out_without_logs(test_logger):
+    logger, buffer = test_logger
+    logger.info("Only")
+    last_id = buffer.get_logs()[-1]["id"]
+    assert buffer.get_logs(min_id=last_id + 1, wait=0.05) == []
@@ -0,0 +1,59 @@
+# tests/test_modbus_master_utils.py
+from types import SimpleNamespace
+
+from core.src.drivers.plugins.python.modbus_master.modbus_master_utils import (
+    MAX_READ_REGISTERS,
+    plan_read_blocks,
+)
+
+
+def make_point(fc, length, size="W", cycle_time_ms=100):
+    return SimpleNamespace(
+        fc=fc,
+        length=length,
+        iec_location=SimpleNamespace(size=size),
+        cycle_time_ms=cycle_time_ms,
+    )
+
+def test_plan_read_blocks_merges_contiguous_registers():
+    points = [(make_point(3, 1), address) for address in range(60)]
+    blocks = plan_read_blocks(points, 100)
+    assert len(blocks) == 1
+    assert (blocks[0].address, blocks[0].count) == (0, 60)
+    assert [index for _, index, _ in blocks[0].members] == list(range(60))
+
+def test_plan_read_blocks_slices_multi_register_points():
+    points = [(make_point(4, 2, size="D"), 10), (make_point(4, 1), 14)]
+    blocks = plan_read_blocks(points, 100)
+    assert len(blocks) == 1
+    assert blocks[0].count == 5
+    assert [(index, count) for _, index, count in blocks[0].members] == [(0, 4), (4, 1)]
+
+def test_plan_read_blocks_respects_gap():
+    points = [(make_point(3, 1), 0), (make_point(3, 1), 3)]
+    assert len(plan_read_blocks(points, 100)) == 2
+    blocks = plan_read_blocks(points, 100, max_gap=2)
+    assert len(blocks) == 1
+    assert blocks[0].count == 4
+    assert blocks[0].members[1][1] == 3
+
+def test_plan_read_blocks_splits_by_fc_and_cycle():
+    points = [
+        (make_point(3, 1), 0),
+        (make_point(4, 1), 1),
+        (make_point(3, 1, cycle_time_ms=200), 1),
+        (make_point(16, 1), 2),  # Write point, not planned
+    ]
+    blocks = plan_read_blocks(points, 100)
+    assert sorted((b.fc, b.cycle_multiple) for b in blocks) == [(3, 1), (3, 2), (4, 1)]
+
+def test_plan_read_blocks_respects_request_limit():
+    points = [(make_point(3, 1), address) for address in range(130)]
+    blocks = plan_read_blocks(points, 100)
+    assert [(b.address, b.count) for b in blocks] == [(0, MAX_READ_REGISTERS), (125, 5)]
+
+def test_plan_read_blocks_bits():
+    points = [(make_point(1, 8, size="X"), 0), (make_point(1, 8, size="X"), 8)]
+    blocks = plan_read_blocks(points, 100)
+    assert len(blocks) == 1
+    assert blocks[0].count == 16
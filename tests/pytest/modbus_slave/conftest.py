@@ -56,6 +56,10 @@ class AdvancedObservingSBA:
             pass
 
     # FIX 2: Added public-facing mutex methods
+    def open_image_view(self, buffer_type):
+        # No zero-copy snapshot: the blocks fall back to per-element reads
+        return None, "Image views not supported by the mock"
+
     def acquire_mutex(self):
         self.lock()
 
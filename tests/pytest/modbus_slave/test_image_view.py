@@ -0,0 +1,144 @@
+# tests/pytest/modbus_slave/test_image_view.py
+from array import array
+
+from core.src.drivers.plugins.python.modbus_slave import simple_modbus
+
+
+class FakeImageView(array):
+    """Stands in for openplc_buffers.ImageView: a buffer plus valid()."""
+
+    def __new__(cls, typecode, values, valid=True):
+        view = super().__new__(cls, typecode, values)
+        view.is_valid = valid
+        return view
+
+    def valid(self):
+        return self.is_valid
+
+
+class ImageViewSBA:
+    """SafeBufferAccess double that only serves image views."""
+
+    def __init__(self, views):
+        self.views = views
+        self.is_valid = True
+        self.error_msg = ""
+        self.locks = 0
+        self.ranges = {}
+        self.range_reads = 0
+
+    def open_image_view(self, buffer_type):
+        return self.views.get(buffer_type), "Success"
+
+    def read_range(self, buffer_type, start_idx, count):
+        self.range_reads += 1
+        data = self.ranges.get(buffer_type)
+        if data is None or start_idx + count > len(data):
+            return None, "Invalid range"
+        return memoryview(data)[start_idx : start_idx + count], "Success"
+
+    def acquire_mutex(self):
+        self.locks += 1
+
+    def release_mutex(self):
+        pass
+
+    def read_int_input(self, index, thread_safe=True):
+        return 0, "Success"
+
+    def read_int_output(self, index, thread_safe=True):
+        return 0, "Success"
+
+    def read_int_memory(self, index, thread_safe=True):
+        return 0, "Success"
+
+
+def patch_sba(monkeypatch, sba):
+    monkeypatch.setattr(simple_modbus, "SafeBufferAccess", lambda args: sba)
+
+
+def test_input_registers_slice_the_snapshot(monkeypatch):
+    sba = ImageViewSBA({"int_input": FakeImageView("H", range(100, 132))})
+    patch_sba(monkeypatch, sba)
+    block = simple_modbus.OpenPLCInputRegistersDataBlock(None, num_registers=32)
+
+    assert block.getValues(3, 4) == [102, 103, 104, 105]
+    assert sba.locks == 0
+
+
+def test_discrete_inputs_unpack_snapshot_bits(monkeypatch):
+    sba = ImageViewSBA({"bool_input": FakeImageView("B", [0b10000001, 0b00000010])})
+    patch_sba(monkeypatch, sba)
+    block = simple_modbus.OpenPLCDiscreteInputsDataBlock(None, num_inputs=16)
+
+    assert block.getValues(7, 4) == [0, 1, 0, 1]
+    assert sba.locks == 0
+
+
+def test_holding_registers_use_the_segment_view(monkeypatch):
+    sba = ImageViewSBA(
+        {
+            "int_output": FakeImageView("H", [1, 2, 3, 4]),
+            "int_memory": FakeImageView("H", [10, 20, 30, 40]),
+        }
+    )
+    patch_sba(monkeypatch, sba)
+    block = simple_modbus.OpenPLCSegmentedHoldingRegistersDataBlock(
+        None, qw_count=4, mw_count=4, md_count=0, ml_count=0
+    )
+
+    assert block.getValues(2, 3) == [2, 3, 4]
+    assert block.getValues(6, 2) == [20, 30]
+    assert sba.locks == 0
+
+    # A request spanning both segments slices each of them
+    assert block.getValues(4, 2) == [4, 10]
+    assert sba.locks == 0
+
+
+def test_holding_registers_split_dint_and_lint(monkeypatch):
+    sba = ImageViewSBA(
+        {
+            "int_memory": FakeImageView("H", [7, 8]),
+            "dint_memory": FakeImageView("I", [0x00010002, 0x00030004]),
+            "lint_memory": FakeImageView("Q", [0x0001000200030004]),
+        }
+    )
+    patch_sba(monkeypatch, sba)
+    block = simple_modbus.OpenPLCSegmentedHoldingRegistersDataBlock(
+        None, qw_count=0, mw_count=2, md_count=2, ml_count=1
+    )
+
+    # %MW1, %MD0-1, %ML0 and one address past the end
+    assert block.getValues(2, 10) == [8, 1, 2, 3, 4, 1, 2, 3, 4, 0]
+    # Starting in the low word of %MD0
+    assert block.getValues(4, 2) == [2, 3]
+
+    low_first = simple_modbus.OpenPLCSegmentedHoldingRegistersDataBlock(
+        None, qw_count=0, mw_count=0, md_count=2, ml_count=1, word_order="low_word_first"
+    )
+    assert low_first.getValues(1, 8) == [2, 1, 4, 3, 4, 3, 2, 1]
+    assert sba.locks == 0
+
+
+def test_segmented_coils_without_view_read_ranges(monkeypatch):
+    sba = ImageViewSBA({})
+    sba.ranges = {
+        "bool_output": array("B", [0b00000001, 0b10000000]),
+        "bool_memory": array("B", [0b00000110]),
+    }
+    patch_sba(monkeypatch, sba)
+    block = simple_modbus.OpenPLCSegmentedCoilsDataBlock(None, qx_bits=16, mx_bits=8)
+
+    assert block.getValues(15, 5) == [0, 1, 0, 1, 1]
+    assert sba.range_reads == 2
+    assert sba.locks == 0
+
+
+def test_overwritten_snapshot_falls_back(monkeypatch):
+    sba = ImageViewSBA({"int_input": FakeImageView("H", range(32), valid=False)})
+    patch_sba(monkeypatch, sba)
+    block = simple_modbus.OpenPLCInputRegistersDataBlock(None, num_registers=32)
+
+    assert block.getValues(1, 2) == [0, 0]
+    assert sba.locks == 1
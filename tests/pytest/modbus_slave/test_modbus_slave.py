@@ -66,6 +66,10 @@ class ObservingSafeBufferAccess:
     # -------------------------
     # Lock handling
     # -------------------------
+    def open_image_view(self, buffer_type):
+        # No zero-copy snapshot: the blocks fall back to per-element reads
+        return None, "Image views not supported by the mock"
+
     def acquire_mutex(self):
         self._lock.acquire()
         self.acquire_count += 1
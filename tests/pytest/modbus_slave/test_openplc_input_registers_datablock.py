@@ -40,6 +40,10 @@ class AdvancedObservingSBA:
         self.fail_read = set(fail_read_indices or [])
 
     # mutex methods the real SBA exposes
+    def open_image_view(self, buffer_type):
+        # No zero-copy snapshot: the blocks fall back to per-element reads
+        return None, "Image views not supported by the mock"
+
     def acquire_mutex(self):
         # No real locking in tests (keeps tests non-blocking),
         # but record the call so tests can assert it happened.
@@ -0,0 +1,133 @@
+# tests/pytest/shared/test_access_plan.py
+import ctypes
+from types import SimpleNamespace
+
+from core.src.drivers.plugins.python.shared.access_plan import AccessPlan
+from core.src.drivers.plugins.python.shared.buffer_accessor import GenericBufferAccessor
+from core.src.drivers.plugins.python.shared.buffer_validator import BufferValidator
+from core.src.drivers.plugins.python.shared.mutex_manager import MutexManager
+
+WIDTHS = {0: 1, 1: 1, 4: 1, 6: 2, 10: 4, 12: 8}
+
+
+class FakeRuntime(SimpleNamespace):
+    """Packed image areas and a journal log standing in for the runtime."""
+
+    def __init__(self, snapshot=True):
+        super().__init__(buffer_size=1024, bits_per_buffer=8, buffer_mutex=1, locks=0)
+        self.images = {t: bytearray(1024 * w) for t, w in WIDTHS.items()}
+        self.journal = []
+        self.snapshot = snapshot
+        self.snapshot_calls = 0
+
+    def mutex_take(self, _):
+        self.locks += 1
+        return 0
+
+    def mutex_give(self, _):
+        return 0
+
+    def read_image_snapshot(self, journal_type, start, count, dest):
+        self.snapshot_calls += 1
+        if not self.snapshot:
+            return -1
+        width = WIDTHS[journal_type]
+        data = bytes(self.images[journal_type][start * width:(start + count) * width])
+        ctypes.memmove(dest, data, len(data))
+        return count
+
+    def journal_write_range(self, journal_type, start, count, values):
+        width = WIDTHS[journal_type]
+        self.journal.append(("range", start, ctypes.string_at(values, count * width)))
+        return 0
+
+    def journal_write_bool(self, _journal_type, index, bit, value):
+        self.journal.append(("bool", index, bit, value))
+        return 0
+
+
+def make_plan(runtime):
+    validator = BufferValidator(runtime)
+    accessor = GenericBufferAccessor(runtime, validator, MutexManager(runtime))
+    return AccessPlan(accessor, validator)
+
+
+def test_read_copies_each_area_once():
+    runtime = FakeRuntime()
+    runtime.images[6][4:8] = (0x1234).to_bytes(2, "little") + (0xBEEF).to_bytes(2, "little")
+    runtime.images[6][20:22] = (7).to_bytes(2, "little")
+    runtime.images[1][3] = 0b10100000
+    runtime.images[1][4] = 0b00000001
+
+    plan = make_plan(runtime)
+    words, _ = plan.add("int_output", 2, None, 2)
+    word, _ = plan.add("int_output", 10)
+    bits, _ = plan.add("bool_output", 3, 5, 4)
+
+    assert plan.read() == (True, "Success")
+    assert runtime.snapshot_calls == 2
+    assert runtime.locks == 0
+    assert plan.values(words) == [0x1234, 0xBEEF]
+    assert plan.values(word) == [7]
+    assert plan.values(bits) == [True, False, True, True]
+    assert plan.view(words).tolist() == [0x1234, 0xBEEF]
+    assert plan.view(bits) is None
+
+
+def test_read_falls_back_to_pointer_tables():
+    runtime = FakeRuntime(snapshot=False)
+    runtime.int_output = [None] * 1024
+    runtime.int_output[5] = SimpleNamespace(contents=SimpleNamespace(value=42))
+
+    plan = make_plan(runtime)
+    slot, _ = plan.add("int_output", 4, None, 2)
+
+    assert plan.read() == (True, "Success")
+    assert runtime.locks == 1
+    assert plan.values(slot) == [0, 42]
+
+
+def test_add_rejects_out_of_range_points():
+    plan = make_plan(FakeRuntime())
+    assert plan.add("int_output", 1023, None, 2)[0] is None
+    assert plan.add("bool_input", 1023, 7, 2)[0] is None
+    assert plan.add("bool_input", 0, None, 1)[0] is None
+    assert plan.add("unknown", 0)[0] is None
+    assert len(plan) == 0
+
+
+def test_write_journals_one_range_per_point():
+    runtime = FakeRuntime()
+    plan = make_plan(runtime)
+    slot, _ = plan.add("dint_memory", 3, None, 2)
+
+    assert plan.write(slot, [1, 0x1FFFFFFFF]) == (True, "Success")
+    assert runtime.journal == [
+        ("range", 3, (1).to_bytes(4, "little") + (0xFFFFFFFF).to_bytes(4, "little"))
+    ]
+
+
+def test_write_bits_uses_ranges_for_whole_bytes():
+    runtime = FakeRuntime()
+    plan = make_plan(runtime)
+    slot, _ = plan.add("bool_input", 0, 6, 20)
+    values = [True, False] + [True] * 8 + [False, True] * 5
+
+    assert plan.write(slot, values) == (True, "Success")
+    assert runtime.journal == [
+        ("bool", 0, 6, 1),
+        ("bool", 0, 7, 0),
+        ("range", 1, bytes([0xFF, 0b10101010])),
+        ("bool", 3, 0, 0),
+        ("bool", 3, 1, 1),
+    ]
+
+
+def test_write_partial_values_updates_leading_bits():
+    runtime = FakeRuntime()
+    plan = make_plan(runtime)
+    slot, _ = plan.add("bool_output", 2, 0, 16)
+
+    assert plan.write(slot, [True, True, False]) == (True, "Success")
+    assert runtime.journal == [("bool", 2, 0, 1), ("bool", 2, 1, 1), ("bool", 2, 2, 0)]
+
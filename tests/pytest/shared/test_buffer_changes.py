@@ -0,0 +1,95 @@
+# tests/pytest/shared/test_buffer_changes.py
+import ctypes
+from types import SimpleNamespace
+
+from core.src.drivers.plugins.python.shared.buffer_accessor import GenericBufferAccessor
+from core.src.drivers.plugins.python.shared.buffer_validator import BufferValidator
+from core.src.drivers.plugins.python.shared.mutex_manager import MutexManager
+
+INT_OUTPUT = 6
+
+
+class FakeRuntime(SimpleNamespace):
+    """One INT output area whose snapshot generation the test advances."""
+
+    def __init__(self):
+        super().__init__(buffer_size=1024, bits_per_buffer=8, buffer_mutex=1)
+        self.values = [0] * 1024
+        self.changed = set()
+        self.generation = 1
+        self.available = True
+
+    def read_image_changes(self, journal_type, start, count, dest, changes, generation):
+        if not self.available:
+            return -1
+        since = generation._obj
+        assert journal_type == INT_OUTPUT
+        words = (ctypes.c_uint16 * count).from_address(dest)
+        bits = (ctypes.c_uint8 * ((count + 7) // 8)).from_address(changes)
+        for k in range(count):
+            words[k] = self.values[start + k]
+            if since.value == self.generation:
+                changed = False
+            elif since.value and since.value + 1 == self.generation:
+                changed = start + k in self.changed
+            else:
+                changed = True
+            if changed:
+                bits[k // 8] |= 1 << (k % 8)
+        since.value = self.generation
+        return count
+
+
+def make_accessor(runtime):
+    validator = BufferValidator(runtime)
+    return GenericBufferAccessor(runtime, validator, MutexManager(runtime))
+
+
+def changed_indexes(changes, count):
+    return [k for k in range(count) if changes[k // 8] & (1 << (k % 8))]
+
+
+def test_first_read_reports_every_element():
+    runtime = FakeRuntime()
+    accessor = make_accessor(runtime)
+    dest = (ctypes.c_uint16 * 10)()
+    changes = (ctypes.c_uint8 * 2)()
+
+    generation, msg = accessor.read_buffer_changes_into("int_output", 0, dest, changes, 0)
+
+    assert (generation, msg) == (1, "Success")
+    assert changed_indexes(changes, 10) == list(range(10))
+
+
+def test_next_read_reports_the_changes_of_the_scan():
+    runtime = FakeRuntime()
+    accessor = make_accessor(runtime)
+    dest = (ctypes.c_uint16 * 10)()
+    changes = (ctypes.c_uint8 * 2)()
+    runtime.values[13] = 500
+    runtime.changed = {13}
+    runtime.generation = 2
+
+    generation, _ = accessor.read_buffer_changes_into("int_output", 10, dest, changes, 1)
+
+    assert generation == 2
+    assert dest[3] == 500
+    assert changed_indexes(changes, 10) == [3]
+
+
+def test_unavailable_changes_return_none():
+    runtime = FakeRuntime()
+    runtime.available = False
+    accessor = make_accessor(runtime)
+    dest = (ctypes.c_uint16 * 4)()
+    changes = (ctypes.c_uint8 * 1)()
+
+    generation, msg = accessor.read_buffer_changes_into("int_output", 0, dest, changes, 0)
+
+    assert generation is None
+    assert msg == "Image changes not available yet"
+
+    runtime.read_image_changes = None
+    generation, msg = accessor.read_buffer_changes_into("int_output", 0, dest, changes, 0)
+    assert generation is None
+    assert msg == "Image changes are not provided by the runtime"
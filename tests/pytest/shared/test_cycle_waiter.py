@@ -0,0 +1,67 @@
+# tests/pytest/shared/test_cycle_waiter.py
+import threading
+from types import SimpleNamespace
+
+from core.src.drivers.plugins.python.shared.cycle_waiter import CycleToken, CycleWaiter
+
+
+class FakeSignal:
+    """Replays wait_cycle results: (cycle, generation, missed) tuples, 0 or -1."""
+
+    def __init__(self, results):
+        self.results = list(results)
+        self.timeouts = []
+
+    def wait_cycle(self, signal, timeout_ms, token_ref):
+        assert signal == 0x1000
+        self.timeouts.append(timeout_ms)
+        result = self.results.pop(0) if self.results else 0
+        if isinstance(result, tuple):
+            token = token_ref._obj
+            token.cycle, token.generation, token.missed = result
+            return 1
+        return result
+
+
+def make_waiter(results):
+    fake = FakeSignal(results)
+    args = SimpleNamespace(cycle_signal=0x1000, wait_cycle=fake.wait_cycle)
+    return CycleWaiter(args), fake
+
+
+def test_wait_returns_tokens_and_counts_missed():
+    waiter, fake = make_waiter([(5, 40, 0), (8, 43, 2), 0])
+
+    assert waiter.wait() == (CycleToken(5, 40, 0), "Success")
+    assert waiter.wait(0.25) == (CycleToken(8, 43, 2), "Success")
+    assert waiter.wait(0.25) == (None, "Timeout")
+    assert fake.timeouts == [-1, 250, 250]
+    assert (waiter.cycles, waiter.missed) == (2, 2)
+
+
+def test_wait_reports_errors():
+    waiter, _ = make_waiter([-1])
+    token, msg = waiter.wait(1)
+    assert token is None
+    assert "failed" in msg
+
+
+def test_missing_signal_is_invalid():
+    waiter = CycleWaiter(SimpleNamespace(cycle_signal=None, wait_cycle=None))
+    assert not waiter.is_valid
+    assert waiter.wait(0) == (None, "Runtime provides no cycle signal")
+    assert waiter.run(lambda token: None, threading.Event())[0] is False
+
+
+def test_run_calls_back_once_per_token_until_stopped():
+    stop = threading.Event()
+    seen = []
+
+    def callback(token):
+        seen.append(token.cycle)
+        if token.cycle == 3:
+            stop.set()
+
+    waiter, _ = make_waiter([(1, 0, 0), 0, (3, 0, 1), (4, 0, 0)])
+    assert waiter.run(callback, stop) == (True, "Success")
+    assert seen == [1, 3]
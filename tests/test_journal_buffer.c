@@ -0,0 +1,344 @@
+#include "huge_pages.h"
+#include "journal_buffer.h"
+#include "unity.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+
+#define TEST_SIZE 16
+
+static pthread_mutex_t image_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static IEC_BOOL *bool_output_table[TEST_SIZE][8];
+static IEC_UINT *int_output_table[TEST_SIZE];
+static IEC_ULINT *lint_output_table[TEST_SIZE];
+static IEC_BOOL coils[TEST_SIZE][8];
+static IEC_UINT words[TEST_SIZE];
+static IEC_ULINT longs[TEST_SIZE];
+
+static journal_stats_t before;
+
+static void init_journal(bool coalescing)
+{
+    journal_buffer_ptrs_t ptrs;
+    memset(&ptrs, 0, sizeof(ptrs));
+    ptrs.bool_output = bool_output_table;
+    ptrs.int_output  = int_output_table;
+    ptrs.lint_output = lint_output_table;
+    ptrs.buffer_size = TEST_SIZE;
+    ptrs.image_mutex = &image_mutex;
+
+    journal_set_coalescing(coalescing);
+    TEST_ASSERT_EQUAL_INT(0, journal_init(&ptrs));
+    TEST_ASSERT_EQUAL(coalescing, journal_is_coalescing());
+}
+
+// The scan thread applies the journal with the image mutex held
+static void apply(void)
+{
+    pthread_mutex_lock(&image_mutex);
+    journal_apply_and_clear();
+    pthread_mutex_unlock(&image_mutex);
+}
+
+void setUp(void)
+{
+    memset(coils, 0, sizeof(coils));
+    memset(words, 0, sizeof(words));
+    memset(longs, 0, sizeof(longs));
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        for (int b = 0; b < 8; b++)
+        {
+            bool_output_table[i][b] = &coils[i][b];
+        }
+        int_output_table[i]  = &words[i];
+        lint_output_table[i] = &longs[i];
+    }
+
+    init_journal(false);
+
+    // The counters survive journal_init(); the tests compare against these
+    journal_get_stats(&before);
+}
+
+void tearDown(void)
+{
+    journal_cleanup();
+    journal_set_coalescing(false);
+}
+
+// Two producers take turns on the same addresses; each step waits for the
+// previous write so the sequence numbers are known
+typedef struct
+{
+    sem_t turn;
+    sem_t done;
+    uint16_t first;
+    uint16_t second;
+    uint32_t first_index;
+    uint32_t second_index;
+} producer_t;
+
+static void *producer_main(void *arg)
+{
+    producer_t *p = (producer_t *)arg;
+    sem_wait(&p->turn);
+    journal_write_int(JOURNAL_INT_OUTPUT, p->first_index, p->first);
+    sem_post(&p->done);
+    sem_wait(&p->turn);
+    journal_write_int(JOURNAL_INT_OUTPUT, p->second_index, p->second);
+    sem_post(&p->done);
+    // Keep the ring until told to exit
+    sem_wait(&p->turn);
+    return NULL;
+}
+
+static void producer_step(producer_t *p)
+{
+    sem_post(&p->turn);
+    sem_wait(&p->done);
+}
+
+void test_journal_apply_and_clear_TwoProducers_ShouldApplyInWriteOrder(void)
+{
+    // Write order: A %QW0, B %QW0, B %QW1, A %QW1. Applying one ring after
+    // the other, in either order, leaves one of the two addresses wrong.
+    producer_t a = {.first = 1, .first_index = 0, .second = 10, .second_index = 1};
+    producer_t b = {.first = 2, .first_index = 0, .second = 20, .second_index = 1};
+    pthread_t ta, tb;
+    sem_init(&a.turn, 0, 0);
+    sem_init(&a.done, 0, 0);
+    sem_init(&b.turn, 0, 0);
+    sem_init(&b.done, 0, 0);
+    pthread_create(&ta, NULL, producer_main, &a);
+    pthread_create(&tb, NULL, producer_main, &b);
+
+    producer_step(&a);
+    producer_step(&b);
+    producer_step(&b);
+    producer_step(&a);
+
+    // Apply while both producers still own their rings
+    TEST_ASSERT_EQUAL_size_t(4, journal_pending_count());
+    TEST_ASSERT_EQUAL_size_t(2, journal_producer_count());
+    apply();
+
+    sem_post(&a.turn);
+    sem_post(&b.turn);
+    pthread_join(ta, NULL);
+    pthread_join(tb, NULL);
+
+    TEST_ASSERT_EQUAL_UINT16(2, words[0]);
+    TEST_ASSERT_EQUAL_UINT16(10, words[1]);
+    TEST_ASSERT_EQUAL_size_t(0, journal_pending_count());
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.applies + 1, after.applies);
+    TEST_ASSERT_EQUAL_UINT64(4, after.last_applied);
+
+    // The next apply releases the retired rings
+    apply();
+    TEST_ASSERT_EQUAL_size_t(0, journal_producer_count());
+
+    sem_destroy(&a.turn);
+    sem_destroy(&a.done);
+    sem_destroy(&b.turn);
+    sem_destroy(&b.done);
+}
+
+void test_journal_write_int_RingFull_ShouldFlushWithoutLosingWrites(void)
+{
+    for (uint32_t i = 0; i < JOURNAL_MAX_ENTRIES; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, i % TEST_SIZE, (uint16_t)i));
+    }
+    TEST_ASSERT_EQUAL_UINT64(before.emergency_flushes, journal_emergency_flush_count());
+    TEST_ASSERT_EQUAL_size_t(JOURNAL_MAX_ENTRIES, journal_pending_count());
+
+    // One more write finds the ring full and applies it on the writer thread
+    TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, 0, 5000));
+    TEST_ASSERT_EQUAL_UINT64(before.emergency_flushes + 1, journal_emergency_flush_count());
+    TEST_ASSERT_EQUAL_size_t(1, journal_pending_count());
+    TEST_ASSERT_EQUAL_UINT16(JOURNAL_MAX_ENTRIES - 1, words[TEST_SIZE - 1]);
+
+    apply();
+    TEST_ASSERT_EQUAL_UINT16(5000, words[0]);
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.emergency_flushes + 1, after.emergency_flushes);
+    TEST_ASSERT_EQUAL_UINT64(before.entries_applied + JOURNAL_MAX_ENTRIES + 1, after.entries_applied);
+    TEST_ASSERT_EQUAL_UINT64(1, after.last_applied);
+    TEST_ASSERT_EQUAL_UINT64(before.rejected[JOURNAL_INT_OUTPUT], after.rejected[JOURNAL_INT_OUTPUT]);
+}
+
+void test_journal_write_range_ArenaFull_ShouldFlushAndCountDroppedElements(void)
+{
+    // Each range fills half the arena; only the first TEST_SIZE elements
+    // exist in the image tables
+    static IEC_ULINT values[1024];
+    for (size_t i = 0; i < 1024; i++)
+    {
+        values[i] = i + 1;
+    }
+    _Static_assert(sizeof(values) * 2 == JOURNAL_PAYLOAD_BYTES, "two ranges fill the arena");
+
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_LINT_OUTPUT, 0, 1024, values));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_LINT_OUTPUT, 0, 1024, values));
+    TEST_ASSERT_EQUAL_UINT64(before.emergency_flushes, journal_emergency_flush_count());
+
+    values[0] = 99;
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_LINT_OUTPUT, 0, 1024, values));
+    TEST_ASSERT_EQUAL_UINT64(before.emergency_flushes + 1, journal_emergency_flush_count());
+    TEST_ASSERT_EQUAL_size_t(1, journal_pending_count());
+    TEST_ASSERT_EQUAL_UINT64(1, longs[0]);
+
+    apply();
+    TEST_ASSERT_EQUAL_UINT64(99, longs[0]);
+    TEST_ASSERT_EQUAL_UINT64(TEST_SIZE, longs[TEST_SIZE - 1]);
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.dropped[JOURNAL_LINT_OUTPUT] + 3 * (1024 - TEST_SIZE),
+                             after.dropped[JOURNAL_LINT_OUTPUT]);
+    TEST_ASSERT_EQUAL_UINT64(before.rejected[JOURNAL_LINT_OUTPUT], after.rejected[JOURNAL_LINT_OUTPUT]);
+}
+
+void test_journal_write_Rejected_ShouldCountByType(void)
+{
+    uint16_t value = 1;
+    TEST_ASSERT_EQUAL_INT(-1, journal_write_range(JOURNAL_INT_OUTPUT, 0, 0, &value));
+    TEST_ASSERT_EQUAL_INT(-1, journal_write_range(JOURNAL_TYPE_COUNT, 0, 1, &value));
+
+    journal_cleanup();
+    TEST_ASSERT_EQUAL_INT(-1, journal_write_int(JOURNAL_INT_OUTPUT, 0, 1));
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.rejected[JOURNAL_INT_OUTPUT] + 2, after.rejected[JOURNAL_INT_OUTPUT]);
+    TEST_ASSERT_EQUAL_UINT64(before.rejected_invalid_type + 1, after.rejected_invalid_type);
+    TEST_ASSERT_EQUAL_UINT64(before.rejected_no_producer, after.rejected_no_producer);
+}
+
+void test_journal_write_int_Coalescing_ShouldKeepLastValuePerAddress(void)
+{
+    init_journal(true);
+
+    for (uint16_t v = 1; v <= 100; v++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, 3, v));
+    }
+    TEST_ASSERT_EQUAL_INT(0, journal_write_bool(JOURNAL_BOOL_OUTPUT, 2, 5, true));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_bool(JOURNAL_BOOL_OUTPUT, 2, 5, false));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_bool(JOURNAL_BOOL_OUTPUT, 2, 5, true));
+    TEST_ASSERT_EQUAL_size_t(2, journal_pending_count());
+
+    apply();
+
+    TEST_ASSERT_EQUAL_UINT16(100, words[3]);
+    TEST_ASSERT_EQUAL_UINT8(1, coils[2][5]);
+    TEST_ASSERT_EQUAL_size_t(0, journal_pending_count());
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(2, after.last_applied);
+    TEST_ASSERT_EQUAL_UINT64(before.entries_applied + 2, after.entries_applied);
+    TEST_ASSERT_EQUAL_UINT64(before.emergency_flushes, after.emergency_flushes);
+}
+
+void test_journal_write_range_AcrossImageEnd_ShouldApplyInsideAndDropRest(void)
+{
+    uint16_t values[4] = {11, 12, 13, 14};
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_INT_OUTPUT, TEST_SIZE - 2, 4, values));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_INT_OUTPUT, TEST_SIZE + 4, 2, values));
+
+    apply();
+
+    TEST_ASSERT_EQUAL_UINT16(0, words[TEST_SIZE - 3]);
+    TEST_ASSERT_EQUAL_UINT16(11, words[TEST_SIZE - 2]);
+    TEST_ASSERT_EQUAL_UINT16(12, words[TEST_SIZE - 1]);
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.dropped[JOURNAL_INT_OUTPUT] + 2 + 2, after.dropped[JOURNAL_INT_OUTPUT]);
+}
+
+void test_journal_write_range_AcrossImageEndCoalescing_ShouldDropRest(void)
+{
+    init_journal(true);
+
+    uint16_t values[4] = {11, 12, 13, 14};
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_INT_OUTPUT, TEST_SIZE - 2, 4, values));
+
+    apply();
+
+    TEST_ASSERT_EQUAL_UINT16(11, words[TEST_SIZE - 2]);
+    TEST_ASSERT_EQUAL_UINT16(12, words[TEST_SIZE - 1]);
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.dropped[JOURNAL_INT_OUTPUT] + 2, after.dropped[JOURNAL_INT_OUTPUT]);
+}
+
+void test_journal_apply_and_clear_Empty_ShouldNotCountAnApply(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, 1, 42));
+    apply();
+    journal_get_stats(&before);
+
+    apply();
+    apply();
+
+    journal_stats_t after;
+    journal_get_stats(&after);
+    TEST_ASSERT_EQUAL_UINT64(before.applies, after.applies);
+    TEST_ASSERT_EQUAL_UINT64(before.entries_applied, after.entries_applied);
+    TEST_ASSERT_EQUAL_UINT64(1, after.last_applied);
+    TEST_ASSERT_EQUAL_UINT64(before.apply_ns_total, after.apply_ns_total);
+    TEST_ASSERT_EQUAL_UINT16(42, words[1]);
+}
+
+void test_journal_track_writes_AppliedWrites_ShouldMarkTheirIndexes(void)
+{
+    uint64_t bits[1]    = {0};
+    uint64_t summary[1] = {0};
+    journal_write_map_t map = {bits, summary};
+    TEST_ASSERT_EQUAL_INT(0, journal_track_writes(JOURNAL_INT_OUTPUT, &map));
+
+    uint16_t values[3] = {1, 2, 3};
+    TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, 1, 42));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_INT_OUTPUT, TEST_SIZE - 1, 3, values));
+    TEST_ASSERT_EQUAL_UINT64(0, bits[0]);
+
+    apply();
+    TEST_ASSERT_EQUAL_INT(0, journal_track_writes(JOURNAL_INT_OUTPUT, NULL));
+
+    // Only the indexes inside the image
+    TEST_ASSERT_EQUAL_UINT64((1ULL << 1) | (1ULL << (TEST_SIZE - 1)), bits[0]);
+    TEST_ASSERT_EQUAL_UINT64(1, summary[0]);
+}
+
+void test_journal_init_PendingEntries_ShouldDiscardThemAndKeepCounting(void)
+{
+    uint16_t values[2] = {21, 22};
+    TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, 1, 5));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_INT_OUTPUT, 2, 2, values));
+    uint32_t sequence = journal_get_sequence();
+
+    journal_cleanup();
+    init_journal(false);
+    TEST_ASSERT_EQUAL_UINT32(sequence, journal_get_sequence());
+
+    TEST_ASSERT_EQUAL_INT(0, journal_write_int(JOURNAL_INT_OUTPUT, 1, 7));
+    TEST_ASSERT_EQUAL_INT(0, journal_write_range(JOURNAL_INT_OUTPUT, 4, 2, values));
+    apply();
+
+    TEST_ASSERT_EQUAL_UINT16(7, words[1]);
+    TEST_ASSERT_EQUAL_UINT16(0, words[2]);
+    TEST_ASSERT_EQUAL_UINT16(0, words[3]);
+    TEST_ASSERT_EQUAL_UINT16(21, words[4]);
+    TEST_ASSERT_EQUAL_UINT16(22, words[5]);
+    TEST_ASSERT_EQUAL_UINT64(0, journal_pending_count());
+}
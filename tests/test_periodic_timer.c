@@ -0,0 +1,156 @@
+#include "unity.h"
+#include "utils.h"
+
+#define TEST_PERIOD_NS 2000000ull // 2ms
+
+// utils.c logs through log.c, which needs the whole runtime; stub it out
+void log_info(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+void log_error(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+// Simulated PLC_CLOCK: time only moves when a test or the timer's sleep moves it
+static uint64_t fake_now;
+static unsigned int fake_sleeps;
+
+static uint64_t fake_now_ns(void *ctx)
+{
+    (void)ctx;
+    return fake_now;
+}
+
+static void fake_sleep_until_ns(void *ctx, uint64_t deadline_ns)
+{
+    (void)ctx;
+    fake_sleeps++;
+    if (fake_now < deadline_ns)
+    {
+        fake_now = deadline_ns;
+    }
+}
+
+static const periodic_clock_t fake_clock = {fake_now_ns, fake_sleep_until_ns, NULL};
+
+void setUp(void)
+{
+    fake_now    = 1000000000ull;
+    fake_sleeps = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_scheduler_parse_overrun_policy_ShouldAcceptKnownPolicies(void)
+{
+    scheduler_config_t config = {.policy = OVERRUN_POLICY_SKIP, .max_catch_up = 1};
+
+    TEST_ASSERT_EQUAL_INT(0, scheduler_parse_overrun_policy("degrade", &config));
+    TEST_ASSERT_EQUAL_INT(OVERRUN_POLICY_DEGRADE, config.policy);
+
+    TEST_ASSERT_EQUAL_INT(0, scheduler_parse_overrun_policy("catch-up", &config));
+    TEST_ASSERT_EQUAL_INT(OVERRUN_POLICY_CATCH_UP, config.policy);
+    TEST_ASSERT_EQUAL_UINT(1, config.max_catch_up);
+
+    TEST_ASSERT_EQUAL_INT(0, scheduler_parse_overrun_policy("catch-up:5", &config));
+    TEST_ASSERT_EQUAL_UINT(5, config.max_catch_up);
+
+    TEST_ASSERT_EQUAL_INT(0, scheduler_parse_overrun_policy("skip", &config));
+    TEST_ASSERT_EQUAL_INT(OVERRUN_POLICY_SKIP, config.policy);
+}
+
+void test_scheduler_parse_overrun_policy_ShouldRejectInvalidText(void)
+{
+    scheduler_config_t config = {.policy = OVERRUN_POLICY_SKIP, .max_catch_up = 1};
+
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_parse_overrun_policy("burst", &config));
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_parse_overrun_policy("catch-up:", &config));
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_parse_overrun_policy("catch-up:0", &config));
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_parse_overrun_policy("catch-upx", &config));
+
+    // Config is left untouched on failure
+    TEST_ASSERT_EQUAL_INT(OVERRUN_POLICY_SKIP, config.policy);
+}
+
+void test_periodic_timer_wait_OnTime_ShouldNotSkip(void)
+{
+    scheduler_config_t config = {.policy = OVERRUN_POLICY_SKIP, .max_catch_up = 1};
+    periodic_timer_t timer;
+
+    periodic_timer_start_on(&timer, TEST_PERIOD_NS, &config, &fake_clock);
+    uint64_t first_slot = timer.next_ns;
+    TEST_ASSERT_EQUAL_UINT64(fake_now, first_slot);
+
+    for (int i = 0; i < 3; i++)
+    {
+        // The cycle takes part of its slot
+        fake_now += TEST_PERIOD_NS / 2;
+        TEST_ASSERT_EQUAL_UINT64(0, periodic_timer_wait(&timer));
+        TEST_ASSERT_EQUAL_UINT64(first_slot + (i + 1) * TEST_PERIOD_NS, fake_now);
+    }
+
+    // Deadlines stay on the absolute grid
+    TEST_ASSERT_EQUAL_UINT64(first_slot + 3 * TEST_PERIOD_NS, timer.next_ns);
+    TEST_ASSERT_EQUAL_UINT(3, fake_sleeps);
+}
+
+void test_periodic_timer_wait_Skip_ShouldJumpToNextFreeSlot(void)
+{
+    scheduler_config_t config = {.policy = OVERRUN_POLICY_SKIP, .max_catch_up = 1};
+    periodic_timer_t timer;
+
+    periodic_timer_start_on(&timer, TEST_PERIOD_NS, &config, &fake_clock);
+    uint64_t first_slot = timer.next_ns;
+
+    fake_now += TEST_PERIOD_NS * 3 + TEST_PERIOD_NS / 2;
+
+    // Slots 1 to 3 passed during the cycle, the next one is slot 4
+    TEST_ASSERT_EQUAL_UINT64(3, periodic_timer_wait(&timer));
+    TEST_ASSERT_EQUAL_UINT64(first_slot + 4 * TEST_PERIOD_NS, timer.next_ns);
+    TEST_ASSERT_EQUAL_UINT64(timer.next_ns, fake_now);
+}
+
+void test_periodic_timer_wait_CatchUp_ShouldRunLateCyclesUpToLimit(void)
+{
+    scheduler_config_t config = {.policy = OVERRUN_POLICY_CATCH_UP, .max_catch_up = 2};
+    periodic_timer_t timer;
+
+    periodic_timer_start_on(&timer, TEST_PERIOD_NS, &config, &fake_clock);
+    uint64_t first_slot = timer.next_ns;
+
+    fake_now += TEST_PERIOD_NS * 5 + TEST_PERIOD_NS / 2;
+
+    // Two late cycles are allowed back-to-back without sleeping
+    TEST_ASSERT_EQUAL_UINT64(0, periodic_timer_wait(&timer));
+    TEST_ASSERT_EQUAL_UINT64(0, periodic_timer_wait(&timer));
+    TEST_ASSERT_EQUAL_UINT(0, fake_sleeps);
+
+    // Then slots 3 to 5 are skipped and the timer waits for slot 6
+    TEST_ASSERT_EQUAL_UINT64(3, periodic_timer_wait(&timer));
+    TEST_ASSERT_EQUAL_UINT64(first_slot + 6 * TEST_PERIOD_NS, timer.next_ns);
+    TEST_ASSERT_EQUAL_UINT(1, fake_sleeps);
+}
+
+void test_periodic_timer_wait_Degrade_ShouldDoublePeriodAfterOverrun(void)
+{
+    scheduler_config_t config = {.policy = OVERRUN_POLICY_DEGRADE, .max_catch_up = 1};
+    periodic_timer_t timer;
+
+    periodic_timer_start_on(&timer, TEST_PERIOD_NS, &config, &fake_clock);
+    uint64_t first_slot = timer.next_ns;
+
+    fake_now += TEST_PERIOD_NS * 2 + TEST_PERIOD_NS / 2;
+    TEST_ASSERT_EQUAL_UINT64(2, periodic_timer_wait(&timer));
+    TEST_ASSERT_EQUAL_UINT(2, timer.degrade_factor);
+    TEST_ASSERT_EQUAL_UINT64(first_slot + 3 * TEST_PERIOD_NS, timer.next_ns);
+
+    // With the doubled period every on-time cycle covers two slots
+    TEST_ASSERT_EQUAL_UINT64(1, periodic_timer_wait(&timer));
+    TEST_ASSERT_EQUAL_UINT64(first_slot + 5 * TEST_PERIOD_NS, timer.next_ns);
+    TEST_ASSERT_EQUAL_UINT(2, timer.degrade_factor);
+}
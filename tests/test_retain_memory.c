@@ -0,0 +1,344 @@
+#include "iec_types.h"
+#include "journal_buffer.h"
+#include "retain_memory.h"
+#include "unity.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAX_TEST_SIZE 1024
+
+// image_tables.c needs the program loader; the tests own the memory areas
+IEC_UINT **int_memory;
+IEC_UDINT **dint_memory;
+IEC_ULINT **lint_memory;
+
+static IEC_UINT *int_table[MAX_TEST_SIZE];
+static IEC_UDINT *dint_table[MAX_TEST_SIZE];
+static IEC_ULINT *lint_table[MAX_TEST_SIZE];
+static IEC_UINT words[MAX_TEST_SIZE];
+static IEC_UDINT dwords[MAX_TEST_SIZE];
+static IEC_ULINT lwords[MAX_TEST_SIZE];
+
+static size_t table_size;
+static char path[] = "/tmp/test_retain_XXXXXX";
+
+// Checkpoints go through this msync. A failing one also loses the range it
+// was asked to write, like pages that never reached the disk.
+static bool msync_fails;
+static int msync_failures;
+
+int msync(void *addr, size_t length, int flags)
+{
+    (void)flags;
+    if (msync_fails)
+    {
+        memset(addr, 0, length);
+        msync_failures++;
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+size_t image_tables_size(void)
+{
+    return table_size;
+}
+
+// The program binds indexes 0 to bound_slots - 1 of every memory area
+static size_t bound_slots;
+
+size_t image_tables_bound_slots(uint32_t table, uint32_t *slots, size_t max)
+{
+    (void)table;
+    size_t count = bound_slots < table_size ? bound_slots : table_size;
+    for (size_t i = 0; slots != NULL && i < count && i < max; i++)
+    {
+        slots[i] = (uint32_t)i;
+    }
+    return count;
+}
+
+// Write maps retain registered, marked like journal writes do
+static journal_write_map_t *write_maps[JOURNAL_TYPE_COUNT];
+
+int journal_track_writes(journal_buffer_type_t type, journal_write_map_t *map)
+{
+    write_maps[type] = map;
+    return 0;
+}
+
+static void journal_written(journal_buffer_type_t type, size_t index)
+{
+    TEST_ASSERT_NOT_NULL(write_maps[type]);
+    write_maps[type]->bits[index / 64] |= 1ULL << (index % 64);
+    write_maps[type]->summary[index / 4096] |= 1ULL << ((index / 64) % 64);
+}
+
+void log_info(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+void log_warn(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+void log_error(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+static void set_values(IEC_UINT base)
+{
+    for (size_t i = 0; i < MAX_TEST_SIZE; i++)
+    {
+        words[i]  = (IEC_UINT)(base + i);
+        dwords[i] = (IEC_UDINT)(base + i) * 1000u;
+        lwords[i] = (IEC_ULINT)(base + i) * 1000000ull;
+    }
+}
+
+static void assert_values(IEC_UINT base)
+{
+    for (size_t i = 0; i < table_size; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT16((IEC_UINT)(base + i), words[i]);
+        TEST_ASSERT_EQUAL_UINT32((IEC_UDINT)(base + i) * 1000u, dwords[i]);
+        TEST_ASSERT_EQUAL_UINT64((IEC_ULINT)(base + i) * 1000000ull, lwords[i]);
+    }
+}
+
+// Stop like the runtime does and start again from the file
+static void restart(void)
+{
+    retain_shutdown();
+    set_values(0);
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+    retain_restore();
+}
+
+static off_t file_size(void)
+{
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, stat(path, &st));
+    return st.st_size;
+}
+
+// Size of one slot for the current table size, as laid out by retain_init()
+static size_t slot_size(void)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t data = table_size * (sizeof(IEC_ULINT) + sizeof(IEC_UDINT) + sizeof(IEC_UINT));
+    return page + (data + page - 1) / page * page;
+}
+
+void setUp(void)
+{
+    for (size_t i = 0; i < MAX_TEST_SIZE; i++)
+    {
+        int_table[i]  = &words[i];
+        dint_table[i] = &dwords[i];
+        lint_table[i] = &lwords[i];
+    }
+    int_memory  = int_table;
+    dint_memory = dint_table;
+    lint_memory = lint_table;
+
+    table_size     = 16;
+    bound_slots    = MAX_TEST_SIZE;
+    msync_fails    = false;
+    msync_failures = 0;
+
+    strcpy(path, "/tmp/test_retain_XXXXXX");
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+
+    // Checkpoints only happen through retain_flush() and retain_shutdown()
+    TEST_ASSERT_EQUAL_INT(0, retain_set_file(path));
+    TEST_ASSERT_EQUAL_INT(0, retain_set_interval(RETAIN_MAX_INTERVAL_MS));
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+    retain_restore();
+}
+
+void tearDown(void)
+{
+    msync_fails = false;
+    retain_shutdown();
+    unlink(path);
+}
+
+void test_retain_restore_AfterCheckpoint_ShouldRestoreValues(void)
+{
+    set_values(100);
+    retain_flush();
+    TEST_ASSERT_EQUAL_INT64((off_t)(2 * slot_size()), file_size());
+
+    restart();
+    assert_values(100);
+}
+
+void test_retain_restore_NewFile_ShouldKeepInitialValues(void)
+{
+    set_values(7);
+    retain_restore();
+    assert_values(7);
+}
+
+void test_retain_init_TornDataPage_ShouldRestoreOlderSlot(void)
+{
+    set_values(100);
+    retain_flush(); // slot 0
+    set_values(200);
+    retain_flush(); // slot 1, the newest
+    retain_shutdown();
+
+    // A crash left part of slot 1's data on disk after its header
+    int fd = open(path, O_RDWR);
+    TEST_ASSERT_TRUE(fd >= 0);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    IEC_ULINT torn = 0xDEADBEEF;
+    TEST_ASSERT_EQUAL_INT((int)sizeof(torn),
+                          (int)pwrite(fd, &torn, sizeof(torn), (off_t)(slot_size() + page)));
+    close(fd);
+
+    set_values(0);
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+    retain_restore();
+    assert_values(100);
+
+    // The next checkpoint replaces the torn slot and becomes the newest
+    set_values(300);
+    retain_flush();
+    restart();
+    assert_values(300);
+}
+
+// Values of indexes below old_size restored from base old_base, the rest kept
+static void assert_migrated(size_t old_size, IEC_UINT old_base, IEC_UINT base)
+{
+    for (size_t i = 0; i < table_size; i++)
+    {
+        IEC_UINT expected = (IEC_UINT)((i < old_size ? old_base : base) + i);
+        TEST_ASSERT_EQUAL_UINT16(expected, words[i]);
+        TEST_ASSERT_EQUAL_UINT32((IEC_UDINT)expected * 1000u, dwords[i]);
+        TEST_ASSERT_EQUAL_UINT64((IEC_ULINT)expected * 1000000ull, lwords[i]);
+    }
+}
+
+void test_retain_init_LargerLayout_ShouldMigrateOldIndexes(void)
+{
+    set_values(100);
+    retain_flush();
+    retain_shutdown();
+
+    // The next start has more memory locations
+    table_size = MAX_TEST_SIZE;
+    set_values(5);
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+    retain_restore();
+    assert_migrated(16, 100, 5);
+    TEST_ASSERT_EQUAL_INT64((off_t)(2 * slot_size()), file_size());
+
+    // The file was rewritten in the new layout
+    retain_flush();
+    restart();
+    assert_migrated(16, 100, 5);
+}
+
+void test_retain_init_SmallerLayout_ShouldMigrateRemainingIndexes(void)
+{
+    table_size = MAX_TEST_SIZE;
+    retain_shutdown();
+    unlink(path);
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+    retain_restore();
+    set_values(100);
+    retain_flush();
+    retain_shutdown();
+
+    table_size = 16;
+    set_values(5);
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+    retain_restore();
+    assert_values(100);
+    TEST_ASSERT_EQUAL_INT64((off_t)(2 * slot_size()), file_size());
+}
+
+void test_retain_init_OtherLayoutUnreadable_ShouldKeepFile(void)
+{
+    retain_shutdown();
+
+    // Not a retain file of any layout
+    int fd = open(path, O_RDWR | O_TRUNC);
+    TEST_ASSERT_TRUE(fd >= 0);
+    char junk[100];
+    memset(junk, 0x5A, sizeof(junk));
+    TEST_ASSERT_EQUAL_INT((int)sizeof(junk), (int)write(fd, junk, sizeof(junk)));
+    close(fd);
+
+    TEST_ASSERT_EQUAL_INT(-1, retain_init());
+    TEST_ASSERT_EQUAL_INT64((off_t)sizeof(junk), file_size());
+}
+
+void test_retain_capture_UnboundEntries_ShouldOnlyRecordJournalWrites(void)
+{
+    bound_slots = 4;
+    set_values(0);
+    retain_restore();
+    retain_flush(); // the first capture compares everything
+
+    // Unbound entries only change through journal writes, which mark them
+    words[2]  = 20;
+    words[8]  = 80;
+    dwords[9] = 90;
+    lwords[5] = 50;
+    journal_written(JOURNAL_INT_MEMORY, 8);
+    journal_written(JOURNAL_LINT_MEMORY, 5);
+    retain_capture();
+    retain_flush();
+
+    restart();
+    TEST_ASSERT_EQUAL_UINT16(20, words[2]);
+    TEST_ASSERT_EQUAL_UINT16(80, words[8]);
+    TEST_ASSERT_EQUAL_UINT64(50, lwords[5]);
+    // Never compared: an unbound entry nothing wrote through the journal
+    TEST_ASSERT_EQUAL_UINT32(9 * 1000u, dwords[9]);
+}
+
+void test_retain_flush_FailedSync_ShouldRewriteWholeSlot(void)
+{
+    // Several data pages, so a partial rewrite would leave some of them lost
+    table_size = MAX_TEST_SIZE;
+    retain_shutdown();
+    unlink(path);
+    TEST_ASSERT_EQUAL_INT(0, retain_init());
+
+    set_values(100);
+    retain_flush(); // slot 0
+    words[0] = 1;
+    retain_flush(); // slot 1
+
+    // Only the last page changed, but the failed write loses all of slot 0
+    words[0]                 = 100;
+    words[MAX_TEST_SIZE - 1] = 9;
+    msync_fails              = true;
+    retain_flush();
+    TEST_ASSERT_EQUAL_INT(1, msync_failures);
+
+    msync_fails = false;
+    retain_flush();
+
+    restart();
+    TEST_ASSERT_EQUAL_UINT16(9, words[MAX_TEST_SIZE - 1]);
+    words[MAX_TEST_SIZE - 1] = (IEC_UINT)(100 + MAX_TEST_SIZE - 1);
+    assert_values(100);
+}
@@ -0,0 +1,130 @@
+#include "huge_pages.h"
+#include "image_gather.h"
+#include "image_shadow.h"
+#include "journal_buffer.h"
+#include "mock_plc_state_manager.h"
+#include "mock_plugin_driver.h"
+#include "safe_state.h"
+#include "unity.h"
+#include "utils.h"
+#include <string.h>
+
+#define TEST_SIZE 16
+
+// image_tables.c needs the program loader; the tests own the tables instead
+IEC_BOOL *(*bool_input)[8];
+IEC_BOOL *(*bool_output)[8];
+IEC_BOOL *(*bool_memory)[8];
+IEC_BYTE **byte_input;
+IEC_BYTE **byte_output;
+IEC_UINT **int_input;
+IEC_UINT **int_output;
+IEC_UDINT **dint_input;
+IEC_UDINT **dint_output;
+IEC_ULINT **lint_input;
+IEC_ULINT **lint_output;
+IEC_UINT **int_memory;
+IEC_UDINT **dint_memory;
+IEC_ULINT **lint_memory;
+
+plugin_driver_t *plugin_driver = NULL;
+
+static IEC_BOOL *bool_output_table[TEST_SIZE][8];
+static IEC_BYTE *byte_output_table[TEST_SIZE];
+static IEC_UINT *int_output_table[TEST_SIZE];
+static IEC_UDINT *dint_output_table[TEST_SIZE];
+static IEC_ULINT *lint_output_table[TEST_SIZE];
+static IEC_BOOL coil;
+static IEC_UINT word;
+
+size_t image_tables_size(void)
+{
+    return TEST_SIZE;
+}
+
+void log_info(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+void log_error(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+void setUp(void)
+{
+    memset(bool_output_table, 0, sizeof(bool_output_table));
+    memset(byte_output_table, 0, sizeof(byte_output_table));
+    memset(int_output_table, 0, sizeof(int_output_table));
+    memset(dint_output_table, 0, sizeof(dint_output_table));
+    memset(lint_output_table, 0, sizeof(lint_output_table));
+    bool_output = bool_output_table;
+    byte_output = byte_output_table;
+    int_output  = int_output_table;
+    dint_output = dint_output_table;
+    lint_output = lint_output_table;
+
+    // The program binds %QX0.3 and %QW2 and last wrote them
+    bool_output_table[0][3] = &coil;
+    int_output_table[2]     = &word;
+    coil                    = 0;
+    word                    = 7;
+
+    // The safe image is built once, like at startup
+    static bool initialized = false;
+    if (!initialized)
+    {
+        TEST_ASSERT_EQUAL_INT(0, safe_state_add("%QX0.3=1"));
+        TEST_ASSERT_EQUAL_INT(0, safe_state_add("%QW2=1200"));
+        TEST_ASSERT_EQUAL_INT(0, safe_state_init());
+        initialized = true;
+    }
+
+    // Snapshot readers subscribe, then a scan publishes the program's outputs
+    image_shadow_read(JOURNAL_INT_OUTPUT, 0, 1, &(IEC_UINT){0}, NULL);
+    image_shadow_read(JOURNAL_BOOL_OUTPUT, 0, 1, &(uint8_t){0}, NULL);
+    image_shadow_sync();
+}
+
+void tearDown(void)
+{
+}
+
+void test_safe_state_apply_Locked_ShouldPublishSafeValuesToSnapshotReaders(void)
+{
+    IEC_UINT words[3] = {0};
+    uint8_t coils     = 0;
+    uint32_t before   = 0;
+    uint32_t after    = 0;
+    TEST_ASSERT_EQUAL_INT(3, image_shadow_read(JOURNAL_INT_OUTPUT, 0, 3, words, &before));
+    TEST_ASSERT_EQUAL_UINT16(7, words[2]);
+
+    plugin_driver_push_outputs_ExpectAndReturn(NULL, 0);
+    safe_state_apply(true);
+
+    TEST_ASSERT_EQUAL_UINT16(1200, word);
+    TEST_ASSERT_EQUAL_UINT8(1, coil);
+
+    // No scan runs in ERROR, the safe state itself refreshed the shadow
+    TEST_ASSERT_EQUAL_INT(3, image_shadow_read(JOURNAL_INT_OUTPUT, 0, 3, words, &after));
+    TEST_ASSERT_EQUAL_UINT16(1200, words[2]);
+    TEST_ASSERT_EQUAL_UINT16(0, words[0]);
+    TEST_ASSERT_TRUE(after != before);
+    TEST_ASSERT_EQUAL_INT(1, image_shadow_read(JOURNAL_BOOL_OUTPUT, 0, 1, &coils, NULL));
+    TEST_ASSERT_EQUAL_HEX8(0x08, coils);
+}
+
+void test_safe_state_apply_WithoutLock_ShouldOnlyForceImageTables(void)
+{
+    IEC_UINT words[3] = {0};
+
+    // No lock: neither the shadow nor the hooks may run beside a resuming scan,
+    // plugin_driver_push_outputs() is not expected
+    safe_state_apply(false);
+
+    TEST_ASSERT_EQUAL_UINT16(1200, word);
+    TEST_ASSERT_EQUAL_UINT8(1, coil);
+    TEST_ASSERT_EQUAL_INT(3, image_shadow_read(JOURNAL_INT_OUTPUT, 0, 3, words, NULL));
+    TEST_ASSERT_EQUAL_UINT16(7, words[2]);
+}
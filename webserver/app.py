@@ -51,6 +51,8 @@ BASE_DIR: Final[Path] = Path(__file__).parent
 CERT_FILE: Final[Path] = (BASE_DIR / "certOPENPLC.pem").resolve()
 KEY_FILE: Final[Path] = (BASE_DIR / "keyOPENPLC.pem").resolve()
 HOSTNAME: Final[str] = "localhost"
+# Longest a runtime-logs request may wait for new logs
+RUNTIME_LOGS_MAX_WAIT_S: Final[float] = 30.0
 
 
 def handle_start_plc(data: dict) -> dict:
@@ -72,7 +74,9 @@ def handle_runtime_logs(data: dict) -> dict:
         level = data["level"]
     else:
         level = None
-    response = runtime_manager.get_logs(min_id=min_id, level=level)
+    # Long poll: hold the request until a log arrives, instead of polling
+    wait = min(max(float(data.get("wait", 0)), 0), RUNTIME_LOGS_MAX_WAIT_S)
+    response = runtime_manager.get_logs(min_id=min_id, level=level, wait=wait)
     return {"runtime-logs": response}
 
 
@@ -84,27 +88,38 @@ def handle_compilation_status(data: dict) -> dict:
     }
 
 
-def parse_timing_stats(stats_response: Optional[str]) -> Optional[dict]:
+def _parse_prefixed_json(response: Optional[str], prefix: str) -> Optional[dict]:
     """
-    Parse the STATS response from the runtime.
-    Expected format: STATS:{json_object}
+    Parse a runtime response of the form PREFIX{json_object}.
     Returns the parsed JSON object or None if parsing fails.
     """
-    if stats_response is None:
-        return None
-
-    # Remove the STATS: prefix
-    if stats_response.startswith("STATS:"):
-        json_str = stats_response[6:].strip()
-    else:
+    if response is None or not response.startswith(prefix):
         return None
 
     try:
-        return json.loads(json_str)
+        return json.loads(response[len(prefix):].strip())
     except json.JSONDecodeError:
         return None
 
 
+def parse_timing_stats(stats_response: Optional[str]) -> Optional[dict]:
+    """
+    Parse the STATS response from the runtime.
+    Expected format: STATS:{json_object}
+    Returns the parsed JSON object or None if parsing fails.
+    """
+    return _parse_prefixed_json(stats_response, "STATS:")
+
+
+def parse_timing_histogram(histogram_response: Optional[str]) -> Optional[dict]:
+    """
+    Parse the HISTOGRAM response from the runtime.
+    Expected format: HISTOGRAM:{json_object}
+    Returns the parsed JSON object or None if parsing fails.
+    """
+    return _parse_prefixed_json(histogram_response, "HISTOGRAM:")
+
+
 def handle_status(data: dict) -> dict:
     response = runtime_manager.status_plc()
     if response is None:
@@ -122,9 +137,49 @@ def handle_status(data: dict) -> dict:
         if timing_stats is not None:
             result["timing_stats"] = timing_stats
 
+    # Percentiles over the 1s/10s/60s windows, same opt-in as the stats
+    include_histogram = data.get("include_histogram", "").lower() == "true"
+    if include_histogram:
+        histogram_response = runtime_manager.histogram_plc()
+        timing_histogram = parse_timing_histogram(histogram_response)
+        if timing_histogram is not None:
+            result["timing_histogram"] = timing_histogram
+
+    include_affinity = data.get("include_affinity", "").lower() == "true"
+    if include_affinity:
+        affinity = _parse_prefixed_json(runtime_manager.affinity_plc(), "AFFINITY:")
+        if affinity is not None:
+            result["affinity"] = affinity
+
+    include_tasks = data.get("include_tasks", "").lower() == "true"
+    if include_tasks:
+        tasks = _parse_prefixed_json(runtime_manager.tasks_plc(), "TASKS:")
+        if tasks is not None:
+            result["tasks"] = tasks
+
     return result
 
 
+def handle_profile(data: dict) -> dict:
+    """
+    Per-phase scan cycle profile. The optional "action" parameter
+    (on, off or reset) controls the profiler instead of reading it.
+    """
+    action = data.get("action", "").lower()
+    if action:
+        if action not in ("on", "off", "reset"):
+            return {"error": "Invalid action"}
+        response = runtime_manager.profile_plc(action)
+        if response is None:
+            return {"status": "No response from runtime"}
+        return {"status": response.strip()}
+
+    profile = _parse_prefixed_json(runtime_manager.profile_plc(), "PROFILE:")
+    if profile is None:
+        return {"status": "No response from runtime"}
+    return {"profile": profile}
+
+
 def handle_ping(data: dict) -> dict:
     response = runtime_manager.ping()
     return {"status": response}
@@ -249,6 +304,7 @@ GET_HANDLERS: dict[str, Callable[[dict], dict]] = {
     "compilation-status": handle_compilation_status,
     "status": handle_status,
     "ping": handle_ping,
+    "profile": handle_profile,
     "scan-canbus": handle_scan_canbus,
 }
 
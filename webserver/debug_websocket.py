@@ -2,22 +2,113 @@
 WebSocket debug endpoint for OpenPLC Runtime v4
 
 This module provides a secure WebSocket interface for debugger communication.
-It receives debug commands in hex format, forwards them to the Unix socket,
-and returns responses through the WebSocket connection.
+It receives debug commands in hex format (or as raw bytes), forwards them to
+the Unix socket as binary frames, and returns responses through the WebSocket
+connection in the same format.
+
+Clients can also subscribe to a set of variables with "debug_subscribe"; the
+runtime then pushes "debug_sample" events captured at the end of each scan
+through its debug stream socket, instead of the client polling.
 """
 
+import threading
+
 from flask import request
 from flask_jwt_extended import decode_token
 from flask_socketio import SocketIO, emit
 from jwt.exceptions import ExpiredSignatureError, InvalidTokenError
 
 from webserver.logger import get_logger
+from webserver.unixclient import MB_DEBUG_SUCCESS, MB_FC_DEBUG_GET_PAGED, DebugStreamClient
 
 logger, _ = get_logger("debug_ws", use_buffer=True)
 
 _socketio = None  # pylint: disable=invalid-name
 _unix_client = None  # pylint: disable=invalid-name
 
+# The runtime serves one stream client, so one subscription is active at a time
+_stream_lock = threading.Lock()
+_stream = None  # pylint: disable=invalid-name
+
+
+class _StreamSubscription:
+    """One debug stream connection forwarding samples to a WebSocket client"""
+
+    def __init__(self, sid, client, binary):
+        self.sid = sid
+        self.client = client
+        self.binary = binary
+        self.stop_event = threading.Event()
+        self.thread = None
+
+    def run(self):
+        while not self.stop_event.is_set():
+            try:
+                sample = self.client.read_sample(timeout=0.5)
+            except (ConnectionError, OSError) as e:
+                if not self.stop_event.is_set():
+                    logger.warning("Debug stream closed: %s", e)
+                    _socketio.emit(
+                        "debug_unsubscribed",
+                        {"reason": str(e)},
+                        namespace="/api/debug",
+                        to=self.sid,
+                    )
+                    _stop_stream(self.sid)
+                break
+
+            if sample is None:
+                continue
+
+            tick, dropped, data = sample
+            event = {"tick": tick, "dropped": dropped}
+            if self.binary:
+                event["binary"] = data
+            else:
+                event["data"] = data.hex(" ")
+            _socketio.emit("debug_sample", event, namespace="/api/debug", to=self.sid)
+
+        self.client.close()
+
+    def stop(self):
+        self.stop_event.set()
+        if self.thread is not None and self.thread is not threading.current_thread():
+            self.thread.join(timeout=2.0)
+
+
+def _stop_stream(sid=None):
+    """Stop the active subscription, only if it belongs to sid when given"""
+    global _stream
+
+    with _stream_lock:
+        if _stream is None or (sid is not None and _stream.sid != sid):
+            return False
+        stream = _stream
+        _stream = None
+
+    stream.stop()
+    logger.info("Debug stream subscription stopped")
+    return True
+
+
+def _emit_debug_pages(payload, binary):
+    """Answer a DEBUG_GET_PAGED command with one debug_response per page"""
+    start = int.from_bytes(payload[1:3], "big")
+    end = int.from_bytes(payload[3:5], "big")
+    pages = _unix_client.send_and_receive_debug_pages(start, end, timeout=5.0)
+
+    if not pages:
+        emit("debug_response", {"success": False, "error": "No response from runtime"})
+        return
+
+    for i, page in enumerate(pages):
+        event = {"success": True, "more": i < len(pages) - 1}
+        if binary:
+            event["binary"] = page
+        else:
+            event["data"] = page.hex(" ")
+        emit("debug_response", event)
+
 
 def init_debug_websocket(app, unix_client_instance):
     """
@@ -25,7 +116,7 @@ def init_debug_websocket(app, unix_client_instance):
 
     Args:
         app: Flask application instance
-        unix_client_instance: SyncUnixClient instance for communicating with C core
+        unix_client_instance: PipelinedUnixClient instance for communicating with C core
     """
     global _socketio, _unix_client
 
@@ -95,8 +186,69 @@ def init_debug_websocket(app, unix_client_instance):
     @_socketio.on("disconnect", namespace="/api/debug")
     def handle_disconnect():
         """Handle WebSocket disconnection"""
+        _stop_stream(request.sid)
         logger.info("Debug WebSocket disconnected")
 
+    @_socketio.on("debug_subscribe", namespace="/api/debug")
+    def handle_debug_subscribe(data):
+        """
+        Subscribe to variables pushed by the runtime after every scan.
+
+        Expected data format:
+        {
+            'indexes': [variable indexes],
+            'mode': 'scans' (every `rate` scans, default) or 'change'
+                    (when any value changed, at most every `rate` scans),
+            'rate': scans between samples (default 1),
+            'binary': true to receive raw bytes instead of hex
+        }
+
+        Emits "debug_subscribed", then "debug_sample" events with tick,
+        dropped and data (hex) or binary. A new subscription replaces the
+        previous one, from this or any other client.
+        """
+        global _stream
+
+        indexes = data.get("indexes") if isinstance(data, dict) else None
+        if not indexes or not isinstance(indexes, list):
+            emit("debug_subscribed", {"success": False, "error": "No variable indexes"})
+            return
+
+        _stop_stream()
+
+        client = DebugStreamClient()
+        try:
+            client.connect()
+            status = client.subscribe(
+                indexes,
+                on_change=data.get("mode") == "change",
+                rate=int(data.get("rate", 1)),
+            )
+        except Exception as e:
+            client.close()
+            logger.error("Debug stream subscribe failed: %s", e)
+            emit("debug_subscribed", {"success": False, "error": str(e)})
+            return
+
+        if status != MB_DEBUG_SUCCESS:
+            client.close()
+            emit("debug_subscribed", {"success": False, "error": f"0x{status:02X}"})
+            return
+
+        stream = _StreamSubscription(request.sid, client, bool(data.get("binary")))
+        with _stream_lock:
+            _stream = stream
+        stream.thread = threading.Thread(target=stream.run, daemon=True)
+        stream.thread.start()
+
+        logger.info("Debug stream subscribed to %d variables", len(indexes))
+        emit("debug_subscribed", {"success": True})
+
+    @_socketio.on("debug_unsubscribe", namespace="/api/debug")
+    def handle_debug_unsubscribe():
+        """Stop the subscription started by this client"""
+        emit("debug_unsubscribed", {"success": _stop_stream(request.sid)})
+
     @_socketio.on("debug_command", namespace="/api/debug")
     def handle_debug_command(data):
         """
@@ -106,8 +258,12 @@ def init_debug_websocket(app, unix_client_instance):
         {
             'command': 'hex string of debug data (e.g., "41 00 00")'
         }
+        or
+        {
+            'binary': raw debug data bytes
+        }
 
-        Returns debug response in same hex format
+        Returns the debug response in the same format as the request
         """
         try:
             if not _unix_client or not _unix_client.is_connected():
@@ -118,16 +274,29 @@ def init_debug_websocket(app, unix_client_instance):
                 )
                 return
 
-            command_hex = data.get("command", "")
-            if not command_hex:
+            binary_request = data.get("binary")
+            if binary_request is not None:
+                payload = bytes(binary_request)
+            else:
+                command_hex = data.get("command", "")
+                try:
+                    payload = bytes.fromhex(command_hex)
+                except ValueError:
+                    emit("debug_response", {"success": False, "error": "Invalid hex command"})
+                    return
+
+            if not payload:
                 logger.warning("Empty debug command received")
                 emit("debug_response", {"success": False, "error": "Empty command"})
                 return
 
-            logger.debug("Debug command received: %s", command_hex)
+            logger.debug("Debug command received: %s", payload.hex(" "))
+
+            if payload[0] == MB_FC_DEBUG_GET_PAGED and len(payload) >= 5:
+                _emit_debug_pages(payload, binary_request is not None)
+                return
 
-            unix_command = f"DEBUG:{command_hex}\n"
-            response = _unix_client.send_and_receive(unix_command, timeout=2.0)
+            response = _unix_client.send_and_receive_debug_frame(payload, timeout=2.0)
 
             if response is None:
                 logger.warning("No response from runtime")
@@ -137,24 +306,17 @@ def init_debug_websocket(app, unix_client_instance):
                 )
                 return
 
-            if response.startswith("DEBUG:"):
-                response_hex = response[6:].strip()
+            if not response:
+                logger.warning("Debug error from runtime: ERROR_PROCESSING")
+                emit("debug_response", {"success": False, "error": "ERROR_PROCESSING"})
+                return
+
+            if binary_request is not None:
+                emit("debug_response", {"success": True, "binary": response})
+            else:
+                response_hex = response.hex(" ")
                 logger.debug("Debug response: %s", response_hex)
                 emit("debug_response", {"success": True, "data": response_hex})
-            elif response.startswith("DEBUG:ERROR"):
-                error_msg = (
-                    response.split(":", 2)[2]
-                    if len(response.split(":")) > 2
-                    else "Unknown error"
-                )
-                logger.warning("Debug error from runtime: %s", error_msg)
-                emit("debug_response", {"success": False, "error": error_msg})
-            else:
-                logger.warning("Unexpected response format: %s", response)
-                emit(
-                    "debug_response",
-                    {"success": False, "error": "Unexpected response format"},
-                )
 
         except Exception as e:
             logger.error("Error processing debug command: %s", e)
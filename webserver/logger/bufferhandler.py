@@ -1,31 +1,100 @@
 # logger/bufferhandler.py
 import logging
 from collections import deque
-from typing import List, Optional
+from typing import Dict, List, Optional
 import json
+import time
 from datetime import datetime, timezone
-from threading import Lock
+from threading import Condition
 from . import config
 
 
+class _LogRing:
+    """Fixed-capacity ring of log entries in increasing id order."""
+
+    def __init__(self, capacity: int):
+        self._capacity = capacity
+        self._ids = [0] * capacity
+        self._entries: List[Optional[dict]] = [None] * capacity
+        self._start = 0
+        self._count = 0
+
+    def append(self, log_id: int, entry: dict) -> None:
+        if self._count == self._capacity:
+            slot = self._start
+            self._start = (self._start + 1) % self._capacity
+        else:
+            slot = (self._start + self._count) % self._capacity
+            self._count += 1
+        self._ids[slot] = log_id
+        self._entries[slot] = entry
+
+    def oldest_id(self) -> Optional[int]:
+        return self._ids[self._start] if self._count else None
+
+    def _seek(self, min_id: int) -> int:
+        """Position of the first entry with an id >= min_id."""
+        low, high = 0, self._count
+        while low < high:
+            middle = (low + high) // 2
+            if self._ids[(self._start + middle) % self._capacity] < min_id:
+                low = middle + 1
+            else:
+                high = middle
+        return low
+
+    def since(self, min_id: Optional[int] = None, count: Optional[int] = None) -> List[dict]:
+        first = self._seek(min_id) if min_id is not None else 0
+        if count is not None:
+            first = max(first, self._count - count)
+        return [
+            self._entries[(self._start + position) % self._capacity]
+            for position in range(first, self._count)
+        ]
+
+    def clear(self) -> None:
+        self._entries = [None] * self._capacity
+        self._start = 0
+        self._count = 0
+
+    def __len__(self):
+        return self._count
+
+
 class BufferHandler(logging.Handler):
     """
     Custom logging handler that stores log records in memory (FIFO).
-    Logs are formatted using the attached formatter (JSON).
+    Logs are formatted using the attached formatter (JSON) and normalized
+    once when they arrive. They are kept in a ring ordered by id, with one
+    more ring per level, so a poll for the logs after some id seeks to it in
+    O(log n) instead of decoding and filtering the whole buffer.
     """
     def __init__(self, capacity: int = 1000):
         super().__init__()
-        self.buffer = deque(maxlen=capacity)
-        self.records = []  # Store formatted log records as strings
-        self._lock = Lock()
+        self.capacity = capacity
+        self.records = deque(maxlen=capacity)  # Formatted log records as strings
+        self._all = _LogRing(capacity)
+        self._by_level: Dict[str, _LogRing] = {}
+        self._new_logs = Condition()
 
     def emit(self, record: logging.LogRecord) -> None:
-        with self._lock:
+        with self._new_logs:
             try:
                 record.log_id = config.LoggerConfig.next_log_id()
                 formatted_record = self.format(record)
+                entry = json.loads(formatted_record)
+                if not isinstance(entry, dict):
+                    entry = {"message": formatted_record}
+                entry["id"] = record.log_id
+                entry = self.normalize_logs([entry])[0]
+
                 self.records.append(formatted_record)
-                self.buffer.append(formatted_record)
+                self._all.append(record.log_id, entry)
+                level = entry["level"]
+                if level not in self._by_level:
+                    self._by_level[level] = _LogRing(self.capacity)
+                self._by_level[level].append(record.log_id, entry)
+                self._new_logs.notify_all()
             except Exception:
                 self.handleError(record)
 
@@ -39,16 +108,36 @@ class BufferHandler(logging.Handler):
             result = [log for log in result if log.get("id", 0) <= max_id]
         return result
 
+    def _select(self, count: Optional[int], min_id: Optional[int],
+                level: Optional[str]) -> List[dict]:
+        if level is None:
+            return self._all.since(min_id, count)
+
+        ring = self._by_level.get(level)
+        oldest = self._all.oldest_id()
+        if ring is None or oldest is None:
+            return []
+        # A level ring holds entries the main ring has already dropped
+        min_id = oldest if min_id is None else max(min_id, oldest)
+        return ring.since(min_id, count)
+
     def get_logs(self, count: Optional[int] = None,
                  min_id: Optional[int] = None,
-                 level: Optional[str] = None) -> List[str]:
-        """Retrieve logs from buffer."""
-        with self._lock:
-            filtered_logs = [json.loads(item) for item in self.buffer]
-            filtered_logs = self.filter_logs(filtered_logs, level=level, min_id=min_id)
-            if count is not None and count < len(filtered_logs):
-                filtered_logs = filtered_logs[-count:]
-            return filtered_logs
+                 level: Optional[str] = None,
+                 wait: float = 0) -> List[dict]:
+        """
+        Retrieve logs from buffer, already normalized. With `wait`, block up
+        to that many seconds until a matching log arrives, so a client can
+        long-poll with the id after the last log it has.
+        """
+        deadline = time.monotonic() + wait
+        with self._new_logs:
+            while True:
+                logs = self._select(count, min_id, level)
+                remaining = deadline - time.monotonic()
+                if logs or remaining <= 0:
+                    return [dict(log) for log in logs]
+                self._new_logs.wait(remaining)
 
     def normalize_timestamp_no_microseconds(self, ts: str) -> str:
         """Normalize ISO 8601 timestamp to remove microseconds."""
@@ -81,7 +170,7 @@ class BufferHandler(logging.Handler):
             except (json.JSONDecodeError, TypeError, ValueError) as e:
                 # If something is not JSON, safely wrap it
                 normalized.append({
-                    "id": None,
+                    "id": data.get("id") if isinstance(data, dict) else None,
                     "timestamp": datetime.now(timezone.utc).isoformat(),
                     "level": "ERROR",
                     "message": f"Malformed log: {data} ({e})",
@@ -90,9 +179,11 @@ class BufferHandler(logging.Handler):
         return normalized
 
     def clear(self) -> None:
-        self.buffer.clear()
-        self.records.clear()
-        config.LoggerConfig.reset_log_id()
+        with self._new_logs:
+            self.records.clear()
+            self._all.clear()
+            self._by_level.clear()
+            config.LoggerConfig.reset_log_id()
 
     def __len__(self):
-        return len(self.buffer)
+        return len(self._all)
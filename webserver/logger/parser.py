@@ -3,12 +3,20 @@ import logging
 import re
 import time
 import json
+import struct
 
 LOG_PATTERN = re.compile(r'^\[(?P<level>\w+)\]\s*(?P<message>.*)$')
 
+# Binary records sent by the runtime (see LOG_RECORD_MAGIC in core/src/plc_app/utils/log.h):
+# [magic 0xB1] [length u16] [timestamp_ns u64] [level u8] [source u16] [message], little-endian
+LOG_RECORD_MAGIC = 0xB1
+LOG_RECORD_FIELDS = struct.Struct("<QBH")
+RECORD_LEVELS = ("DEBUG", "INFO", "WARN", "ERROR")
+
 LEVEL_MAP = {
     "DEBUG": logging.DEBUG,
     "INFO": logging.INFO,
+    "WARN": logging.WARNING,
     "WARNING": logging.WARNING,
     "ERROR": logging.ERROR,
     "CRITICAL": logging.CRITICAL,
@@ -19,6 +27,20 @@ class LogParser:
     def __init__(self, collector_logger: logging.Logger):
         self.collector_logger = collector_logger
 
+    def parse_record(self, body: bytes):
+        """Log one binary runtime record, given the bytes after its length field."""
+        if len(body) < LOG_RECORD_FIELDS.size:
+            return
+        timestamp_ns, level_id, source = LOG_RECORD_FIELDS.unpack_from(body)
+        level_name = RECORD_LEVELS[level_id] if level_id < len(RECORD_LEVELS) else "INFO"
+        log_entry = {
+            "timestamp": str(timestamp_ns // 1_000_000_000),
+            "level": level_name,
+            "source": source,
+            "message": body[LOG_RECORD_FIELDS.size:].decode("utf-8", errors="replace"),
+        }
+        self._emit(LEVEL_MAP[level_name], log_entry)
+
     def parse_and_log(self, line: str):
         """Parse incoming log line and re-log it in normalized JSON format."""
         sline = line.strip()
@@ -57,6 +79,9 @@ class LogParser:
                 "message": message
             }
 
+        self._emit(level, log_entry)
+
+    def _emit(self, level: int, log_entry: dict):
         # Create final JSON string
         json_log = json.dumps(log_entry, ensure_ascii=False)
 
@@ -273,8 +273,15 @@ def run_compile(runtime_manager: RuntimeManager, cwd: str = "core/generated"):
     # Block until compile finishes
     wait_and_finish(compile_proc, "Build")
 
+    # A running PLC switches to the new program online, without stopping
+    online_change = (
+        build_state.status == BuildStatus.SUCCESS
+        and runtime_manager.status_plc().strip() == "STATUS:RUNNING"
+    )
+
     # Stop PLC before cleanup
-    runtime_manager.stop_plc()
+    if not online_change:
+        runtime_manager.stop_plc()
 
     # --- Cleanup step ---
     cleanup_proc = subprocess.Popen(
@@ -292,7 +299,14 @@ def run_compile(runtime_manager: RuntimeManager, cwd: str = "core/generated"):
     wait_and_finish(cleanup_proc, "Cleanup")
 
     # Restart PLC only if everything succeeded
-    if build_state.status == BuildStatus.SUCCESS:
+    if build_state.status == BuildStatus.SUCCESS and online_change:
+        if runtime_manager.online_change_plc().strip() == "ONLINE_CHANGE:OK":
+            build_state.log("[INFO] PLC program changed online\n")
+        else:
+            build_state.log("[WARNING] Online change failed, restarting the PLC\n")
+            runtime_manager.stop_plc()
+            runtime_manager.start_plc()
+    elif build_state.status == BuildStatus.SUCCESS:
         runtime_manager.start_plc()
     else:
         build_state.log("[WARNING] PLC program has not been updated because the build failed\n")
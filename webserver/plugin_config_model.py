@@ -17,6 +17,7 @@ class PluginType(IntEnum):
     """Plugin type enumeration."""
     PYTHON = 0
     NATIVE = 1
+    PROCESS = 2
 
 
 @dataclass
@@ -24,7 +25,8 @@ class PluginConfig:
     """
     Represents a single plugin configuration entry from plugins.conf.
     
-    Format: name,path,enabled,type,config_path,venv_path
+    Format: name,path,enabled,type,config_path,venv_path,isolation,startup,
+            hook_budget_us,hooks
     """
     name: str
     path: str
@@ -32,6 +34,10 @@ class PluginConfig:
     plugin_type: PluginType
     config_path: str = ""
     venv_path: str = ""
+    isolation: str = ""
+    startup: str = ""
+    hook_budget_us: str = ""
+    hooks: str = ""
     
     @classmethod
     def from_line(cls, line: str) -> Optional['PluginConfig']:
@@ -61,6 +67,10 @@ class PluginConfig:
             plugin_type = PluginType(int(parts[3].strip()))
             config_path = parts[4].strip() if len(parts) > 4 else ""
             venv_path = parts[5].strip() if len(parts) > 5 else ""
+            isolation = parts[6].strip() if len(parts) > 6 else ""
+            startup = parts[7].strip() if len(parts) > 7 else ""
+            hook_budget_us = parts[8].strip() if len(parts) > 8 else ""
+            hooks = parts[9].strip() if len(parts) > 9 else ""
             
             return cls(
                 name=name,
@@ -68,7 +78,11 @@ class PluginConfig:
                 enabled=enabled,
                 plugin_type=plugin_type,
                 config_path=config_path,
-                venv_path=venv_path
+                venv_path=venv_path,
+                isolation=isolation,
+                startup=startup,
+                hook_budget_us=hook_budget_us,
+                hooks=hooks
             )
         except (ValueError, IndexError):
             return None
@@ -83,8 +97,12 @@ class PluginConfig:
         enabled_str = "1" if self.enabled else "0"
         line = f"{self.name},{self.path},{enabled_str},{self.plugin_type.value},{self.config_path}"
         
-        if self.venv_path:
-            line += f",{self.venv_path}"
+        # Optional fields are written up to the last one that is set
+        optional = [self.venv_path, self.isolation, self.startup, self.hook_budget_us, self.hooks]
+        while optional and not optional[-1]:
+            optional.pop()
+        for value in optional:
+            line += f",{value}"
             
         return line
     
@@ -14,7 +14,7 @@ except ImportError:
     HAS_PSUTIL = False
 
 from webserver.logger import get_logger
-from webserver.unixclient import SyncUnixClient
+from webserver.unixclient import PipelinedUnixClient
 from webserver.unixserver import UnixLogServer
 
 logger, buffer = get_logger("logger", use_buffer=True)
@@ -31,7 +31,7 @@ class RuntimeManager:
         self.log_socket = log_socket
         self.process = None
         self.log_server = UnixLogServer(log_socket)
-        self.runtime_socket = SyncUnixClient(plc_socket)
+        self.runtime_socket = PipelinedUnixClient(plc_socket)
         self.monitor_thread = threading.Thread(target=self._monitor, daemon=True)
         self.running = False
 
@@ -215,13 +215,13 @@ class RuntimeManager:
         self._safe_stop_log_server()
         self._safe_close_runtime_socket()
 
-    def get_logs(self, min_id=None, level=None):
+    def get_logs(self, min_id=None, level=None, wait=0):
         """
-        Get current logs from the runtime
+        Get current logs from the runtime, waiting up to `wait` seconds for
+        one to arrive if there is none yet
         """
         try:
-            _logs = buffer.normalize_logs(buffer.get_logs(min_id=min_id, level=level))
-            return _logs
+            return buffer.get_logs(min_id=min_id, level=level, wait=wait)
         except AttributeError as e:
             logger.error("Failed to get logs from buffer: %s", e)
             return []
@@ -267,6 +267,20 @@ class RuntimeManager:
             logger.error("Failed to stop PLC runtime (unexpected): %s", e)
             return "STOP:ERROR\n"
 
+    def online_change_plc(self):
+        """
+        Send ONLINE_CHANGE command: switch the running PLC to the program in
+        the build directory without stopping it
+        """
+        try:
+            return self.runtime_socket.send_and_receive("ONLINE_CHANGE\n")
+        except (OSError, socket.error) as e:
+            logger.error("Failed to change PLC program online: %s", e)
+            return "ONLINE_CHANGE:ERROR\n"
+        except Exception as e:
+            logger.error("Failed to change PLC program online (unexpected): %s", e)
+            return "ONLINE_CHANGE:ERROR\n"
+
     def status_plc(self):
         """
         Send STATUS command
@@ -293,6 +307,64 @@ class RuntimeManager:
             logger.error("Failed to get PLC stats (unexpected): %s", e)
             return None
 
+    def affinity_plc(self):
+        """
+        Send AFFINITY command to get the CPUs the scan thread and the
+        housekeeping threads run on
+        """
+        try:
+            return self.runtime_socket.send_and_receive("AFFINITY\n")
+        except (OSError, socket.error) as e:
+            logger.error("Failed to get PLC affinity: %s", e)
+            return None
+        except Exception as e:
+            logger.error("Failed to get PLC affinity (unexpected): %s", e)
+            return None
+
+    def tasks_plc(self):
+        """
+        Send TASKS command to get per-task timing when tasks run on
+        separate threads
+        """
+        try:
+            return self.runtime_socket.send_and_receive("TASKS\n")
+        except (OSError, socket.error) as e:
+            logger.error("Failed to get PLC tasks: %s", e)
+            return None
+        except Exception as e:
+            logger.error("Failed to get PLC tasks (unexpected): %s", e)
+            return None
+
+    def histogram_plc(self, reset=False):
+        """
+        Send HISTOGRAM command to get scan time percentiles, or
+        HISTOGRAM:RESET to clear them
+        """
+        command = "HISTOGRAM:RESET\n" if reset else "HISTOGRAM\n"
+        try:
+            return self.runtime_socket.send_and_receive(command)
+        except (OSError, socket.error) as e:
+            logger.error("Failed to get PLC histogram: %s", e)
+            return None
+        except Exception as e:
+            logger.error("Failed to get PLC histogram (unexpected): %s", e)
+            return None
+
+    def profile_plc(self, action=None):
+        """
+        Send PROFILE command to get per-phase scan timings, or
+        PROFILE:ON / PROFILE:OFF / PROFILE:RESET to control the profiler
+        """
+        command = f"PROFILE:{action.upper()}\n" if action else "PROFILE\n"
+        try:
+            return self.runtime_socket.send_and_receive(command)
+        except (OSError, socket.error) as e:
+            logger.error("Failed to get PLC profile: %s", e)
+            return None
+        except Exception as e:
+            logger.error("Failed to get PLC profile (unexpected): %s", e)
+            return None
+
 
     def _manage_canbus(self, action="start"):
         """
@@ -1,12 +1,48 @@
 import os
 import socket
-from threading import Lock
-from typing import Optional
+from threading import Event, Lock, Thread
+from typing import Dict, List, Optional, Tuple
 from webserver.logger import get_logger
 
 logger, _ = get_logger(use_buffer=True)
 mutex = Lock()
 
+# Binary debug framing, see DEBUG_FRAME_MAGIC in core/src/plc_app/unix_socket.h
+DEBUG_FRAME_MAGIC = 0xFE
+DEBUG_FRAME_HEADER_SIZE = 3
+MAX_DEBUG_FRAME = 65535
+MB_FC_DEBUG_GET_PAGED = 0x49
+
+# Tagged requests, see TAGGED_FRAME_MAGIC in core/src/plc_app/unix_socket.h
+TAGGED_FRAME_MAGIC = 0xFD
+TAGGED_FRAME_HEADER_SIZE = 8
+TAGGED_KIND_COMMAND = 0
+TAGGED_KIND_DEBUG = 1
+TAGGED_FLAG_FINAL = 0x01
+TAGGED_FLAG_REJECTED = 0x02
+COMMAND_BUFFER_SIZE = 8192
+
+# Debug stream socket, see core/src/plc_app/debug_stream.h
+DEBUG_STREAM_SOCKET_PATH = "/run/runtime/plc_debug_stream.socket"
+MB_FC_DEBUG_SUBSCRIBE = 0x46
+MB_FC_DEBUG_SAMPLE = 0x47
+MB_DEBUG_SUCCESS = 0x7E
+DEBUG_STREAM_MODE_EVERY_N = 0x00
+DEBUG_STREAM_MODE_ON_CHANGE = 0x01
+DEBUG_SAMPLE_FLAG_DROPPED = 0x01
+DEBUG_SAMPLE_HEADER_SIZE = 8
+
+
+def _recv_exact(sock: socket.socket, length: int) -> Optional[bytes]:
+    """Receive exactly length bytes, None if the connection closed."""
+    buffer = bytearray()
+    while len(buffer) < length:
+        chunk = sock.recv(length - len(buffer))
+        if not chunk:
+            return None
+        buffer.extend(chunk)
+    return bytes(buffer)
+
 
 class SyncUnixClient:
     def __init__(self, socket_path="/run/runtime/plc_runtime.socket"):
@@ -131,6 +167,91 @@ class SyncUnixClient:
             except Exception:
                 return None
 
+    def send_and_receive_debug_frame(
+        self, payload: bytes, timeout: float = 0.5
+    ) -> Optional[bytes]:
+        """
+        Send a raw debug payload as a binary frame and return the raw response
+        payload. Returns b"" if the runtime could not process the request and
+        None on socket errors.
+        """
+        if not self.sock:
+            raise RuntimeError("Socket not connected")
+
+        if len(payload) > MAX_DEBUG_FRAME:
+            raise ValueError("Debug payload too large")
+
+        header = bytes([DEBUG_FRAME_MAGIC]) + len(payload).to_bytes(2, "big")
+
+        with mutex:
+            try:
+                self.sock.sendall(header + payload)
+            except Exception as e:
+                logger.error("Error sending debug frame: %s", e)
+                return None
+
+            self.sock.settimeout(timeout)
+            try:
+                response_header = _recv_exact(self.sock, DEBUG_FRAME_HEADER_SIZE)
+                if response_header is None or response_header[0] != DEBUG_FRAME_MAGIC:
+                    logger.error("Invalid debug frame header")
+                    return None
+
+                length = int.from_bytes(response_header[1:3], "big")
+                return _recv_exact(self.sock, length) if length > 0 else b""
+            except socket.timeout:
+                logger.warning("Timeout waiting for debug frame")
+                return None
+            except Exception:
+                return None
+
+    def send_and_receive_debug_pages(
+        self, start: int, end: int, timeout: float = 2.0
+    ) -> Optional[List[bytes]]:
+        """
+        Read variables start..end with one DEBUG_GET_PAGED request. The runtime
+        answers with as many frames as needed; they are returned in order. An
+        error is returned as a single 2-byte page. Returns None on socket errors.
+        """
+        if not self.sock:
+            raise RuntimeError("Socket not connected")
+
+        payload = bytes([MB_FC_DEBUG_GET_PAGED]) + start.to_bytes(2, "big") + end.to_bytes(2, "big")
+        header = bytes([DEBUG_FRAME_MAGIC]) + len(payload).to_bytes(2, "big")
+
+        with mutex:
+            try:
+                self.sock.sendall(header + payload)
+            except Exception as e:
+                logger.error("Error sending debug frame: %s", e)
+                return None
+
+            self.sock.settimeout(timeout)
+            pages = []
+            try:
+                while True:
+                    response_header = _recv_exact(self.sock, DEBUG_FRAME_HEADER_SIZE)
+                    if response_header is None or response_header[0] != DEBUG_FRAME_MAGIC:
+                        logger.error("Invalid debug frame header")
+                        return None
+
+                    length = int.from_bytes(response_header[1:3], "big")
+                    page = _recv_exact(self.sock, length) if length > 0 else b""
+                    if page is None:
+                        return None
+                    pages.append(page)
+
+                    # Error pages are 2 bytes; the last page ends at `end`
+                    if len(page) < 4 or page[1] != MB_DEBUG_SUCCESS:
+                        return pages
+                    if int.from_bytes(page[2:4], "big") >= end:
+                        return pages
+            except socket.timeout:
+                logger.warning("Timeout waiting for debug frame")
+                return None
+            except Exception:
+                return None
+
     def close(self):
         if self.sock:
             logger.debug("Closing connection")
@@ -138,3 +259,325 @@ class SyncUnixClient:
                 self.sock.close()
             finally:
                 self.sock = None
+
+
+class _PendingRequest:
+    """Reply frames of one tagged request, complete once `done` is set."""
+
+    def __init__(self):
+        self.frames: List[bytes] = []
+        self.done = Event()
+        self.rejected = False
+        self.failed = False
+
+
+class PipelinedUnixClient:
+    """
+    Client for the runtime's command socket with the methods of
+    SyncUnixClient, for use from many threads at once. Every request is sent
+    as a tagged frame right away, without waiting for the ones in flight; a
+    reader thread hands each reply to the caller waiting for its request id.
+    The runtime answers queries such as STATUS and STATS on their own worker,
+    so they no longer wait behind a slow debug request or a program start,
+    and a timeout only abandons the request that timed out.
+    """
+
+    def __init__(self, socket_path="/run/runtime/plc_runtime.socket"):
+        self.socket_path = socket_path
+        self.sock: Optional[socket.socket] = None
+        self._send_lock = Lock()
+        self._pending_lock = Lock()
+        self._pending: Dict[int, _PendingRequest] = {}
+        self._next_id = 0
+
+    def is_connected(self):
+        return self.sock is not None
+
+    def connect(self):
+        """Connect to the Unix socket server and start the reader thread"""
+        if not os.path.exists(self.socket_path):
+            raise FileNotFoundError(f"Socket not found: {self.socket_path}")
+
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            logger.debug("Connecting to socket %s", self.socket_path)
+            # Also bounds sendall() when the runtime stops reading
+            sock.settimeout(1.0)
+            sock.connect(self.socket_path)
+            logger.debug("Connected to server socket %s", self.socket_path)
+        except Exception as e:
+            logger.error("Failed to connect: %s", e)
+            sock.close()
+            return
+
+        self.sock = sock
+        reader = Thread(target=self._read_replies, args=(sock,), name="unix-client-reader")
+        reader.daemon = True
+        reader.start()
+
+    def _dispatch(self, request_id: int, flags: int, body: bytes):
+        with self._pending_lock:
+            pending = self._pending.get(request_id)
+            if pending is not None and flags & TAGGED_FLAG_FINAL:
+                del self._pending[request_id]
+        if pending is None:
+            return  # timed out, or sent without waiting for the reply
+
+        if flags & TAGGED_FLAG_REJECTED:
+            pending.rejected = True
+        else:
+            pending.frames.append(body)
+        if flags & TAGGED_FLAG_FINAL:
+            pending.done.set()
+
+    def _read_replies(self, sock: socket.socket):
+        buffer = bytearray()
+        try:
+            while True:
+                try:
+                    chunk = sock.recv(65536)
+                except socket.timeout:
+                    continue
+                if not chunk:
+                    logger.warning("Runtime socket closed by the runtime")
+                    break
+                buffer.extend(chunk)
+
+                while len(buffer) >= TAGGED_FRAME_HEADER_SIZE:
+                    if buffer[0] != TAGGED_FRAME_MAGIC:
+                        raise ConnectionError("Invalid tagged frame header")
+                    length = int.from_bytes(buffer[6:8], "big")
+                    if len(buffer) < TAGGED_FRAME_HEADER_SIZE + length:
+                        break
+                    request_id = int.from_bytes(buffer[1:5], "big")
+                    end = TAGGED_FRAME_HEADER_SIZE + length
+                    self._dispatch(request_id, buffer[5], bytes(buffer[TAGGED_FRAME_HEADER_SIZE:end]))
+                    del buffer[:end]
+        except (OSError, ConnectionError) as e:
+            if self.sock is sock:
+                logger.error("Runtime socket read failed: %s", e)
+        finally:
+            if self.sock is sock:
+                self.sock = None
+                sock.close()
+            with self._pending_lock:
+                pending = list(self._pending.values())
+                self._pending.clear()
+            for request in pending:
+                request.failed = True
+                request.done.set()
+
+    def _request(
+        self, kind: int, body: bytes, timeout: float, wait: bool = True
+    ) -> Optional[List[bytes]]:
+        """
+        Send one tagged request and return its reply frames, None if it
+        failed, was rejected or timed out. Without `wait` the reply is dropped
+        and [] is returned once the request is sent.
+        """
+        sock = self.sock
+        if sock is None:
+            raise RuntimeError("Socket not connected")
+
+        pending = _PendingRequest()
+        with self._pending_lock:
+            self._next_id = (self._next_id + 1) & 0xFFFFFFFF
+            request_id = self._next_id
+            if wait:
+                self._pending[request_id] = pending
+
+        header = (
+            bytes([TAGGED_FRAME_MAGIC])
+            + request_id.to_bytes(4, "big")
+            + bytes([kind])
+            + len(body).to_bytes(2, "big")
+        )
+        try:
+            with self._send_lock:
+                sock.sendall(header + body)
+        except Exception as e:
+            # A partly sent frame leaves the stream out of sync
+            logger.error("Error sending message: %s", e)
+            with self._pending_lock:
+                self._pending.pop(request_id, None)
+            self.close()
+            return None
+
+        if not wait:
+            return []
+        if not pending.done.wait(timeout):
+            with self._pending_lock:
+                self._pending.pop(request_id, None)
+            logger.warning("Timeout waiting for the reply to request %d", request_id)
+            return None
+        if pending.failed:
+            return None
+        if pending.rejected:
+            logger.warning("Request %d rejected by the runtime", request_id)
+            return None
+        return pending.frames
+
+    @staticmethod
+    def _command_body(msg: str) -> bytes:
+        data = msg.rstrip("\n").encode()
+        if len(data) >= COMMAND_BUFFER_SIZE:
+            raise ValueError("Command too long")
+        return data
+
+    def send_message(self, msg: str):
+        """Send a text command without waiting for its response."""
+        self._request(TAGGED_KIND_COMMAND, self._command_body(msg), 0, wait=False)
+
+    def send_and_receive(self, msg: str, timeout: float = 0.5) -> Optional[str]:
+        """Send a text command and return its response line, None on errors."""
+        frames = self._request(TAGGED_KIND_COMMAND, self._command_body(msg), timeout)
+        if not frames or not frames[0]:
+            return None
+
+        message = frames[0].decode("utf-8").strip()
+        logger.debug(
+            "Received message: %s",
+            message[:200] + "..." if len(message) > 200 else message,
+        )
+        return message
+
+    def send_and_receive_debug_frame(
+        self, payload: bytes, timeout: float = 0.5
+    ) -> Optional[bytes]:
+        """
+        Send a raw debug payload and return the raw response payload. Returns
+        b"" if the runtime could not process the request and None on socket
+        errors.
+        """
+        if len(payload) > MAX_DEBUG_FRAME:
+            raise ValueError("Debug payload too large")
+
+        frames = self._request(TAGGED_KIND_DEBUG, payload, timeout)
+        if frames is None:
+            return None
+        return frames[0] if frames else b""
+
+    def send_and_receive_debug_pages(
+        self, start: int, end: int, timeout: float = 2.0
+    ) -> Optional[List[bytes]]:
+        """
+        Read variables start..end with one DEBUG_GET_PAGED request and return
+        the pages in order. An error is returned as a single 2-byte page.
+        Returns None on socket errors.
+        """
+        payload = bytes([MB_FC_DEBUG_GET_PAGED]) + start.to_bytes(2, "big") + end.to_bytes(2, "big")
+        frames = self._request(TAGGED_KIND_DEBUG, payload, timeout)
+        if frames is None:
+            return None
+        # The empty final frame only ends the sequence
+        return frames[:-1] if frames and not frames[-1] else frames
+
+    def close(self):
+        sock = self.sock
+        if sock:
+            logger.debug("Closing connection")
+            self.sock = None
+            try:
+                sock.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            sock.close()
+
+
+class DebugStreamClient:
+    """
+    Client for the runtime's debug stream socket. After subscribe() the
+    runtime pushes one sample per captured scan; read_sample() returns them
+    in order. The socket serves one client at a time and the subscription
+    ends when the connection is closed.
+    """
+
+    def __init__(self, socket_path=DEBUG_STREAM_SOCKET_PATH):
+        self.socket_path = socket_path
+        self.sock: Optional[socket.socket] = None
+
+    def connect(self):
+        """Connect to the debug stream socket"""
+        if not os.path.exists(self.socket_path):
+            raise FileNotFoundError(f"Socket not found: {self.socket_path}")
+
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.settimeout(1.0)
+        self.sock.connect(self.socket_path)
+        logger.debug("Connected to debug stream socket %s", self.socket_path)
+
+    def _read_frame(self, timeout: float) -> bytes:
+        """Read one framed payload. Raises socket.timeout or ConnectionError."""
+        self.sock.settimeout(timeout)
+        header = _recv_exact(self.sock, DEBUG_FRAME_HEADER_SIZE)
+        if header is None:
+            raise ConnectionError("Debug stream closed by the runtime")
+        if header[0] != DEBUG_FRAME_MAGIC:
+            raise ConnectionError("Invalid debug frame header")
+
+        length = int.from_bytes(header[1:3], "big")
+        payload = _recv_exact(self.sock, length) if length > 0 else b""
+        if payload is None:
+            raise ConnectionError("Debug stream closed by the runtime")
+        return payload
+
+    def subscribe(
+        self, indexes: List[int], on_change: bool = False, rate: int = 1, timeout: float = 2.0
+    ) -> int:
+        """
+        Subscribe to the given variable indexes, replacing any previous
+        subscription. An empty list cancels it. Returns the runtime status
+        code (MB_DEBUG_SUCCESS on success).
+        """
+        if not self.sock:
+            raise RuntimeError("Socket not connected")
+
+        payload = bytearray([MB_FC_DEBUG_SUBSCRIBE])
+        payload += len(indexes).to_bytes(2, "big")
+        for index in indexes:
+            payload += int(index).to_bytes(2, "big")
+        if indexes:
+            payload.append(DEBUG_STREAM_MODE_ON_CHANGE if on_change else DEBUG_STREAM_MODE_EVERY_N)
+            payload += max(1, min(int(rate), 0xFFFF)).to_bytes(2, "big")
+
+        if len(payload) > MAX_DEBUG_FRAME:
+            raise ValueError("Too many variables in one subscription")
+
+        self.sock.sendall(bytes([DEBUG_FRAME_MAGIC]) + len(payload).to_bytes(2, "big") + payload)
+
+        # Samples of the previous subscription may still be in flight
+        while True:
+            response = self._read_frame(timeout)
+            if not response:
+                raise ValueError("Subscribe request rejected by the runtime")
+            if response[0] == MB_FC_DEBUG_SUBSCRIBE and len(response) >= 2:
+                return response[1]
+
+    def read_sample(self, timeout: float = 0.5) -> Optional[Tuple[int, bool, bytes]]:
+        """
+        Return the next sample as (tick, dropped, data), or None if nothing
+        arrived within timeout. `dropped` is set when the runtime lost samples
+        before this one. Raises ConnectionError when the stream closes.
+        """
+        if not self.sock:
+            raise RuntimeError("Socket not connected")
+
+        try:
+            payload = self._read_frame(timeout)
+        except socket.timeout:
+            return None
+
+        if len(payload) < DEBUG_SAMPLE_HEADER_SIZE or payload[0] != MB_FC_DEBUG_SAMPLE:
+            return None
+
+        tick = int.from_bytes(payload[1:5], "big")
+        dropped = bool(payload[5] & DEBUG_SAMPLE_FLAG_DROPPED)
+        length = int.from_bytes(payload[6:8], "big")
+        return tick, dropped, payload[DEBUG_SAMPLE_HEADER_SIZE : DEBUG_SAMPLE_HEADER_SIZE + length]
+
+    def close(self):
+        if self.sock:
+            try:
+                self.sock.close()
+            finally:
+                self.sock = None
@@ -2,6 +2,7 @@ import socket
 import threading
 import os
 from webserver.logger import get_logger, LogParser
+from webserver.logger.parser import LOG_RECORD_MAGIC
 
 logger, _ = get_logger("runtime", use_buffer=True)
 parser = LogParser(logger)
@@ -57,9 +58,21 @@ class UnixLogServer:
     def _handle_client(self, client_sock: socket.socket):
         """Handle communication with a connected client"""
         try:
-            with client_sock.makefile('r') as f:
-                for line in f:
-                    parser.parse_and_log(line)
+            with client_sock.makefile('rb') as f:
+                # Binary records start with the magic byte, anything else is a text line
+                while True:
+                    first = f.read(1)
+                    if not first:
+                        break
+                    if first[0] == LOG_RECORD_MAGIC:
+                        header = f.read(2)
+                        if len(header) < 2:
+                            break
+                        body = f.read(int.from_bytes(header, "little"))
+                        parser.parse_record(body)
+                    else:
+                        line = first + f.readline()
+                        parser.parse_and_log(line.decode("utf-8", errors="replace"))
         except (OSError, socket.error) as e:
             logger.error("Socket error: %s", e)
         except Exception as e: